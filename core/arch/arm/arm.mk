@@ -26,6 +26,14 @@ CFG_LPAE_ADDR_SPACE_BITS ?= 32
 CFG_MMAP_REGIONS ?= 13
 CFG_RESERVED_VASPACE_SIZE ?= (1024 * 1024 * 10)
 
+# When enabled, cpu_spin_lock() and friends use fair ticket locks: CPUs
+# contending for a lock get it in the order they started waiting and the
+# waiters only read the lock until it is handed over to them, instead of
+# all of them retrying an exclusive store each time the lock is released.
+# This helps on systems with many cores. The lock is still a 32-bit word
+# where 0 (SPINLOCK_UNLOCK) means unlocked, at most 65535 CPUs may wait.
+CFG_CORE_TICKET_SPINLOCK ?= n
+
 ifeq ($(CFG_ARM64_core),y)
 CFG_KERN_LINKER_FORMAT ?= elf64-littleaarch64
 CFG_KERN_LINKER_ARCH ?= aarch64
@@ -36,6 +44,11 @@ CFG_KERN_LINKER_ARCH ?= aarch64
 # 36 bits, 64GB.
 # (etc.)
 CFG_CORE_ARM64_PA_BITS ?= 32
+# When enabled, the ticket spinlocks (CFG_CORE_TICKET_SPINLOCK) use the
+# ARMv8.1 Large System Extension atomic instructions (LDADD, CAS, STADD)
+# instead of exclusive load/store loops. All the CPUs must implement
+# FEAT_LSE.
+CFG_CORE_ARM64_LSE ?= n
 else
 ifeq ($(CFG_ARM32_core),y)
 CFG_KERN_LINKER_FORMAT ?= elf32-littlearm
@@ -45,6 +58,13 @@ $(error Error: CFG_ARM64_core or CFG_ARM32_core should be defined)
 endif
 endif
 
+# Size in bytes from which cache_op_batch_flush() cleans the whole data
+# cache by set/way instead of each range of a TEE_CACHECLEAN or
+# TEE_CACHEFLUSH batch. Set/way operations only maintain the caches of
+# the local CPU, so this is only correct when no other CPU may have dirty
+# lines of the buffers. 0 disables it.
+CFG_CORE_CACHE_OP_ALL_THRESHOLD ?= 0
+
 ifeq ($(CFG_TA_FLOAT_SUPPORT),y)
 # Use hard-float for floating point support in user TAs instead of
 # soft-float
@@ -54,6 +74,13 @@ ifeq ($(CFG_ARM64_core),y)
 $(call force,CFG_WITH_VFP,y)
 endif
 ifeq ($(CFG_WITH_VFP),y)
+# When enabled, thread_kernel_disable_vfp() leaves VFP enabled for the
+# current thread so that back-to-back kernel VFP sections (for instance
+# CE crypto processing a stream of small blocks) only pay for saving the
+# interrupted VFP state once. The VFP is disabled again before returning
+# to user mode, before handling an abort and when the thread is suspended
+# or exits.
+CFG_CORE_LAZY_KERNEL_VFP ?= n
 arm64-platform-hard-float-enabled := y
 ifneq ($(CFG_TA_ARM32_NO_HARD_FLOAT_SUPPORT),y)
 arm32-platform-hard-float-enabled := y
@@ -87,6 +114,16 @@ endif
 # 'y' to set the Alignment Check Enable bit in SCTLR/SCTLR_EL1, 'n' to clear it
 CFG_SCTLR_ALIGNMENT_CHECK ?= n
 
+# 'y' to use the AArch64 assembly memcpy(), memmove() and memset() in the
+# user mode libraries (TAs and ldelf) instead of the generic C ones. They
+# rely on unaligned accesses and are not used in the core which runs C
+# code with the MMU disabled during boot.
+ifeq ($(CFG_SCTLR_ALIGNMENT_CHECK),y)
+$(call force,CFG_ULIBS_ARM64_MEM_ROUTINES,n,Mandated by CFG_SCTLR_ALIGNMENT_CHECK)
+else
+CFG_ULIBS_ARM64_MEM_ROUTINES ?= y
+endif
+
 ifeq ($(CFG_CORE_LARGE_PHYS_ADDR),y)
 $(call force,CFG_WITH_LPAE,y)
 endif
@@ -99,6 +136,11 @@ ifeq ($(CFG_CORE_SEL1_SPMC),y)
 $(call force,CFG_CORE_FFA,y)
 endif
 
+# With CFG_CORE_FFA=y, number of the buffers of the arguments of the
+# yielding calls from normal world kept mapped between the calls, saving
+# the lookup, the map and the unmap of the buffer of each call.
+CFG_CORE_FFA_ARG_CACHE_ENTRIES ?= 4
+
 # Unmaps all kernel mode code except the code needed to take exceptions
 # from user space and restore kernel mode mapping again. This gives more
 # strict control over what is accessible while in user mode.
@@ -109,6 +151,61 @@ CFG_CORE_UNMAP_CORE_AT_EL0 ?= y
 # save/restore PMCR during world switch.
 CFG_SM_NO_CYCLE_COUNTING ?= y
 
+# Sampling profiler: each time a PMU event counter overflows, the program
+# counter of the interrupted TEE core or TA code is recorded, with the
+# call chain for the TEE core. The samples are read with the PMU profiler
+# pseudo TA. The highest numbered event counter and the PMU interrupt
+# CFG_CORE_PMU_PROFILER_IT (a PPI) are taken from normal world once
+# sampling has been started. The firmware must permit event counting in
+# secure state (MDCR_EL3.SPME). CFG_CORE_PMU_PROFILER_SAMPLES is the
+# number of samples buffered per core.
+CFG_CORE_PMU_PROFILER ?= n
+CFG_CORE_PMU_PROFILER_IT ?= 23
+CFG_CORE_PMU_PROFILER_SAMPLES ?= 256
+ifeq ($(CFG_CORE_PMU_PROFILER),y)
+ifneq ($(CFG_ARM64_core),y)
+$(error CFG_CORE_PMU_PROFILER requires CFG_ARM64_core=y)
+endif
+ifeq ($(CFG_WITH_PAGER),y)
+$(error CFG_CORE_PMU_PROFILER is not supported with CFG_WITH_PAGER=y)
+endif
+endif
+
+# Time slicing of TAs: user mode code of a TA which runs for longer than
+# CFG_CORE_TIME_SLICE_MS without returning from the invoked entry point is
+# suspended as for a foreign interrupt and resumed once normal world has
+# had a chance to run. The secure physical timer (CNTPS) is used with its
+# interrupt CFG_CORE_TIME_SLICE_IT (a PPI), it must not be used by the
+# platform for anything else.
+CFG_CORE_TIME_SLICE ?= n
+CFG_CORE_TIME_SLICE_MS ?= 10
+CFG_CORE_TIME_SLICE_IT ?= 29
+ifeq ($(CFG_CORE_TIME_SLICE),y)
+ifneq ($(CFG_ARM64_core),y)
+$(error CFG_CORE_TIME_SLICE requires CFG_ARM64_core=y)
+endif
+ifeq ($(CFG_WITH_PAGER),y)
+$(error CFG_CORE_TIME_SLICE is not supported with CFG_WITH_PAGER=y)
+endif
+endif
+
+# Messages logged by secure threads are copied into a per-core ring of
+# CFG_CORE_DEFERRED_CONSOLE_SIZE bytes and written to the console when the
+# thread returns to normal world, instead of busy-waiting on the UART
+# while the thread runs. Messages are dropped when the ring is full and
+# are drained right away on panic. Boot and fast calls log synchronously.
+CFG_CORE_DEFERRED_CONSOLE ?= n
+CFG_CORE_DEFERRED_CONSOLE_SIZE ?= 4096
+
+# Time page: a page mapped read-only in user TAs on request, with the
+# frequency of the physical counter and the last REE time read by the
+# core. TEE_GetSystemTime() is then computed in user mode and
+# TEE_GetREETime() only causes an RPC when the REE time is older than
+# CFG_CORE_TIME_PAGE_REE_MS. The physical counter becomes readable from
+# user mode.
+CFG_CORE_TIME_PAGE ?= n
+CFG_CORE_TIME_PAGE_REE_MS ?= 1000
+
 ifeq ($(CFG_ARM32_core),y)
 # Configration directive related to ARMv7 optee boot arguments.
 # CFG_PAGEABLE_ADDR: if defined, forces pageable data physical address.
@@ -94,26 +94,41 @@ void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
 	put_be_block(state->hash_state, dg);
 }
 
+/*
+ * Number of blocks processed by each pass of encrypt_pl() and
+ * decrypt_pl(). AES-CTR and GHASH are done in separate passes over a
+ * stride small enough to stay in L1 while letting the interleaved CTR
+ * and GHASH routines work on several blocks per call.
+ */
+#define PL_STRIDE_BLOCKS	8
+
 static void encrypt_pl(struct internal_aes_gcm_state *state,
 		       const struct internal_aes_gcm_key *ek, uint64_t dg[2],
 		       const uint8_t *src, size_t num_blocks, uint8_t *dst)
 {
-	void *buf_cryp = state->buf_cryp;
+	size_t n = 0;
 
 	while (num_blocks) {
-		ce_aes_xor_block(buf_cryp, buf_cryp, src);
-
-		pmull_ghash_update(1, dg, buf_cryp, &state->ghash_key, NULL);
-		memcpy(dst, buf_cryp, TEE_AES_BLOCK_SIZE);
-
-		ce_aes_ecb_encrypt(buf_cryp, (const uint8_t *)state->ctr,
+		n = MIN(num_blocks, (size_t)PL_STRIDE_BLOCKS);
+
+		/* buf_cryp holds the encrypted counter of the first block */
+		ce_aes_xor_block(dst, state->buf_cryp, src);
+		if (n > 1)
+			ce_aes_ctr_encrypt(dst + TEE_AES_BLOCK_SIZE,
+					   src + TEE_AES_BLOCK_SIZE,
+					   (const uint8_t *)ek->data,
+					   ek->rounds, n - 1,
+					   (uint8_t *)state->ctr, 1);
+		pmull_ghash_update(n, dg, dst, &state->ghash_key, NULL);
+
+		ce_aes_ecb_encrypt(state->buf_cryp, (const uint8_t *)state->ctr,
 				   (const uint8_t *)ek->data, ek->rounds,
 				   1, 1);
 		internal_aes_gcm_inc_ctr(state);
 
-		src += TEE_AES_BLOCK_SIZE;
-		dst += TEE_AES_BLOCK_SIZE;
-		num_blocks--;
+		src += n * TEE_AES_BLOCK_SIZE;
+		dst += n * TEE_AES_BLOCK_SIZE;
+		num_blocks -= n;
 	}
 }
 
@@ -121,14 +136,19 @@ static void decrypt_pl(struct internal_aes_gcm_state *state,
 		       const struct internal_aes_gcm_key *ek, uint64_t dg[2],
 		       const uint8_t *src, size_t num_blocks, uint8_t *dst)
 {
+	size_t n = 0;
+
 	while (num_blocks) {
+		n = MIN(num_blocks, (size_t)PL_STRIDE_BLOCKS);
+
+		/* Hash first in case of in-place decryption */
+		pmull_ghash_update(n, dg, src, &state->ghash_key, NULL);
 		ce_aes_ctr_encrypt(dst, src, (const uint8_t *)ek->data,
-				   ek->rounds, 1, (uint8_t *)state->ctr, 1);
-		pmull_ghash_update(1, dg, src, &state->ghash_key, NULL);
+				   ek->rounds, n, (uint8_t *)state->ctr, 1);
 
-		src += TEE_AES_BLOCK_SIZE;
-		dst += TEE_AES_BLOCK_SIZE;
-		num_blocks--;
+		src += n * TEE_AES_BLOCK_SIZE;
+		dst += n * TEE_AES_BLOCK_SIZE;
+		num_blocks -= n;
 	}
 }
 
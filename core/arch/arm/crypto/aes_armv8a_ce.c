@@ -205,6 +205,19 @@ void crypto_accel_aes_cbc_dec(void *out, const void *in, const void *key,
 	thread_kernel_disable_vfp(vfp_state);
 }
 
+void crypto_accel_aes_cbc_mac(void *mac, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	assert(mac && in && key);
+
+	vfp_state = thread_kernel_enable_vfp();
+	ce_aes_cbc_mac(mac, in, key, round_count, block_count);
+	thread_kernel_disable_vfp(vfp_state);
+}
+
 void crypto_accel_aes_ctr_be_enc(void *out, const void *in, const void *key,
 				 unsigned int round_count,
 				 unsigned int block_count, void *iv)
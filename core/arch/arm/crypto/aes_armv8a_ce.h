@@ -19,6 +19,8 @@ void ce_aes_cbc_encrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
 			int rounds, int blocks, uint8_t iv[]);
 void ce_aes_cbc_decrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
 			int rounds, int blocks, uint8_t iv[]);
+void ce_aes_cbc_mac(uint8_t mac[], uint8_t const in[], uint8_t const rk[],
+		    int rounds, int blocks);
 void ce_aes_ctr_encrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
 			int rounds, int blocks, uint8_t ctr[], int first);
 void ce_aes_xts_encrypt(uint8_t out[], uint8_t const in[], uint8_t const rk1[],
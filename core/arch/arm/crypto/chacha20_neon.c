@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <crypto/crypto_accel.h>
+#include <kernel/thread.h>
+
+/* Prototype for assembly function */
+void chacha20_neon_xor(void *out, const void *in, uint32_t state[16],
+		       unsigned int block_count);
+
+void crypto_accel_chacha20_xor(void *out, const void *in, uint32_t state[16],
+			       unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	vfp_state = thread_kernel_enable_vfp();
+	chacha20_neon_xor(out, in, state, block_count);
+	thread_kernel_disable_vfp(vfp_state);
+}
@@ -5,6 +5,14 @@
 
 #include <crypto/crypto_accel.h>
 #include <kernel/thread.h>
+#include <string.h>
+#include <string_ext.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#define SHA256_BLOCK_SIZE	64
+/* Blocks compressed with each enabling of VFP, 4 KiB */
+#define SHA256_MAX_BLOCKS	64
 
 /* Prototype for assembly function */
 void sha256_ce_transform(uint32_t state[8], const void *src,
@@ -19,3 +27,49 @@ void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 	sha256_ce_transform(state, src, block_count);
 	thread_kernel_disable_vfp(vfp_state);
 }
+
+TEE_Result crypto_accel_sha256_check(const uint8_t *hash, const void *data,
+				     size_t data_size)
+{
+	uint32_t state[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	uint8_t pad[2 * SHA256_BLOCK_SIZE] = { 0 };
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { 0 };
+	size_t nblocks = data_size / SHA256_BLOCK_SIZE;
+	size_t rem = data_size % SHA256_BLOCK_SIZE;
+	uint64_t nbits = (uint64_t)data_size * 8;
+	const uint8_t *p = data;
+	size_t pad_len = 0;
+	size_t n = 0;
+
+	while (nblocks) {
+		n = MIN(nblocks, (size_t)SHA256_MAX_BLOCKS);
+		crypto_accel_sha256_compress(state, p, n);
+		p += n * SHA256_BLOCK_SIZE;
+		nblocks -= n;
+	}
+
+	/* The final 0x80 byte and the 64-bit length may need another block */
+	if (rem < SHA256_BLOCK_SIZE - 8)
+		pad_len = SHA256_BLOCK_SIZE;
+	else
+		pad_len = 2 * SHA256_BLOCK_SIZE;
+	memcpy(pad, p, rem);
+	pad[rem] = 0x80;
+	for (n = 0; n < 8; n++)
+		pad[pad_len - 1 - n] = nbits >> (n * 8);
+	crypto_accel_sha256_compress(state, pad, pad_len / SHA256_BLOCK_SIZE);
+
+	for (n = 0; n < ARRAY_SIZE(state); n++) {
+		digest[n * 4] = state[n] >> 24;
+		digest[n * 4 + 1] = state[n] >> 16;
+		digest[n * 4 + 2] = state[n] >> 8;
+		digest[n * 4 + 3] = state[n];
+	}
+
+	if (consttime_memcmp(digest, hash, sizeof(digest)))
+		return TEE_ERROR_SECURITY;
+	return TEE_SUCCESS;
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <crypto/crypto_accel.h>
+#include <kernel/thread.h>
+
+/* Prototype for assembly function */
+void sha512_ce_transform(uint64_t state[8], const void *src,
+			 unsigned int block_count);
+
+/* The SHA-512 instructions are optional from ARMv8.2 */
+static bool have_sha512_insns(void)
+{
+	uint64_t isar0 = read_id_aa64isar0_el1();
+
+	return ((isar0 >> ID_AA64ISAR0_SHA2_SHIFT) & ID_AA64ISAR0_SHA2_MASK) >=
+	       ID_AA64ISAR0_SHA2_SHA512;
+}
+
+TEE_Result crypto_accel_sha512_compress(uint64_t state[8], const void *src,
+					unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	if (!have_sha512_insns())
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	vfp_state = thread_kernel_enable_vfp();
+	sha512_ce_transform(state, src, block_count);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return TEE_SUCCESS;
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <crypto/crypto_accel.h>
+#include <kernel/thread.h>
+
+/* Prototype for assembly function */
+void sm3_ce_transform(uint32_t state[8], const void *src,
+		      unsigned int block_count);
+
+/* The SM3 instructions are optional from ARMv8.2 */
+static bool have_sm3_insns(void)
+{
+	uint64_t isar0 = read_id_aa64isar0_el1();
+
+	return (isar0 >> ID_AA64ISAR0_SM3_SHIFT) & ID_AA64ISAR0_SM3_MASK;
+}
+
+TEE_Result crypto_accel_sm3_compress(uint32_t state[8], const void *src,
+				     unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	if (!have_sm3_insns())
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	vfp_state = thread_kernel_enable_vfp();
+	sm3_ce_transform(state, src, block_count);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return TEE_SUCCESS;
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <crypto/crypto_accel.h>
+#include <kernel/thread.h>
+
+/* Prototype for assembly function */
+void sm4_ce_crypt(uint8_t out[], const uint8_t in[], const uint32_t rk[32],
+		  unsigned int block_count);
+
+/* The SM4 instructions are optional from ARMv8.2 */
+static bool have_sm4_insns(void)
+{
+	uint64_t isar0 = read_id_aa64isar0_el1();
+
+	return (isar0 >> ID_AA64ISAR0_SM4_SHIFT) & ID_AA64ISAR0_SM4_MASK;
+}
+
+TEE_Result crypto_accel_sm4_crypt(void *out, const void *in,
+				  const uint32_t rk[32],
+				  unsigned int block_count)
+{
+	uint32_t vfp_state = 0;
+
+	if (!have_sm4_insns())
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	vfp_state = thread_kernel_enable_vfp();
+	sm4_ce_crypt(out, in, rk, block_count);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return TEE_SUCCESS;
+}
@@ -188,10 +188,27 @@
 				      & CPACR_EL1_FPEN_MASK)
 
 
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_SHA2_MASK		0xf
+#define ID_AA64ISAR0_SHA2_SHA512	0x2
+#define ID_AA64ISAR0_SM3_SHIFT		36
+#define ID_AA64ISAR0_SM3_MASK		0xf
+#define ID_AA64ISAR0_SM4_SHIFT		40
+#define ID_AA64ISAR0_SM4_MASK		0xf
+
 #define PAR_F			BIT32(0)
 #define PAR_PA_SHIFT		12
 #define PAR_PA_MASK		(BIT64(36) - 1)
 
+#define PMCR_E			BIT32(0)
+#define PMCR_N_SHIFT		11
+#define PMCR_N_MASK		0x1f
+
+/* Event filter, count in secure EL0 and EL1 only */
+#define PMEVTYPER_NSK		BIT32(29)
+#define PMEVTYPER_NSU		BIT32(28)
+#define PMEVTYPER_EVT_MASK	0xffff
+
 #define TLBI_MVA_SHIFT		12
 #define TLBI_ASID_SHIFT		48
 #define TLBI_ASID_MASK		0xff
@@ -266,6 +283,11 @@ static inline __noprof void tlbi_vale1is(uint64_t mva)
 	asm volatile ("tlbi	vale1is, %0" : : "r" (mva));
 }
 
+static inline __noprof void tlbi_aside1(uint64_t asid)
+{
+	asm volatile ("tlbi	aside1, %0" : : "r" (asid));
+}
+
 /*
  * Templates for register read/write functions based on mrs/msr
  */
@@ -331,12 +353,23 @@ DEFINE_REG_READ_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 DEFINE_REG_WRITE_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 
 DEFINE_REG_READ_FUNC_(pmccntr, uint64_t, pmccntr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmcr_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmselr_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmxevtyper_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmxevcntr_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmcntenset_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmcntenclr_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmintenset_el1)
+DEFINE_U32_REG_WRITE_FUNC(pmintenclr_el1)
+DEFINE_U32_REG_READWRITE_FUNCS(pmovsclr_el0)
 
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr0_el1)
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr1_el1)
 DEFINE_U64_REG_READWRITE_FUNCS(tcr_el1)
 
 DEFINE_U64_REG_READ_FUNC(esr_el1)
+DEFINE_U64_REG_READ_FUNC(elr_el1)
+DEFINE_U64_REG_READ_FUNC(spsr_el1)
 DEFINE_U64_REG_READ_FUNC(far_el1)
 DEFINE_U64_REG_READ_FUNC(mpidr_el1)
 /* Alias for reading this register to avoid ifdefs in code */
@@ -345,6 +378,7 @@ DEFINE_U64_REG_READ_FUNC(midr_el1)
 /* Alias for reading this register to avoid ifdefs in code */
 #define read_midr() read_midr_el1()
 DEFINE_U64_REG_READ_FUNC(par_el1)
+DEFINE_U64_REG_READ_FUNC(id_aa64isar0_el1)
 
 DEFINE_U64_REG_WRITE_FUNC(mair_el1)
 
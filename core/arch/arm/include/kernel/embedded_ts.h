@@ -12,12 +12,22 @@
 #include <tee_api_types.h>
 #include <util.h>
 
+/*
+ * With CFG_EARLY_TA_COMPRESS_LZ=y the image is split in blocks of
+ * EMB_TS_LZ_BLOCK_SIZE bytes which are compressed independently with
+ * lz_compress(). Block n is found at offset @lz_offs[n] in @ts and ends
+ * at @lz_offs[n + 1], a block as large as its uncompressed size is stored
+ * as is.
+ */
+#define EMB_TS_LZ_BLOCK_SIZE	4096
+
 struct embedded_ts {
 	uint32_t flags;
 	TEE_UUID uuid;
 	uint32_t size;
 	uint32_t uncompressed_size; /* 0: not compressed */
 	const uint8_t *ts; /* @size bytes */
+	const uint32_t *lz_offs; /* NULL: not LZ compressed */
 };
 
 struct ts_store_handle;
@@ -20,5 +20,13 @@ TEE_Result ldelf_dlopen(struct user_mode_ctx *uctx, TEE_UUID *uuid,
 			uint32_t flags);
 TEE_Result ldelf_dlsym(struct user_mode_ctx *uctx, TEE_UUID *uuid,
 		       const char *sym, size_t maxlen, vaddr_t *val);
+/*
+ * Resolves @num_syms symbols in one call into ldelf, @names holds the
+ * NUL terminated names one after the other. @vals receives the address of
+ * each symbol or 0 if the symbol isn't found.
+ */
+TEE_Result ldelf_dlsym_table(struct user_mode_ctx *uctx, TEE_UUID *uuid,
+			     const char *names, size_t names_len,
+			     size_t num_syms, uint64_t *vals);
 
 #endif /* KERNEL_LDELF_LOADER_H */
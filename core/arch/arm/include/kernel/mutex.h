@@ -5,6 +5,7 @@
 #ifndef KERNEL_MUTEX_H
 #define KERNEL_MUTEX_H
 
+#include <kernel/lock_stats.h>
 #include <kernel/refcount.h>
 #include <kernel/wait_queue.h>
 #include <sys/queue.h>
@@ -14,10 +15,27 @@ struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+#if CFG_MUTEX_SPIN_US
+	short owner;		/* 1 + thread id of writer, 0: none */
+#endif
+#ifdef CFG_MUTEX_WRITER_PREFERENCE
+	short writers_waiting;	/* writers waiting for the mutex */
+#endif
+#ifdef CFG_LOCK_STATS
+	struct lock_stats *stats;
+#endif
 };
 
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
 
+/* Initializer of a mutex with contention statistics, see lock_stats.h */
+#ifdef CFG_LOCK_STATS
+#define MUTEX_INITIALIZER_NAMED(n) { .wq = WAIT_QUEUE_INITIALIZER, \
+		.stats = &(struct lock_stats)LOCK_STATS_INITIALIZER(n) }
+#else
+#define MUTEX_INITIALIZER_NAMED(n) MUTEX_INITIALIZER
+#endif
+
 struct recursive_mutex {
 	struct mutex m;		/* used when lock_depth goes 0 -> 1 or 1 -> 0 */
 	short int owner;
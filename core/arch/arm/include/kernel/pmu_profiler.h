@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_PMU_PROFILER_H
+#define __KERNEL_PMU_PROFILER_H
+
+#include <pta_pmu_profiler.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+#ifdef CFG_CORE_PMU_PROFILER
+/*
+ * pmu_profiler_start() - start sampling on all cores
+ * @event:	PMU event to count
+ * @period:	Number of events between two samples
+ *
+ * Sampling starts right away on the calling core and on the other cores
+ * when they next enter from normal world.
+ */
+TEE_Result pmu_profiler_start(uint32_t event, uint32_t period);
+
+/* Stop sampling, with the same lazy update of the cores */
+void pmu_profiler_stop(void);
+
+/*
+ * pmu_profiler_read() - read and remove samples
+ * @samples:	Array receiving the samples
+ * @count:	Number of elements in @samples
+ * @dropped:	Number of samples dropped since the last call
+ *
+ * Returns the number of samples stored in @samples.
+ */
+size_t pmu_profiler_read(struct pmu_prof_sample *samples, size_t count,
+			 uint32_t *dropped);
+
+/*
+ * Applies the current sampling configuration to the calling core, called
+ * with all exceptions masked on entry from normal world.
+ */
+void pmu_profiler_sync(void);
+#else
+static inline void pmu_profiler_sync(void)
+{
+}
+#endif
+
+#endif /*__KERNEL_PMU_PROFILER_H*/
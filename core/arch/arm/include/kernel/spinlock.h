@@ -14,6 +14,7 @@
 #include <assert.h>
 #include <compiler.h>
 #include <stdbool.h>
+#include <kernel/lock_stats.h>
 #include <kernel/thread.h>
 
 #ifdef CFG_TEE_CORE_DEBUG
@@ -129,6 +130,25 @@ static inline void cpu_spin_unlock_xrestore(unsigned int *lock,
 	cpu_spin_unlock(lock);
 	thread_unmask_exceptions(exceptions);
 }
+
+/*
+ * Same as cpu_spin_lock_xsave() but also updates the contention
+ * statistics @s of the lock if CFG_LOCK_STATS=y
+ */
+static inline uint32_t cpu_spin_lock_xsave_stats(unsigned int *lock,
+						 struct lock_stats *s)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	uint64_t start = 0;
+
+	if (!cpu_spin_trylock(lock)) {
+		start = lock_stats_wait_start(s);
+		cpu_spin_lock(lock);
+	}
+	lock_stats_acquired(s, start, 0);
+
+	return exceptions;
+}
 #endif /* __ASSEMBLER__ */
 
 #endif /* KERNEL_SPINLOCK_H */
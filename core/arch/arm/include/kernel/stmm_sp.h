@@ -131,6 +131,8 @@ struct stmm_boot_info {
 	struct stmm_mp_info	*mp_info;
 };
 
+struct stmm_storage;
+
 struct stmm_ctx {
 	struct user_mode_ctx uctx;
 	struct tee_ta_ctx ta_ctx;
@@ -138,6 +140,7 @@ struct stmm_ctx {
 	vaddr_t ns_comm_buf_addr;
 	unsigned int ns_comm_buf_size;
 	bool is_initializing;
+	struct stmm_storage *storage;
 };
 
 extern const struct ts_ops stmm_sp_ops;
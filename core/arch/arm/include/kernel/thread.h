@@ -52,6 +52,9 @@ struct thread_core_local {
 #ifdef CFG_CORE_DEBUG_CHECK_STACKS
 	bool stackcheck_recursion;
 #endif
+#ifdef CFG_CORE_TIME_SLICE
+	bool time_slice_yield;
+#endif
 } THREAD_CORE_LOCAL_ALIGNED;
 
 struct thread_vector_table {
@@ -249,6 +252,9 @@ struct thread_specific_data {
 	bool stackcheck_recursion;
 #endif
 	unsigned int syscall_recursion;
+#ifdef CFG_TA_INVOKE_STATS
+	uint64_t rpc_cnt;	/* Counter ticks spent in RPC */
+#endif
 };
 
 struct user_mode_ctx;
@@ -587,6 +593,41 @@ static inline bool __nostackcheck get_stack_hard_limits(vaddr_t *start,
 	return get_stack_limits(start, end, true);
 }
 
+/*
+ * struct thread_stack_usage - deepest use seen of a stack
+ * @type:	THREAD_STACK_TYPE_*
+ * @index:	Core position of a temporary or abort stack, else thread id
+ * @size:	Usable size of the stack
+ * @max_used:	Largest number of bytes seen used from the stack
+ */
+struct thread_stack_usage {
+	uint32_t type;
+	uint32_t index;
+	size_t size;
+	size_t max_used;
+};
+
+#define THREAD_STACK_TYPE_TMP		0
+#define THREAD_STACK_TYPE_ABT		1
+#define THREAD_STACK_TYPE_THREAD	2
+
+/*
+ * Fills @usage with up to @count stacks and returns the number of stacks,
+ * the largest uses are cleared if @reset is true. Stack use is sampled on
+ * each function entry, it's only tracked with CFG_CORE_DEBUG_CHECK_STACKS=y.
+ */
+#ifdef CFG_CORE_DEBUG_CHECK_STACKS
+size_t thread_get_stack_usage(struct thread_stack_usage *usage, size_t count,
+			      bool reset);
+#else
+static inline size_t
+thread_get_stack_usage(struct thread_stack_usage *usage __unused,
+		       size_t count __unused, bool reset __unused)
+{
+	return 0;
+}
+#endif
+
 bool thread_is_in_normal_mode(void);
 
 /*
@@ -597,6 +638,14 @@ bool thread_is_in_normal_mode(void);
  */
 bool thread_is_from_abort_mode(void);
 
+#ifdef CFG_CORE_RPC_AFFINITY
+/*
+ * Enables or disables the report of the core preferred for the resume of
+ * a thread in RPC returns, see OPTEE_SMC_RPC_AFFINITY_SHIFT.
+ */
+void thread_set_rpc_affinity(bool enable);
+#endif
+
 /*
  * Disables and empties the prealloc RPC cache one reference at a time. If
  * all threads are idle this function returns true and a cookie of one shm
@@ -740,6 +789,7 @@ enum thread_shm_type {
  * @THREAD_SHM_CACHE_USER_SOCKET - socket communication
  * @THREAD_SHM_CACHE_USER_FS - filesystem access
  * @THREAD_SHM_CACHE_USER_I2C - I2C communication
+ * @THREAD_SHM_CACHE_USER_RPMB - RPMB requests and responses
  *
  * To ensure that each user of the shared memory cache doesn't interfere
  * with each other a unique ID per user is used.
@@ -748,6 +798,7 @@ enum thread_shm_cache_user {
 	THREAD_SHM_CACHE_USER_SOCKET,
 	THREAD_SHM_CACHE_USER_FS,
 	THREAD_SHM_CACHE_USER_I2C,
+	THREAD_SHM_CACHE_USER_RPMB,
 };
 
 /*
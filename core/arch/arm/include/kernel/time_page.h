@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_TIME_PAGE_H
+#define __KERNEL_TIME_PAGE_H
+
+#include <compiler.h>
+#include <kernel/user_mode_ctx_struct.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * The time page is a struct utee_time_page mapped read-only in the user
+ * TAs which request it, letting libutee compute the system time and the
+ * REE time without syscalls.
+ */
+
+#ifdef CFG_CORE_TIME_PAGE
+/*
+ * Maps the time page in @uctx unless already mapped, @va receives the
+ * address of the mapping.
+ */
+TEE_Result time_page_map(struct user_mode_ctx *uctx, vaddr_t *va);
+/* Records @time, the REE time which was just read with an RPC */
+void time_page_set_ree_time(const TEE_Time *time);
+#else
+static inline TEE_Result time_page_map(struct user_mode_ctx *uctx __unused,
+				       vaddr_t *va __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void time_page_set_ree_time(const TEE_Time *time __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_TIME_PAGE_H*/
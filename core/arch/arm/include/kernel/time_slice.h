@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_TIME_SLICE_H
+#define __KERNEL_TIME_SLICE_H
+
+#include <compiler.h>
+
+/*
+ * User mode code of a TA running for longer than CFG_CORE_TIME_SLICE_MS
+ * without returning from the invoked entry point is suspended as if a
+ * foreign interrupt had occurred, which gives normal world a chance to
+ * schedule other work. The executed TA code is resumed when normal world
+ * returns from the RPC.
+ */
+
+#ifdef CFG_CORE_TIME_SLICE
+/* Called by the current thread just before entering user mode for a TA */
+void time_slice_start(void);
+/* Called by the current thread once returned from user mode */
+void time_slice_stop(void);
+/*
+ * Called with all exceptions masked when the thread @thread_id is resumed
+ * on the current core, gives the thread a new time slice.
+ */
+void time_slice_resume(short int thread_id);
+#else
+static inline void time_slice_start(void)
+{
+}
+
+static inline void time_slice_stop(void)
+{
+}
+
+static inline void time_slice_resume(short int thread_id __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_TIME_SLICE_H*/
@@ -5,10 +5,15 @@
 
 #include <kernel/tee_time.h>
 
+/*
+ * @get_sys_time_ns is optional, tee_time_get_sys_time_ns() converts the
+ * result of @get_sys_time if it's NULL.
+ */
 struct time_source {
 	const char *name;
 	uint32_t protection_level;
 	TEE_Result (*get_sys_time)(TEE_Time *time);
+	TEE_Result (*get_sys_time_ns)(uint64_t *ns);
 };
 void time_source_init(void);
 
@@ -46,6 +46,26 @@ static inline void tlbi_mva_asid(vaddr_t va, uint32_t asid)
 	dsb_ish();
 	isb();
 }
+
+/*
+ * Invalidate the TLB entries tagged with the ASID pair of @asid on the
+ * calling core only
+ */
+static inline void tlbi_asid_local(uint32_t asid)
+{
+	uint32_t a = asid & TLBI_ASID_MASK;
+
+	dsb_ishst();
+#ifdef ARM64
+	tlbi_aside1(SHIFT_U64(a, TLBI_ASID_SHIFT));
+	tlbi_aside1(SHIFT_U64(a | 1, TLBI_ASID_SHIFT));
+#else
+	write_tlbiasid(a);
+	write_tlbiasid(a | 1);
+#endif
+	dsb();
+	isb();
+}
 #endif /*!__ASSEMBLER__*/
 
 #endif /* TLB_HELPERS_H */
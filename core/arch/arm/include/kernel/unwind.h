@@ -7,6 +7,7 @@
 #ifndef KERNEL_UNWIND
 #define KERNEL_UNWIND
 
+#include <compiler.h>
 #include <types_ext.h>
 
 #if defined(CFG_UNWIND) && (TRACE_LEVEL > 0)
@@ -17,14 +18,32 @@ static inline void print_kernel_stack(void)
 }
 #endif
 
+/* Deepest call stack returned by unw_get_kernel_stack() */
+#define UNW_KERNEL_STACK_MAX_DEPTH	32
+
 #ifdef CFG_UNWIND
-/* Get current call stack as an array allocated on the heap */
+/*
+ * Get current call stack as a zero terminated array allocated on the heap,
+ * the outermost frames are dropped beyond UNW_KERNEL_STACK_MAX_DEPTH.
+ */
 vaddr_t *unw_get_kernel_stack(void);
+
+/*
+ * Get at most @count return addresses of the current call stack into @buf
+ * without allocating anything. Returns the number of addresses stored.
+ */
+size_t unw_get_kernel_stack_buf(vaddr_t *buf, size_t count);
 #else
 static inline void *unw_get_kernel_stack(void)
 {
 	return NULL;
 }
+
+static inline size_t unw_get_kernel_stack_buf(vaddr_t *buf __unused,
+					      size_t count __unused)
+{
+	return 0;
+}
 #endif /* CFG_UNWIND  */
 
 #endif /*KERNEL_UNWIND*/
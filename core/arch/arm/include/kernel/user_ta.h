@@ -7,6 +7,7 @@
 #define KERNEL_USER_TA_H
 
 #include <assert.h>
+#include <kernel/handle.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/user_mode_ctx_struct.h>
 #include <kernel/thread.h>
@@ -27,7 +28,11 @@ SLIST_HEAD(load_seg_head, load_seg);
  * @open_sessions:	List of sessions opened by this TA
  * @cryp_states:	List of cryp states created by this TA
  * @objects:		List of storage objects opened by this TA
+ * @cryp_db:		Handles of the cryp states given to the TA
+ * @obj_db:		Handles of the objects given to the TA
+ * @uref_gen:		Generation count of the handles given to the TA
  * @storage_enums:	List of storage enumerators opened by this TA
+ * @storage_tx:		True if storage writes are staged until committed
  * @ta_time_offs:	Time reference used by the TA
  * @uctx:		Generic user mode context
  * @ctx:		Generic TA context
@@ -36,7 +41,11 @@ struct user_ta_ctx {
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
 	struct tee_obj_head objects;
+	struct handle_db cryp_db;
+	struct handle_db obj_db;
+	uint32_t uref_gen;
 	struct tee_storage_enum_head storage_enums;
+	bool storage_tx;
 	void *ta_time_offs;
 	struct user_mode_ctx uctx;
 	struct tee_ta_ctx ta_ctx;
@@ -17,6 +17,7 @@ struct condvar;
 struct wait_queue_elem {
 	short handle;
 	bool done;
+	bool sleeping;		/* A wakeup RPC is needed once done */
 	bool wait_read;
 	struct condvar *cv;
 	SLIST_ENTRY(wait_queue_elem) link;
@@ -66,6 +66,12 @@ bool core_pbuf_is(uint32_t flags, paddr_t pbuf, size_t len);
  */
 bool core_vbuf_is(uint32_t flags, const void *vbuf, size_t len);
 
+/*
+ * Returns true if the buffer is inside a single static core mapping and
+ * is thus physically contiguous, false if unknown.
+ */
+bool core_vbuf_is_pa_contiguous(const void *vbuf, size_t len);
+
 /*
  * Translate physical address to virtual address using specified mapping
  * Returns NULL on failure or a valid virtual address on success.
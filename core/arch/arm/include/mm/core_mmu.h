@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <compiler.h>
 #include <kernel/user_ta.h>
+#include <mm/tee_mm.h>
 #include <mm/tee_mmu_types.h>
 #include <types_ext.h>
 #include <util.h>
@@ -423,6 +424,24 @@ uint32_t core_mmu_type_to_attr(enum teecore_memtypes t);
  */
 void core_mmu_create_user_map(struct user_mode_ctx *uctx,
 			      struct core_mmu_user_map *map);
+
+/*
+ * core_mmu_reuse_user_map() - Get the user mode mapping of the current
+ * thread as last created with core_mmu_create_user_map(), the tables must
+ * still describe the mapping of @uctx.
+ * @uctx:	Pointer to user mode context
+ * @map:	MMU configuration to use when activating this VA space
+ */
+void core_mmu_reuse_user_map(struct user_mode_ctx *uctx,
+			     struct core_mmu_user_map *map);
+
+/*
+ * core_mmu_map_user_region() - Writes the translation entries of a region
+ *     of the active user map which was created with VM_FLAG_LAZY set
+ * @region:	Region to map
+ */
+void core_mmu_map_user_region(struct vm_region *region);
+
 /*
  * core_mmu_get_user_map() - Reads current MMU configuration for user VA space
  * @map:	MMU configuration for current user VA space.
@@ -585,6 +604,19 @@ TEE_Result core_mmu_map_contiguous_pages(vaddr_t vstart, paddr_t pstart,
 					 size_t num_pages,
 					 enum teecore_memtypes memtype);
 
+/*
+ * core_mmu_alloc_shm_va() - allocate virtual memory from tee_mm_shm
+ * @pa:		Physical address of the first page to be mapped
+ * @size:	Size in bytes
+ *
+ * With CFG_CORE_MMU_SHM_BLOCK_MAP=y large allocations are placed such
+ * that physically contiguous parts can be mapped with block mappings by
+ * core_mmu_map_pages() and core_mmu_map_contiguous_pages().
+ *
+ * @returns:	the allocated entry or NULL on failure
+ */
+tee_mm_entry_t *core_mmu_alloc_shm_va(paddr_t pa, size_t size);
+
 /*
  * core_mmu_unmap_pages() - remove mapping at given virtual address
  * @vstart:	Virtual address where mapping begins
@@ -697,6 +729,45 @@ void core_init_mmu_prtn(struct mmu_partition *prtn, struct tee_mmap_region *mm);
 unsigned int asid_alloc(void);
 void asid_free(unsigned int asid);
 
+#ifdef CFG_CORE_MMU_LAZY_TLBI
+/*
+ * struct asid_stats - statistics of user map switches
+ * @switches:	Number of times a user map was set or removed
+ * @flushes:	Number of times TLB entries of an ASID pair had to be
+ *		invalidated on a switch
+ */
+struct asid_stats {
+	uint32_t switches;
+	uint32_t flushes;
+};
+
+/*
+ * asid_tables_changed() - record that the translation tables of @asid
+ * were rebuilt, TLB entries of @asid are invalidated on each core the
+ * next time @asid is switched to there
+ */
+void asid_tables_changed(unsigned int asid);
+
+/*
+ * asid_switch_tlb() - prepare the local TLB before switching to @asid,
+ * called with foreign interrupts masked. @asid is 0 when the user map is
+ * removed.
+ */
+void asid_switch_tlb(unsigned int asid);
+#else
+static inline void asid_tables_changed(unsigned int asid __unused)
+{
+}
+
+static inline void asid_switch_tlb(unsigned int asid __unused)
+{
+}
+#endif
+
+#if defined(CFG_CORE_MMU_LAZY_TLBI) && defined(CFG_WITH_STATS)
+void asid_get_stats(struct asid_stats *stats, bool reset);
+#endif
+
 #ifdef CFG_SECURE_DATA_PATH
 /* Alloc and fill SDP memory objects table - table is NULL terminated */
 struct mobj **core_sdp_mem_create_mobjs(void);
@@ -52,6 +52,20 @@ struct pgt {
 
 SLIST_HEAD(pgt_cache, pgt);
 
+/*
+ * struct pgt_cache_stats - statistics of the cache of saved page tables
+ * @hits:	Number of tables found saved when a context was mapped
+ * @misses:	Number of tables not found saved when a context was mapped
+ * @evictions:	Number of saved tables released to make room
+ * @num_saved:	Number of tables currently saved
+ */
+struct pgt_cache_stats {
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t num_saved;
+};
+
 static inline bool pgt_check_avail(size_t num_tbls)
 {
 	return num_tbls <= PGT_CACHE_SIZE;
@@ -78,9 +92,30 @@ static inline void pgt_flush_ctx_range(struct pgt_cache *pgt_cache __unused,
 
 void pgt_init(void);
 
-#if defined(CFG_PAGED_USER_TA)
+/*
+ * Tables flushed for a context being freed: the saved tables with
+ * CFG_PAGED_USER_TA, else the tables parked with pgt_park().
+ */
 void pgt_flush_ctx(struct ts_ctx *ctx);
 
+#if defined(CFG_PAGED_USER_TA)
+static inline void pgt_park(struct pgt_cache *pgt_cache,
+			    struct ts_ctx *ctx __unused,
+			    unsigned int map_gen __unused)
+{
+	pgt_free(pgt_cache, true);
+}
+
+static inline bool pgt_unpark(struct pgt_cache *pgt_cache __unused,
+			      struct ts_ctx *ctx __unused,
+			      unsigned int map_gen __unused)
+{
+	return false;
+}
+
+
+void pgt_get_cache_stats(struct pgt_cache_stats *stats, bool reset);
+
 static inline void pgt_inc_used_entries(struct pgt *pgt)
 {
 	pgt->num_used_entries++;
@@ -99,8 +134,22 @@ static inline void pgt_set_used_entries(struct pgt *pgt, size_t val)
 }
 
 #else
-static inline void pgt_flush_ctx(struct ts_ctx *ctx __unused)
+/*
+ * pgt_park() - Keeps the tables of @ctx with mapping generation @map_gen
+ * for the current thread instead of freeing them
+ * pgt_unpark() - Gives back the parked tables to @pgt_cache if they are
+ * the ones of @ctx with mapping generation @map_gen, else releases them.
+ * Returns true if the tables were given back and can be used as is.
+ */
+void pgt_park(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
+	      unsigned int map_gen);
+bool pgt_unpark(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
+		unsigned int map_gen);
+
+static inline void pgt_get_cache_stats(struct pgt_cache_stats *stats,
+				       bool reset __unused)
 {
+	*stats = (struct pgt_cache_stats){ };
 }
 
 static inline void pgt_inc_used_entries(struct pgt *pgt __unused)
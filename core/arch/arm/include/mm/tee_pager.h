@@ -29,6 +29,7 @@ struct tee_pager_area {
 	vaddr_t base;
 	size_t size;
 	struct pgt *pgt;
+	struct user_mode_ctx *uctx;	/* NULL for core areas */
 	TAILQ_ENTRY(tee_pager_area) link;
 	TAILQ_ENTRY(tee_pager_area) fobj_link;
 };
@@ -255,6 +256,39 @@ static inline void tee_pager_release_phys(void *addr __unused,
 }
 #endif
 
+/* Causes of the page faults handled by the pager */
+enum tee_pager_fault_type {
+	TEE_PAGER_FAULT_RO_LOAD,	/* Load and hash check of a RO page */
+	TEE_PAGER_FAULT_RW_LOAD,	/* Load and decryption of a RW page */
+	TEE_PAGER_FAULT_ZERO_INIT,	/* Zero initialized locked page */
+	TEE_PAGER_FAULT_UNHIDE,		/* Hidden page mapped again */
+	TEE_PAGER_FAULT_PERM,		/* Permission update, dirty tracking */
+	TEE_PAGER_FAULT_TYPE_NUM,
+};
+
+/*
+ * Histogram buckets of the fault handling durations, bucket 0 counts
+ * faults shorter than 2 microseconds and bucket n > 0 those taking
+ * [2^n, 2^(n + 1)[ microseconds. The last bucket also counts all longer
+ * faults.
+ */
+#define TEE_PAGER_FAULT_HIST_BUCKETS	16
+
+struct tee_pager_fault_stats {
+	size_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint32_t hist[TEE_PAGER_FAULT_HIST_BUCKETS];
+};
+
+/* Number of TAs for which evictions are counted */
+#define TEE_PAGER_STATS_MAX_TA		8
+
+struct tee_pager_ta_stats {
+	TEE_UUID uuid;
+	size_t evictions;	/* pages of the TA evicted */
+};
+
 /*
  * Statistics on the pager
  */
@@ -265,8 +299,39 @@ struct tee_pager_stats {
 	size_t zi_released;
 	size_t npages;		/* number of load pages */
 	size_t npages_all;	/* number of pages */
+	size_t second_chances;	/* referenced pages spared from eviction */
+	size_t ro_resident;	/* mapped pages of read-only areas */
+	size_t rw_resident;	/* mapped pages of read-write areas */
+	size_t hidden;		/* pages currently hidden */
+	size_t read_ahead;	/* pages loaded ahead of sequential faults */
+	size_t ro_evictions;	/* evicted pages of read-only areas */
+	size_t rw_evictions;	/* evicted pages of read-write areas */
+	uint64_t maint_us;	/* time spent in cache and TLB maintenance */
+	struct tee_pager_fault_stats faults[TEE_PAGER_FAULT_TYPE_NUM];
+	struct tee_pager_ta_stats ta[TEE_PAGER_STATS_MAX_TA];
+};
+
+/*
+ * Faults at @va loading a read-only page of the core, @va is a link
+ * address of tee.elf, that is without the ASLR offset
+ */
+struct tee_pager_fault_rec {
+	vaddr_t va;
+	uint32_t count;
 };
 
+#ifdef CFG_CORE_PAGER_FAULT_LOG
+/*
+ * Copies at most @num_recs records of the fault log into @recs and returns
+ * the number of records in the log. @dropped, if not NULL, is updated
+ * with the number of faults not counted because the log was full. The log
+ * is emptied if @reset is true.
+ */
+size_t tee_pager_get_fault_log(struct tee_pager_fault_rec *recs,
+			       size_t num_recs, uint32_t *dropped,
+			       bool reset);
+#endif
+
 #ifdef CFG_WITH_PAGER
 void tee_pager_get_stats(struct tee_pager_stats *stats);
 bool tee_pager_handle_fault(struct abort_info *ai);
@@ -265,6 +265,8 @@
  */
 /* Normal world works as a uniprocessor system */
 #define OPTEE_SMC_NSEC_CAP_UNIPROCESSOR		(1 << 0)
+/* Normal world understands OPTEE_SMC_RPC_AFFINITY_* in RPC returns */
+#define OPTEE_SMC_NSEC_CAP_RPC_AFFINITY		(1 << 1)
 /* Secure world has reserved shared memory for normal world to use */
 #define OPTEE_SMC_SEC_CAP_HAVE_RESERVED_SHM	(1 << 0)
 /* Secure world can communicate via previously unregistered shared memory */
@@ -278,6 +280,14 @@
 #define OPTEE_SMC_SEC_CAP_VIRTUALIZATION	(1 << 3)
 /* Secure world supports Shared Memory with a NULL reference */
 #define OPTEE_SMC_SEC_CAP_MEMREF_NULL		(1 << 4)
+/* Secure world supports OPTEE_MSG_CMD_MULTI_INVOKE */
+#define OPTEE_SMC_SEC_CAP_MULTI_INVOKE		(1 << 5)
+/* Secure world supports OPTEE_SMC_REGISTER_RING */
+#define OPTEE_SMC_SEC_CAP_MSG_RING		(1 << 6)
+/* Secure world reports OPTEE_SMC_RPC_AFFINITY_* if asked to */
+#define OPTEE_SMC_SEC_CAP_RPC_AFFINITY		(1 << 7)
+/* Secure world supports OPTEE_SMC_REGISTER_NOTIF */
+#define OPTEE_SMC_SEC_CAP_ASYNC_NOTIF		(1 << 8)
 
 #define OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES	9
 #define OPTEE_SMC_EXCHANGE_CAPABILITIES \
@@ -384,7 +394,9 @@
  * Call requests usage:
  * a0	SMC Function ID, OPTEE_SMC_VM_CREATED
  * a1	Hypervisor Client ID of newly created virtual machine
- * a2-6 Not used
+ * a2	Size in bytes of the TA RAM of the virtual machine, 0 for an equal
+ *	share of the TA RAM between CFG_VIRT_GUEST_COUNT machines
+ * a3-6 Not used
  * a7	Hypervisor Client ID register. Must be 0, because only hypervisor
  *      can issue this call
  *
@@ -450,6 +462,73 @@
 #define OPTEE_SMC_GET_THREAD_COUNT \
 	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_THREAD_COUNT)
 
+/*
+ * Registers a submission/completion ring, see struct optee_msg_ring
+ *
+ * The ring is processed by OPTEE_MSG_CMD_PROCESS_RING. A completion is
+ * signalled by writing struct optee_msg_ring::cq_tail and, if configured,
+ * raising a non-secure notification interrupt. Registering a ring with
+ * a NULL physical address unregisters the current ring.
+ *
+ * Call register usage:
+ * a0	SMC Function ID, OPTEE_SMC_REGISTER_RING
+ * a1	Upper 32 bits of a 64-bit physical address of the ring
+ * a2	Lower 32 bits of a 64-bit physical address of the ring, page
+ *	aligned
+ * a3	Size of the ring in bytes
+ * a4-6	Not used
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1-7 Preserved
+ *
+ * Error return:
+ * a0	OPTEE_SMC_RETURN_UNKNOWN_FUNCTION   Requested call is not implemented
+ * a0	OPTEE_SMC_RETURN_EBADADDR	    Bad address or size of the ring
+ * a0	OPTEE_SMC_RETURN_EBUSY		    Current ring is being processed
+ * a1-7	Preserved
+ */
+#define OPTEE_SMC_FUNCID_REGISTER_RING	16
+#define OPTEE_SMC_REGISTER_RING \
+	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_REGISTER_RING)
+
+/*
+ * Registers the bitmap of pending asynchronous notifications
+ *
+ * Secure world marks a notification value pending by setting bit
+ * (value % 32) of the 32-bit word (value / 32) of the bitmap with an
+ * atomic operation and then raises a non-secure interrupt. Normal world
+ * fetches and clears the pending values by atomically exchanging each
+ * word with 0. Values below the number of threads are wait queue keys,
+ * a pending value is handled as OPTEE_RPC_WAIT_QUEUE_WAKEUP of that key,
+ * sparing secure world the RPC. Registering a bitmap with a NULL
+ * physical address unregisters the current bitmap, wakeups are then done
+ * with RPCs again.
+ *
+ * Call register usage:
+ * a0	SMC Function ID, OPTEE_SMC_REGISTER_NOTIF
+ * a1	Upper 32 bits of a 64-bit physical address of the bitmap
+ * a2	Lower 32 bits of a 64-bit physical address of the bitmap, page
+ *	aligned
+ * a3	Size of the bitmap in bytes, a multiple of 4 of at most a page
+ *	with at least one bit per thread
+ * a4-6	Not used
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1-7 Preserved
+ *
+ * Error return:
+ * a0	OPTEE_SMC_RETURN_UNKNOWN_FUNCTION   Requested call is not implemented
+ * a0	OPTEE_SMC_RETURN_EBADADDR	    Bad address or size of the bitmap
+ * a1-7	Preserved
+ */
+#define OPTEE_SMC_FUNCID_REGISTER_NOTIF	17
+#define OPTEE_SMC_REGISTER_NOTIF \
+	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_REGISTER_NOTIF)
+
 /*
  * Resume from RPC (for example after processing a foreign interrupt)
  *
@@ -484,6 +563,18 @@
 
 #define OPTEE_SMC_RPC_VAL(func)		((func) | OPTEE_SMC_RETURN_RPC_PREFIX)
 
+/*
+ * Once OPTEE_SMC_NSEC_CAP_RPC_AFFINITY has been exchanged, bits [31:16] of
+ * the a3 resume information of an RPC hold 1 + the index of the core the
+ * thread was suspended on, 0 if there's no preferred core. The stack and
+ * data of the thread are likely to be cached by that core so normal world
+ * should preferably resume the thread there. a3 is still passed back
+ * unmodified when resuming.
+ */
+#define OPTEE_SMC_RPC_AFFINITY_SHIFT		16
+#define OPTEE_SMC_RPC_AFFINITY_MASK		0xFFFF0000
+#define OPTEE_SMC_RPC_THREAD_ID_MASK		0x0000FFFF
+
 /*
  * Allocate memory for RPC parameter passing. The memory is used to hold a
  * struct optee_msg_arg.
@@ -11,6 +11,14 @@ struct thread_svc_regs;
 /* Registered as .handle_svc in struct tee_ta_ops for user TAs. */
 bool user_ta_handle_svc(struct thread_svc_regs *regs);
 
+/*
+ * Handles the short user TA syscalls which neither sleep nor use VFP,
+ * called with all exceptions masked before the state needed by other
+ * syscalls is set up. Returns false if the syscall must be handled by
+ * user_ta_handle_svc() instead.
+ */
+bool user_ta_handle_fast_svc(struct thread_svc_regs *regs);
+
 /* Separate SVC handler for calls from ldelf */
 bool ldelf_handle_svc(struct thread_svc_regs *regs);
 
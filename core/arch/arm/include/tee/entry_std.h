@@ -19,6 +19,13 @@
 uint32_t tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params);
 uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params);
 
+/*
+ * Registers the ring processed by OPTEE_MSG_CMD_PROCESS_RING, called from
+ * the fast call OPTEE_SMC_REGISTER_RING. Returns an OPTEE_SMC_RETURN_*
+ * value.
+ */
+uint32_t tee_entry_std_register_ring(paddr_t pa, size_t size);
+
 /* Get list head for sessions opened from non-secure */
 void nsec_sessions_list_head(struct tee_ta_session_head **open_sessions);
 
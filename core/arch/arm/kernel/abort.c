@@ -13,6 +13,7 @@
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <mm/tee_pager.h>
+#include <mm/vm.h>
 #include <tee/tee_svc.h>
 #include <trace.h>
 #include <unw/unwind.h>
@@ -504,6 +505,26 @@ static enum fault_type get_fault_type(struct abort_info *ai)
 	}
 }
 
+/*
+ * Memref parameters of a TA with TA_FLAG_LAZY_PARAM_MAP are mapped at the
+ * first access, by the TA or by the kernel on behalf of the TA.
+ */
+static bool handle_lazy_map_fault(struct abort_info *ai)
+{
+	struct ts_session *sess = NULL;
+
+	if (ai->abort_type != ABORT_TYPE_DATA ||
+	    core_mmu_get_fault_type(ai->fault_descr) !=
+	    CORE_MMU_FAULT_TRANSLATION)
+		return false;
+
+	sess = ts_get_current_session_may_fail();
+	if (!sess || !is_user_mode_ctx(sess->ctx))
+		return false;
+
+	return vm_map_lazy_region(to_user_mode_ctx(sess->ctx), ai->va);
+}
+
 void abort_handler(uint32_t abort_type, struct thread_abort_regs *regs)
 {
 	struct abort_info ai;
@@ -531,6 +552,8 @@ void abort_handler(uint32_t abort_type, struct thread_abort_regs *regs)
 			abort_print_error(&ai);
 			panic("abort outside thread context");
 		}
+		if (handle_lazy_map_fault(&ai))
+			break;
 		thread_kernel_save_vfp();
 		handled = tee_pager_handle_fault(&ai);
 		thread_kernel_restore_vfp();
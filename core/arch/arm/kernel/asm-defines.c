@@ -107,6 +107,10 @@ DEFINES
 		offsetof(struct thread_core_local, flags));
 	DEFINE(THREAD_CORE_LOCAL_ABT_STACK_VA_END,
 		offsetof(struct thread_core_local, abt_stack_va_end));
+#ifdef CFG_CORE_TIME_SLICE
+	DEFINE(THREAD_CORE_LOCAL_TIME_SLICE_YIELD,
+		offsetof(struct thread_core_local, time_slice_yield));
+#endif
 
 	/* struct core_mmu_config */
 	DEFINE(CORE_MMU_CONFIG_SIZE, sizeof(struct core_mmu_config));
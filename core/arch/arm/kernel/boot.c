@@ -325,7 +325,7 @@ static void init_vcore(tee_mm_pool_t *mm_vcore)
 #endif
 
 	if (!tee_mm_init(mm_vcore, begin, end, SMALL_PAGE_SHIFT,
-			 TEE_MM_POOL_NO_FLAGS))
+			 TEE_MM_POOL_LARGE_FLAGS))
 		panic("tee_mm_vcore init failed");
 }
 
@@ -392,6 +392,7 @@ static void init_runtime(unsigned long pageable_part)
 	size_t tzsram_end = TZSRAM_BASE + TZSRAM_SIZE;
 	size_t hash_size = (pageable_size / SMALL_PAGE_SIZE) *
 			   TEE_SHA256_HASH_SIZE;
+	size_t check_size = 0;
 	const struct boot_embdata *embdata = (const void *)__init_end;
 	const void *tmp_hashes = NULL;
 	tee_mm_entry_t *mm = NULL;
@@ -451,9 +452,18 @@ static void init_runtime(unsigned long pageable_part)
 	 */
 	undo_init_relocation(paged_store);
 
-	/* Check that hashes of what's in pageable area is OK */
+	/*
+	 * Check that hashes of what's in pageable area is OK. Only the init
+	 * part is mapped without going through the pager, with
+	 * CFG_CORE_PAGER_LAZY_HASH_CHECK the rest is checked by the pager
+	 * when each page is loaded the first time.
+	 */
+	if (IS_ENABLED(CFG_CORE_PAGER_LAZY_HASH_CHECK))
+		check_size = init_size;
+	else
+		check_size = pageable_size;
 	DMSG("Checking hashes of pageable area");
-	for (n = 0; (n * SMALL_PAGE_SIZE) < pageable_size; n++) {
+	for (n = 0; (n * SMALL_PAGE_SIZE) < check_size; n++) {
 		const uint8_t *hash = hashes + n * TEE_SHA256_HASH_SIZE;
 		const uint8_t *page = paged_store + n * SMALL_PAGE_SIZE;
 		TEE_Result res;
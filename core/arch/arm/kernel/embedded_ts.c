@@ -7,6 +7,9 @@
 #include <initcall.h>
 #include <kernel/embedded_ts.h>
 #include <kernel/ts_store.h>
+#ifdef CFG_EARLY_TA_COMPRESS_LZ
+#include <lz.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,6 +22,8 @@ struct ts_store_handle {
 	const struct embedded_ts *ts;
 	size_t offs;
 	z_stream strm;
+	uint8_t *lz_buf;
+	size_t lz_buf_blk; /* Block held in @lz_buf + 1, 0: none */
 };
 
 static void *zalloc(void *opaque __unused, unsigned int items,
@@ -66,7 +71,7 @@ TEE_Result emb_ts_open(const TEE_UUID *uuid,
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	if (ts->uncompressed_size) {
+	if (ts->uncompressed_size && !ts->lz_offs) {
 		if (!decompression_init(&handle->strm, ts)) {
 			free(handle);
 			return TEE_ERROR_BAD_FORMAT;
@@ -198,9 +203,95 @@ out:
 	return ret;
 }
 
+#ifdef CFG_EARLY_TA_COMPRESS_LZ
+static TEE_Result read_lz_block(const struct embedded_ts *ts, size_t blk,
+				uint8_t *dst, size_t len)
+{
+	const uint8_t *src = ts->ts + ts->lz_offs[blk];
+	size_t src_len = ts->lz_offs[blk + 1] - ts->lz_offs[blk];
+
+	if (src_len == len) {
+		memcpy(dst, src, len);
+		return TEE_SUCCESS;
+	}
+
+	if (!lz_decompress(src, src_len, dst, len)) {
+		EMSG("Decompression error in block %zu", blk);
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Blocks fully covered by the read are decompressed directly into @data,
+ * partially read blocks go via a bounce buffer which is kept for the
+ * next read, usually continuing in the same block.
+ */
+static TEE_Result read_lz(struct ts_store_handle *h, void *data, size_t len)
+{
+	const struct embedded_ts *ts = h->ts;
+	TEE_Result res = TEE_SUCCESS;
+	size_t next_offs = 0;
+	uint8_t *dst = data;
+
+	if (ADD_OVERFLOW(h->offs, len, &next_offs) ||
+	    next_offs > ts->uncompressed_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Unlike a DEFLATE stream skipped blocks are never decompressed */
+	if (!data) {
+		h->offs = next_offs;
+		return TEE_SUCCESS;
+	}
+
+	while (h->offs < next_offs) {
+		size_t blk = h->offs / EMB_TS_LZ_BLOCK_SIZE;
+		size_t blk_offs = h->offs % EMB_TS_LZ_BLOCK_SIZE;
+		size_t blk_len = MIN((size_t)EMB_TS_LZ_BLOCK_SIZE,
+				     ts->uncompressed_size -
+				     blk * EMB_TS_LZ_BLOCK_SIZE);
+		size_t n = MIN(blk_len - blk_offs, next_offs - h->offs);
+
+		if (n == blk_len) {
+			res = read_lz_block(ts, blk, dst, blk_len);
+			if (res)
+				return res;
+		} else {
+			if (!h->lz_buf) {
+				h->lz_buf = malloc(EMB_TS_LZ_BLOCK_SIZE);
+				if (!h->lz_buf)
+					return TEE_ERROR_OUT_OF_MEMORY;
+			}
+			if (h->lz_buf_blk != blk + 1) {
+				h->lz_buf_blk = 0;
+				res = read_lz_block(ts, blk, h->lz_buf,
+						    blk_len);
+				if (res)
+					return res;
+				h->lz_buf_blk = blk + 1;
+			}
+			memcpy(dst, h->lz_buf + blk_offs, n);
+		}
+		dst += n;
+		h->offs += n;
+	}
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result read_lz(struct ts_store_handle *h __unused,
+			  void *data __unused, size_t len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 TEE_Result emb_ts_read(struct ts_store_handle *h, void *data, size_t len)
 {
-	if (h->ts->uncompressed_size)
+	if (h->ts->lz_offs)
+		return read_lz(h, data, len);
+	else if (h->ts->uncompressed_size)
 		return read_compressed(h, data, len);
 	else
 		return read_uncompressed(h, data, len);
@@ -208,8 +299,9 @@ TEE_Result emb_ts_read(struct ts_store_handle *h, void *data, size_t len)
 
 void emb_ts_close(struct ts_store_handle *h)
 {
-	if (h->ts->uncompressed_size)
+	if (h->ts->uncompressed_size && !h->ts->lz_offs)
 		inflateEnd(&h->strm);
+	free(h->lz_buf);
 	free(h);
 }
 
@@ -141,6 +141,14 @@ TEE_Result ldelf_init_with_ldelf(struct ts_session *sess,
 		 */
 		if (arg->flags & ~TA_FLAGS_MASK)
 			return TEE_ERROR_BAD_FORMAT;
+		/*
+		 * A user TA has a single stack and its user mode context
+		 * (memory mappings of parameters, etc) is updated by each
+		 * entry, it can't be entered by several threads at the
+		 * same time.
+		 */
+		if (arg->flags & TA_FLAG_CONCURRENT)
+			return TEE_ERROR_BAD_FORMAT;
 
 		to_user_ta_ctx(uctx->ts_ctx)->ta_ctx.flags = arg->flags;
 	}
@@ -443,3 +451,87 @@ TEE_Result ldelf_dlsym(struct user_mode_ctx *uctx, TEE_UUID *uuid,
 
 	return res;
 }
+
+static bool names_are_valid(const char *names, size_t names_len,
+			    size_t num_syms)
+{
+	const char *p = names;
+	const char *end = names + names_len;
+	size_t n = 0;
+
+	for (n = 0; n < num_syms; n++) {
+		p += strnlen(p, end - p);
+		if (p == end)
+			return false;
+		p++;
+	}
+
+	return p == end;
+}
+
+TEE_Result ldelf_dlsym_table(struct user_mode_ctx *uctx, TEE_UUID *uuid,
+			     const char *names, size_t names_len,
+			     size_t num_syms, uint64_t *vals)
+{
+	uaddr_t usr_stack = uctx->ldelf_stack_ptr;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct dl_entry_arg *arg = NULL;
+	uint32_t panic_code = 0;
+	uint32_t panicked = 0;
+	struct ts_session *sess = NULL;
+	char *arg_names = NULL;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (!num_syms || MUL_OVERFLOW(num_syms, sizeof(vaddr_t), &sz) ||
+	    ADD_OVERFLOW(sz, sizeof(*arg), &sz) ||
+	    ADD_OVERFLOW(sz, names_len, &sz) || sz > LDELF_STACK_SIZE / 2)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	usr_stack -= ROUNDUP(sz, STACK_ALIGNMENT);
+	arg = (struct dl_entry_arg *)usr_stack;
+
+	res = vm_check_access_rights(uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)arg, sz);
+	if (res) {
+		EMSG("ldelf stack is inaccessible!");
+		return res;
+	}
+
+	memset(arg, 0, sizeof(*arg));
+	arg->cmd = LDELF_DL_ENTRY_DLSYM_TABLE;
+	arg->dlsym_table.uuid = *uuid;
+	arg->dlsym_table.num_syms = num_syms;
+	arg->dlsym_table.names_len = names_len;
+	/* The names are checked once copied, @names may be TA memory */
+	arg_names = (char *)(arg->dlsym_table.vals + num_syms);
+	memcpy(arg_names, names, names_len);
+	if (!names_are_valid(arg_names, names_len, num_syms))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	sess = ts_get_current_session();
+	sess->handle_svc = ldelf_handle_svc;
+
+	res = thread_enter_user_mode((vaddr_t)arg, 0, 0, 0,
+				     usr_stack, uctx->dl_entry_func,
+				     is_arm32, &panicked, &panic_code);
+
+	sess->handle_svc = sess->ctx->ops->handle_svc;
+	ldelf_sess_cleanup(sess);
+
+	if (panicked) {
+		EMSG("ldelf dl_entry function panicked");
+		abort_print_current_ta();
+		res = TEE_ERROR_TARGET_DEAD;
+	}
+	if (!res) {
+		res = arg->ret;
+		for (n = 0; !res && n < num_syms; n++)
+			vals[n] = arg->dlsym_table.vals[n];
+	}
+
+	return res;
+}
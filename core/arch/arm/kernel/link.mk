@@ -100,12 +100,22 @@ $(link-out-dir)/rodata_init.ld.S: $(link-out-dir)/init.o
 	@$(cmd-echo-silent) '  GEN     $@'
 	$(q)$(READELFcore) -S -W $< | $(PYTHON3) ./scripts/gen_ld_sects.py .rodata. > $@
 
+# Hot functions first in the pageable text, see CFG_CORE_PAGED_TEXT_ORDER
+cleanfiles += $(link-out-dir)/text_pageable_order.ld.S
+$(link-out-dir)/text_pageable_order.ld.S: $(CFG_CORE_PAGED_TEXT_ORDER) \
+					  $(conf-file)
+	@$(cmd-echo-silent) '  GEN     $@'
+	@mkdir -p $(dir $@)
+	$(q)$(if $(CFG_CORE_PAGED_TEXT_ORDER), \
+		cat $(CFG_CORE_PAGED_TEXT_ORDER) > $@, : > $@)
+
 -include $(link-script-dep)
 
 link-script-extra-deps += $(link-out-dir)/text_unpaged.ld.S
 link-script-extra-deps += $(link-out-dir)/rodata_unpaged.ld.S
 link-script-extra-deps += $(link-out-dir)/text_init.ld.S
 link-script-extra-deps += $(link-out-dir)/rodata_init.ld.S
+link-script-extra-deps += $(link-out-dir)/text_pageable_order.ld.S
 link-script-extra-deps += $(conf-file)
 cleanfiles += $(link-script-pp) $(link-script-dep)
 $(link-script-pp): $(link-script) $(link-script-extra-deps)
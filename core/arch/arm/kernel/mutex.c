@@ -3,6 +3,8 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <atomic.h>
+#include <kernel/delay.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
@@ -11,6 +13,13 @@
 #include <trace.h>
 
 #include "mutex_lockdep.h"
+#include "thread_private.h"
+
+#ifdef CFG_LOCK_STATS
+#define MUTEX_STATS(m)	((m)->stats)
+#else
+#define MUTEX_STATS(m)	NULL
+#endif
 
 void mutex_init(struct mutex *m)
 {
@@ -22,8 +31,117 @@ void mutex_init_recursive(struct recursive_mutex *m)
 	*m = (struct recursive_mutex)RECURSIVE_MUTEX_INITIALIZER;
 }
 
+#if CFG_MUTEX_SPIN_US
+static void set_owner(struct mutex *m)
+{
+	m->owner = thread_get_id() + 1;
+}
+
+static void clear_owner(struct mutex *m)
+{
+	m->owner = 0;
+}
+
+static bool owner_is_running(short owner)
+{
+	volatile enum thread_state *state = NULL;
+
+	if (!owner || owner - 1 == thread_get_id())
+		return false;
+	state = &threads[owner - 1].state;
+
+	return *state == THREAD_STATE_ACTIVE;
+}
+
+/*
+ * Spins for at most CFG_MUTEX_SPIN_US while the mutex is held for writing
+ * by a thread executing on another core. The mutex is then likely to be
+ * unlocked soon, which saves sleeping in normal world and the RPC to wake
+ * us up again. A writer which isn't active, that is, which is suspended
+ * in normal world, or readers holding the mutex aren't spun on.
+ */
+static void spin_while_owner_runs(struct mutex *m, struct lock_stats *stats,
+				  uint64_t *wait_start)
+{
+	uint64_t timeout = 0;
+
+	if (atomic_load_short(&m->state) != -1)
+		return;
+
+	if (!*wait_start)
+		*wait_start = lock_stats_wait_start(stats);
+	timeout = timeout_init_us(CFG_MUTEX_SPIN_US);
+	while (atomic_load_short(&m->state) == -1 &&
+	       owner_is_running(atomic_load_short(&m->owner)) &&
+	       !timeout_elapsed(timeout))
+		;
+}
+#else
+static void set_owner(struct mutex *m __unused)
+{
+}
+
+static void clear_owner(struct mutex *m __unused)
+{
+}
+
+static void spin_while_owner_runs(struct mutex *m __unused,
+				  struct lock_stats *stats __unused,
+				  uint64_t *wait_start __unused)
+{
+}
+#endif
+
+#ifdef CFG_MUTEX_WRITER_PREFERENCE
+/*
+ * Once a writer waits for the mutex new readers are kept waiting too,
+ * that is, a steady flow of readers can't starve the writers. Writers are
+ * woken before readers by wq_wake_next() and the readers are woken as a
+ * batch once no writer is waiting any longer.
+ *
+ * Note that a thread holding a read lock mustn't take another read lock
+ * of the same mutex as it could then wait for a writer waiting for it.
+ */
+static void writer_wait(struct mutex *m, bool *waiting)
+{
+	if (!*waiting) {
+		m->writers_waiting++;
+		*waiting = true;
+	}
+}
+
+static void writer_acquired(struct mutex *m, bool waiting)
+{
+	if (waiting)
+		m->writers_waiting--;
+}
+
+static bool reader_can_lock(struct mutex *m)
+{
+	return m->state != -1 && !m->writers_waiting;
+}
+#else
+static void writer_wait(struct mutex *m __unused, bool *waiting __unused)
+{
+}
+
+static void writer_acquired(struct mutex *m __unused, bool waiting __unused)
+{
+}
+
+static bool reader_can_lock(struct mutex *m)
+{
+	return m->state != -1;
+}
+#endif
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	struct lock_stats *stats = MUTEX_STATS(m);
+	uint64_t wait_start = 0;
+	unsigned int sleeps = 0;
+	bool waiting = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -44,13 +162,21 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 		 * all.
 		 */
 
+		spin_while_owner_runs(m, stats, &wait_start);
+
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 		can_lock = !m->state;
 		if (!can_lock) {
 			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			writer_wait(m, &waiting);
+			if (!wait_start)
+				wait_start = lock_stats_wait_start(stats);
 		} else {
 			m->state = -1; /* write locked */
+			writer_acquired(m, waiting);
+			set_owner(m);
+			lock_stats_acquired(stats, wait_start, sleeps);
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
@@ -61,6 +187,7 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 			 * world for the lock to become available.
 			 */
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
+			sleeps++;
 		} else
 			return;
 	}
@@ -101,6 +228,7 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 	if (!m->state)
 		panic();
 
+	clear_owner(m);
 	m->state = 0;
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
@@ -136,8 +264,10 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		set_owner(m);
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
@@ -171,6 +301,10 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	struct lock_stats *stats = MUTEX_STATS(m);
+	uint64_t wait_start = 0;
+	unsigned int sleeps = 0;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -189,13 +323,18 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 		 * all.
 		 */
 
+		spin_while_owner_runs(m, stats, &wait_start);
+
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
-		can_lock = m->state != -1;
+		can_lock = reader_can_lock(m);
 		if (!can_lock) {
 			wq_wait_init(&m->wq, &wqe, true /* wait_read */);
+			if (!wait_start)
+				wait_start = lock_stats_wait_start(stats);
 		} else {
 			m->state++; /* read_locked */
+			lock_stats_acquired(stats, wait_start, sleeps);
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
@@ -206,6 +345,7 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 			 * world for the lock to become available.
 			 */
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
+			sleeps++;
 		} else
 			return;
 	}
@@ -223,7 +363,7 @@ static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
 
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
-	can_lock = m->state != -1;
+	can_lock = reader_can_lock(m);
 	if (can_lock)
 		m->state++;
 
@@ -424,6 +564,7 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 		m->state--;
 	} else {
 		/* Only one lock (read or write), unlock the mutex */
+		clear_owner(m);
 		m->state = 0;
 	}
 	new_state = m->state;
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <atomic.h>
+#include <config.h>
+#include <kernel/interrupt.h>
+#include <kernel/misc.h>
+#include <kernel/pmu_profiler.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/ts_manager.h>
+#include <string.h>
+#include <tee/uuid.h>
+#include <trace.h>
+#include <unw/unwind.h>
+#include <util.h>
+
+/*
+ * The highest numbered event counter is used for sampling. Each core is
+ * programmed while it enters from normal world so that changes of the
+ * configuration don't need inter-processor interrupts: the configuration
+ * has a generation number which is compared with the one last applied by
+ * the core.
+ */
+
+struct pmu_prof_core {
+	unsigned int lock;
+	unsigned int gen;
+	bool it_enabled;
+	uint32_t period;
+	size_t head;
+	size_t count;
+	uint32_t dropped;
+	struct pmu_prof_sample samples[CFG_CORE_PMU_PROFILER_SAMPLES];
+};
+
+static struct pmu_prof_core prof_core[CFG_TEE_CORE_NB_CORE];
+
+static unsigned int prof_lock = SPINLOCK_UNLOCK;
+static unsigned int prof_gen;
+static bool prof_running;
+static bool prof_itr_added;
+static uint32_t prof_event;
+static uint32_t prof_period;
+
+static unsigned int counter_idx(void)
+{
+	unsigned int n = (read_pmcr_el0() >> PMCR_N_SHIFT) & PMCR_N_MASK;
+
+	assert(n);
+	return n - 1;
+}
+
+static void counter_stop(unsigned int idx)
+{
+	write_pmintenclr_el1(BIT32(idx));
+	write_pmcntenclr_el0(BIT32(idx));
+	write_pmovsclr_el0(BIT32(idx));
+	isb();
+}
+
+static void counter_start(unsigned int idx, uint32_t event, uint32_t period)
+{
+	write_pmselr_el0(idx);
+	isb();
+	write_pmxevtyper_el0(PMEVTYPER_NSK | PMEVTYPER_NSU | event);
+	write_pmxevcntr_el0(-period);
+	write_pmovsclr_el0(BIT32(idx));
+	write_pmintenset_el1(BIT32(idx));
+	write_pmcntenset_el0(BIT32(idx));
+	write_pmcr_el0(read_pmcr_el0() | PMCR_E);
+	isb();
+}
+
+/*
+ * Returns the frame pointer of the interrupted code: the first frame
+ * record found outside the temporary stack used by the native interrupt
+ * handler, which has been saved by itr_core_handler().
+ */
+static vaddr_t interrupted_fp(void)
+{
+	vaddr_t tmp_end = thread_get_core_local()->tmp_stack_va_end;
+	vaddr_t fp = (vaddr_t)__builtin_frame_address(0);
+	vaddr_t next = 0;
+
+	while (true) {
+		next = *(vaddr_t *)fp;
+		if (next <= fp || next >= tmp_end)
+			return next;
+		fp = next;
+	}
+}
+
+static uint32_t get_callchain(uint64_t pc, uint64_t *callchain)
+{
+	struct unwind_state_arm64 state = { .pc = pc };
+	vaddr_t stack = thread_stack_start();
+	size_t stack_size = thread_stack_size();
+	uint32_t n = 0;
+
+	if (!IS_ENABLED(CFG_UNWIND) || !stack)
+		return 0;
+
+	state.fp = interrupted_fp();
+	while (n < PMU_PROF_CALLCHAIN_DEPTH &&
+	       unwind_stack_arm64(&state, stack, stack_size))
+		callchain[n++] = state.pc;
+
+	return n;
+}
+
+static void record_sample(struct pmu_prof_core *pc)
+{
+	struct pmu_prof_sample *s = NULL;
+	struct ts_session *sess = NULL;
+	uint64_t spsr = read_spsr_el1();
+
+	cpu_spin_lock(&pc->lock);
+
+	if (pc->count == ARRAY_SIZE(pc->samples)) {
+		pc->dropped++;
+		goto out;
+	}
+
+	s = pc->samples + (pc->head + pc->count) % ARRAY_SIZE(pc->samples);
+	pc->count++;
+
+	memset(s, 0, sizeof(*s));
+	s->pc = read_elr_el1();
+	s->core = get_core_pos();
+	if (thread_get_id_may_fail() >= 0)
+		sess = ts_get_current_session_may_fail();
+	if (sess)
+		tee_uuid_to_octets(s->uuid, &sess->ctx->uuid);
+
+	if ((spsr & (SPSR_MODE_RW_32 << SPSR_MODE_RW_SHIFT)) ||
+	    ((spsr >> SPSR_64_MODE_EL_SHIFT) & SPSR_64_MODE_EL_MASK) ==
+	    SPSR_64_MODE_EL0)
+		s->flags |= PMU_PROF_SAMPLE_USER;
+	else
+		s->depth = get_callchain(s->pc, s->callchain);
+out:
+	cpu_spin_unlock(&pc->lock);
+}
+
+static enum itr_return pmu_it_handler(struct itr_handler *h __unused)
+{
+	struct pmu_prof_core *pc = prof_core + get_core_pos();
+	unsigned int idx = counter_idx();
+
+	if (!(read_pmovsclr_el0() & BIT32(idx)))
+		return ITRR_NONE;
+
+	write_pmovsclr_el0(BIT32(idx));
+	write_pmselr_el0(idx);
+	isb();
+	write_pmxevcntr_el0(-pc->period);
+
+	record_sample(pc);
+
+	return ITRR_HANDLED;
+}
+
+static struct itr_handler pmu_itr = {
+	.it = CFG_CORE_PMU_PROFILER_IT,
+	.flags = ITRF_TRIGGER_LEVEL,
+	.handler = pmu_it_handler,
+};
+
+void pmu_profiler_sync(void)
+{
+	struct pmu_prof_core *pc = prof_core + get_core_pos();
+	unsigned int idx = 0;
+	uint32_t event = 0;
+	uint32_t period = 0;
+	bool running = false;
+
+	assert(thread_get_exceptions() == THREAD_EXCP_ALL);
+
+	if (pc->gen == atomic_load_uint(&prof_gen))
+		return;
+
+	cpu_spin_lock(&prof_lock);
+	pc->gen = prof_gen;
+	running = prof_running;
+	event = prof_event;
+	period = prof_period;
+	cpu_spin_unlock(&prof_lock);
+
+	idx = counter_idx();
+	counter_stop(idx);
+	if (!running) {
+		if (pc->it_enabled) {
+			itr_disable(pmu_itr.it);
+			pc->it_enabled = false;
+		}
+		return;
+	}
+
+	if (!pc->it_enabled) {
+		itr_add_this_cpu(pmu_itr.it, pmu_itr.flags);
+		itr_enable(pmu_itr.it);
+		pc->it_enabled = true;
+	}
+	pc->period = period;
+	counter_start(idx, event, period);
+}
+
+static void update_config(bool running, uint32_t event, uint32_t period)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&prof_lock);
+
+	prof_running = running;
+	prof_event = event;
+	prof_period = period;
+	prof_gen++;
+	/*
+	 * The PMU interrupt is only taken from normal world once sampling
+	 * has been requested.
+	 */
+	if (running && !prof_itr_added) {
+		itr_add(&pmu_itr);
+		prof_itr_added = true;
+	}
+	cpu_spin_unlock(&prof_lock);
+
+	pmu_profiler_sync();
+	thread_unmask_exceptions(exceptions);
+}
+
+TEE_Result pmu_profiler_start(uint32_t event, uint32_t period)
+{
+	if (event & ~PMEVTYPER_EVT_MASK || !period)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!((read_pmcr_el0() >> PMCR_N_SHIFT) & PMCR_N_MASK))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	update_config(true, event, period);
+
+	return TEE_SUCCESS;
+}
+
+void pmu_profiler_stop(void)
+{
+	update_config(false, 0, 0);
+}
+
+size_t pmu_profiler_read(struct pmu_prof_sample *samples, size_t count,
+			 uint32_t *dropped)
+{
+	struct pmu_prof_core *pc = NULL;
+	uint32_t exceptions = 0;
+	size_t ret = 0;
+
+	*dropped = 0;
+	for (pc = prof_core; pc < prof_core + ARRAY_SIZE(prof_core); pc++) {
+		exceptions = cpu_spin_lock_xsave(&pc->lock);
+		while (pc->count && ret < count) {
+			samples[ret] = pc->samples[pc->head];
+			pc->head = (pc->head + 1) % ARRAY_SIZE(pc->samples);
+			pc->count--;
+			ret++;
+		}
+		*dropped += pc->dropped;
+		pc->dropped = 0;
+		cpu_spin_unlock_xrestore(&pc->lock, exceptions);
+	}
+
+	return ret;
+}
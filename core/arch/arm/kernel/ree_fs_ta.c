@@ -38,6 +38,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <kernel/mutex.h>
 #include <kernel/thread.h>
 #include <kernel/ts_store.h>
 #include <mm/core_memprot.h>
@@ -47,6 +48,7 @@
 #include <signed_hdr.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
 #include <tee/tee_pobj.h>
@@ -413,66 +415,73 @@ out:
 	return res;
 }
 
+/*
+ * Reads are processed in chunks small enough to remain in the data cache
+ * so each chunk is hashed right after it has been copied or decrypted
+ * instead of reading the whole destination buffer again.
+ */
+#define READ_CHUNK_SIZE		(4 * 1024)
+
+static TEE_Result read_chunk(struct ree_fs_ta_handle *h, uint8_t *dst,
+			     uint8_t *src, size_t len)
+{
+	if (h->shdr->img_type == SHDR_ENCRYPTED_TA) {
+		if (tee_ta_decrypt_update(h->enc_ctx, dst, src, len))
+			return TEE_ERROR_SECURITY;
+	} else if (dst != src) {
+		/* Hash secure buffer (shm might be modified) */
+		memcpy(dst, src, len);
+	}
+
+	if (crypto_hash_update(h->hash_ctx, dst, len))
+		return TEE_ERROR_SECURITY;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result ree_fs_ta_read(struct ts_store_handle *h, void *data,
 				 size_t len)
 {
 	struct ree_fs_ta_handle *handle = (struct ree_fs_ta_handle *)h;
 
 	uint8_t *src = (uint8_t *)handle->nw_ta + handle->offs;
-	size_t next_offs = 0;
-	uint8_t *dst = src;
 	TEE_Result res = TEE_SUCCESS;
+	size_t num_bytes = 0;
+	size_t next_offs = 0;
+	uint8_t *dst = NULL;
+	uint8_t *b = NULL;
 
 	if (ADD_OVERFLOW(handle->offs, len, &next_offs) ||
 	    next_offs > handle->nw_ta_size)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	if (handle->shdr->img_type == SHDR_ENCRYPTED_TA) {
-		if (data) {
-			dst = data; /* Hash secure buffer */
-			res = tee_ta_decrypt_update(handle->enc_ctx, dst, src,
-						    len);
-			if (res != TEE_SUCCESS)
-				return TEE_ERROR_SECURITY;
-		} else {
-			size_t num_bytes = 0;
-			size_t b_size = MIN(1024U, len);
-			uint8_t *b = malloc(b_size);
-
-			if (!b)
-				return TEE_ERROR_OUT_OF_MEMORY;
-
-			dst = NULL;
-			while (num_bytes < len) {
-				size_t n = MIN(b_size, len - num_bytes);
-
-				res = tee_ta_decrypt_update(handle->enc_ctx, b,
-							    src + num_bytes, n);
-				if (res)
-					break;
-				num_bytes += n;
-
-				res = crypto_hash_update(handle->hash_ctx, b,
-							 n);
-				if (res)
-					break;
-			}
-
-			free(b);
-			if (res != TEE_SUCCESS)
-				return TEE_ERROR_SECURITY;
-		}
-	} else if (data) {
-		dst = data; /* Hash secure buffer (shm might be modified) */
-		memcpy(dst, src, len);
+	/* Skipped encrypted data must still be decrypted to be hashed */
+	if (!data && len && handle->shdr->img_type == SHDR_ENCRYPTED_TA) {
+		b = malloc(MIN((size_t)READ_CHUNK_SIZE, len));
+		if (!b)
+			return TEE_ERROR_OUT_OF_MEMORY;
 	}
 
-	if (dst) {
-		res = crypto_hash_update(handle->hash_ctx, dst, len);
-		if (res != TEE_SUCCESS)
-			return TEE_ERROR_SECURITY;
+	while (num_bytes < len) {
+		size_t n = MIN((size_t)READ_CHUNK_SIZE, len - num_bytes);
+
+		if (data)
+			dst = (uint8_t *)data + num_bytes;
+		else if (b)
+			dst = b;
+		else
+			dst = src + num_bytes;
+
+		res = read_chunk(handle, dst, src + num_bytes, n);
+		if (res)
+			break;
+		num_bytes += n;
 	}
 
+	free(b);
+	if (res)
+		return res;
+
 	handle->offs = next_offs;
 	if (handle->offs == handle->nw_ta_size) {
 		if (handle->shdr->img_type == SHDR_ENCRYPTED_TA) {
@@ -533,6 +542,25 @@ REGISTER_TA_STORE(9) = {
  * by the upper layer (ELF loader).
  */
 
+/*
+ * With CFG_REE_FS_TA_CACHE_SIZE != 0 the verified buffers are kept in an
+ * LRU cache of at most CFG_REE_FS_TA_CACHE_SIZE bytes once the handle is
+ * closed, so that the next instance of the same TA is loaded from the
+ * cache without RPC and signature verification. Entries in use by an
+ * open handle are never evicted.
+ */
+struct ta_cache_entry {
+	TEE_UUID uuid;
+	size_t ta_size;
+	tee_mm_entry_t *mm;
+	uint8_t *buf;
+	uint8_t *tag;
+	unsigned int tag_len;
+	unsigned int refcount;
+	bool evicted;
+	TAILQ_ENTRY(ta_cache_entry) link;
+};
+
 struct buf_ree_fs_ta_handle {
 	struct ts_store_handle *h; /* Note: a REE FS TA store handle */
 	size_t ta_size;
@@ -541,8 +569,159 @@ struct buf_ree_fs_ta_handle {
 	size_t offs;
 	uint8_t *tag;
 	unsigned int tag_len;
+	struct ta_cache_entry *entry;
 };
 
+#if CFG_REE_FS_TA_CACHE_SIZE
+/* Most recently used entry first */
+static TAILQ_HEAD(ta_cache_entry_head, ta_cache_entry) ta_cache =
+	TAILQ_HEAD_INITIALIZER(ta_cache);
+static size_t ta_cache_bytes;
+static struct mutex ta_cache_mu = MUTEX_INITIALIZER;
+
+static void cache_entry_free(struct ta_cache_entry *e)
+{
+	tee_mm_free(e->mm);
+	free(e->tag);
+	free(e);
+}
+
+/* Called with ta_cache_mu held */
+static void cache_remove(struct ta_cache_entry *e)
+{
+	TAILQ_REMOVE(&ta_cache, e, link);
+	ta_cache_bytes -= e->ta_size;
+	if (e->refcount)
+		e->evicted = true;
+	else
+		cache_entry_free(e);
+}
+
+static bool cache_get(const TEE_UUID *uuid,
+		      struct buf_ree_fs_ta_handle *handle)
+{
+	struct ta_cache_entry *e = NULL;
+
+	mutex_lock(&ta_cache_mu);
+	TAILQ_FOREACH(e, &ta_cache, link)
+		if (!memcmp(&e->uuid, uuid, sizeof(*uuid)))
+			break;
+	if (e) {
+		e->refcount++;
+		TAILQ_REMOVE(&ta_cache, e, link);
+		TAILQ_INSERT_HEAD(&ta_cache, e, link);
+	}
+	mutex_unlock(&ta_cache_mu);
+
+	if (!e)
+		return false;
+
+	handle->entry = e;
+	handle->ta_size = e->ta_size;
+	handle->buf = e->buf;
+	handle->tag = e->tag;
+	handle->tag_len = e->tag_len;
+
+	return true;
+}
+
+/* Moves the buffer of a freshly verified TA into the cache if it fits */
+static void cache_put(const TEE_UUID *uuid,
+		      struct buf_ree_fs_ta_handle *handle)
+{
+	struct ta_cache_entry *e_lru = NULL;
+	struct ta_cache_entry *prev = NULL;
+	struct ta_cache_entry *e = NULL;
+
+	if (handle->ta_size > CFG_REE_FS_TA_CACHE_SIZE)
+		return;
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return;
+
+	mutex_lock(&ta_cache_mu);
+
+	/* Replace a previous version of the TA */
+	TAILQ_FOREACH(prev, &ta_cache, link) {
+		if (!memcmp(&prev->uuid, uuid, sizeof(*uuid))) {
+			cache_remove(prev);
+			break;
+		}
+	}
+
+	/* Evict the least recently used entries not in use */
+	e_lru = TAILQ_LAST(&ta_cache, ta_cache_entry_head);
+	while (e_lru &&
+	       ta_cache_bytes + handle->ta_size > CFG_REE_FS_TA_CACHE_SIZE) {
+		prev = TAILQ_PREV(e_lru, ta_cache_entry_head, link);
+		if (!e_lru->refcount)
+			cache_remove(e_lru);
+		e_lru = prev;
+	}
+
+	if (ta_cache_bytes + handle->ta_size > CFG_REE_FS_TA_CACHE_SIZE) {
+		mutex_unlock(&ta_cache_mu);
+		free(e);
+		return;
+	}
+
+	e->uuid = *uuid;
+	e->ta_size = handle->ta_size;
+	e->mm = handle->mm;
+	e->buf = handle->buf;
+	e->tag = handle->tag;
+	e->tag_len = handle->tag_len;
+	e->refcount = 1;
+	TAILQ_INSERT_HEAD(&ta_cache, e, link);
+	ta_cache_bytes += e->ta_size;
+
+	mutex_unlock(&ta_cache_mu);
+
+	handle->mm = NULL;
+	handle->entry = e;
+}
+
+static void cache_release(struct ta_cache_entry *e)
+{
+	mutex_lock(&ta_cache_mu);
+	assert(e->refcount);
+	e->refcount--;
+	if (!e->refcount && e->evicted)
+		cache_entry_free(e);
+	mutex_unlock(&ta_cache_mu);
+}
+
+void ree_fs_ta_cache_evict(const TEE_UUID *uuid)
+{
+	struct ta_cache_entry *e = NULL;
+
+	mutex_lock(&ta_cache_mu);
+	TAILQ_FOREACH(e, &ta_cache, link) {
+		if (!memcmp(&e->uuid, uuid, sizeof(*uuid))) {
+			cache_remove(e);
+			break;
+		}
+	}
+	mutex_unlock(&ta_cache_mu);
+}
+#else
+static bool cache_get(const TEE_UUID *uuid __unused,
+		      struct buf_ree_fs_ta_handle *handle __unused)
+{
+	return false;
+}
+
+static void cache_put(const TEE_UUID *uuid __unused,
+		      struct buf_ree_fs_ta_handle *handle __unused)
+{
+}
+
+static void cache_release(struct ta_cache_entry *e __unused)
+{
+}
+#endif
+
 static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 			      struct ts_store_handle **h)
 {
@@ -552,6 +731,10 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	handle = calloc(1, sizeof(*handle));
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	if (cache_get(uuid, handle)) {
+		*h = (struct ts_store_handle *)handle;
+		return TEE_SUCCESS;
+	}
 	res = ree_fs_ta_open(uuid, &handle->h);
 	if (res)
 		goto err2;
@@ -587,6 +770,7 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 	res = ree_fs_ta_read(handle->h, handle->buf, handle->ta_size);
 	if (res)
 		goto err;
+	cache_put(uuid, handle);
 	*h = (struct ts_store_handle *)handle;
 err:
 	ree_fs_ta_close(handle->h);
@@ -645,8 +829,12 @@ static void buf_ta_close(struct ts_store_handle *h)
 
 	if (!handle)
 		return;
-	tee_mm_free(handle->mm);
-	free(handle->tag);
+	if (handle->entry) {
+		cache_release(handle->entry);
+	} else {
+		tee_mm_free(handle->mm);
+		free(handle->tag);
+	}
 	free(handle);
 }
 
@@ -6,6 +6,7 @@
 #include <kernel/thread.h>
 #include <mm/mobj.h>
 #include <string.h>
+#include <util.h>
 
 /*
  * @brief: I2C master transfer request to an I2C slave device.
@@ -60,3 +61,85 @@ TEE_Result rpc_io_i2c_transfer(struct rpc_i2c_request *req, size_t *len)
 
 	return TEE_SUCCESS;
 }
+
+/*
+ * @brief: combined I2C master transfer request to an I2C slave device.
+ * It is the responsibility of the caller to validate the number of bytes
+ * processed by the REE.
+ *
+ * @param req: the secure world I2C master combined request
+ * @param len: the number of data bytes processed by REE
+ * @returns: TEE_SUCCESS on success, TEE_ERROR_XXX on error.
+ */
+TEE_Result rpc_io_i2c_transfer_seq(struct rpc_i2c_seq_request *req,
+				   size_t *len)
+{
+	struct thread_param p[4] = { };
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	uint32_t *desc = NULL;
+	size_t desc_len = 0;
+	size_t data_len = 0;
+	size_t offs = 0;
+	uint8_t *va = NULL;
+	size_t n = 0;
+
+	assert(req);
+
+	if (!len || !req->msg_count || req->msg_count > RPC_I2C_SEQ_MAX_MSGS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	desc_len = req->msg_count * 2 * sizeof(uint32_t);
+	for (n = 0; n < req->msg_count; n++) {
+		if (req->msgs[n].buffer_len > UINT32_MAX ||
+		    ADD_OVERFLOW(data_len, req->msgs[n].buffer_len, &data_len))
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+	if (ADD_OVERFLOW(desc_len, data_len, &offs))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_I2C,
+					THREAD_SHM_TYPE_KERNEL_PRIVATE,
+					offs, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	desc = (uint32_t *)va;
+	offs = desc_len;
+	for (n = 0; n < req->msg_count; n++) {
+		desc[2 * n] = req->msgs[n].mode;
+		desc[2 * n + 1] = req->msgs[n].buffer_len;
+		if (req->msgs[n].mode == RPC_I2C_MODE_WRITE)
+			memcpy(va + offs, req->msgs[n].buffer,
+			       req->msgs[n].buffer_len);
+		offs += req->msgs[n].buffer_len;
+	}
+
+	p[0] = THREAD_PARAM_VALUE(IN, req->msg_count, req->bus, req->chip);
+	p[1] = THREAD_PARAM_VALUE(IN, req->flags, 0, 0);
+	p[2] = THREAD_PARAM_MEMREF(INOUT, mobj, 0, offs);
+	p[3] = THREAD_PARAM_VALUE(OUT, 0, 0, 0);
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_I2C_TRANSFER_SEQ, ARRAY_SIZE(p), p);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/*
+	 * Reporting more bytes than supplied or requested from the I2C chip is
+	 * an REE error
+	 */
+	if (p[3].u.value.a > data_len)
+		return TEE_ERROR_EXCESS_DATA;
+
+	*len = p[3].u.value.a;
+
+	offs = desc_len;
+	for (n = 0; n < req->msg_count; n++) {
+		if (req->msgs[n].mode == RPC_I2C_MODE_READ)
+			memcpy(req->msgs[n].buffer, va + offs,
+			       req->msgs[n].buffer_len);
+		offs += req->msgs[n].buffer_len;
+	}
+
+	return TEE_SUCCESS;
+}
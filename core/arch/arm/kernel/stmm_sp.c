@@ -7,12 +7,15 @@
 #include <crypto/crypto.h>
 #include <ffa.h>
 #include <kernel/abort.h>
+#include <kernel/mutex.h>
 #include <kernel/stmm_sp.h>
 #include <kernel/user_mode_ctx.h>
 #include <mm/fobj.h>
 #include <mm/mobj.h>
 #include <mm/vm.h>
 #include <pta_stmm.h>
+#include <stdlib_ext.h>
+#include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee/tee_pobj.h>
 #include <tee/tee_svc.h>
@@ -75,6 +78,15 @@ extern unsigned char stmm_image[];
 extern const unsigned int stmm_image_size;
 extern const unsigned int stmm_image_uncompressed_size;
 
+/*
+ * With CFG_STMM_IMAGE_CACHE the image is only inflated by the first
+ * instance of StMM, a pristine copy of it is kept to be copied by later
+ * instances. The image can't be shared as StMM makes parts of it writable
+ * once started.
+ */
+static struct fobj *stmm_image_cache;
+static struct mutex stmm_image_cache_mu = MUTEX_INITIALIZER;
+
 static struct stmm_ctx *stmm_alloc_ctx(const TEE_UUID *uuid)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -214,6 +226,73 @@ static void uncompress_image(void *dst, size_t dst_size, void *src,
 		panic("inflateEnd");
 }
 
+static TEE_Result map_image_cache(struct stmm_ctx *spc, size_t sz,
+				  vaddr_t *va)
+{
+	struct mobj *mobj = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	mobj = mobj_with_fobj_alloc(stmm_image_cache, NULL);
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	*va = 0;
+	res = vm_map(&spc->uctx, va, sz, TEE_MATTR_PRW, 0, mobj, 0);
+	mobj_put(mobj);
+
+	return res;
+}
+
+static TEE_Result load_image(struct stmm_ctx *spc, vaddr_t image_addr,
+			     size_t sz)
+{
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t cache_addr = 0;
+	bool fill_cache = false;
+
+	if (!IS_ENABLED(CFG_STMM_IMAGE_CACHE)) {
+		uncompress_image((void *)image_addr,
+				 stmm_image_uncompressed_size, stmm_image,
+				 stmm_image_size);
+		return TEE_SUCCESS;
+	}
+
+	mutex_lock(&stmm_image_cache_mu);
+
+	if (!stmm_image_cache) {
+		uncompress_image((void *)image_addr,
+				 stmm_image_uncompressed_size, stmm_image,
+				 stmm_image_size);
+
+		stmm_image_cache = fobj_ta_mem_alloc(sz / SMALL_PAGE_SIZE);
+		/* Not being able to cache the image isn't fatal */
+		if (!stmm_image_cache)
+			goto out;
+		fill_cache = true;
+	}
+
+	res = map_image_cache(spc, sz, &cache_addr);
+	if (res) {
+		if (fill_cache) {
+			fobj_put(stmm_image_cache);
+			stmm_image_cache = NULL;
+			res = TEE_SUCCESS;
+		}
+		goto out;
+	}
+
+	if (fill_cache)
+		memcpy((void *)cache_addr, (void *)image_addr, sz);
+	else
+		memcpy((void *)image_addr, (void *)cache_addr, sz);
+
+	res = vm_unmap(&spc->uctx, cache_addr, sz);
+out:
+	mutex_unlock(&stmm_image_cache_mu);
+
+	return res;
+}
+
 static TEE_Result load_stmm(struct stmm_ctx *spc)
 {
 	struct stmm_boot_info *boot_info = NULL;
@@ -253,8 +332,9 @@ static TEE_Result load_stmm(struct stmm_ctx *spc)
 	sec_buf_addr = stack_addr + stmm_stack_size;
 
 	vm_set_ctx(&spc->ta_ctx.ts_ctx);
-	uncompress_image((void *)image_addr, stmm_image_uncompressed_size,
-			 stmm_image, stmm_image_size);
+	res = load_image(spc, image_addr, uncompressed_size_roundup);
+	if (res)
+		return res;
 
 	res = vm_set_prot(&spc->uctx, image_addr, uncompressed_size_roundup,
 			  TEE_MATTR_URX | TEE_MATTR_PR);
@@ -346,7 +426,7 @@ TEE_Result stmm_init_session(const TEE_UUID *uuid, struct tee_ta_session *sess)
 
 	mutex_lock(&tee_ta_mutex);
 	spc->is_initializing = false;
-	TAILQ_INSERT_TAIL(&tee_ctxes, &spc->ta_ctx, link);
+	tee_ta_register_ctx(&spc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	return TEE_SUCCESS;
@@ -475,10 +555,61 @@ static uint32_t stmm_get_instance_id(struct ts_ctx *ctx)
 	return to_stmm_ctx(ctx)->uctx.vm_info.asid;
 }
 
+/*
+ * The storage object of StMM is kept open between requests and the most
+ * recently used blocks of it are cached. Writes go through to the object
+ * before completing since StMM expects them to be persistent, the cached
+ * blocks are updated with the written data.
+ */
+#define STMM_STORAGE_BLOCK_SIZE		1024
+
+struct stmm_storage_block {
+	size_t offs;
+	size_t len;
+	unsigned int last_use;
+	bool valid;
+	uint8_t data[STMM_STORAGE_BLOCK_SIZE];
+};
+
+struct stmm_storage {
+	unsigned long storage_id;
+	uint32_t flags;
+	size_t obj_id_len;
+	char obj_id[TEE_OBJECT_ID_MAX_LEN];
+	struct tee_pobj *po;
+	struct tee_file_handle *fh;
+	unsigned int use_count;
+	struct stmm_storage_block blocks[CFG_STMM_STORAGE_CACHE_BLOCKS];
+};
+
+static void sec_storage_close(struct stmm_storage *st)
+{
+	size_t n = 0;
+
+	if (st->fh)
+		st->po->fops->close(&st->fh);
+	if (st->po) {
+		tee_pobj_release(st->po);
+		st->po = NULL;
+	}
+	for (n = 0; n < ARRAY_SIZE(st->blocks); n++)
+		st->blocks[n].valid = false;
+}
+
+static void sec_storage_free(struct stmm_ctx *spc)
+{
+	if (spc->storage) {
+		sec_storage_close(spc->storage);
+		free_wipe(spc->storage);
+		spc->storage = NULL;
+	}
+}
+
 static void stmm_ctx_destroy(struct ts_ctx *ctx)
 {
 	struct stmm_ctx *spc = to_stmm_ctx(ctx);
 
+	sec_storage_free(spc);
 	tee_pager_rem_um_areas(&spc->uctx);
 	vm_info_final(&spc->uctx);
 	free(spc);
@@ -617,30 +748,181 @@ static void service_compose_direct_resp(struct thread_svc_regs *regs,
 	SVC_REGS_A7(regs) = 0;
 }
 
+static TEE_Result sec_storage_open(struct stmm_ctx *spc,
+				   unsigned long storage_id, char *obj_id,
+				   unsigned long obj_id_len, unsigned long flags,
+				   bool create, struct stmm_storage **ret_st)
+{
+	const struct tee_file_operations *fops = NULL;
+	struct stmm_storage *st = spc->storage;
+	TEE_Result res = TEE_SUCCESS;
+
+	COMPILE_TIME_ASSERT(CFG_STMM_STORAGE_CACHE_BLOCKS > 0);
+
+	fops = tee_svc_storage_file_ops(storage_id);
+	if (!fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	if (obj_id_len > TEE_OBJECT_ID_MAX_LEN)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!st) {
+		st = calloc(1, sizeof(*st));
+		if (!st)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		spc->storage = st;
+	}
+
+	if (st->fh && st->storage_id == storage_id && st->flags == flags &&
+	    st->obj_id_len == obj_id_len &&
+	    !memcmp(st->obj_id, obj_id, obj_id_len)) {
+		*ret_st = st;
+		return TEE_SUCCESS;
+	}
+
+	sec_storage_close(st);
+
+	res = tee_pobj_get(&spc->ta_ctx.ts_ctx.uuid, obj_id, obj_id_len, flags,
+			   false, fops, &st->po);
+	if (res != TEE_SUCCESS) {
+		st->po = NULL;
+		return res;
+	}
+
+	res = fops->open(st->po, NULL, &st->fh);
+	if (res == TEE_ERROR_ITEM_NOT_FOUND && create)
+		res = fops->create(st->po, false, NULL, 0, NULL, 0, NULL, 0,
+				   &st->fh);
+	if (res != TEE_SUCCESS) {
+		st->fh = NULL;
+		sec_storage_close(st);
+		return res;
+	}
+
+	st->storage_id = storage_id;
+	st->flags = flags;
+	st->obj_id_len = obj_id_len;
+	memcpy(st->obj_id, obj_id, obj_id_len);
+	*ret_st = st;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sec_storage_read(struct stmm_storage *st, size_t offs,
+				   void *buf, size_t *len)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = st->po->fops->read(st->fh, offs, buf, len);
+	if (res == TEE_ERROR_CORRUPT_OBJECT) {
+		EMSG("Object corrupt");
+		st->po->fops->remove(st->po);
+		sec_storage_close(st);
+	}
+
+	return res;
+}
+
+static TEE_Result sec_storage_get_block(struct stmm_storage *st, size_t offs,
+					struct stmm_storage_block **ret_blk)
+{
+	struct stmm_storage_block *blk = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(st->blocks); n++) {
+		if (st->blocks[n].valid && st->blocks[n].offs == offs) {
+			blk = st->blocks + n;
+			goto out;
+		}
+		if (!blk || !st->blocks[n].valid ||
+		    (blk->valid && st->blocks[n].last_use < blk->last_use))
+			blk = st->blocks + n;
+	}
+
+	blk->valid = false;
+	blk->offs = offs;
+	blk->len = sizeof(blk->data);
+	res = sec_storage_read(st, offs, blk->data, &blk->len);
+	if (res != TEE_SUCCESS)
+		return res;
+	blk->valid = true;
+out:
+	blk->last_use = ++st->use_count;
+	*ret_blk = blk;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sec_storage_read_cached(struct stmm_storage *st, void *data,
+					  size_t len, size_t offset)
+{
+	struct stmm_storage_block *blk = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t blk_offs = 0;
+	size_t done = 0;
+	size_t l = 0;
+
+	while (done < len) {
+		blk_offs = (offset + done) % STMM_STORAGE_BLOCK_SIZE;
+		res = sec_storage_get_block(st, offset + done - blk_offs, &blk);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		l = MIN(len - done, STMM_STORAGE_BLOCK_SIZE - blk_offs);
+		/* A short read means that the object is too small */
+		if (blk->len < blk_offs + l)
+			return TEE_ERROR_CORRUPT_OBJECT;
+		memcpy((uint8_t *)data + done, blk->data + blk_offs, l);
+		done += l;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void sec_storage_update_cache(struct stmm_storage *st,
+				     const void *data, size_t len,
+				     size_t offset)
+{
+	struct stmm_storage_block *blk = NULL;
+	size_t start = 0;
+	size_t end = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(st->blocks); n++) {
+		blk = st->blocks + n;
+		if (!blk->valid || offset >= blk->offs + sizeof(blk->data) ||
+		    offset + len <= blk->offs)
+			continue;
+
+		start = MAX(offset, blk->offs);
+		end = MIN(offset + len, blk->offs + sizeof(blk->data));
+		/* A write past the cached end may leave a hole, reload it */
+		if (start > blk->offs + blk->len) {
+			blk->valid = false;
+			continue;
+		}
+		memcpy(blk->data + start - blk->offs,
+		       (const uint8_t *)data + start - offset, end - start);
+		blk->len = MAX(blk->len, end - blk->offs);
+	}
+}
+
 /*
- * Combined read from secure partition, this will open, read and
- * close the file object.
+ * Combined read from secure partition, this will open the file object
+ * unless already done by a previous request and read it through the
+ * cache.
  */
 static TEE_Result sec_storage_obj_read(unsigned long storage_id, char *obj_id,
 				       unsigned long obj_id_len, void *data,
 				       unsigned long len, unsigned long offset,
 				       unsigned long flags)
 {
-	const struct tee_file_operations *fops = NULL;
 	TEE_Result res = TEE_ERROR_BAD_STATE;
+	struct stmm_storage *st = NULL;
 	struct ts_session *sess = NULL;
-	struct tee_file_handle *fh = NULL;
 	struct stmm_ctx *spc = NULL;
-	struct tee_pobj *po = NULL;
-	size_t file_size = 0;
-	size_t read_len = 0;
-
-	fops = tee_svc_storage_file_ops(storage_id);
-	if (!fops)
-		return TEE_ERROR_ITEM_NOT_FOUND;
-
-	if (obj_id_len > TEE_OBJECT_ID_MAX_LEN)
-		return TEE_ERROR_BAD_PARAMETERS;
+	size_t end = 0;
 
 	sess = ts_get_current_session();
 	spc = to_stmm_ctx(sess->ctx);
@@ -651,35 +933,21 @@ static TEE_Result sec_storage_obj_read(unsigned long storage_id, char *obj_id,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_pobj_get(&sess->ctx->uuid, obj_id, obj_id_len, flags,
-			   false, fops, &po);
-	if (res != TEE_SUCCESS)
-		return res;
+	if (ADD_OVERFLOW(offset, len, &end))
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = po->fops->open(po, &file_size, &fh);
+	res = sec_storage_open(spc, storage_id, obj_id, obj_id_len, flags,
+			       false, &st);
 	if (res != TEE_SUCCESS)
-		goto out;
-
-	read_len = len;
-	res = po->fops->read(fh, offset, data, &read_len);
-	if (res == TEE_ERROR_CORRUPT_OBJECT) {
-		EMSG("Object corrupt");
-		po->fops->remove(po);
-	} else if (res == TEE_SUCCESS && len != read_len) {
-		res = TEE_ERROR_CORRUPT_OBJECT;
-	}
-
-	po->fops->close(&fh);
-
-out:
-	tee_pobj_release(po);
+		return res;
 
-	return res;
+	return sec_storage_read_cached(st, data, len, offset);
 }
 
 /*
- * Combined write from secure partition, this will create/open, write and
- * close the file object.
+ * Combined write from secure partition, this will create/open the file
+ * object unless already done by a previous request and write through to
+ * it.
  */
 static TEE_Result sec_storage_obj_write(unsigned long storage_id, char *obj_id,
 					unsigned long obj_id_len, void *data,
@@ -687,19 +955,11 @@ static TEE_Result sec_storage_obj_write(unsigned long storage_id, char *obj_id,
 					unsigned long flags)
 
 {
-	const struct tee_file_operations *fops = NULL;
+	struct stmm_storage *st = NULL;
 	struct ts_session *sess = NULL;
-	struct tee_file_handle *fh = NULL;
 	struct stmm_ctx *spc = NULL;
 	TEE_Result res = TEE_SUCCESS;
-	struct tee_pobj *po = NULL;
-
-	fops = tee_svc_storage_file_ops(storage_id);
-	if (!fops)
-		return TEE_ERROR_ITEM_NOT_FOUND;
-
-	if (obj_id_len > TEE_OBJECT_ID_MAX_LEN)
-		return TEE_ERROR_BAD_PARAMETERS;
+	size_t end = 0;
 
 	sess = ts_get_current_session();
 	spc = to_stmm_ctx(sess->ctx);
@@ -710,21 +970,19 @@ static TEE_Result sec_storage_obj_write(unsigned long storage_id, char *obj_id,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_pobj_get(&sess->ctx->uuid, obj_id, obj_id_len, flags,
-			   false, fops, &po);
+	if (ADD_OVERFLOW(offset, len, &end))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = sec_storage_open(spc, storage_id, obj_id, obj_id_len, flags,
+			       true, &st);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = po->fops->open(po, NULL, &fh);
-	if (res == TEE_ERROR_ITEM_NOT_FOUND)
-		res = po->fops->create(po, false, NULL, 0, NULL, 0, NULL, 0,
-				       &fh);
-	if (res == TEE_SUCCESS) {
-		res = po->fops->write(fh, offset, data, len);
-		po->fops->close(&fh);
-	}
-
-	tee_pobj_release(po);
+	res = st->po->fops->write(st->fh, offset, data, len);
+	if (res == TEE_SUCCESS)
+		sec_storage_update_cache(st, data, len, offset);
+	else
+		sec_storage_close(st);
 
 	return res;
 }
@@ -787,13 +1045,13 @@ static void stmm_handle_storage_service(struct thread_svc_regs *regs)
 
 	switch (action) {
 	case __FFA_SVC_RPMB_READ:
-		DMSG("RPMB read");
+		FMSG("RPMB read");
 		res = sec_storage_obj_read(TEE_STORAGE_PRIVATE_RPMB, obj_id,
 					   obj_id_len, va, len, offset, flags);
 		stmm_rc = tee2stmm_ret_val(res);
 		break;
 	case __FFA_SVC_RPMB_WRITE:
-		DMSG("RPMB write");
+		FMSG("RPMB write");
 		res = sec_storage_obj_write(TEE_STORAGE_PRIVATE_RPMB, obj_id,
 					    obj_id_len, va, len, offset, flags);
 		stmm_rc = tee2stmm_ret_val(res);
@@ -848,11 +1106,11 @@ static bool spm_handle_svc(struct thread_svc_regs *regs)
 		*a0 = MAKE_FFA_VERSION(FFA_VERSION_MAJOR, FFA_VERSION_MINOR);
 		return true;
 	case __FFA_MSG_SEND_DIRECT_RESP:
-		DMSG("Received FFA direct response");
+		FMSG("Received FFA direct response");
 		return_from_sp_helper(false, 0, regs);
 		return false;
 	case __FFA_MSG_SEND_DIRECT_REQ:
-		DMSG("Received FFA direct request");
+		FMSG("Received FFA direct request");
 		spm_handle_direct_req(regs);
 		return true;
 	default:
@@ -16,6 +16,7 @@ srcs-y += delay.c
 
 srcs-$(CFG_SECURE_TIME_SOURCE_CNTPCT) += tee_time_arm_cntpct.c
 srcs-$(CFG_SECURE_TIME_SOURCE_REE) += tee_time_ree.c
+srcs-$(CFG_CORE_TIME_PAGE) += time_page.c
 srcs-$(CFG_ARM64_core) += timer_a64.c
 
 srcs-$(CFG_ARM32_core) += spin_lock_a32.S
@@ -65,6 +66,8 @@ srcs-$(CFG_ARM64_core) += unwind_arm64.c
 endif
 
 srcs-$(CFG_VIRTUALIZATION) += virtualization.c
+srcs-$(CFG_CORE_PMU_PROFILER) += pmu_profiler.c
+srcs-$(CFG_CORE_TIME_SLICE) += time_slice.c
 
 srcs-y += link_dummies_paged.c
 srcs-y += link_dummies_init.c
@@ -8,6 +8,7 @@
 #include <initcall.h>
 #include <kernel/tee_time.h>
 #include <kernel/thread.h>
+#include <kernel/time_page.h>
 #include <kernel/time_source.h>
 #include <mm/core_mmu.h>
 #include <optee_rpc_cmd.h>
@@ -29,6 +30,22 @@ TEE_Result tee_time_get_sys_time(TEE_Time *time)
 	return _time_source.get_sys_time(time);
 }
 
+TEE_Result tee_time_get_sys_time_ns(uint64_t *ns)
+{
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time t = { };
+
+	if (_time_source.get_sys_time_ns)
+		return _time_source.get_sys_time_ns(ns);
+
+	res = _time_source.get_sys_time(&t);
+	if (!res)
+		*ns = t.seconds * TEE_TIME_NSEC_PER_SEC +
+		      t.millis * TEE_TIME_NSEC_PER_MSEC;
+
+	return res;
+}
+
 uint32_t tee_time_get_sys_time_protection_level(void)
 {
 	return _time_source.protection_level;
@@ -61,6 +78,7 @@ TEE_Result tee_time_get_ree_time(TEE_Time *time)
 	if (res == TEE_SUCCESS) {
 		time->seconds = params.u.value.a;
 		time->millis = params.u.value.b / 1000000;
+		time_page_set_ree_time(time);
 	}
 
 	return res;
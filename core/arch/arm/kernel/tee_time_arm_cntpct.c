@@ -14,13 +14,65 @@
 #include <trace.h>
 #include <utee_defines.h>
 
-static TEE_Result arm_cntpct_get_sys_time(TEE_Time *time)
+/*
+ * Counter ticks are converted to nanoseconds with ns = (cnt * mult) >> shift,
+ * avoiding a division by the counter frequency each time the time is read.
+ * The constants are computed once with the largest shift keeping @mult in
+ * 32 bits, the relative error is then below 2^-31.
+ */
+static uint32_t cnt_mult;
+static unsigned int cnt_shift;
+
+static void init_cnt_conv(void)
 {
-	uint64_t cntpct = barrier_read_cntpct();
 	uint32_t cntfrq = read_cntfrq();
+	unsigned int shift = 32;
+	uint64_t mult = 0;
+
+	while (true) {
+		mult = (TEE_TIME_NSEC_PER_SEC << shift) / cntfrq;
+		if (mult <= UINT32_MAX || !shift)
+			break;
+		shift--;
+	}
+
+	cnt_shift = shift;
+	/* Set last, concurrent first callers compute the same values */
+	__atomic_store_n(&cnt_mult, mult, __ATOMIC_RELEASE);
+}
+
+static uint64_t cnt2ns(uint64_t cnt)
+{
+	uint64_t mult = __atomic_load_n(&cnt_mult, __ATOMIC_ACQUIRE);
+	uint64_t lo = 0;
+	uint64_t hi = 0;
+
+	if (!mult) {
+		init_cnt_conv();
+		mult = cnt_mult;
+	}
+
+	/* 64x32 bits multiplication, only the result has to fit 64 bits */
+	lo = ((cnt & UINT32_MAX) * mult) >> cnt_shift;
+	hi = ((cnt >> 32) * mult) << (32 - cnt_shift);
+
+	return hi + lo;
+}
+
+static TEE_Result arm_cntpct_get_sys_time_ns(uint64_t *ns)
+{
+	*ns = cnt2ns(barrier_read_cntpct());
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result arm_cntpct_get_sys_time(TEE_Time *time)
+{
+	uint64_t ns = cnt2ns(barrier_read_cntpct());
 
-	time->seconds = cntpct / cntfrq;
-	time->millis = (cntpct % cntfrq) / (cntfrq / TEE_TIME_MILLIS_BASE);
+	/* Divisions by constants, turned into multiplications */
+	time->seconds = ns / TEE_TIME_NSEC_PER_SEC;
+	time->millis = (ns % TEE_TIME_NSEC_PER_SEC) / TEE_TIME_NSEC_PER_MSEC;
 
 	return TEE_SUCCESS;
 }
@@ -29,6 +81,7 @@ static const struct time_source arm_cntpct_time_source = {
 	.name = "arm cntpct",
 	.protection_level = 1000,
 	.get_sys_time = arm_cntpct_get_sys_time,
+	.get_sys_time_ns = arm_cntpct_get_sys_time_ns,
 };
 
 REGISTER_TIME_SOURCE(arm_cntpct_time_source)
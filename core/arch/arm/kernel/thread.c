@@ -9,7 +9,9 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <config.h>
+#include <console.h>
 #include <io.h>
 #include <keep.h>
 #include <kernel/asan.h>
@@ -22,6 +24,7 @@
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread_defs.h>
 #include <kernel/thread.h>
+#include <kernel/time_slice.h>
 #include <kernel/user_mode_ctx_struct.h>
 #include <kernel/virtualization.h>
 #include <mm/core_memprot.h>
@@ -30,7 +33,10 @@
 #include <mm/tee_pager.h>
 #include <mm/vm.h>
 #include <smccc.h>
+#include <sm/optee_smc.h>
 #include <sm/sm.h>
+#include <string.h>
+#include <tee/arch_svc.h>
 #include <trace.h>
 #include <util.h>
 
@@ -248,6 +254,141 @@ void thread_unlock_global(void)
 	cpu_spin_unlock(&thread_global_lock);
 }
 
+#ifdef CFG_CORE_THREAD_POOL_PER_CORE
+/*
+ * Per-core caches of free threads. A standard call allocates a thread
+ * from the cache of the core it's entering on and only steals from the
+ * caches of the other cores when that one is empty. Threads are returned
+ * to the cache of the core where they are freed. This keeps the cores
+ * from serializing on thread_global_lock when entering with standard
+ * calls.
+ *
+ * The state field of a thread is only changed from and to
+ * THREAD_STATE_FREE while holding the lock of the pool the thread is
+ * added to or taken from.
+ */
+struct thread_pool {
+	unsigned int lock;
+	unsigned int count;
+	short int ids[CFG_NUM_THREADS];
+} __aligned(64);
+
+static struct thread_pool thread_pools[CFG_TEE_CORE_NB_CORE];
+
+static void __nostackcheck thread_pool_add(size_t pos, size_t n)
+{
+	struct thread_pool *pool = thread_pools + pos;
+
+	cpu_spin_lock(&pool->lock);
+	assert(pool->count < CFG_NUM_THREADS);
+	threads[n].state = THREAD_STATE_FREE;
+	pool->ids[pool->count] = n;
+	pool->count++;
+	cpu_spin_unlock(&pool->lock);
+}
+
+static bool thread_pool_take(size_t pos, size_t *n)
+{
+	struct thread_pool *pool = thread_pools + pos;
+	bool found_thread = false;
+
+	/* Avoid touching the lock of a remote core with an empty pool */
+	if (!atomic_load_uint(&pool->count))
+		return false;
+
+	cpu_spin_lock(&pool->lock);
+	if (pool->count) {
+		pool->count--;
+		*n = pool->ids[pool->count];
+		assert(threads[*n].state == THREAD_STATE_FREE);
+		threads[*n].state = THREAD_STATE_ACTIVE;
+		found_thread = true;
+	}
+	cpu_spin_unlock(&pool->lock);
+
+	return found_thread;
+}
+
+static void init_thread_pools(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
+		thread_pools[n].lock = SPINLOCK_UNLOCK;
+		thread_pools[n].count = 0;
+	}
+
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		if (threads[n].state == THREAD_STATE_FREE)
+			thread_pool_add(n % CFG_TEE_CORE_NB_CORE, n);
+}
+
+static bool alloc_free_thread(size_t *n)
+{
+	size_t pos = get_core_pos();
+	size_t i = 0;
+
+	for (i = 0; i < CFG_TEE_CORE_NB_CORE; i++)
+		if (thread_pool_take((pos + i) % CFG_TEE_CORE_NB_CORE, n))
+			return true;
+
+	return false;
+}
+
+static void __nostackcheck release_free_thread(size_t n)
+{
+	thread_pool_add(get_core_pos(), n);
+}
+
+void thread_lock_all_pools(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+		cpu_spin_lock(&thread_pools[n].lock);
+}
+
+void thread_unlock_all_pools(void)
+{
+	size_t n = 0;
+
+	for (n = CFG_TEE_CORE_NB_CORE; n > 0; n--)
+		cpu_spin_unlock(&thread_pools[n - 1].lock);
+}
+#else /*CFG_CORE_THREAD_POOL_PER_CORE*/
+static void init_thread_pools(void)
+{
+}
+
+static bool alloc_free_thread(size_t *n)
+{
+	bool found_thread = false;
+	size_t i = 0;
+
+	thread_lock_global();
+
+	for (i = 0; i < CFG_NUM_THREADS; i++) {
+		if (threads[i].state == THREAD_STATE_FREE) {
+			threads[i].state = THREAD_STATE_ACTIVE;
+			*n = i;
+			found_thread = true;
+			break;
+		}
+	}
+
+	thread_unlock_global();
+
+	return found_thread;
+}
+
+static void __nostackcheck release_free_thread(size_t n)
+{
+	thread_lock_global();
+	threads[n].state = THREAD_STATE_FREE;
+	thread_unlock_global();
+}
+#endif /*CFG_CORE_THREAD_POOL_PER_CORE*/
+
 #ifdef ARM32
 uint32_t __nostackcheck thread_get_exceptions(void)
 {
@@ -334,6 +475,13 @@ struct thread_core_local * __nostackcheck thread_get_core_local(void)
 }
 
 #ifdef CFG_CORE_DEBUG_CHECK_STACKS
+/*
+ * Deepest use seen by check_stack_limits() of the temporary and abort
+ * stacks of each core followed by the thread stacks.
+ */
+#define NUM_STACKS	(2 * CFG_TEE_CORE_NB_CORE + CFG_NUM_THREADS)
+static size_t stack_max_used[NUM_STACKS] __nex_bss;
+
 static void print_stack_limits(void)
 {
 	size_t n = 0;
@@ -373,6 +521,71 @@ static void check_stack_limits(void)
 	}
 }
 
+static size_t * __nostackcheck get_stack_max_used(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	unsigned int pos = get_core_pos();
+	struct thread_core_local *l = get_core_local(pos);
+	int ct = l->curr_thread;
+	size_t *p = NULL;
+
+	if (l->flags & THREAD_CLF_TMP)
+		p = stack_max_used + pos;
+	else if (l->flags & THREAD_CLF_ABORT)
+		p = stack_max_used + CFG_TEE_CORE_NB_CORE + pos;
+	else if (!l->flags && ct >= 0 && ct < CFG_NUM_THREADS)
+		p = stack_max_used + 2 * CFG_TEE_CORE_NB_CORE + ct;
+
+	thread_unmask_exceptions(exceptions);
+	return p;
+}
+
+static void update_stack_max_used(void)
+{
+	vaddr_t stack_start = 0;
+	vaddr_t stack_end = 0;
+	/* Any value in the current stack frame will do */
+	vaddr_t current_sp = (vaddr_t)&stack_start;
+	size_t *max_used = get_stack_max_used();
+
+	/* The stack is only used by the current core or thread */
+	if (max_used && get_stack_soft_limits(&stack_start, &stack_end) &&
+	    stack_end - current_sp > *max_used)
+		*max_used = stack_end - current_sp;
+}
+
+size_t thread_get_stack_usage(struct thread_stack_usage *usage, size_t count,
+			      bool reset)
+{
+	size_t n = 0;
+
+	for (n = 0; n < MIN(count, (size_t)NUM_STACKS); n++) {
+		if (n < CFG_TEE_CORE_NB_CORE) {
+			usage[n].type = THREAD_STACK_TYPE_TMP;
+			usage[n].index = n;
+			usage[n].size = GET_STACK_BOTTOM(stack_tmp, n) -
+					GET_STACK_TOP_SOFT(stack_tmp, n);
+		} else if (n < 2 * CFG_TEE_CORE_NB_CORE) {
+			usage[n].type = THREAD_STACK_TYPE_ABT;
+			usage[n].index = n - CFG_TEE_CORE_NB_CORE;
+			usage[n].size =
+				GET_STACK_BOTTOM(stack_abt, usage[n].index) -
+				GET_STACK_TOP_SOFT(stack_abt, usage[n].index);
+		} else {
+			usage[n].type = THREAD_STACK_TYPE_THREAD;
+			usage[n].index = n - 2 * CFG_TEE_CORE_NB_CORE;
+			usage[n].size = STACK_THREAD_SIZE - STACK_CHECK_EXTRA;
+		}
+		usage[n].max_used = stack_max_used[n];
+	}
+
+	/* Values updated concurrently may be lost, it's only statistics */
+	if (reset)
+		memset(stack_max_used, 0, sizeof(stack_max_used));
+
+	return NUM_STACKS;
+}
+
 static bool * __nostackcheck get_stackcheck_recursion_flag(void)
 {
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
@@ -401,6 +614,7 @@ void __nostackcheck __cyg_profile_func_enter(void *this_fn __unused,
 		return;
 	*p = true;
 	check_stack_limits();
+	update_stack_max_used();
 	*p = false;
 }
 
@@ -415,6 +629,23 @@ static void print_stack_limits(void)
 }
 #endif
 
+/*
+ * Disables the VFP if it was left enabled by thread_kernel_disable_vfp()
+ * with CFG_CORE_LAZY_KERNEL_VFP=y. The VFP registers only hold dead
+ * kernel state at this point so there's nothing to save.
+ */
+static void thread_release_kernel_vfp(void)
+{
+#ifdef CFG_WITH_VFP
+	struct thread_ctx *thr = threads + thread_get_id();
+
+	if (thr->vfp_state.kern_lingering) {
+		thr->vfp_state.kern_lingering = false;
+		vfp_disable();
+	}
+#endif /*CFG_WITH_VFP*/
+}
+
 static void thread_lazy_save_ns_vfp(void)
 {
 #ifdef CFG_WITH_VFP
@@ -433,6 +664,12 @@ static void thread_lazy_restore_ns_vfp(void)
 
 	assert(!thr->vfp_state.sec_lazy_saved && !thr->vfp_state.sec_saved);
 
+	/*
+	 * Any lingering kernel VFP state is dead and about to be
+	 * overwritten with the normal world state below.
+	 */
+	thr->vfp_state.kern_lingering = false;
+
 	if (tuv && tuv->lazy_saved && !tuv->saved) {
 		vfp_lazy_save_state_final(&tuv->vfp, false /*!force_save*/);
 		tuv->saved = true;
@@ -514,10 +751,12 @@ void thread_init_boot_thread(void)
 {
 	struct thread_core_local *l = thread_get_core_local();
 
+	/* Must be set before the free threads are added to the pools */
+	threads[0].state = THREAD_STATE_ACTIVE;
+
 	thread_init_threads();
 
 	l->curr_thread = 0;
-	threads[0].state = THREAD_STATE_ACTIVE;
 }
 
 void __nostackcheck thread_clr_boot_thread(void)
@@ -526,31 +765,18 @@ void __nostackcheck thread_clr_boot_thread(void)
 
 	assert(l->curr_thread >= 0 && l->curr_thread < CFG_NUM_THREADS);
 	assert(threads[l->curr_thread].state == THREAD_STATE_ACTIVE);
-	threads[l->curr_thread].state = THREAD_STATE_FREE;
+	release_free_thread(l->curr_thread);
 	l->curr_thread = -1;
 }
 
 void thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
 {
-	size_t n;
+	size_t n = 0;
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
 
 	assert(l->curr_thread == -1);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
-	}
-
-	thread_unlock_global();
-
-	if (!found_thread)
+	if (!alloc_free_thread(&n))
 		return;
 
 	l->curr_thread = n;
@@ -678,6 +904,9 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 	if (is_user_mode(&threads[n].regs))
 		tee_ta_update_session_utime_resume();
 
+	if (threads[n].have_user_map)
+		time_slice_resume(n);
+
 	/*
 	 * Return from RPC to request service of a foreign interrupt must not
 	 * get parameters from non-secure world.
@@ -815,22 +1044,20 @@ void thread_state_free(void)
 
 	assert(ct != -1);
 
+	console_drain_deferred();
 	thread_lazy_restore_ns_vfp();
 	tee_pager_release_phys(
 		(void *)(threads[ct].stack_va_end - STACK_THREAD_SIZE),
 		STACK_THREAD_SIZE);
 
-	thread_lock_global();
-
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
-	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
+	release_free_thread(ct);
 	l->curr_thread = -1;
 
 #ifdef CFG_VIRTUALIZATION
 	virt_unset_guest();
 #endif
-	thread_unlock_global();
 }
 
 #ifdef CFG_WITH_PAGER
@@ -860,6 +1087,29 @@ static void release_unused_kernel_stack(struct thread_ctx *thr __unused,
 }
 #endif
 
+#ifdef CFG_CORE_RPC_AFFINITY
+static bool rpc_affinity __nex_bss;
+
+void thread_set_rpc_affinity(bool enable)
+{
+	rpc_affinity = enable;
+}
+
+/* Returns the resume information of the suspended thread @ct */
+static int resume_info(int ct)
+{
+	if (!rpc_affinity)
+		return ct;
+
+	return ct | ((get_core_pos() + 1) << OPTEE_SMC_RPC_AFFINITY_SHIFT);
+}
+#else
+static int resume_info(int ct)
+{
+	return ct;
+}
+#endif
+
 int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 {
 	struct thread_core_local *l = thread_get_core_local();
@@ -880,6 +1130,7 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 		tee_ta_gprof_sample_pc(pc);
 	}
 	thread_lazy_restore_ns_vfp();
+	console_drain_deferred();
 
 	thread_lock_global();
 
@@ -905,7 +1156,7 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 
 	thread_unlock_global();
 
-	return ct;
+	return resume_info(ct);
 }
 
 #ifdef ARM32
@@ -1062,6 +1313,8 @@ void thread_init_threads(void)
 		TAILQ_INIT(&threads[n].tsd.sess_stack);
 		SLIST_INIT(&threads[n].tsd.pgt_cache);
 	}
+
+	init_thread_pools();
 }
 
 void __nostackcheck thread_init_thread_core_local(void)
@@ -1184,11 +1437,11 @@ void thread_init_per_cpu(void)
 
 	thread_init_vbar(get_excp_vect());
 
-#ifdef CFG_FTRACE_SUPPORT
+#if defined(CFG_FTRACE_SUPPORT) || defined(CFG_CORE_TIME_PAGE)
 	/*
 	 * Enable accesses to frequency register and physical counter
 	 * register in EL0/PL0 required for timestamping during
-	 * function tracing.
+	 * function tracing and for reading time with the time page.
 	 */
 	write_cntkctl(read_cntkctl() | CNTKCTL_PL0PCTEN);
 #endif
@@ -1252,6 +1505,16 @@ uint32_t thread_kernel_enable_vfp(void)
 	struct thread_ctx *thr = threads + thread_get_id();
 	struct thread_user_vfp_state *tuv = thr->vfp_state.uvfp;
 
+	if (thr->vfp_state.kern_lingering) {
+		/*
+		 * The interrupted VFP state was saved by an earlier call
+		 * and the VFP is still enabled, nothing more to do.
+		 */
+		assert(vfp_is_enabled());
+		thr->vfp_state.kern_lingering = false;
+		return exceptions;
+	}
+
 	assert(!vfp_is_enabled());
 
 	if (!thr->vfp_state.ns_saved) {
@@ -1286,7 +1549,16 @@ void thread_kernel_disable_vfp(uint32_t state)
 
 	assert(vfp_is_enabled());
 
-	vfp_disable();
+	/*
+	 * Leave the VFP enabled when called from plain thread context so
+	 * that the next kernel VFP section doesn't have to save the
+	 * interrupted state again. In exception context the VFP is always
+	 * disabled since thread_kernel_restore_vfp() expects it that way.
+	 */
+	if (IS_ENABLED(CFG_CORE_LAZY_KERNEL_VFP) && thread_is_in_normal_mode())
+		threads[thread_get_id()].vfp_state.kern_lingering = true;
+	else
+		vfp_disable();
 	exceptions = thread_get_exceptions();
 	assert(exceptions & THREAD_EXCP_FOREIGN_INTR);
 	exceptions &= ~THREAD_EXCP_FOREIGN_INTR;
@@ -1299,6 +1571,7 @@ void thread_kernel_save_vfp(void)
 	struct thread_ctx *thr = threads + thread_get_id();
 
 	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	thread_release_kernel_vfp();
 	if (vfp_is_enabled()) {
 		vfp_lazy_save_state_init(&thr->vfp_state.sec);
 		thr->vfp_state.sec_lazy_saved = true;
@@ -1310,6 +1583,7 @@ void thread_kernel_restore_vfp(void)
 	struct thread_ctx *thr = threads + thread_get_id();
 
 	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	thread_release_kernel_vfp();
 	assert(!vfp_is_enabled());
 	if (thr->vfp_state.sec_lazy_saved) {
 		vfp_lazy_restore_state(&thr->vfp_state.sec,
@@ -1325,6 +1599,7 @@ void thread_user_enable_vfp(struct thread_user_vfp_state *uvfp)
 	struct thread_user_vfp_state *tuv = thr->vfp_state.uvfp;
 
 	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	thread_release_kernel_vfp();
 	assert(!vfp_is_enabled());
 
 	if (!thr->vfp_state.ns_saved) {
@@ -1464,6 +1739,8 @@ uint32_t thread_enter_user_mode(unsigned long a0, unsigned long a1,
 	}
 
 	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	/* Kernel VFP state must not leak into user mode */
+	thread_release_kernel_vfp();
 	/*
 	 * We're using the per thread location of saved context registers
 	 * for temporary storage. Now that exceptions are masked they will
@@ -1539,16 +1816,19 @@ static void gprof_set_status(struct ts_session *s __maybe_unused,
  */
 void __weak thread_svc_handler(struct thread_svc_regs *regs)
 {
-	struct ts_session *sess = NULL;
+	struct ts_session *sess = ts_get_current_session();
 	uint32_t state = 0;
 
+	if (sess->handle_svc == user_ta_handle_svc &&
+	    user_ta_handle_fast_svc(regs))
+		return;
+
 	/* Enable native interrupts */
 	state = thread_get_exceptions();
 	thread_unmask_exceptions(state & ~THREAD_EXCP_NATIVE_INTR);
 
 	thread_user_save_vfp();
 
-	sess = ts_get_current_session();
 	/*
 	 * User mode service has just entered kernel mode, suspend gprof
 	 * collection until we're about to switch back again.
@@ -1560,6 +1840,11 @@ void __weak thread_svc_handler(struct thread_svc_regs *regs)
 
 	assert(sess && sess->handle_svc);
 	if (sess->handle_svc(regs)) {
+		/* Kernel VFP state must not leak into user mode */
+		state = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+		thread_release_kernel_vfp();
+		thread_unmask_exceptions(state);
+
 		/* We're about to switch back to user mode */
 		gprof_set_status(sess, TS_GPROF_RESUME);
 	} else {
@@ -1582,6 +1867,9 @@ static struct mobj *alloc_shm(enum thread_shm_type shm_type, size_t size)
 	}
 }
 
+/* Buffers up to this size are allocated in power of two number of pages */
+#define SHM_CACHE_MAX_CLASS_SIZE	(16 * SMALL_PAGE_SIZE)
+
 static void clear_shm_cache_entry(struct thread_shm_cache_entry *ce)
 {
 	if (ce->mobj) {
@@ -1641,9 +1929,18 @@ void *thread_rpc_shm_cache_alloc(enum thread_shm_cache_user user,
 
 	/*
 	 * Always allocate in page chunks as normal world allocates payload
-	 * memory as complete pages.
+	 * memory as complete pages. Smaller buffers are rounded up to a
+	 * power of two number of pages so that a cache entry is reused
+	 * instead of reallocated when the requested size varies a bit.
 	 */
 	sz = ROUNDUP(size, SMALL_PAGE_SIZE);
+	if (sz <= SHM_CACHE_MAX_CLASS_SIZE) {
+		size_t class_sz = SMALL_PAGE_SIZE;
+
+		while (class_sz < sz)
+			class_sz *= 2;
+		sz = class_sz;
+	}
 
 	if (ce->type != shm_type || sz > ce->size) {
 		clear_shm_cache_entry(ce);
@@ -1690,6 +1987,45 @@ void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache)
 	}
 }
 
+void thread_rpc_shm_cache_clear_appl(struct thread_shm_cache *cache)
+{
+	struct thread_shm_cache_entry *ce = SLIST_FIRST(cache);
+	struct thread_shm_cache_entry *next = NULL;
+
+	while (ce) {
+		next = SLIST_NEXT(ce, link);
+		if (!ce->mobj || ce->type == THREAD_SHM_TYPE_APPLICATION) {
+			SLIST_REMOVE(cache, ce, thread_shm_cache_entry, link);
+			clear_shm_cache_entry(ce);
+			free(ce);
+		}
+		ce = next;
+	}
+}
+
+bool thread_rpc_shm_cache_pop(struct thread_shm_cache *cache,
+			      uint64_t *cookie)
+{
+	struct thread_shm_cache_entry *ce = NULL;
+
+	while (true) {
+		ce = SLIST_FIRST(cache);
+		if (!ce)
+			return false;
+		SLIST_REMOVE_HEAD(cache, link);
+		if (ce->mobj)
+			break;
+		free(ce);
+	}
+
+	assert(ce->type != THREAD_SHM_TYPE_APPLICATION);
+	*cookie = mobj_get_cookie(ce->mobj);
+	mobj_put(ce->mobj);
+	free(ce);
+
+	return true;
+}
+
 #ifdef CFG_WITH_ARM_TRUSTED_FW
 /*
  * These five functions are __weak to allow platforms to override them if
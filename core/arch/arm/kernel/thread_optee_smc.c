@@ -4,10 +4,14 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <compiler.h>
 #include <io.h>
+#include <kernel/invoke_stats.h>
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
+#include <kernel/pmu_profiler.h>
+#include <kernel/rpc_stats.h>
 #include <kernel/thread.h>
 #include <kernel/virtualization.h>
 #include <mm/core_mmu.h>
@@ -66,10 +70,13 @@ uint32_t thread_handle_std_smc(uint32_t a0, uint32_t a1, uint32_t a2,
 	 * on error. Successful return is done via thread_exit() or
 	 * thread_rpc().
 	 */
+	pmu_profiler_sync();
 	if (a0 == OPTEE_SMC_CALL_RETURN_FROM_RPC) {
-		thread_resume_from_rpc(a3, a1, a2, a4, a5);
+		thread_resume_from_rpc(a3 & OPTEE_SMC_RPC_THREAD_ID_MASK,
+				       a1, a2, a4, a5);
 		rv = OPTEE_SMC_RETURN_ERESUME;
 	} else {
+		bm_tracepoint(BENCH_TP_SMC_ENTRY);
 		thread_alloc_and_run(a0, a1, a2, a3);
 		rv = OPTEE_SMC_RETURN_ETHREAD_LIMIT;
 	}
@@ -207,6 +214,7 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 {
 	uint32_t rv = 0;
 
+	bm_tracepoint(BENCH_TP_THREAD_START);
 #ifdef CFG_VIRTUALIZATION
 	virt_on_stdcall();
 #endif
@@ -215,8 +223,10 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 	if (rv == OPTEE_SMC_RETURN_OK) {
 		struct thread_ctx *thr = threads + thread_get_id();
 
-		thread_rpc_shm_cache_clear(&thr->shm_cache);
-		if (!thread_prealloc_rpc_cache) {
+		if (thread_prealloc_rpc_cache) {
+			thread_rpc_shm_cache_clear_appl(&thr->shm_cache);
+		} else {
+			thread_rpc_shm_cache_clear(&thr->shm_cache);
 			thread_rpc_free_arg(mobj_get_cookie(thr->rpc_mobj));
 			mobj_put(thr->rpc_mobj);
 			thr->rpc_arg = 0;
@@ -234,6 +244,7 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
 
 	thread_lock_global();
+	thread_lock_all_pools();
 
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		if (threads[n].state != THREAD_STATE_FREE) {
@@ -250,11 +261,14 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 			threads[n].rpc_arg = NULL;
 			goto out;
 		}
+		if (thread_rpc_shm_cache_pop(&threads[n].shm_cache, cookie))
+			goto out;
 	}
 
 	*cookie = 0;
 	thread_prealloc_rpc_cache = false;
 out:
+	thread_unlock_all_pools();
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
 	return rv;
@@ -267,6 +281,7 @@ bool thread_enable_prealloc_rpc_cache(void)
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
 
 	thread_lock_global();
+	thread_lock_all_pools();
 
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		if (threads[n].state != THREAD_STATE_FREE) {
@@ -278,6 +293,7 @@ bool thread_enable_prealloc_rpc_cache(void)
 	rv = true;
 	thread_prealloc_rpc_cache = true;
 out:
+	thread_unlock_all_pools();
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
 	return rv;
@@ -477,6 +493,8 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 	void *arg = NULL;
 	uint64_t carg = 0;
 	uint32_t ret = 0;
+	uint64_t rpc_begin = 0;
+	uint64_t t = 0;
 
 	/* The source CRYPTO_RNG_SRC_JITTER_RPC is safe to use here */
 	plat_prng_add_jitter_entropy(CRYPTO_RNG_SRC_JITTER_RPC,
@@ -487,9 +505,17 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		return ret;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
+	rpc_begin = rpc_stats_begin();
+	t = invoke_stats_rpc_begin();
+	bm_tracepoint(BENCH_TP_RPC_OUT);
 	thread_rpc(rpc_args);
+	bm_tracepoint(BENCH_TP_RPC_IN);
+	invoke_stats_rpc_end(t);
+
+	ret = get_rpc_arg_res(arg, num_params, params);
+	rpc_stats_end(rpc_begin, cmd, num_params, params, ret);
 
-	return get_rpc_arg_res(arg, num_params, params);
+	return ret;
 }
 
 /**
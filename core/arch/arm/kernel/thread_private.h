@@ -36,6 +36,7 @@ struct thread_vfp_state {
 	bool ns_saved;
 	bool sec_saved;
 	bool sec_lazy_saved;
+	bool kern_lingering;
 	struct vfp_state ns;
 	struct vfp_state sec;
 	struct thread_user_vfp_state *uvfp;
@@ -192,6 +193,23 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
+/*
+ * Locks/unlocks the per-core pools of free threads. While all pools are
+ * locked no thread can change state from or to THREAD_STATE_FREE.
+ */
+#ifdef CFG_CORE_THREAD_POOL_PER_CORE
+void thread_lock_all_pools(void);
+void thread_unlock_all_pools(void);
+#else
+static inline void thread_lock_all_pools(void)
+{
+}
+
+static inline void thread_unlock_all_pools(void)
+{
+}
+#endif
+
 
 /*
  * Suspends current thread and temorarily exits to non-secure world.
@@ -243,5 +261,21 @@ void thread_svc_handler(struct thread_svc_regs *regs);
 
 /* Frees the cache of allocated FS RPC memory */
 void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
+
+/*
+ * Frees the entries of the cache of allocated RPC memory which must be
+ * freed by RPC before the thread returns to normal world. Kernel private
+ * and global memory can instead be freed by normal world when the cache
+ * is disabled, see thread_rpc_shm_cache_pop().
+ */
+void thread_rpc_shm_cache_clear_appl(struct thread_shm_cache *cache);
+
+/*
+ * Removes one entry from the cache of allocated RPC memory and returns
+ * true with the cookie of its buffer in @cookie, or returns false if the
+ * cache is empty. Normal world is expected to free the buffer.
+ */
+bool thread_rpc_shm_cache_pop(struct thread_shm_cache *cache,
+			      uint64_t *cookie);
 #endif /*__ASSEMBLER__*/
 #endif /*THREAD_PRIVATE_H*/
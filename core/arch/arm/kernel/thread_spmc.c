@@ -8,7 +8,10 @@
 #include <ffa.h>
 #include <io.h>
 #include <kernel/interrupt.h>
+#include <kernel/invoke_stats.h>
 #include <kernel/panic.h>
+#include <kernel/pmu_profiler.h>
+#include <kernel/rpc_stats.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_misc.h>
 #include <kernel/thread.h>
@@ -107,8 +110,23 @@ static unsigned int rxtx_size;
 static unsigned int rxtx_spinlock;
 static bool tx_buf_is_mine;
 
-static SLIST_HEAD(mem_frag_state_head, mem_frag_state) frag_state_head =
-	SLIST_HEAD_INITIALIZER(&frag_state_head);
+/* States of fragmented memory transactions in progress, hashed on handle */
+#define FRAG_STATE_NUM_BUCKETS	16
+
+SLIST_HEAD(mem_frag_state_head, mem_frag_state);
+
+static struct mem_frag_state_head frag_state_head[FRAG_STATE_NUM_BUCKETS];
+
+static struct mem_frag_state_head *frag_state_bucket(uint64_t global_handle)
+{
+	uint64_t h = global_handle;
+
+	h ^= h >> 32;
+	h ^= h >> 16;
+	h ^= h >> 8;
+
+	return frag_state_head + h % FRAG_STATE_NUM_BUCKETS;
+}
 
 static uint32_t swap_src_dst(uint32_t src_dst)
 {
@@ -370,6 +388,7 @@ static void handle_yielding_call(struct thread_smc_args *args)
 	uint32_t ret_val = 0;
 
 	thread_check_canaries();
+	pmu_profiler_sync();
 
 	if (args->a3 == OPTEE_FFA_YIELDING_CALL_RESUME) {
 		/* Note connection to struct thread_rpc_arg::ret */
@@ -485,6 +504,8 @@ static int add_mem_share_helper(struct mem_share_state *s, void *buf,
 	unsigned int region_count = flen /
 				    sizeof(struct constituent_address_range);
 	struct constituent_address_range *arange = NULL;
+	unsigned int run_count = 0;
+	uint64_t run_addr = 0;
 	unsigned int n = 0;
 
 	if (region_count > s->region_count)
@@ -494,14 +515,30 @@ static int add_mem_share_helper(struct mem_share_state *s, void *buf,
 		return FFA_INVALID_PARAMETERS;
 	arange = buf;
 
+	/*
+	 * Physically contiguous address ranges, as produced when a large
+	 * buffer is described page by page, are added as one run.
+	 */
 	for (n = 0; n < region_count; n++) {
 		unsigned int page_count = READ_ONCE(arange[n].page_count);
 		uint64_t addr = READ_ONCE(arange[n].address);
 
-		if (mobj_ffa_add_pages_at(s->mf, &s->current_page_idx,
-					  addr, page_count))
+		if (run_count &&
+		    addr == run_addr + (uint64_t)run_count * SMALL_PAGE_SIZE &&
+		    !ADD_OVERFLOW(run_count, page_count, &run_count))
+			continue;
+
+		if (run_count &&
+		    mobj_ffa_add_pages_at(s->mf, &s->current_page_idx,
+					  run_addr, run_count))
 			return FFA_INVALID_PARAMETERS;
+		run_addr = addr;
+		run_count = page_count;
 	}
+	if (run_count &&
+	    mobj_ffa_add_pages_at(s->mf, &s->current_page_idx, run_addr,
+				  run_count))
+		return FFA_INVALID_PARAMETERS;
 
 	s->region_count -= region_count;
 	if (s->region_count)
@@ -515,6 +552,7 @@ static int add_mem_share_helper(struct mem_share_state *s, void *buf,
 
 static int add_mem_share_frag(struct mem_frag_state *s, void *buf, size_t flen)
 {
+	struct mem_frag_state_head *head = NULL;
 	int rc = 0;
 
 	rc = add_mem_share_helper(&s->share, buf, flen);
@@ -529,7 +567,8 @@ static int add_mem_share_frag(struct mem_frag_state *s, void *buf, size_t flen)
 		}
 	}
 
-	SLIST_REMOVE(&frag_state_head, s, mem_frag_state, link);
+	head = frag_state_bucket(mobj_ffa_get_cookie(s->share.mf));
+	SLIST_REMOVE(head, s, mem_frag_state, link);
 	if (rc < 0)
 		mobj_ffa_sel1_spmc_delete(s->share.mf);
 	else
@@ -566,6 +605,7 @@ static int add_mem_share(tee_mm_entry_t *mm, void *buf, size_t blen,
 
 	if (flen != blen) {
 		struct mem_frag_state *s = calloc(sizeof(*s), 1);
+		struct mem_frag_state_head *head = NULL;
 
 		if (!s) {
 			rc = FFA_NO_MEMORY;
@@ -575,7 +615,8 @@ static int add_mem_share(tee_mm_entry_t *mm, void *buf, size_t blen,
 		s->mm = mm;
 		s->frag_offset = addr_range_offs;
 
-		SLIST_INSERT_HEAD(&frag_state_head, s, link);
+		head = frag_state_bucket(mobj_ffa_get_cookie(share.mf));
+		SLIST_INSERT_HEAD(head, s, link);
 		rc = add_mem_share_frag(s, (char *)buf + addr_range_offs,
 					flen - addr_range_offs);
 
@@ -696,9 +737,10 @@ static void handle_mem_share(struct thread_smc_args *args)
 		ret_fid = FFA_MEM_FRAG_RX;
 		ret_w3 = rc;
 		reg_pair_from_64(global_handle, &ret_w2, &ret_w1);
+	} else {
+		ret_fid = FFA_SUCCESS_32;
+		reg_pair_from_64(global_handle, &ret_w3, &ret_w2);
 	}
-	ret_fid = FFA_SUCCESS_32;
-	reg_pair_from_64(global_handle, &ret_w3, &ret_w2);
 out:
 	set_args(args, ret_fid, ret_w1, ret_w2, ret_w3, 0, 0);
 }
@@ -707,7 +749,7 @@ static struct mem_frag_state *get_frag_state(uint64_t global_handle)
 {
 	struct mem_frag_state *s = NULL;
 
-	SLIST_FOREACH(s, &frag_state_head, link)
+	SLIST_FOREACH(s, frag_state_bucket(global_handle), link)
 		if (mobj_ffa_get_cookie(s->share.mf) == global_handle)
 			return s;
 
@@ -748,7 +790,7 @@ static void handle_mem_frag_tx(struct thread_smc_args *args)
 			rc = FFA_INVALID_PARAMETERS;
 			goto out;
 		}
-		page_count = s->share.page_count;
+		page_count = tee_mm_get_bytes(mm) / SMALL_PAGE_SIZE;
 		buf = (void *)tee_mm_get_smem(mm);
 	} else {
 		if (flen > rxtx_size) {
@@ -782,6 +824,111 @@ out:
 	set_args(args, ret_fid, ret_w1, ret_w2, ret_w3, 0, 0);
 }
 
+/*
+ * Normal world reuses a few buffers for the struct optee_msg_arg of its
+ * yielding calls. The mobjs of the recent ones are kept referenced and
+ * mapped here, which saves the lookup of the cookie, the retrieve from
+ * the SPMC if any and the map and unmap of the buffer on each call. An
+ * entry is busy while a thread uses it and is dropped when its cookie is
+ * unregistered or reclaimed. There's at most one entry per cookie.
+ */
+struct arg_cache_entry {
+	uint64_t cookie;
+	struct mobj *mobj;
+	bool busy;
+};
+
+static struct arg_cache_entry arg_cache[CFG_CORE_FFA_ARG_CACHE_ENTRIES];
+static unsigned int arg_cache_lock = SPINLOCK_UNLOCK;
+
+static struct arg_cache_entry *arg_cache_get(uint64_t cookie)
+{
+	struct arg_cache_entry *entry = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&arg_cache_lock);
+	for (n = 0; n < ARRAY_SIZE(arg_cache); n++) {
+		if (arg_cache[n].mobj && arg_cache[n].cookie == cookie) {
+			if (!arg_cache[n].busy) {
+				arg_cache[n].busy = true;
+				entry = arg_cache + n;
+			}
+			break;
+		}
+	}
+	cpu_spin_unlock_xrestore(&arg_cache_lock, exceptions);
+
+	return entry;
+}
+
+/*
+ * Releases @entry if not NULL, else tries to keep the mapped @mobj of
+ * @cookie. Returns false if the caller still has to unmap and put @mobj.
+ */
+static bool arg_cache_put(struct arg_cache_entry *entry, uint64_t cookie,
+			  struct mobj *mobj)
+{
+	struct arg_cache_entry *free_entry = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&arg_cache_lock);
+	if (entry) {
+		entry->busy = false;
+		goto out;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(arg_cache); n++) {
+		if (!arg_cache[n].mobj) {
+			if (!free_entry)
+				free_entry = arg_cache + n;
+		} else if (arg_cache[n].cookie == cookie) {
+			/* Cached by another thread meanwhile */
+			free_entry = NULL;
+			break;
+		}
+	}
+	if (free_entry) {
+		free_entry->cookie = cookie;
+		free_entry->mobj = mobj;
+		free_entry->busy = false;
+		entry = free_entry;
+	}
+out:
+	cpu_spin_unlock_xrestore(&arg_cache_lock, exceptions);
+
+	return entry;
+}
+
+/*
+ * Drops the entry of @cookie unless a thread is using it, the unregister
+ * or reclaim of @cookie fails with busy then as it would without cache.
+ */
+static void arg_cache_drop(uint64_t cookie)
+{
+	struct mobj *mobj = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&arg_cache_lock);
+	for (n = 0; n < ARRAY_SIZE(arg_cache); n++) {
+		if (arg_cache[n].mobj && arg_cache[n].cookie == cookie) {
+			if (!arg_cache[n].busy) {
+				mobj = arg_cache[n].mobj;
+				arg_cache[n].mobj = NULL;
+			}
+			break;
+		}
+	}
+	cpu_spin_unlock_xrestore(&arg_cache_lock, exceptions);
+
+	if (mobj) {
+		mobj_dec_map(mobj);
+		mobj_put(mobj);
+	}
+}
+
 static void handle_mem_reclaim(struct thread_smc_args *args)
 {
 	uint32_t ret_val = FFA_INVALID_PARAMETERS;
@@ -792,6 +939,7 @@ static void handle_mem_reclaim(struct thread_smc_args *args)
 		goto out;
 
 	cookie = reg_pair_to_64(args->a2, args->a1);
+	arg_cache_drop(cookie);
 	switch (mobj_ffa_sel1_spmc_reclaim(cookie)) {
 	case TEE_SUCCESS:
 		ret_fid = FFA_SUCCESS_32;
@@ -869,10 +1017,17 @@ void thread_spmc_msg_recv(struct thread_smc_args *args)
 static uint32_t yielding_call_with_arg(uint64_t cookie)
 {
 	uint32_t rv = TEE_ERROR_BAD_PARAMETERS;
+	struct arg_cache_entry *entry = NULL;
 	struct optee_msg_arg *arg = NULL;
 	struct mobj *mobj = NULL;
 	uint32_t num_params = 0;
 
+	entry = arg_cache_get(cookie);
+	if (entry) {
+		mobj = entry->mobj;
+		goto use_arg;
+	}
+
 	mobj = mobj_ffa_get_by_cookie(cookie, 0);
 	if (!mobj) {
 		EMSG("Can't find cookie %#"PRIx64, cookie);
@@ -883,6 +1038,7 @@ static uint32_t yielding_call_with_arg(uint64_t cookie)
 	if (rv)
 		goto out_put_mobj;
 
+use_arg:
 	rv = TEE_ERROR_BAD_PARAMETERS;
 	arg = mobj_get_va(mobj, 0);
 	if (!arg)
@@ -903,6 +1059,8 @@ static uint32_t yielding_call_with_arg(uint64_t cookie)
 	thread_rpc_shm_cache_clear(&threads[thread_get_id()].shm_cache);
 
 out_dec_map:
+	if (arg_cache_put(entry, cookie, mobj))
+		return rv;
 	mobj_dec_map(mobj);
 out_put_mobj:
 	mobj_put(mobj);
@@ -911,8 +1069,10 @@ out_put_mobj:
 
 static uint32_t yielding_unregister_shm(uint64_t cookie)
 {
-	uint32_t res = mobj_ffa_unregister_by_cookie(cookie);
+	uint32_t res = 0;
 
+	arg_cache_drop(cookie);
+	res = mobj_ffa_unregister_by_cookie(cookie);
 	switch (res) {
 	case TEE_SUCCESS:
 	case TEE_ERROR_ITEM_NOT_FOUND:
@@ -1159,15 +1319,23 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 	uint64_t carg = 0;
 	struct optee_msg_arg *arg = NULL;
 	uint32_t ret = 0;
+	uint64_t rpc_begin = 0;
+	uint64_t t = 0;
 
 	ret = get_rpc_arg(cmd, num_params, params, &arg, &carg);
 	if (ret)
 		return ret;
 
 	reg_pair_from_64(carg, &rpc_arg.call.w6, &rpc_arg.call.w5);
+	rpc_begin = rpc_stats_begin();
+	t = invoke_stats_rpc_begin();
 	thread_rpc(&rpc_arg);
+	invoke_stats_rpc_end(t);
+
+	ret = get_rpc_arg_res(arg, num_params, params);
+	rpc_stats_end(rpc_begin, cmd, num_params, params, ret);
 
-	return get_rpc_arg_res(arg, num_params, params);
+	return ret;
 }
 
 struct mobj *thread_rpc_alloc_global_payload(size_t size __unused)
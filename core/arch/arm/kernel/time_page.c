@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <config.h>
+#include <initcall.h>
+#include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <kernel/time_page.h>
+#include <mm/core_memprot.h>
+#include <mm/mobj.h>
+#include <mm/tee_mm.h>
+#include <mm/vm.h>
+#include <string.h>
+#include <utee_types.h>
+#include <util.h>
+
+static struct utee_time_page *time_page;
+static struct mobj *time_page_mobj;
+static unsigned int time_page_lock = SPINLOCK_UNLOCK;
+
+/*
+ * Readers in user mode retry while utee_time_page::seq is odd or has
+ * changed while they read the page.
+ */
+static uint32_t update_begin(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&time_page_lock);
+
+	time_page->seq++;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return exceptions;
+}
+
+static void update_end(uint32_t exceptions)
+{
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	time_page->seq++;
+
+	cpu_spin_unlock_xrestore(&time_page_lock, exceptions);
+}
+
+void time_page_set_ree_time(const TEE_Time *time)
+{
+	uint64_t cnt = barrier_read_cntpct();
+	uint32_t exceptions = 0;
+
+	if (!time_page)
+		return;
+
+	exceptions = update_begin();
+	time_page->ree_cnt = cnt;
+	time_page->ree_valid_cnt = cnt + time_page->cnt_freq *
+					 CFG_CORE_TIME_PAGE_REE_MS / 1000;
+	time_page->ree_seconds = time->seconds;
+	time_page->ree_millis = time->millis;
+	time_page->flags |= UTEE_TIME_PAGE_REE_TIME;
+	update_end(exceptions);
+}
+
+TEE_Result time_page_map(struct user_mode_ctx *uctx, vaddr_t *va)
+{
+	struct vm_region *r = NULL;
+
+	if (!time_page_mobj)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
+		if (r->mobj == time_page_mobj) {
+			*va = r->va;
+			return TEE_SUCCESS;
+		}
+	}
+
+	*va = 0;
+	return vm_map(uctx, va, SMALL_PAGE_SIZE, TEE_MATTR_UR | TEE_MATTR_PR,
+		      VM_FLAG_PERMANENT | VM_FLAG_READONLY, time_page_mobj, 0);
+}
+
+static TEE_Result time_page_init(void)
+{
+	tee_mm_entry_t *mm = tee_mm_alloc(&tee_mm_sec_ddr, SMALL_PAGE_SIZE);
+	paddr_t pa = 0;
+
+	if (!mm)
+		panic("Failed to allocate time page");
+
+	pa = tee_mm_get_smem(mm);
+	time_page_mobj = mobj_phys_alloc(pa, SMALL_PAGE_SIZE,
+					 TEE_MATTR_CACHE_CACHED,
+					 CORE_MEM_TA_RAM);
+	if (!time_page_mobj)
+		panic("Failed to register time page");
+
+	time_page = phys_to_virt(pa, MEM_AREA_TA_RAM);
+	memset(time_page, 0, SMALL_PAGE_SIZE);
+	time_page->cnt_freq = read_cntfrq();
+	/* Only if the system time of the core is derived from the counter */
+	if (IS_ENABLED(CFG_SECURE_TIME_SOURCE_CNTPCT))
+		time_page->flags = UTEE_TIME_PAGE_SYS_TIME;
+
+	return TEE_SUCCESS;
+}
+service_init(time_page_init);
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <kernel/interrupt.h>
+#include <kernel/misc.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/time_slice.h>
+#include <util.h>
+
+/*
+ * The secure physical timer of a core is armed while a thread executes a
+ * TA on it. When the timer fires while the core executes user mode code
+ * the thread is suspended by the native interrupt handler on its way back
+ * to user mode, see native_intr_handler in thread_a64.S. If the timer
+ * fires while the core executes TEE core code on behalf of the TA it's
+ * re-armed with a short delay instead: there's no safe point to suspend
+ * the thread before it returns to user mode.
+ */
+
+#define CNTPS_CTL_ENABLE	BIT32(0)
+#define CNTPS_CTL_ISTATUS	BIT32(2)
+
+#define RETRY_MS		1
+
+/* Number of nested TA invocations of each thread */
+static unsigned int slice_depth[CFG_NUM_THREADS];
+static bool it_enabled[CFG_TEE_CORE_NB_CORE];
+static bool itr_added;
+static unsigned int itr_lock = SPINLOCK_UNLOCK;
+
+static void arm_timer(uint32_t ms)
+{
+	write_cntps_ctl(0);
+	write_cntps_tval((read_cntfrq() / 1000) * ms);
+	write_cntps_ctl(CNTPS_CTL_ENABLE);
+}
+
+static bool is_from_user_mode(uint64_t spsr)
+{
+	return (spsr & (SPSR_MODE_RW_32 << SPSR_MODE_RW_SHIFT)) ||
+	       ((spsr >> SPSR_64_MODE_EL_SHIFT) & SPSR_64_MODE_EL_MASK) ==
+	       SPSR_64_MODE_EL0;
+}
+
+static enum itr_return time_slice_it_handler(struct itr_handler *h __unused)
+{
+	struct thread_core_local *l = thread_get_core_local();
+
+	if (!(read_cntps_ctl() & CNTPS_CTL_ISTATUS))
+		return ITRR_NONE;
+
+	write_cntps_ctl(0);
+
+	if (l->curr_thread < 0 || !slice_depth[l->curr_thread])
+		return ITRR_HANDLED;
+
+	if (is_from_user_mode(read_spsr_el1()))
+		l->time_slice_yield = true;
+	else
+		arm_timer(RETRY_MS);
+
+	return ITRR_HANDLED;
+}
+
+static struct itr_handler time_slice_itr = {
+	.it = CFG_CORE_TIME_SLICE_IT,
+	.flags = ITRF_TRIGGER_LEVEL,
+	.handler = time_slice_it_handler,
+};
+
+static void enable_it_this_cpu(void)
+{
+	size_t pos = get_core_pos();
+
+	if (it_enabled[pos])
+		return;
+
+	cpu_spin_lock(&itr_lock);
+	if (!itr_added) {
+		itr_add(&time_slice_itr);
+		itr_added = true;
+	}
+	cpu_spin_unlock(&itr_lock);
+
+	itr_add_this_cpu(time_slice_itr.it, time_slice_itr.flags);
+	itr_enable(time_slice_itr.it);
+	it_enabled[pos] = true;
+}
+
+void time_slice_start(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	short int ct = thread_get_id();
+
+	enable_it_this_cpu();
+	slice_depth[ct]++;
+	arm_timer(CFG_CORE_TIME_SLICE_MS);
+
+	thread_unmask_exceptions(exceptions);
+}
+
+void time_slice_stop(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	short int ct = thread_get_id();
+
+	assert(slice_depth[ct]);
+	slice_depth[ct]--;
+	if (slice_depth[ct])
+		arm_timer(CFG_CORE_TIME_SLICE_MS);
+	else
+		write_cntps_ctl(0);
+	thread_get_core_local()->time_slice_yield = false;
+
+	thread_unmask_exceptions(exceptions);
+}
+
+void time_slice_resume(short int thread_id)
+{
+	assert(thread_get_exceptions() == THREAD_EXCP_ALL);
+
+	thread_get_core_local()->time_slice_yield = false;
+	if (!slice_depth[thread_id])
+		return;
+
+	enable_it_this_cpu();
+	arm_timer(CFG_CORE_TIME_SLICE_MS);
+}
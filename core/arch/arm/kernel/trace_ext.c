@@ -3,11 +3,15 @@
  * Copyright (c) 2014, Linaro Limited
  */
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <trace.h>
 #include <console.h>
+#include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <mm/core_mmu.h>
+#include <util.h>
 
 const char trace_ext_prefix[] = "TC";
 int trace_level __nex_data = TRACE_LEVEL;
@@ -17,9 +21,8 @@ void __weak plat_trace_ext_puts(const char *str __unused)
 {
 }
 
-void trace_ext_puts(const char *str)
+static void console_puts(const char *str, bool mark_contended)
 {
-	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
 	bool mmu_enabled = cpu_mmu_enabled();
 	bool was_contended = false;
 	const char *p;
@@ -33,7 +36,7 @@ void trace_ext_puts(const char *str)
 
 	console_flush();
 
-	if (was_contended)
+	if (was_contended && mark_contended)
 		console_putc('*');
 
 	for (p = str; *p; p++)
@@ -43,6 +46,83 @@ void trace_ext_puts(const char *str)
 
 	if (mmu_enabled)
 		cpu_spin_unlock(&puts_lock);
+}
+
+#ifdef CFG_CORE_DEFERRED_CONSOLE
+/*
+ * Messages logged by secure threads are copied into a ring of the current
+ * core and written to the console when the thread returns to normal world.
+ * A ring is only accessed by its core with all exceptions masked, so no
+ * lock is needed.
+ */
+struct trace_ring {
+	size_t head;
+	size_t tail;
+	unsigned int dropped;
+	char buf[CFG_CORE_DEFERRED_CONSOLE_SIZE];
+};
+
+static struct trace_ring trace_rings[CFG_TEE_CORE_NB_CORE] __nex_bss;
+
+static bool ring_puts(const char *str)
+{
+	struct trace_ring *r = trace_rings + get_core_pos();
+	size_t len = strlen(str);
+	size_t n = 0;
+
+	if (!cpu_mmu_enabled() || thread_get_id_may_fail() < 0)
+		return false;
+
+	if (len > sizeof(r->buf) - (r->head - r->tail)) {
+		r->dropped++;
+		return true;
+	}
+
+	for (n = 0; n < len; n++)
+		r->buf[(r->head + n) % sizeof(r->buf)] = str[n];
+	r->head += len;
+
+	return true;
+}
+
+void console_drain_deferred(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct trace_ring *r = trace_rings + get_core_pos();
+	char chunk[64] = { };
+	size_t n = 0;
+
+	while (r->tail != r->head) {
+		for (n = 0; n < sizeof(chunk) - 1 && r->tail != r->head; n++) {
+			chunk[n] = r->buf[r->tail % sizeof(r->buf)];
+			r->tail++;
+		}
+		chunk[n] = '\0';
+		console_puts(chunk, false);
+	}
+
+	if (r->dropped) {
+		snprintf(chunk, sizeof(chunk), "*** %u messages dropped\n",
+			 r->dropped);
+		r->dropped = 0;
+		console_puts(chunk, false);
+	}
+
+	thread_unmask_exceptions(exceptions);
+}
+#else
+static bool ring_puts(const char *str __unused)
+{
+	return false;
+}
+#endif
+
+void trace_ext_puts(const char *str)
+{
+	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	if (!ring_puts(str))
+		console_puts(str, true);
 
 	thread_unmask_exceptions(itr_status);
 }
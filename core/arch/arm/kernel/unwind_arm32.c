@@ -34,10 +34,11 @@
 #include <kernel/linker.h>
 #include <kernel/thread.h>
 #include <kernel/unwind.h>
+#include <malloc.h>
+#include <string.h>
 #include <trace.h>
 #include <unw/unwind.h>
-
-#include "unwind_private.h"
+#include <util.h>
 
 /* The register names */
 #define	FP	11
@@ -52,20 +53,19 @@ bool find_exidx(vaddr_t addr __unused, vaddr_t *idx_start, vaddr_t *idx_end)
 	return true;
 }
 
-vaddr_t *unw_get_kernel_stack(void)
+/*
+ * Inlined so that the registers read are the ones of the caller of
+ * unw_get_kernel_stack() or unw_get_kernel_stack_buf(). @pc is an address
+ * well inside that caller: 2 is subtracted from the PC when calling
+ * find_index(), see the comment there for more details.
+ */
+static __always_inline size_t get_kernel_stack(vaddr_t *buf, size_t count,
+					       uint32_t pc)
 {
-	size_t n = 0;
-	size_t size = 0;
-	size_t exidx_sz = 0;
-	vaddr_t *tmp = NULL;
-	vaddr_t *addr = NULL;
 	struct unwind_state_arm32 state = { };
 	vaddr_t stack = thread_stack_start();
 	size_t stack_size = thread_stack_size();
-
-	if (SUB_OVERFLOW((vaddr_t)__exidx_end, (vaddr_t)__exidx_start,
-			 &exidx_sz))
-		return NULL;
+	size_t n = 0;
 
 	/* r7: Thumb-style frame pointer */
 	state.registers[7] = read_r7();
@@ -73,35 +73,39 @@ vaddr_t *unw_get_kernel_stack(void)
 	state.registers[FP] = read_fp();
 	state.registers[SP] = read_sp();
 	state.registers[LR] = read_lr();
+	state.registers[PC] = pc;
 
-	/*
-	 * Add 4 to make sure that we have an address well inside this function.
-	 * This is needed because we're subtracting 2 from PC when calling
-	 * find_index() above. See a comment there for more details.
-	 */
-	state.registers[PC] = (uint32_t)unw_get_kernel_stack + 4;
-
-	while (unwind_stack_arm32(&state, stack, stack_size)) {
-		tmp = unw_grow(addr, &size, (n + 1) * sizeof(vaddr_t));
-		if (!tmp)
-			goto err;
-		addr = tmp;
-		addr[n] = state.registers[PC];
-		n++;
-	}
+	while (n < count && unwind_stack_arm32(&state, stack, stack_size))
+		buf[n++] = state.registers[PC];
+
+	return n;
+}
 
-	if (addr) {
-		tmp = unw_grow(addr, &size, (n + 1) * sizeof(vaddr_t));
-		if (!tmp)
-			goto err;
-		addr = tmp;
-		addr[n] = 0;
+size_t unw_get_kernel_stack_buf(vaddr_t *buf, size_t count)
+{
+	return get_kernel_stack(buf, count,
+				(uint32_t)unw_get_kernel_stack_buf + 4);
+}
+
+vaddr_t *unw_get_kernel_stack(void)
+{
+	vaddr_t buf[UNW_KERNEL_STACK_MAX_DEPTH] = { };
+	vaddr_t *addr = NULL;
+	size_t n = get_kernel_stack(buf, ARRAY_SIZE(buf),
+				    (uint32_t)unw_get_kernel_stack + 4);
+
+	if (!n)
+		return NULL;
+
+	addr = malloc((n + 1) * sizeof(vaddr_t));
+	if (!addr) {
+		EMSG("Out of memory");
+		return NULL;
 	}
+	memcpy(addr, buf, n * sizeof(vaddr_t));
+	addr[n] = 0;
 
 	return addr;
-err:
-	EMSG("Out of memory");
-	return NULL;
 }
 
 #if (TRACE_LEVEL > 0)
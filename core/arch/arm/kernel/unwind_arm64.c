@@ -33,45 +33,55 @@
 #include <kernel/linker.h>
 #include <kernel/thread.h>
 #include <kernel/unwind.h>
+#include <malloc.h>
+#include <string.h>
 #include <unw/unwind.h>
+#include <util.h>
 
-#include "unwind_private.h"
-
-vaddr_t *unw_get_kernel_stack(void)
+/*
+ * Inlined so that the frame pointer read is the one of the caller of
+ * unw_get_kernel_stack() or unw_get_kernel_stack_buf(), the frame records
+ * are then followed without any table lookup.
+ */
+static __always_inline size_t get_kernel_stack(vaddr_t *buf, size_t count)
 {
-	size_t n = 0;
-	size_t size = 0;
-	vaddr_t *tmp = NULL;
-	vaddr_t *addr = NULL;
 	uaddr_t stack = thread_stack_start();
 	size_t stack_size = thread_stack_size();
 	struct unwind_state_arm64 state = {
 		.pc = read_pc(),
 		.fp = read_fp()
 	};
+	size_t n = 0;
 
-	while (unwind_stack_arm64(&state, stack, stack_size)) {
-		tmp = unw_grow(addr, &size, (n + 1) * sizeof(vaddr_t));
-		if (!tmp)
-			goto err;
-		addr = tmp;
-		addr[n] = state.pc;
-		n++;
-	}
+	while (n < count && unwind_stack_arm64(&state, stack, stack_size))
+		buf[n++] = state.pc;
+
+	return n;
+}
+
+size_t unw_get_kernel_stack_buf(vaddr_t *buf, size_t count)
+{
+	return get_kernel_stack(buf, count);
+}
+
+vaddr_t *unw_get_kernel_stack(void)
+{
+	vaddr_t buf[UNW_KERNEL_STACK_MAX_DEPTH] = { };
+	vaddr_t *addr = NULL;
+	size_t n = get_kernel_stack(buf, ARRAY_SIZE(buf));
+
+	if (!n)
+		return NULL;
 
-	if (addr) {
-		tmp = unw_grow(addr, &size, (n + 1) * sizeof(vaddr_t));
-		if (!tmp)
-			goto err;
-		addr = tmp;
-		addr[n] = 0;
+	addr = malloc((n + 1) * sizeof(vaddr_t));
+	if (!addr) {
+		EMSG("Out of memory");
+		return NULL;
 	}
+	memcpy(addr, buf, n * sizeof(vaddr_t));
+	addr[n] = 0;
 
 	return addr;
-err:
-	EMSG("Out of memory");
-	free(addr);
-	return NULL;
 }
 
 void print_kernel_stack(void)
@@ -6,6 +6,7 @@
  */
 
 #include <assert.h>
+#include <bench.h>
 #include <compiler.h>
 #include <crypto/crypto.h>
 #include <ctype.h>
@@ -17,6 +18,7 @@
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
+#include <kernel/time_slice.h>
 #include <kernel/ts_store.h>
 #include <kernel/user_access.h>
 #include <kernel/user_mode_ctx.h>
@@ -39,6 +41,7 @@
 #include <ta_pub_key.h>
 #include <tee/arch_svc.h>
 #include <tee/tee_cryp_utl.h>
+#include <tee/tee_fs_key_manager.h>
 #include <tee/tee_obj.h>
 #include <tee/tee_svc_cryp.h>
 #include <tee/tee_svc.h>
@@ -146,9 +149,11 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	}
 	if (ta_sess->param) {
 		/* Map user space memory */
-		res = vm_map_param(&utc->uctx, ta_sess->param, param_va);
+		res = vm_map_param(&utc->uctx, ta_sess->param, param_va,
+				   utc->ta_ctx.flags & TA_FLAG_LAZY_PARAM_MAP);
 		if (res != TEE_SUCCESS)
 			goto out;
+		bm_tracepoint(BENCH_TP_PARAM_MAP);
 	}
 
 	/* Switch to user ctx */
@@ -163,11 +168,13 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	else
 		memset(usr_params, 0, sizeof(*usr_params));
 
+	time_slice_start();
 	res = thread_enter_user_mode(func, kaddr_to_uref(session),
 				     (vaddr_t)usr_params, cmd, usr_stack,
 				     utc->uctx.entry_func, utc->uctx.is_32bit,
 				     &utc->ta_ctx.panicked,
 				     &utc->ta_ctx.panic_code);
+	time_slice_stop();
 
 	thread_user_clear_vfp(&utc->uctx);
 
@@ -185,14 +192,19 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	}
 
 	if (ta_sess->param) {
-		/* Copy out value results */
-		update_from_utee_param(ta_sess->param, usr_params);
+		/*
+		 * Copy out value results, the parameters of a panicked TA
+		 * are left untouched since they can't be trusted.
+		 */
+		if (!utc->ta_ctx.panicked)
+			update_from_utee_param(ta_sess->param, usr_params);
 
 		/*
 		 * Clear out the parameter mappings added with
 		 * vm_clean_param() above.
 		 */
 		vm_clean_param(&utc->uctx);
+		bm_tracepoint(BENCH_TP_PARAM_UNMAP);
 	}
 
 
@@ -357,6 +369,7 @@ static void free_utc(struct user_ta_ctx *utc)
 	tee_obj_close_all(utc);
 	/* Free emums created by this TA */
 	tee_svc_storage_close_all_enum(utc);
+	tee_fs_key_cache_flush(&utc->ta_ctx.ts_ctx.uuid);
 	free(utc);
 }
 
@@ -461,7 +474,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	 * until this context is fully initialized. This is needed to
 	 * handle single instance TAs.
 	 */
-	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ta_ctx, link);
+	tee_ta_register_ctx(&utc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	/*
@@ -482,7 +495,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 		utc->uctx.is_initializing = false;
 	} else {
 		s->ts_sess.ctx = NULL;
-		TAILQ_REMOVE(&tee_ctxes, &utc->ta_ctx, link);
+		tee_ta_unregister_ctx(&utc->ta_ctx);
 	}
 
 	/* The state has changed for the context, notify eventual waiters. */
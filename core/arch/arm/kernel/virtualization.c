@@ -21,8 +21,14 @@
 
 static unsigned int prtn_list_lock __nex_data = SPINLOCK_UNLOCK;
 
-static LIST_HEAD(prtn_list_head, guest_partition) prtn_list __nex_data =
-	LIST_HEAD_INITIALIZER(prtn_list_head);
+/*
+ * Guest partitions are looked up on each standard call so they are kept
+ * in a hash table indexed by guest ID.
+ */
+#define PRTN_HASH_SIZE	16
+
+static LIST_HEAD(prtn_list_head, guest_partition) prtn_hash[PRTN_HASH_SIZE]
+	__nex_bss;
 
 /* Free pages used for guest partitions */
 tee_mm_pool_t virt_mapper_pool __nex_bss;
@@ -67,6 +73,23 @@ static void set_current_prtn(struct guest_partition *prtn)
 	thread_unmask_exceptions(exceptions);
 }
 
+static struct prtn_list_head *prtn_head(uint16_t guest_id)
+{
+	return prtn_hash + guest_id % PRTN_HASH_SIZE;
+}
+
+/* Called with prtn_list_lock held */
+static struct guest_partition *find_prtn(uint16_t guest_id)
+{
+	struct guest_partition *prtn = NULL;
+
+	LIST_FOREACH(prtn, prtn_head(guest_id), link)
+		if (prtn->id == guest_id)
+			return prtn;
+
+	return NULL;
+}
+
 static size_t get_ta_ram_size(void)
 {
 	return TA_RAM_SIZE / CFG_VIRT_GUEST_COUNT -
@@ -75,7 +98,8 @@ static size_t get_ta_ram_size(void)
 }
 
 static struct tee_mmap_region *prepare_memory_map(paddr_t tee_data,
-						  paddr_t ta_ram)
+						  paddr_t ta_ram,
+						  size_t ta_ram_size)
 {
 	int i, entries;
 	vaddr_t max_va = 0;
@@ -120,7 +144,7 @@ static struct tee_mmap_region *prepare_memory_map(paddr_t tee_data,
 	map[entries - 1].va +=
 		(ta_ram - map[entries - 1].va) & CORE_MMU_PGDIR_MASK;
 	map[entries - 1].pa = ta_ram;
-	map[entries - 1].size = get_ta_ram_size();
+	map[entries - 1].size = ta_ram_size;
 	map[entries - 1].type = MEM_AREA_TA_RAM;
 	map[entries - 1].attr = core_mmu_type_to_attr(map[entries - 1].type);
 
@@ -168,7 +192,8 @@ void virt_init_memory(struct tee_mmap_region *memory_map)
 }
 
 
-static int configure_guest_prtn_mem(struct guest_partition *prtn)
+static int configure_guest_prtn_mem(struct guest_partition *prtn,
+				    size_t ta_ram_size)
 {
 	int ret;
 	paddr_t original_data_pa;
@@ -181,7 +206,7 @@ static int configure_guest_prtn_mem(struct guest_partition *prtn)
 	}
 	DMSG("TEE RAM: %08" PRIxPA, tee_mm_get_smem(prtn->tee_ram));
 
-	prtn->ta_ram = tee_mm_alloc(&virt_mapper_pool, get_ta_ram_size());
+	prtn->ta_ram = tee_mm_alloc(&virt_mapper_pool, ta_ram_size);
 	if (!prtn->ta_ram) {
 		EMSG("Can't allocate memory for TA data");
 		ret = TEE_ERROR_OUT_OF_MEMORY;
@@ -208,7 +233,8 @@ static int configure_guest_prtn_mem(struct guest_partition *prtn)
 	}
 
 	prtn->memory_map = prepare_memory_map(tee_mm_get_smem(prtn->tee_ram),
-					     tee_mm_get_smem(prtn->ta_ram));
+					     tee_mm_get_smem(prtn->ta_ram),
+					     ta_ram_size);
 	if (!prtn->memory_map) {
 		ret = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
@@ -243,11 +269,24 @@ err:
 	return ret;
 }
 
-uint32_t virt_guest_created(uint16_t guest_id)
+uint32_t virt_guest_created(uint16_t guest_id, size_t ta_ram_size)
 {
 	struct guest_partition *prtn;
 	uint32_t exceptions;
 
+	if (!ta_ram_size)
+		ta_ram_size = get_ta_ram_size();
+	else if (ROUNDUP_OVERFLOW(ta_ram_size, SMALL_PAGE_SIZE, &ta_ram_size))
+		return OPTEE_SMC_RETURN_ENOTAVAIL;
+
+	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
+	prtn = find_prtn(guest_id);
+	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
+	if (prtn) {
+		EMSG("Guest %d already exists", guest_id);
+		return OPTEE_SMC_RETURN_ENOTAVAIL;
+	}
+
 	prtn = nex_calloc(1, sizeof(*prtn));
 	if (!prtn)
 		return OPTEE_SMC_RETURN_ENOTAVAIL;
@@ -255,7 +294,7 @@ uint32_t virt_guest_created(uint16_t guest_id)
 	prtn->id = guest_id;
 	mutex_init(&prtn->mutex);
 	refcount_set(&prtn->refc, 1);
-	if (configure_guest_prtn_mem(prtn)) {
+	if (configure_guest_prtn_mem(prtn, ta_ram_size)) {
 		nex_free(prtn);
 		return OPTEE_SMC_RETURN_ENOTAVAIL;
 	}
@@ -266,7 +305,7 @@ uint32_t virt_guest_created(uint16_t guest_id)
 	thread_init_threads();
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_INSERT_HEAD(&prtn_list, prtn, link);
+	LIST_INSERT_HEAD(prtn_head(guest_id), prtn, link);
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
 	IMSG("Added guest %d", guest_id);
@@ -284,13 +323,9 @@ uint32_t virt_guest_destroyed(uint16_t guest_id)
 	IMSG("Removing guest %d", guest_id);
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			LIST_REMOVE(prtn, link);
-			break;
-		}
-	}
+	prtn = find_prtn(guest_id);
+	if (prtn)
+		LIST_REMOVE(prtn, link);
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
 	if (prtn) {
@@ -327,19 +362,15 @@ bool virt_set_guest(uint16_t guest_id)
 		panic("Virtual guest partition is already set");
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			set_current_prtn(prtn);
-			core_mmu_set_prtn(prtn->mmu_prtn);
-			refcount_inc(&prtn->refc);
-			cpu_spin_unlock_xrestore(&prtn_list_lock,
-						 exceptions);
-			return true;
-		}
+	prtn = find_prtn(guest_id);
+	if (prtn) {
+		set_current_prtn(prtn);
+		core_mmu_set_prtn(prtn->mmu_prtn);
+		refcount_inc(&prtn->refc);
 	}
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
-	return guest_id == HYP_CLNT_ID;
+	return prtn || guest_id == HYP_CLNT_ID;
 }
 
 void virt_unset_guest(void)
@@ -3,6 +3,9 @@
  * Copyright (c) 2015-2016, Linaro Limited
  */
 #include <compiler.h>
+#include <config.h>
+#include <kernel/delay.h>
+#include <kernel/notif.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <kernel/wait_queue.h>
@@ -37,9 +40,11 @@ void __weak __wq_rpc(uint32_t func, int id, const void *sync_obj __maybe_unused,
 	else
 		DMSG("%s thread %u %p", cmd_str, id, sync_obj);
 
-	struct thread_param params = THREAD_PARAM_VALUE(IN, func, id, 0);
-
-	ret = thread_rpc_cmd(OPTEE_RPC_CMD_WAIT_QUEUE, 1, &params);
+	/* A wakeup doesn't need an RPC with asynchronous notifications */
+	if (func == OPTEE_RPC_WAIT_QUEUE_SLEEP)
+		ret = notif_wait(id);
+	else
+		ret = notif_send(id);
 	if (ret != TEE_SUCCESS)
 		DMSG("%s thread %u ret 0x%x", cmd_str, id, ret);
 }
@@ -65,6 +70,7 @@ void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
 
 	wqe->handle = thread_get_id();
 	wqe->done = false;
+	wqe->sleeping = false;
 	wqe->wait_read = wait_read;
 	wqe->cv = cv;
 
@@ -75,24 +81,73 @@ void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
 	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
 }
 
+#if CFG_WAIT_QUEUE_SPIN_US
+/*
+ * Waits in secure world for at most CFG_WAIT_QUEUE_SPIN_US to be woken up
+ * before going to sleep in normal world. A waker finding the element done
+ * before it's sleeping doesn't do the wakeup RPC.
+ */
+static void spin_for_wakeup(struct wait_queue_elem *wqe)
+{
+	volatile bool *done = &wqe->done;
+	uint64_t timeout = timeout_init_us(CFG_WAIT_QUEUE_SPIN_US);
+
+	while (!*done && !timeout_elapsed(timeout))
+		;
+}
+#else
+static void spin_for_wakeup(struct wait_queue_elem *wqe __unused)
+{
+}
+#endif
+
 void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 		   const void *sync_obj, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
 	unsigned done;
 
-	do {
-		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_SLEEP, wqe->handle,
-			 sync_obj, fname, lineno);
+	spin_for_wakeup(wqe);
 
+	while (true) {
 		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 
 		done = wqe->done;
 		if (done)
 			SLIST_REMOVE(wq, wqe, wait_queue_elem, link);
+		else
+			wqe->sleeping = true;
 
 		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
-	} while (!done);
+
+		if (done)
+			break;
+
+		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_SLEEP, wqe->handle,
+			 sync_obj, fname, lineno);
+	}
+}
+
+/*
+ * Returns true if the readers are to be woken as the next batch, false if
+ * it's the first writer. Called with wq_spin_lock held.
+ */
+static bool next_wake_read(struct wait_queue *wq)
+{
+	struct wait_queue_elem *wqe = NULL;
+	bool have_reader = false;
+
+	SLIST_FOREACH(wqe, wq, link) {
+		if (wqe->cv || wqe->done)
+			continue;
+		if (!IS_ENABLED(CFG_MUTEX_WRITER_PREFERENCE))
+			return wqe->wait_read;
+		if (!wqe->wait_read)
+			return false;
+		have_reader = true;
+	}
+
+	return have_reader;
 }
 
 void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
@@ -101,6 +156,7 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	uint32_t old_itr_status;
 	struct wait_queue_elem *wqe;
 	int handle = -1;
+	bool found = false;
 	bool do_wakeup = false;
 	bool wake_type_assigned = false;
 	bool wake_read = false; /* avoid gcc warning */
@@ -108,28 +164,35 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	/*
 	 * If next type is wait_read wakeup all wqe with wait_read true.
 	 * If next type isn't wait_read wakeup only the first wqe which isn't
-	 * done.
+	 * done. With CFG_MUTEX_WRITER_PREFERENCE the next type is a writer
+	 * as long as one is waiting.
 	 */
 
 	while (true) {
 		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 
+		if (!wake_type_assigned) {
+			wake_read = next_wake_read(wq);
+			wake_type_assigned = true;
+		}
+
 		SLIST_FOREACH(wqe, wq, link) {
 			if (wqe->cv)
 				continue;
 			if (wqe->done)
 				continue;
-			if (!wake_type_assigned) {
-				wake_read = wqe->wait_read;
-				wake_type_assigned = true;
-			}
 
 			if (wqe->wait_read != wake_read)
 				continue;
 
 			wqe->done = true;
 			handle = wqe->handle;
-			do_wakeup = true;
+			found = true;
+			/*
+			 * A waiter which hasn't gone to sleep in normal
+			 * world yet will find itself done without it.
+			 */
+			do_wakeup = wqe->sleeping;
 			break;
 		}
 
@@ -139,8 +202,9 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 			__wq_rpc(OPTEE_RPC_WAIT_QUEUE_WAKEUP, handle,
 				 sync_obj, fname, lineno);
 
-		if (!do_wakeup || !wake_read)
+		if (!found || !wake_read)
 			break;
+		found = false;
 		do_wakeup = false;
 	}
 }
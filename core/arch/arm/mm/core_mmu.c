@@ -6,11 +6,13 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <bitstring.h>
 #include <config.h>
 #include <kernel/boot.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/linker.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_l2cc_mutex.h>
@@ -1307,6 +1309,21 @@ bool core_vbuf_is(uint32_t attr, const void *vbuf, size_t len)
 	return core_pbuf_is(attr, p, len);
 }
 
+bool core_vbuf_is_pa_contiguous(const void *vbuf, size_t len)
+{
+	struct tee_mmap_region *map = NULL;
+
+	/* The static mappings are only linear outside virtualization */
+	if (IS_ENABLED(CFG_VIRTUALIZATION))
+		return false;
+
+	map = find_map_by_va((void *)vbuf);
+	if (!map || !map->pa)
+		return false;
+
+	return core_is_buffer_inside((vaddr_t)vbuf, len, map->va, map->size);
+}
+
 /* core_va2pa - teecore exported service */
 static int __maybe_unused core_va2pa_helper(void *va, paddr_t *pa)
 {
@@ -1551,6 +1568,49 @@ static void set_region(struct core_mmu_table_info *tbl_info,
 	}
 }
 
+/*
+ * Returns true if the CORE_MMU_PGDIR_SIZE range at @va in @region can be
+ * mapped with a block entry of the directory table instead of a
+ * translation table, @pa receives the physical address of the block.
+ * Paged user TAs keep a translation table for each directory entry.
+ */
+static bool can_map_user_block(struct vm_region *region, vaddr_t va,
+			       vaddr_t end, paddr_t *pa)
+{
+	size_t offset = va - region->va + region->offset;
+
+	if (IS_ENABLED(CFG_PAGED_USER_TA) || mobj_is_paged(region->mobj) ||
+	    region->mobj->phys_granule || (region->flags & VM_FLAG_LAZY))
+		return false;
+
+	if ((va & CORE_MMU_PGDIR_MASK) || end - va < CORE_MMU_PGDIR_SIZE)
+		return false;
+
+	if (mobj_get_pa(region->mobj, offset, 0, pa))
+		return false;
+
+	return !(*pa & CORE_MMU_PGDIR_MASK);
+}
+
+/*
+ * Maps the part of @region described by @r within the translation table
+ * @pg_info, @r->size is reduced to what's physically contiguous.
+ */
+static void set_unpaged_entries(struct core_mmu_table_info *pg_info,
+				struct vm_region *region,
+				struct tee_mmap_region *r)
+{
+	size_t granule = BIT(pg_info->shift);
+	size_t offset = r->va - region->va + region->offset;
+
+	r->size = MIN(r->size, mobj_get_phys_granule(region->mobj));
+	r->size = ROUNDUP(r->size, SMALL_PAGE_SIZE);
+
+	if (mobj_get_pa(region->mobj, offset, granule, &r->pa) != TEE_SUCCESS)
+		panic("Failed to get PA of unpaged mobj");
+	set_region(pg_info, r);
+}
+
 static void set_pg_region(struct core_mmu_table_info *dir_info,
 			struct vm_region *region, struct pgt **pgt,
 			struct core_mmu_table_info *pg_info)
@@ -1564,6 +1624,14 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 	uint32_t pgt_attr = (r.attr & TEE_MATTR_SECURE) | TEE_MATTR_TABLE;
 
 	while (r.va < end) {
+		if (can_map_user_block(region, r.va, end, &r.pa)) {
+			core_mmu_set_entry(dir_info,
+					   core_mmu_va2idx(dir_info, r.va),
+					   r.pa, r.attr);
+			r.va += CORE_MMU_PGDIR_SIZE;
+			continue;
+		}
+
 		if (!pg_info->table ||
 		     r.va >= (pg_info->va_base + CORE_MMU_PGDIR_SIZE)) {
 			/*
@@ -1604,23 +1672,71 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 		r.size = MIN(CORE_MMU_PGDIR_SIZE - (r.va - pg_info->va_base),
 			     end - r.va);
 
-		if (!mobj_is_paged(region->mobj)) {
-			size_t granule = BIT(pg_info->shift);
-			size_t offset = r.va - region->va + region->offset;
+		if (region->flags & VM_FLAG_LAZY) {
+			/* Clear what a reused table may have left behind */
+			struct tee_mmap_region empty = {
+				.va = r.va,
+				.size = r.size,
+			};
 
-			r.size = MIN(r.size,
-				     mobj_get_phys_granule(region->mobj));
-			r.size = ROUNDUP(r.size, SMALL_PAGE_SIZE);
-
-			if (mobj_get_pa(region->mobj, offset, granule,
-					&r.pa) != TEE_SUCCESS)
-				panic("Failed to get PA of unpaged mobj");
-			set_region(pg_info, &r);
+			set_region(pg_info, &empty);
+		} else if (!mobj_is_paged(region->mobj)) {
+			set_unpaged_entries(pg_info, region, &r);
 		}
 		r.va += r.size;
 	}
 }
 
+static struct pgt *find_user_pgt(paddr_t tbl_pa)
+{
+	struct pgt *p = NULL;
+
+	SLIST_FOREACH(p, &thread_get_tsd()->pgt_cache, link)
+		if (virt_to_phys(p->tbl) == tbl_pa)
+			return p;
+
+	return NULL;
+}
+
+void core_mmu_map_user_region(struct vm_region *region)
+{
+	struct core_mmu_table_info dir_info = { };
+	struct core_mmu_table_info pg_info = { };
+	struct tee_mmap_region r = {
+		.va = region->va,
+		.attr = region->attr,
+	};
+	vaddr_t end = region->va + region->size;
+	struct pgt *pgt = NULL;
+	uint32_t attr = 0;
+	paddr_t pa = 0;
+	unsigned int idx = 0;
+
+	assert(!mobj_is_paged(region->mobj));
+
+	core_mmu_get_user_pgdir(&dir_info);
+	while (r.va < end) {
+		/* The tables were assigned when the map was created */
+		idx = core_mmu_va2idx(&dir_info, r.va);
+		core_mmu_get_entry(&dir_info, idx, &pa, &attr);
+		assert(attr & TEE_MATTR_TABLE);
+		pgt = find_user_pgt(pa);
+		if (!pgt)
+			panic("User translation table not found");
+		core_mmu_set_info_table(&pg_info, dir_info.level + 1,
+					core_mmu_idx2va(&dir_info, idx),
+					pgt->tbl);
+
+		r.size = MIN(CORE_MMU_PGDIR_SIZE - (r.va - pg_info.va_base),
+			     end - r.va);
+		set_unpaged_entries(&pg_info, region, &r);
+		r.va += r.size;
+	}
+
+	/* Entries were invalid before, no TLB maintenance is needed */
+	dsb_ishst();
+}
+
 static bool can_map_at_level(paddr_t paddr, vaddr_t vaddr,
 			     size_t size_left, paddr_t block_size,
 			     struct tee_mmap_region *mm __maybe_unused)
@@ -1700,6 +1816,58 @@ void core_mmu_map_region(struct mmu_partition *prtn, struct tee_mmap_region *mm)
 	}
 }
 
+/*
+ * Returns true if the @num_pages pages to be mapped at @vaddr can start
+ * with a CORE_MMU_PGDIR_SIZE block mapping. The pages are either listed
+ * in @pages or, if @pages is NULL, contiguous from @pa.
+ */
+static bool can_map_pgdir_block(vaddr_t vaddr, paddr_t pa,
+				const paddr_t *pages, size_t num_pages)
+{
+	size_t n = 0;
+
+	if (!IS_ENABLED(CFG_CORE_MMU_SHM_BLOCK_MAP))
+		return false;
+	if (num_pages < CORE_MMU_PGDIR_SIZE / SMALL_PAGE_SIZE ||
+	    ((vaddr | pa) & CORE_MMU_PGDIR_MASK))
+		return false;
+
+	if (pages)
+		for (n = 1; n < CORE_MMU_PGDIR_SIZE / SMALL_PAGE_SIZE; n++)
+			if (pages[n] != pa + n * SMALL_PAGE_SIZE)
+				return false;
+
+	return true;
+}
+
+tee_mm_entry_t *core_mmu_alloc_shm_va(paddr_t pa, size_t size)
+{
+	tee_mm_entry_t *mm = NULL;
+	vaddr_t va = 0;
+
+	if (IS_ENABLED(CFG_CORE_MMU_SHM_BLOCK_MAP) &&
+	    size >= CORE_MMU_PGDIR_SIZE) {
+		/*
+		 * Find a free range with room enough to give the virtual
+		 * address the same offset into a CORE_MMU_PGDIR_SIZE block
+		 * as the physical address and claim that part of it. Other
+		 * threads may allocate in between, in that case we fall
+		 * back to an unaligned allocation.
+		 */
+		mm = tee_mm_alloc(&tee_mm_shm, size + CORE_MMU_PGDIR_SIZE);
+		if (mm) {
+			va = tee_mm_get_smem(mm);
+			va += (pa - va) & CORE_MMU_PGDIR_MASK;
+			tee_mm_free(mm);
+			mm = tee_mm_alloc2(&tee_mm_shm, va, size);
+			if (mm)
+				return mm;
+		}
+	}
+
+	return tee_mm_alloc(&tee_mm_shm, size);
+}
+
 TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 			      enum teecore_memtypes memtype)
 {
@@ -1710,7 +1878,7 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 	uint32_t old_attr;
 	uint32_t exceptions;
 	vaddr_t vaddr = vstart;
-	size_t i;
+	size_t i = 0;
 	bool secure;
 
 	assert(!(core_mmu_type_to_attr(memtype) & TEE_MATTR_PX));
@@ -1729,7 +1897,7 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 	if (!core_mmu_is_dynamic_vaspace(mm))
 		panic("Trying to map into static region");
 
-	for (i = 0; i < num_pages; i++) {
+	while (i < num_pages) {
 		if (pages[i] & SMALL_PAGE_MASK) {
 			ret = TEE_ERROR_BAD_PARAMETERS;
 			goto err;
@@ -1743,6 +1911,10 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 			idx = core_mmu_va2idx(&tbl_info, vaddr);
 			if (tbl_info.shift == SMALL_PAGE_SHIFT)
 				break;
+			if (tbl_info.shift == CORE_MMU_PGDIR_SHIFT &&
+			    can_map_pgdir_block(vaddr, pages[i], pages + i,
+						num_pages - i))
+				break;
 
 			/* This is supertable. Need to divide it. */
 			if (!core_mmu_entry_to_finer_grained(&tbl_info, idx,
@@ -1756,7 +1928,8 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 
 		core_mmu_set_entry(&tbl_info, idx, pages[i],
 				   core_mmu_type_to_attr(memtype));
-		vaddr += SMALL_PAGE_SIZE;
+		vaddr += BIT(tbl_info.shift);
+		i += BIT(tbl_info.shift) / SMALL_PAGE_SIZE;
 	}
 
 	/*
@@ -1807,7 +1980,7 @@ TEE_Result core_mmu_map_contiguous_pages(vaddr_t vstart, paddr_t pstart,
 	if (!core_mmu_is_dynamic_vaspace(mm))
 		panic("Trying to map into static region");
 
-	for (i = 0; i < num_pages; i++) {
+	while (i < num_pages) {
 		while (true) {
 			if (!core_mmu_find_table(NULL, vaddr, UINT_MAX,
 						 &tbl_info))
@@ -1816,6 +1989,10 @@ TEE_Result core_mmu_map_contiguous_pages(vaddr_t vstart, paddr_t pstart,
 			idx = core_mmu_va2idx(&tbl_info, vaddr);
 			if (tbl_info.shift == SMALL_PAGE_SHIFT)
 				break;
+			if (tbl_info.shift == CORE_MMU_PGDIR_SHIFT &&
+			    can_map_pgdir_block(vaddr, paddr, NULL,
+						num_pages - i))
+				break;
 
 			/* This is supertable. Need to divide it. */
 			if (!core_mmu_entry_to_finer_grained(&tbl_info, idx,
@@ -1829,8 +2006,9 @@ TEE_Result core_mmu_map_contiguous_pages(vaddr_t vstart, paddr_t pstart,
 
 		core_mmu_set_entry(&tbl_info, idx, paddr,
 				   core_mmu_type_to_attr(memtype));
-		paddr += SMALL_PAGE_SIZE;
-		vaddr += SMALL_PAGE_SIZE;
+		paddr += BIT(tbl_info.shift);
+		vaddr += BIT(tbl_info.shift);
+		i += BIT(tbl_info.shift) / SMALL_PAGE_SIZE;
 	}
 
 	/*
@@ -1848,9 +2026,10 @@ void core_mmu_unmap_pages(vaddr_t vstart, size_t num_pages)
 {
 	struct core_mmu_table_info tbl_info;
 	struct tee_mmap_region *mm;
-	size_t i;
+	size_t i = 0;
 	unsigned int idx;
 	uint32_t exceptions;
+	uint32_t attr = 0;
 
 	exceptions = mmu_lock();
 
@@ -1861,15 +2040,23 @@ void core_mmu_unmap_pages(vaddr_t vstart, size_t num_pages)
 	if (!core_mmu_is_dynamic_vaspace(mm))
 		panic("Trying to unmap static region");
 
-	for (i = 0; i < num_pages; i++, vstart += SMALL_PAGE_SIZE) {
+	while (i < num_pages) {
 		if (!core_mmu_find_table(NULL, vstart, UINT_MAX, &tbl_info))
 			panic("Can't find pagetable");
 
-		if (tbl_info.shift != SMALL_PAGE_SHIFT)
-			panic("Invalid pagetable level");
-
 		idx = core_mmu_va2idx(&tbl_info, vstart);
+		if (tbl_info.shift != SMALL_PAGE_SHIFT) {
+			/* Only a block mapped by core_mmu_map_pages() */
+			core_mmu_get_entry(&tbl_info, idx, NULL, &attr);
+			if (tbl_info.shift != CORE_MMU_PGDIR_SHIFT || !attr ||
+			    (vstart & CORE_MMU_PGDIR_MASK) ||
+			    num_pages - i < CORE_MMU_PGDIR_SIZE / SMALL_PAGE_SIZE)
+				panic("Invalid pagetable level");
+		}
+
 		core_mmu_set_entry(&tbl_info, idx, 0, 0);
+		vstart += BIT(tbl_info.shift);
+		i += BIT(tbl_info.shift) / SMALL_PAGE_SIZE;
 	}
 	tlbi_all();
 
@@ -2070,6 +2257,76 @@ void asid_free(unsigned int asid)
 	cpu_spin_unlock_xrestore(&g_asid_spinlock, exceptions);
 }
 
+#ifdef CFG_CORE_MMU_LAZY_TLBI
+/*
+ * Each ASID pair has a generation which is bumped each time the
+ * translation tables of the context using the ASID are rebuilt. Each core
+ * records the generation of the ASID pairs it last invalidated in its
+ * local TLB. Switching to a user map on a core which has already seen the
+ * current generation of the ASID can keep what's in the TLB, otherwise
+ * only the entries of that ASID pair are invalidated on the local core.
+ *
+ * Index 0 is the reserved ASID pair used while no user map is active.
+ * The generation is 64-bit so it can't wrap in practice.
+ */
+static uint64_t g_asid_gen_next __nex_bss;
+static uint64_t g_asid_gen[MMU_NUM_ASID_PAIRS + 1] __nex_bss;
+static uint64_t g_asid_core_gen[CFG_TEE_CORE_NB_CORE][MMU_NUM_ASID_PAIRS + 1]
+	__nex_bss;
+#ifdef CFG_WITH_STATS
+static struct asid_stats g_asid_stats __nex_bss;
+#endif
+
+void asid_tables_changed(unsigned int asid)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&g_asid_spinlock);
+
+	assert(asid / 2 <= MMU_NUM_ASID_PAIRS);
+	g_asid_gen_next++;
+	g_asid_gen[asid / 2] = g_asid_gen_next;
+
+	cpu_spin_unlock_xrestore(&g_asid_spinlock, exceptions);
+}
+
+void asid_switch_tlb(unsigned int asid)
+{
+	unsigned int pos = get_core_pos();
+	unsigned int i = asid / 2;
+
+	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	assert(i <= MMU_NUM_ASID_PAIRS);
+
+#ifdef CFG_WITH_STATS
+	atomic_inc32(&g_asid_stats.switches);
+#endif
+	/*
+	 * The reserved ASID pair is invalidated each time the user map is
+	 * removed since entries may have been loaded with it while the
+	 * previous user map was being replaced.
+	 */
+	if (i && g_asid_core_gen[pos][i] == g_asid_gen[i])
+		return;
+
+	tlbi_asid_local(asid);
+	g_asid_core_gen[pos][i] = g_asid_gen[i];
+#ifdef CFG_WITH_STATS
+	atomic_inc32(&g_asid_stats.flushes);
+#endif
+}
+
+#ifdef CFG_WITH_STATS
+void asid_get_stats(struct asid_stats *stats, bool reset)
+{
+	stats->switches = atomic_load_u32(&g_asid_stats.switches);
+	stats->flushes = atomic_load_u32(&g_asid_stats.flushes);
+	if (reset) {
+		atomic_store_u32(&g_asid_stats.switches, 0);
+		atomic_store_u32(&g_asid_stats.flushes, 0);
+	}
+}
+#endif
+#endif /*CFG_CORE_MMU_LAZY_TLBI*/
+
 static bool arm_va2pa_helper(void *va, paddr_t *pa)
 {
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
@@ -2450,5 +2707,5 @@ void core_mmu_init_ta_ram(void)
 	/* remove previous config and init TA ddr memory pool */
 	tee_mm_final(&tee_mm_sec_ddr);
 	tee_mm_init(&tee_mm_sec_ddr, ps, pe, CORE_MMU_USER_CODE_SHIFT,
-		    TEE_MM_POOL_NO_FLAGS);
+		    TEE_MM_POOL_LARGE_FLAGS);
 }
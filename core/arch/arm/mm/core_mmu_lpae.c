@@ -59,6 +59,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <compiler.h>
 #include <inttypes.h>
 #include <keep.h>
@@ -399,6 +400,9 @@ struct mmu_partition *core_alloc_mmu_prtn(void *tables)
 
 void core_free_mmu_prtn(struct mmu_partition *prtn)
 {
+	/* The ASID may be reused, drop what's tagged with it on all cores */
+	if (IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI))
+		tlbi_asid(prtn->asid);
 	asid_free(prtn->asid);
 	nex_free(prtn);
 }
@@ -418,7 +422,14 @@ void core_mmu_set_prtn(struct mmu_partition *prtn)
 
 	write_ttbr0_el1(ttbr | ((paddr_t)prtn->asid << TTBR_ASID_SHIFT));
 	isb();
-	tlbi_all();
+	/*
+	 * With CFG_CORE_MMU_LAZY_TLBI the TEE core mappings of each
+	 * partition are tagged with the ASID of the partition or with the
+	 * ASIDs of the user maps of the guest: the translation tables of
+	 * the partitions remain live and switching TTBR0 is enough.
+	 */
+	if (!IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI))
+		tlbi_all();
 }
 
 void core_mmu_set_default_prtn(void)
@@ -636,6 +647,17 @@ void core_mmu_create_user_map(struct user_mode_ctx *uctx,
 	core_mmu_populate_user_map(&dir_info, uctx);
 	map->user_map = virt_to_phys(dir_info.table) | TABLE_DESC;
 	map->asid = uctx->vm_info.asid;
+	asid_tables_changed(map->asid);
+}
+
+void core_mmu_reuse_user_map(struct user_mode_ctx *uctx,
+			     struct core_mmu_user_map *map)
+{
+	struct core_mmu_table_info dir_info = { };
+
+	core_mmu_get_user_pgdir(&dir_info);
+	map->user_map = virt_to_phys(dir_info.table) | TABLE_DESC;
+	map->asid = uctx->vm_info.asid;
 }
 
 bool core_mmu_find_table(struct mmu_partition *prtn, vaddr_t va,
@@ -814,6 +836,18 @@ bool core_mmu_user_mapping_is_active(void)
 	return ret;
 }
 
+/*
+ * Entries may have been loaded with the ASID of the partition while the
+ * previous user map was being replaced, invalidate them on this core.
+ */
+static void switch_prtn_asid_tlb(struct mmu_partition *prtn)
+{
+	if (IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI) && prtn->asid)
+		tlbi_asid_local(prtn->asid);
+	else
+		asid_switch_tlb(0);
+}
+
 #ifdef ARM32
 void core_mmu_get_user_map(struct core_mmu_user_map *map)
 {
@@ -839,9 +873,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	assert(user_va_idx != -1);
 
 	ttbr = read_ttbr0_64bit();
-	/* Clear ASID */
+	/* Switch to the ASID of the partition */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
-	write_ttbr0_64bit(ttbr);
+	write_ttbr0_64bit(ttbr | ((uint64_t)prtn->asid << TTBR_ASID_SHIFT));
 	isb();
 
 	/* Set the new map */
@@ -853,6 +887,7 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 			map->user_map;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		asid_switch_tlb(map->asid);
 		ttbr |= ((uint64_t)map->asid << TTBR_ASID_SHIFT);
 		write_ttbr0_64bit(ttbr);
 		isb();
@@ -862,9 +897,15 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		prtn->l1_tables[1][get_core_pos()][user_va_idx] = 0;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		switch_prtn_asid_tlb(prtn);
 	}
 
-	tlbi_all();
+	/*
+	 * With CFG_CORE_MMU_LAZY_TLBI user mappings rely on ASID tagging,
+	 * asid_switch_tlb() above has taken care of stale entries.
+	 */
+	if (!IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI))
+		tlbi_all();
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
@@ -923,9 +964,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	struct mmu_partition *prtn = get_prtn();
 
 	ttbr = read_ttbr0_el1();
-	/* Clear ASID */
+	/* Switch to the ASID of the partition */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
-	write_ttbr0_el1(ttbr);
+	write_ttbr0_el1(ttbr | ((uint64_t)prtn->asid << TTBR_ASID_SHIFT));
 	isb();
 
 	/* Set the new map */
@@ -937,6 +978,7 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 			map->user_map;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		asid_switch_tlb(map->asid);
 		ttbr |= ((uint64_t)map->asid << TTBR_ASID_SHIFT);
 		write_ttbr0_el1(ttbr);
 		isb();
@@ -946,9 +988,15 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		prtn->l1_tables[1][get_core_pos()][user_va_idx] = 0;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		switch_prtn_asid_tlb(prtn);
 	}
 
-	tlbi_all();
+	/*
+	 * With CFG_CORE_MMU_LAZY_TLBI user mappings rely on ASID tagging,
+	 * asid_switch_tlb() above has taken care of stale entries.
+	 */
+	if (!IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI))
+		tlbi_all();
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
@@ -6,6 +6,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <keep.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/misc.h>
@@ -491,6 +492,15 @@ void core_mmu_create_user_map(struct user_mode_ctx *uctx,
 	map->ttbr0 = core_mmu_get_ul1_ttb_pa(get_prtn()) |
 		     TEE_MMU_DEFAULT_ATTRS;
 	map->ctxid = uctx->vm_info.asid;
+	asid_tables_changed(map->ctxid);
+}
+
+void core_mmu_reuse_user_map(struct user_mode_ctx *uctx,
+			     struct core_mmu_user_map *map)
+{
+	map->ttbr0 = core_mmu_get_ul1_ttb_pa(get_prtn()) |
+		     TEE_MMU_DEFAULT_ATTRS;
+	map->ctxid = uctx->vm_info.asid;
 }
 
 bool core_mmu_find_table(struct mmu_partition *prtn, vaddr_t va,
@@ -655,14 +665,21 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	if (map) {
 		write_ttbr0(map->ttbr0);
 		isb();
+		asid_switch_tlb(map->ctxid);
 		write_contextidr(map->ctxid);
 		isb();
 	} else {
 		write_ttbr0(read_ttbr1());
 		isb();
+		asid_switch_tlb(0);
 	}
 
-	tlbi_all();
+	/*
+	 * With CFG_CORE_MMU_LAZY_TLBI user mappings rely on ASID tagging,
+	 * asid_switch_tlb() above has taken care of stale entries.
+	 */
+	if (!IS_ENABLED(CFG_CORE_MMU_LAZY_TLBI))
+		tlbi_all();
 	icache_inv_all();
 
 	/* Restore interrupts */
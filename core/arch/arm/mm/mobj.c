@@ -538,7 +538,11 @@ struct mobj *mobj_with_fobj_alloc(struct fobj *fobj, struct file *file)
 	m->mobj.ops = &mobj_with_fobj_ops;
 	refcount_set(&m->mobj.refc, 1);
 	m->mobj.size = fobj->num_pages * SMALL_PAGE_SIZE;
-	m->mobj.phys_granule = SMALL_PAGE_SIZE;
+	/* A contiguous fobj can be mapped with larger blocks */
+	if (fobj_is_contiguous(fobj))
+		m->mobj.phys_granule = 0;
+	else
+		m->mobj.phys_granule = SMALL_PAGE_SIZE;
 	m->fobj = fobj_get(fobj);
 	m->file = file_get(file);
 
@@ -19,6 +19,8 @@
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
 #include <tee_api_types.h>
 #include <types_ext.h>
 #include <util.h>
@@ -38,6 +40,10 @@ struct mobj_reg_shm {
 	tee_mm_entry_t *mm;
 	paddr_t page_offset;
 	struct refcount mapcount;
+	TAILQ_ENTRY(mobj_reg_shm) idle_link;
+	TAILQ_ENTRY(mobj_reg_shm) cache_link;
+	uint32_t pages_hash;
+	bool map_idle;
 	bool guarded;
 	bool releasing;
 	bool release_frees;
@@ -55,14 +61,63 @@ static size_t mobj_reg_shm_size(size_t nr_pages)
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+/*
+ * Registered shared memory objects, hashed on cookie. The lock of a
+ * bucket protects its list and the guarded, releasing and release_frees
+ * flags of its objects. Lookups only take the lock of their bucket and
+ * get a reference with refcount_inc(), which fails for an object already
+ * on its way to mobj_reg_shm_free(), so that the memrefs of different
+ * buffers are resolved on different cores without contention.
+ */
+#define REG_SHM_NUM_BUCKETS	64
+
+SLIST_HEAD(reg_shm_head, mobj_reg_shm);
+
+struct reg_shm_bucket {
+	struct reg_shm_head head;
+	unsigned int lock;
+};
+
+static struct reg_shm_bucket reg_shm_buckets[REG_SHM_NUM_BUCKETS];
 
-static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
+static unsigned int reg_shm_cache_lock = SPINLOCK_UNLOCK;
+
+/*
+ * Objects not mapped by anyone any longer but still mapped in core virtual
+ * memory, least recently used first. At most CFG_CORE_REG_SHM_MAP_CACHE
+ * idle mappings are kept so that a buffer used again, typically by the
+ * next invoke of the same client, doesn't have to be mapped again.
+ * Protected by reg_shm_map_lock.
+ */
+static TAILQ_HEAD(, mobj_reg_shm) reg_shm_idle =
+	TAILQ_HEAD_INITIALIZER(reg_shm_idle);
+static size_t reg_shm_num_idle;
+
+/*
+ * Guarded objects released by their last mobj_put(), least recently
+ * released first. At most CFG_CORE_REG_SHM_FREE_CACHE are kept, along with
+ * their idle mapping if any, so that a non-contiguous temporary memref
+ * passed again with the same pages reuses the object instead of checking
+ * and mapping the pages again. Protected by reg_shm_cache_lock.
+ */
+static TAILQ_HEAD(, mobj_reg_shm) reg_shm_cache =
+	TAILQ_HEAD_INITIALIZER(reg_shm_cache);
+static size_t reg_shm_num_cached;
 
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
+static struct reg_shm_bucket *cookie_bucket(uint64_t cookie)
+{
+	uint64_t h = cookie;
+
+	h ^= h >> 32;
+	h ^= h >> 16;
+	h ^= h >> 8;
+
+	return reg_shm_buckets + (h % REG_SHM_NUM_BUCKETS);
+}
+
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
 				      size_t granule, paddr_t *pa)
 {
@@ -120,24 +175,107 @@ static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
 	r->mm = NULL;
 }
 
-static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
+static void reg_shm_idle_remove(struct mobj_reg_shm *r)
+{
+	TAILQ_REMOVE(&reg_shm_idle, r, idle_link);
+	r->map_idle = false;
+	reg_shm_num_idle--;
+}
+
+/* Unmaps idle objects until at most @max are left */
+static void reg_shm_trim_idle(size_t max)
+{
+	struct mobj_reg_shm *r = NULL;
+
+	while (reg_shm_num_idle > max) {
+		r = TAILQ_FIRST(&reg_shm_idle);
+		reg_shm_idle_remove(r);
+		reg_shm_unmap_helper(r);
+	}
+}
+
+static void reg_shm_unmap_and_free(struct mobj_reg_shm *mobj_reg_shm)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
 
+	if (mobj_reg_shm->map_idle)
+		reg_shm_idle_remove(mobj_reg_shm);
 	if (mobj_reg_shm->mm)
 		reg_shm_unmap_helper(mobj_reg_shm);
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
 	free(mobj_reg_shm);
 }
 
+static uint32_t reg_shm_pages_hash(const paddr_t *pages, size_t num_pages)
+{
+	uint32_t h = 2166136261;
+	uint64_t pfn = 0;
+	size_t n = 0;
+
+	for (n = 0; n < num_pages; n++) {
+		pfn = pages[n] >> SMALL_PAGE_SHIFT;
+		h = (h ^ (uint32_t)pfn ^ (uint32_t)(pfn >> 32)) * 16777619;
+	}
+
+	return h;
+}
+
+/*
+ * Called instead of reg_shm_unmap_and_free() for an object removed from
+ * its bucket
+ */
+static void reg_shm_cache_put(struct mobj_reg_shm *mobj_reg_shm)
+{
+	struct mobj_reg_shm *r = NULL;
+	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_cache_lock);
+
+	TAILQ_INSERT_TAIL(&reg_shm_cache, mobj_reg_shm, cache_link);
+	reg_shm_num_cached++;
+
+	while (reg_shm_num_cached > CFG_CORE_REG_SHM_FREE_CACHE) {
+		r = TAILQ_FIRST(&reg_shm_cache);
+		TAILQ_REMOVE(&reg_shm_cache, r, cache_link);
+		reg_shm_num_cached--;
+		reg_shm_unmap_and_free(r);
+	}
+
+	cpu_spin_unlock_xrestore(&reg_shm_cache_lock, exceptions);
+}
+
+/*
+ * Returns a cached object describing exactly @pages and @page_offset,
+ * removed from the cache, or NULL. Called with reg_shm_cache_lock held.
+ */
+static struct mobj_reg_shm *reg_shm_cache_get(const paddr_t *pages,
+					      size_t num_pages,
+					      paddr_t page_offset,
+					      uint32_t pages_hash)
+{
+	size_t size = num_pages * SMALL_PAGE_SIZE - page_offset;
+	struct mobj_reg_shm *r = NULL;
+
+	TAILQ_FOREACH(r, &reg_shm_cache, cache_link) {
+		if (r->pages_hash == pages_hash && r->mobj.size == size &&
+		    r->page_offset == page_offset &&
+		    !memcmp(r->pages, pages, num_pages * sizeof(*pages))) {
+			TAILQ_REMOVE(&reg_shm_cache, r, cache_link);
+			reg_shm_num_cached--;
+			return r;
+		}
+	}
+
+	return NULL;
+}
+
 static void mobj_reg_shm_free(struct mobj *mobj)
 {
 	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *b = cookie_bucket(r->cookie);
 	uint32_t exceptions = 0;
 
+	exceptions = cpu_spin_lock_xsave(&b->lock);
 	if (r->guarded && !r->releasing) {
 		/*
 		 * Guarded registersted shared memory can't be released
@@ -146,17 +284,20 @@ static void mobj_reg_shm_free(struct mobj *mobj)
 		 * unless mobj_reg_shm_release_by_cookie() is waiting for
 		 * the mobj to be released.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-		reg_shm_free_helper(r);
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		SLIST_REMOVE(&b->head, r, mobj_reg_shm, next);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
+
+		if (CFG_CORE_REG_SHM_FREE_CACHE)
+			reg_shm_cache_put(r);
+		else
+			reg_shm_unmap_and_free(r);
 	} else {
 		/*
 		 * We've reached the point where an unguarded reg shm can
 		 * be released by cookie. Notify eventual waiters.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
 		r->release_frees = true;
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 		mutex_lock(&shm_mu);
 		if (shm_release_waiters)
@@ -190,8 +331,19 @@ static TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj)
 	if (refcount_val(&r->mapcount))
 		goto out;
 
+	if (r->map_idle) {
+		/* Still mapped since last time */
+		reg_shm_idle_remove(r);
+		goto out_set;
+	}
+
 	sz = ROUNDUP(mobj->size + r->page_offset, SMALL_PAGE_SIZE);
-	r->mm = tee_mm_alloc(&tee_mm_shm, sz);
+	r->mm = core_mmu_alloc_shm_va(r->pages[0], sz);
+	if (!r->mm && reg_shm_num_idle) {
+		/* Make room by dropping the idle mappings */
+		reg_shm_trim_idle(0);
+		r->mm = core_mmu_alloc_shm_va(r->pages[0], sz);
+	}
 	if (!r->mm) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto out;
@@ -205,6 +357,7 @@ static TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj)
 		goto out;
 	}
 
+out_set:
 	refcount_set(&r->mapcount, 1);
 out:
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
@@ -222,8 +375,16 @@ static TEE_Result mobj_reg_shm_dec_map(struct mobj *mobj)
 
 	exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
 
-	if (refcount_val(&r->mapcount))
-		reg_shm_unmap_helper(r);
+	if (!refcount_val(&r->mapcount) && r->mm && !r->map_idle) {
+		/*
+		 * Keep the mapping until it's needed for something else or
+		 * the object is freed.
+		 */
+		TAILQ_INSERT_TAIL(&reg_shm_idle, r, idle_link);
+		r->map_idle = true;
+		reg_shm_num_idle++;
+		reg_shm_trim_idle(CFG_CORE_REG_SHM_MAP_CACHE);
+	}
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
@@ -267,6 +428,8 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 				paddr_t page_offset, uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
+	struct reg_shm_bucket *b = cookie_bucket(cookie);
+	uint32_t pages_hash = 0;
 	size_t i = 0;
 	uint32_t exceptions = 0;
 	size_t s = 0;
@@ -277,6 +440,27 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 	s = mobj_reg_shm_size(num_pages);
 	if (!s)
 		return NULL;
+
+	/*
+	 * The pages of a cached object have already been checked, reusing
+	 * it also saves mapping them again if the mapping is still idle.
+	 */
+	pages_hash = reg_shm_pages_hash(pages, num_pages);
+	if (CFG_CORE_REG_SHM_FREE_CACHE) {
+		exceptions = cpu_spin_lock_xsave(&reg_shm_cache_lock);
+		mobj_reg_shm = reg_shm_cache_get(pages, num_pages, page_offset,
+						 pages_hash);
+		cpu_spin_unlock_xrestore(&reg_shm_cache_lock, exceptions);
+		if (mobj_reg_shm) {
+			refcount_set(&mobj_reg_shm->mobj.refc, 1);
+			mobj_reg_shm->cookie = cookie;
+			exceptions = cpu_spin_lock_xsave(&b->lock);
+			SLIST_INSERT_HEAD(&b->head, mobj_reg_shm, next);
+			cpu_spin_unlock_xrestore(&b->lock, exceptions);
+			return &mobj_reg_shm->mobj;
+		}
+	}
+
 	mobj_reg_shm = calloc(1, s);
 	if (!mobj_reg_shm)
 		return NULL;
@@ -288,6 +472,7 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 	mobj_reg_shm->cookie = cookie;
 	mobj_reg_shm->guarded = true;
 	mobj_reg_shm->page_offset = page_offset;
+	mobj_reg_shm->pages_hash = pages_hash;
 	memcpy(mobj_reg_shm->pages, pages, sizeof(*pages) * num_pages);
 
 	/* Ensure loaded references match format and security constraints */
@@ -301,9 +486,9 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 			goto err;
 	}
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	SLIST_INSERT_HEAD(&b->head, mobj_reg_shm, next);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	return &mobj_reg_shm->mobj;
 err:
@@ -313,17 +498,20 @@ err:
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *b = cookie_bucket(r->cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
 
-	to_mobj_reg_shm(mobj)->guarded = false;
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	r->guarded = false;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 }
 
+/* Called with the lock of the bucket of @cookie held */
 static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	SLIST_FOREACH(mobj_reg_shm, &cookie_bucket(cookie)->head, next)
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
 
@@ -332,20 +520,26 @@ static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct reg_shm_bucket *b = cookie_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
 	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	/* A refcount of 0 means that the object is being freed */
+	if (r && !refcount_inc(&r->mobj.refc))
+		r = NULL;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	if (!r)
 		return NULL;
 
-	return mobj_get(&r->mobj);
+	return &r->mobj;
 }
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 {
+	struct reg_shm_bucket *b = cookie_bucket(cookie);
 	uint32_t exceptions = 0;
 	struct mobj_reg_shm *r = NULL;
+	bool release_frees = false;
 
 	/*
 	 * Try to find r and see can be released by this function, if so
@@ -353,14 +547,14 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	 * wrong cookie and perhaps a second time, regardless return
 	 * TEE_ERROR_BAD_PARAMETERS.
 	 */
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
 	r = reg_shm_find_unlocked(cookie);
 	if (!r || r->guarded || r->releasing)
 		r = NULL;
 	else
 		r->releasing = true;
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	if (!r)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -381,15 +575,16 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	assert(shm_release_waiters);
 
 	while (true) {
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-		if (r->release_frees) {
-			reg_shm_free_helper(r);
-			r = NULL;
-		}
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
-
-		if (!r)
+		exceptions = cpu_spin_lock_xsave(&b->lock);
+		release_frees = r->release_frees;
+		if (release_frees)
+			SLIST_REMOVE(&b->head, r, mobj_reg_shm, next);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
+
+		if (release_frees) {
+			reg_shm_unmap_and_free(r);
 			break;
+		}
 		condvar_wait(&shm_cv, &shm_mu);
 	}
 
@@ -427,7 +622,7 @@ static TEE_Result mobj_mapped_shm_init(void)
 		panic("Can't find region for shmem pool");
 
 	if (!tee_mm_init(&tee_mm_shm, pool_start, pool_end, SMALL_PAGE_SHIFT,
-		    TEE_MM_POOL_NO_FLAGS))
+		    TEE_MM_POOL_LARGE_FLAGS))
 		panic("Could not create shmem pool");
 
 	DMSG("Shared memory address range: %" PRIxVA ", %" PRIxVA,
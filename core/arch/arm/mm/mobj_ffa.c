@@ -29,13 +29,24 @@ SLIST_HEAD(mobj_ffa_head, mobj_ffa);
 #ifdef CFG_CORE_SEL1_SPMC
 #define NUM_SHMS	64
 static bitstr_t bit_decl(shm_bits, NUM_SHMS);
+static unsigned int shm_bits_lock = SPINLOCK_UNLOCK;
 #endif
 
-static struct mobj_ffa_head shm_head = SLIST_HEAD_INITIALIZER(shm_head);
-static struct mobj_ffa_head shm_inactive_head =
-	SLIST_HEAD_INITIALIZER(shm_inactive_head);
+/*
+ * Active and inactive objects, hashed on cookie. The lock of a bucket
+ * protects both its lists, the mapping and the flags of the objects of
+ * the bucket, so that objects with different cookies are mostly looked
+ * up and mapped without contention.
+ */
+#define SHM_NUM_BUCKETS	64
+
+struct shm_bucket {
+	struct mobj_ffa_head active;
+	struct mobj_ffa_head inactive;
+	unsigned int lock;
+};
 
-static unsigned int shm_lock = SPINLOCK_UNLOCK;
+static struct shm_bucket shm_buckets[SHM_NUM_BUCKETS];
 
 static const struct mobj_ops mobj_ffa_ops __rodata_unpaged;
 
@@ -45,6 +56,32 @@ static struct mobj_ffa *to_mobj_ffa(struct mobj *mobj)
 	return container_of(mobj, struct mobj_ffa, mobj);
 }
 
+static size_t cookie_hash(uint64_t cookie)
+{
+	uint64_t h = cookie;
+
+	h ^= h >> 32;
+	h ^= h >> 16;
+	h ^= h >> 8;
+
+	return h % SHM_NUM_BUCKETS;
+}
+
+static struct mobj_ffa_head *shm_bucket(uint64_t cookie)
+{
+	return &shm_buckets[cookie_hash(cookie)].active;
+}
+
+static struct mobj_ffa_head *inactive_bucket(uint64_t cookie)
+{
+	return &shm_buckets[cookie_hash(cookie)].inactive;
+}
+
+static unsigned int *bucket_lock(uint64_t cookie)
+{
+	return &shm_buckets[cookie_hash(cookie)].lock;
+}
+
 static size_t shm_size(size_t num_pages)
 {
 	size_t s = 0;
@@ -90,7 +127,7 @@ struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
 	if (!mf)
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	exceptions = cpu_spin_lock_xsave(&shm_bits_lock);
 	bit_ffc(shm_bits, NUM_SHMS, &i);
 	if (i != -1) {
 		bit_set(shm_bits, i);
@@ -100,7 +137,7 @@ struct mobj_ffa *mobj_ffa_sel1_spmc_new(unsigned int num_pages)
 		 */
 		mf->cookie = (i + 1) | BIT64(44);
 	}
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&shm_bits_lock, exceptions);
 
 	if (i == -1) {
 		free(mf);
@@ -176,11 +213,11 @@ void mobj_ffa_sel1_spmc_delete(struct mobj_ffa *mf)
 
 	assert(i >= 0 && i < NUM_SHMS);
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	assert(!mf->mm);
+	exceptions = cpu_spin_lock_xsave(&shm_bits_lock);
 	assert(bit_test(shm_bits, i));
 	bit_clear(shm_bits, i);
-	assert(!mf->mm);
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(&shm_bits_lock, exceptions);
 
 	free(mf);
 }
@@ -214,12 +251,14 @@ uint64_t mobj_ffa_push_to_inactive(struct mobj_ffa *mf)
 {
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	assert(!find_in_list(&shm_inactive_head, cmp_ptr, (vaddr_t)mf));
-	assert(!find_in_list(&shm_inactive_head, cmp_cookie, mf->cookie));
-	assert(!find_in_list(&shm_head, cmp_cookie, mf->cookie));
-	SLIST_INSERT_HEAD(&shm_inactive_head, mf, link);
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(mf->cookie));
+	assert(!find_in_list(inactive_bucket(mf->cookie), cmp_ptr,
+			     (vaddr_t)mf));
+	assert(!find_in_list(inactive_bucket(mf->cookie), cmp_cookie,
+			     mf->cookie));
+	assert(!find_in_list(shm_bucket(mf->cookie), cmp_cookie, mf->cookie));
+	SLIST_INSERT_HEAD(inactive_bucket(mf->cookie), mf, link);
+	cpu_spin_unlock_xrestore(bucket_lock(mf->cookie), exceptions);
 
 	return mf->cookie;
 }
@@ -240,8 +279,8 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(cookie));
+	mf = find_in_list(shm_bucket(cookie), cmp_cookie, cookie);
 	/*
 	 * If the mobj is found here it's still active and cannot be
 	 * unregistered.
@@ -252,7 +291,7 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 		res = TEE_ERROR_BUSY;
 		goto out;
 	}
-	mf = find_in_list(&shm_inactive_head, cmp_cookie, cookie);
+	mf = find_in_list(inactive_bucket(cookie), cmp_cookie, cookie);
 	/*
 	 * If the mobj isn't found or if it already has been unregistered.
 	 */
@@ -264,7 +303,7 @@ TEE_Result mobj_ffa_unregister_by_cookie(uint64_t cookie)
 	res = TEE_SUCCESS;
 
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(bucket_lock(cookie), exceptions);
 	return res;
 }
 
@@ -275,8 +314,8 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 	struct mobj_ffa *mf = NULL;
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(cookie));
+	mf = find_in_list(shm_bucket(cookie), cmp_cookie, cookie);
 	/*
 	 * If the mobj is found here it's still active and cannot be
 	 * reclaimed.
@@ -288,7 +327,7 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 		goto out;
 	}
 
-	mf = find_in_list(&shm_inactive_head, cmp_cookie, cookie);
+	mf = find_in_list(inactive_bucket(cookie), cmp_cookie, cookie);
 	if (!mf) {
 		res = TEE_ERROR_ITEM_NOT_FOUND;
 		goto out;
@@ -303,11 +342,11 @@ TEE_Result mobj_ffa_sel1_spmc_reclaim(uint64_t cookie)
 		goto out;
 	}
 
-	if (!pop_from_list(&shm_inactive_head, cmp_ptr, (vaddr_t)mf))
+	if (!pop_from_list(inactive_bucket(mf->cookie), cmp_ptr, (vaddr_t)mf))
 		panic();
 	res = TEE_SUCCESS;
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(bucket_lock(cookie), exceptions);
 	if (!res)
 		mobj_ffa_sel1_spmc_delete(mf);
 	return res;
@@ -322,9 +361,9 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie, unsigned int internal_offs)
 	if (internal_offs >= SMALL_PAGE_SIZE)
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(cookie));
 
-	mf = find_in_list(&shm_head, cmp_cookie, cookie);
+	mf = find_in_list(shm_bucket(cookie), cmp_cookie, cookie);
 	if (mf) {
 		if (mf->page_offset == internal_offs) {
 			if (!refcount_inc(&mf->mobj.refc)) {
@@ -344,7 +383,7 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie, unsigned int internal_offs)
 			mf = NULL;
 		}
 	} else {
-		mf = pop_from_list(&shm_inactive_head, cmp_cookie, cookie);
+		mf = pop_from_list(inactive_bucket(cookie), cmp_cookie, cookie);
 		if (mf) {
 			mf->unregistered_by_cookie = false;
 			mf->registered_by_cookie = true;
@@ -355,11 +394,11 @@ struct mobj *mobj_ffa_get_by_cookie(uint64_t cookie, unsigned int internal_offs)
 			assert(!(mf->mobj.size & SMALL_PAGE_MASK));
 			mf->mobj.size -= internal_offs;
 			mf->page_offset = internal_offs;
-			SLIST_INSERT_HEAD(&shm_head, mf, link);
+			SLIST_INSERT_HEAD(shm_bucket(mf->cookie), mf, link);
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(bucket_lock(cookie), exceptions);
 
 	if (!mf) {
 		EMSG("Failed to get cookie %#"PRIx64" internal_offs %#x",
@@ -424,11 +463,11 @@ static void ffa_inactivate(struct mobj *mobj)
 	struct mobj_ffa *mf = to_mobj_ffa(mobj);
 	uint32_t exceptions = 0;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(mf->cookie));
 	/*
 	 * If refcount isn't 0 some other thread has found this mobj in
-	 * shm_head after the mobj_put() that put us here and before we got
-	 * the lock.
+	 * its active bucket after the mobj_put() that put us here and
+	 * before we got the lock.
 	 */
 	if (refcount_val(&mobj->refc)) {
 		DMSG("cookie %#"PRIx64" was resurrected", mf->cookie);
@@ -436,12 +475,12 @@ static void ffa_inactivate(struct mobj *mobj)
 	}
 
 	DMSG("cookie %#"PRIx64, mf->cookie);
-	if (!pop_from_list(&shm_head, cmp_ptr, (vaddr_t)mf))
+	if (!pop_from_list(shm_bucket(mf->cookie), cmp_ptr, (vaddr_t)mf))
 		panic();
 	unmap_helper(mf);
-	SLIST_INSERT_HEAD(&shm_inactive_head, mf, link);
+	SLIST_INSERT_HEAD(inactive_bucket(mf->cookie), mf, link);
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(bucket_lock(mf->cookie), exceptions);
 }
 
 static TEE_Result ffa_get_cattr(struct mobj *mobj __unused, uint32_t *cattr)
@@ -475,12 +514,12 @@ static TEE_Result ffa_inc_map(struct mobj *mobj)
 	if (refcount_inc(&mf->mapcount))
 		return TEE_SUCCESS;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(mf->cookie));
 
 	if (refcount_val(&mf->mapcount))
 		goto out;
 
-	mf->mm = tee_mm_alloc(&tee_mm_shm, mf->mobj.size);
+	mf->mm = core_mmu_alloc_shm_va(mf->pages[0], mf->mobj.size);
 	if (!mf->mm) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto out;
@@ -496,7 +535,7 @@ static TEE_Result ffa_inc_map(struct mobj *mobj)
 
 	refcount_set(&mf->mapcount, 1);
 out:
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	cpu_spin_unlock_xrestore(bucket_lock(mf->cookie), exceptions);
 
 	return res;
 }
@@ -509,9 +548,11 @@ static TEE_Result ffa_dec_map(struct mobj *mobj)
 	if (!refcount_dec(&mf->mapcount))
 		return TEE_SUCCESS;
 
-	exceptions = cpu_spin_lock_xsave(&shm_lock);
-	unmap_helper(mf);
-	cpu_spin_unlock_xrestore(&shm_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(bucket_lock(mf->cookie));
+	/* Another thread may have mapped it again before we got the lock */
+	if (!refcount_val(&mf->mapcount))
+		unmap_helper(mf);
+	cpu_spin_unlock_xrestore(bucket_lock(mf->cookie), exceptions);
 
 	return TEE_SUCCESS;
 }
@@ -526,7 +567,7 @@ static TEE_Result mapped_shm_init(void)
 		panic("Can't find region for shmem pool");
 
 	if (!tee_mm_init(&tee_mm_shm, pool_start, pool_end, SMALL_PAGE_SHIFT,
-			 TEE_MM_POOL_NO_FLAGS))
+			 TEE_MM_POOL_LARGE_FLAGS))
 		panic("Could not create shmem pool");
 
 	DMSG("Shared memory address range: %#"PRIxVA", %#"PRIxVA,
@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <kernel/mutex.h>
 #include <kernel/tee_misc.h>
+#include <kernel/thread.h>
 #include <mm/core_mmu.h>
 #include <mm/pgt_cache.h>
 #include <mm/tee_pager.h>
@@ -52,8 +53,17 @@ static struct pgt_cache pgt_free_list = SLIST_HEAD_INITIALIZER(pgt_free_list);
  * the context (page tables holding valid physical pages) are saved in this
  * cache in the hope that some of the valid physical pages may still be
  * valid when the context is mapped again.
+ *
+ * The cache is hashed on the context so all saved tables of a context are
+ * found in the same bucket. With CFG_PGT_CACHE_CTX_TABLES > 0 at most that
+ * many tables are saved per context, the least used ones are released
+ * instead which leaves more free tables for other contexts and lowers the
+ * risk of having to evict tables saved by a context.
  */
-static struct pgt_cache pgt_cache_list = SLIST_HEAD_INITIALIZER(pgt_cache_list);
+#define PGT_CACHE_HASH_BUCKETS	16
+
+static struct pgt_cache pgt_cache_hash[PGT_CACHE_HASH_BUCKETS];
+static struct pgt_cache_stats pgt_stats;
 #endif
 
 static struct pgt pgt_entries[PGT_CACHE_SIZE];
@@ -168,74 +178,104 @@ static void push_to_free_list(struct pgt *p)
 #endif
 
 #ifdef CFG_PAGED_USER_TA
-static void push_to_cache_list(struct pgt *pgt)
+static struct pgt_cache *ctx_bucket(void *ctx)
 {
-	SLIST_INSERT_HEAD(&pgt_cache_list, pgt, link);
+	vaddr_t h = (vaddr_t)ctx;
+
+	/* Contexts are heap allocated, skip the always clear low bits */
+	h ^= h >> 4;
+	h ^= h >> 12;
+
+	return pgt_cache_hash + (h % PGT_CACHE_HASH_BUCKETS);
 }
 
-static bool match_pgt(struct pgt *pgt, vaddr_t vabase, void *ctx)
+static void flush_pgt_entry(struct pgt *p)
 {
-	return pgt->ctx == ctx && pgt->vabase == vabase;
+	tee_pager_pgt_save_and_release_entries(p);
+	assert(!p->num_used_entries);
+	p->ctx = NULL;
+	p->vabase = 0;
 }
 
-static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
+static void release_saved_pgt(struct pgt *p)
 {
-	struct pgt *pgt;
-	struct pgt *p;
+	flush_pgt_entry(p);
+	push_to_free_list(p);
+}
 
-	pgt = SLIST_FIRST(&pgt_cache_list);
-	if (!pgt)
-		return NULL;
-	if (match_pgt(pgt, vabase, ctx)) {
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-		return pgt;
+static void push_to_cache_list(struct pgt *pgt)
+{
+	struct pgt_cache *bucket = ctx_bucket(pgt->ctx);
+	struct pgt *least_used = NULL;
+	struct pgt *p = NULL;
+	size_t count = 0;
+
+	if (CFG_PGT_CACHE_CTX_TABLES) {
+		SLIST_FOREACH(p, bucket, link) {
+			if (p->ctx != pgt->ctx)
+				continue;
+			count++;
+			if (!least_used ||
+			    p->num_used_entries < least_used->num_used_entries)
+				least_used = p;
+		}
+
+		/* Never more than CFG_PGT_CACHE_CTX_TABLES tables are saved */
+		if (count == CFG_PGT_CACHE_CTX_TABLES) {
+			pgt_stats.evictions++;
+			if (least_used->num_used_entries >=
+			    pgt->num_used_entries) {
+				release_saved_pgt(pgt);
+				return;
+			}
+			SLIST_REMOVE(bucket, least_used, pgt, link);
+			release_saved_pgt(least_used);
+		}
 	}
 
-	while (true) {
-		p = SLIST_NEXT(pgt, link);
-		if (!p)
-			break;
-		if (match_pgt(p, vabase, ctx)) {
-			SLIST_REMOVE_AFTER(pgt, link);
-			break;
+	SLIST_INSERT_HEAD(bucket, pgt, link);
+}
+
+static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
+{
+	struct pgt_cache *bucket = ctx_bucket(ctx);
+	struct pgt *p = NULL;
+
+	SLIST_FOREACH(p, bucket, link) {
+		if (p->ctx == ctx && p->vabase == vabase) {
+			SLIST_REMOVE(bucket, p, pgt, link);
+			return p;
 		}
-		pgt = p;
 	}
-	return p;
+
+	return NULL;
 }
 
 static struct pgt *pop_least_used_from_cache_list(void)
 {
-	struct pgt *pgt;
-	struct pgt *p_prev = NULL;
-	size_t least_used;
-
-	pgt = SLIST_FIRST(&pgt_cache_list);
-	if (!pgt)
-		return NULL;
-	if (!pgt->num_used_entries)
-		goto out;
-	least_used = pgt->num_used_entries;
+	struct pgt_cache *least_bucket = NULL;
+	struct pgt *least_used = NULL;
+	struct pgt *p = NULL;
+	size_t n = 0;
 
-	while (true) {
-		if (!SLIST_NEXT(pgt, link))
-			break;
-		if (SLIST_NEXT(pgt, link)->num_used_entries <= least_used) {
-			p_prev = pgt;
-			least_used = SLIST_NEXT(pgt, link)->num_used_entries;
+	for (n = 0; n < PGT_CACHE_HASH_BUCKETS; n++) {
+		SLIST_FOREACH(p, pgt_cache_hash + n, link) {
+			if (!least_used ||
+			    p->num_used_entries < least_used->num_used_entries) {
+				least_used = p;
+				least_bucket = pgt_cache_hash + n;
+				if (!p->num_used_entries)
+					goto out;
+			}
 		}
-		pgt = SLIST_NEXT(pgt, link);
 	}
 
+	if (!least_used)
+		return NULL;
 out:
-	if (p_prev) {
-		pgt = SLIST_NEXT(p_prev, link);
-		SLIST_REMOVE_AFTER(p_prev, link);
-	} else {
-		pgt = SLIST_FIRST(&pgt_cache_list);
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-	}
-	return pgt;
+	SLIST_REMOVE(least_bucket, least_used, pgt, link);
+	pgt_stats.evictions++;
+	return least_used;
 }
 
 static void pgt_free_unlocked(struct pgt_cache *pgt_cache, bool save_ctx)
@@ -261,8 +301,11 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 {
 	struct pgt *p = pop_from_cache_list(vabase, ctx);
 
-	if (p)
+	if (p) {
+		pgt_stats.hits++;
 		return p;
+	}
+	pgt_stats.misses++;
 	p = pop_from_free_list();
 	if (!p) {
 		p = pop_least_used_from_cache_list();
@@ -279,23 +322,20 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 
 void pgt_flush_ctx(struct ts_ctx *ctx)
 {
-	struct pgt *p;
+	struct pgt_cache *bucket = ctx_bucket(ctx);
+	struct pgt *p = NULL;
 	struct pgt *pp = NULL;
 
 	mutex_lock(&pgt_mu);
 
 	while (true) {
-		p = SLIST_FIRST(&pgt_cache_list);
+		p = SLIST_FIRST(bucket);
 		if (!p)
 			goto out;
 		if (p->ctx != ctx)
 			break;
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-		tee_pager_pgt_save_and_release_entries(p);
-		assert(!p->num_used_entries);
-		p->ctx = NULL;
-		p->vabase = 0;
-		push_to_free_list(p);
+		SLIST_REMOVE_HEAD(bucket, link);
+		release_saved_pgt(p);
 	}
 
 	pp = p;
@@ -305,11 +345,7 @@ void pgt_flush_ctx(struct ts_ctx *ctx)
 			break;
 		if (p->ctx == ctx) {
 			SLIST_REMOVE_AFTER(pp, link);
-			tee_pager_pgt_save_and_release_entries(p);
-			assert(!p->num_used_entries);
-			p->ctx = NULL;
-			p->vabase = 0;
-			push_to_free_list(p);
+			release_saved_pgt(p);
 		} else {
 			pp = p;
 		}
@@ -319,12 +355,23 @@ out:
 	mutex_unlock(&pgt_mu);
 }
 
-static void flush_pgt_entry(struct pgt *p)
+void pgt_get_cache_stats(struct pgt_cache_stats *stats, bool reset)
 {
-	tee_pager_pgt_save_and_release_entries(p);
-	assert(!p->num_used_entries);
-	p->ctx = NULL;
-	p->vabase = 0;
+	struct pgt *p = NULL;
+	size_t n = 0;
+
+	mutex_lock(&pgt_mu);
+
+	*stats = pgt_stats;
+	stats->num_saved = 0;
+	for (n = 0; n < PGT_CACHE_HASH_BUCKETS; n++)
+		SLIST_FOREACH(p, pgt_cache_hash + n, link)
+			stats->num_saved++;
+
+	if (reset)
+		memset(&pgt_stats, 0, sizeof(pgt_stats));
+
+	mutex_unlock(&pgt_mu);
 }
 
 static bool pgt_entry_matches(struct pgt *p, void *ctx, vaddr_t begin,
@@ -394,7 +441,7 @@ void pgt_flush_ctx_range(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 
 	if (pgt_cache)
 		flush_ctx_range_from_list(pgt_cache, ctx, begin, last);
-	flush_ctx_range_from_list(&pgt_cache_list, ctx, begin, last);
+	flush_ctx_range_from_list(ctx_bucket(ctx), ctx, begin, last);
 
 	condvar_broadcast(&pgt_cv);
 	mutex_unlock(&pgt_mu);
@@ -402,6 +449,22 @@ void pgt_flush_ctx_range(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 
 #else /*!CFG_PAGED_USER_TA*/
 
+/*
+ * When a thread leaves a user TA context for no other context the tables
+ * of the context are parked instead of freed. If the same thread maps the
+ * same context again before the mapping of the context has changed, the
+ * parked tables are still valid and are used as they are. Parked tables
+ * are released as soon as another context is mapped by the thread, when
+ * tables are missing to map a context or when the context is freed.
+ */
+struct pgt_parked {
+	struct pgt_cache pgt_cache;
+	struct ts_ctx *ctx;
+	unsigned int map_gen;
+};
+
+static struct pgt_parked pgt_parked[CFG_NUM_THREADS];
+
 static void pgt_free_unlocked(struct pgt_cache *pgt_cache,
 			      bool save_ctx __unused)
 {
@@ -413,6 +476,86 @@ static void pgt_free_unlocked(struct pgt_cache *pgt_cache,
 	}
 }
 
+static bool release_parked(struct pgt_parked *pp)
+{
+	bool released = !SLIST_EMPTY(&pp->pgt_cache);
+
+	pgt_free_unlocked(&pp->pgt_cache, false);
+	pp->ctx = NULL;
+
+	return released;
+}
+
+static bool release_all_parked(void)
+{
+	bool released = false;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(pgt_parked); n++)
+		if (release_parked(pgt_parked + n))
+			released = true;
+
+	return released;
+}
+
+void pgt_park(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
+	      unsigned int map_gen)
+{
+	struct pgt_parked *pp = pgt_parked + thread_get_id();
+
+	mutex_lock(&pgt_mu);
+
+	release_parked(pp);
+	pp->pgt_cache = *pgt_cache;
+	SLIST_INIT(pgt_cache);
+	pp->ctx = ctx;
+	pp->map_gen = map_gen;
+
+	/* Threads waiting for tables may take these */
+	condvar_broadcast(&pgt_cv);
+	mutex_unlock(&pgt_mu);
+}
+
+bool pgt_unpark(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
+		unsigned int map_gen)
+{
+	struct pgt_parked *pp = pgt_parked + thread_get_id();
+	bool ret = false;
+
+	mutex_lock(&pgt_mu);
+
+	if (pp->ctx == ctx && pp->map_gen == map_gen &&
+	    SLIST_EMPTY(pgt_cache)) {
+		*pgt_cache = pp->pgt_cache;
+		SLIST_INIT(&pp->pgt_cache);
+		pp->ctx = NULL;
+		ret = true;
+	} else if (release_parked(pp)) {
+		condvar_broadcast(&pgt_cv);
+	}
+
+	mutex_unlock(&pgt_mu);
+
+	return ret;
+}
+
+void pgt_flush_ctx(struct ts_ctx *ctx)
+{
+	bool released = false;
+	size_t n = 0;
+
+	mutex_lock(&pgt_mu);
+
+	for (n = 0; n < ARRAY_SIZE(pgt_parked); n++)
+		if (pgt_parked[n].ctx == ctx &&
+		    release_parked(pgt_parked + n))
+			released = true;
+	if (released)
+		condvar_broadcast(&pgt_cv);
+
+	mutex_unlock(&pgt_mu);
+}
+
 static struct pgt *pop_from_some_list(vaddr_t vabase,
 				      struct ts_ctx *ctx __unused)
 {
@@ -464,7 +607,7 @@ void pgt_clear_ctx_range(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 	if (pgt_cache)
 		clear_ctx_range_from_list(pgt_cache, ctx, begin, end);
 #ifdef CFG_PAGED_USER_TA
-	clear_ctx_range_from_list(&pgt_cache_list, ctx, begin, end);
+	clear_ctx_range_from_list(ctx_bucket(ctx), ctx, begin, end);
 #endif
 
 	mutex_unlock(&pgt_mu);
@@ -509,6 +652,10 @@ void pgt_alloc(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 
 	pgt_free_unlocked(pgt_cache, ctx);
 	while (!pgt_alloc_unlocked(pgt_cache, ctx, begin, last)) {
+#ifndef CFG_PAGED_USER_TA
+		if (release_all_parked())
+			continue;
+#endif
 		DMSG("Waiting for page tables");
 		condvar_broadcast(&pgt_cv);
 		condvar_wait(&pgt_cv, &pgt_mu);
@@ -8,6 +8,7 @@
 #include <kernel/tee_common.h>
 #include <mm/tee_mm.h>
 #include <mm/tee_pager.h>
+#include <string.h>
 #include <trace.h>
 #include <util.h>
 
@@ -35,6 +36,345 @@ static void pfree(tee_mm_pool_t *pool, void *ptr)
 		free(ptr);
 }
 
+/*
+ * Bitmap backend, used for pools initialized with TEE_MM_POOL_BITMAP
+ *
+ * Each block of the pool has a bit in @bits which is set while the block
+ * is allocated. The words of @bits are the leaves of a complete binary
+ * tree, @tree, where each node holds the longest run of free blocks in the
+ * range it covers as well as the length of the free runs at the start and
+ * at the end of the range. Finding the lowest or highest free extent able
+ * to hold an allocation is then a walk from the root to a leaf. Bits
+ * beyond the end of the pool are kept set so they're never handed out.
+ *
+ * Entries are kept in @entries sorted on offset to be found with a binary
+ * search.
+ */
+#define BM_WORD_BITS	32
+
+struct tee_mm_extent {
+	uint32_t max;
+	uint32_t prefix;
+	uint32_t suffix;
+};
+
+struct tee_mm_bitmap {
+	uint32_t *bits;
+	struct tee_mm_extent *tree;
+	size_t num_leaves;
+	tee_mm_entry_t **entries;
+	size_t num_entries;
+	size_t max_entries;
+	size_t allocated;
+};
+
+static void bm_free(tee_mm_pool_t *pool, struct tee_mm_bitmap *bm)
+{
+	if (bm) {
+		pfree(pool, bm->bits);
+		pfree(pool, bm->tree);
+		pfree(pool, bm->entries);
+	}
+	pfree(pool, bm);
+}
+
+static void bm_update_leaf(struct tee_mm_bitmap *bm, size_t idx)
+{
+	struct tee_mm_extent *e = bm->tree + bm->num_leaves + idx;
+	uint32_t w = bm->bits[idx];
+	uint32_t x = ~w;
+
+	if (!w) {
+		e->max = BM_WORD_BITS;
+		e->prefix = BM_WORD_BITS;
+		e->suffix = BM_WORD_BITS;
+		return;
+	}
+
+	e->prefix = __builtin_ctz(w);
+	e->suffix = __builtin_clz(w);
+	/* Each round shortens all runs of free blocks by one */
+	e->max = 0;
+	while (x) {
+		x &= x << 1;
+		e->max++;
+	}
+}
+
+static void bm_update_node(struct tee_mm_bitmap *bm, size_t node,
+			   uint32_t half)
+{
+	struct tee_mm_extent *e = bm->tree + node;
+	struct tee_mm_extent *l = bm->tree + node * 2;
+	struct tee_mm_extent *r = bm->tree + node * 2 + 1;
+
+	e->prefix = l->prefix;
+	if (l->prefix == half)
+		e->prefix += r->prefix;
+	e->suffix = r->suffix;
+	if (r->suffix == half)
+		e->suffix += l->suffix;
+	e->max = MAX(l->max, r->max);
+	if (l->suffix + r->prefix > e->max)
+		e->max = l->suffix + r->prefix;
+}
+
+/* Updates the tree after the bits of words @first to @last changed */
+static void bm_update(struct tee_mm_bitmap *bm, size_t first, size_t last)
+{
+	uint32_t half = BM_WORD_BITS;
+	size_t lo = 0;
+	size_t hi = 0;
+	size_t n = 0;
+
+	for (n = first; n <= last; n++)
+		bm_update_leaf(bm, n);
+
+	lo = (bm->num_leaves + first) / 2;
+	hi = (bm->num_leaves + last) / 2;
+	while (lo) {
+		for (n = lo; n <= hi; n++)
+			bm_update_node(bm, n, half);
+		lo /= 2;
+		hi /= 2;
+		half *= 2;
+	}
+}
+
+static void bm_set_range(struct tee_mm_bitmap *bm, uint32_t offs,
+			 uint32_t size, bool alloc)
+{
+	size_t n = 0;
+
+	for (n = offs; n < offs + size; n++) {
+		uint32_t mask = BIT(n % BM_WORD_BITS);
+
+		if (alloc)
+			bm->bits[n / BM_WORD_BITS] |= mask;
+		else
+			bm->bits[n / BM_WORD_BITS] &= ~mask;
+	}
+
+	bm_update(bm, offs / BM_WORD_BITS, (offs + size - 1) / BM_WORD_BITS);
+}
+
+static bool bm_range_is_free(struct tee_mm_bitmap *bm, uint32_t offs,
+			     uint32_t size)
+{
+	size_t n = 0;
+
+	for (n = offs; n < offs + size; n++)
+		if (bm->bits[n / BM_WORD_BITS] & BIT(n % BM_WORD_BITS))
+			return false;
+
+	return true;
+}
+
+/* Returns the lowest, or highest if @hi, position of @size free bits */
+static int bm_leaf_find(uint32_t w, uint32_t size, bool hi)
+{
+	uint32_t mask = 0;
+	int n = 0;
+
+	if (size == BM_WORD_BITS)
+		return w ? -1 : 0;
+
+	mask = BIT(size) - 1;
+	if (hi) {
+		for (n = BM_WORD_BITS - size; n >= 0; n--)
+			if (!(w & (mask << n)))
+				return n;
+	} else {
+		for (n = 0; n <= (int)(BM_WORD_BITS - size); n++)
+			if (!(w & (mask << n)))
+				return n;
+	}
+
+	return -1;
+}
+
+/*
+ * Finds the free extent of @size blocks with the lowest offset, or the
+ * highest offset with TEE_MM_POOL_HI_ALLOC, and returns its offset in
+ * @offs.
+ */
+static bool bm_find_free(tee_mm_pool_t *pool, size_t size, uint32_t *offs)
+{
+	struct tee_mm_bitmap *bm = pool->bitmap;
+	bool hi = pool->flags & TEE_MM_POOL_HI_ALLOC;
+	size_t len = bm->num_leaves * BM_WORD_BITS;
+	struct tee_mm_extent *l = NULL;
+	struct tee_mm_extent *r = NULL;
+	size_t start = 0;
+	size_t node = 1;
+	size_t half = 0;
+	int pos = 0;
+
+	if (bm->tree[1].max < size)
+		return false;
+
+	while (node < bm->num_leaves) {
+		half = len / 2;
+		l = bm->tree + node * 2;
+		r = l + 1;
+
+		if (hi && r->max >= size) {
+			node = node * 2 + 1;
+			start += half;
+		} else if (l->suffix + r->prefix >= size &&
+			   (hi || l->max < size)) {
+			/* The extent straddles the two halves */
+			if (hi)
+				*offs = start + half + r->prefix - size;
+			else
+				*offs = start + half - l->suffix;
+			return true;
+		} else if (hi || l->max >= size) {
+			node = node * 2;
+		} else {
+			node = node * 2 + 1;
+			start += half;
+		}
+		len = half;
+	}
+
+	pos = bm_leaf_find(bm->bits[node - bm->num_leaves], (uint32_t)size,
+			   hi);
+	if (pos < 0)
+		panic();
+	*offs = start + pos;
+
+	return true;
+}
+
+/* Returns the index of the first entry with an offset larger than @offs */
+static size_t bm_entry_upper_bound(struct tee_mm_bitmap *bm, uint32_t offs)
+{
+	size_t lo = 0;
+	size_t hi = bm->num_entries;
+	size_t mid = 0;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (bm->entries[mid]->offset > offs)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+static bool bm_add_entry(tee_mm_pool_t *pool, tee_mm_entry_t *nn)
+{
+	struct tee_mm_bitmap *bm = pool->bitmap;
+	tee_mm_entry_t **entries = NULL;
+	size_t max_entries = 0;
+	size_t idx = 0;
+
+	if (bm->num_entries == bm->max_entries) {
+		max_entries = MAX(bm->max_entries * 2, 16U);
+		entries = pmalloc(pool, max_entries * sizeof(*entries));
+		if (!entries)
+			return false;
+		if (bm->num_entries)
+			memcpy(entries, bm->entries,
+			       bm->num_entries * sizeof(*entries));
+		pfree(pool, bm->entries);
+		bm->entries = entries;
+		bm->max_entries = max_entries;
+	}
+
+	idx = bm_entry_upper_bound(bm, nn->offset);
+	memmove(bm->entries + idx + 1, bm->entries + idx,
+		(bm->num_entries - idx) * sizeof(*bm->entries));
+	bm->entries[idx] = nn;
+	bm->num_entries++;
+
+	bm_set_range(bm, nn->offset, nn->size, true);
+	bm->allocated += nn->size;
+
+	return true;
+}
+
+static bool bm_remove_entry(tee_mm_pool_t *pool, tee_mm_entry_t *p)
+{
+	struct tee_mm_bitmap *bm = pool->bitmap;
+	size_t idx = bm_entry_upper_bound(bm, p->offset);
+
+	if (!idx || bm->entries[idx - 1] != p)
+		return false;
+
+	idx--;
+	bm->num_entries--;
+	memmove(bm->entries + idx, bm->entries + idx + 1,
+		(bm->num_entries - idx) * sizeof(*bm->entries));
+
+	bm_set_range(bm, p->offset, p->size, false);
+	bm->allocated -= p->size;
+
+	return true;
+}
+
+static tee_mm_entry_t *bm_find_entry(const tee_mm_pool_t *pool,
+				     uint32_t offs)
+{
+	struct tee_mm_bitmap *bm = pool->bitmap;
+	size_t idx = bm_entry_upper_bound(bm, offs);
+	tee_mm_entry_t *entry = NULL;
+
+	if (!idx)
+		return NULL;
+
+	entry = bm->entries[idx - 1];
+	if (offs < entry->offset + entry->size)
+		return entry;
+
+	return NULL;
+}
+
+static bool bm_init(tee_mm_pool_t *pool)
+{
+	uint32_t num_blocks = (pool->hi - pool->lo) >> pool->shift;
+	size_t num_words = ROUNDUP(num_blocks, BM_WORD_BITS) / BM_WORD_BITS;
+	struct tee_mm_bitmap *bm = NULL;
+	size_t n = 0;
+
+	bm = pcalloc(pool, 1, sizeof(*bm));
+	if (!bm)
+		return false;
+
+	bm->num_leaves = 1;
+	while (bm->num_leaves < num_words)
+		bm->num_leaves *= 2;
+
+	bm->bits = pmalloc(pool, bm->num_leaves * sizeof(*bm->bits));
+	bm->tree = pcalloc(pool, bm->num_leaves * 2, sizeof(*bm->tree));
+	if (!bm->bits || !bm->tree) {
+		bm_free(pool, bm);
+		return false;
+	}
+
+	memset(bm->bits, 0xff, bm->num_leaves * sizeof(*bm->bits));
+	for (n = 0; n < num_blocks; n++)
+		bm->bits[n / BM_WORD_BITS] &= ~BIT(n % BM_WORD_BITS);
+	bm_update(bm, 0, bm->num_leaves - 1);
+
+	pool->bitmap = bm;
+	return true;
+}
+
+static void bm_final(tee_mm_pool_t *pool)
+{
+	struct tee_mm_bitmap *bm = pool->bitmap;
+	size_t n = 0;
+
+	for (n = 0; n < bm->num_entries; n++)
+		pfree(pool, bm->entries[n]);
+	bm_free(pool, bm);
+	pool->bitmap = NULL;
+}
+
 bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
 		 uint32_t flags)
 {
@@ -58,8 +398,15 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
 		pool->entry->offset = ((hi - lo - 1) >> shift) + 1;
 	pool->entry->pool = pool;
+	pool->bitmap = NULL;
 	pool->lock = SPINLOCK_UNLOCK;
 
+	if ((pool->flags & TEE_MM_POOL_BITMAP) && !bm_init(pool)) {
+		pfree(pool, pool->entry);
+		pool->entry = NULL;
+		return false;
+	}
+
 	return true;
 }
 
@@ -68,6 +415,8 @@ void tee_mm_final(tee_mm_pool_t *pool)
 	if (pool == NULL || pool->entry == NULL)
 		return;
 
+	if (pool->bitmap)
+		bm_final(pool);
 	while (pool->entry->next != NULL)
 		tee_mm_free(pool->entry->next);
 	pfree(pool, pool->entry);
@@ -90,6 +439,9 @@ static size_t tee_mm_stats_allocated(tee_mm_pool_t *pool)
 	if (!pool)
 		return 0;
 
+	if (pool->bitmap)
+		return pool->bitmap->allocated << pool->shift;
+
 	entry = pool->entry;
 	while (entry) {
 		sz += entry->size;
@@ -157,6 +509,20 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 	else
 		psize = ((size - 1) >> pool->shift) + 1;
 
+	if (pool->bitmap) {
+		uint32_t offs = 0;
+
+		if (!psize || !bm_find_free(pool, psize, &offs))
+			goto err;
+		nn->offset = offs;
+		nn->size = psize;
+		nn->pool = pool;
+		nn->next = NULL;
+		if (!bm_add_entry(pool, nn))
+			goto err;
+		goto out;
+	}
+
 	/* find free slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
 		while (entry->next != NULL && psize >
@@ -208,7 +574,7 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 		nn->offset = entry->offset + entry->size;
 	nn->size = psize;
 	nn->pool = pool;
-
+out:
 	update_max_allocated(pool);
 
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
@@ -266,6 +632,20 @@ tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 	offslo = (base - pool->lo) >> pool->shift;
 	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
 
+	if (pool->bitmap) {
+		if (!size ||
+		    (offshi << pool->shift) > (pool->hi - pool->lo) ||
+		    !bm_range_is_free(pool->bitmap, offslo, offshi - offslo))
+			goto err;
+		mm->offset = offslo;
+		mm->size = offshi - offslo;
+		mm->pool = pool;
+		mm->next = NULL;
+		if (!bm_add_entry(pool, mm))
+			goto err;
+		goto out;
+	}
+
 	/* find slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
 		while (entry->next != NULL &&
@@ -285,7 +665,7 @@ tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 	mm->offset = offslo;
 	mm->size = offshi - offslo;
 	mm->pool = pool;
-
+out:
 	update_max_allocated(pool);
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return mm;
@@ -295,6 +675,49 @@ err:
 	return NULL;
 }
 
+tee_mm_entry_t *tee_mm_alloc_aligned(tee_mm_pool_t *pool, size_t size,
+				     size_t align, paddr_t offs)
+{
+	tee_mm_entry_t *mm = NULL;
+	paddr_t base = 0;
+
+	if (!pool || !size || !IS_POWER_OF_TWO(align) || offs >= align ||
+	    (offs & ((1 << pool->shift) - 1)) || pool->hi - pool->lo < size)
+		return NULL;
+
+	/*
+	 * Try the candidate ranges in the order tee_mm_alloc() would use,
+	 * this is slower but only large allocations are supposed to need
+	 * an alignment.
+	 */
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
+		base = ROUNDDOWN(pool->hi - size, align) + offs;
+		if (base > pool->hi - size) {
+			if (base - pool->lo < align)
+				return NULL;
+			base -= align;
+		}
+		while (base >= pool->lo) {
+			mm = tee_mm_alloc2(pool, base, size);
+			if (mm || base - pool->lo < align)
+				return mm;
+			base -= align;
+		}
+	} else {
+		base = ROUNDDOWN(pool->lo, align) + offs;
+		if (base < pool->lo)
+			base += align;
+		while (base <= pool->hi - size) {
+			mm = tee_mm_alloc2(pool, base, size);
+			if (mm || pool->hi - size - base < align)
+				return mm;
+			base += align;
+		}
+	}
+
+	return NULL;
+}
+
 void tee_mm_free(tee_mm_entry_t *p)
 {
 	tee_mm_entry_t *entry;
@@ -304,6 +727,15 @@ void tee_mm_free(tee_mm_entry_t *p)
 		return;
 
 	exceptions = cpu_spin_lock_xsave(&p->pool->lock);
+
+	if (p->pool->bitmap) {
+		if (!bm_remove_entry(p->pool, p))
+			panic("invalid mm_entry");
+		cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
+		pfree(p->pool, p);
+		return;
+	}
+
 	entry = p->pool->entry;
 
 	/* remove entry from list */
@@ -341,7 +773,10 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 		return true;
 
 	exceptions = cpu_spin_lock_xsave(&pool->lock);
-	ret = pool->entry == NULL || pool->entry->next == NULL;
+	if (pool->bitmap)
+		ret = !pool->bitmap->num_entries;
+	else
+		ret = pool->entry->next == NULL;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 
 	return ret;
@@ -359,7 +794,7 @@ tee_mm_pool_t tee_mm_shm;
 tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 {
 	tee_mm_entry_t *entry = pool->entry;
-	uint16_t offset = (addr - pool->lo) >> pool->shift;
+	uint32_t offset = (addr - pool->lo) >> pool->shift;
 	uint32_t exceptions;
 
 	if (addr > pool->hi || addr < pool->lo)
@@ -367,6 +802,13 @@ tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 
 	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
 
+	if (pool->bitmap) {
+		entry = bm_find_entry(pool, offset);
+		cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock,
+					 exceptions);
+		return entry;
+	}
+
 	while (entry->next != NULL) {
 		entry = entry->next;
 
@@ -6,12 +6,15 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <io.h>
 #include <keep.h>
 #include <kernel/abort.h>
 #include <kernel/asan.h>
+#include <kernel/boot.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/linker.h>
+#include <kernel/lock_stats.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_misc.h>
@@ -38,6 +41,7 @@ static struct tee_pager_area_head tee_pager_area_head =
 #define INVALID_PGIDX		UINT_MAX
 #define PMEM_FLAG_DIRTY		BIT(0)
 #define PMEM_FLAG_HIDDEN	BIT(1)
+#define PMEM_FLAG_REFERENCED	BIT(2)
 
 /*
  * struct tee_pager_pmem - Represents a physical page used for paging.
@@ -57,7 +61,17 @@ struct tee_pager_pmem {
 	TAILQ_ENTRY(tee_pager_pmem) link;
 };
 
-/* The list of physical pages. The first page in the list is the oldest */
+/*
+ * The list of physical pages. The first page in the list is the oldest.
+ *
+ * The oldest pages are hidden, that is unmapped while keeping their
+ * content, to detect which of them are still in use. A hidden page
+ * accessed again is moved to the tail of the list. With
+ * CFG_PAGER_SECOND_CHANCE it's also tagged as referenced, which spares it
+ * once more when it reaches the head of the list again and would have
+ * been evicted. Pages which are in use over longer periods thus need to go
+ * unused during two rounds through the list before they're evicted.
+ */
 TAILQ_HEAD(tee_pager_pmem_head, tee_pager_pmem);
 
 static struct tee_pager_pmem_head tee_pager_pmem_head =
@@ -72,8 +86,23 @@ static struct tee_pager_pmem_head tee_pager_lock_pmem_head =
 /* Number of registered physical pages, used hiding pages. */
 static size_t tee_pager_npages;
 
+/*
+ * User TA areas are all of PAGER_AREA_TYPE_RW, their read-only pages are
+ * told apart with the mapping attributes.
+ */
+static enum tee_pager_fault_type fault_type(struct tee_pager_area *area)
+{
+	if (area->type == PAGER_AREA_TYPE_LOCK)
+		return TEE_PAGER_FAULT_ZERO_INIT;
+	if (area->flags & (TEE_MATTR_PW | TEE_MATTR_UW))
+		return TEE_PAGER_FAULT_RW_LOAD;
+	return TEE_PAGER_FAULT_RO_LOAD;
+}
+
 #ifdef CFG_WITH_STATS
 static struct tee_pager_stats pager_stats;
+/* Counter ticks spent in cache and TLB maintenance */
+static uint64_t pager_maint_cnt;
 
 static inline void incr_ro_hits(void)
 {
@@ -95,6 +124,16 @@ static inline void incr_zi_released(void)
 	pager_stats.zi_released++;
 }
 
+static inline void incr_second_chances(void)
+{
+	pager_stats.second_chances++;
+}
+
+static inline void incr_read_ahead(void)
+{
+	pager_stats.read_ahead++;
+}
+
 static inline void incr_npages_all(void)
 {
 	pager_stats.npages_all++;
@@ -105,14 +144,74 @@ static inline void set_npages(void)
 	pager_stats.npages = tee_pager_npages;
 }
 
-void tee_pager_get_stats(struct tee_pager_stats *stats)
+static uint64_t cnt2us(uint64_t cnt)
 {
-	*stats = pager_stats;
+	return cnt * 1000000 / read_cntfrq();
+}
 
-	pager_stats.hidden_hits = 0;
-	pager_stats.ro_hits = 0;
-	pager_stats.rw_hits = 0;
-	pager_stats.zi_released = 0;
+static unsigned int fault_hist_bucket(uint64_t us)
+{
+	if (us < 2)
+		return 0;
+
+	return MIN(63U - __builtin_clzll(us),
+		   TEE_PAGER_FAULT_HIST_BUCKETS - 1U);
+}
+
+static inline uint64_t stat_fault_begin(void)
+{
+	return barrier_read_cntpct();
+}
+
+static void stat_fault_end(enum tee_pager_fault_type type, uint64_t begin)
+{
+	struct tee_pager_fault_stats *fs = pager_stats.faults + type;
+	uint64_t us = cnt2us(barrier_read_cntpct() - begin);
+
+	fs->count++;
+	fs->total_us += us;
+	fs->max_us = MAX(fs->max_us, us);
+	fs->hist[fault_hist_bucket(us)]++;
+}
+
+static void incr_evictions(struct tee_pager_pmem *pmem)
+{
+	struct tee_pager_area *area = TAILQ_FIRST(&pmem->fobj->areas);
+	struct tee_pager_ta_stats *ts = NULL;
+	const TEE_UUID *uuid = NULL;
+	size_t n = 0;
+
+	if (!area)
+		return;
+
+	if (fault_type(area) == TEE_PAGER_FAULT_RO_LOAD)
+		pager_stats.ro_evictions++;
+	else
+		pager_stats.rw_evictions++;
+
+	if (!area->uctx)
+		return;
+
+	uuid = &area->uctx->ts_ctx->uuid;
+	for (n = 0; n < TEE_PAGER_STATS_MAX_TA; n++) {
+		ts = pager_stats.ta + n;
+		if (!ts->evictions)
+			ts->uuid = *uuid;
+		if (!memcmp(&ts->uuid, uuid, sizeof(*uuid))) {
+			ts->evictions++;
+			break;
+		}
+	}
+}
+
+static inline uint64_t stat_maint_begin(void)
+{
+	return barrier_read_cntpct();
+}
+
+static inline void stat_maint_end(uint64_t begin)
+{
+	pager_maint_cnt += barrier_read_cntpct() - begin;
 }
 
 #else /* CFG_WITH_STATS */
@@ -120,8 +219,16 @@ static inline void incr_ro_hits(void) { }
 static inline void incr_rw_hits(void) { }
 static inline void incr_hidden_hits(void) { }
 static inline void incr_zi_released(void) { }
+static inline void incr_second_chances(void) { }
+static inline void incr_read_ahead(void) { }
 static inline void incr_npages_all(void) { }
 static inline void set_npages(void) { }
+static inline uint64_t stat_fault_begin(void) { return 0; }
+static inline void stat_fault_end(enum tee_pager_fault_type type __unused,
+				  uint64_t begin __unused) { }
+static inline void incr_evictions(struct tee_pager_pmem *pmem __unused) { }
+static inline uint64_t stat_maint_begin(void) { return 0; }
+static inline void stat_maint_end(uint64_t begin __unused) { }
 
 void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
@@ -144,6 +251,7 @@ static struct pager_table {
 static unsigned int num_pager_tables;
 
 static unsigned pager_spinlock = SPINLOCK_UNLOCK;
+static struct lock_stats pager_lock_stats = LOCK_STATS_INITIALIZER("pager");
 
 /* Defines the range of the alias area */
 static tee_mm_entry_t *pager_alias_area;
@@ -163,8 +271,11 @@ static uint32_t pager_lock_dldetect(const char *func, const int line,
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	unsigned int retries = 0;
 	unsigned int reminder = 0;
+	uint64_t wait_start = 0;
 
 	while (!cpu_spin_trylock(&pager_spinlock)) {
+		if (!wait_start)
+			wait_start = lock_stats_wait_start(&pager_lock_stats);
 		retries++;
 		if (!retries) {
 			/* wrapped, time to report */
@@ -177,13 +288,14 @@ static uint32_t pager_lock_dldetect(const char *func, const int line,
 				abort_print(ai);
 		}
 	}
+	lock_stats_acquired(&pager_lock_stats, wait_start, 0);
 
 	return exceptions;
 }
 #else
 static uint32_t pager_lock(struct abort_info __unused *ai)
 {
-	return cpu_spin_lock_xsave(&pager_spinlock);
+	return cpu_spin_lock_xsave_stats(&pager_spinlock, &pager_lock_stats);
 }
 #endif
 
@@ -214,6 +326,56 @@ static void pager_unlock(uint32_t exceptions)
 	cpu_spin_unlock_xrestore(&pager_spinlock, exceptions);
 }
 
+#ifdef CFG_WITH_STATS
+/* Counts the pages of the working set, mapped or hidden per area type */
+static void get_working_set_stats(struct tee_pager_stats *stats)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	struct tee_pager_area *area = NULL;
+
+	stats->ro_resident = 0;
+	stats->rw_resident = 0;
+	stats->hidden = 0;
+
+	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
+		if (!pmem->fobj)
+			continue;
+		if (pmem->flags & PMEM_FLAG_HIDDEN) {
+			stats->hidden++;
+			continue;
+		}
+		area = TAILQ_FIRST(&pmem->fobj->areas);
+		if (area && area->type == PAGER_AREA_TYPE_RW)
+			stats->rw_resident++;
+		else
+			stats->ro_resident++;
+	}
+}
+
+void tee_pager_get_stats(struct tee_pager_stats *stats)
+{
+	uint32_t exceptions = pager_lock(NULL);
+
+	*stats = pager_stats;
+	stats->maint_us = cnt2us(pager_maint_cnt);
+	get_working_set_stats(stats);
+
+	pager_stats.hidden_hits = 0;
+	pager_stats.ro_hits = 0;
+	pager_stats.rw_hits = 0;
+	pager_stats.zi_released = 0;
+	pager_stats.second_chances = 0;
+	pager_stats.read_ahead = 0;
+	pager_stats.ro_evictions = 0;
+	pager_stats.rw_evictions = 0;
+	memset(pager_stats.faults, 0, sizeof(pager_stats.faults));
+	memset(pager_stats.ta, 0, sizeof(pager_stats.ta));
+	pager_maint_cnt = 0;
+
+	pager_unlock(exceptions);
+}
+#endif /* CFG_WITH_STATS */
+
 void *tee_pager_phys_to_virt(paddr_t pa)
 {
 	struct core_mmu_table_info ti;
@@ -416,23 +578,99 @@ static vaddr_t area_idx2va(struct tee_pager_area *area, size_t idx)
 	return (idx << SMALL_PAGE_SHIFT) + (area->base & ~CORE_MMU_PGDIR_MASK);
 }
 
-static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
+/* Returns the ASID of a user mode area or 0 for a core area */
+static uint32_t area_get_asid(struct tee_pager_area *area __maybe_unused)
 {
-	vaddr_t va = area_idx2va(area, idx);
-
 #if defined(CFG_PAGED_USER_TA)
 	assert(area->pgt);
-	if (area->pgt->ctx) {
-		uint32_t asid = to_user_mode_ctx(area->pgt->ctx)->vm_info.asid;
+	if (area->pgt->ctx)
+		return to_user_mode_ctx(area->pgt->ctx)->vm_info.asid;
+#endif
+	return 0;
+}
 
+static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
+{
+	vaddr_t va = area_idx2va(area, idx);
+	uint32_t asid = area_get_asid(area);
+
+	if (asid)
 		tlbi_mva_asid(va, asid);
+	else
+		tlbi_mva_allasid(va);
+}
+
+/*
+ * Deferred TLB invalidation of entries unmapped while holding the pager
+ * lock. Entries are recorded with tlbi_batch_add() and invalidated by
+ * tlbi_batch_flush() with a single round of barriers instead of one per
+ * entry. When more than TLBI_BATCH_MAX_PAGES entries of a user mode
+ * context are recorded the whole ASID is invalidated instead.
+ */
+#define TLBI_BATCH_MAX_PAGES	8
+
+struct tlbi_batch {
+	vaddr_t va[TLBI_BATCH_MAX_PAGES];
+	size_t num_va;
+	uint32_t asid;		/* 0 for core entries */
+	bool whole_asid;
+};
+
+static void tlbi_batch_flush(struct tlbi_batch *batch)
+{
+	uint64_t begin = stat_maint_begin();
+	size_t n = 0;
+
+	if (batch->whole_asid) {
+		tlbi_asid(batch->asid);
+	} else if (batch->num_va) {
+		/* Make sure the table updates are visible first */
+		dsb_ishst();
+		for (n = 0; n < batch->num_va; n++) {
+			if (batch->asid)
+				tlbi_mva_asid_nosync(batch->va[n],
+						     batch->asid);
+			else
+				tlbi_mva_allasid_nosync(batch->va[n]);
+		}
+		dsb_ish();
+		isb();
+	}
+
+	batch->num_va = 0;
+	stat_maint_end(begin);
+	batch->whole_asid = false;
+}
+
+static void tlbi_batch_add(struct tlbi_batch *batch,
+			   struct tee_pager_area *area, size_t idx)
+{
+	uint32_t asid = area_get_asid(area);
+
+	if ((batch->num_va || batch->whole_asid) && asid != batch->asid)
+		tlbi_batch_flush(batch);
+	batch->asid = asid;
+
+	if (batch->whole_asid)
 		return;
+	if (batch->num_va == TLBI_BATCH_MAX_PAGES) {
+		if (asid) {
+			batch->whole_asid = true;
+			return;
+		}
+		tlbi_batch_flush(batch);
 	}
-#endif
-	tlbi_mva_allasid(va);
+	batch->va[batch->num_va] = area_idx2va(area, idx);
+	batch->num_va++;
 }
 
-static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
+/*
+ * Unmaps @pmem from the areas using it, the TLB entries are recorded in
+ * @batch and must be invalidated with tlbi_batch_flush() before the
+ * page is used for something else.
+ */
+static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt,
+		       struct tlbi_batch *batch)
 {
 	struct tee_pager_area *area = NULL;
 	size_t tblidx = 0;
@@ -452,7 +690,7 @@ static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
 		if (a & TEE_MATTR_VALID_BLOCK) {
 			area_set_entry(area, tblidx, 0, 0);
 			pgt_dec_used_entries(area->pgt);
-			area_tlbi_entry(area, tblidx);
+			tlbi_batch_add(batch, area, tblidx);
 		}
 	}
 }
@@ -749,6 +987,7 @@ static TEE_Result pager_add_um_area(struct user_mode_ctx *uctx, vaddr_t base,
 		area->base = b;
 		area->size = s2;
 		area->flags = prot;
+		area->uctx = uctx;
 
 		area_insert(uctx->areas, area, a_prev);
 
@@ -847,6 +1086,7 @@ static void split_area(struct tee_pager_area_head *area_head,
 	a2->base = va;
 	a2->size = area->size - diff;
 	a2->pgt = area->pgt;
+	a2->uctx = area->uctx;
 	area->size = diff;
 
 	TAILQ_INSERT_AFTER(area_head, area, a2, link);
@@ -943,11 +1183,12 @@ static void rem_area(struct tee_pager_area_head *area_head,
 	struct tee_pager_pmem *pmem;
 	size_t last_pgoffs = area->fobj_pgoffs +
 			     (area->size >> SMALL_PAGE_SHIFT) - 1;
+	struct tlbi_batch batch = { };
 	uint32_t exceptions;
 	size_t idx = 0;
 	uint32_t a = 0;
 
-	exceptions = pager_lock_check_stack(64);
+	exceptions = pager_lock_check_stack(128);
 
 	TAILQ_REMOVE(area_head, area, link);
 	TAILQ_REMOVE(&area->fobj->areas, area, fobj_link);
@@ -964,10 +1205,11 @@ static void rem_area(struct tee_pager_area_head *area_head,
 			continue;
 
 		area_set_entry(area, idx, 0, 0);
-		area_tlbi_entry(area, idx);
+		tlbi_batch_add(&batch, area, idx);
 		pgt_dec_used_entries(area->pgt);
 	}
 
+	tlbi_batch_flush(&batch);
 	pager_unlock(exceptions);
 
 	free_area(area);
@@ -985,7 +1227,6 @@ void tee_pager_rem_um_region(struct user_mode_ctx *uctx, vaddr_t base,
 		if (core_is_buffer_inside(area->base, area->size, base, s))
 			rem_area(uctx->areas, area);
 	}
-	tlbi_asid(uctx->vm_info.asid);
 }
 
 void tee_pager_rem_um_areas(struct user_mode_ctx *uctx)
@@ -1122,6 +1363,7 @@ void tee_pager_invalidate_fobj(struct fobj *fobj)
 		if (pmem->fobj == fobj) {
 			pmem->fobj = NULL;
 			pmem->fobj_pgidx = INVALID_PGIDX;
+			pmem->flags &= ~PMEM_FLAG_REFERENCED;
 		}
 	}
 
@@ -1147,6 +1389,7 @@ static bool tee_pager_unhide_page(struct tee_pager_area *area,
 {
 	struct tee_pager_pmem *pmem = pmem_find(area, tblidx);
 	uint32_t a = get_area_mattr(area->flags);
+	uint64_t begin = 0;
 	uint32_t attr = 0;
 	paddr_t pa = 0;
 
@@ -1196,7 +1439,9 @@ static bool tee_pager_unhide_page(struct tee_pager_area *area,
 		area_set_entry(area, tblidx, pa, a & ~TEE_MATTR_UX);
 		dsb_ishst();
 
+		begin = stat_maint_begin();
 		icache_inv_user_range(va, SMALL_PAGE_SIZE);
+		stat_maint_end(begin);
 
 		/* Set the final mapping */
 		area_set_entry(area, tblidx, pa, a);
@@ -1207,6 +1452,8 @@ static bool tee_pager_unhide_page(struct tee_pager_area *area,
 	}
 	pgt_inc_used_entries(area->pgt);
 
+	if (IS_ENABLED(CFG_PAGER_SECOND_CHANCE))
+		pmem->flags |= PMEM_FLAG_REFERENCED;
 	TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
 	TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
 	incr_hidden_hits();
@@ -1216,6 +1463,7 @@ static bool tee_pager_unhide_page(struct tee_pager_area *area,
 static void tee_pager_hide_pages(void)
 {
 	struct tee_pager_pmem *pmem = NULL;
+	struct tlbi_batch batch = { };
 	size_t n = 0;
 
 	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
@@ -1231,8 +1479,10 @@ static void tee_pager_hide_pages(void)
 			continue;
 
 		pmem->flags |= PMEM_FLAG_HIDDEN;
-		pmem_unmap(pmem, NULL);
+		pmem_unmap(pmem, NULL, &batch);
 	}
+
+	tlbi_batch_flush(&batch);
 }
 
 static unsigned int __maybe_unused
@@ -1287,9 +1537,34 @@ static bool tee_pager_release_one_phys(struct tee_pager_area *area,
 	return false;
 }
 
+/*
+ * Returns the oldest page not referenced since it was last spared, the
+ * referenced pages passed on the way are moved to the tail of the list.
+ */
+static struct tee_pager_pmem *pmem_get_victim(void)
+{
+	struct tee_pager_pmem *pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	size_t n = 0;
+
+	/* Bounded in case all pages have been referenced */
+	for (n = 0; n < tee_pager_npages; n++) {
+		if (!(pmem->flags & PMEM_FLAG_REFERENCED))
+			break;
+
+		pmem->flags &= ~PMEM_FLAG_REFERENCED;
+		TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
+		incr_second_chances();
+		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	}
+
+	return pmem;
+}
+
 /* Finds the oldest page and unmaps it from all tables */
 static struct tee_pager_pmem *tee_pager_get_page(enum tee_pager_area_type at)
 {
+	struct tlbi_batch batch = { };
 	struct tee_pager_pmem *pmem;
 
 	pmem = TAILQ_FIRST(&tee_pager_pmem_head);
@@ -1298,8 +1573,13 @@ static struct tee_pager_pmem *tee_pager_get_page(enum tee_pager_area_type at)
 		return NULL;
 	}
 
+	if (IS_ENABLED(CFG_PAGER_SECOND_CHANCE))
+		pmem = pmem_get_victim();
+
 	if (pmem->fobj) {
-		pmem_unmap(pmem, NULL);
+		incr_evictions(pmem);
+		pmem_unmap(pmem, NULL, &batch);
+		tlbi_batch_flush(&batch);
 		tee_pager_save_page(pmem);
 	}
 
@@ -1410,6 +1690,216 @@ static bool pager_update_permissions(struct tee_pager_area *area,
 	return true;
 }
 
+/*
+ * Loads the page at @page_va of @area into @pmem and maps it, @pmem has
+ * been obtained with tee_pager_get_page().
+ */
+static void pager_map_pmem(struct tee_pager_area *area,
+			   struct tee_pager_pmem *pmem, vaddr_t page_va,
+			   bool clean_user_cache)
+{
+	uint32_t attr = 0;
+	paddr_t pa = 0;
+	size_t tblidx = 0;
+
+	/* load page code & data */
+	tee_pager_load_page(area, page_va, pmem->va_alias);
+
+	pmem->fobj = area->fobj;
+	pmem->fobj_pgidx = area_va2idx(area, page_va) +
+			   area->fobj_pgoffs -
+			   ((area->base & CORE_MMU_PGDIR_MASK) >>
+				SMALL_PAGE_SHIFT);
+	tblidx = pmem_get_area_tblidx(pmem, area);
+	attr = get_area_mattr(area->flags);
+	/*
+	 * Pages from PAGER_AREA_TYPE_RW starts read-only to be
+	 * able to tell when they are updated and should be tagged
+	 * as dirty.
+	 */
+	if (area->type == PAGER_AREA_TYPE_RW)
+		attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
+	pa = get_pmem_pa(pmem);
+
+	/*
+	 * We've updated the page using the aliased mapping and
+	 * some cache maintenence is now needed if it's an
+	 * executable page.
+	 *
+	 * Since the d-cache is a Physically-indexed,
+	 * physically-tagged (PIPT) cache we can clean either the
+	 * aliased address or the real virtual address. In this
+	 * case we choose the real virtual address.
+	 *
+	 * The i-cache can also be PIPT, but may be something else
+	 * too like VIPT. The current code requires the caches to
+	 * implement the IVIPT extension, that is:
+	 * "instruction cache maintenance is required only after
+	 * writing new data to a physical address that holds an
+	 * instruction."
+	 *
+	 * To portably invalidate the icache the page has to
+	 * be mapped at the final virtual address but not
+	 * executable.
+	 */
+	if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
+		uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
+				TEE_MATTR_PW | TEE_MATTR_UW;
+		void *va = (void *)page_va;
+		uint64_t begin = 0;
+
+		/* Set a temporary read-only mapping */
+		area_set_entry(area, tblidx, pa, attr & ~mask);
+		area_tlbi_entry(area, tblidx);
+
+		begin = stat_maint_begin();
+		dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
+		if (clean_user_cache)
+			icache_inv_user_range(va, SMALL_PAGE_SIZE);
+		else
+			icache_inv_range(va, SMALL_PAGE_SIZE);
+		stat_maint_end(begin);
+
+		/* Set the final mapping */
+		area_set_entry(area, tblidx, pa, attr);
+		area_tlbi_entry(area, tblidx);
+	} else {
+		area_set_entry(area, tblidx, pa, attr);
+		/*
+		 * No need to flush TLB for this entry, it was
+		 * invalid. We should use a barrier though, to make
+		 * sure that the change is visible.
+		 */
+		dsb_ishst();
+	}
+	pgt_inc_used_entries(area->pgt);
+
+	FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
+}
+
+/*
+ * Sequential read-ahead of read-only areas, protected by the pager lock.
+ * When faults hit consecutive pages of a read-only area the following
+ * pages are loaded and mapped too. The number of pages read ahead doubles
+ * with each sequential fault, up to CFG_PAGER_READ_AHEAD_PAGES and a
+ * quarter of the pageable pages.
+ */
+static struct tee_pager_area *ra_area;
+static vaddr_t ra_next_va;
+static size_t ra_num_pages;
+
+static void pager_read_ahead(struct tee_pager_area *area, vaddr_t page_va,
+			     bool clean_user_cache)
+{
+	vaddr_t end = area->base + area->size;
+	vaddr_t va = page_va + SMALL_PAGE_SIZE;
+	struct tee_pager_pmem *pmem = NULL;
+	size_t max_pages = 0;
+	size_t tblidx = 0;
+	uint32_t attr = 0;
+	size_t n = 0;
+
+	if (!CFG_PAGER_READ_AHEAD_PAGES || area->type != PAGER_AREA_TYPE_RO)
+		return;
+
+	if (area != ra_area || page_va != ra_next_va) {
+		/* Not sequential, start over */
+		ra_area = area;
+		ra_next_va = va;
+		ra_num_pages = 0;
+		return;
+	}
+
+	max_pages = MIN((size_t)CFG_PAGER_READ_AHEAD_PAGES,
+			tee_pager_npages / 4);
+	if (ra_num_pages)
+		ra_num_pages = MIN(ra_num_pages * 2, max_pages);
+	else
+		ra_num_pages = MIN((size_t)1, max_pages);
+
+	for (n = 0; n < ra_num_pages && va < end; n++) {
+		tblidx = area_va2idx(area, va);
+		area_get_entry(area, tblidx, NULL, &attr);
+		/* Stop at pages which are already resident */
+		if ((attr & TEE_MATTR_VALID_BLOCK) || pmem_find(area, tblidx))
+			break;
+
+		pmem = tee_pager_get_page(area->type);
+		if (!pmem)
+			break;
+		pager_map_pmem(area, pmem, va, clean_user_cache);
+		incr_read_ahead();
+		va += SMALL_PAGE_SIZE;
+	}
+
+	ra_next_va = va;
+}
+
+#ifdef CFG_CORE_PAGER_FAULT_LOG
+/*
+ * Open addressing hash table of the fault addresses, protected by the
+ * pager lock. Only grows until it's reset since the addresses of the hot
+ * code are expected to show up early.
+ */
+static struct tee_pager_fault_rec fault_log[CFG_CORE_PAGER_FAULT_LOG_ENTRIES];
+static size_t fault_log_count;
+static uint32_t fault_log_dropped;
+
+static void log_fault(struct abort_info *ai)
+{
+	vaddr_t va = ai->va - boot_mmu_config.load_offset;
+	size_t mask = ARRAY_SIZE(fault_log) - 1;
+	size_t idx = (va >> 2) * 0x9E3779B1 & mask;
+	size_t n = 0;
+
+	COMPILE_TIME_ASSERT(IS_POWER_OF_TWO(CFG_CORE_PAGER_FAULT_LOG_ENTRIES));
+
+	for (n = 0; n < ARRAY_SIZE(fault_log); n++) {
+		struct tee_pager_fault_rec *rec = fault_log + ((idx + n) & mask);
+
+		if (!rec->count) {
+			rec->va = va;
+			fault_log_count++;
+		}
+		if (rec->va == va) {
+			rec->count++;
+			return;
+		}
+	}
+	fault_log_dropped++;
+}
+
+size_t tee_pager_get_fault_log(struct tee_pager_fault_rec *recs,
+			       size_t num_recs, uint32_t *dropped,
+			       bool reset)
+{
+	uint32_t exceptions = pager_lock(NULL);
+	size_t count = fault_log_count;
+	size_t n = 0;
+	size_t m = 0;
+
+	for (n = 0; n < ARRAY_SIZE(fault_log) && m < num_recs; n++)
+		if (fault_log[n].count)
+			recs[m++] = fault_log[n];
+	if (dropped)
+		*dropped = fault_log_dropped;
+
+	if (reset) {
+		memset(fault_log, 0, sizeof(fault_log));
+		fault_log_count = 0;
+		fault_log_dropped = 0;
+	}
+
+	pager_unlock(exceptions);
+
+	return count;
+}
+#else
+static void log_fault(struct abort_info *ai __unused)
+{
+}
+#endif
+
 #ifdef CFG_TEE_CORE_DEBUG
 static void stat_handle_fault(void)
 {
@@ -1438,6 +1928,8 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 {
 	struct tee_pager_area *area;
 	vaddr_t page_va = ai->va & ~SMALL_PAGE_MASK;
+	enum tee_pager_fault_type type = TEE_PAGER_FAULT_TYPE_NUM;
+	uint64_t begin = 0;
 	uint32_t exceptions;
 	bool ret;
 	bool clean_user_cache = false;
@@ -1459,6 +1951,7 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	 * and once everything is ready we map it.
 	 */
 	exceptions = pager_lock(ai);
+	begin = stat_fault_begin();
 
 	stat_handle_fault();
 
@@ -1480,9 +1973,6 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 
 	if (!tee_pager_unhide_page(area, area_va2idx(area, page_va))) {
 		struct tee_pager_pmem *pmem = NULL;
-		uint32_t attr = 0;
-		paddr_t pa = 0;
-		size_t tblidx = 0;
 
 		/*
 		 * The page wasn't hidden, but some other core may have
@@ -1495,92 +1985,31 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 			 * could already have been dealt with from another
 			 * core or if ret is false the TA will be paniced.
 			 */
+			type = TEE_PAGER_FAULT_PERM;
 			goto out;
 		}
 
+		type = fault_type(area);
+		if (type == TEE_PAGER_FAULT_RO_LOAD && !clean_user_cache)
+			log_fault(ai);
+
 		pmem = tee_pager_get_page(area->type);
 		if (!pmem) {
 			abort_print(ai);
 			panic();
 		}
 
-		/* load page code & data */
-		tee_pager_load_page(area, page_va, pmem->va_alias);
-
-
-		pmem->fobj = area->fobj;
-		pmem->fobj_pgidx = area_va2idx(area, page_va) +
-				   area->fobj_pgoffs -
-				   ((area->base & CORE_MMU_PGDIR_MASK) >>
-					SMALL_PAGE_SHIFT);
-		tblidx = pmem_get_area_tblidx(pmem, area);
-		attr = get_area_mattr(area->flags);
-		/*
-		 * Pages from PAGER_AREA_TYPE_RW starts read-only to be
-		 * able to tell when they are updated and should be tagged
-		 * as dirty.
-		 */
-		if (area->type == PAGER_AREA_TYPE_RW)
-			attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
-		pa = get_pmem_pa(pmem);
-
-		/*
-		 * We've updated the page using the aliased mapping and
-		 * some cache maintenence is now needed if it's an
-		 * executable page.
-		 *
-		 * Since the d-cache is a Physically-indexed,
-		 * physically-tagged (PIPT) cache we can clean either the
-		 * aliased address or the real virtual address. In this
-		 * case we choose the real virtual address.
-		 *
-		 * The i-cache can also be PIPT, but may be something else
-		 * too like VIPT. The current code requires the caches to
-		 * implement the IVIPT extension, that is:
-		 * "instruction cache maintenance is required only after
-		 * writing new data to a physical address that holds an
-		 * instruction."
-		 *
-		 * To portably invalidate the icache the page has to
-		 * be mapped at the final virtual address but not
-		 * executable.
-		 */
-		if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
-			uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
-					TEE_MATTR_PW | TEE_MATTR_UW;
-			void *va = (void *)page_va;
-
-			/* Set a temporary read-only mapping */
-			area_set_entry(area, tblidx, pa, attr & ~mask);
-			area_tlbi_entry(area, tblidx);
-
-			dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
-			if (clean_user_cache)
-				icache_inv_user_range(va, SMALL_PAGE_SIZE);
-			else
-				icache_inv_range(va, SMALL_PAGE_SIZE);
-
-			/* Set the final mapping */
-			area_set_entry(area, tblidx, pa, attr);
-			area_tlbi_entry(area, tblidx);
-		} else {
-			area_set_entry(area, tblidx, pa, attr);
-			/*
-			 * No need to flush TLB for this entry, it was
-			 * invalid. We should use a barrier though, to make
-			 * sure that the change is visible.
-			 */
-			dsb_ishst();
-		}
-		pgt_inc_used_entries(area->pgt);
-
-		FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
-
+		pager_map_pmem(area, pmem, page_va, clean_user_cache);
+		pager_read_ahead(area, page_va, clean_user_cache);
+	} else {
+		type = TEE_PAGER_FAULT_UNHIDE;
 	}
 
 	tee_pager_hide_pages();
 	ret = true;
 out:
+	if (type != TEE_PAGER_FAULT_TYPE_NUM)
+		stat_fault_end(type, begin);
 	pager_unlock(exceptions);
 	return ret;
 }
@@ -1691,6 +2120,7 @@ void tee_pager_pgt_save_and_release_entries(struct pgt *pgt)
 	struct tee_pager_pmem *pmem = NULL;
 	struct tee_pager_area *area = NULL;
 	struct tee_pager_area_head *areas = NULL;
+	struct tlbi_batch batch = { };
 	uint32_t exceptions = pager_lock_check_stack(SMALL_PAGE_SIZE);
 
 	if (!pgt->num_used_entries)
@@ -1698,8 +2128,9 @@ void tee_pager_pgt_save_and_release_entries(struct pgt *pgt)
 
 	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
 		if (pmem->fobj)
-			pmem_unmap(pmem, pgt);
+			pmem_unmap(pmem, pgt, &batch);
 	}
+	tlbi_batch_flush(&batch);
 	assert(!pgt->num_used_entries);
 
 out:
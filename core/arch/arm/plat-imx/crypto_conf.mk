@@ -34,6 +34,21 @@ CFG_NXP_CAAM_BLOB_DRV ?= y
 $(call force, CFG_JR_BLOCK_SIZE,0x1000)
 
 $(call force, CFG_JR_INDEX,0)  # Default JR index used
+
+# Number of Job Rings reserved for the secure world, the jobs being
+# distributed on them per core. The Job Rings are the ones with a secure
+# status in the DTB or else the ones following CFG_JR_INDEX with
+# consecutive interrupt numbers from CFG_JR_INT. At most
+# 32 / CFG_NB_JOBS_QUEUE Job Rings are used, only one if
+# CFG_NXP_CAAM_RUNTIME_JR is not enabled.
+CFG_NXP_CAAM_JR_NUM ?= 1
+
+# Job Ring completion interrupt coalescing, the interrupt is raised when
+# CFG_NXP_CAAM_JR_COAL_COUNT jobs are done (0 for half of the Job Ring
+# entries) or when a job is done and CFG_NXP_CAAM_JR_COAL_TIMER clock
+# cycles elapsed without new job completion.
+CFG_NXP_CAAM_JR_COAL_COUNT ?= 0
+CFG_NXP_CAAM_JR_COAL_TIMER ?= 10
 $(call force, CFG_JR_INT,137)  # Default JR IT Number (105 + 32) = 137
 
 #
@@ -97,4 +112,8 @@ $(call force, CFG_CRYPTO_DRV_MAC, $(call cryphw-one-enabled, HMAC CMAC))
 #
 CFG_CRYPTO_DRV_ACIPHER ?= $(CFG_NXP_CAAM_ACIPHER_DRV)
 
+# Blob encapsulation and decapsulation, also available to the TAs through
+# the blob pseudo TA
+CFG_CRYPTO_DRV_BLOB ?= $(CFG_NXP_CAAM_BLOB_DRV)
+
 endif
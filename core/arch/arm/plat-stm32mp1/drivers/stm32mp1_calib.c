@@ -489,7 +489,7 @@ static TEE_Result init_stm32mp1_calib(void)
 	if (!fdt)
 		panic();
 
-	rcc_node = fdt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
+	rcc_node = dt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
 	if (rcc_node < 0)
 		panic();
 
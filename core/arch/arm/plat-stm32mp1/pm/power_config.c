@@ -7,6 +7,7 @@
 #include <config.h>
 #include <dt-bindings/power/stm32mp1-power.h>
 #include <kernel/boot.h>
+#include <kernel/dt.h>
 #include <kernel/panic.h>
 #include <libfdt.h>
 #include <stm32mp_pm.h>
@@ -195,7 +196,7 @@ int stm32mp1_set_lp_deepest_soc_mode(uint32_t psci_mode, uint32_t soc_mode)
 #ifdef CFG_DT
 static int dt_get_pwr_node(void *fdt)
 {
-	return fdt_node_offset_by_compatible(fdt, -1, DT_PWR_COMPAT);
+	return dt_node_offset_by_compatible(fdt, -1, DT_PWR_COMPAT);
 }
 
 static TEE_Result stm32mp1_init_lp_states(void)
@@ -19,11 +19,15 @@
 #include <rproc_pub_key.h>
 #include <stm32_util.h>
 #include <string.h>
+#include <string_ext.h>
 
 #define PTA_NAME "remoteproc.pta"
 
 #define STM32_M4_FW_ID		0
 
+/* Chunks are copied and hashed by blocks while still in the data cache */
+#define LOAD_BLOCK_SIZE		SMALL_PAGE_SIZE
+
 /* Firmware states */
 enum rproc_load_state {
 	REMOTEPROC_OFF = 0,
@@ -107,7 +111,20 @@ static const struct rproc_ta_memory_region rproc_ta_mp1_m4_mems[] = {
 	{ .pa = RETRAM_BASE, .da = 0x00000000, .size = RETRAM_SIZE },
 };
 
+/*
+ * struct rproc_ta_seg_load - segment being loaded in chunks
+ * @hash_ctx - SHA256 context of the data loaded so far, NULL if none
+ * @da - Segment base address from remote processor space
+ * @size - Byte size loaded so far
+ */
+struct rproc_ta_seg_load {
+	void *hash_ctx;
+	paddr_t da;
+	size_t size;
+};
+
 static enum rproc_load_state rproc_ta_state;
+static struct rproc_ta_seg_load rproc_ta_seg_load;
 
 static TEE_Result rproc_pta_capabilities(uint32_t pt,
 					 TEE_Param params[TEE_NUM_PARAMS])
@@ -203,6 +220,112 @@ static TEE_Result rproc_pta_load_segment(uint32_t pt,
 	return res;
 }
 
+static void rproc_pta_seg_load_release(bool clear)
+{
+	struct rproc_ta_seg_load *seg = &rproc_ta_seg_load;
+	paddr_t pa = 0;
+
+	if (clear && !da_to_pa(seg->da, seg->size, &pa))
+		memset((void *)core_mmu_get_va(pa, MEM_AREA_IO_SEC), 0,
+		       seg->size);
+
+	crypto_hash_free_ctx(seg->hash_ctx);
+	*seg = (struct rproc_ta_seg_load){ };
+}
+
+static TEE_Result rproc_pta_load_segment_chunk(uint32_t pt,
+					       TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_MEMREF_INPUT);
+	struct rproc_ta_seg_load *seg = &rproc_ta_seg_load;
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+	paddr_t pa = 0;
+	uint8_t *dst = 0;
+	uint32_t flags = params[0].value.b;
+	uint8_t *src = params[1].memref.buffer;
+	size_t size = params[1].memref.size;
+	uint8_t *hash = params[3].memref.buffer;
+	paddr_t da = (paddr_t)reg_pair_to_64(params[2].value.b,
+					     params[2].value.a);
+	size_t offs = 0;
+	size_t n = 0;
+
+	if (pt != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!hash || params[3].memref.size != TEE_SHA256_HASH_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (flags & ~(PTA_REMOTEPROC_CHUNK_FIRST | PTA_REMOTEPROC_CHUNK_LAST))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Only STM32_M4_FW_ID supported */
+	if (params[0].value.a != STM32_M4_FW_ID) {
+		EMSG("Unsupported firmware ID %#"PRIx32, params[0].value.a);
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	if (rproc_ta_state != REMOTEPROC_OFF)
+		return TEE_ERROR_BAD_STATE;
+
+	if (flags & PTA_REMOTEPROC_CHUNK_FIRST) {
+		/* Drop a previous segment load which was not completed */
+		rproc_pta_seg_load_release(true);
+
+		res = crypto_hash_alloc_ctx(&seg->hash_ctx, TEE_ALG_SHA256);
+		if (res)
+			return res;
+
+		res = crypto_hash_init(seg->hash_ctx);
+		if (res)
+			goto out;
+
+		seg->da = da;
+	} else if (!seg->hash_ctx || da != seg->da + seg->size) {
+		/* The chunks must be contiguous from the first one */
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	/* Get the physical address in A7 mapping */
+	res = da_to_pa(da, size, &pa);
+	if (res)
+		goto out;
+
+	/* Get the associated va */
+	dst = (void *)core_mmu_get_va(pa, MEM_AREA_IO_SEC);
+
+	/*
+	 * Copy the chunk to the remote processor memory and hash what has
+	 * been copied, not the non-secure source which could change.
+	 */
+	for (offs = 0; offs < size; offs += n) {
+		n = MIN(size - offs, (size_t)LOAD_BLOCK_SIZE);
+		memcpy(dst + offs, src + offs, n);
+		seg->size += n;
+
+		res = crypto_hash_update(seg->hash_ctx, dst + offs, n);
+		if (res)
+			goto out;
+	}
+
+	if (!(flags & PTA_REMOTEPROC_CHUNK_LAST))
+		return TEE_SUCCESS;
+
+	/* Verify that loaded segment is valid */
+	res = crypto_hash_final(seg->hash_ctx, digest, sizeof(digest));
+	if (!res && consttime_memcmp(digest, hash, sizeof(digest)))
+		res = TEE_ERROR_SECURITY;
+
+out:
+	rproc_pta_seg_load_release(res != TEE_SUCCESS);
+
+	return res;
+}
+
 static TEE_Result rproc_pta_set_memory(uint32_t pt,
 				       TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -324,6 +447,9 @@ static TEE_Result rproc_pta_start(uint32_t pt,
 	if (rproc_ta_state != REMOTEPROC_OFF)
 		return TEE_ERROR_BAD_STATE;
 
+	/* A segment partially loaded can't be completed once started */
+	rproc_pta_seg_load_release(true);
+
 	clk_enable(CK_MCU);
 
 	/* Configure the Cortex-M4 RAMs as expected to run the firmware */
@@ -477,6 +603,8 @@ static TEE_Result rproc_pta_invoke_command(void *pSessionContext __unused,
 		return rproc_pta_da_to_pa(param_types, params);
 	case PTA_REMOTEPROC_VERIFY_DIGEST:
 		return rproc_pta_verify_digest(param_types, params);
+	case PTA_REMOTEPROC_LOAD_SEGMENT_CHUNK_SHA256:
+		return rproc_pta_load_segment_chunk(param_types, params);
 	default:
 		break;
 	}
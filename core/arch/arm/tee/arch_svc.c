@@ -121,6 +121,15 @@ static const struct syscall_entry tee_svc_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_cipher_update_vec),
+	SYSCALL_ENTRY(syscall_authenc_update_payload_vec),
+	SYSCALL_ENTRY(syscall_asymm_verify_batch),
+	SYSCALL_ENTRY(syscall_storage_tx_begin),
+	SYSCALL_ENTRY(syscall_storage_tx_commit),
+	SYSCALL_ENTRY(syscall_storage_next_enum_batch),
+	SYSCALL_ENTRY(syscall_cryp_obj_populate_batch),
+	SYSCALL_ENTRY(syscall_get_time_page),
+	SYSCALL_ENTRY(syscall_get_property_set),
 };
 
 /*
@@ -277,6 +286,69 @@ bool user_ta_handle_svc(struct thread_svc_regs *regs)
 	return scn != TEE_SCN_RETURN && scn != TEE_SCN_PANIC;
 }
 
+#ifdef ARM32
+static unsigned long get_svc_arg(struct thread_svc_regs *regs, unsigned int n)
+{
+	const uint32_t args[] = { regs->r0, regs->r1, regs->r2, regs->r3 };
+
+	return args[n];
+}
+#endif /*ARM32*/
+
+#ifdef ARM64
+static unsigned long get_svc_arg(struct thread_svc_regs *regs, unsigned int n)
+{
+	const uint64_t args[] = { regs->x0, regs->x1, regs->x2, regs->x3 };
+
+	/* The upper halves aren't defined when called from AArch32 */
+	if (((regs->spsr >> SPSR_MODE_RW_SHIFT) & SPSR_MODE_RW_MASK) ==
+	     SPSR_MODE_RW_32)
+		return (uint32_t)args[n];
+	return args[n];
+}
+#endif /*ARM64*/
+
+bool user_ta_handle_fast_svc(struct thread_svc_regs *regs)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t max_args = 0;
+	size_t scn = 0;
+
+	get_scn_max_args(regs, &scn, &max_args);
+	if (max_args)
+		return false;
+
+	/*
+	 * These syscalls are called directly, skipping the tracing and
+	 * the generic copying of arguments. REE time and TA persistent
+	 * time may need RPC so only system time is handled here.
+	 */
+	switch (scn) {
+	case TEE_SCN_GET_CANCELLATION_FLAG:
+		res = syscall_get_cancellation_flag((void *)get_svc_arg(regs,
+									0));
+		break;
+	case TEE_SCN_UNMASK_CANCELLATION:
+		res = syscall_unmask_cancellation((void *)get_svc_arg(regs, 0));
+		break;
+	case TEE_SCN_MASK_CANCELLATION:
+		res = syscall_mask_cancellation((void *)get_svc_arg(regs, 0));
+		break;
+	case TEE_SCN_GET_TIME:
+		if (get_svc_arg(regs, 0) != UTEE_TIME_CAT_SYSTEM)
+			return false;
+		res = syscall_get_time(UTEE_TIME_CAT_SYSTEM,
+				       (void *)get_svc_arg(regs, 1));
+		break;
+	default:
+		return false;
+	}
+
+	set_svc_retval(regs, res);
+
+	return true;
+}
+
 static syscall_t get_ldelf_syscall_func(size_t num)
 {
 	/* Cast away const */
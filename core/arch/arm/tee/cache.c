@@ -4,9 +4,12 @@
  * Copyright (c) 2015, Linaro Limited
  */
 
+#include <arm.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <string.h>
 #include <tee/cache.h>
+#include <util.h>
 
 /*
  * tee_uta_cache_operation - dynamic cache clean/inval request from a TA.
@@ -55,3 +58,154 @@ TEE_Result cache_operation(enum utee_cache_operation op, void *va, size_t len)
 		return TEE_ERROR_NOT_SUPPORTED;
 	}
 }
+
+static size_t dcache_line_size(void)
+{
+#ifdef ARM64
+	uint32_t ctr = read_ctr_el0();
+#else
+	uint32_t ctr = read_ctr();
+#endif
+
+	return CTR_WORD_SIZE << ((ctr >> CTR_DMINLINE_SHIFT) &
+				 CTR_DMINLINE_MASK);
+}
+
+void cache_op_batch_init(struct cache_op_batch *batch,
+			 enum utee_cache_operation op)
+{
+	memset(batch, 0, sizeof(*batch));
+	batch->op = op;
+}
+
+static bool same_offset(vaddr_t va, paddr_t pa, vaddr_t va2, paddr_t pa2)
+{
+	if (va >= va2)
+		return pa >= pa2 && pa - pa2 == va - va2;
+
+	return pa < pa2 && pa2 - pa == va2 - va;
+}
+
+static bool merge_range(struct cache_op_batch *batch, vaddr_t va,
+			paddr_t pa, size_t len)
+{
+	vaddr_t line_mask = dcache_line_size() - 1;
+	vaddr_t end = va + len;
+	vaddr_t r_end = 0;
+	size_t n = 0;
+
+	for (n = 0; n < batch->count; n++) {
+		vaddr_t r_va = batch->range[n].va;
+
+		r_end = r_va + batch->range[n].len;
+		/* Compare whole cache lines, a partial one is done anyway */
+		if ((va & ~line_mask) > ROUNDUP(r_end, line_mask + 1) ||
+		    (r_va & ~line_mask) > ROUNDUP(end, line_mask + 1))
+			continue;
+		/* The outer cache is maintained by physical address */
+		if (!same_offset(va, pa, r_va, batch->range[n].pa))
+			continue;
+
+		if (va < r_va) {
+			batch->range[n].va = va;
+			batch->range[n].pa = pa;
+		}
+		batch->range[n].len = MAX(end, r_end) - batch->range[n].va;
+		return true;
+	}
+
+	return false;
+}
+
+TEE_Result cache_op_batch_add(struct cache_op_batch *batch, void *va,
+			      size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t end = 0;
+	paddr_t pa = 0;
+
+	if (!len)
+		return TEE_SUCCESS;
+	if (ADD_OVERFLOW((vaddr_t)va, len, &end))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pa = virt_to_phys(va);
+	if (!pa)
+		return TEE_ERROR_ACCESS_DENIED;
+
+	if (merge_range(batch, (vaddr_t)va, pa, len))
+		return TEE_SUCCESS;
+
+	if (batch->count == ARRAY_SIZE(batch->range)) {
+		res = cache_op_batch_flush(batch);
+		if (res)
+			return res;
+	}
+
+	batch->range[batch->count].va = (vaddr_t)va;
+	batch->range[batch->count].pa = pa;
+	batch->range[batch->count].len = len;
+	batch->count++;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Cleans the whole data cache by set/way instead of each range, only the
+ * caches of the local CPU are maintained that way.
+ */
+static TEE_Result batch_op_all(struct cache_op_batch *batch)
+{
+	enum cache_op outer_op = DCACHE_AREA_CLEAN;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (batch->op == TEE_CACHEFLUSH)
+		outer_op = DCACHE_AREA_CLEAN_INV;
+
+	/* Same sequence as cache_operation() */
+	res = cache_op_inner(DCACHE_CLEAN, NULL, 0);
+	for (n = 0; !res && n < batch->count; n++)
+		res = cache_op_outer(outer_op, batch->range[n].pa,
+				     batch->range[n].len);
+	if (!res && batch->op == TEE_CACHEFLUSH)
+		res = cache_op_inner(DCACHE_CLEAN_INV, NULL, 0);
+	batch->count = 0;
+
+	return res;
+}
+
+static bool use_op_all(struct cache_op_batch *batch)
+{
+	size_t threshold = CFG_CORE_CACHE_OP_ALL_THRESHOLD;
+	size_t total = 0;
+	size_t n = 0;
+
+	if (!threshold ||
+	    (batch->op != TEE_CACHECLEAN && batch->op != TEE_CACHEFLUSH))
+		return false;
+
+	for (n = 0; n < batch->count; n++)
+		total += batch->range[n].len;
+
+	return total >= threshold;
+}
+
+TEE_Result cache_op_batch_flush(struct cache_op_batch *batch)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (use_op_all(batch))
+		return batch_op_all(batch);
+
+	for (n = 0; n < batch->count; n++) {
+		res = cache_operation(batch->op, (void *)batch->range[n].va,
+				      batch->range[n].len);
+		if (res)
+			break;
+	}
+	batch->count = 0;
+
+	return res;
+}
@@ -4,6 +4,7 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <config.h>
 #include <tee/entry_fast.h>
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
@@ -11,7 +12,9 @@
 #include <kernel/tee_l2cc_mutex.h>
 #include <kernel/virtualization.h>
 #include <kernel/misc.h>
+#include <kernel/notif.h>
 #include <mm/core_mmu.h>
+#include <tee/entry_std.h>
 
 #ifdef CFG_CORE_RESERVED_SHM
 static void tee_entry_get_shm_config(struct thread_smc_args *args)
@@ -77,11 +80,19 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 	 * OPTEE_SMC_NSEC_CAP_UNIPROCESSOR.
 	 */
 
-	if (args->a1 & ~OPTEE_SMC_NSEC_CAP_UNIPROCESSOR) {
+	uint32_t nsec_caps = OPTEE_SMC_NSEC_CAP_UNIPROCESSOR;
+
+	if (IS_ENABLED(CFG_CORE_RPC_AFFINITY))
+		nsec_caps |= OPTEE_SMC_NSEC_CAP_RPC_AFFINITY;
+
+	if (args->a1 & ~nsec_caps) {
 		/* Unknown capability. */
 		args->a0 = OPTEE_SMC_RETURN_ENOTAVAIL;
 		return;
 	}
+#ifdef CFG_CORE_RPC_AFFINITY
+	thread_set_rpc_affinity(args->a1 & OPTEE_SMC_NSEC_CAP_RPC_AFFINITY);
+#endif
 
 	args->a0 = OPTEE_SMC_RETURN_OK;
 	args->a1 = 0;
@@ -92,6 +103,18 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 	args->a1 |= OPTEE_SMC_SEC_CAP_VIRTUALIZATION;
 #endif
 	args->a1 |= OPTEE_SMC_SEC_CAP_MEMREF_NULL;
+#ifdef CFG_CORE_MULTI_INVOKE
+	args->a1 |= OPTEE_SMC_SEC_CAP_MULTI_INVOKE;
+#endif
+#ifdef CFG_CORE_MSG_RING
+	args->a1 |= OPTEE_SMC_SEC_CAP_MSG_RING;
+#endif
+#ifdef CFG_CORE_RPC_AFFINITY
+	args->a1 |= OPTEE_SMC_SEC_CAP_RPC_AFFINITY;
+#endif
+#ifdef CFG_CORE_ASYNC_NOTIF
+	args->a1 |= OPTEE_SMC_SEC_CAP_ASYNC_NOTIF;
+#endif
 
 #if defined(CFG_CORE_DYN_SHM)
 	dyn_shm_en = core_mmu_nsec_ddr_is_defined();
@@ -147,6 +170,24 @@ static void tee_entry_get_thread_count(struct thread_smc_args *args)
 	args->a1 = CFG_NUM_THREADS;
 }
 
+#ifdef CFG_CORE_MSG_RING
+static void tee_entry_register_ring(struct thread_smc_args *args)
+{
+	paddr_t pa = reg_pair_to_64(args->a1, args->a2);
+
+	args->a0 = tee_entry_std_register_ring(pa, args->a3);
+}
+#endif
+
+#ifdef CFG_CORE_ASYNC_NOTIF
+static void tee_entry_register_notif(struct thread_smc_args *args)
+{
+	paddr_t pa = reg_pair_to_64(args->a1, args->a2);
+
+	args->a0 = notif_register_async(pa, args->a3);
+}
+#endif
+
 #if defined(CFG_VIRTUALIZATION)
 static void tee_entry_vm_created(struct thread_smc_args *args)
 {
@@ -158,7 +199,7 @@ static void tee_entry_vm_created(struct thread_smc_args *args)
 		return;
 	}
 
-	args->a0 = virt_guest_created(guest_id);
+	args->a0 = virt_guest_created(guest_id, args->a2);
 }
 
 static void tee_entry_vm_destroyed(struct thread_smc_args *args)
@@ -230,6 +271,16 @@ void __tee_entry_fast(struct thread_smc_args *args)
 	case OPTEE_SMC_GET_THREAD_COUNT:
 		tee_entry_get_thread_count(args);
 		break;
+#ifdef CFG_CORE_MSG_RING
+	case OPTEE_SMC_REGISTER_RING:
+		tee_entry_register_ring(args);
+		break;
+#endif
+#ifdef CFG_CORE_ASYNC_NOTIF
+	case OPTEE_SMC_REGISTER_NOTIF:
+		tee_entry_register_notif(args);
+		break;
+#endif
 
 #if defined(CFG_VIRTUALIZATION)
 	case OPTEE_SMC_VM_CREATED:
@@ -258,6 +309,12 @@ size_t tee_entry_generic_get_api_call_count(void)
 #if defined(CFG_VIRTUALIZATION)
 	ret += 2;
 #endif
+#ifdef CFG_CORE_MSG_RING
+	ret += 1;
+#endif
+#ifdef CFG_CORE_ASYNC_NOTIF
+	ret += 1;
+#endif
 
 	return ret;
 }
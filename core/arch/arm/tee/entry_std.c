@@ -5,19 +5,23 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <bench.h>
 #include <compiler.h>
 #include <initcall.h>
 #include <io.h>
+#include <kernel/interrupt.h>
 #include <kernel/linker.h>
 #include <kernel/msg_param.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_misc.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tee/entry_std.h>
 #include <tee/tee_cryp_utl.h>
@@ -435,6 +439,7 @@ static void entry_invoke_command(struct optee_msg_arg *arg, uint32_t num_params)
 		res = TEE_ERROR_BAD_PARAMETERS;
 		goto out;
 	}
+	bm_tracepoint(BENCH_TP_SESSION_FOUND);
 
 	res = tee_ta_invoke_command(&err_orig, s, NSAPP_IDENTITY,
 				    TEE_TIMEOUT_INFINITE, arg->func, &param);
@@ -477,6 +482,305 @@ out:
 	arg->ret_origin = err_orig;
 }
 
+#ifdef CFG_CORE_MULTI_INVOKE
+static TEE_Result get_multi_invoke_buf(struct optee_msg_param *param,
+				       struct param_mem *mem)
+{
+	uint64_t attr = READ_ONCE(param->attr);
+
+	switch (attr) {
+#ifdef CFG_CORE_FFA
+	case OPTEE_MSG_ATTR_TYPE_FMEM_INOUT:
+		return set_fmem_param(&param->u.fmem, mem);
+#else
+	case OPTEE_MSG_ATTR_TYPE_TMEM_INOUT:
+	case OPTEE_MSG_ATTR_TYPE_TMEM_INOUT | OPTEE_MSG_ATTR_NONCONTIG:
+		return set_tmem_param(&param->u.tmem, attr, mem);
+#ifdef CFG_CORE_DYN_SHM
+	case OPTEE_MSG_ATTR_TYPE_RMEM_INOUT:
+		return set_rmem_param(&param->u.rmem, mem);
+#endif
+#endif
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+/*
+ * Processes the struct optee_msg_arg entries found in the buffer supplied
+ * in param[1] back-to-back. The entries reside in non-secure shared
+ * memory and are handled in place the same way as the struct
+ * optee_msg_arg passed with OPTEE_SMC_CALL_WITH_ARG.
+ */
+static void entry_multi_invoke(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	const uint32_t req_attr = OPTEE_MSG_ATTR_META |
+				  OPTEE_MSG_ATTR_TYPE_VALUE_INOUT;
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct param_mem mem = { };
+	bool did_map = false;
+	uint8_t *buf = NULL;
+	size_t num_entries = 0;
+	size_t offs = 0;
+	size_t n = 0;
+
+	if (num_params != 2 || READ_ONCE(arg->params[0].attr) != req_attr)
+		goto out;
+
+	num_entries = READ_ONCE(arg->params[0].u.value.a);
+	arg->params[0].u.value.b = 0;
+
+	res = get_multi_invoke_buf(arg->params + 1, &mem);
+	if (res)
+		goto out;
+
+	res = TEE_ERROR_BAD_PARAMETERS;
+	if (!mem.mobj || !mem.size)
+		goto out;
+
+	if (mobj_inc_map(mem.mobj))
+		goto out;
+	did_map = true;
+
+	buf = mobj_get_va(mem.mobj, mem.offs);
+	if (!buf || !mobj_get_va(mem.mobj, mem.offs + mem.size - 1) ||
+	    !ALIGNMENT_IS_OK(buf, struct optee_msg_arg))
+		goto out;
+
+	for (n = 0; n < num_entries; n++) {
+		struct optee_msg_arg *e = (void *)(buf + offs);
+		uint32_t e_num_params = 0;
+		size_t e_size = 0;
+
+		if (mem.size - offs < sizeof(*e))
+			goto out;
+
+		e_num_params = READ_ONCE(e->num_params);
+		if (e_num_params > TEE_NUM_PARAMS)
+			goto out;
+
+		e_size = OPTEE_MSG_GET_ARG_SIZE(e_num_params);
+		if (mem.size - offs < e_size)
+			goto out;
+
+		if (READ_ONCE(e->cmd) != OPTEE_MSG_CMD_INVOKE_COMMAND)
+			goto out;
+
+		entry_invoke_command(e, e_num_params);
+		arg->params[0].u.value.b = n + 1;
+		offs += e_size;
+	}
+
+	res = TEE_SUCCESS;
+out:
+	if (did_map)
+		mobj_dec_map(mem.mobj);
+	mobj_put(mem.mobj);
+
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+#endif /*CFG_CORE_MULTI_INVOKE*/
+
+#ifdef CFG_CORE_MSG_RING
+/*
+ * State of the ring registered with OPTEE_SMC_REGISTER_RING. The indexes
+ * owned by secure world are kept here and only copied to the shared ring
+ * header, the values written by normal world are read once and never
+ * trusted beyond selecting an entry inside the ring.
+ */
+struct msg_ring {
+	struct mobj *mobj;
+	struct optee_msg_ring *hdr;
+	struct optee_msg_ring_sqe *sq;
+	struct optee_msg_ring_cqe *cq;
+	uint32_t num_entries;
+	uint32_t sq_head;
+	uint32_t cq_tail;
+	uint32_t in_flight;
+	unsigned int num_workers;
+	unsigned int lock;
+};
+
+static struct msg_ring msg_ring = { .lock = SPINLOCK_UNLOCK };
+
+static struct mobj *map_ring(paddr_t pa, size_t size)
+{
+	struct mobj *mobj = NULL;
+	paddr_t *pages = NULL;
+	size_t num_pages = 0;
+	size_t n = 0;
+
+	if (core_pbuf_is(CORE_MEM_NSEC_SHM, pa, size))
+		return mobj_shm_alloc(pa, size, 0);
+
+#ifdef CFG_CORE_DYN_SHM
+	num_pages = ROUNDUP(size, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
+	pages = calloc(num_pages, sizeof(*pages));
+	if (!pages)
+		return NULL;
+	for (n = 0; n < num_pages; n++)
+		pages[n] = pa + n * SMALL_PAGE_SIZE;
+	/* mobj_mapped_shm_alloc() checks that the pages are non-secure */
+	mobj = mobj_mapped_shm_alloc(pages, num_pages, 0, 0);
+	free(pages);
+#endif
+
+	return mobj;
+}
+
+uint32_t tee_entry_std_register_ring(paddr_t pa, size_t size)
+{
+	struct optee_msg_ring *hdr = NULL;
+	struct mobj *old_mobj = NULL;
+	struct mobj *mobj = NULL;
+	uint32_t num_entries = 0;
+	uint32_t exceptions = 0;
+
+	if (pa) {
+		if ((pa & SMALL_PAGE_MASK) || size < sizeof(*hdr))
+			return OPTEE_SMC_RETURN_EBADADDR;
+
+		mobj = map_ring(pa, size);
+		if (!mobj)
+			return OPTEE_SMC_RETURN_EBADADDR;
+		hdr = mobj_get_va(mobj, 0);
+		if (!hdr || !mobj_get_va(mobj, size - 1))
+			goto err;
+
+		num_entries = READ_ONCE(hdr->num_entries);
+		if (!num_entries || !IS_POWER_OF_TWO(num_entries) ||
+		    size < OPTEE_MSG_RING_SIZE(num_entries))
+			goto err;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&msg_ring.lock);
+	if (msg_ring.num_workers) {
+		cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+		mobj_put(mobj);
+		return OPTEE_SMC_RETURN_EBUSY;
+	}
+
+	old_mobj = msg_ring.mobj;
+	msg_ring.mobj = mobj;
+	msg_ring.hdr = hdr;
+	msg_ring.num_entries = num_entries;
+	msg_ring.sq = NULL;
+	msg_ring.cq = NULL;
+	if (hdr) {
+		msg_ring.sq = (void *)(hdr + 1);
+		msg_ring.cq = (void *)(msg_ring.sq + num_entries);
+		msg_ring.sq_head = READ_ONCE(hdr->sq_head);
+		msg_ring.cq_tail = READ_ONCE(hdr->cq_tail);
+	}
+	msg_ring.in_flight = 0;
+	cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+
+	mobj_put(old_mobj);
+
+	return OPTEE_SMC_RETURN_OK;
+err:
+	mobj_put(mobj);
+	return OPTEE_SMC_RETURN_EBADADDR;
+}
+
+/*
+ * Takes the next submission entry if there's one and there's room for
+ * its completion. Must be called with msg_ring.lock held.
+ */
+static bool ring_take_sqe(uint32_t *idx)
+{
+	struct optee_msg_ring *hdr = msg_ring.hdr;
+	uint32_t sq_tail = READ_ONCE(hdr->sq_tail);
+	uint32_t cq_used = msg_ring.cq_tail - READ_ONCE(hdr->cq_head);
+
+	if (sq_tail == msg_ring.sq_head ||
+	    sq_tail - msg_ring.sq_head > msg_ring.num_entries)
+		return false;
+	if (cq_used > msg_ring.num_entries ||
+	    cq_used + msg_ring.in_flight >= msg_ring.num_entries)
+		return false;
+
+	*idx = msg_ring.sq_head & (msg_ring.num_entries - 1);
+	msg_ring.sq_head++;
+	msg_ring.in_flight++;
+	atomic_store_u32(&hdr->sq_head, msg_ring.sq_head);
+
+	return true;
+}
+
+/* Must be called with msg_ring.lock held */
+static void ring_post_cqe(uint32_t idx, uint64_t user_data,
+			  struct optee_msg_arg *arg)
+{
+	struct optee_msg_ring_cqe *cqe = NULL;
+
+	cqe = msg_ring.cq + (msg_ring.cq_tail & (msg_ring.num_entries - 1));
+	cqe->user_data = user_data;
+	cqe->sqe_index = idx;
+	cqe->ret = arg->ret;
+	cqe->ret_origin = arg->ret_origin;
+
+	/* The entry must be visible before the updated tail */
+	dsb_ish();
+
+	msg_ring.cq_tail++;
+	msg_ring.in_flight--;
+	atomic_store_u32(&msg_ring.hdr->cq_tail, msg_ring.cq_tail);
+}
+
+static void entry_process_ring(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	uint32_t exceptions = 0;
+	uint32_t idx = 0;
+
+	if (num_params) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&msg_ring.lock);
+	if (!msg_ring.hdr) {
+		cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+		arg->ret = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+	msg_ring.num_workers++;
+
+	while (ring_take_sqe(&idx)) {
+		struct optee_msg_ring_sqe *sqe = msg_ring.sq + idx;
+		struct optee_msg_arg *sarg = (void *)sqe->arg;
+		uint64_t user_data = READ_ONCE(sqe->user_data);
+		uint32_t sarg_num_params = READ_ONCE(sarg->num_params);
+
+		cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+
+		if (sarg_num_params > OPTEE_MSG_RING_NUM_PARAMS ||
+		    READ_ONCE(sarg->cmd) != OPTEE_MSG_CMD_INVOKE_COMMAND) {
+			sarg->ret = TEE_ERROR_BAD_PARAMETERS;
+			sarg->ret_origin = TEE_ORIGIN_TEE;
+		} else {
+			entry_invoke_command(sarg, sarg_num_params);
+		}
+
+		exceptions = cpu_spin_lock_xsave(&msg_ring.lock);
+		ring_post_cqe(idx, user_data, sarg);
+		cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+
+		if (CFG_CORE_MSG_RING_NOTIF_IT)
+			itr_raise_pi(CFG_CORE_MSG_RING_NOTIF_IT);
+
+		exceptions = cpu_spin_lock_xsave(&msg_ring.lock);
+	}
+
+	msg_ring.num_workers--;
+	cpu_spin_unlock_xrestore(&msg_ring.lock, exceptions);
+	arg->ret = TEE_SUCCESS;
+out:
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+#endif /*CFG_CORE_MSG_RING*/
+
 #ifndef CFG_CORE_FFA
 #ifdef CFG_CORE_DYN_SHM
 static void register_shm(struct optee_msg_arg *arg, uint32_t num_params)
@@ -551,6 +855,16 @@ uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 	case OPTEE_MSG_CMD_CANCEL:
 		entry_cancel(arg, num_params);
 		break;
+#ifdef CFG_CORE_MULTI_INVOKE
+	case OPTEE_MSG_CMD_MULTI_INVOKE:
+		entry_multi_invoke(arg, num_params);
+		break;
+#endif
+#ifdef CFG_CORE_MSG_RING
+	case OPTEE_MSG_CMD_PROCESS_RING:
+		entry_process_ring(arg, num_params);
+		break;
+#endif
 #ifndef CFG_CORE_FFA
 #ifdef CFG_CORE_DYN_SHM
 	case OPTEE_MSG_CMD_REGISTER_SHM:
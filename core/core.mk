@@ -142,6 +142,13 @@ libdir = core/lib/zlib
 include mk/lib.mk
 endif
 
+ifeq (y,$(filter y,$(CFG_PAGER_RWP_COMPRESS) $(CFG_EARLY_TA_COMPRESS_LZ) \
+		  $(CFG_REE_FS_COMPRESS)))
+libname = lz
+libdir = core/lib/lz
+include mk/lib.mk
+endif
+
 libname = unw
 libdir = lib/libunw
 include mk/lib.mk
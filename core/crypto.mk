@@ -40,9 +40,19 @@ CFG_CRYPTO_DH ?= y
 # ECC includes ECDSA and ECDH
 CFG_CRYPTO_ECC ?= y
 ifeq ($(CFG_CRYPTOLIB_NAME),tomcrypt)
+# Keep a precomputed comb table of each curve generator that has been used
+# to speed up ECC key generation and ECDSA signing
+CFG_CRYPTO_ECC_FIXED_BASE ?= y
+# Keep the Montgomery constant of the moduli of RSA, DH and DSA keys
+# (including the CRT primes of RSA keys) between operations with the key
+CFG_CRYPTO_MONT_CACHE ?= y
 CFG_CRYPTO_SM2_PKE ?= y
 CFG_CRYPTO_SM2_DSA ?= y
 CFG_CRYPTO_SM2_KEP ?= y
+# X25519 key agreement and Ed25519 signatures with a radix 2^51 field
+# arithmetic on 64-bit CPUs
+CFG_CRYPTO_X25519 ?= y
+CFG_CRYPTO_ED25519 ?= y
 endif
 ifeq ($(CFG_CRYPTOLIB_NAME)-$(CFG_CRYPTO_SM2_PKE),mbedtls-y)
 $(error Error: CFG_CRYPTO_SM2_PKE=y requires CFG_CRYPTOLIB_NAME=tomcrypt)
@@ -53,12 +63,26 @@ endif
 ifeq ($(CFG_CRYPTOLIB_NAME)-$(CFG_CRYPTO_SM2_KEP),mbedtls-y)
 $(error Error: CFG_CRYPTO_SM2_KEP=y requires CFG_CRYPTOLIB_NAME=tomcrypt)
 endif
+ifeq ($(CFG_CRYPTOLIB_NAME)-$(CFG_CRYPTO_X25519),mbedtls-y)
+$(error Error: CFG_CRYPTO_X25519=y requires CFG_CRYPTOLIB_NAME=tomcrypt)
+endif
+ifeq ($(CFG_CRYPTOLIB_NAME)-$(CFG_CRYPTO_ED25519),mbedtls-y)
+$(error Error: CFG_CRYPTO_ED25519=y requires CFG_CRYPTOLIB_NAME=tomcrypt)
+endif
 
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
 CFG_CRYPTO_GCM ?= y
 # Default uses the OP-TEE internal AES-GCM implementation
 CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB ?= n
+# ChaCha20-Poly1305 (RFC 8439), much faster than the AES based modes on
+# cores without the Cryptographic Extensions
+ifeq ($(CFG_CRYPTOLIB_NAME),tomcrypt)
+CFG_CRYPTO_CHACHA20_POLY1305 ?= y
+endif
+ifeq ($(CFG_CRYPTOLIB_NAME)-$(CFG_CRYPTO_CHACHA20_POLY1305),mbedtls-y)
+$(error Error: CFG_CRYPTO_CHACHA20_POLY1305=y requires CFG_CRYPTOLIB_NAME=tomcrypt)
+endif
 
 endif
 
@@ -87,6 +111,18 @@ CFG_CRYPTO_SHA1_ARM_CE ?= $(CFG_CRYPTO_SHA1)
 CFG_CORE_CRYPTO_SHA1_ACCEL ?= $(CFG_CRYPTO_SHA1_ARM_CE)
 CFG_CRYPTO_AES_ARM_CE ?= $(CFG_CRYPTO_AES)
 CFG_CORE_CRYPTO_AES_ACCEL ?= $(CFG_CRYPTO_AES_ARM_CE)
+# The SHA-512 instructions are only available in AArch64 and are optional
+# from ARMv8.2, without them the software implementation is used instead.
+ifeq ($(CFG_ARM64_core),y)
+CFG_CRYPTO_SHA512_ARM_CE ?= $(call cfg-one-enabled, CFG_CRYPTO_SHA384 \
+				    CFG_CRYPTO_SHA512 CFG_CRYPTO_SHA512_256)
+CFG_CORE_CRYPTO_SHA512_ACCEL ?= $(CFG_CRYPTO_SHA512_ARM_CE)
+# Same for the SM3 and SM4 instructions
+CFG_CRYPTO_SM3_ARM_CE ?= $(CFG_CRYPTO_SM3)
+CFG_CORE_CRYPTO_SM3_ACCEL ?= $(CFG_CRYPTO_SM3_ARM_CE)
+CFG_CRYPTO_SM4_ARM_CE ?= $(CFG_CRYPTO_SM4)
+CFG_CORE_CRYPTO_SM4_ACCEL ?= $(CFG_CRYPTO_SM4_ARM_CE)
+endif
 
 else #CFG_CRYPTO_WITH_CE
 
@@ -94,6 +130,35 @@ CFG_AES_GCM_TABLE_BASED ?= y
 
 endif #!CFG_CRYPTO_WITH_CE
 
+# CFG_TA_CRYPTO_ARM_CE lets libutee run AES ECB/CBC/CTR and SHA-256 in user
+# mode with the CE instructions, sparing a system call per update. Only used
+# for keys with TEE_USAGE_EXTRACTABLE since the key is read back by the TA,
+# other keys and algorithms stay in the core.
+CFG_TA_CRYPTO_ARM_CE ?= n
+ifeq ($(CFG_TA_CRYPTO_ARM_CE),y)
+ifneq ($(CFG_CRYPTO_WITH_CE)-$(CFG_TA_FLOAT_SUPPORT),y-y)
+$(error CFG_TA_CRYPTO_ARM_CE requires CFG_CRYPTO_WITH_CE=y and CFG_TA_FLOAT_SUPPORT=y)
+endif
+endif
+
+# CFG_TA_MBEDTLS_ARM_CE replaces the AES block functions and the SHA-1 and
+# SHA-256 transforms of the mbedTLS library of the TAs with the CE
+# instructions, using the same assembly built into libutee.
+CFG_TA_MBEDTLS_ARM_CE ?= n
+ifeq ($(CFG_TA_MBEDTLS_ARM_CE),y)
+ifneq ($(CFG_CRYPTO_WITH_CE)-$(CFG_TA_FLOAT_SUPPORT),y-y)
+$(error CFG_TA_MBEDTLS_ARM_CE requires CFG_CRYPTO_WITH_CE=y and CFG_TA_FLOAT_SUPPORT=y)
+endif
+endif
+
+# ChaCha20 only needs Advanced SIMD (NEON), which AArch64 and all the ARMv8
+# cores have. ARMv7 platforms with NEON may set CFG_CRYPTO_CHACHA20_ARM_NEON=y.
+ifneq (,$(filter y,$(CFG_ARM64_core) $(CFG_CRYPTO_WITH_CE)))
+CFG_CRYPTO_CHACHA20_ARM_NEON ?= $(CFG_CRYPTO_CHACHA20_POLY1305)
+endif
+CFG_CRYPTO_CHACHA20_ARM_NEON ?= n
+CFG_CORE_CRYPTO_CHACHA20_ACCEL ?= $(CFG_CRYPTO_CHACHA20_ARM_NEON)
+
 
 # Cryptographic extensions can only be used safely when OP-TEE knows how to
 # preserve the VFP context
@@ -109,10 +174,23 @@ endif
 ifeq ($(CFG_CRYPTO_AES_ARM_CE),y)
 $(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_AES_ARM_CE)
 endif
+ifeq ($(CFG_CRYPTO_SHA512_ARM_CE),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SHA512_ARM_CE)
+endif
+ifeq ($(CFG_CRYPTO_SM3_ARM_CE),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SM3_ARM_CE)
+endif
+ifeq ($(CFG_CRYPTO_SM4_ARM_CE),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SM4_ARM_CE)
+endif
+ifeq ($(CFG_CRYPTO_CHACHA20_ARM_NEON),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_CHACHA20_ARM_NEON)
+endif
 
 cryp-enable-all-depends = $(call cfg-enable-all-depends,$(strip $(1)),$(foreach v,$(2),CFG_CRYPTO_$(v)))
 $(eval $(call cryp-enable-all-depends,CFG_REE_FS, AES ECB CTR HMAC SHA256 GCM))
 $(eval $(call cryp-enable-all-depends,CFG_RPMB_FS, AES ECB CTR HMAC SHA256 GCM))
+$(eval $(call cryp-enable-all-depends,CFG_REE_FS_HTREE_CHACHA20_POLY1305, CHACHA20_POLY1305))
 
 # Dependency checks: warn and disable some features if dependencies are not met
 
@@ -139,6 +217,9 @@ $(eval $(call cryp-dep-one, DES, ECB CBC))
 $(eval $(call cryp-dep-one, SM2_PKE, ECC))
 $(eval $(call cryp-dep-one, SM2_DSA, ECC))
 $(eval $(call cryp-dep-one, SM2_KEP, ECC))
+# Ed25519 hashes with SHA-512, X25519 shares its source file with Ed25519
+$(eval $(call cryp-dep-one, ED25519, SHA512))
+$(eval $(call cryp-dep-one, X25519, SHA512))
 
 ###############################################################
 # libtomcrypt (LTC) specifics, phase #1
@@ -164,17 +245,21 @@ core-ltc-vars += CCM
 ifeq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
 core-ltc-vars += GCM
 endif
-core-ltc-vars += RSA DSA DH ECC
+core-ltc-vars += RSA DSA DH ECC ECC_FIXED_BASE MONT_CACHE
 core-ltc-vars += SIZE_OPTIMIZATION
 core-ltc-vars += SM2_PKE
 core-ltc-vars += SM2_DSA
 core-ltc-vars += SM2_KEP
+core-ltc-vars += X25519
+core-ltc-vars += ED25519
+core-ltc-vars += CHACHA20_POLY1305
 # Assigned selected CFG_CRYPTO_xxx as _CFG_CORE_LTC_xxx
 $(foreach v, $(core-ltc-vars), $(eval _CFG_CORE_LTC_$(v) := $(CFG_CRYPTO_$(v))))
 _CFG_CORE_LTC_MPI := $(CFG_CORE_MBEDTLS_MPI)
 _CFG_CORE_LTC_AES_ACCEL := $(CFG_CORE_CRYPTO_AES_ACCEL)
 _CFG_CORE_LTC_SHA1_ACCEL := $(CFG_CORE_CRYPTO_SHA1_ACCEL)
 _CFG_CORE_LTC_SHA256_ACCEL := $(CFG_CORE_CRYPTO_SHA256_ACCEL)
+_CFG_CORE_LTC_CHACHA20_ACCEL := $(CFG_CORE_CRYPTO_CHACHA20_ACCEL)
 endif
 
 ###############################################################
@@ -219,13 +304,17 @@ _CFG_CORE_LTC_HWSUPP_PMULL := $(CFG_HWSUPP_PMULL)
 
 # Assign aggregated variables
 ltc-one-enabled = $(call cfg-one-enabled,$(foreach v,$(1),_CFG_CORE_LTC_$(v)))
-_CFG_CORE_LTC_ACIPHER := $(call ltc-one-enabled, RSA DSA DH ECC)
-_CFG_CORE_LTC_AUTHENC := $(and $(filter y,$(_CFG_CORE_LTC_AES_DESC)), \
+_CFG_CORE_LTC_ACIPHER := $(call ltc-one-enabled, RSA DSA DH ECC X25519 \
+						  ED25519)
+_CFG_CORE_LTC_CURVE25519 := $(call ltc-one-enabled, X25519 ED25519)
+_CFG_CORE_LTC_AES_AUTHENC := $(and $(filter y,$(_CFG_CORE_LTC_AES_DESC)), \
 			       $(filter y,$(call ltc-one-enabled, CCM GCM)))
+_CFG_CORE_LTC_AUTHENC := $(call ltc-one-enabled, AES_AUTHENC CHACHA20_POLY1305)
 _CFG_CORE_LTC_CIPHER := $(call ltc-one-enabled, AES_DESC DES)
 _CFG_CORE_LTC_HASH := $(call ltc-one-enabled, MD5 SHA1 SHA224 SHA256 SHA384 \
 					      SHA512)
-_CFG_CORE_LTC_MAC := $(call ltc-one-enabled, HMAC CMAC CBC_MAC)
+_CFG_CORE_LTC_MAC := $(call ltc-one-enabled, HMAC CMAC CBC_MAC \
+					    CHACHA20_POLY1305)
 _CFG_CORE_LTC_CBC := $(call ltc-one-enabled, CBC CBC_MAC)
 _CFG_CORE_LTC_ASN1 := $(call ltc-one-enabled, RSA DSA ECC)
 
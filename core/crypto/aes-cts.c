@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tee/tee_cryp_utl.h>
@@ -37,6 +37,8 @@ struct cts_ctx {
 	TEE_OperationMode mode;
 };
 
+SLAB_CACHE_DEFINE(cts_ctx_cache, struct cts_ctx, NULL);
+
 static const struct crypto_cipher_ops cts_ops;
 
 static struct cts_ctx *to_cts_ctx(struct crypto_cipher_ctx *ctx)
@@ -209,7 +211,7 @@ static void cts_free_ctx(struct crypto_cipher_ctx *ctx)
 
 	crypto_cipher_free_ctx(c->cbc);
 	crypto_cipher_free_ctx(c->ecb);
-	free(c);
+	slab_free(&cts_ctx_cache, c);
 }
 
 static void cts_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -234,7 +236,7 @@ static const struct crypto_cipher_ops cts_ops = {
 TEE_Result crypto_aes_cts_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
 	TEE_Result res = TEE_SUCCESS;
-	struct cts_ctx *c = calloc(1, sizeof(*c));
+	struct cts_ctx *c = slab_alloc(&cts_ctx_cache);
 
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -252,7 +254,7 @@ TEE_Result crypto_aes_cts_alloc_ctx(struct crypto_cipher_ctx **ctx)
 	return TEE_SUCCESS;
 err:
 	crypto_cipher_free_ctx(c->ecb);
-	free(c);
+	slab_free(&cts_ctx_cache, c);
 
 	return res;
 }
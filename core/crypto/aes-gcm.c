@@ -8,6 +8,7 @@
 #include <crypto/crypto_impl.h>
 #include <crypto/internal_aes-gcm.h>
 #include <io.h>
+#include <mm/slab.h>
 #include <string_ext.h>
 #include <string.h>
 #include <tee_api_types.h>
@@ -415,7 +416,6 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 
 
 #ifndef CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB
-#include <stdlib.h>
 #include <crypto/crypto.h>
 
 struct aes_gcm_ctx {
@@ -423,6 +423,8 @@ struct aes_gcm_ctx {
 	struct internal_aes_gcm_ctx ctx;
 };
 
+SLAB_CACHE_DEFINE(aes_gcm_ctx_cache, struct aes_gcm_ctx, NULL);
+
 static const struct crypto_authenc_ops aes_gcm_ops;
 
 static struct aes_gcm_ctx *
@@ -435,7 +437,7 @@ to_aes_gcm_ctx(struct crypto_authenc_ctx *aec)
 
 TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 {
-	struct aes_gcm_ctx *ctx = calloc(1, sizeof(*ctx));
+	struct aes_gcm_ctx *ctx = slab_alloc(&aes_gcm_ctx_cache);
 
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -448,7 +450,7 @@ TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 
 static void aes_gcm_free_ctx(struct crypto_authenc_ctx *aec)
 {
-	free(to_aes_gcm_ctx(aec));
+	slab_free(&aes_gcm_ctx_cache, to_aes_gcm_ctx(aec));
 }
 
 static void aes_gcm_copy_state(struct crypto_authenc_ctx *dst_ctx,
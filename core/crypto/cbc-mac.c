@@ -11,12 +11,14 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <types_ext.h>
 #include <util.h>
 
 #define CBCMAC_MAX_BLOCK_LEN 16
+/* Whole blocks passed to the cipher at once, the output is discarded */
+#define CBCMAC_CHUNK_LEN (CBCMAC_MAX_BLOCK_LEN * 8)
 
 struct crypto_cbc_mac_ctx {
 	struct crypto_mac_ctx ctx;
@@ -30,6 +32,8 @@ struct crypto_cbc_mac_ctx {
 	bool pkcs5_pad;
 };
 
+SLAB_CACHE_DEFINE(crypto_cbc_mac_ctx_cache, struct crypto_cbc_mac_ctx, NULL);
+
 static const struct crypto_mac_ops crypto_cbc_mac_ops;
 
 static struct crypto_cbc_mac_ctx *to_cbc_mac_ctx(struct crypto_mac_ctx *ctx)
@@ -77,14 +81,17 @@ static TEE_Result crypto_cbc_mac_update(struct crypto_mac_ctx *ctx,
 	}
 
 	while (len >= mc->block_len) {
+		uint8_t chunk[CBCMAC_CHUNK_LEN];
+		size_t n = MIN(len - len % mc->block_len, sizeof(chunk));
+
 		res = crypto_cipher_update(mc->cbc_ctx, TEE_MODE_ENCRYPT,
-					   false, data, mc->block_len,
-					   mc->digest);
+					   false, data, n, chunk);
 		if (res)
 			return res;
+		memcpy(mc->digest, chunk + n - mc->block_len, mc->block_len);
 		mc->is_computed = 1;
-		data += mc->block_len;
-		len -= mc->block_len;
+		data += n;
+		len -= n;
 	}
 
 	if (len > 0) {
@@ -129,7 +136,7 @@ static void crypto_cbc_mac_free_ctx(struct crypto_mac_ctx *ctx)
 	struct crypto_cbc_mac_ctx *mc = to_cbc_mac_ctx(ctx);
 
 	crypto_cipher_free_ctx(mc->cbc_ctx);
-	free(mc);
+	slab_free(&crypto_cbc_mac_ctx_cache, mc);
 }
 
 static void crypto_cbc_mac_copy_state(struct crypto_mac_ctx *dst_ctx,
@@ -173,7 +180,7 @@ static TEE_Result crypto_cbc_mac_alloc_ctx(struct crypto_mac_ctx **ctx_ret,
 	if (res)
 		return res;
 
-	ctx = calloc(1, sizeof(*ctx));
+	ctx = slab_alloc(&crypto_cbc_mac_ctx_cache);
 	if (!ctx) {
 		crypto_cipher_free_ctx(cbc_ctx);
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -340,6 +340,11 @@ TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 	case TEE_ALG_AES_GCM:
 		res = crypto_aes_gcm_alloc_ctx(&c);
 		break;
+#endif
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+	case TEE_ALG_CHACHA20_POLY1305:
+		res = crypto_chacha20_poly1305_alloc_ctx(&c);
+		break;
 #endif
 	default:
 		return TEE_ERROR_NOT_IMPLEMENTED;
@@ -788,6 +793,51 @@ TEE_Result crypto_acipher_sm2_kep_derive(struct ecc_keypair *my_key __unused,
 }
 #endif
 
+#if !defined(CFG_CRYPTO_X25519)
+TEE_Result crypto_acipher_gen_x25519_key(struct x25519_keypair *key __unused,
+					 size_t key_size __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result crypto_acipher_x25519_shared_secret(struct x25519_keypair
+					       *private_key __unused,
+					       const uint8_t *public_key
+								__unused,
+					       uint8_t *secret __unused,
+					       size_t *secret_len __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif
+
+#if !defined(CFG_CRYPTO_ED25519)
+TEE_Result crypto_acipher_gen_ed25519_key(struct ed25519_keypair *key __unused,
+					  size_t key_size __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result crypto_acipher_ed25519_sign(struct ed25519_keypair *key __unused,
+				       const uint8_t *msg __unused,
+				       size_t msg_len __unused,
+				       uint8_t *sig __unused,
+				       size_t *sig_len __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result crypto_acipher_ed25519_verify(struct ed25519_public_key *key
+								__unused,
+					 const uint8_t *msg __unused,
+					 size_t msg_len __unused,
+					 const uint8_t *sig __unused,
+					 size_t sig_len __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif
+
 __weak void crypto_storage_obj_del(uint8_t *data __unused, size_t len __unused)
 {
 }
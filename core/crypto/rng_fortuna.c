@@ -9,11 +9,14 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
 #include <string.h>
+#include <string_ext.h>
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
@@ -71,6 +74,22 @@ static struct {
 
 unsigned int ring_buffer_spin_lock;
 
+#define PCPU_BUF_SIZE		CFG_CRYPTO_RNG_PCPU_BUF_SIZE
+#define PCPU_MAX_READ		(PCPU_BUF_SIZE / 4)
+
+/*
+ * struct pcpu_buf - per-core buffer of random bytes
+ * @avail:		Number of bytes left, at the end of @data
+ * @data:		Output of fortuna_read(), bytes before the @avail last
+ *			ones have been handed out and wiped
+ *
+ * Only accessed by the local core with foreign interrupts masked.
+ */
+static struct pcpu_buf {
+	size_t avail;
+	uint8_t data[PCPU_BUF_SIZE];
+} pcpu_buf[CFG_TEE_CORE_NB_CORE] __maybe_unused;
+
 static void inc_counter(uint64_t counter[2])
 {
 	counter[0]++;
@@ -511,10 +530,74 @@ out:
 	return res;
 }
 
+#if PCPU_BUF_SIZE
+/*
+ * Takes @blen bytes from @b into @buf and wipes them from @b, returns
+ * false if not enough bytes are available.
+ */
+static bool pcpu_buf_take(struct pcpu_buf *b, void *buf, size_t blen)
+{
+	uint8_t *p = NULL;
+
+	if (b->avail < blen)
+		return false;
+
+	p = b->data + PCPU_BUF_SIZE - b->avail;
+	memcpy(buf, p, blen);
+	memzero_explicit(p, blen);
+	b->avail -= blen;
+
+	return true;
+}
+
+static TEE_Result pcpu_buf_read(void *buf, size_t blen)
+{
+	uint32_t exceptions = 0;
+	struct pcpu_buf *b = NULL;
+	struct pcpu_buf tmp = { };
+	TEE_Result res = TEE_SUCCESS;
+	bool done = false;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	done = pcpu_buf_take(pcpu_buf + get_core_pos(), buf, blen);
+	thread_unmask_exceptions(exceptions);
+	if (done)
+		return TEE_SUCCESS;
+
+	/*
+	 * Refill in a local buffer with the PRNG lock held, then serve the
+	 * request from it and hand over what's left to the current core
+	 * unless its buffer was refilled in the meantime.
+	 */
+	res = fortuna_read(tmp.data, sizeof(tmp.data));
+	if (res)
+		return res;
+	tmp.avail = sizeof(tmp.data);
+	pcpu_buf_take(&tmp, buf, blen);
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	b = pcpu_buf + get_core_pos();
+	if (b->avail < tmp.avail) {
+		memzero_explicit(b->data, sizeof(b->data));
+		memcpy(b, &tmp, sizeof(tmp));
+	}
+	thread_unmask_exceptions(exceptions);
+
+	memzero_explicit(&tmp, sizeof(tmp));
+
+	return TEE_SUCCESS;
+}
+#endif
+
 TEE_Result crypto_rng_read(void *buf, size_t blen)
 {
 	size_t offs = 0;
 
+#if PCPU_BUF_SIZE
+	if (blen && blen <= PCPU_MAX_READ)
+		return pcpu_buf_read(buf, blen);
+#endif
+
 	while (true) {
 		TEE_Result res;
 		size_t n;
@@ -9,7 +9,7 @@
 #include <compiler.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string_ext.h>
 #include <string.h>
 #include <tee_api_types.h>
@@ -23,6 +23,8 @@ struct sm3_hash_ctx {
 	struct sm3_context sm3_ctx;
 };
 
+SLAB_CACHE_DEFINE(sm3_hash_ctx_cache, struct sm3_hash_ctx, NULL);
+
 static const struct crypto_hash_ops sm3_hash_ops;
 
 static struct sm3_hash_ctx *to_hash_ctx(struct crypto_hash_ctx *ctx)
@@ -77,7 +79,7 @@ static void op_sm3_hash_free_ctx(struct crypto_hash_ctx *ctx)
 	struct sm3_hash_ctx *hc = to_hash_ctx(ctx);
 
 	memzero_explicit(&hc->sm3_ctx, sizeof(hc->sm3_ctx));
-	free(hc);
+	slab_free(&sm3_hash_ctx_cache, hc);
 }
 
 static void op_sm3_hash_copy_state(struct crypto_hash_ctx *dst_ctx,
@@ -101,7 +103,7 @@ TEE_Result crypto_sm3_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
 	struct sm3_hash_ctx *hc = NULL;
 
-	hc = calloc(1, sizeof(*hc));
+	hc = slab_alloc(&sm3_hash_ctx_cache);
 	if (!hc)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -9,7 +9,7 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <kernel/panic.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
@@ -18,11 +18,26 @@
 
 #include "sm3.h"
 
+/* Longer keys are not cached */
+#define SM3_HMAC_MAX_CACHED_KEY	64
+
+/*
+ * @inner and @outer hold the states after the inner and outer padded key
+ * blocks of @key, initializing again with the same key only restores
+ * @inner and the outer padded key block is never hashed again.
+ */
 struct sm3_hmac_ctx {
 	struct crypto_mac_ctx mac_ctx;
 	struct sm3_context sm3_ctx;
+	struct sm3_context inner;
+	struct sm3_context outer;
+	uint8_t key[SM3_HMAC_MAX_CACHED_KEY];
+	size_t key_len;
+	bool key_cached;
 };
 
+SLAB_CACHE_DEFINE(sm3_hmac_ctx_cache, struct sm3_hmac_ctx, NULL);
+
 static const struct crypto_mac_ops sm3_hmac_ops;
 
 static struct sm3_hmac_ctx *to_hmac_ctx(struct crypto_mac_ctx *ctx)
@@ -32,10 +47,30 @@ static struct sm3_hmac_ctx *to_hmac_ctx(struct crypto_mac_ctx *ctx)
 	return container_of(ctx, struct sm3_hmac_ctx, mac_ctx);
 }
 
+static void cache_key(struct sm3_hmac_ctx *c, const uint8_t *key, size_t len)
+{
+	c->key_cached = len <= sizeof(c->key);
+	if (c->key_cached) {
+		if (len)
+			memcpy(c->key, key, len);
+		c->key_len = len;
+	}
+}
+
 static TEE_Result op_sm3_hmac_init(struct crypto_mac_ctx *ctx,
 				 const uint8_t *key, size_t len)
 {
-	sm3_hmac_init(&to_hmac_ctx(ctx)->sm3_ctx, key, len);
+	struct sm3_hmac_ctx *c = to_hmac_ctx(ctx);
+
+	if (!c->key_cached || c->key_len != len ||
+	    consttime_memcmp(c->key, key, len)) {
+		sm3_hmac_init(&c->inner, key, len);
+		sm3_init(&c->outer);
+		sm3_update(&c->outer, c->inner.opad, sizeof(c->inner.opad));
+		cache_key(c, key, len);
+	}
+
+	c->sm3_ctx = c->inner;
 
 	return TEE_SUCCESS;
 }
@@ -64,10 +99,15 @@ static TEE_Result op_sm3_hmac_final(struct crypto_mac_ctx *ctx, uint8_t *digest,
 	else
 		tmp_digest = digest;
 
-	sm3_hmac_final(&c->sm3_ctx, tmp_digest);
+	/* Same as sm3_hmac_final() but starting from the cached outer state */
+	sm3_final(&c->sm3_ctx, block_digest);
+	c->sm3_ctx = c->outer;
+	sm3_update(&c->sm3_ctx, block_digest, sizeof(block_digest));
+	sm3_final(&c->sm3_ctx, tmp_digest);
 
 	if (hmac_size > len)
 		memcpy(digest, tmp_digest, len);
+	memzero_explicit(block_digest, sizeof(block_digest));
 
 	return TEE_SUCCESS;
 }
@@ -76,8 +116,8 @@ static void op_sm3_hmac_free_ctx(struct crypto_mac_ctx *ctx)
 {
 	struct sm3_hmac_ctx *c = to_hmac_ctx(ctx);
 
-	memzero_explicit(&c->sm3_ctx, sizeof(c->sm3_ctx));
-	free(c);
+	memzero_explicit(c, sizeof(*c));
+	slab_free(&sm3_hmac_ctx_cache, c);
 }
 
 static void op_sm3_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
@@ -87,6 +127,11 @@ static void op_sm3_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
 	struct sm3_hmac_ctx *dst = to_hmac_ctx(dst_ctx);
 
 	dst->sm3_ctx = src->sm3_ctx;
+	dst->inner = src->inner;
+	dst->outer = src->outer;
+	memcpy(dst->key, src->key, sizeof(dst->key));
+	dst->key_len = src->key_len;
+	dst->key_cached = src->key_cached;
 }
 
 static const struct crypto_mac_ops sm3_hmac_ops = {
@@ -101,7 +146,7 @@ TEE_Result crypto_hmac_sm3_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
 	struct sm3_hmac_ctx *c = NULL;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&sm3_hmac_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -10,8 +10,10 @@
  * 2011-10-26
  */
 
+#include <crypto/crypto_accel.h>
 #include <string.h>
 #include <string_ext.h>
+#include <util.h>
 
 #include "sm3.h"
 
@@ -154,6 +156,22 @@ static void sm3_process(struct sm3_context *ctx, const uint8_t data[64])
 	ctx->state[7] ^= H;
 }
 
+static void sm3_process_blocks(struct sm3_context *ctx, const uint8_t *data,
+			       size_t nblocks)
+{
+#ifdef CFG_CORE_CRYPTO_SM3_ACCEL
+	if (crypto_accel_sm3_compress(ctx->state, data, nblocks) ==
+	    TEE_SUCCESS)
+		return;
+#endif
+
+	while (nblocks) {
+		sm3_process(ctx, data);
+		data += 64;
+		nblocks--;
+	}
+}
+
 void sm3_update(struct sm3_context *ctx, const uint8_t *input, size_t ilen)
 {
 	size_t fill;
@@ -172,16 +190,16 @@ void sm3_update(struct sm3_context *ctx, const uint8_t *input, size_t ilen)
 
 	if (left && ilen >= fill) {
 		memcpy(ctx->buffer + left, input, fill);
-		sm3_process(ctx, ctx->buffer);
+		sm3_process_blocks(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sm3_process(ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sm3_process_blocks(ctx, input, ilen / 64);
+		input += ROUNDDOWN(ilen, 64);
+		ilen %= 64;
 	}
 
 	if (ilen > 0)
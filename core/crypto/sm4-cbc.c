@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
@@ -20,6 +20,8 @@ struct sm4_cbc_ctx {
 	uint8_t iv[16];
 };
 
+SLAB_CACHE_DEFINE(sm4_cbc_ctx_cache, struct sm4_cbc_ctx, NULL);
+
 static const struct crypto_cipher_ops sm4_cbc_ops;
 
 static struct sm4_cbc_ctx *to_sm4_cbc_ctx(struct crypto_cipher_ctx *ctx)
@@ -71,7 +73,7 @@ static void sm4_cbc_final(struct crypto_cipher_ctx *ctx)
 
 static void sm4_cbc_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_sm4_cbc_ctx(ctx));
+	slab_free(&sm4_cbc_ctx_cache, to_sm4_cbc_ctx(ctx));
 }
 
 static void sm4_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -96,7 +98,7 @@ TEE_Result crypto_sm4_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 {
 	struct sm4_cbc_ctx *c = NULL;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&sm4_cbc_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
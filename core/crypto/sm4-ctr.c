@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
@@ -20,6 +20,8 @@ struct sm4_ctr_ctx {
 	uint8_t ctr[16];
 };
 
+SLAB_CACHE_DEFINE(sm4_ctr_ctx_cache, struct sm4_ctr_ctx, NULL);
+
 static const struct crypto_cipher_ops sm4_ctr_ops;
 
 static struct sm4_ctr_ctx *to_sm4_ctr_ctx(struct crypto_cipher_ctx *ctx)
@@ -68,7 +70,7 @@ static void sm4_ctr_final(struct crypto_cipher_ctx *ctx)
 
 static void sm4_ctr_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_sm4_ctr_ctx(ctx));
+	slab_free(&sm4_ctr_ctx_cache, to_sm4_ctr_ctx(ctx));
 }
 
 static void sm4_ctr_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -93,7 +95,7 @@ TEE_Result crypto_sm4_ctr_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 {
 	struct sm4_ctr_ctx *c = NULL;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&sm4_ctr_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string_ext.h>
 #include <tee_api_types.h>
 #include <util.h>
@@ -18,6 +18,8 @@ struct sm4_ecb_ctx {
 	struct sm4_context state;
 };
 
+SLAB_CACHE_DEFINE(sm4_ecb_ctx_cache, struct sm4_ecb_ctx, NULL);
+
 static const struct crypto_cipher_ops sm4_ecb_ops;
 
 static struct sm4_ecb_ctx *to_sm4_ecb_ctx(struct crypto_cipher_ctx *ctx)
@@ -67,7 +69,7 @@ static void sm4_ecb_final(struct crypto_cipher_ctx *ctx)
 
 static void sm4_ecb_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_sm4_ecb_ctx(ctx));
+	slab_free(&sm4_ecb_ctx_cache, to_sm4_ecb_ctx(ctx));
 }
 
 static void sm4_ecb_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -91,7 +93,7 @@ TEE_Result crypto_sm4_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 {
 	struct sm4_ecb_ctx *c = NULL;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&sm4_ecb_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
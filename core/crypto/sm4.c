@@ -14,7 +14,9 @@
 
 #include "sm4.h"
 #include <assert.h>
+#include <crypto/crypto_accel.h>
 #include <string.h>
+#include <util.h>
 
 #define GET_UINT32_BE(n, b, i)				\
 	do {						\
@@ -183,6 +185,25 @@ static void sm4_one_round(uint32_t sk[32], const uint8_t input[16],
 	PUT_UINT32_BE(ulbuf[32], output, 12);
 }
 
+/* Number of blocks handled at once by the CBC decryption and CTR modes */
+#define SM4_STRIDE_BLOCKS	8
+
+static void sm4_crypt_blocks(uint32_t sk[32], const uint8_t *input,
+			     uint8_t *output, size_t nblocks)
+{
+#ifdef CFG_CORE_CRYPTO_SM4_ACCEL
+	if (crypto_accel_sm4_crypt(output, input, sk, nblocks) == TEE_SUCCESS)
+		return;
+#endif
+
+	while (nblocks) {
+		sm4_one_round(sk, input, output);
+		input  += 16;
+		output += 16;
+		nblocks--;
+	}
+}
+
 void sm4_setkey_enc(struct sm4_context *ctx, const uint8_t key[16])
 {
 	ctx->mode = SM4_ENCRYPT;
@@ -205,19 +226,15 @@ void sm4_crypt_ecb(struct sm4_context *ctx, size_t length, const uint8_t *input,
 {
 	assert(!(length % 16));
 
-	while (length > 0) {
-		sm4_one_round(ctx->sk, input, output);
-		input  += 16;
-		output += 16;
-		length -= 16;
-	}
+	sm4_crypt_blocks(ctx->sk, input, output, length / 16);
 }
 
 void sm4_crypt_cbc(struct sm4_context *ctx, size_t length, uint8_t iv[16],
 		   const uint8_t *input, uint8_t *output)
 {
-	int i;
-	uint8_t temp[16];
+	size_t i;
+	size_t n;
+	uint8_t temp[SM4_STRIDE_BLOCKS * 16];
 
 	assert(!(length % 16));
 
@@ -225,7 +242,7 @@ void sm4_crypt_cbc(struct sm4_context *ctx, size_t length, uint8_t iv[16],
 		while (length > 0) {
 			for (i = 0; i < 16; i++)
 				output[i] = (uint8_t)(input[i] ^ iv[i]);
-			sm4_one_round(ctx->sk, output, output);
+			sm4_crypt_blocks(ctx->sk, output, output, 1);
 			memcpy(iv, output, 16);
 			input  += 16;
 			output += 16;
@@ -234,14 +251,17 @@ void sm4_crypt_cbc(struct sm4_context *ctx, size_t length, uint8_t iv[16],
 	} else {
 		/* SM4_DECRYPT */
 		while (length > 0) {
-			memcpy(temp, input, 16);
-			sm4_one_round(ctx->sk, input, output);
+			n = MIN(length, sizeof(temp));
+			memcpy(temp, input, n);
+			sm4_crypt_blocks(ctx->sk, input, output, n / 16);
 			for (i = 0; i < 16; i++)
 				output[i] = (uint8_t)(output[i] ^ iv[i]);
-			memcpy(iv, temp, 16);
-			input  += 16;
-			output += 16;
-			length -= 16;
+			for (i = 16; i < n; i++)
+				output[i] = (uint8_t)(output[i] ^ temp[i - 16]);
+			memcpy(iv, temp + n - 16, 16);
+			input  += n;
+			output += n;
+			length -= n;
 		}
 	}
 }
@@ -249,22 +269,26 @@ void sm4_crypt_cbc(struct sm4_context *ctx, size_t length, uint8_t iv[16],
 void sm4_crypt_ctr(struct sm4_context *ctx, size_t length, uint8_t ctr[16],
 		   const uint8_t *input, uint8_t *output)
 {
-	int i;
-	uint8_t temp[16];
+	size_t i;
+	size_t j;
+	size_t n;
+	uint8_t temp[SM4_STRIDE_BLOCKS * 16];
 
 	assert(!(length % 16));
 
 	while (length > 0) {
-		memcpy(temp, ctr, 16);
-		sm4_one_round(ctx->sk, ctr, ctr);
-		for (i = 0; i < 16; i++)
-			output[i] = (uint8_t)(input[i] ^ ctr[i]);
-		memcpy(ctr, temp, 16);
-		for (i = 16; i > 0; i--)
-			if (++ctr[i - 1])
-				break;
-		input  += 16;
-		output += 16;
-		length -= 16;
+		n = MIN(length, sizeof(temp));
+		for (j = 0; j < n; j += 16) {
+			memcpy(temp + j, ctr, 16);
+			for (i = 16; i > 0; i--)
+				if (++ctr[i - 1])
+					break;
+		}
+		sm4_crypt_blocks(ctx->sk, temp, temp, n / 16);
+		for (i = 0; i < n; i++)
+			output[i] = (uint8_t)(input[i] ^ temp[i]);
+		input  += n;
+		output += n;
+		length -= n;
 	}
 }
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <util.h>
 
 /*
  * These macros are the offsets where images reside on sec mem
@@ -16,7 +17,6 @@
 #define BNXT_BUFFER_SEC_MEM	0x8ae00000
 #define BNXT_FW_SEC_MEM_SRC	BNXT_BUFFER_SEC_MEM
 #define BNXT_FW_SEC_MEM_CFG	(BNXT_BUFFER_SEC_MEM + 0x100000)
-#define TEMP_MEM		(BNXT_BUFFER_SEC_MEM + 0x180000)
 
 #define BNXT_CRASH_SEC_MEM	0x8b000000
 #define BNXT_CRASH_LEN		0x2000000
@@ -35,6 +35,9 @@
 
 #define BUFFER_PADDING			SZ_1K
 
+/* Sections are checked and written to the device in chunks of this size */
+#define SECTION_CHUNK_SIZE		(4 * SZ_1K)
+
 #define INC_SRC_ADDR			1
 
 #define EOF				-1
@@ -305,27 +308,61 @@ static int get_char(uint8_t *inbuf, size_t *inbuf_idx, size_t inbuf_size)
 	return c;
 }
 
-static void put_char(uint8_t *outbuf,
-		     size_t *outbuf_idx,
-		     size_t outbuf_size,
-		     uint8_t ch)
+/*
+ * A section is streamed to the device: the checksum is computed over each
+ * chunk right before the chunk is written, while it's still in the cache.
+ * The device is halted while sections are loaded and is only started
+ * once all of them have been checked.
+ */
+struct section_stream {
+	uintptr_t dst;		/* Host view of the next address to write */
+	size_t left;		/* Bytes of the section left to write */
+	bool is_crc;
+	uint32_t checksum;
+	size_t buf_len;
+	uint8_t buf[SECTION_CHUNK_SIZE] __aligned(sizeof(uint32_t));
+};
+
+static void section_stream_write(struct section_stream *st,
+				 const uint8_t *data, size_t len)
 {
-	if (*outbuf_idx >= outbuf_size)
+	size_t i = 0;
+
+	/* Only the first org_data_len bytes belong to the section */
+	len = MIN(len, st->left);
+	if (!len)
 		return;
 
-	outbuf[*outbuf_idx] = ch;
-	*outbuf_idx += 1;
+	if (st->is_crc) {
+		st->checksum = CRC32(~st->checksum, (const char *)data, len);
+	} else {
+		for (i = 0; i < len / sizeof(uint32_t); i++)
+			st->checksum += ((const uint32_t *)data)[i];
+	}
+
+	memcpy32_helper((uintptr_t)data, st->dst, len / sizeof(uint32_t),
+			INC_SRC_ADDR);
+	st->dst += len;
+	st->left -= len;
+}
+
+static void put_char(struct section_stream *st, uint8_t ch)
+{
+	st->buf[st->buf_len++] = ch;
+	if (st->buf_len == sizeof(st->buf)) {
+		section_stream_write(st, st->buf, st->buf_len);
+		st->buf_len = 0;
+	}
 }
 
 static size_t ape_section_uncompress(uint8_t *inbuf,
 				     size_t inbuf_size,
-				     uint8_t *outbuf,
-				     size_t outbuf_size)
+				     struct section_stream *st)
 {
 	int i = 0, j = 0, k = 0, r = 0, c = 0;
 	uint32_t flags = 0;
 	size_t exp_size = 0, codesize = 0;
-	size_t inbuf_idx = 0, outbuf_idx = 0;
+	size_t inbuf_idx = 0;
 #define CODE_8U_MASK		0xff00u	/* 8 code units count mask (8 bits) */
 #define CODE_END_MASK		0x100u	/* End of code units mask */
 #define CODE_IS_UNENCODED_MASK	1	/* Unencoded code unit mask */
@@ -345,7 +382,6 @@ static size_t ape_section_uncompress(uint8_t *inbuf,
 	uint8_t text_buf[NS + F - 1];
 
 	inbuf_idx = 0;
-	outbuf_idx = 0;
 
 	for (i = 0; i < NS - F; i++)
 		text_buf[i] = ' ';
@@ -376,7 +412,7 @@ static size_t ape_section_uncompress(uint8_t *inbuf,
 			if (exp_size > inbuf_size)
 				break;
 
-			put_char(outbuf, &outbuf_idx, outbuf_size, c);
+			put_char(st, c);
 			text_buf[r++] = c;
 			r &= (NS - 1);
 			++codesize;
@@ -403,7 +439,7 @@ static size_t ape_section_uncompress(uint8_t *inbuf,
 
 			for (k = 0; k <= j; k++) {
 				c = text_buf[((i + k) & (NS - 1))];
-				put_char(outbuf, &outbuf_idx, outbuf_size, c);
+				put_char(st, c);
 				text_buf[r++] = c;
 				r &= (NS - 1);
 				++codesize;
@@ -411,37 +447,43 @@ static size_t ape_section_uncompress(uint8_t *inbuf,
 		}
 	}
 
+	section_stream_write(st, st->buf, st->buf_len);
+	st->buf_len = 0;
+
 	return codesize;
 }
 
 static int ape_section_copy(struct ape_bin_hdr_s *bin_hdr,
 			    struct ape_section_hdr_s *section)
 {
-	uintptr_t src = 0;
-	uintptr_t dst = 0;
-	uint32_t checksum = 0;
-	uint32_t i = 0;
-	size_t size = 0;
+	struct section_stream *st = NULL;
 	uint8_t *section_data = NULL;
-	size_t work_buff_size = 0;
-	void *work_buff = NULL;
+	size_t size = section->org_data_len;
+	size_t offs = 0;
 	int rc = BNXT_FAILURE;
 
-	if (SECTION_IS_ZIPPED(section)) {
-		work_buff_size = section->org_data_len + BUFFER_PADDING;
-		work_buff = (void *)phys_to_virt(TEMP_MEM, MEM_AREA_RAM_SEC);
-		if (!work_buff) {
-			EMSG("ERROR: buffer allocation");
-			return BNXT_FAILURE;
-		}
+	st = calloc(1, sizeof(*st));
+	if (!st) {
+		EMSG("ERROR: buffer allocation");
+		return BNXT_FAILURE;
+	}
 
-		section_data = (uint8_t *)((uintptr_t)bin_hdr +
-					   SECTION_SRC_OFFSET(section));
+	st->dst = ape_host_view_addr_get(section->dest_addr, size);
+	if (st->dst == 0) {
+		EMSG("ERROR: ChiMP-to-host address conversion of %x",
+		     section->dest_addr);
+		goto ape_section_copy_exit;
+	}
+	st->left = size;
+	st->is_crc = section->flags_src_offset & SECTION_FLAGS_IS_CRC;
+
+	section_data = (uint8_t *)((uintptr_t)bin_hdr +
+				   SECTION_SRC_OFFSET(section));
+
+	if (SECTION_IS_ZIPPED(section)) {
 		size = ape_section_uncompress(section_data,
-					      section->zip_data_len,
-					      work_buff,
-					      work_buff_size);
-		if (size >= work_buff_size) {
+					      section->zip_data_len, st);
+		if (size >= section->org_data_len + BUFFER_PADDING) {
 			EMSG("ERROR: section uncompress");
 			goto ape_section_copy_exit;
 		}
@@ -451,40 +493,22 @@ static int ape_section_copy(struct ape_bin_hdr_s *bin_hdr,
 			     section->org_data_len, size);
 			goto ape_section_copy_exit;
 		}
-		src = (uintptr_t)work_buff;
 	} else {
-		src = (uintptr_t)bin_hdr + SECTION_SRC_OFFSET(section);
+		for (offs = 0; offs < size; offs += SECTION_CHUNK_SIZE)
+			section_stream_write(st, section_data + offs,
+					     SECTION_CHUNK_SIZE);
 	}
 
-	size = section->org_data_len;
-
-	if (section->flags_src_offset & SECTION_FLAGS_IS_CRC) {
-		checksum = CRC32(CRC32_INIT_VAL, (const char *)src, size);
-	} else {
-		checksum = 0;
-		for (i = 0; i < size / sizeof(uint32_t); i++)
-			checksum += ((uint32_t *)src)[i];
-	}
-	if (checksum != section->checksum) {
+	if (st->checksum != section->checksum) {
 		EMSG("ERROR: checksum mismatch (exp: %x, act: %x)",
-		     section->checksum, checksum);
+		     section->checksum, st->checksum);
 		goto ape_section_copy_exit;
 	}
 
-	dst = ape_host_view_addr_get(section->dest_addr, size);
-	if (dst == 0) {
-		EMSG("ERROR: ChiMP-to-host address conversion of %x",
-		     section->dest_addr);
-		goto ape_section_copy_exit;
-	}
-
-	/* Copy the section */
-	size = size / sizeof(uint32_t);
-	memcpy32_helper(src, dst, size, INC_SRC_ADDR);
-
 	rc = BNXT_SUCCESS;
 
 ape_section_copy_exit:
+	free(st);
 	return rc;
 }
 
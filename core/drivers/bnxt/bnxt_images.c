@@ -40,6 +40,11 @@ static int verify_header(vaddr_t mem)
 	return BNXT_FAILURE;
 }
 
+/*
+ * The images are copied to @dst if it's not 0, they're then used from
+ * there rather than from @src so the flash is only read once and the
+ * images can't be changed after they've been copied.
+ */
 static void set_bnxt_images_info(struct bnxt_images_info *bnxt_info,
 				 int chip_type, vaddr_t src, vaddr_t dst)
 {
@@ -66,6 +71,7 @@ static void set_bnxt_images_info(struct bnxt_images_info *bnxt_info,
 		if (dst) {
 			memcpy((void *)dst, (void *)(src + fw_image_offset),
 			       len);
+			bnxt_info->bnxt_fw_vaddr = dst;
 			dst += len;
 		}
 
@@ -77,6 +83,7 @@ static void set_bnxt_images_info(struct bnxt_images_info *bnxt_info,
 		if (dst) {
 			memcpy((void *)dst, (void *)(src + fw_image_offset),
 			       len);
+			bnxt_info->bnxt_cfg_vaddr = dst;
 		}
 	}
 }
@@ -111,6 +118,7 @@ int get_bnxt_images_info(struct bnxt_images_info *bnxt_info, int chip_type,
 						      MEM_AREA_IO_NSEC);
 		memcpy((void *)ddr_dest, (void *)bnxt_info->bnxt_bspd_cfg_vaddr,
 		       BNXT_BSPD_CFG_LEN);
+		bnxt_info->bnxt_bspd_cfg_vaddr = ddr_dest;
 
 		set_bnxt_images_info(bnxt_info, chip_type, flash_dev_vaddr,
 				     ddr_dest + BNXT_IMG_SECMEM_OFFSET);
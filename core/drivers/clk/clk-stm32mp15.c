@@ -1477,11 +1477,69 @@ void stm32mp_register_clock_parents_secure(unsigned long clock_id)
 	secure_parent_clocks(parent_id);
 }
 
+/*
+ * Whether the rate of the parent clock can only be changed from secure
+ * world, following the same tree as secure_parent_clocks()
+ */
+static bool parent_rate_is_secure(int parent_id)
+{
+	switch (parent_id) {
+	case _ACLK:
+	case _PCLK4:
+	case _PCLK5:
+		return parent_rate_is_secure(get_parent_id_parent(parent_id));
+	case _HSI:
+	case _HSI_KER:
+	case _LSI:
+	case _CSI:
+	case _CSI_KER:
+	case _HSE:
+	case _HSE_KER:
+	case _HSE_KER_DIV2:
+	case _LSE:
+	case _PLL1_P:
+	case _PLL1_Q:
+	case _PLL1_R:
+	case _PLL2_P:
+	case _PLL2_Q:
+	case _PLL2_R:
+	case _CK_MPU:
+		return true;
+	case _PLL3_P:
+	case _PLL3_Q:
+	case _PLL3_R:
+		return stm32mp_periph_is_secure(STM32MP1_SHRES_PLL3);
+	default:
+		return false;
+	}
+}
+
+/*
+ * Rates are cached by the clock framework when non-secure world can't
+ * change them, clk_rates_changed() is called when this driver does.
+ */
+static bool clk_stm32_is_rate_cacheable(unsigned long id)
+{
+	int i = 0;
+
+	if (!stm32_rcc_is_secure())
+		return false;
+
+	if (clock_id2parent_id(id) == _UNKNOWN_ID) {
+		i = stm32mp1_clk_get_gated_id(id);
+		if (i < 0 || gate_is_non_secure(gate_ref(i)))
+			return false;
+	}
+
+	return parent_rate_is_secure(__clk_get_parent(id));
+}
+
 static const struct clk_ops stm32mp_clk_ops = {
 	.enable		= clk_stm32_enable,
 	.disable	= clk_stm32_disable,
 	.is_enabled	= clk_stm32_is_enabled,
 	.get_rate	= clk_stm32_get_rate,
+	.is_rate_cacheable = clk_stm32_is_rate_cacheable,
 };
 DECLARE_KEEP_PAGER(stm32mp_clk_ops);
 
@@ -1573,12 +1631,12 @@ static void stm32mp1_clk_early_init(void)
 	int ignored = 0;
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, -1, DT_RCC_SEC_CLK_COMPAT);
+	node = dt_node_offset_by_compatible(fdt, -1, DT_RCC_SEC_CLK_COMPAT);
 
 	if (node < 0 || _fdt_reg_base_address(fdt, node) != RCC_BASE) {
 		/* Check non secure compatible */
-		node = fdt_node_offset_by_compatible(fdt, -1,
-						     DT_RCC_CLK_COMPAT);
+		node = dt_node_offset_by_compatible(fdt, -1,
+						    DT_RCC_CLK_COMPAT);
 		if (node < 0 || _fdt_reg_base_address(fdt, node) != RCC_BASE) {
 			panic();
 		} else {
@@ -1704,7 +1762,7 @@ static int get_all_opp_freqvolt_from_dt(uint32_t *count)
 	assert(count);
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, -1, DT_OPP_COMPAT);
+	node = dt_node_offset_by_compatible(fdt, -1, DT_OPP_COMPAT);
 	if (node < 0)
 		return node;
 
@@ -2230,9 +2288,11 @@ int stm32mp1_set_opp_khz(uint32_t freq_khz)
 			EMSG("No CPU operating point can be set");
 			panic();
 		}
+		clk_rates_changed();
 
 		return -1;
 	}
+	clk_rates_changed();
 
 	current_opp_khz = freq_khz;
 
@@ -2553,6 +2613,7 @@ void stm32mp1_clk_restore_context_for_stop(void)
 	/* Restore MCU clock source after PLL3 is ready */
 	restore_mcu_subsys_clocks();
 	disable_kernel_clocks();
+	clk_rates_changed();
 }
 
 void stm32mp1_clk_mcuss_protect(bool enable)
@@ -2602,6 +2663,7 @@ static void stm32_clock_resume(void)
 	}
 
 	disable_kernel_clocks();
+	clk_rates_changed();
 }
 
 static TEE_Result stm32_clock_pm(enum pm_op op, unsigned int pm_hint __unused,
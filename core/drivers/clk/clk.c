@@ -5,11 +5,81 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <drivers/clk.h>
+#include <kernel/spinlock.h>
 #include <stdbool.h>
 
+/*
+ * Cache of the clock rates, one entry per slot. Readers don't take a
+ * lock, they retry the lookup through the provider if @seq is odd or has
+ * changed while they read the entry. An entry is only valid if @gen
+ * matches rate_cache_gen, which clk_rates_changed() increments.
+ */
+#define RATE_CACHE_ENTRIES	32
+
+struct rate_cache_entry {
+	unsigned int seq;
+	uint32_t gen;
+	unsigned long id;
+	unsigned long rate;
+	bool cacheable;
+};
+
 static const struct clk_ops *ops;
 
+static struct rate_cache_entry rate_cache[RATE_CACHE_ENTRIES];
+/* Starts at 1 so that zeroed entries are invalid */
+static uint32_t rate_cache_gen = 1;
+static unsigned int rate_cache_lock = SPINLOCK_UNLOCK;
+
+static bool rate_cache_get(unsigned long id, unsigned long *rate,
+			   bool *cacheable)
+{
+	struct rate_cache_entry *e = rate_cache + id % RATE_CACHE_ENTRIES;
+	uint32_t gen = atomic_load_u32(&rate_cache_gen);
+	unsigned int seq = atomic_load_uint(&e->seq);
+	bool hit = false;
+
+	if (seq & 1)
+		return false;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	hit = __compiler_atomic_load(&e->gen) == gen &&
+	      __compiler_atomic_load(&e->id) == id;
+	*rate = __compiler_atomic_load(&e->rate);
+	*cacheable = __compiler_atomic_load(&e->cacheable);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return hit && atomic_load_uint(&e->seq) == seq;
+}
+
+static void rate_cache_put(unsigned long id, uint32_t gen,
+			   unsigned long rate, bool cacheable)
+{
+	struct rate_cache_entry *e = rate_cache + id % RATE_CACHE_ENTRIES;
+	uint32_t exceptions = cpu_spin_lock_xsave(&rate_cache_lock);
+
+	atomic_store_uint(&e->seq, e->seq + 1);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	__compiler_atomic_store(&e->gen, gen);
+	__compiler_atomic_store(&e->id, id);
+	__compiler_atomic_store(&e->rate, rate);
+	__compiler_atomic_store(&e->cacheable, cacheable);
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	atomic_store_uint(&e->seq, e->seq + 1);
+
+	cpu_spin_unlock_xrestore(&rate_cache_lock, exceptions);
+}
+
+void clk_rates_changed(void)
+{
+	atomic_inc32(&rate_cache_gen);
+}
+
 TEE_Result clk_enable(unsigned long id)
 {
 	assert(ops && ops->enable);
@@ -26,9 +96,29 @@ void clk_disable(unsigned long id)
 
 unsigned long clk_get_rate(unsigned long id)
 {
+	unsigned long rate = 0;
+	bool cacheable = false;
+	uint32_t gen = 0;
+
 	assert(ops && ops->get_rate);
 
-	return ops->get_rate(id);
+	if (!ops->is_rate_cacheable)
+		return ops->get_rate(id);
+
+	/* Clocks which aren't cacheable are remembered as such too */
+	if (rate_cache_get(id, &rate, &cacheable)) {
+		if (cacheable)
+			return rate;
+		return ops->get_rate(id);
+	}
+
+	/* The rate is stale if the provider changes it past this point */
+	gen = atomic_load_u32(&rate_cache_gen);
+	rate = ops->get_rate(id);
+	cacheable = ops->is_rate_cacheable(id);
+	rate_cache_put(id, gen, rate, cacheable);
+
+	return rate;
 }
 
 unsigned long clk_get_parent(unsigned long id)
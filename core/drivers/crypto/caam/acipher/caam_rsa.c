@@ -269,7 +269,7 @@ static enum caam_status do_keypair_conv_f2(struct caam_rsa_keypair *outkey,
 	 * If the Prime P or Prime Q are not filled, returns
 	 * immediately. This is not an error.
 	 */
-	if (size_p || !size_q)
+	if (!size_p || !size_q)
 		return CAAM_NO_ERROR;
 
 	/* Allocate one buffer for both */
@@ -525,6 +525,7 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 	size_t size_n = 0;
 	size_t size_d_gen = 0;
 	struct caam_jobctx jobctx = { };
+	struct cache_op_batch cache_batch = { };
 	uint32_t *desc = 0;
 	uint32_t desclen = 0;
 	struct prime_data prime = { };
@@ -615,6 +616,8 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 		goto exit_gen_keypair;
 	}
 
+	cache_op_batch_init(&cache_batch, TEE_CACHEFLUSH);
+
 	caam_desc_init(desc);
 	caam_desc_add_word(desc, DESC_HEADER(0));
 
@@ -636,8 +639,8 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 		caam_desc_add_ptr(desc, genkey.qp.paddr);
 		caam_desc_add_word(desc, RSA_FINAL_KEY(ALL));
 
-		cache_operation(TEE_CACHEFLUSH, genkey.dp.data,
-				genkey.dp.length + genkey.dq.length +
+		cache_op_batch_add(&cache_batch, genkey.dp.data,
+				   genkey.dp.length + genkey.dq.length +
 					genkey.qp.length);
 
 	} else {
@@ -651,10 +654,11 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 	RSA_DUMPDESC(desc);
 
 	cache_operation(TEE_CACHECLEAN, genkey.e.data, genkey.e.length);
-	cache_operation(TEE_CACHEFLUSH, genkey.p.data,
-			genkey.p.length + genkey.q.length);
-	cache_operation(TEE_CACHEFLUSH, genkey.d.data,
-			genkey.d.length + genkey.n.length);
+	cache_op_batch_add(&cache_batch, genkey.p.data,
+			   genkey.p.length + genkey.q.length);
+	cache_op_batch_add(&cache_batch, genkey.d.data,
+			   genkey.d.length + genkey.n.length);
+	cache_op_batch_flush(&cache_batch);
 
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
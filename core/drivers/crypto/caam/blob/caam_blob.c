@@ -9,6 +9,10 @@
 #include <caam_jr.h>
 #include <caam_trace.h>
 #include <caam_utils_mem.h>
+#include <caam_utils_status.h>
+#ifdef CFG_CRYPTO_DRV_BLOB
+#include <drvcrypt_blob.h>
+#endif
 #include <kernel/tee_common_otp.h>
 #include <mm/core_memprot.h>
 #include <stdint.h>
@@ -20,6 +24,258 @@
 static uint8_t stored_key[MKVB_SIZE];
 static bool mkvb_retrieved;
 
+#ifdef CFG_CRYPTO_DRV_BLOB
+/*
+ * Size added to the payload by the encapsulation: the encrypted blob key
+ * (32 bytes) and the MAC (16 bytes)
+ */
+#define BLOB_OVERHEAD		48
+
+/*
+ * Maximum number of descriptor entries of a blob job
+ */
+#define MAX_DESC_ENTRIES	11
+
+/*
+ * Blob job data
+ */
+struct blob_job {
+	struct caam_jobctx jobctx; /* Job context */
+	uint32_t *desc;            /* Job descriptor */
+	struct caambuf buf;        /* Key modifier, input and output data */
+};
+
+/*
+ * Frees the resources of the @nb jobs
+ *
+ * @jobs   Blob jobs
+ * @nb     Number of jobs
+ */
+static void free_jobs(struct blob_job *jobs, size_t nb)
+{
+	size_t n = 0;
+
+	for (n = 0; n < nb; n++) {
+		caam_free_desc(&jobs[n].desc);
+		caam_free_buf(&jobs[n].buf);
+	}
+}
+
+/*
+ * Prepares the job encapsulating @in into @out or decapsulating @in into
+ * @out. The key modifier, the input and the output data are all in one
+ * buffer.
+ *
+ * @job      [out] Blob job
+ * @key_mod  Key modifier
+ * @in       Input data
+ * @out_len  Length of the output data
+ * @encaps   True for an encapsulation, false for a decapsulation
+ */
+static enum caam_status prepare_job(struct blob_job *job,
+				    struct drvcrypt_buf *key_mod,
+				    struct drvcrypt_buf *in, size_t out_len,
+				    bool encaps)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	paddr_t paddr = 0;
+	uint32_t *desc = NULL;
+
+	retstatus = caam_alloc_align_buf(&job->buf, key_mod->length +
+					 in->length + out_len);
+	if (retstatus != CAAM_NO_ERROR)
+		return retstatus;
+
+	job->desc = caam_calloc_desc(MAX_DESC_ENTRIES);
+	if (!job->desc)
+		return CAAM_OUT_MEMORY;
+
+	memcpy(job->buf.data, key_mod->data, key_mod->length);
+	memcpy(job->buf.data + key_mod->length, in->data, in->length);
+
+	desc = job->desc;
+	paddr = job->buf.paddr;
+	caam_desc_init(desc);
+	caam_desc_add_word(desc, DESC_HEADER(0));
+	caam_desc_add_word(desc, LD_KEY_PLAIN(CLASS_2, REG, key_mod->length));
+	caam_desc_add_ptr(desc, paddr);
+	paddr += key_mod->length;
+	caam_desc_add_word(desc, SEQ_IN_PTR(in->length));
+	caam_desc_add_ptr(desc, paddr);
+	paddr += in->length;
+	caam_desc_add_word(desc, SEQ_OUT_PTR(out_len));
+	caam_desc_add_ptr(desc, paddr);
+	if (encaps)
+		caam_desc_add_word(desc, BLOB_ENCAPS);
+	else
+		caam_desc_add_word(desc, BLOB_DECAPS);
+	BLOB_DUMPDESC(desc);
+
+	cache_operation(TEE_CACHEFLUSH, job->buf.data, job->buf.length);
+
+	job->jobctx.desc = desc;
+
+	return CAAM_NO_ERROR;
+}
+
+/*
+ * Runs the encapsulation or decapsulation of @nb elements in a batch of
+ * jobs. @nb is at most the number of Job Ring entries.
+ *
+ * @data    [in/out] Array of blob operation data
+ * @nb      Number of elements of @data
+ * @jobs    Blob jobs
+ * @encaps  True for an encapsulation, false for a decapsulation
+ */
+static TEE_Result do_blob_batch(struct drvcrypt_blob_data *data, size_t nb,
+				struct blob_job *jobs, bool encaps)
+{
+	struct caam_jobctx *jobctx[NB_JOBS_QUEUE] = { };
+	enum caam_status retstatus = CAAM_FAILURE;
+	TEE_Result res = TEE_SUCCESS;
+	struct drvcrypt_buf *in = NULL;
+	struct drvcrypt_buf *out = NULL;
+	size_t out_len = 0;
+	size_t n = 0;
+
+	memset(jobs, 0, nb * sizeof(*jobs));
+
+	for (n = 0; n < nb; n++) {
+		if (encaps) {
+			in = &data[n].payload;
+			out_len = in->length + BLOB_OVERHEAD;
+		} else {
+			in = &data[n].blob;
+			out_len = in->length - BLOB_OVERHEAD;
+		}
+
+		retstatus = prepare_job(&jobs[n], &data[n].key_mod, in,
+					out_len, encaps);
+		if (retstatus != CAAM_NO_ERROR) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+
+		jobctx[n] = &jobs[n].jobctx;
+	}
+
+	retstatus = caam_jr_enqueue_batch(jobctx, nb);
+	if (retstatus != CAAM_NO_ERROR && retstatus != CAAM_JOB_STATUS) {
+		BLOB_TRACE("JR return code: %#"PRIx32, retstatus);
+		res = TEE_ERROR_GENERIC;
+		goto out;
+	}
+
+	for (n = 0; n < nb; n++) {
+		if (JRSTA_SRC_GET(jobs[n].jobctx.status) != JRSTA_SRC(NONE)) {
+			BLOB_TRACE("Blob %zu failed: Job status %#"PRIx32, n,
+				   jobs[n].jobctx.status);
+			res = job_status_to_tee_result(jobs[n].jobctx.status);
+			continue;
+		}
+
+		if (encaps) {
+			in = &data[n].payload;
+			out = &data[n].blob;
+		} else {
+			in = &data[n].blob;
+			out = &data[n].payload;
+		}
+
+		out_len = jobs[n].buf.length - data[n].key_mod.length -
+			  in->length;
+		cache_operation(TEE_CACHEINVALIDATE,
+				jobs[n].buf.data + jobs[n].buf.length - out_len,
+				out_len);
+		memcpy(out->data, jobs[n].buf.data + jobs[n].buf.length -
+		       out_len, out_len);
+		out->length = out_len;
+	}
+
+out:
+	free_jobs(jobs, nb);
+
+	return res;
+}
+
+/*
+ * Encapsulates or decapsulates @nb elements, the jobs being enqueued
+ * by batches of at most the number of Job Ring entries.
+ *
+ * @data    [in/out] Array of blob operation data
+ * @nb      Number of elements of @data
+ * @encaps  True for an encapsulation, false for a decapsulation
+ */
+static TEE_Result do_blob(struct drvcrypt_blob_data *data, size_t nb,
+			  bool encaps)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct blob_job *jobs = NULL;
+	struct drvcrypt_buf *in = NULL;
+	struct drvcrypt_buf *out = NULL;
+	size_t out_len = 0;
+	size_t n = 0;
+
+	/* Check all the sizes before running any job */
+	for (n = 0; n < nb; n++) {
+		if (encaps) {
+			in = &data[n].payload;
+			out = &data[n].blob;
+			if (ADD_OVERFLOW(in->length, BLOB_OVERHEAD, &out_len))
+				return TEE_ERROR_BAD_PARAMETERS;
+		} else {
+			in = &data[n].blob;
+			out = &data[n].payload;
+			if (in->length <= BLOB_OVERHEAD)
+				return TEE_ERROR_BAD_PARAMETERS;
+			out_len = in->length - BLOB_OVERHEAD;
+		}
+
+		if (!in->length)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		if (out->length < out_len) {
+			out->length = out_len;
+			res = TEE_ERROR_SHORT_BUFFER;
+		}
+	}
+
+	if (res)
+		return res;
+
+	jobs = caam_calloc(MIN(nb, (size_t)NB_JOBS_QUEUE) * sizeof(*jobs));
+	if (!jobs)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < nb && !res; n += NB_JOBS_QUEUE)
+		res = do_blob_batch(data + n,
+				    MIN(nb - n, (size_t)NB_JOBS_QUEUE), jobs,
+				    encaps);
+
+	caam_free(jobs);
+
+	return res;
+}
+
+static TEE_Result do_blob_encaps(struct drvcrypt_blob_data *data, size_t nb)
+{
+	return do_blob(data, nb, true);
+}
+
+static TEE_Result do_blob_decaps(struct drvcrypt_blob_data *data, size_t nb)
+{
+	return do_blob(data, nb, false);
+}
+
+/*
+ * Registration of the Blob Driver
+ */
+static const struct drvcrypt_blob driver_blob = {
+	.encaps = do_blob_encaps,
+	.decaps = do_blob_decaps,
+};
+#endif /* CFG_CRYPTO_DRV_BLOB */
+
 enum caam_status caam_blob_mkvb_init(vaddr_t baseaddr)
 {
 	struct caam_jobctx jobctx = { };
@@ -67,6 +323,11 @@ out_buf:
 out:
 	caam_hal_ctrl_inc_priblob(baseaddr);
 
+#ifdef CFG_CRYPTO_DRV_BLOB
+	if (res == CAAM_NO_ERROR && drvcrypt_register_blob(&driver_blob))
+		res = CAAM_FAILURE;
+#endif
+
 	return res;
 }
 
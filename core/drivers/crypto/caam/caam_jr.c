@@ -13,10 +13,15 @@
 #include <caam_rng.h>
 #include <caam_utils_delay.h>
 #include <caam_utils_mem.h>
+#ifdef CFG_CRYPTO_DRIVER
+#include <drvcrypt_async.h>
+#endif
 #include <kernel/interrupt.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <tee/cache.h>
 
@@ -46,6 +51,7 @@ struct jr_privdata {
 	uint64_t paddr_outrings; /* CAAM physical addr of output queue */
 
 	uint8_t nb_jobs;         /* Number of Job ring entries managed */
+	uint8_t first_job_id;    /* Bit of the first Job ID of the ring */
 
 	/* Input Job Ring Variables */
 	struct caam_inring_entry *inrings; /* Input JR HW queue */
@@ -65,9 +71,17 @@ struct jr_privdata {
 };
 
 /*
- * Job Ring module private data reference
+ * Job Ring module private data references, one per Job Ring
  */
-static struct jr_privdata *jr_privdata;
+static struct jr_privdata *jr_privdata[NB_JOB_RINGS];
+static unsigned int jr_count;
+
+#ifdef CFG_CRYPTO_DRIVER
+/*
+ * Job Ring asynchronous job queue
+ */
+static struct drvcrypt_queue jr_queue;
+#endif
 
 /*
  * Free module resources
@@ -168,13 +182,15 @@ static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
 /*
  * Returns all jobs completed depending on the input @wait_job_ids mask.
  *
- * Dequeues all Jobs completed. Call the job context callback
- * function. Function returns the bit mask of the expected completed job
- * (@wait_job_ids parameter)
+ * Dequeues all Jobs completed in the Job Ring. Call the job context
+ * callback function. Function returns the bit mask of the expected
+ * completed job (@wait_job_ids parameter)
  *
+ * @jr_priv       Job Ring private data
  * @wait_job_ids  Expected Jobs to be complete
  */
-static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
+static uint32_t do_jr_dequeue(struct jr_privdata *jr_priv,
+			      uint32_t wait_job_ids)
 {
 	uint32_t ret_job_id = 0;
 	struct caller_info *caller = NULL;
@@ -184,44 +200,46 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 	bool found = false;
 	uint16_t idx_jr = 0;
 	uint32_t nb_jobs_done = 0;
+	uint32_t nb_jobs_read = 0;
 	size_t nb_jobs_inv = 0;
 
-	exceptions = cpu_spin_lock_xsave(&jr_privdata->outlock);
+	exceptions = cpu_spin_lock_xsave(&jr_priv->outlock);
 
-	nb_jobs_done = caam_hal_jr_get_nbjob_done(jr_privdata->baseaddr);
+	nb_jobs_done = caam_hal_jr_get_nbjob_done(jr_priv->baseaddr);
 
 	if (nb_jobs_done == 0) {
-		cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
+		cpu_spin_unlock_xrestore(&jr_priv->outlock, exceptions);
 		return ret_job_id;
 	}
 
 	/* Ensure that output ring descriptor entries are not in cache */
-	if ((jr_privdata->outread_index + nb_jobs_done) >
-	    jr_privdata->nb_jobs) {
+	if ((jr_priv->outread_index + nb_jobs_done) >
+	    jr_priv->nb_jobs) {
 		/*
 		 * Invalidate the whole circular job buffer because some
 		 * completed job rings are at the beginning of the buffer
 		 */
-		jr_out = jr_privdata->outrings;
-		nb_jobs_inv = jr_privdata->nb_jobs;
+		jr_out = jr_priv->outrings;
+		nb_jobs_inv = jr_priv->nb_jobs;
 	} else {
 		/* Invalidate only the completed job */
-		jr_out = &jr_privdata->outrings[jr_privdata->outread_index];
+		jr_out = &jr_priv->outrings[jr_priv->outread_index];
 		nb_jobs_inv = nb_jobs_done;
 	}
 
 	cache_operation(TEE_CACHEINVALIDATE, jr_out,
 			sizeof(struct caam_outring_entry) * nb_jobs_inv);
 
+	nb_jobs_read = nb_jobs_done;
 	for (; nb_jobs_done; nb_jobs_done--) {
-		jr_out = &jr_privdata->outrings[jr_privdata->outread_index];
+		jr_out = &jr_priv->outrings[jr_priv->outread_index];
 
 		/*
 		 * Lock the caller information array because enqueue is
 		 * also touching it
 		 */
-		cpu_spin_lock(&jr_privdata->callers_lock);
-		for (idx_jr = 0, found = false; idx_jr < jr_privdata->nb_jobs;
+		cpu_spin_lock(&jr_priv->callers_lock);
+		for (idx_jr = 0, found = false; idx_jr < jr_priv->nb_jobs;
 		     idx_jr++) {
 			/*
 			 * Search for the caller information corresponding to
@@ -230,7 +248,7 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 			 * completion can be out of order compared to input
 			 * buffer
 			 */
-			caller = &jr_privdata->callers[idx_jr];
+			caller = &jr_priv->callers[idx_jr];
 			if (caam_desc_pop(jr_out) == caller->pdesc) {
 				jobctx = caller->jobctx;
 				jobctx->status = caam_read_jobstatus(jr_out);
@@ -252,20 +270,14 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 				break;
 			}
 		}
-		cpu_spin_unlock(&jr_privdata->callers_lock);
-
-		/*
-		 * Remove the JR from the output list even if no
-		 * JR caller found
-		 */
-		caam_hal_jr_del_job(jr_privdata->baseaddr);
+		cpu_spin_unlock(&jr_priv->callers_lock);
 
 		/*
 		 * Increment index to next JR output entry taking care that
 		 * it is a circular buffer of nb_jobs size.
 		 */
-		jr_privdata->outread_index++;
-		jr_privdata->outread_index %= jr_privdata->nb_jobs;
+		jr_priv->outread_index++;
+		jr_priv->outread_index %= jr_priv->nb_jobs;
 
 		if (found && jobctx->callback) {
 			/* Finally, execute user's callback */
@@ -273,36 +285,54 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
+	/*
+	 * Remove all the JR read from the output list at once, even
+	 * those for which no JR caller was found
+	 */
+	caam_hal_jr_del_job(jr_priv->baseaddr, nb_jobs_read);
+
+	cpu_spin_unlock_xrestore(&jr_priv->outlock, exceptions);
 
 	return ret_job_id;
 }
 
 /*
- * Enqueues a new job in the Job Ring input queue. Keep the caller's
- * job context in private array.
+ * Enqueues new jobs in the Job Ring input queue. Keep the callers'
+ * job context in private array. All jobs are pushed in the input queue
+ * before the HW is informed of them with a single register write.
+ * The Job ID of each job is set in its job context.
  *
- * @jobctx   Caller's job context
- * @job_id   [out] Job ID enqueued
+ * The jobs are enqueued in the Job Ring assigned to the current core so
+ * that the cores enqueue concurrently when several Job Rings are used.
+ *
+ * @jobctx   Callers' job contexts
+ * @nb_jobs  Number of jobs to enqueue
  */
-static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
-				      uint32_t *job_id)
+static enum caam_status do_jr_enqueue(struct caam_jobctx **jobctx,
+				      unsigned int nb_jobs)
 {
 	enum caam_status retstatus = CAAM_BUSY;
 	struct caam_inring_entry *cur_inrings = NULL;
 	struct caller_info *caller = NULL;
+	struct jr_privdata *jr_priv = NULL;
+	uint32_t *desc = NULL;
 	uint32_t exceptions = 0;
 	uint32_t job_mask = 0;
+	uint32_t job_reserved = 0;
 	uint8_t idx_jr = 0;
-	bool found = false;
+	unsigned int nb_found = 0;
+	unsigned int n = 0;
 
-	exceptions = cpu_spin_lock_xsave(&jr_privdata->inlock);
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	jr_priv = jr_privdata[get_core_pos() % jr_count];
+	cpu_spin_lock(&jr_priv->inlock);
 
 	/*
-	 * Stay locked until a job is available
-	 * Check if there is an available JR index in the HW
+	 * Stay locked until enough jobs are available
+	 * Check if there are available JR indexes in the HW
 	 */
-	while (caam_hal_jr_read_nbslot_available(jr_privdata->baseaddr) == 0) {
+	while (caam_hal_jr_read_nbslot_available(jr_priv->baseaddr) <
+	       nb_jobs) {
 		/*
 		 * WFE will return thanks to a SEV generated by the
 		 * interrupt handler or by a spin_unlock
@@ -311,71 +341,88 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	};
 
 	/*
-	 * There is a space free in the input ring but it doesn't mean
-	 * that the job pushed is completed.
-	 * Completion is out of order. Look for a free space in the
+	 * There are free spaces in the input ring but it doesn't mean
+	 * that the jobs pushed are completed.
+	 * Completion is out of order. Look for free spaces in the
 	 * caller data to push them and get a job ID for the completion
 	 *
 	 * Lock the caller information array because dequeue is
 	 * also touching it
 	 */
-	cpu_spin_lock(&jr_privdata->callers_lock);
-	for (idx_jr = 0; idx_jr < jr_privdata->nb_jobs; idx_jr++) {
-		if (jr_privdata->callers[idx_jr].job_id == JR_JOB_FREE) {
+	cpu_spin_lock(&jr_priv->callers_lock);
+	for (idx_jr = 0; idx_jr < jr_priv->nb_jobs && nb_found < nb_jobs;
+	     idx_jr++) {
+		if (jr_priv->callers[idx_jr].job_id == JR_JOB_FREE) {
 			JR_TRACE("Found a space #%" PRId8
 				 " free in the callers array",
 				 idx_jr);
-			job_mask = 1 << idx_jr;
+			job_mask = BIT32(jr_priv->first_job_id + idx_jr);
 
 			/* Store the caller information for the JR completion */
-			caller = &jr_privdata->callers[idx_jr];
+			caller = &jr_priv->callers[idx_jr];
 			caller->job_id = job_mask;
-			caller->jobctx = jobctx;
-			caller->pdesc = virt_to_phys((void *)jobctx->desc);
+			caller->jobctx = jobctx[nb_found];
+			caller->pdesc =
+				virt_to_phys((void *)jobctx[nb_found]->desc);
 
-			found = true;
-			break;
+			jobctx[nb_found]->id = job_mask;
+			job_reserved |= job_mask;
+			nb_found++;
 		}
 	}
-	cpu_spin_unlock(&jr_privdata->callers_lock);
 
-	if (!found) {
-		JR_TRACE("Error didn't find a free space in the callers array");
+	if (nb_found < nb_jobs) {
+		JR_TRACE("Error didn't find %u free spaces in the callers",
+			 nb_jobs);
+		/* Release the caller information already reserved */
+		for (idx_jr = 0; idx_jr < jr_priv->nb_jobs; idx_jr++) {
+			caller = &jr_priv->callers[idx_jr];
+			if (caller->job_id & job_reserved) {
+				caller->pdesc = 0;
+				caller->job_id = JR_JOB_FREE;
+			}
+		}
+		cpu_spin_unlock(&jr_priv->callers_lock);
 		goto end_enqueue;
 	}
+	cpu_spin_unlock(&jr_priv->callers_lock);
 
-	JR_TRACE("Push id=%" PRId16 ", job (0x%08" PRIx32
-		 ") context @0x%08" PRIxVA,
-		 jr_privdata->inwrite_index, job_mask, (vaddr_t)jobctx);
+	for (n = 0; n < nb_jobs; n++) {
+		JR_TRACE("Push id=%" PRId16 ", job (0x%08" PRIx32
+			 ") context @0x%08" PRIxVA,
+			 jr_priv->inwrite_index, jobctx[n]->id,
+			 (vaddr_t)jobctx[n]);
 
-	cur_inrings = &jr_privdata->inrings[jr_privdata->inwrite_index];
+		cur_inrings = &jr_priv->inrings[jr_priv->inwrite_index];
 
-	/* Push the descriptor into the JR HW list */
-	caam_desc_push(cur_inrings, caller->pdesc);
+		/* Push the descriptor into the JR HW list */
+		caam_desc_push(cur_inrings, virt_to_phys(jobctx[n]->desc));
 
-	/* Ensure that physical memory is up to date */
-	cache_operation(TEE_CACHECLEAN, cur_inrings,
-			sizeof(struct caam_inring_entry));
+		/* Ensure that physical memory is up to date */
+		cache_operation(TEE_CACHECLEAN, cur_inrings,
+				sizeof(struct caam_inring_entry));
 
-	/*
-	 * Increment index to next JR input entry taking care that
-	 * it is a circular buffer of nb_jobs size.
-	 */
-	jr_privdata->inwrite_index++;
-	jr_privdata->inwrite_index %= jr_privdata->nb_jobs;
+		/*
+		 * Increment index to next JR input entry taking care that
+		 * it is a circular buffer of nb_jobs size.
+		 */
+		jr_priv->inwrite_index++;
+		jr_priv->inwrite_index %= jr_priv->nb_jobs;
 
-	/* Ensure that input descriptor is pushed in physical memory */
-	cache_operation(TEE_CACHECLEAN, jobctx->desc,
-			DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
+		/* Ensure that input descriptor is pushed in physical memory */
+		desc = jobctx[n]->desc;
+		cache_operation(TEE_CACHECLEAN, desc,
+				DESC_SZBYTES(caam_desc_get_len(desc)));
+	}
 
-	/* Inform HW that a new JR is available */
-	caam_hal_jr_add_newjob(jr_privdata->baseaddr);
+	/* Inform HW that new JRs are available */
+	caam_hal_jr_add_newjob(jr_priv->baseaddr, nb_jobs);
 
-	*job_id = job_mask;
 	retstatus = CAAM_NO_ERROR;
 
 end_enqueue:
-	cpu_spin_unlock_xrestore(&jr_privdata->inlock, exceptions);
+	cpu_spin_unlock(&jr_priv->inlock);
+	thread_unmask_exceptions(exceptions);
 
 	return retstatus;
 }
@@ -390,20 +437,42 @@ static void job_done(struct caam_jobctx *jobctx)
 	jobctx->completion = true;
 }
 
+/*
+ * Returns the mask of the Job IDs of the Job Ring
+ *
+ * @jr_priv   Job Ring private data
+ */
+static uint32_t jr_job_ids(struct jr_privdata *jr_priv)
+{
+	return GENMASK_32(jr_priv->first_job_id + jr_priv->nb_jobs - 1,
+			  jr_priv->first_job_id);
+}
+
 void caam_jr_cancel(uint32_t job_id)
 {
+	struct jr_privdata *jr_priv = NULL;
 	unsigned int idx = 0;
+	unsigned int n = 0;
 
 	JR_TRACE("Job cancel 0x%" PRIx32, job_id);
-	for (idx = 0; idx < jr_privdata->nb_jobs; idx++) {
+	for (n = 0; n < jr_count; n++) {
+		jr_priv = jr_privdata[n];
+		if (job_id & jr_job_ids(jr_priv))
+			break;
+	}
+
+	if (n == jr_count)
+		return;
+
+	for (idx = 0; idx < jr_priv->nb_jobs; idx++) {
 		/*
 		 * Search for the caller information corresponding to
 		 * the job_id mask.
 		 */
-		if (jr_privdata->callers[idx].job_id == job_id) {
+		if (jr_priv->callers[idx].job_id == job_id) {
 			/* Clear the Entry Descriptor */
-			jr_privdata->callers[idx].pdesc = 0;
-			jr_privdata->callers[idx].job_id = JR_JOB_FREE;
+			jr_priv->callers[idx].pdesc = 0;
+			jr_priv->callers[idx].job_id = JR_JOB_FREE;
 			return;
 		}
 	}
@@ -411,9 +480,12 @@ void caam_jr_cancel(uint32_t job_id)
 
 enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 {
+	struct jr_privdata *jr_priv = NULL;
 	uint32_t job_complete = 0;
 	uint32_t nb_loop = 0;
 	bool infinite = false;
+	bool it_raised = false;
+	unsigned int n = 0;
 
 	if (timeout_ms == UINT_MAX)
 		infinite = true;
@@ -421,14 +493,25 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms)
 		nb_loop = timeout_ms * 100;
 
 	do {
-		/* Call the do_jr_dequeue function to dequeue the jobs */
-		job_complete = do_jr_dequeue(job_ids);
+		job_complete = 0;
+		it_raised = false;
+
+		/* Only the Job Rings of the expected jobs are dequeued */
+		for (n = 0; n < jr_count; n++) {
+			jr_priv = jr_privdata[n];
+			if (!(job_ids & jr_job_ids(jr_priv)))
+				continue;
+
+			job_complete |= do_jr_dequeue(jr_priv, job_ids);
+			if (caam_hal_jr_check_ack_itr(jr_priv->baseaddr))
+				it_raised = true;
+		}
 
 		if (job_complete & job_ids)
 			return CAAM_NO_ERROR;
 
-		/* Check if JR interrupt otherwise wait a bit */
-		if (!caam_hal_jr_check_ack_itr(jr_privdata->baseaddr))
+		/* Wait a bit if there is no JR interrupt */
+		if (!it_raised)
 			caam_udelay(10);
 	} while (infinite || (nb_loop--));
 
@@ -467,7 +550,7 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 		jobctx->context = jobctx;
 	}
 
-	retstatus = do_jr_enqueue(jobctx, &jobctx->id);
+	retstatus = do_jr_enqueue(&jobctx, 1);
 
 	if (retstatus != CAAM_NO_ERROR) {
 		JR_TRACE("enqueue job error 0x%08x", retstatus);
@@ -521,29 +604,161 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 	return retstatus;
 }
 
-enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
+enum caam_status caam_jr_enqueue_batch(struct caam_jobctx **jobctx,
+				       unsigned int nb_jobs)
 {
 	enum caam_status retstatus = CAAM_FAILURE;
+	uint32_t job_ids = 0;
+	unsigned int n = 0;
+
+	if (!jobctx || !nb_jobs || nb_jobs > jr_privdata[0]->nb_jobs)
+		return CAAM_BAD_PARAM;
+
+	for (n = 0; n < nb_jobs; n++)
+		if (!jobctx[n] || jobctx[n]->callback)
+			return CAAM_BAD_PARAM;
+
+	for (n = 0; n < nb_jobs; n++) {
+		JR_DUMPDESC(jobctx[n]->desc);
+
+		jobctx[n]->completion = false;
+		jobctx[n]->status = 0;
+		jobctx[n]->callback = job_done;
+		jobctx[n]->context = jobctx[n];
+	}
+
+	retstatus = do_jr_enqueue(jobctx, nb_jobs);
+	if (retstatus != CAAM_NO_ERROR) {
+		JR_TRACE("enqueue batch error 0x%08x", retstatus);
+		goto out;
+	}
+
+	/*
+	 * Jobs are synchronous, wait until all jobs complete.
+	 * Dequeue all the jobs completed at once on each wake up.
+	 */
+	while (true) {
+		job_ids = 0;
+		for (n = 0; n < nb_jobs; n++)
+			if (!jobctx[n]->completion)
+				job_ids |= jobctx[n]->id;
+
+		if (!job_ids)
+			break;
+
+		caam_jr_dequeue(job_ids, 100);
+	}
+
+	for (n = 0; n < nb_jobs; n++)
+		if (JRSTA_SRC_GET(jobctx[n]->status) != JRSTA_SRC(NONE))
+			retstatus = CAAM_JOB_STATUS;
+
+out:
+	/* Erase local callback function */
+	for (n = 0; n < nb_jobs; n++)
+		jobctx[n]->callback = NULL;
+
+	return retstatus;
+}
+
+#ifdef CFG_CRYPTO_DRIVER
+/*
+ * Asynchronous job completion callback, called from do_jr_dequeue()
+ *
+ * @jobctx   Job context
+ */
+static void async_job_done(struct caam_jobctx *jobctx)
+{
+	struct drvcrypt_job *job = jobctx->context;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
+		res = TEE_ERROR_GENERIC;
+
+	drvcrypt_job_complete(job, res);
+}
+
+/*
+ * Start an asynchronous job in the Job Ring
+ *
+ * @job   Job from the Job Ring queue
+ */
+static TEE_Result async_job_start(struct drvcrypt_job *job)
+{
+	struct caam_jobctx *jobctx = job->ctx;
+	uint32_t job_id = 0;
+
+	jobctx->callback = async_job_done;
+	jobctx->context = job;
+
+	switch (caam_jr_enqueue(jobctx, &job_id)) {
+	case CAAM_PENDING:
+		return TEE_SUCCESS;
+	case CAAM_BUSY:
+		return TEE_ERROR_BUSY;
+	default:
+		return TEE_ERROR_GENERIC;
+	}
+}
+
+/*
+ * Dequeue the Job Ring completed jobs, waiting at most 1ms for one
+ *
+ * @queue   Job Ring queue
+ */
+static void async_job_poll(struct drvcrypt_queue *queue __unused)
+{
+	caam_jr_dequeue(UINT32_MAX, 1);
+}
+
+static const struct drvcrypt_queue_ops jr_queue_ops = {
+	.start = async_job_start,
+	.poll = async_job_poll,
+};
+
+TEE_Result caam_jr_submit(struct drvcrypt_job *job)
+{
+	if (!job || !job->ctx)
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	JR_TRACE("Initialization");
+	if (!jr_queue.ops)
+		return TEE_ERROR_BAD_STATE;
+
+	return drvcrypt_job_submit(&jr_queue, job);
+}
+#endif /* CFG_CRYPTO_DRIVER */
+
+/*
+ * Initialize the Job Ring @idx of the configuration
+ *
+ * @jrcfg    Job Ring Configuration
+ * @idx      Index of the Job Ring in the configuration
+ * @privdata [out] Job Ring private data
+ */
+static enum caam_status do_jr_init(struct caam_jrcfg *jrcfg, unsigned int idx,
+				   struct jr_privdata **privdata)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	struct jr_privdata *jr_priv = NULL;
 
 	/* Allocate the Job Ring resources */
-	retstatus = do_jr_alloc(&jr_privdata, jrcfg->nb_jobs);
+	retstatus = do_jr_alloc(&jr_priv, jrcfg->nb_jobs);
 	if (retstatus != CAAM_NO_ERROR)
-		goto end_init;
+		return retstatus;
 
-	jr_privdata->ctrladdr = jrcfg->base;
-	jr_privdata->jroffset = jrcfg->offset;
+	jr_priv->ctrladdr = jrcfg->base;
+	jr_priv->jroffset = jrcfg->offset[idx];
+	jr_priv->first_job_id = idx * jrcfg->nb_jobs;
 
-	retstatus =
-		caam_hal_jr_setowner(jrcfg->base, jrcfg->offset, JROWN_ARM_S);
+	retstatus = caam_hal_jr_setowner(jrcfg->base, jr_priv->jroffset,
+					 JROWN_ARM_S);
 	JR_TRACE("JR setowner returned 0x%x", retstatus);
 
 	if (retstatus != CAAM_NO_ERROR)
 		goto end_init;
 
-	jr_privdata->baseaddr = jrcfg->base + jrcfg->offset;
-	retstatus = caam_hal_jr_reset(jr_privdata->baseaddr);
+	jr_priv->baseaddr = jrcfg->base + jr_priv->jroffset;
+	retstatus = caam_hal_jr_reset(jr_priv->baseaddr);
 	if (retstatus != CAAM_NO_ERROR)
 		goto end_init;
 
@@ -552,54 +767,109 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 	 * The HW configuration is 64 bits registers regardless
 	 * the CAAM or CPU addressing mode.
 	 */
-	jr_privdata->paddr_inrings = virt_to_phys(jr_privdata->inrings);
-	jr_privdata->paddr_outrings = virt_to_phys(jr_privdata->outrings);
-	if (!jr_privdata->paddr_inrings || !jr_privdata->paddr_outrings) {
+	jr_priv->paddr_inrings = virt_to_phys(jr_priv->inrings);
+	jr_priv->paddr_outrings = virt_to_phys(jr_priv->outrings);
+	if (!jr_priv->paddr_inrings || !jr_priv->paddr_outrings) {
 		JR_TRACE("JR bad queue pointers");
 		retstatus = CAAM_FAILURE;
 		goto end_init;
 	}
 
-	caam_hal_jr_config(jr_privdata->baseaddr, jr_privdata->nb_jobs,
-			   jr_privdata->paddr_inrings,
-			   jr_privdata->paddr_outrings);
+	caam_hal_jr_config(jr_priv->baseaddr, jr_priv->nb_jobs,
+			   jr_priv->paddr_inrings, jr_priv->paddr_outrings);
 
 	/*
 	 * Prepare the interrupt handler to secure the interrupt even
 	 * if the interrupt is not used
 	 */
-	jr_privdata->it_handler.it = jrcfg->it_num;
-	jr_privdata->it_handler.flags = ITRF_TRIGGER_LEVEL;
-	jr_privdata->it_handler.handler = caam_jr_irqhandler;
-	jr_privdata->it_handler.data = jr_privdata;
+	jr_priv->it_handler.it = jrcfg->it_num[idx];
+	jr_priv->it_handler.flags = ITRF_TRIGGER_LEVEL;
+	jr_priv->it_handler.handler = caam_jr_irqhandler;
+	jr_priv->it_handler.data = jr_priv;
 
 #ifdef CFG_NXP_CAAM_RUNTIME_JR
-	itr_add(&jr_privdata->it_handler);
+	itr_add(&jr_priv->it_handler);
 #endif
-	caam_hal_jr_enable_itr(jr_privdata->baseaddr);
+	caam_hal_jr_enable_itr(jr_priv->baseaddr);
 
 	retstatus = CAAM_NO_ERROR;
 
 end_init:
 	if (retstatus != CAAM_NO_ERROR)
-		do_jr_free(jr_privdata);
+		do_jr_free(jr_priv);
+	else
+		*privdata = jr_priv;
 
 	return retstatus;
 }
 
+enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	unsigned int n = 0;
+
+	JR_TRACE("Initialization of %" PRIu8 " Job Rings", jrcfg->nb_jr);
+
+	/* The Job IDs of all the Job Rings are bits of a 32 bits mask */
+	if (!jrcfg->nb_jr || jrcfg->nb_jr * jrcfg->nb_jobs > 32)
+		return CAAM_BAD_PARAM;
+
+	for (n = 0; n < jrcfg->nb_jr; n++) {
+		retstatus = do_jr_init(jrcfg, n, &jr_privdata[n]);
+		if (retstatus != CAAM_NO_ERROR) {
+			while (n--) {
+				do_jr_free(jr_privdata[n]);
+				jr_privdata[n] = NULL;
+			}
+			return retstatus;
+		}
+	}
+
+	jr_count = jrcfg->nb_jr;
+
+#ifdef CFG_CRYPTO_DRIVER
+	drvcrypt_queue_init(&jr_queue, &jr_queue_ops,
+			    jr_count * jrcfg->nb_jobs);
+#endif
+
+	return CAAM_NO_ERROR;
+}
+
 enum caam_status caam_jr_halt(void)
 {
-	return caam_hal_jr_halt(jr_privdata->baseaddr);
+	enum caam_status retstatus = CAAM_NO_ERROR;
+	unsigned int n = 0;
+
+	for (n = 0; n < jr_count && retstatus == CAAM_NO_ERROR; n++)
+		retstatus = caam_hal_jr_halt(jr_privdata[n]->baseaddr);
+
+	return retstatus;
 }
 
 enum caam_status caam_jr_flush(void)
 {
-	return caam_hal_jr_flush(jr_privdata->baseaddr);
+	enum caam_status retstatus = CAAM_NO_ERROR;
+	unsigned int n = 0;
+
+	for (n = 0; n < jr_count && retstatus == CAAM_NO_ERROR; n++)
+		retstatus = caam_hal_jr_flush(jr_privdata[n]->baseaddr);
+
+	return retstatus;
 }
 
 void caam_jr_resume(uint32_t pm_hint)
 {
-	if (pm_hint == PM_HINT_CONTEXT_STATE) {
+	struct jr_privdata *jr_priv = NULL;
+	unsigned int n = 0;
+
+	if (pm_hint != PM_HINT_CONTEXT_STATE) {
+		for (n = 0; n < jr_count; n++)
+			caam_hal_jr_resume(jr_privdata[n]->baseaddr);
+		return;
+	}
+
+	for (n = 0; n < jr_count; n++) {
+		jr_priv = jr_privdata[n];
 #ifndef CFG_NXP_CAAM_RUNTIME_JR
 		/*
 		 * In case the CAAM is not used the JR used to
@@ -607,40 +877,44 @@ void caam_jr_resume(uint32_t pm_hint)
 		 * hence, need reconfigure the Secure JR and release
 		 * it after RNG instantiation
 		 */
-		caam_hal_jr_setowner(jr_privdata->ctrladdr,
-				     jr_privdata->jroffset, JROWN_ARM_S);
+		caam_hal_jr_setowner(jr_priv->ctrladdr, jr_priv->jroffset,
+				     JROWN_ARM_S);
 
-		caam_hal_jr_config(jr_privdata->baseaddr, jr_privdata->nb_jobs,
-				   jr_privdata->paddr_inrings,
-				   jr_privdata->paddr_outrings);
+		caam_hal_jr_config(jr_priv->baseaddr, jr_priv->nb_jobs,
+				   jr_priv->paddr_inrings,
+				   jr_priv->paddr_outrings);
 #endif /* CFG_NXP_CAAM_RUNTIME_JR */
 
 		/* Read the current job ring index */
-		jr_privdata->inwrite_index =
-			caam_hal_jr_input_index(jr_privdata->baseaddr);
+		jr_priv->inwrite_index =
+			caam_hal_jr_input_index(jr_priv->baseaddr);
 		/* Read the current output ring index */
-		jr_privdata->outread_index =
-			caam_hal_jr_output_index(jr_privdata->baseaddr);
+		jr_priv->outread_index =
+			caam_hal_jr_output_index(jr_priv->baseaddr);
+	}
 
-		if (caam_rng_instantiation() != CAAM_NO_ERROR)
-			panic();
+	if (caam_rng_instantiation() != CAAM_NO_ERROR)
+		panic();
 
 #ifndef CFG_NXP_CAAM_RUNTIME_JR
-		caam_hal_jr_setowner(jr_privdata->ctrladdr,
-				     jr_privdata->jroffset, JROWN_ARM_NS);
+	for (n = 0; n < jr_count; n++)
+		caam_hal_jr_setowner(jr_privdata[n]->ctrladdr,
+				     jr_privdata[n]->jroffset, JROWN_ARM_NS);
 #endif /* CFG_NXP_CAAM_RUNTIME_JR */
-	} else {
-		caam_hal_jr_resume(jr_privdata->baseaddr);
-	}
 }
 
 enum caam_status caam_jr_complete(void)
 {
-	enum caam_status ret = CAAM_BUSY;
+	enum caam_status ret = CAAM_NO_ERROR;
+	unsigned int n = 0;
 
-	ret = caam_hal_jr_flush(jr_privdata->baseaddr);
-	if (ret == CAAM_NO_ERROR)
-		caam_hal_jr_resume(jr_privdata->baseaddr);
+	for (n = 0; n < jr_count; n++) {
+		ret = caam_hal_jr_flush(jr_privdata[n]->baseaddr);
+		if (ret != CAAM_NO_ERROR)
+			return ret;
+
+		caam_hal_jr_resume(jr_privdata[n]->baseaddr);
+	}
 
 	return ret;
 }
@@ -13,11 +13,34 @@
 #include <mm/core_memprot.h>
 #include <registers/jr_regs.h>
 
+/*
+ * Returns true if the Job Ring at @jr_offset is reserved for the Secure
+ * environment
+ *
+ * @jrcfg      Job Ring configuration
+ * @jr_offset  Job Ring address offset
+ */
+static __maybe_unused bool is_secure_jobring(struct caam_jrcfg *jrcfg,
+					     paddr_t jr_offset)
+{
+	unsigned int n = 0;
+
+	for (n = 0; n < jrcfg->nb_jr; n++)
+		if (jrcfg->offset[n] == jr_offset)
+			return true;
+
+	return false;
+}
+
 enum caam_status caam_hal_cfg_get_conf(struct caam_jrcfg *jrcfg)
 {
 	enum caam_status retstatus = CAAM_FAILURE;
 	vaddr_t ctrl_base = 0;
 	void *fdt = NULL;
+	/* The Job IDs of all the Job Rings are bits of a 32 bits mask */
+	unsigned int nb_jr = MIN(NB_JOB_RINGS, 32 / NB_JOBS_QUEUE);
+	unsigned int jrnum = 0;
+	unsigned int n = 0;
 
 	fdt = get_dt();
 
@@ -49,21 +72,35 @@ enum caam_status caam_hal_cfg_get_conf(struct caam_jrcfg *jrcfg)
 
 	jrcfg->base = ctrl_base;
 
+#ifndef CFG_NXP_CAAM_RUNTIME_JR
+	/* The Job Ring is only used at boot time, one is enough */
+	nb_jr = 1;
+#endif
+
 	/*
-	 * Next get the Job Ring reserved for the Secure environment
+	 * Next get the Job Rings reserved for the Secure environment
 	 * into the DTB. If nothing reserved use the default hard coded
-	 * value.
+	 * values: the Job Rings following CFG_JR_INDEX with consecutive
+	 * interrupt numbers.
 	 */
 	if (fdt)
-		caam_hal_cfg_get_jobring_dt(fdt, jrcfg);
+		caam_hal_cfg_get_jobring_dt(fdt, jrcfg, nb_jr);
+
+	if (!jrcfg->nb_jr) {
+		jrnum = caam_hal_ctrl_jrnum(ctrl_base);
+		if (jrnum > CFG_JR_INDEX)
+			nb_jr = MIN(nb_jr, jrnum - CFG_JR_INDEX);
 
-	if (!jrcfg->offset) {
-		jrcfg->offset = (CFG_JR_INDEX + 1) * JRX_BLOCK_SIZE;
-		jrcfg->it_num = CFG_JR_INT;
+		for (n = 0; n < nb_jr; n++) {
+			jrcfg->offset[n] = (CFG_JR_INDEX + 1 + n) *
+					   JRX_BLOCK_SIZE;
+			jrcfg->it_num[n] = CFG_JR_INT + n;
+		}
+		jrcfg->nb_jr = nb_jr;
 
 #ifdef CFG_NXP_CAAM_RUNTIME_JR
 		if (fdt) {
-			/* Ensure Secure Job Ring is secure only into DTB */
+			/* Ensure Secure Job Rings are secure only into DTB */
 			caam_hal_cfg_disable_jobring_dt(fdt, jrcfg);
 		}
 #endif
@@ -94,7 +131,7 @@ void caam_hal_cfg_setup_nsjobring(struct caam_jrcfg *jrcfg)
 		 * But save the configuration to restore it when
 		 * device reset after suspend.
 		 */
-		if (jr_offset == jrcfg->offset) {
+		if (is_secure_jobring(jrcfg, jr_offset)) {
 			caam_hal_jr_prepare_backup(jrcfg->base, jr_offset);
 			continue;
 		}
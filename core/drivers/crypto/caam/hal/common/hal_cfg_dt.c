@@ -22,20 +22,23 @@ static const char *dt_jr_match_table = {
 };
 
 /*
- * Finds the Job Ring reserved for the Secure Mode in the DTB
+ * Finds the next Job Ring reserved for the Secure Mode in the DTB
  *
  * @fdt         Reference to the Device Tree
  * @status      Status mask flag of the node to found
+ * @start_node  Node offset to start the search after
  * @find_node   [out] Node offset found
  */
-static paddr_t find_jr_offset(void *fdt, int status, int *find_node)
+static paddr_t find_jr_offset(void *fdt, int status, int start_node,
+			      int *find_node)
 {
 	paddr_t jr_offset = 0;
-	int node = fdt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
+	int node = dt_node_offset_by_compatible(fdt, start_node,
+						dt_jr_match_table);
 
 	for (; node != -FDT_ERR_NOTFOUND;
-	     node = fdt_node_offset_by_compatible(fdt, node,
-						  dt_jr_match_table)) {
+	     node = dt_node_offset_by_compatible(fdt, node,
+						 dt_jr_match_table)) {
 		HAL_TRACE("Found Job Ring node status @%" PRId32, node);
 		if (_fdt_get_status(fdt, node) == status) {
 			HAL_TRACE("Found Job Ring node @%" PRId32, node);
@@ -57,7 +60,7 @@ void caam_hal_cfg_get_ctrl_dt(void *fdt, vaddr_t *ctrl_base)
 
 	*ctrl_base = 0;
 	/* Get the CAAM Node to get the controller base address */
-	node = fdt_node_offset_by_compatible(fdt, 0, dt_caam_match_table);
+	node = dt_node_offset_by_compatible(fdt, 0, dt_caam_match_table);
 
 	if (node < 0)
 		return;
@@ -91,14 +94,20 @@ void caam_hal_cfg_get_ctrl_dt(void *fdt, vaddr_t *ctrl_base)
 	HAL_TRACE("Map Controller 0x%" PRIxVA, *ctrl_base);
 }
 
-void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
+void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg,
+				 unsigned int nb_jr)
 {
 	paddr_t jr_offset = 0;
 	int jr_it_num = 0;
 	int node = 0;
 
-	jr_offset = find_jr_offset(fdt, DT_STATUS_OK_SEC, &node);
-	if (jr_offset) {
+	jrcfg->nb_jr = 0;
+
+	while (jrcfg->nb_jr < nb_jr) {
+		jr_offset = find_jr_offset(fdt, DT_STATUS_OK_SEC, node, &node);
+		if (!jr_offset)
+			return;
+
 		/* Disable JR for Normal World */
 		if (dt_enable_secure_status(fdt, node)) {
 			EMSG("Not able to disable JR DTB entry");
@@ -112,25 +121,32 @@ void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
 			return;
 		}
 
-		jrcfg->offset = jr_offset;
+		jrcfg->offset[jrcfg->nb_jr] = jr_offset;
 		/* Add index of the first SPI interrupt */
-		jrcfg->it_num = jr_it_num + 32;
+		jrcfg->it_num[jrcfg->nb_jr] = jr_it_num + 32;
+		jrcfg->nb_jr++;
 	}
 }
 
 void caam_hal_cfg_disable_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
 {
-	int node = fdt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
+	int node = dt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
+
+	paddr_t jr_offset = 0;
+	unsigned int n = 0;
 
 	for (; node != -FDT_ERR_NOTFOUND;
-	     node = fdt_node_offset_by_compatible(fdt, node,
-						  dt_jr_match_table)) {
+	     node = dt_node_offset_by_compatible(fdt, node,
+						 dt_jr_match_table)) {
 		HAL_TRACE("Found Job Ring node @%" PRId32, node);
-		if (_fdt_reg_base_address(fdt, node) == jrcfg->offset) {
+		jr_offset = _fdt_reg_base_address(fdt, node);
+		for (n = 0; n < jrcfg->nb_jr; n++) {
+			if (jr_offset != jrcfg->offset[n])
+				continue;
+
 			HAL_TRACE("Disable Job Ring node @%" PRId32, node);
 			if (dt_enable_secure_status(fdt, node))
 				panic();
-			break;
 		}
 	}
 }
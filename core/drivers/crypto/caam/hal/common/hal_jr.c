@@ -73,6 +73,7 @@ enum caam_status caam_hal_jr_reset(vaddr_t baseaddr)
 void caam_hal_jr_config(vaddr_t baseaddr, uint8_t nbjobs, uint64_t inrings,
 			uint64_t outrings)
 {
+	uint32_t coal_count = 0;
 	uint32_t value = 0;
 
 	/* Setup the JR input queue */
@@ -101,12 +102,18 @@ void caam_hal_jr_config(vaddr_t baseaddr, uint8_t nbjobs, uint64_t inrings,
 	/*
 	 * Configure interrupt and disable it:
 	 * Optimization to generate an interrupt either when there are
-	 *   half of the job done
-	 *   or when there is a job done and 10 clock cycles elapsed without
-	 *      new job completion
+	 *   CFG_NXP_CAAM_JR_COAL_COUNT jobs done (default half of the jobs)
+	 *   or when there is a job done and CFG_NXP_CAAM_JR_COAL_TIMER clock
+	 *      cycles elapsed without new job completion
 	 */
-	value = JRX_JRCFGR_LS_ICTT(10);
-	value |= JRX_JRCFGR_LS_ICDCT(nbjobs / 2);
+	if (CFG_NXP_CAAM_JR_COAL_COUNT)
+		coal_count = MIN((uint32_t)CFG_NXP_CAAM_JR_COAL_COUNT,
+				 (uint32_t)nbjobs);
+	else
+		coal_count = nbjobs / 2;
+
+	value = JRX_JRCFGR_LS_ICTT(CFG_NXP_CAAM_JR_COAL_TIMER);
+	value |= JRX_JRCFGR_LS_ICDCT(coal_count);
 	value |= JRX_JRCFGR_LS_ICEN;
 	value |= JRX_JRCFGR_LS_IMSK;
 	io_caam_write32(baseaddr + JRX_JRCFGR_LS, value);
@@ -121,9 +128,9 @@ uint32_t caam_hal_jr_read_nbslot_available(vaddr_t baseaddr)
 	return io_caam_read32(baseaddr + JRX_IRSAR);
 }
 
-void caam_hal_jr_add_newjob(vaddr_t baseaddr)
+void caam_hal_jr_add_newjob(vaddr_t baseaddr, uint32_t nb_jobs)
 {
-	io_caam_write32(baseaddr + JRX_IRJAR, 1);
+	io_caam_write32(baseaddr + JRX_IRJAR, nb_jobs);
 }
 
 uint32_t caam_hal_jr_get_nbjob_done(vaddr_t baseaddr)
@@ -131,9 +138,9 @@ uint32_t caam_hal_jr_get_nbjob_done(vaddr_t baseaddr)
 	return io_caam_read32(baseaddr + JRX_ORSFR);
 }
 
-void caam_hal_jr_del_job(vaddr_t baseaddr)
+void caam_hal_jr_del_job(vaddr_t baseaddr, uint32_t nb_jobs)
 {
-	io_caam_write32(baseaddr + JRX_ORJRR, 1);
+	io_caam_write32(baseaddr + JRX_ORJRR, nb_jobs);
 }
 
 void caam_hal_jr_disable_itr(vaddr_t baseaddr)
@@ -37,15 +37,18 @@ void caam_hal_cfg_setup_nsjobring(struct caam_jrcfg *jrcfg);
 void caam_hal_cfg_get_ctrl_dt(void *fdt, vaddr_t *ctrl_base);
 
 /*
- * Returns the Job Ring configuration to be used by the TEE
+ * Returns the Job Rings configuration to be used by the TEE, at most
+ * @nb_jr Job Rings reserved for the secure world are taken
  *
  * @fdt     Device Tree handle
  * @jrcfg   [out] Job Ring configuration
+ * @nb_jr   Maximum number of Job Rings
  */
-void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg);
+void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg,
+				 unsigned int nb_jr);
 
 /*
- * Disable the DT node related to the Job Ring used by secure world
+ * Disable the DT nodes related to the Job Rings used by secure world
  *
  * @fdt     Device Tree handle
  * @jrcfg   Job Ring configuration
@@ -60,10 +63,10 @@ static inline void caam_hal_cfg_get_ctrl_dt(void *fdt __unused,
 
 static inline void
 caam_hal_cfg_get_jobring_dt(void *fdt __unused,
-			    struct caam_jrcfg *jrcfg)
+			    struct caam_jrcfg *jrcfg,
+			    unsigned int nb_jr __unused)
 {
-	jrcfg->offset = 0;
-	jrcfg->it_num = 0;
+	jrcfg->nb_jr = 0;
 }
 
 static inline void
@@ -47,11 +47,12 @@ void caam_hal_jr_config(vaddr_t baseaddr, uint8_t nbjobs, uint64_t inrings,
 uint32_t caam_hal_jr_read_nbslot_available(vaddr_t baseaddr);
 
 /*
- * Indicates to HW that a new job is available
+ * Indicates to HW that new jobs are available
  *
  * @baseaddr   Job Ring Base Address
+ * @nb_jobs    Number of jobs added to the input ring
  */
-void caam_hal_jr_add_newjob(vaddr_t baseaddr);
+void caam_hal_jr_add_newjob(vaddr_t baseaddr, uint32_t nb_jobs);
 
 /*
  * Returns the number of job completed and present in the output ring slots
@@ -61,11 +62,12 @@ void caam_hal_jr_add_newjob(vaddr_t baseaddr);
 uint32_t caam_hal_jr_get_nbjob_done(vaddr_t baseaddr);
 
 /*
- * Removes a job from the job ring output queue
+ * Removes jobs from the job ring output queue
  *
  * @baseaddr   Job Ring Base Address
+ * @nb_jobs    Number of jobs read from the output ring
  */
-void caam_hal_jr_del_job(vaddr_t baseaddr);
+void caam_hal_jr_del_job(vaddr_t baseaddr, uint32_t nb_jobs);
 
 /*
  * Disable and acknwoledge the Job Ring interrupt
@@ -8,6 +8,7 @@
 #define __CAAM_JR_H__
 
 #include <caam_jr_status.h>
+#include <tee_api_types.h>
 #include <types_ext.h>
 
 /*
@@ -22,14 +23,24 @@ struct caam_jobctx {
 	void (*callback)(struct caam_jobctx *ctx); /* job completion callback */
 };
 
+/*
+ * Definition of the number of Job Rings reserved for the Secure world
+ */
+#if defined(CFG_NXP_CAAM_JR_NUM)
+#define NB_JOB_RINGS	CFG_NXP_CAAM_JR_NUM
+#else
+#define NB_JOB_RINGS	1
+#endif
+
 /*
  * Job Ring module configuration
  */
 struct caam_jrcfg {
-	vaddr_t base;    /* CAAM virtual base address */
-	paddr_t offset;  /* Job Ring address offset */
-	int it_num;      /* Job Ring interrupt number */
-	uint8_t nb_jobs; /* Number of Jobs to managed */
+	vaddr_t base;                 /* CAAM virtual base address */
+	paddr_t offset[NB_JOB_RINGS]; /* Job Rings address offset */
+	int it_num[NB_JOB_RINGS];     /* Job Rings interrupt number */
+	uint8_t nb_jr;                /* Number of Job Rings configured */
+	uint8_t nb_jobs;              /* Number of Jobs to managed per ring */
 };
 
 /*
@@ -61,7 +72,9 @@ struct caam_outring_entry {
 #endif /* CFG_CAAM_64BIT */
 
 /*
- * Initialization of the CAAM Job Ring module
+ * Initialization of the CAAM Job Ring module. All the Job Rings of
+ * the configuration are used, the jobs being distributed on them
+ * depending on the core enqueuing them.
  *
  * @jrcfg  Job Ring Configuration
  */
@@ -96,16 +109,42 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms);
 enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id);
 
 /*
- * Request the CAAM JR to halt.
- * Stop fetching input queue and wait running job completion.
+ * Enqueues @nb_jobs synchronous jobs in the Job Ring input queue, informing
+ * the HW of all of them at once, and waits until all jobs are completed.
+ * Returns CAAM_JOB_STATUS if at least one of the jobs failed, the status
+ * of each job being set in its job context.
+ *
+ * @jobctx   Array of references to the job contexts
+ * @nb_jobs  Number of jobs, at most the number of Job Ring entries
+ */
+enum caam_status caam_jr_enqueue_batch(struct caam_jobctx **jobctx,
+				       unsigned int nb_jobs);
+
+#ifdef CFG_CRYPTO_DRIVER
+struct drvcrypt_job;
+
+/*
+ * Submits an asynchronous job to the Job Ring queue of the crypto driver
+ * (see drvcrypt_async.h). The @job->ctx is the CAAM job context whose
+ * callback and context fields are used by the Job Ring queue. Completion
+ * is waited with drvcrypt_job_wait().
+ *
+ * @job  Reference to the job
+ */
+TEE_Result caam_jr_submit(struct drvcrypt_job *job);
+#endif
+
+/*
+ * Request the CAAM JRs to halt.
+ * Stop fetching input queues and wait running jobs completion.
  */
 enum caam_status caam_jr_halt(void);
 
-/* Request the CAAM JR to flush all job running. */
+/* Request the CAAM JRs to flush all job running. */
 enum caam_status caam_jr_flush(void);
 
 /*
- * Resume the CAAM JR processing.
+ * Resume the CAAM JRs processing.
  *
  * @pm_hints  Hint on current power transition
  */
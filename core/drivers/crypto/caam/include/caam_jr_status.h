@@ -24,6 +24,8 @@
 
 #define JRSTA_CCB_GET_ERR(status) ((status) & SHIFT_U32(0xFF, 0))
 #define JRSTA_CCB_CHAID_RNG       SHIFT_U32(0x5, 4)
+#define JRSTA_CCB_ERRID_MASK      SHIFT_U32(0xF, 0)
+#define JRSTA_CCB_ERRID_ICV       SHIFT_U32(0xA, 0)
 #define JRSTA_CCB_ERRID_HW        SHIFT_U32(0xB, 0)
 #define JRSTA_DECO_ERRID_FORMAT   SHIFT_U32(0x88, 0)
 
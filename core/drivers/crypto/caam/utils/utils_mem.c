@@ -459,6 +459,23 @@ int caam_mem_get_pa_area(struct caambuf *buf, struct caambuf **out_pabufs)
 	MEM_TRACE("Get PA Areas of %p-%zu (out %p)", buf->data, buf->length,
 		  out_pabufs);
 
+	/* Avoid translating each page when the area is known to be linear */
+	if (core_vbuf_is_pa_contiguous(buf->data, buf->length)) {
+		if (out_pabufs) {
+			pabufs = caam_calloc(sizeof(*pabufs));
+			if (!pabufs)
+				return -1;
+
+			pabufs->data = buf->data;
+			pabufs->paddr = virt_to_phys(buf->data);
+			pabufs->length = buf->length;
+			pabufs->nocache = buf->nocache;
+			*out_pabufs = pabufs;
+		}
+
+		return 1;
+	}
+
 	if (out_pabufs) {
 		/*
 		 * Caller asked for the extracted contiguous
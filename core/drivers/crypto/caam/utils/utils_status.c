@@ -18,6 +18,11 @@ TEE_Result job_status_to_tee_result(uint32_t status)
 		if (JRSTA_CCB_GET_ERR(status) == JRSTA_DECO_ERRID_FORMAT)
 			return TEE_ERROR_BAD_PARAMETERS;
 		break;
+	case JRSTA_SRC(CCB):
+		if ((JRSTA_CCB_GET_ERR(status) & JRSTA_CCB_ERRID_MASK) ==
+		    JRSTA_CCB_ERRID_ICV)
+			return TEE_ERROR_MAC_INVALID;
+		break;
 	default:
 		break;
 	}
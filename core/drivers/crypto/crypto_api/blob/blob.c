@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ *
+ * Brief   Blob interface calling the HW crypto driver.
+ */
+#include <drvcrypt.h>
+#include <drvcrypt_blob.h>
+
+/*
+ * Checks the blob operation data
+ *
+ * @data   Array of blob operation data
+ * @nb     Number of elements of @data
+ */
+static TEE_Result check_data(struct drvcrypt_blob_data *data, size_t nb)
+{
+	size_t n = 0;
+
+	if (!data || !nb)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < nb; n++) {
+		if (!data[n].key_mod.data ||
+		    data[n].key_mod.length != DRVCRYPT_BLOB_KEY_MOD_SIZE)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		if ((!data[n].payload.data && data[n].payload.length) ||
+		    (!data[n].blob.data && data[n].blob.length))
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result drvcrypt_blob_encaps(struct drvcrypt_blob_data *data, size_t nb)
+{
+	struct drvcrypt_blob *blob = NULL;
+	TEE_Result ret = TEE_ERROR_GENERIC;
+
+	ret = check_data(data, nb);
+	if (ret)
+		return ret;
+
+	blob = drvcrypt_get_ops(CRYPTO_BLOB);
+	if (!blob || !blob->encaps)
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	ret = blob->encaps(data, nb);
+	CRYPTO_TRACE("Blob encapsulation of %zu elements ret 0x%" PRIx32, nb,
+		     ret);
+
+	return ret;
+}
+
+TEE_Result drvcrypt_blob_decaps(struct drvcrypt_blob_data *data, size_t nb)
+{
+	struct drvcrypt_blob *blob = NULL;
+	TEE_Result ret = TEE_ERROR_GENERIC;
+
+	ret = check_data(data, nb);
+	if (ret)
+		return ret;
+
+	blob = drvcrypt_get_ops(CRYPTO_BLOB);
+	if (!blob || !blob->decaps)
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	ret = blob->decaps(data, nb);
+	CRYPTO_TRACE("Blob decapsulation of %zu elements ret 0x%" PRIx32, nb,
+		     ret);
+
+	return ret;
+}
@@ -0,0 +1 @@
+srcs-y += blob.c
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ *
+ * Brief   Crypto Driver asynchronous job queue.
+ */
+#include <drvcrypt.h>
+#include <drvcrypt_async.h>
+#include <kernel/spinlock.h>
+
+void drvcrypt_queue_init(struct drvcrypt_queue *queue,
+			 const struct drvcrypt_queue_ops *ops,
+			 unsigned int depth)
+{
+	queue->ops = ops;
+	queue->depth = depth;
+	queue->nb_running = 0;
+	queue->polling = false;
+	queue->done_lock = SPINLOCK_UNLOCK;
+	mutex_init(&queue->mu);
+	condvar_init(&queue->cv);
+	TAILQ_INIT(&queue->pending);
+	TAILQ_INIT(&queue->running);
+}
+
+void drvcrypt_job_complete(struct drvcrypt_job *job, TEE_Result res)
+{
+	struct drvcrypt_queue *queue = job->queue;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&queue->done_lock);
+	job->result = res;
+	job->hw_done = true;
+	cpu_spin_unlock_xrestore(&queue->done_lock, exceptions);
+}
+
+/*
+ * Start as many pending jobs as the hardware accepts.
+ * Called with the queue mutex held.
+ *
+ * @queue  Driver queue
+ */
+static void start_pending(struct drvcrypt_queue *queue)
+{
+	struct drvcrypt_job *job = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	while (queue->nb_running < queue->depth) {
+		job = TAILQ_FIRST(&queue->pending);
+		if (!job)
+			return;
+
+		TAILQ_REMOVE(&queue->pending, job, link);
+		TAILQ_INSERT_TAIL(&queue->running, job, link);
+		queue->nb_running++;
+
+		res = queue->ops->start(job);
+		if (res == TEE_ERROR_BUSY) {
+			/* Retry once a running job is completed */
+			TAILQ_REMOVE(&queue->running, job, link);
+			queue->nb_running--;
+			TAILQ_INSERT_HEAD(&queue->pending, job, link);
+			return;
+		}
+
+		if (res) {
+			CRYPTO_TRACE("Job %p start error 0x%" PRIx32, job, res);
+			drvcrypt_job_complete(job, res);
+		}
+	}
+}
+
+/*
+ * Remove the jobs completed by the hardware from the running list and
+ * call their completion callback. Returns true if a job was completed.
+ * Called with the queue mutex held.
+ *
+ * @queue  Driver queue
+ */
+static bool reap_completed(struct drvcrypt_queue *queue)
+{
+	struct drvcrypt_job *job = NULL;
+	struct drvcrypt_job *next = NULL;
+	uint32_t exceptions = 0;
+	bool hw_done = false;
+	bool reaped = false;
+
+	for (job = TAILQ_FIRST(&queue->running); job; job = next) {
+		next = TAILQ_NEXT(job, link);
+
+		exceptions = cpu_spin_lock_xsave(&queue->done_lock);
+		hw_done = job->hw_done;
+		cpu_spin_unlock_xrestore(&queue->done_lock, exceptions);
+		if (!hw_done)
+			continue;
+
+		TAILQ_REMOVE(&queue->running, job, link);
+		queue->nb_running--;
+
+		if (job->callback)
+			job->callback(job);
+		job->done = true;
+		reaped = true;
+	}
+
+	return reaped;
+}
+
+TEE_Result drvcrypt_job_submit(struct drvcrypt_queue *queue,
+			       struct drvcrypt_job *job)
+{
+	if (!queue || !queue->ops || !job)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	job->queue = queue;
+	job->result = TEE_ERROR_GENERIC;
+	job->hw_done = false;
+	job->done = false;
+
+	mutex_lock(&queue->mu);
+	TAILQ_INSERT_TAIL(&queue->pending, job, link);
+	start_pending(queue);
+	mutex_unlock(&queue->mu);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job)
+{
+	struct drvcrypt_queue *queue = job->queue;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	mutex_lock(&queue->mu);
+	while (!job->done) {
+		/*
+		 * Only one thread polls the hardware, the other ones sleep
+		 * until it reports completed jobs or leaves.
+		 */
+		if (queue->polling) {
+			condvar_wait(&queue->cv, &queue->mu);
+			continue;
+		}
+
+		queue->polling = true;
+		mutex_unlock(&queue->mu);
+		queue->ops->poll(queue);
+		mutex_lock(&queue->mu);
+		queue->polling = false;
+
+		if (reap_completed(queue))
+			condvar_broadcast(&queue->cv);
+
+		/* Keep the hardware busy with the jobs left pending */
+		start_pending(queue);
+	}
+	res = job->result;
+	mutex_unlock(&queue->mu);
+
+	return res;
+}
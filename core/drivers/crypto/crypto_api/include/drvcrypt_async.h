@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ *
+ * Brief   Crypto Driver asynchronous job interface.
+ *         A driver owns a job queue, jobs are submitted to the queue and
+ *         started on the hardware as soon as it can accept them. The
+ *         submitting thread can then wait for the completion of its job,
+ *         sleeping on the queue while another thread collects the
+ *         completed jobs from the hardware.
+ *         Completed jobs are only collected by threads waiting in
+ *         drvcrypt_job_wait().
+ */
+#ifndef __DRVCRYPT_ASYNC_H__
+#define __DRVCRYPT_ASYNC_H__
+
+#include <drvcrypt.h>
+#include <kernel/mutex.h>
+#include <sys/queue.h>
+
+struct drvcrypt_queue;
+
+/*
+ * Asynchronous job
+ */
+struct drvcrypt_job {
+	struct drvcrypt_queue *queue; /* Queue the job is submitted to */
+	void *ctx;		      /* Driver's job context */
+	/*
+	 * Optional completion callback, called in thread context with the
+	 * queue locked, hence it must not submit a new job to the queue.
+	 */
+	void (*callback)(struct drvcrypt_job *job);
+	TEE_Result result;	      /* Result of the job */
+	bool hw_done;		      /* Job completed by the hardware */
+	bool done;		      /* Job completed and callback called */
+	TAILQ_ENTRY(drvcrypt_job) link;
+};
+
+/*
+ * Driver queue operations
+ */
+struct drvcrypt_queue_ops {
+	/*
+	 * Start the job on the hardware. Returns TEE_ERROR_BUSY if the
+	 * hardware can't accept more jobs for now.
+	 */
+	TEE_Result (*start)(struct drvcrypt_job *job);
+	/*
+	 * Collect the jobs completed by the hardware calling
+	 * drvcrypt_job_complete() for each of them. May wait a bit for a
+	 * job completion but must return in a bounded amount of time.
+	 */
+	void (*poll)(struct drvcrypt_queue *queue);
+};
+
+/*
+ * Driver job queue
+ */
+struct drvcrypt_queue {
+	const struct drvcrypt_queue_ops *ops;
+	unsigned int depth;	   /* Maximum number of running jobs */
+	unsigned int nb_running;   /* Number of jobs started on hardware */
+	bool polling;		   /* A thread is polling the hardware */
+	unsigned int done_lock;	   /* Protects the jobs hw_done and result */
+	struct mutex mu;	   /* Protects the queue */
+	struct condvar cv;	   /* Signaled when jobs are completed */
+	TAILQ_HEAD(, drvcrypt_job) pending; /* Jobs not yet started */
+	TAILQ_HEAD(, drvcrypt_job) running; /* Jobs started on hardware */
+};
+
+/*
+ * Initialize a driver job queue
+ *
+ * @queue  Queue to initialize
+ * @ops    Driver queue operations
+ * @depth  Maximum number of jobs running at the same time on the hardware
+ */
+void drvcrypt_queue_init(struct drvcrypt_queue *queue,
+			 const struct drvcrypt_queue_ops *ops,
+			 unsigned int depth);
+
+/*
+ * Submit a job to a driver queue. The job is started immediately if the
+ * hardware can accept it, else it is started as soon as a running job
+ * completes. The job object must stay valid until it is completed.
+ *
+ * @queue  Driver queue
+ * @job    Job to submit, @job->ctx and @job->callback must be set
+ */
+TEE_Result drvcrypt_job_submit(struct drvcrypt_queue *queue,
+			       struct drvcrypt_job *job);
+
+/*
+ * Wait for the completion of a submitted job and return its result
+ *
+ * @job    Job to wait for
+ */
+TEE_Result drvcrypt_job_wait(struct drvcrypt_job *job);
+
+/*
+ * Report the completion of a job by the hardware. Called by the driver, in
+ * any context including with spinlocks held, usually from the queue poll
+ * operation.
+ *
+ * @job    Job completed
+ * @res    Result of the job
+ */
+void drvcrypt_job_complete(struct drvcrypt_job *job, TEE_Result res);
+
+#endif /* __DRVCRYPT_ASYNC_H__ */
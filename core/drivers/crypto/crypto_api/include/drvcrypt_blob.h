@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ *
+ * Brief   Blob interface calling the HW crypto driver.
+ */
+#ifndef __DRVCRYPT_BLOB_H__
+#define __DRVCRYPT_BLOB_H__
+
+#include <drvcrypt.h>
+
+/*
+ * Size of the key modifier binding a blob to its owner
+ */
+#define DRVCRYPT_BLOB_KEY_MOD_SIZE	16
+
+/*
+ * Blob operation data
+ */
+struct drvcrypt_blob_data {
+	struct drvcrypt_buf key_mod; /* Key modifier */
+	struct drvcrypt_buf payload; /* Plain data */
+	struct drvcrypt_buf blob;    /* Encapsulated data */
+};
+
+/*
+ * Encapsulates the payloads of @nb blobs. On return the blob length of
+ * each element is the size of its blob. If a blob buffer is too small,
+ * TEE_ERROR_SHORT_BUFFER is returned and the blob length of the element
+ * is set to the size needed.
+ *
+ * @data   [in/out] Array of blob operation data
+ * @nb     Number of elements of @data
+ */
+TEE_Result drvcrypt_blob_encaps(struct drvcrypt_blob_data *data, size_t nb);
+
+/*
+ * Decapsulates the blobs of @nb elements. On return the payload length
+ * of each element is the size of its plain data. If a payload buffer is
+ * too small, TEE_ERROR_SHORT_BUFFER is returned and the payload length
+ * of the element is set to the size needed.
+ *
+ * @data   [in/out] Array of blob operation data
+ * @nb     Number of elements of @data
+ */
+TEE_Result drvcrypt_blob_decaps(struct drvcrypt_blob_data *data, size_t nb);
+
+/*
+ * Crypto Library Blob driver operations
+ */
+struct drvcrypt_blob {
+	/* Encapsulates an array of payloads */
+	TEE_Result (*encaps)(struct drvcrypt_blob_data *data, size_t nb);
+	/* Decapsulates an array of blobs */
+	TEE_Result (*decaps)(struct drvcrypt_blob_data *data, size_t nb);
+};
+
+/*
+ * Register a blob processing driver in the crypto API
+ *
+ * @ops - Driver operations in the HW layer
+ */
+static inline TEE_Result drvcrypt_register_blob(const struct drvcrypt_blob *ops)
+{
+	return drvcrypt_register(CRYPTO_BLOB, (void *)ops);
+}
+#endif /* __DRVCRYPT_BLOB_H__ */
@@ -1,4 +1,5 @@
 srcs-y += drvcrypt.c
+srcs-y += drvcrypt_async.c
 
 subdirs-y += math
 
@@ -7,3 +8,4 @@ subdirs-$(CFG_CRYPTO_DRV_ACIPHER) += acipher
 subdirs-$(CFG_CRYPTO_DRV_ACIPHER) += oid
 subdirs-$(CFG_CRYPTO_DRV_CIPHER) += cipher
 subdirs-$(CFG_CRYPTO_DRV_MAC) += mac
+subdirs-$(CFG_CRYPTO_DRV_BLOB) += blob
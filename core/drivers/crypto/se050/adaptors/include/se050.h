@@ -19,6 +19,13 @@
 
 TEE_Result se050_core_early_init(struct se050_scp_key *keys);
 
+/*
+ * Write @wbuf then read @rbuf from the secure element in a single combined
+ * I2C transfer, saving one REE round trip per exchange when the I2C bus is
+ * accessed over RPC. Returns the number of bytes read or -1 on error.
+ */
+int glue_i2c_write_read(uint8_t *wbuf, int wlen, uint8_t *rbuf, int rlen);
+
 extern sss_se05x_key_store_t *se050_kstore;
 extern sss_se05x_session_t *se050_session;
 extern struct sss_se05x_ctx se050_ctx;
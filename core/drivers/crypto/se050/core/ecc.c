@@ -11,6 +11,7 @@
 #include <drvcrypt_math.h>
 #include <initcall.h>
 #include <se050.h>
+#include <se050_key_cache.h>
 #include <string.h>
 #include <tee/cache.h>
 #include <tee/tee_cryp_utl.h>
@@ -199,15 +200,47 @@ static TEE_Result set_binary_data(struct bignum *b, size_t key_len, uint8_t **p,
 	return TEE_SUCCESS;
 }
 
+/* Digest of the key material identifying an object in the key cache */
+static TEE_Result key_digest(uint32_t curve, struct bignum *d,
+			     struct bignum *x, struct bignum *y,
+			     size_t key_len, uint8_t *digest)
+{
+	struct bignum *parts[] = { x, y, d };
+	uint8_t buf[sizeof(curve) + 3 * 66] = { };
+	size_t len = sizeof(curve);
+	size_t n = 0;
+	size_t a = 0;
+
+	memcpy(buf, &curve, sizeof(curve));
+	for (n = 0; n < ARRAY_SIZE(parts) && parts[n]; n++) {
+		a = crypto_bignum_num_bytes(parts[n]);
+		if (a > key_len || len + key_len > sizeof(buf))
+			return TEE_ERROR_BAD_PARAMETERS;
+		crypto_bignum_bn2bin(parts[n], buf + len + key_len - a);
+		len += key_len;
+	}
+
+	return tee_hash_createdigest(TEE_ALG_SHA256, buf, len, digest,
+				     TEE_SHA256_HASH_SIZE);
+}
+
 static TEE_Result se050_inject_public_key(sss_se05x_object_t *k_object,
 					  struct ecc_public_key *key,
 					  size_t key_len)
 {
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
 	struct se050_ecc_keypub key_bin = { };
 	TEE_Result ret = TEE_ERROR_GENERIC;
 	sss_status_t st = kStatus_SSS_Fail;
 	uint32_t oid = 0;
 
+	ret = key_digest(key->curve, NULL, key->x, key->y, key_len, digest);
+	if (ret != TEE_SUCCESS)
+		return ret;
+
+	if (se050_key_cache_get(digest, k_object))
+		return TEE_SUCCESS;
+
 	st = sss_se05x_key_object_init(k_object, se050_kstore);
 	if (st != kStatus_SSS_Success)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -242,6 +275,8 @@ static TEE_Result se050_inject_public_key(sss_se05x_object_t *k_object,
 	if (st != kStatus_SSS_Success)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	se050_key_cache_put(digest, k_object);
+
 	return TEE_SUCCESS;
 }
 
@@ -249,6 +284,7 @@ static TEE_Result se050_inject_keypair(sss_se05x_object_t *k_object,
 				       struct ecc_keypair *key,
 				       size_t key_len)
 {
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
 	struct se050_ecc_keypair key_bin = { };
 	sss_status_t st = kStatus_SSS_Fail;
 	TEE_Result ret = TEE_ERROR_GENERIC;
@@ -268,6 +304,13 @@ static TEE_Result se050_inject_keypair(sss_se05x_object_t *k_object,
 		return TEE_SUCCESS;
 	}
 
+	ret = key_digest(key->curve, key->d, key->x, key->y, key_len, digest);
+	if (ret != TEE_SUCCESS)
+		return ret;
+
+	if (se050_key_cache_get(digest, k_object))
+		return TEE_SUCCESS;
+
 	st = se050_get_oid(kKeyObject_Mode_Transient, &oid);
 	if (st != kStatus_SSS_Success)
 		return TEE_ERROR_GENERIC;
@@ -308,6 +351,8 @@ static TEE_Result se050_inject_keypair(sss_se05x_object_t *k_object,
 	if (st != kStatus_SSS_Success)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	se050_key_cache_put(digest, k_object);
+
 	return TEE_SUCCESS;
 }
 
@@ -416,7 +461,7 @@ static TEE_Result sign(uint32_t algo, struct ecc_keypair *key,
 	sss_se05x_signature_der2bin(sig, sig_len);
 exit:
 	if (!se050_ecc_keypair_from_nvm(key))
-		sss_se05x_key_store_erase_key(se050_kstore, &kobject);
+		se050_key_cache_release(&kobject);
 
 	sss_se05x_asymmetric_context_free(&ctx);
 
@@ -469,7 +514,7 @@ static TEE_Result verify(uint32_t algo, struct ecc_public_key *key,
 	if (st != kStatus_SSS_Success)
 		res = TEE_ERROR_SIGNATURE_INVALID;
 exit:
-	sss_se05x_key_store_erase_key(se050_kstore, &kobject);
+	se050_key_cache_release(&kobject);
 	sss_se05x_asymmetric_context_free(&ctx);
 
 	return res;
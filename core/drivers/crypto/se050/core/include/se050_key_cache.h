@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef SE050_KEY_CACHE_H_
+#define SE050_KEY_CACHE_H_
+
+#include <se050.h>
+#include <tee_api_types.h>
+#include <utee_defines.h>
+
+/*
+ * Cache of the transient key objects imported in the SE050, indexed by a
+ * digest of the key material. Reusing a cached object saves the APDUs
+ * creating, writing and erasing it on each operation with the same key.
+ * The cache holds CFG_CORE_SE05X_KEY_CACHE_ENTRIES objects, 0 disables it.
+ */
+
+/*
+ * Looks up the object of a key, on success @obj is a copy of the cached
+ * object which must be given back with se050_key_cache_release().
+ */
+bool se050_key_cache_get(const uint8_t digest[TEE_SHA256_HASH_SIZE],
+			 sss_se05x_object_t *obj);
+
+/*
+ * Adds the object of a key freshly imported in the SE050, evicting the
+ * least recently used idle object if needed. The object must still be
+ * given back with se050_key_cache_release().
+ */
+void se050_key_cache_put(const uint8_t digest[TEE_SHA256_HASH_SIZE],
+			 sss_se05x_object_t *obj);
+
+/* Gives back an object, the key is erased from the SE050 unless cached */
+void se050_key_cache_release(sss_se05x_object_t *obj);
+
+#endif /* SE050_KEY_CACHE_H_ */
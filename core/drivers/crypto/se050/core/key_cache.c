@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <kernel/mutex.h>
+#include <se050_key_cache.h>
+#include <string.h>
+#include <util.h>
+
+struct key_cache_entry {
+	uint8_t digest[TEE_SHA256_HASH_SIZE];
+	sss_se05x_object_t obj;
+	unsigned int refs;
+	uint64_t last_use;
+	bool used;
+};
+
+static struct key_cache_entry key_cache[CFG_CORE_SE05X_KEY_CACHE_ENTRIES];
+static struct mutex key_cache_mu = MUTEX_INITIALIZER;
+static uint64_t key_cache_tick;
+
+static struct key_cache_entry *find_digest(const uint8_t *digest)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(key_cache); n++)
+		if (key_cache[n].used &&
+		    !memcmp(key_cache[n].digest, digest, TEE_SHA256_HASH_SIZE))
+			return key_cache + n;
+
+	return NULL;
+}
+
+static struct key_cache_entry *find_obj(sss_se05x_object_t *obj)
+{
+	size_t n = 0;
+
+	if (!obj->keyId)
+		return NULL;
+
+	for (n = 0; n < ARRAY_SIZE(key_cache); n++)
+		if (key_cache[n].used && key_cache[n].obj.keyId == obj->keyId)
+			return key_cache + n;
+
+	return NULL;
+}
+
+bool se050_key_cache_get(const uint8_t digest[TEE_SHA256_HASH_SIZE],
+			 sss_se05x_object_t *obj)
+{
+	struct key_cache_entry *e = NULL;
+
+	if (!ARRAY_SIZE(key_cache))
+		return false;
+
+	mutex_lock(&key_cache_mu);
+	e = find_digest(digest);
+	if (e) {
+		e->refs++;
+		e->last_use = ++key_cache_tick;
+		*obj = e->obj;
+	}
+	mutex_unlock(&key_cache_mu);
+
+	return e;
+}
+
+void se050_key_cache_put(const uint8_t digest[TEE_SHA256_HASH_SIZE],
+			 sss_se05x_object_t *obj)
+{
+	struct key_cache_entry *e = NULL;
+	size_t n = 0;
+
+	if (!ARRAY_SIZE(key_cache))
+		return;
+
+	mutex_lock(&key_cache_mu);
+	/* Another thread may have imported the same key meanwhile */
+	if (find_digest(digest))
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(key_cache); n++) {
+		if (!key_cache[n].used) {
+			e = key_cache + n;
+			break;
+		}
+		if (!key_cache[n].refs &&
+		    (!e || key_cache[n].last_use < e->last_use))
+			e = key_cache + n;
+	}
+	if (!e)
+		goto out;
+
+	if (e->used)
+		sss_se05x_key_store_erase_key(se050_kstore, &e->obj);
+
+	memcpy(e->digest, digest, sizeof(e->digest));
+	e->obj = *obj;
+	e->refs = 1;
+	e->last_use = ++key_cache_tick;
+	e->used = true;
+out:
+	mutex_unlock(&key_cache_mu);
+}
+
+void se050_key_cache_release(sss_se05x_object_t *obj)
+{
+	struct key_cache_entry *e = NULL;
+
+	if (ARRAY_SIZE(key_cache)) {
+		mutex_lock(&key_cache_mu);
+		e = find_obj(obj);
+		if (e) {
+			assert(e->refs);
+			e->refs--;
+		}
+		mutex_unlock(&key_cache_mu);
+	}
+
+	if (!e)
+		sss_se05x_key_store_erase_key(se050_kstore, obj);
+}
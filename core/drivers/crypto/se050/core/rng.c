@@ -45,3 +45,8 @@ uint8_t hw_get_random_byte(void)
 
 	return data;
 }
+
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	return do_rng_read(buf, len);
+}
@@ -11,6 +11,7 @@ srcs-y += scp03.c
 srcs-y += storage.c
 srcs-$(CFG_NXP_SE05X_RSA_DRV) += rsa.c
 srcs-$(CFG_NXP_SE05X_ECC_DRV) += ecc.c
+srcs-$(CFG_NXP_SE05X_ECC_DRV) += key_cache.c
 srcs-$(CFG_NXP_SE05X_CTR_DRV) += ctr.c
 srcs-$(CFG_NXP_SE05X_HUK_DRV) += huk.c
 srcs-$(CFG_NXP_SE05X_RNG_DRV) += rng.c
@@ -20,6 +20,10 @@ CFG_CORE_SE05X_OEFID ?= 0
 CFG_CORE_SE05X_BAUDRATE ?= 3400000
 # I2C bus [0..2] (depends on board)
 CFG_CORE_SE05X_I2C_BUS ?= 2
+# Number of transient ECC key objects kept imported in the SE050 so that
+# operations reusing a key skip the APDUs importing and erasing it, 0 to
+# disable
+CFG_CORE_SE05X_KEY_CACHE_ENTRIES ?= 4
 
 # Extra stacks required to support the Plug and Trust external library
 ifeq ($(shell test $(CFG_STACK_THREAD_EXTRA) -lt 8192; echo $$?), 0)
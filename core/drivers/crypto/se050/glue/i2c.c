@@ -10,8 +10,12 @@
 #include <initcall.h>
 #include <kernel/rpc_io_i2c.h>
 #include <phNxpEsePal_i2c.h>
+#include <se050.h>
+#include <stdbool.h>
+#include <util.h>
 
 static TEE_Result (*transfer)(struct rpc_i2c_request *req, size_t *bytes);
+static bool rpc_seq_unsupported;
 
 static TEE_Result native_i2c_transfer(struct rpc_i2c_request *req,
 				      size_t *bytes)
@@ -62,6 +66,80 @@ int glue_i2c_write(uint8_t *buffer, int len)
 	return i2c_transfer(buffer, len, RPC_I2C_MODE_WRITE);
 }
 
+/* Single segment transfers, used when no combined transfer can be issued */
+static TEE_Result transfer_msgs(struct rpc_i2c_seq_request *seq, size_t *bytes)
+{
+	struct rpc_i2c_request request = {
+		.bus = seq->bus,
+		.chip = seq->chip,
+		.flags = seq->flags,
+	};
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t len = 0;
+	size_t n = 0;
+
+	*bytes = 0;
+	for (n = 0; n < seq->msg_count; n++) {
+		request.mode = seq->msgs[n].mode;
+		request.buffer = seq->msgs[n].buffer;
+		request.buffer_len = seq->msgs[n].buffer_len;
+		res = (*transfer)(&request, &len);
+		if (res)
+			return res;
+		if (len != request.buffer_len)
+			return TEE_ERROR_COMMUNICATION;
+		*bytes += len;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result transfer_seq(struct rpc_i2c_seq_request *seq, size_t *bytes)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (transfer != &rpc_io_i2c_transfer || rpc_seq_unsupported)
+		return transfer_msgs(seq, bytes);
+
+	res = rpc_io_i2c_transfer_seq(seq, bytes);
+	if (res == TEE_ERROR_NOT_SUPPORTED || res == TEE_ERROR_NOT_IMPLEMENTED) {
+		/* The REE doesn't know about combined transfers */
+		rpc_seq_unsupported = true;
+		return transfer_msgs(seq, bytes);
+	}
+
+	return res;
+}
+
+int glue_i2c_write_read(uint8_t *wbuf, int wlen, uint8_t *rbuf, int rlen)
+{
+	struct rpc_i2c_msg msgs[] = {
+		{ .mode = RPC_I2C_MODE_WRITE, .buffer = wbuf,
+		  .buffer_len = wlen },
+		{ .mode = RPC_I2C_MODE_READ, .buffer = rbuf,
+		  .buffer_len = rlen },
+	};
+	struct rpc_i2c_seq_request seq = {
+		.bus = CFG_CORE_SE05X_I2C_BUS,
+		.chip = SMCOM_I2C_ADDRESS >> 1,
+		.msgs = msgs,
+		.msg_count = ARRAY_SIZE(msgs),
+	};
+	size_t bytes = 0;
+	int retry = 5;
+
+	if (wlen < 0 || rlen < 0)
+		return -1;
+
+	do {
+		if (transfer_seq(&seq, &bytes) == TEE_SUCCESS &&
+		    bytes == (size_t)wlen + rlen)
+			return rlen;
+	} while (--retry);
+
+	return -1;
+}
+
 int glue_i2c_init(void)
 {
 	if (transfer == &rpc_io_i2c_transfer)
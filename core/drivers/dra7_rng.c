@@ -13,6 +13,8 @@
 #include <mm/core_mmu.h>
 #include <platform_config.h>
 #include <rng_support.h>
+#include <string.h>
+#include <util.h>
 
 #define	RNG_OUTPUT_L            0x0000
 #define	RNG_OUTPUT_H            0x0004
@@ -72,46 +74,52 @@ register_phys_mem_pgdir(MEM_AREA_IO_SEC, RNG_BASE, RNG_REG_SIZE);
 
 static unsigned int rng_lock = SPINLOCK_UNLOCK;
 
+static int pos;
+static union {
+	uint32_t val[2];
+	uint8_t byte[8];
+} random;
+
+/* Reads the next output of the RNG into random, called with rng_lock held */
+static void refill(vaddr_t rng)
+{
+	/* Is the result ready (available)? */
+	while (!(io_read32(rng + RNG_STATUS) & RNG_READY)) {
+		/* Is the shutdown threshold reached? */
+		if (io_read32(rng + RNG_STATUS) & SHUTDOWN_OFLO) {
+			uint32_t alarm = io_read32(rng + RNG_ALARMSTOP);
+			uint32_t tune = io_read32(rng + RNG_FRODETUNE);
+
+			/* Clear the alarm events */
+			io_write32(rng + RNG_ALARMMASK, 0x0);
+			io_write32(rng + RNG_ALARMSTOP, 0x0);
+			/* De-tune offending FROs */
+			io_write32(rng + RNG_FRODETUNE, tune ^ alarm);
+			/* Re-enable the shut down FROs */
+			io_write32(rng + RNG_FROENABLE, RNG_FRO_MASK);
+			/* Clear the shutdown overflow event */
+			io_write32(rng + RNG_INTACK, SHUTDOWN_OFLO);
+
+			DMSG("Fixed FRO shutdown\n");
+		}
+	}
+	/* Read random value */
+	random.val[0] = io_read32(rng + RNG_OUTPUT_L);
+	random.val[1] = io_read32(rng + RNG_OUTPUT_H);
+	/* Acknowledge read complete */
+	io_write32(rng + RNG_INTACK, RNG_READY);
+}
+
 uint8_t hw_get_random_byte(void)
 {
-	static int pos;
-	static union {
-		uint32_t val[2];
-		uint8_t byte[8];
-	} random;
 	vaddr_t rng = (vaddr_t)phys_to_virt(RNG_BASE, MEM_AREA_IO_SEC);
 	uint8_t ret;
 
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	cpu_spin_lock(&rng_lock);
 
-	if (!pos) {
-		/* Is the result ready (available)? */
-		while (!(io_read32(rng + RNG_STATUS) & RNG_READY)) {
-			/* Is the shutdown threshold reached? */
-			if (io_read32(rng + RNG_STATUS) & SHUTDOWN_OFLO) {
-				uint32_t alarm = io_read32(rng + RNG_ALARMSTOP);
-				uint32_t tune = io_read32(rng + RNG_FRODETUNE);
-
-				/* Clear the alarm events */
-				io_write32(rng + RNG_ALARMMASK, 0x0);
-				io_write32(rng + RNG_ALARMSTOP, 0x0);
-				/* De-tune offending FROs */
-				io_write32(rng + RNG_FRODETUNE, tune ^ alarm);
-				/* Re-enable the shut down FROs */
-				io_write32(rng + RNG_FROENABLE, RNG_FRO_MASK);
-				/* Clear the shutdown overflow event */
-				io_write32(rng + RNG_INTACK, SHUTDOWN_OFLO);
-
-				DMSG("Fixed FRO shutdown\n");
-			}
-		}
-		/* Read random value */
-		random.val[0] = io_read32(rng + RNG_OUTPUT_L);
-		random.val[1] = io_read32(rng + RNG_OUTPUT_H);
-		/* Acknowledge read complete */
-		io_write32(rng + RNG_INTACK, RNG_READY);
-	}
+	if (!pos)
+		refill(rng);
 
 	ret = random.byte[pos];
 
@@ -123,6 +131,35 @@ uint8_t hw_get_random_byte(void)
 	return ret;
 }
 
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	vaddr_t rng = (vaddr_t)phys_to_virt(RNG_BASE, MEM_AREA_IO_SEC);
+	uint32_t exceptions = 0;
+	uint8_t *b = buf;
+	size_t n = 0;
+
+	/* The lock is only held for one output of the RNG at a time */
+	while (len) {
+		exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+		cpu_spin_lock(&rng_lock);
+
+		if (!pos)
+			refill(rng);
+
+		n = MIN(len, sizeof(random) - pos);
+		memcpy(b, random.byte + pos, n);
+		pos = (pos + n) % sizeof(random);
+
+		cpu_spin_unlock(&rng_lock);
+		thread_set_exceptions(exceptions);
+
+		b += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result dra7_rng_init(void)
 {
 	vaddr_t rng = (vaddr_t)phys_to_virt(RNG_BASE, MEM_AREA_IO_SEC);
@@ -96,9 +96,9 @@ static void gic_pm_register(struct gic_data *gd __unused)
 
 #if !defined(CFG_ARM_GICV3)
 static uint8_t gic_op_set_pmr(struct itr_chip *chip, uint8_t mask);
+#endif
 static uint8_t gic_op_set_ipriority(struct itr_chip *chip, size_t it,
 			uint8_t mask);
-#endif
 
 static const struct itr_ops gic_ops = {
 	.add = gic_op_add,
@@ -109,8 +109,8 @@ static const struct itr_ops gic_ops = {
 	.set_affinity = gic_op_set_affinity,
 #if !defined(CFG_ARM_GICV3)
 	.set_pmr = gic_op_set_pmr,
-	.set_ipriority = gic_op_set_ipriority,
 #endif
+	.set_ipriority = gic_op_set_ipriority,
 };
 DECLARE_KEEP_PAGER(gic_ops);
 
@@ -447,20 +447,31 @@ void gic_dump_state(struct gic_data *gd)
 	}
 }
 
+/*
+ * All pending interrupts are handled before returning, the GIC returning
+ * the highest priority one first, which saves an exception entry and
+ * exit for each interrupt pending at the same time.
+ */
 void gic_it_handle(struct gic_data *gd)
 {
 	uint32_t iar = 0;
 	uint32_t id = 0;
 
-	iar = gic_read_iar(gd);
-	id = iar & GICC_IAR_IT_ID_MASK;
+	while (true) {
+		iar = gic_read_iar(gd);
+		id = iar & GICC_IAR_IT_ID_MASK;
 
-	if (id < gd->max_it)
-		itr_handle(id);
-	else
-		DMSG("ignoring interrupt %" PRIu32, id);
+		/* Special interrupt IDs, nothing more is pending */
+		if (id >= GIC_MAX_INTS)
+			break;
 
-	gic_write_eoir(gd, iar);
+		if (id < gd->max_it)
+			itr_handle(id);
+		else
+			DMSG("ignoring interrupt %" PRIu32, id);
+
+		gic_write_eoir(gd, iar);
+	}
 }
 
 static void gic_op_add(struct itr_chip *chip, size_t it,
@@ -13,6 +13,7 @@
 #include <mm/core_mmu.h>
 #include <platform_config.h>
 #include <rng_support.h>
+#include <string.h>
 #include <trace.h>
 #include <types_ext.h>
 #include <util.h>
@@ -60,24 +61,32 @@ static TEE_Result hi16xx_rng_init(void)
 	return TEE_SUCCESS;
 }
 
-uint8_t hw_get_random_byte(void)
+static vaddr_t rng_num_va(void)
 {
 	static vaddr_t r;
-	static int pos;
-	static union {
-		uint32_t val;
-		uint8_t byte[4];
-	} random;
+
+	if (!r)
+		r = (vaddr_t)phys_to_virt(RNG_BASE, MEM_AREA_IO_SEC) + RNG_NUM;
+
+	return r;
+}
+
+/* Bytes of the last word read left for hw_get_random_byte() */
+static int pos;
+static union {
+	uint32_t val;
+	uint8_t byte[4];
+} random;
+
+uint8_t hw_get_random_byte(void)
+{
 	uint8_t ret;
 	uint32_t exceptions;
 
 	exceptions = cpu_spin_lock_xsave(&rng_lock);
 
-	if (!r)
-		r = (vaddr_t)phys_to_virt(RNG_BASE, MEM_AREA_IO_SEC) + RNG_NUM;
-
 	if (!pos)
-		random.val = io_read32(r);
+		random.val = io_read32(rng_num_va());
 
 	ret = random.byte[pos++];
 
@@ -89,4 +98,26 @@ uint8_t hw_get_random_byte(void)
 	return ret;
 }
 
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	vaddr_t r = rng_num_va();
+	uint32_t exceptions = 0;
+	uint8_t *b = buf;
+	uint32_t val = 0;
+	size_t n = 0;
+
+	/* The output register needs no polling, read it a word at a time */
+	exceptions = cpu_spin_lock_xsave(&rng_lock);
+	while (len) {
+		val = io_read32(r);
+		n = MIN(len, sizeof(val));
+		memcpy(b, &val, n);
+		b += n;
+		len -= n;
+	}
+	cpu_spin_unlock_xrestore(&rng_lock, exceptions);
+
+	return TEE_SUCCESS;
+}
+
 driver_init(hi16xx_rng_init);
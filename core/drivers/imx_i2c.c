@@ -463,7 +463,7 @@ static TEE_Result i2c_mapped(const char *i2c_match)
 		return TEE_ERROR_NOT_SUPPORTED;
 
 	for (i = 0; i < ARRAY_SIZE(i2c_bus); i++) {
-		off = fdt_node_offset_by_compatible(fdt, off, i2c_match);
+		off = dt_node_offset_by_compatible(fdt, off, i2c_match);
 		if (off < 0)
 			break;
 
@@ -114,7 +114,7 @@ static TEE_Result imx_wdog_base(vaddr_t *wdog_vbase)
 		match = dt_wdog_match_table[i];
 		off = 0;
 		while (off >= 0) {
-			off = fdt_node_offset_by_compatible(fdt, off, match);
+			off = dt_node_offset_by_compatible(fdt, off, match);
 			if (off > 0) {
 				st = _fdt_get_status(fdt, off);
 				if (st & DT_STATUS_OK_SEC) {
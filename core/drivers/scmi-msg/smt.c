@@ -107,13 +107,17 @@ static void scmi_proccess_smt(unsigned int agent_id, uint32_t *payload_buf)
 	smt_hdr = channel_to_smt_hdr(chan);
 	assert(smt_hdr);
 
-	smt_status = READ_ONCE(smt_hdr->status);
-
 	if (!channel_set_busy(chan)) {
+		/*
+		 * The message is being processed from another entry which
+		 * will update the SMT status once done.
+		 */
 		DMSG("SCMI channel %u busy", agent_id);
-		goto out;
+		return;
 	}
 
+	smt_status = READ_ONCE(smt_hdr->status);
+
 	in_payload_size = READ_ONCE(smt_hdr->length) -
 			  sizeof(smt_hdr->message_header);
 
@@ -148,7 +152,6 @@ static void scmi_proccess_smt(unsigned int agent_id, uint32_t *payload_buf)
 	/* Update message length with the length of the response message */
 	smt_hdr->length = msg.out_size_out + sizeof(smt_hdr->message_header);
 
-	channel_release_busy(chan);
 	error = false;
 
 out:
@@ -158,6 +161,8 @@ out:
 	} else {
 		smt_hdr->status |= SMT_STATUS_FREE;
 	}
+
+	channel_release_busy(chan);
 }
 
 #ifdef CFG_SCMI_MSG_SMT_FASTCALL_ENTRY
@@ -190,6 +195,39 @@ void scmi_smt_threaded_entry(unsigned int agent_id)
 
 	scmi_proccess_smt(agent_id, threaded_payload[thread_get_id()]);
 }
+
+size_t __weak plat_scmi_agent_count(void)
+{
+	return 0;
+}
+
+static bool channel_has_pending_msg(struct scmi_msg_channel *chan)
+{
+	return chan && chan->threaded && !chan->busy &&
+	       !(READ_ONCE(channel_to_smt_hdr(chan)->status) &
+		 SMT_STATUS_FREE);
+}
+
+void scmi_smt_threaded_entry_pending(void)
+{
+	uint32_t *payload_buf = threaded_payload[thread_get_id()];
+	size_t count = plat_scmi_agent_count();
+	unsigned int agent_id = 0;
+	bool pending = true;
+
+	/* Loop until no channel got a new message while processing others */
+	while (pending) {
+		pending = false;
+		for (agent_id = 0; agent_id < count; agent_id++) {
+			if (!channel_has_pending_msg(
+					plat_scmi_get_channel(agent_id)))
+				continue;
+
+			scmi_proccess_smt(agent_id, payload_buf);
+			pending = true;
+		}
+	}
+}
 #endif
 
 /* Init a SMT header for a shared memory buffer: state it a free/no-error */
@@ -661,8 +661,8 @@ static void save_dt_nvmem_layout(void *fdt)
 	int cell_nb = 0;
 	int nvmem_node = 0;
 
-	nvmem_node = fdt_node_offset_by_compatible(fdt, -1,
-						   "st,stm32-nvmem-layout");
+	nvmem_node = dt_node_offset_by_compatible(fdt, -1,
+						  "st,stm32-nvmem-layout");
 	if (nvmem_node < 0)
 		return;
 
@@ -692,8 +692,8 @@ static void save_dt_nvmem_layout(void *fdt)
 		int node = 0;
 		struct nvmem_layout *layout_cell = &nvmem_layout[i];
 
-		node = fdt_node_offset_by_phandle(fdt,
-						  fdt32_to_cpu(*(cells + i)));
+		node = dt_node_offset_by_phandle(fdt,
+						 fdt32_to_cpu(*(cells + i)));
 		if (node < 0) {
 			IMSG("Malformed nvmem_layout node: ignored");
 			continue;
@@ -732,7 +732,7 @@ static void initialize_bsec_from_dt(void)
 	struct dt_node_info bsec_info = { };
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, 0, "st,stm32mp15-bsec");
+	node = dt_node_offset_by_compatible(fdt, 0, "st,stm32mp15-bsec");
 	if (node < 0)
 		panic();
 
@@ -318,7 +318,7 @@ int stm32_pinctrl_fdt_get_pinctrl(void *fdt, int device_node,
 		int node = 0;
 		int subnode = 0;
 
-		node = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
+		node = dt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
 		if (node < 0)
 			return -FDT_ERR_NOTFOUND;
 
@@ -67,7 +67,7 @@ static vaddr_t get_base(struct stm32_iwdg_instance *iwdg)
 static int stm32_iwdg_get_dt_node(void *fdt, struct dt_node_info *info,
 				  int offset)
 {
-	int node = fdt_node_offset_by_compatible(fdt, offset, IWDG_COMPAT);
+	int node = dt_node_offset_by_compatible(fdt, offset, IWDG_COMPAT);
 
 	if (node < 0) {
 		if (offset == -1)
@@ -200,7 +200,7 @@ static TEE_Result stm32_rng_init(void)
 		panic();
 
 	while (true) {
-		node = fdt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
+		node = dt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
 		if (node < 0)
 			break;
 
@@ -414,7 +414,7 @@ static TEE_Result stm32_rtc_init(void)
 	if (!fdt)
 		panic();
 
-	node = fdt_node_offset_by_compatible(fdt, -1, RTC_COMPAT);
+	node = dt_node_offset_by_compatible(fdt, -1, RTC_COMPAT);
 	if (node < 0)
 		return TEE_SUCCESS;
 
@@ -84,7 +84,7 @@ static struct stm32_tim_instance stm32_tim[TIM_MAX_INSTANCE];
 
 static int timer_get_dt_node(void *fdt, struct dt_node_info *info, int offset)
 {
-	int node = fdt_node_offset_by_compatible(fdt, offset, TIM_COMPAT);
+	int node = dt_node_offset_by_compatible(fdt, offset, TIM_COMPAT);
 
 	if (node < 0)
 		return -FDT_ERR_NOTFOUND;
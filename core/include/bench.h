@@ -31,6 +31,28 @@
 #define TEE_BENCH_UTEE		0x40000000
 #define TEE_BENCH_DUMB_TA	0xF0000001
 
+/*
+ * Tracepoints along the path of a call into the TEE core. Tracepoint
+ * records are timestamped with the system counter instead of the cycle
+ * counter and their src field holds TEE_BENCH_CORE_TP, the tracepoint ID
+ * in bits [23:16] and the core ID in bits [15:0].
+ */
+#define TEE_BENCH_CORE_TP	0x31000000
+#define TEE_BENCH_TP_SRC(tp, core) \
+	(TEE_BENCH_CORE_TP | ((uint64_t)(tp) << 16) | (core))
+
+enum bench_tp {
+	BENCH_TP_SMC_ENTRY = 1,		/* New standard call received */
+	BENCH_TP_THREAD_START = 2,	/* Thread allocated and running */
+	BENCH_TP_SESSION_FOUND = 3,	/* Session looked up */
+	BENCH_TP_TA_ENTER = 4,		/* Entering the TA */
+	BENCH_TP_TA_EXIT = 5,		/* Returned from the TA */
+	BENCH_TP_RPC_OUT = 6,		/* Leaving for an RPC */
+	BENCH_TP_RPC_IN = 7,		/* Returning from an RPC */
+	BENCH_TP_PARAM_MAP = 8,		/* Parameter memrefs mapped */
+	BENCH_TP_PARAM_UNMAP = 9,	/* Parameter memrefs unmapped */
+};
+
 /* storing timestamp */
 struct tee_time_st {
 	uint64_t cnt;	/* stores value from CNTPCT register */
@@ -53,8 +75,10 @@ struct tee_ts_global {
 
 #ifdef CFG_TEE_BENCHMARK
 void bm_timestamp(void);
+void bm_tracepoint(enum bench_tp tp);
 #else
 static inline void bm_timestamp(void) {}
+static inline void bm_tracepoint(enum bench_tp tp __unused) {}
 #endif /* CFG_TEE_BENCHMARK */
 
 #endif /* BENCH_H */
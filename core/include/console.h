@@ -14,6 +14,18 @@ void console_init(void);
 void console_putc(int ch);
 void console_flush(void);
 
+#ifdef CFG_CORE_DEFERRED_CONSOLE
+/*
+ * Write the messages deferred by secure threads on the calling core to the
+ * console, called when a thread returns to normal world.
+ */
+void console_drain_deferred(void);
+#else
+static inline void console_drain_deferred(void)
+{
+}
+#endif
+
 struct serial_chip;
 void register_serial_console(struct serial_chip *chip);
 
@@ -26,6 +26,13 @@ void crypto_accel_aes_cbc_enc(void *out, const void *in, const void *key,
 void crypto_accel_aes_cbc_dec(void *out, const void *in, const void *key,
 			      unsigned int round_count,
 			      unsigned int block_count, void *iv);
+/*
+ * CBC encryption of the blocks where only the last ciphertext block is
+ * kept, mac[] is the IV on input and the result on output.
+ */
+void crypto_accel_aes_cbc_mac(void *mac, const void *in, const void *key,
+			      unsigned int round_count,
+			      unsigned int block_count);
 
 void crypto_accel_aes_ctr_be_enc(void *out, const void *in, const void *key,
 				 unsigned int round_count,
@@ -44,4 +51,44 @@ void crypto_accel_sha1_compress(uint32_t state[5], const void *src,
 				unsigned int block_count);
 void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 				  unsigned int block_count);
+
+/*
+ * Returns TEE_ERROR_NOT_SUPPORTED if the CPU lacks the SHA-512
+ * instructions, the caller is then expected to fall back to a software
+ * implementation.
+ */
+TEE_Result crypto_accel_sha512_compress(uint64_t state[8], const void *src,
+					unsigned int block_count);
+
+/*
+ * Returns TEE_ERROR_NOT_SUPPORTED if the CPU lacks the SM3 instructions,
+ * the caller is then expected to fall back to a software implementation.
+ */
+TEE_Result crypto_accel_sm3_compress(uint32_t state[8], const void *src,
+				     unsigned int block_count);
+
+/*
+ * Encrypts or decrypts @block_count blocks depending on the order of the
+ * round keys in @rk. Returns TEE_ERROR_NOT_SUPPORTED if the CPU lacks the
+ * SM4 instructions, the caller is then expected to fall back to a
+ * software implementation.
+ */
+TEE_Result crypto_accel_sm4_crypt(void *out, const void *in,
+				  const uint32_t rk[32],
+				  unsigned int block_count);
+
+/*
+ * XORs @block_count blocks of the ChaCha20 key stream of @state with @in
+ * into @out and increments the 32-bit block counter in @state[12] once per
+ * block. The caller is expected to keep that counter from wrapping.
+ */
+void crypto_accel_chacha20_xor(void *out, const void *in, uint32_t state[16],
+			       unsigned int block_count);
+
+/*
+ * Same as hash_sha256_check() but implemented directly on top of
+ * crypto_accel_sha256_compress() without any hash context
+ */
+TEE_Result crypto_accel_sha256_check(const uint8_t *hash, const void *data,
+				     size_t data_size);
 #endif /*__CRYPTO_CRYPTO_ACCEL_H*/
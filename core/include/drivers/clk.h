@@ -15,6 +15,10 @@
  * Minimal generic clock framework where platform is expected implement a
  * single clock provider and each individual clock identified with a unique
  * unsigned long identifier.
+ *
+ * @is_rate_cacheable is optional, it returns true if the rate of a clock
+ * can only be changed by the provider. Such rates are cached by
+ * clk_get_rate() until the provider calls clk_rates_changed().
  */
 struct clk_ops {
 	TEE_Result (*enable)(unsigned long id);
@@ -22,6 +26,7 @@ struct clk_ops {
 	unsigned long (*get_rate)(unsigned long id);
 	unsigned long (*get_parent)(unsigned long id);
 	bool (*is_enabled)(unsigned long id);
+	bool (*is_rate_cacheable)(unsigned long id);
 };
 
 TEE_Result clk_enable(unsigned long id);
@@ -32,4 +37,10 @@ unsigned long clk_get_parent(unsigned long id);
 
 void clk_provider_register(const struct clk_ops *ops);
 
+/*
+ * Drops the cached clock rates, called by the provider once it has changed
+ * the rate or the parent of a clock
+ */
+void clk_rates_changed(void);
+
 #endif /* CLK_H */
@@ -80,6 +80,14 @@ void scmi_smt_interrupt_entry(unsigned int agent_id);
  */
 void scmi_smt_threaded_entry(unsigned int agent_id);
 
+/*
+ * Process the SMT formatted messages pending in all threaded channels in
+ * a TEE thread execution context, until none is left. Lets a single
+ * notification from the agents drain the messages of several channels.
+ * This function depends on CFG_SCMI_MSG_SMT_THREAD_ENTRY.
+ */
+void scmi_smt_threaded_entry_pending(void);
+
 /* Platform callback functions */
 
 /*
@@ -89,6 +97,13 @@ void scmi_smt_threaded_entry(unsigned int agent_id);
  */
 struct scmi_msg_channel *plat_scmi_get_channel(unsigned int agent_id);
 
+/*
+ * Return the number of SCMI agents, the agent IDs of which range from 0.
+ * Used by scmi_smt_threaded_entry_pending(); the default implementation
+ * returns 0.
+ */
+size_t plat_scmi_agent_count(void);
+
 /*
  * Return how many SCMI protocols supported by the platform
  * According to the SCMI specification, this function does not target
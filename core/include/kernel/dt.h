@@ -66,6 +66,17 @@ struct dt_driver {
  */
 const struct dt_driver *dt_find_compatible_driver(const void *fdt, int offs);
 
+/*
+ * Same as fdt_node_offset_by_compatible() and fdt_node_offset_by_phandle()
+ * but served from an index built at boot when @fdt is the embedded DT,
+ * instead of scanning the whole DT at each call.
+ *
+ * Returns the node offset or a negative libfdt error code
+ */
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible);
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
 const struct dt_driver *__dt_driver_start(void);
 
 const struct dt_driver *__dt_driver_end(void);
@@ -180,6 +191,19 @@ static inline const struct dt_driver *dt_find_compatible_driver(
 	return NULL;
 }
 
+static inline int dt_node_offset_by_compatible(const void *fdt __unused,
+					       int startoffset __unused,
+					       const char *compatible __unused)
+{
+	return -1;
+}
+
+static inline int dt_node_offset_by_phandle(const void *fdt __unused,
+					    uint32_t phandle __unused)
+{
+	return -1;
+}
+
 static inline int dt_map_dev(const void *fdt __unused, int offs __unused,
 			     vaddr_t *vbase __unused, size_t *size __unused)
 {
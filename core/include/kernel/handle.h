@@ -7,14 +7,25 @@
 #define KERNEL_HANDLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <util.h>
 
+/*
+ * struct handle_db - database of handles
+ * @ptrs:	Registered pointers and free list entries indexed by handle
+ * @max_ptrs:	Number of entries in @ptrs
+ * @free_list:	Index + 1 of the first unused entry in @ptrs, 0 if none
+ * @num_ptrs:	Number of registered pointers
+ */
 struct handle_db {
 	void **ptrs;
 	size_t max_ptrs;
+	size_t free_list;
+	size_t num_ptrs;
 };
 
-#define HANDLE_DB_INITIALIZER { NULL, 0 }
+#define HANDLE_DB_INITIALIZER { NULL, 0, 0, 0 }
 
 /*
  * Frees all internal data structures of the database, but does not free
@@ -24,12 +35,13 @@ struct handle_db {
  */
 void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr));
 
-/* Checks if the associated pointers of all handles in the database are NULL. */
+/* Checks if the database holds no registered pointers. */
 bool handle_db_is_empty(struct handle_db *db);
 
 /*
  * Allocates a new handle and assigns the supplied pointer to it,
- * ptr must not be NULL.
+ * ptr must not be NULL and must be at least 2-byte aligned. Allocation
+ * takes constant time, apart from when the database has to grow.
  * The function returns
  * >= 0 on success and
  * -1 on failure
@@ -49,4 +61,27 @@ void *handle_put(struct handle_db *db, int handle);
  */
 void *handle_lookup(struct handle_db *db, int handle);
 
+/*
+ * Handles given to user space hold the handle + 1 in the lower
+ * HANDLE_UREF_IDX_BITS bits and a generation count in the upper bits so
+ * that a stale handle isn't mistaken for a newer pointer registered with
+ * the same handle. 0 is never a valid user space handle.
+ */
+#define HANDLE_UREF_IDX_BITS	16
+
+/*
+ * Allocates a handle like handle_get() and returns the user space handle
+ * in @uref, built with the generation count @gen which is incremented.
+ * Since the same generation count can be given back after a wrap the
+ * caller must also keep @uref with @ptr and compare it on lookup.
+ * Returns false on failure.
+ */
+bool handle_get_uref(struct handle_db *db, void *ptr, uint32_t *gen,
+		     uint32_t *uref);
+
+static inline int uref_to_handle(uint32_t uref)
+{
+	return (int)(uref & (BIT32(HANDLE_UREF_IDX_BITS) - 1)) - 1;
+}
+
 #endif /*KERNEL_HANDLE_H*/
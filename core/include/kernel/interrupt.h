@@ -27,9 +27,9 @@ struct itr_ops {
 		uint8_t cpu_mask);
 #if !defined(CFG_ARM_GICV3)
 	uint8_t (*set_pmr)(struct itr_chip *chip, uint8_t mask);
+#endif
 	uint8_t (*set_ipriority)(struct itr_chip *chip, size_t it,
 					uint8_t mask);
-#endif
 };
 
 enum itr_return {
@@ -37,18 +37,59 @@ enum itr_return {
 	ITRR_HANDLED,
 };
 
+/*
+ * struct itr_handler - handler of an interrupt
+ * @it:			Interrupt number
+ * @flags:		ITRF_* flags
+ * @handler:		Called when @it is raised
+ * @data:		Private data of @handler
+ * @link:		Link in the list of handlers with the same hash of @it
+ * @count:		Number of calls of @handler returning ITRR_HANDLED
+ * @time_total_cnt:	Cumulated time spent in @handler in counter ticks
+ * @time_max_cnt:	Longest time spent in @handler in counter ticks
+ */
 struct itr_handler {
 	size_t it;
 	uint32_t flags;
 	enum itr_return (*handler)(struct itr_handler *h);
 	void *data;
 	SLIST_ENTRY(itr_handler) link;
+#ifdef CFG_ITR_STATS
+	uint64_t count;
+	uint64_t time_total_cnt;
+	uint64_t time_max_cnt;
+#endif
 };
 
 void itr_init(struct itr_chip *data);
 void itr_handle(size_t it);
 
+#ifdef CFG_ITR_STATS
+struct itr_stats {
+	size_t it;
+	uint64_t count;
+	uint64_t time_total_cnt;
+	uint64_t time_max_cnt;
+};
+
+/*
+ * itr_stats_get() - get a copy of the statistics of the interrupt handlers
+ * @stats:	Array receiving the statistics, can be NULL if @count is 0
+ * @count:	Number of elements in @stats
+ * @reset:	Clear the counters once copied
+ *
+ * Returns the number of registered interrupt handlers which may be larger
+ * than @count, in which case only @count elements are copied.
+ */
+size_t itr_stats_get(struct itr_stats *stats, size_t count, bool reset);
+#endif
+
 void itr_add(struct itr_handler *handler);
+/*
+ * Configure on the calling cpu a per-cpu interrupt (PPI) with banked
+ * settings, already registered with itr_add() from another cpu.
+ */
+void itr_add_this_cpu(size_t it, uint32_t flags);
 void itr_enable(size_t it);
 void itr_disable(size_t it);
 /* raise the Peripheral Interrupt corresponding to the interrupt ID */
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_INVOKE_STATS_H
+#define __KERNEL_INVOKE_STATS_H
+
+#include <arm.h>
+#include <kernel/thread.h>
+#include <stdbool.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Latency histogram buckets, bucket 0 counts invocations shorter than
+ * 2 microseconds and bucket n > 0 those taking [2^n, 2^(n + 1)[
+ * microseconds. The last bucket also counts all longer invocations.
+ */
+#define INVOKE_STATS_HIST_BUCKETS	24
+
+/*
+ * struct invoke_stats - statistics of the invocations of a TA command
+ * @uuid:		UUID of the TA
+ * @cmd:		Command ID
+ * @count:		Number of invocations
+ * @total_us:		Cumulated duration of the invocations
+ * @rpc_us:		Time spent in RPC to normal world
+ * @busy_wait_us:	Time spent waiting for the TA to be available
+ * @hist:		Histogram of the invocation durations
+ */
+struct invoke_stats {
+	TEE_UUID uuid;
+	uint32_t cmd;
+	uint32_t count;
+	uint64_t total_us;
+	uint64_t rpc_us;
+	uint64_t busy_wait_us;
+	uint32_t hist[INVOKE_STATS_HIST_BUCKETS];
+};
+
+/*
+ * struct invoke_stats_sample - timestamps of one invocation in progress
+ * @start:	Counter value when the invocation started
+ * @busy_done:	Counter value when the TA was made busy
+ * @rpc_start:	Time spent in RPC by the thread when the invocation started
+ */
+struct invoke_stats_sample {
+	uint64_t start;
+	uint64_t busy_done;
+	uint64_t rpc_start;
+};
+
+#ifdef CFG_TA_INVOKE_STATS
+static inline void invoke_stats_start(struct invoke_stats_sample *s)
+{
+	s->start = barrier_read_cntpct();
+	s->rpc_start = thread_get_tsd()->rpc_cnt;
+}
+
+static inline void invoke_stats_busy_done(struct invoke_stats_sample *s)
+{
+	s->busy_done = barrier_read_cntpct();
+}
+
+/*
+ * invoke_stats_stop() - record an invocation in the statistics
+ * @s:		Sample started with invoke_stats_start()
+ * @uuid:	UUID of the TA invoked
+ * @cmd:	Command ID invoked
+ *
+ * At most CFG_TA_INVOKE_STATS_ENTRIES (UUID, command ID) pairs are
+ * tracked, invocations of further pairs are ignored.
+ */
+void invoke_stats_stop(struct invoke_stats_sample *s, const TEE_UUID *uuid,
+		       uint32_t cmd);
+
+/*
+ * invoke_stats_get() - get a copy of the statistics
+ * @stats:	Array receiving the statistics, can be NULL if @count is 0
+ * @count:	Number of elements in @stats
+ * @reset:	Clear the statistics once copied
+ *
+ * Returns the number of (UUID, command ID) pairs tracked which may be
+ * larger than @count, in which case only @count elements are copied.
+ */
+size_t invoke_stats_get(struct invoke_stats *stats, size_t count, bool reset);
+
+/*
+ * invoke_stats_percentile() - estimate a latency percentile
+ * @stats:	Statistics of a TA command
+ * @pct:	Percentile, 1 to 100
+ *
+ * Returns the upper bound in microseconds of the histogram bucket
+ * containing the percentile.
+ */
+uint32_t invoke_stats_percentile(const struct invoke_stats *stats,
+				 unsigned int pct);
+
+/* Brackets an RPC to normal world done by the current thread */
+static inline uint64_t invoke_stats_rpc_begin(void)
+{
+	return barrier_read_cntpct();
+}
+
+static inline void invoke_stats_rpc_end(uint64_t begin)
+{
+	thread_get_tsd()->rpc_cnt += barrier_read_cntpct() - begin;
+}
+#else
+static inline void invoke_stats_start(struct invoke_stats_sample *s __unused)
+{
+}
+
+static inline void
+invoke_stats_busy_done(struct invoke_stats_sample *s __unused)
+{
+}
+
+static inline void invoke_stats_stop(struct invoke_stats_sample *s __unused,
+				     const TEE_UUID *uuid __unused,
+				     uint32_t cmd __unused)
+{
+}
+
+static inline uint64_t invoke_stats_rpc_begin(void)
+{
+	return 0;
+}
+
+static inline void invoke_stats_rpc_end(uint64_t begin __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_INVOKE_STATS_H*/
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_LOCK_STATS_H
+#define __KERNEL_LOCK_STATS_H
+
+#include <arm.h>
+#include <stdbool.h>
+#include <sys/queue.h>
+#include <types_ext.h>
+
+/*
+ * struct lock_stats - contention statistics of a lock instance
+ * @name:		Name of the lock
+ * @acquired:		Number of times the lock was acquired
+ * @contended:		Number of acquisitions which had to wait
+ * @sleeps:		Number of times a thread slept in normal world
+ *			waiting for the lock (mutexes only)
+ * @wait_total_cnt:	Cumulated waiting time in counter ticks
+ * @wait_max_cnt:	Longest waiting time in counter ticks
+ * @registered:		True once listed for lock_stats_get()
+ * @link:		Link in the list of registered locks
+ *
+ * The counters are updated with the lock held and are read without it,
+ * so a copy may be slightly inconsistent. A lock is registered the first
+ * time it's acquired.
+ */
+struct lock_stats {
+	const char *name;
+	uint64_t acquired;
+	uint64_t contended;
+	uint64_t sleeps;
+	uint64_t wait_total_cnt;
+	uint64_t wait_max_cnt;
+	bool registered;
+	SLIST_ENTRY(lock_stats) link;
+};
+
+#define LOCK_STATS_INITIALIZER(n)	{ .name = (n) }
+
+#ifdef CFG_LOCK_STATS
+static inline uint64_t lock_stats_wait_start(struct lock_stats *s)
+{
+	if (!s)
+		return 0;
+	return barrier_read_cntpct();
+}
+
+/*
+ * lock_stats_acquired() - account an acquisition of a lock
+ * @s:		Statistics of the lock, ignored if NULL or unnamed
+ * @start:	Value returned by lock_stats_wait_start() when the lock was
+ *		found busy, 0 if the lock was acquired right away
+ * @sleeps:	Times the thread slept in normal world waiting for the lock
+ *
+ * Called with the lock held.
+ */
+void lock_stats_acquired(struct lock_stats *s, uint64_t start,
+			 unsigned int sleeps);
+
+/*
+ * lock_stats_get() - get a copy of the statistics of the registered locks
+ * @stats:	Array receiving the statistics, can be NULL if @count is 0
+ * @count:	Number of elements in @stats
+ * @reset:	Clear the counters once copied
+ *
+ * Returns the number of registered locks which may be larger than
+ * @count, in which case only @count elements are copied.
+ */
+size_t lock_stats_get(struct lock_stats *stats, size_t count, bool reset);
+#else
+static inline uint64_t lock_stats_wait_start(struct lock_stats *s __unused)
+{
+	return 0;
+}
+
+static inline void lock_stats_acquired(struct lock_stats *s __unused,
+				       uint64_t start __unused,
+				       unsigned int sleeps __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_LOCK_STATS_H*/
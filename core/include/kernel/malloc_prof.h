@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_MALLOC_PROF_H
+#define __KERNEL_MALLOC_PROF_H
+
+#include <stdbool.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * struct malloc_prof_site - heap usage of an allocation site
+ * @site:	Return address of the call to malloc() and friends
+ * @allocs:	Number of allocations
+ * @live_count:	Number of buffers currently allocated
+ * @live_bytes:	Bytes currently allocated
+ * @peak_bytes:	Highest value of @live_bytes
+ */
+struct malloc_prof_site {
+	vaddr_t site;
+	uint32_t allocs;
+	uint32_t live_count;
+	uint64_t live_bytes;
+	uint64_t peak_bytes;
+};
+
+/* Maximum number of TAs tracked */
+#define MALLOC_PROF_MAX_TAS	16
+
+/*
+ * struct malloc_prof_ta - heap usage on behalf of a TA
+ * @uuid:	UUID of the TA of the session active when allocating
+ * @allocs:	Number of allocations
+ * @live_bytes:	Bytes currently allocated
+ * @peak_bytes:	Highest value of @live_bytes
+ */
+struct malloc_prof_ta {
+	TEE_UUID uuid;
+	uint32_t allocs;
+	uint64_t live_bytes;
+	uint64_t peak_bytes;
+};
+
+#ifdef CFG_CORE_MALLOC_PROFILE
+/*
+ * Called by the TEE core heap for each successful allocation and before
+ * each release. Buffers which don't fit in the tracking tables are only
+ * counted in malloc_prof_get_sites().
+ */
+void malloc_prof_alloc(void *ptr, size_t size, vaddr_t site);
+void malloc_prof_free(void *ptr);
+
+/*
+ * malloc_prof_get_sites() - get a copy of the allocation sites
+ * @sites:	Array receiving the sites, can be NULL if @count is 0
+ * @count:	Number of elements in @sites
+ * @untracked:	Number of allocations which couldn't be tracked
+ *
+ * Returns the number of sites which may be larger than @count, in which
+ * case only @count elements are copied.
+ */
+size_t malloc_prof_get_sites(struct malloc_prof_site *sites, size_t count,
+			     uint32_t *untracked);
+
+/* Same as malloc_prof_get_sites() for the TAs */
+size_t malloc_prof_get_tas(struct malloc_prof_ta *tas, size_t count);
+
+/* Clears the allocation counts and sets the peaks to the live values */
+void malloc_prof_reset(void);
+#else
+static inline void malloc_prof_alloc(void *ptr __unused, size_t size __unused,
+				     vaddr_t site __unused)
+{
+}
+
+static inline void malloc_prof_free(void *ptr __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_MALLOC_PROF_H*/
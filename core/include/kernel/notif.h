@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_NOTIF_H
+#define __KERNEL_NOTIF_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Notifications are values a thread sleeping in normal world can wait
+ * for. Values below CFG_NUM_THREADS are used by the wait queues, a waiter
+ * waits for the ID of its thread. Other users pick their values from
+ * NOTIF_VALUE_USER_BASE and above.
+ *
+ * notif_wait() sleeps in normal world until the value is sent.
+ * notif_send() wakes the waiter, without any RPC if the asynchronous
+ * notifications have been started by normal world, else with an RPC from
+ * the current thread.
+ */
+#define NOTIF_VALUE_USER_BASE	CFG_NUM_THREADS
+
+TEE_Result notif_wait(uint32_t value);
+TEE_Result notif_send(uint32_t value);
+
+#if defined(CFG_CORE_ASYNC_NOTIF)
+/*
+ * Registers the bitmap of pending values in non-secure shared memory, see
+ * OPTEE_SMC_REGISTER_NOTIF. A NULL @pa unregisters the bitmap. Returns an
+ * OPTEE_SMC_RETURN_* code.
+ */
+uint32_t notif_register_async(paddr_t pa, size_t size);
+
+/*
+ * Marks @value pending in the bitmap and raises CFG_CORE_ASYNC_NOTIF_IT.
+ * Returns TEE_ERROR_BAD_STATE if no bitmap is registered and
+ * TEE_ERROR_BAD_PARAMETERS if @value doesn't fit in it.
+ */
+TEE_Result notif_send_async(uint32_t value);
+#else
+static inline TEE_Result notif_send_async(uint32_t value __unused)
+{
+	return TEE_ERROR_BAD_STATE;
+}
+#endif
+
+#endif /*__KERNEL_NOTIF_H*/
@@ -35,4 +35,29 @@ struct rpc_i2c_request {
 
 TEE_Result rpc_io_i2c_transfer(struct rpc_i2c_request *p, size_t *bytes);
 
+/* Maximum number of segments in a combined transfer */
+#define RPC_I2C_SEQ_MAX_MSGS	8
+
+/* A segment of a combined transfer */
+struct rpc_i2c_msg {
+	enum rpc_i2c_mode mode;
+	uint8_t *buffer;
+	size_t buffer_len;
+};
+
+/*
+ * Combined transfer: the segments are issued to the same I2C slave in a
+ * single RPC, separated by repeated start conditions.
+ */
+struct rpc_i2c_seq_request {
+	uint16_t bus; /* bus identifier used by the REE [0..n] */
+	uint16_t chip; /* slave identifier from its data sheet */
+	uint16_t flags; /* transfer flags (ie: ten bit chip address) */
+	struct rpc_i2c_msg *msgs;
+	size_t msg_count; /* number of segments [1..RPC_I2C_SEQ_MAX_MSGS] */
+};
+
+TEE_Result rpc_io_i2c_transfer_seq(struct rpc_i2c_seq_request *p,
+				   size_t *bytes);
+
 #endif /* __RPC_IO_I2C_H */
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+#ifndef __KERNEL_RPC_STATS_H
+#define __KERNEL_RPC_STATS_H
+
+#include <arm.h>
+#include <kernel/thread.h>
+#include <stdbool.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * Latency histogram buckets, bucket 0 counts RPCs shorter than
+ * 2 microseconds and bucket n > 0 those taking [2^n, 2^(n + 1)[
+ * microseconds. The last bucket also counts all longer RPCs.
+ */
+#define RPC_STATS_HIST_BUCKETS		20
+
+/*
+ * struct rpc_stats - statistics of an RPC command issued on behalf of a TA
+ * @uuid:	UUID of the TA of the current session, nil UUID for RPCs
+ *		issued outside of any session
+ * @cmd:	OPTEE_RPC_CMD_* command ID
+ * @count:	Number of RPCs
+ * @failed:	Number of RPCs with a return code other than TEE_SUCCESS
+ * @bytes:	Cumulated size of the memory reference parameters
+ * @total_us:	Cumulated duration of the RPCs
+ * @max_us:	Longest RPC
+ * @hist:	Histogram of the RPC durations
+ */
+struct rpc_stats {
+	TEE_UUID uuid;
+	uint32_t cmd;
+	uint32_t count;
+	uint32_t failed;
+	uint64_t bytes;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint32_t hist[RPC_STATS_HIST_BUCKETS];
+};
+
+#ifdef CFG_RPC_STATS
+static inline uint64_t rpc_stats_begin(void)
+{
+	return barrier_read_cntpct();
+}
+
+/*
+ * rpc_stats_end() - record an RPC in the statistics
+ * @begin:	Value returned by rpc_stats_begin() before the RPC
+ * @cmd:	OPTEE_RPC_CMD_* command ID
+ * @num_params:	Number of elements in @params
+ * @params:	Parameters of the RPC, as updated by normal world
+ * @ret:	Return code of the RPC
+ *
+ * At most CFG_RPC_STATS_ENTRIES (UUID, command ID) pairs are tracked,
+ * RPCs of further pairs are ignored.
+ */
+void rpc_stats_end(uint64_t begin, uint32_t cmd, size_t num_params,
+		   const struct thread_param *params, uint32_t ret);
+
+/*
+ * rpc_stats_get() - get a copy of the statistics
+ * @stats:	Array receiving the statistics, can be NULL if @count is 0
+ * @count:	Number of elements in @stats
+ * @reset:	Clear the statistics once copied
+ *
+ * Returns the number of (UUID, command ID) pairs tracked which may be
+ * larger than @count, in which case only @count elements are copied.
+ */
+size_t rpc_stats_get(struct rpc_stats *stats, size_t count, bool reset);
+#else
+static inline uint64_t rpc_stats_begin(void)
+{
+	return 0;
+}
+
+static inline void rpc_stats_end(uint64_t begin __unused,
+				 uint32_t cmd __unused,
+				 size_t num_params __unused,
+				 const struct thread_param *params __unused,
+				 uint32_t ret __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_RPC_STATS_H*/
@@ -34,10 +34,15 @@ struct param_val {
 	uint32_t b;
 };
 
+/*
+ * @readonly is set for memory lent by a calling TA as an input memref, see
+ * CFG_TA_LEND_PRIV_MEMREF, it's mapped read-only in the called TA.
+ */
 struct param_mem {
 	struct mobj *mobj;
 	size_t size;
 	size_t offs;
+	bool readonly;
 };
 
 struct tee_ta_param {
@@ -68,6 +73,7 @@ struct sample_buf {
 struct tee_ta_ctx {
 	uint32_t flags;		/* TA_FLAGS from TA header */
 	TAILQ_ENTRY(tee_ta_ctx) link;
+	SLIST_ENTRY(tee_ta_ctx) hash_link; /* Link in UUID hash bucket */
 	struct ts_ctx ts_ctx;
 	uint32_t panicked;	/* True if TA has panicked, written from asm */
 	uint32_t panic_code;	/* Code supplied for panic */
@@ -79,6 +85,8 @@ struct tee_ta_ctx {
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	SLIST_ENTRY(tee_ta_session) hash_link; /* Link in id hash bucket */
+	struct tee_ta_session_head *open_sessions; /* List holding @link */
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -86,7 +94,7 @@ struct tee_ta_session {
 	TEE_ErrorOrigin err_origin;
 	bool cancel;		/* True if TA invocation is cancelled */
 	bool cancel_mask;	/* True if cancel is masked */
-	TEE_Time cancel_time;	/* Time when to cancel the TA invocation */
+	uint64_t cancel_time_ns; /* When to cancel the invocation, or max */
 	uint32_t ref_count;	/* reference counter */
 	struct condvar refc_cv;	/* CV used to wait for ref_count to be 0 */
 	struct condvar lock_cv;	/* CV used to wait for lock */
@@ -97,6 +105,13 @@ struct tee_ta_session {
 /* Registered contexts */
 extern struct tee_ta_ctx_head tee_ctxes;
 
+/*
+ * Adds a context to, or removes it from, tee_ctxes and the index used to
+ * find the contexts of a TA. Called with tee_ta_mutex held.
+ */
+void tee_ta_register_ctx(struct tee_ta_ctx *ctx);
+void tee_ta_unregister_ctx(struct tee_ta_ctx *ctx);
+
 extern struct mutex tee_ta_mutex;
 extern struct condvar tee_ta_init_cv;
 
@@ -118,7 +133,12 @@ TEE_Result tee_ta_cancel_command(TEE_ErrorOrigin *err,
 				 struct tee_ta_session *sess,
 				 const TEE_Identity *clnt_id);
 
-bool tee_ta_session_is_cancelled(struct tee_ta_session *s, TEE_Time *curr_time);
+/*
+ * @curr_time_ns, if not NULL, is the current tee_time_get_sys_time_ns()
+ * saving a read of the time if the caller already has it.
+ */
+bool tee_ta_session_is_cancelled(struct tee_ta_session *s,
+				 const uint64_t *curr_time_ns);
 
 /*-----------------------------------------------------------------------------
  * Function called to close a TA.
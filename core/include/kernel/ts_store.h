@@ -81,4 +81,14 @@ struct ts_store_ops {
 	int __tee_sp_store_##prio __unused; \
 	SCATTERED_ARRAY_DEFINE_PG_ITEM_ORDERED(sp_stores, prio, \
 					       struct ts_store_ops)
+
+#if defined(CFG_REE_FS_TA_BUFFERED) && CFG_REE_FS_TA_CACHE_SIZE
+/* Drops the cached REE FS image of a TA, if any */
+void ree_fs_ta_cache_evict(const TEE_UUID *uuid);
+#else
+static inline void ree_fs_ta_cache_evict(const TEE_UUID *uuid __unused)
+{
+}
+#endif
+
 #endif /*__KERNEL_TS_STORE_H*/
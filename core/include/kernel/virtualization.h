@@ -13,6 +13,8 @@
 /**
  * virt_guest_created() - create new VM partition
  * @guest_id: VM id provided by hypervisor
+ * @ta_ram_size: size of TA RAM of the VM, 0 for the default share of
+ *		 TA RAM
  *
  * This function is called by hypervisor (via fast SMC)
  * when hypervisor creates new guest VM, so OP-TEE
@@ -20,7 +22,7 @@
  *
  * Return: OPTEE_SMC_RETURN_* code
  */
-uint32_t virt_guest_created(uint16_t guest_id);
+uint32_t virt_guest_created(uint16_t guest_id, size_t ta_ram_size);
 
 /**
  * virt_guest_destroyed() - destroy existing VM partition
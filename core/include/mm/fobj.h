@@ -160,9 +160,35 @@ static inline TEE_Result fobj_save_page(struct fobj *fobj,
  */
 struct fobj *fobj_sec_mem_alloc(unsigned int num_pages);
 
+/*
+ * fobj_sec_mem_alloc_aligned() - Allocates storage directly in secure memory
+ * at a physical address equal to @offs modulo @align
+ * @num_pages:	Number of pages
+ * @align:	Power of two alignment
+ * @offs:	Page aligned offset smaller than @align
+ *
+ * Returns a valid pointer on success or NULL on failure.
+ */
+struct fobj *fobj_sec_mem_alloc_aligned(unsigned int num_pages, size_t align,
+					paddr_t offs);
+
 #define fobj_ta_mem_alloc(num_pages)	fobj_sec_mem_alloc(num_pages)
 #endif
 
+/*
+ * fobj_is_contiguous() - Tells if the pages of @fobj are physically
+ * contiguous
+ * @fobj:	Fobj pointer
+ */
+#ifdef CFG_PAGED_USER_TA
+static inline bool fobj_is_contiguous(struct fobj *fobj __unused)
+{
+	return false;
+}
+#else
+bool fobj_is_contiguous(struct fobj *fobj);
+#endif
+
 /*
  * fobj_get() - Increase fobj reference count
  * @fobj:	Fobj pointer
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __MM_SLAB_H
+#define __MM_SLAB_H
+
+#include <compiler.h>
+#include <scattered_array.h>
+#include <stdint.h>
+#include <sys/queue.h>
+#include <types_ext.h>
+#include <util.h>
+
+/*
+ * Slab caches of fixed size objects
+ *
+ * A slab cache hands out objects of a single type carved from slabs, that
+ * is larger chunks of heap memory holding several objects each. Objects
+ * released with slab_free() are kept in their slab to be handed out again
+ * by slab_alloc() without going through malloc() and free(), and empty
+ * slabs are returned to the heap except for one kept in reserve.
+ *
+ * If the cache has a constructor it's called once on each object when a
+ * new slab is allocated, objects must then be returned to the cache in
+ * their constructed state. Without constructor objects are cleared by
+ * slab_alloc() instead, like with calloc().
+ *
+ * Caches defined with NEX_SLAB_CACHE_DEFINE() are shared by all guests
+ * when CFG_VIRTUALIZATION is enabled and take their slabs from the nexus
+ * heap.
+ */
+
+#define SLAB_CACHE_NEXUS	BIT(0)
+
+struct slab;
+
+/*
+ * struct slab_cache_stats - usage statistics of a slab cache
+ * @num_objs:		Number of objects currently allocated
+ * @max_objs:		Tracks max value of @num_objs
+ * @num_slabs:		Number of slabs currently allocated
+ * @num_alloc_fail:	Number of failed allocation requests
+ */
+struct slab_cache_stats {
+	uint32_t num_objs;
+	uint32_t max_objs;
+	uint32_t num_slabs;
+	uint32_t num_alloc_fail;
+};
+
+struct slab_cache {
+	const char *name;
+	size_t obj_size;
+	void (*ctor)(void *obj);
+	uint32_t flags;
+	unsigned int spinlock;
+	LIST_HEAD(, slab) partial;
+	LIST_HEAD(, slab) full;
+	struct slab *empty;
+	struct slab_cache_stats stats;
+};
+
+/* Element of the scattered array listing all slab caches */
+struct slab_cache_ref {
+	struct slab_cache *sc;
+};
+
+#define __SLAB_CACHE_DEFINE(attr, _name, type, _ctor, _flags) \
+	static attr struct slab_cache _name = { \
+		.name = #_name, \
+		.obj_size = sizeof(type), \
+		.ctor = (_ctor), \
+		.flags = (_flags), \
+	}; \
+	SCATTERED_ARRAY_DEFINE_PG_ITEM(slab_caches, struct slab_cache_ref) = \
+		{ .sc = &_name }
+
+/*
+ * Defines a slab cache named @_name of objects of type @type with the
+ * optional constructor @_ctor
+ */
+#define SLAB_CACHE_DEFINE(_name, type, _ctor) \
+	__SLAB_CACHE_DEFINE(, _name, type, _ctor, 0)
+
+#define NEX_SLAB_CACHE_DEFINE(_name, type, _ctor) \
+	__SLAB_CACHE_DEFINE(__nex_data, _name, type, _ctor, SLAB_CACHE_NEXUS)
+
+/* Iterates over all defined slab caches, @ref is a struct slab_cache_ref * */
+#define for_each_slab_cache(ref) \
+	SCATTERED_ARRAY_FOREACH(ref, slab_caches, struct slab_cache_ref)
+
+/*
+ * slab_alloc() - allocate an object from a slab cache
+ * @sc:	Slab cache
+ *
+ * Returns a pointer to the object or NULL if out of memory
+ */
+void *slab_alloc(struct slab_cache *sc);
+
+/*
+ * slab_free() - release an object from slab_alloc()
+ * @sc:		Slab cache the object was allocated from
+ * @obj:	Object, may be NULL
+ */
+void slab_free(struct slab_cache *sc, void *obj);
+
+void slab_cache_get_stats(struct slab_cache *sc,
+			  struct slab_cache_stats *stats);
+
+#endif /*__MM_SLAB_H*/
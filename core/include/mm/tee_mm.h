@@ -15,6 +15,21 @@
 #define TEE_MM_POOL_HI_ALLOC            (1u << 0)
 /* Flag to indicate that pool should use nex_malloc instead of malloc */
 #define TEE_MM_POOL_NEX_MALLOC             (1u << 1)
+/*
+ * Flag to indicate that the pool keeps track of free blocks with a bitmap
+ * and a tree of free extents, and of entries with a sorted array, instead
+ * of walking a list of entries. Allocation, free and lookup then scale
+ * logarithmically with the size of the pool. Zero sized allocations are
+ * not supported in such a pool.
+ */
+#define TEE_MM_POOL_BITMAP		(1u << 2)
+
+/* Flags added to the large pools of the core: TA RAM, shm and vcore */
+#ifdef CFG_CORE_TEE_MM_BITMAP
+#define TEE_MM_POOL_LARGE_FLAGS		TEE_MM_POOL_BITMAP
+#else
+#define TEE_MM_POOL_LARGE_FLAGS		0
+#endif
 
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
@@ -24,8 +39,11 @@ struct _tee_mm_entry_t {
 };
 typedef struct _tee_mm_entry_t tee_mm_entry_t;
 
+struct tee_mm_bitmap;
+
 struct _tee_mm_pool_t {
 	tee_mm_entry_t *entry;
+	struct tee_mm_bitmap *bitmap;	/* Only with TEE_MM_POOL_BITMAP */
 	paddr_t lo;		/* low boundary of the pool */
 	paddr_t hi;		/* high boundary of the pool */
 	uint32_t flags;		/* Config flags for the pool */
@@ -86,6 +104,14 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size);
 /* Allocate supplied memory range if it's free */
 tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size);
 
+/*
+ * Allocates size number of bytes at an address equal to offs modulo align,
+ * align is a power of two and offs a multiple of the pool granule smaller
+ * than align. Returns NULL if no such free range is found.
+ */
+tee_mm_entry_t *tee_mm_alloc_aligned(tee_mm_pool_t *pool, size_t size,
+				     size_t align, paddr_t offs);
+
 /*
  * Frees the entry in the paged virtual address space pointed to by the
  * input parameter p
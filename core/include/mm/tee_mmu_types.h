@@ -53,6 +53,11 @@
  * functions.
  */
 #define VM_FLAG_READONLY		BIT(4)
+/*
+ * The translation entries of the mapping are written at the first access
+ * instead of when the user map is created, see vm_map_lazy_region().
+ */
+#define VM_FLAG_LAZY			BIT(5)
 
 /*
  * Set of flags used by tee_mmu_is_vbuf_inside_ta_private() and
@@ -86,7 +91,25 @@ TAILQ_HEAD(vm_region_head, vm_region);
 
 struct vm_info {
 	struct vm_region_head regions;
+	/*
+	 * The regions above sorted on address for binary search, NULL if
+	 * it couldn't be allocated in which case lookups walk the list.
+	 */
+	struct vm_region **region_index;
+	size_t num_regions;
+	/* Changed each time the mapping described by @regions changes */
+	unsigned int map_gen;
 	unsigned int asid;
+	/*
+	 * Memory used by the context, updated with @region_index: bytes
+	 * mapped by private regions and by the others (parameters and
+	 * shared memory), bytes backed by the pager and the number of
+	 * translation tables needed to map @regions.
+	 */
+	size_t priv_size;
+	size_t nonpriv_size;
+	size_t paged_size;
+	size_t num_pgts;
 };
 
 static inline void mattr_perm_to_str(char *str, size_t size, uint32_t attr)
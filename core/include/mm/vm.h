@@ -47,6 +47,17 @@ static inline TEE_Result vm_map(struct user_mode_ctx *uctx, vaddr_t *va,
 	return vm_map_pad(uctx, va, len, prot, flags, mobj, offs, 0, 0, 0);
 }
 
+/*
+ * Maps zero initialized TA memory, see vm_map_pad() for @va, @pad_begin
+ * and @pad_end. If @block_map is true, memory large enough is preferably
+ * allocated contiguous and aligned so that it can be mapped with
+ * CORE_MMU_PGDIR_SIZE blocks instead of small pages, else the memory is
+ * allocated as usual.
+ */
+TEE_Result vm_map_zi(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
+		     uint32_t flags, size_t pad_begin, size_t pad_end,
+		     bool block_map);
+
 TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 		    size_t len, size_t pad_begin, size_t pad_end);
 
@@ -61,11 +72,20 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 TEE_Result vm_unmap(struct user_mode_ctx *uctx, vaddr_t va, size_t len);
 
-/* Map parameters for a user TA */
+/*
+ * Map parameters for a user TA, with @lazy the translation entries are
+ * only written at the first access of each mapping
+ */
 TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
-			void *param_va[TEE_NUM_PARAMS]);
+			void *param_va[TEE_NUM_PARAMS], bool lazy);
 void vm_clean_param(struct user_mode_ctx *uctx);
 
+/*
+ * Writes the translation entries of the lazily mapped region covering @va
+ * in the active user map. Returns false if there's no such region.
+ */
+bool vm_map_lazy_region(struct user_mode_ctx *uctx, vaddr_t va);
+
 TEE_Result vm_add_rwmem(struct user_mode_ctx *uctx, struct mobj *mobj,
 			vaddr_t *va);
 void vm_rem_rwmem(struct user_mode_ctx *uctx, struct mobj *mobj, vaddr_t va);
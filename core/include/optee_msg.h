@@ -233,6 +233,74 @@ struct optee_msg_arg {
 	((OPTEE_MSG_NONCONTIG_PAGE_SIZE - sizeof(struct optee_msg_arg)) / \
 	 sizeof(struct optee_msg_param))
 
+/*
+ * Maximum number of parameters of the struct optee_msg_arg embedded in a
+ * struct optee_msg_ring_sqe.
+ */
+#define OPTEE_MSG_RING_NUM_PARAMS	4
+
+/**
+ * struct optee_msg_ring - header of a submission/completion ring
+ * @sq_head: Index of next submission entry to consume, updated by secure
+ *	     world
+ * @sq_tail: Index of next submission entry to produce, updated by normal
+ *	     world
+ * @cq_head: Index of next completion entry to consume, updated by normal
+ *	     world
+ * @cq_tail: Index of next completion entry to produce, updated by secure
+ *	     world
+ * @num_entries: Number of entries in each of the submission and
+ *	     completion queues, must be a power of 2
+ *
+ * The header is followed by @num_entries struct optee_msg_ring_sqe and
+ * then by @num_entries struct optee_msg_ring_cqe. The indexes are free
+ * running, the entry used is given by index & (@num_entries - 1).
+ */
+struct optee_msg_ring {
+	uint32_t sq_head;
+	uint32_t sq_tail;
+	uint32_t cq_head;
+	uint32_t cq_tail;
+	uint32_t num_entries;
+	uint32_t pad[3];
+};
+
+/**
+ * struct optee_msg_ring_sqe - submission queue entry
+ * @user_data: Opaque value returned in the matching completion entry
+ * @arg: A struct optee_msg_arg with at most OPTEE_MSG_RING_NUM_PARAMS
+ *	 parameters, only OPTEE_MSG_CMD_INVOKE_COMMAND is supported
+ *
+ * Output parameters are updated in @arg when the command completes. The
+ * normal world must not reuse a submission entry until it has consumed
+ * the completion entry referring to it.
+ */
+struct optee_msg_ring_sqe {
+	uint64_t user_data;
+	uint64_t pad;
+	uint8_t arg[OPTEE_MSG_GET_ARG_SIZE(OPTEE_MSG_RING_NUM_PARAMS)];
+};
+
+/**
+ * struct optee_msg_ring_cqe - completion queue entry
+ * @user_data: Value of user_data in the completed submission entry
+ * @sqe_index: Index in the submission queue of the completed entry
+ * @ret: Return value of the command
+ * @ret_origin: Origin of the return value
+ */
+struct optee_msg_ring_cqe {
+	uint64_t user_data;
+	uint32_t sqe_index;
+	uint32_t ret;
+	uint32_t ret_origin;
+	uint32_t pad;
+};
+
+#define OPTEE_MSG_RING_SIZE(num_entries) \
+	(sizeof(struct optee_msg_ring) + \
+	 (sizeof(struct optee_msg_ring_sqe) + \
+	  sizeof(struct optee_msg_ring_cqe)) * (num_entries))
+
 #endif /*__ASSEMBLER__*/
 
 /*****************************************************************************
@@ -322,6 +390,30 @@ struct optee_msg_arg {
  * [in] param[0].u.rmem.shm_ref		holds shared memory reference
  * [in] param[0].u.rmem.offs		0
  * [in] param[0].u.rmem.size		0
+ *
+ * OPTEE_MSG_CMD_MULTI_INVOKE invokes several commands in previously
+ * opened sessions, one after another in the same call. The information is
+ * passed as:
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_VALUE_INOUT |
+ *					OPTEE_MSG_ATTR_META
+ * [in] param[0].u.value.a		number of entries
+ * [out] param[0].u.value.b		number of entries processed
+ * [in] param[1].attr			OPTEE_MSG_ATTR_TYPE_TMEM_INOUT or
+ *					OPTEE_MSG_ATTR_TYPE_RMEM_INOUT
+ * [in] param[1].u.{tmem,rmem}		buffer holding the entries
+ *
+ * Each entry is a struct optee_msg_arg with cmd set to
+ * OPTEE_MSG_CMD_INVOKE_COMMAND followed by its parameters, the next entry
+ * starts OPTEE_MSG_GET_ARG_SIZE(num_params) bytes after the start of the
+ * current entry. The result of each invoke is returned in the ret and
+ * ret_origin fields of its entry. Processing stops at the first malformed
+ * entry, struct optee_msg_arg::ret of the outer call is TEE_SUCCESS only
+ * if all entries were processed.
+ *
+ * OPTEE_MSG_CMD_PROCESS_RING consumes the submission queue of the ring
+ * registered with OPTEE_SMC_REGISTER_RING. The command returns once the
+ * submission queue is empty or the completion queue is full. Several
+ * calls can process the same ring concurrently. There are no parameters.
  */
 #define OPTEE_MSG_CMD_OPEN_SESSION	0
 #define OPTEE_MSG_CMD_INVOKE_COMMAND	1
@@ -329,6 +421,8 @@ struct optee_msg_arg {
 #define OPTEE_MSG_CMD_CANCEL		3
 #define OPTEE_MSG_CMD_REGISTER_SHM	4
 #define OPTEE_MSG_CMD_UNREGISTER_SHM	5
+#define OPTEE_MSG_CMD_MULTI_INVOKE	6
+#define OPTEE_MSG_CMD_PROCESS_RING	7
 #define OPTEE_MSG_FUNCID_CALL_WITH_ARG	0x0004
 
 #endif /* _OPTEE_MSG_H */
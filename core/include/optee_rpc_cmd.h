@@ -170,6 +170,28 @@
 /* I2C master control flags */
 #define OPTEE_MSG_RPC_CMD_I2C_FLAGS_TEN_BIT	BIT(0)
 
+/*
+ * Issue a combined sequence of master requests to an I2C chip, the
+ * segments being separated by repeated start conditions and the sequence
+ * ending with a single stop condition.
+ *
+ * [in]     value[0].a	    Number of segments in the sequence
+ * [in]     value[0].b	    The I2C bus (a.k.a adapter).
+ *				16 bit field.
+ * [in]     value[0].c	    The I2C chip (a.k.a address).
+ *				16 bit field (either 7 or 10 bit effective).
+ * [in]     value[1].a	    The I2C master control flags (ie, 10 bit address).
+ *				16 bit field.
+ * [in/out] memref[2]	    Buffer starting with one pair of 32 bit words
+ *			    per segment: the transfer mode
+ *			    (OPTEE_MSG_RPC_CMD_I2C_TRANSFER_*) and the
+ *			    length of the segment. The data of the segments
+ *			    follow in the same order, read segments being
+ *			    filled by the REE.
+ * [out]    value[3].a	    Number of data bytes transferred by the REE.
+ */
+#define OPTEE_RPC_CMD_I2C_TRANSFER_SEQ	22
+
 /*
  * Definition of protocol for command OPTEE_RPC_CMD_FS
  */
@@ -274,6 +296,22 @@
  */
 #define OPTEE_RPC_FS_READDIR		10
 
+/*
+ * Write to a file at several offsets
+ *
+ * memref[1] holds an array of value[0].c extents, each described by two
+ * 64-bit values: the offset into the file followed by the length. The data
+ * of the extents is stored back to back in memref[2], in the same order.
+ * Extents are written in order, the request returns once all are written.
+ *
+ * [in]     value[0].a	    OPTEE_RPC_FS_WRITEV
+ * [in]     value[0].b	    File descriptor of open file
+ * [in]     value[0].c	    Number of extents
+ * [in]     memref[1]	    Array of extents
+ * [in]     memref[2]	    Buffer holding data to be written
+ */
+#define OPTEE_RPC_FS_WRITEV		11
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_FS */
 
 /*
@@ -347,6 +385,39 @@
  */
 #define OPTEE_RPC_SOCKET_IOCTL	5
 
+/*
+ * Send several records on socket, in order and up to the first one which
+ * can't be transmitted completely. Each record is a datagram on a UDP
+ * socket.
+ *
+ * [in]     value[0].a	    OPTEE_RPC_SOCKET_SENDV
+ * [in]     value[0].b	    TA instance id
+ * [in]     value[0].c	    Socket handle
+ * [in]     memref[1]	    Records to transmit, one after the other
+ * [in]     memref[2]	    Array of uint32_t, the length of each record
+ * [in]     value[3].a	    Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * [out]    value[3].b	    Number of transmitted records
+ * [out]    value[3].c	    Number of transmitted bytes
+ */
+#define OPTEE_RPC_SOCKET_SENDV	6
+
+/*
+ * Wait for sockets to be ready
+ *
+ * [in]     value[0].a	    OPTEE_RPC_SOCKET_POLL
+ * [in]     value[0].b	    TA instance id
+ * [in/out] memref[1]	    Array of struct { uint32_t handle;
+ *			    uint32_t events; uint32_t revents; }, events
+ *			    and revents are OPTEE_RPC_SOCKET_POLL_* masks
+ * [in]     value[2].a	    Timeout ms or OPTEE_RPC_SOCKET_TIMEOUT_*
+ * [out]    value[2].b	    Number of sockets with revents set
+ */
+#define OPTEE_RPC_SOCKET_POLL	7
+
+#define OPTEE_RPC_SOCKET_POLL_IN	BIT(0)
+#define OPTEE_RPC_SOCKET_POLL_OUT	BIT(1)
+#define OPTEE_RPC_SOCKET_POLL_ERR	BIT(2)
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_SOCKET */
 
 #endif /*__OPTEE_RPC_CMD_H*/
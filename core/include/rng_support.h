@@ -5,8 +5,18 @@
 #ifndef __RNG_SUPPORT_H__
 #define __RNG_SUPPORT_H__
 
+#include <stddef.h>
 #include <stdint.h>
+#include <tee_api_types.h>
 
 uint8_t hw_get_random_byte(void);
 
+/*
+ * Fills @buf with @len bytes from the hardware RNG. The default
+ * implementation used with CFG_WITH_SOFTWARE_PRNG=n calls
+ * hw_get_random_byte() for each byte, drivers override it to read the
+ * RNG in bursts.
+ */
+TEE_Result hw_get_random_bytes(void *buf, size_t len);
+
 #endif /* __RNG_SUPPORT_H__ */
@@ -5,8 +5,35 @@
 #ifndef TEE_CACHE_H
 #define TEE_CACHE_H
 
+#include <tee_api_types.h>
+#include <types_ext.h>
 #include <utee_types.h>
 
 TEE_Result cache_operation(enum utee_cache_operation op, void *va, size_t len);
 
+#define CACHE_OP_BATCH_RANGES	8
+
+/*
+ * Batch of cache_operation() requests of the same @op, for instance all
+ * the buffers of a DMA job. A range touching the cache lines of a queued
+ * range and contiguous with it both in virtual and physical memory is
+ * merged with it. The ranges are maintained by cache_op_batch_flush(), or
+ * when a range doesn't fit in the batch any longer.
+ */
+struct cache_op_batch {
+	enum utee_cache_operation op;
+	size_t count;
+	struct {
+		vaddr_t va;
+		paddr_t pa;
+		size_t len;
+	} range[CACHE_OP_BATCH_RANGES];
+};
+
+void cache_op_batch_init(struct cache_op_batch *batch,
+			 enum utee_cache_operation op);
+TEE_Result cache_op_batch_add(struct cache_op_batch *batch, void *va,
+			      size_t len);
+TEE_Result cache_op_batch_flush(struct cache_op_batch *batch);
+
 #endif /* TEE_CACHE_H */
@@ -41,10 +41,14 @@ struct tee_fs_htree_meta {
 	uint64_t length;
 };
 
-/* Internal struct needed by struct tee_fs_htree_image */
+/*
+ * Internal struct needed by struct tee_fs_htree_image, @fanout is the
+ * number of children of each node or 0 for the original binary tree.
+ */
 struct tee_fs_htree_imeta {
 	struct tee_fs_htree_meta meta;
 	uint32_t max_node_id;
+	uint32_t fanout;
 };
 
 /* Internal struct provided to let the rpc callbacks know the size if needed */
@@ -69,6 +73,7 @@ enum tee_fs_htree_type {
 };
 
 struct tee_fs_rpc_operation;
+struct tee_fs_rpc_writev;
 
 /**
  * struct tee_fs_htree_storage - storage description supplied by user of
@@ -78,6 +83,11 @@ struct tee_fs_rpc_operation;
  *			operation
  * @rpc_write_init:	initialize a struct tee_fs_rpc_operation for an RPC
  *			write operation
+ * @rpc_writev_init:	optional, initialize a struct tee_fs_rpc_writev for
+ *			an RPC vectored write of up to @max_entries entries
+ *			and @max_len bytes
+ * @rpc_writev_add:	add an entry to an RPC vectored write operation,
+ *			returns TEE_ERROR_SHORT_BUFFER if it's full
  *
  * The @idx arguments starts counting from 0. The @vers arguments are either
  * 0 or 1. The @data arguments is a pointer to a buffer in non-secure shared
@@ -94,6 +104,12 @@ struct tee_fs_htree_storage {
 				     enum tee_fs_htree_type type, size_t idx,
 				     uint8_t vers, void **data);
 	TEE_Result (*rpc_write_final)(struct tee_fs_rpc_operation *op);
+	TEE_Result (*rpc_writev_init)(void *aux, struct tee_fs_rpc_writev *wv,
+				      size_t max_entries, size_t max_len);
+	TEE_Result (*rpc_writev_add)(void *aux, struct tee_fs_rpc_writev *wv,
+				     enum tee_fs_htree_type type, size_t idx,
+				     uint8_t vers, void **data);
+	TEE_Result (*rpc_writev_final)(struct tee_fs_rpc_writev *wv);
 };
 
 struct tee_fs_htree;
@@ -130,6 +146,16 @@ struct tee_fs_htree_meta *tee_fs_htree_get_meta(struct tee_fs_htree *ht);
  */
 void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht);
 
+/**
+ * tee_fs_htree_set_compress() - compress blocks written from now on
+ * @ht:		hash tree
+ * @compress:	true to compress the blocks, ignored unless
+ *		CFG_REE_FS_COMPRESS=y
+ *
+ * Compressed blocks are read back regardless of this setting.
+ */
+void tee_fs_htree_set_compress(struct tee_fs_htree *ht, bool compress);
+
 /**
  * tee_fs_htree_sync_to_storage() - synchronize hash tree to storage
  * @ht:		hash tree
@@ -50,6 +50,13 @@ TEE_Result tee_tadb_ta_write(struct tee_tadb_ta_write *ta, const void *buf,
 			     size_t len);
 void tee_tadb_ta_close_and_delete(struct tee_tadb_ta_write *ta);
 TEE_Result tee_tadb_ta_close_and_commit(struct tee_tadb_ta_write *ta);
+/*
+ * Commits @count TAs with a single update of the TA database, if it
+ * fails all the TAs are deleted. A TA replaces an earlier one in @ta with
+ * the same UUID.
+ */
+TEE_Result tee_tadb_ta_close_and_commit_multi(struct tee_tadb_ta_write **ta,
+					      size_t count);
 
 TEE_Result tee_tadb_ta_delete(const TEE_UUID *uuid);
 
@@ -44,6 +44,15 @@ struct tee_file_operations {
 			     bool overwrite);
 	TEE_Result (*remove)(struct tee_pobj *po);
 	TEE_Result (*truncate)(struct tee_file_handle *fh, size_t size);
+	/*
+	 * Optional: once @stage has been called on a file handle, writes
+	 * and truncations through it are only made persistent by
+	 * @commit_staged, which commits the staged files given all at
+	 * once. Closing a staged file handle discards its staged changes.
+	 */
+	void (*stage)(struct tee_file_handle *fh);
+	TEE_Result (*commit_staged)(struct tee_file_handle **fh,
+				    size_t num_fh);
 
 	TEE_Result (*opendir)(const TEE_UUID *uuid, struct tee_fs_dir **d);
 	TEE_Result (*readdir)(struct tee_fs_dir *d, struct tee_fs_dirent **ent);
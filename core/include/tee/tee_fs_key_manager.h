@@ -27,4 +27,10 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 			    const uint8_t *in_key, size_t size,
 			    uint8_t *out_key);
 
+/*
+ * Wipes the cached keys derived for the TA @uuid, see
+ * CFG_FS_KEY_CACHE_ENTRIES
+ */
+void tee_fs_key_cache_flush(const TEE_UUID *uuid);
+
 #endif
@@ -22,6 +22,26 @@ struct tee_fs_rpc_operation {
 	size_t num_params;
 };
 
+/*
+ * struct tee_fs_rpc_writev - vectored write operation
+ * @op:			RPC operation
+ * @extents:		Offset and length pairs of the extents added so far
+ * @data:		Data of the extents, back to back
+ * @max_extents:	Maximum number of extents
+ * @max_data_len:	Maximum total length of data
+ * @num_extents:	Number of extents added
+ * @data_len:		Total length of data added
+ */
+struct tee_fs_rpc_writev {
+	struct tee_fs_rpc_operation op;
+	uint64_t *extents;
+	uint8_t *data;
+	size_t max_extents;
+	size_t max_data_len;
+	size_t num_extents;
+	size_t data_len;
+};
+
 struct tee_fs_dirfile_fileh;
 
 TEE_Result tee_fs_rpc_open(uint32_t id, struct tee_pobj *po, int *fd);
@@ -44,6 +64,20 @@ TEE_Result tee_fs_rpc_write_init(struct tee_fs_rpc_operation *op,
 				 size_t data_len, void **data);
 TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op);
 
+/*
+ * Vectored write, several extents of a file are written with a single
+ * request. tee_fs_rpc_writev_add() returns in @data where to store the
+ * data of an extent, until tee_fs_rpc_writev_final() sends the request.
+ * TEE_ERROR_SHORT_BUFFER is returned when the operation is full.
+ */
+TEE_Result tee_fs_rpc_writev_init(struct tee_fs_rpc_writev *wv,
+				  uint32_t id, int fd, size_t max_extents,
+				  size_t max_data_len);
+TEE_Result tee_fs_rpc_writev_add(struct tee_fs_rpc_writev *wv,
+				 tee_fs_off_t offset, size_t data_len,
+				 void **data);
+TEE_Result tee_fs_rpc_writev_final(struct tee_fs_rpc_writev *wv);
+
 
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len);
 TEE_Result tee_fs_rpc_remove(uint32_t id, struct tee_pobj *po);
@@ -22,11 +22,14 @@ struct tee_obj {
 	size_t ds_pos;
 	struct tee_pobj *pobj;	/* ptr to persistant object */
 	struct tee_file_handle *fh;
+	bool staged;		/* true if writes are held until committed */
+	uint32_t uref;		/* handle given to the TA */
 };
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
+/* Registers @o with the TA, fails if no handle can be allocated */
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
 
-TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
+TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj);
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o);
@@ -49,6 +49,8 @@ TEE_Result syscall_get_property_name_to_index(unsigned long prop_set,
 					      void *name,
 					      unsigned long name_len,
 					      uint32_t *index);
+TEE_Result syscall_get_property_set(unsigned long prop_set, void *buf,
+				    uint32_t *blen);
 
 TEE_Result syscall_open_ta_session(const TEE_UUID *dest,
 			unsigned long cancel_req_to, struct utee_params *params,
@@ -72,6 +74,8 @@ TEE_Result syscall_mask_cancellation(uint32_t *old_mask);
 TEE_Result syscall_wait(unsigned long timeout);
 
 TEE_Result syscall_get_time(unsigned long cat, TEE_Time *time);
+
+TEE_Result syscall_get_time_page(uint64_t *va);
 TEE_Result syscall_set_ta_time(const TEE_Time *time);
 
 #endif /* TEE_SVC_H */
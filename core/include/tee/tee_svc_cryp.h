@@ -23,6 +23,8 @@ TEE_Result syscall_cryp_obj_close(unsigned long obj);
 TEE_Result syscall_cryp_obj_reset(unsigned long obj);
 TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 			struct utee_attribute *attrs, unsigned long attr_count);
+TEE_Result syscall_cryp_obj_populate_batch(struct utee_populate_item *items,
+					   size_t num_items);
 TEE_Result syscall_cryp_obj_copy(unsigned long dst_obj,
 			unsigned long src_obj);
 TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
@@ -50,6 +52,9 @@ TEE_Result syscall_cipher_update(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
 TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
+TEE_Result syscall_cipher_update_vec(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_cnt,
+			void *dest, uint64_t *dest_len);
 
 TEE_Result syscall_cryp_derive_key(unsigned long state,
 			const struct utee_attribute *params,
@@ -65,6 +70,9 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 TEE_Result syscall_authenc_update_payload(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len);
+TEE_Result syscall_authenc_update_payload_vec(unsigned long state,
+			const struct utee_iovec *iov, size_t iov_cnt,
+			void *dest_data, uint64_t *dest_len);
 TEE_Result syscall_authenc_enc_final(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len, void *tag, uint64_t *tag_len);
@@ -80,6 +88,10 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 			const struct utee_attribute *usr_params,
 			size_t num_params, const void *data, size_t data_len,
 			const void *sig, size_t sig_len);
+TEE_Result syscall_asymm_verify_batch(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, struct utee_verify_item *items,
+			size_t num_items);
 
 TEE_Result tee_obj_set_type(struct tee_obj *o, uint32_t obj_type,
 			    size_t max_key_size);
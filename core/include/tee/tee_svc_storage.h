@@ -9,6 +9,7 @@
 #include <tee_api_types.h>
 #include <kernel/tee_ta_manager.h>
 #include <tee/tee_fs.h>
+#include <utee_types.h>
 
 /*
  * Returns the appropriate tee_file_operations for the specified storage ID.
@@ -17,6 +18,12 @@
  */
 const struct tee_file_operations *tee_svc_storage_file_ops(uint32_t storage_id);
 
+/*
+ * Drops the cached header and attributes of a persistent object, to be
+ * called before the object file is created, renamed or removed.
+ */
+void tee_svc_storage_head_cache_invalidate(struct tee_pobj *po);
+
 /*
  * Persistant Object Functions
  */
@@ -49,6 +56,10 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 			TEE_ObjectInfo *info, void *obj_id, uint64_t *len);
 
+TEE_Result syscall_storage_next_enum_batch(unsigned long obj_enum,
+			struct utee_enum_item *usr_items, size_t num_items,
+			uint64_t *count);
+
 /*
  * Data Stream Access Functions
  */
@@ -63,6 +74,16 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 				    unsigned long whence);
 
+TEE_Result syscall_storage_tx_begin(void);
+
+TEE_Result syscall_storage_tx_commit(void);
+
+/*
+ * Commits the staged writes of all the objects of the TA at once, the
+ * transaction remains open.
+ */
+TEE_Result tee_svc_storage_commit_staged(struct user_ta_ctx *utc);
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc);
 
 void tee_svc_storage_init(void);
@@ -38,6 +38,12 @@ struct asan_global {
 #endif
 };
 
+/*
+ * Shadow bytes and the buffers of asan_memset_unchecked() and
+ * asan_memcpy_unchecked() are also accessed a word at a time.
+ */
+typedef unsigned long __attribute__((__may_alias__)) asan_word_t;
+
 static vaddr_t asan_va_base;
 static size_t asan_va_size;
 static bool asan_active;
@@ -118,8 +124,9 @@ void asan_tag_access(const void *begin, const void *end)
 
 	asan_memset_unchecked(va_to_shadow(begin), 0,
 			      va_range_to_shadow_size(begin, end));
+	/* A partial block holds the number of accessible bytes */
 	if (!va_is_well_aligned(end))
-		*va_to_shadow(end) = ASAN_BLOCK_SIZE - va_misalignment(end);
+		*va_to_shadow(end) = va_misalignment(end);
 }
 
 void asan_tag_heap_free(const void *begin, const void *end)
@@ -135,13 +142,24 @@ void asan_tag_heap_free(const void *begin, const void *end)
 			      va_range_to_shadow_size(begin, end));
 }
 
+static bool is_word_aligned(const void *p)
+{
+	return !((vaddr_t)p & (sizeof(asan_word_t) - 1));
+}
+
 void *asan_memset_unchecked(void *s, int c, size_t n)
 {
+	asan_word_t w = (uint8_t)c * (~(asan_word_t)0 / UINT8_MAX);
 	uint8_t *b = s;
-	size_t m;
 
-	for (m = 0; m < n; m++)
-		b[m] = c;
+	while (n && !is_word_aligned(b)) {
+		*b++ = c;
+		n--;
+	}
+	for (; n >= sizeof(w); n -= sizeof(w), b += sizeof(w))
+		*(asan_word_t *)b = w;
+	while (n--)
+		*b++ = c;
 
 	return s;
 }
@@ -151,10 +169,24 @@ void *asan_memcpy_unchecked(void *__restrict dst, const void *__restrict src,
 {
 	uint8_t *__restrict d = dst;
 	const uint8_t *__restrict s = src;
-	size_t n;
 
-	for (n = 0; n < len; n++)
-		d[n] = s[n];
+	/* Words are only copied if both buffers can be aligned together */
+	if (((vaddr_t)d ^ (vaddr_t)s) & (sizeof(asan_word_t) - 1))
+		goto copy_bytes;
+
+	while (len && !is_word_aligned(d)) {
+		*d++ = *s++;
+		len--;
+	}
+	for (; len >= sizeof(asan_word_t); len -= sizeof(asan_word_t)) {
+		*(asan_word_t *)d = *(const asan_word_t *)s;
+		d += sizeof(asan_word_t);
+		s += sizeof(asan_word_t);
+	}
+
+copy_bytes:
+	while (len--)
+		*d++ = *s++;
 
 	return dst;
 }
@@ -165,12 +197,27 @@ void asan_start(void)
 	asan_active = true;
 }
 
+/* Returns true if all the shadow bytes in [@b, @e) are 0 */
+static bool shadow_is_zero(const int8_t *b, const int8_t *e)
+{
+	while (b < e && !is_word_aligned(b))
+		if (*b++)
+			return false;
+	for (; e - b >= (ptrdiff_t)sizeof(asan_word_t); b += sizeof(asan_word_t))
+		if (*(const asan_word_t *)b)
+			return false;
+	while (b < e)
+		if (*b++)
+			return false;
+
+	return true;
+}
+
 static void check_access(vaddr_t addr, size_t size)
 {
 	void *begin = (void *)addr;
 	void *end = (void *)(addr + size);
-	int8_t *a;
-	int8_t *e;
+	int8_t *e = NULL;
 
 	if (!asan_active || !size)
 		return;
@@ -183,13 +230,39 @@ static void check_access(vaddr_t addr, size_t size)
 	if (!va_range_inside_shadow(begin, end))
 		panic();
 
+	/*
+	 * All the blocks but the last one must be fully accessible, the
+	 * last one up to the last byte of the access.
+	 */
 	e = va_to_shadow((void *)(addr + size - 1));
-	for (a = va_to_shadow(begin); a <= e; a++)
-		if (*a < 0)
-			panic();
+	if (!shadow_is_zero(va_to_shadow(begin), e))
+		panic();
+	if (*e && (*e < 0 || va_misalignment((void *)(addr + size - 1)) >=
+			     (size_t)*e))
+		panic();
+}
+
+/*
+ * Fast path for the fixed size accesses of the instrumented code which
+ * fit in one block of the shadowed range, only one shadow byte has to be
+ * checked then.
+ */
+static void check_access_fixed(vaddr_t addr, size_t size)
+{
+	size_t misalign = va_misalignment((void *)addr);
+	vaddr_t offs = addr - asan_va_base;
+	int8_t s = 0;
+
+	if (!asan_active)
+		return;
+	if (offs >= asan_va_size || asan_va_size - offs < size ||
+	    misalign + size > ASAN_BLOCK_SIZE) {
+		check_access(addr, size);
+		return;
+	}
 
-	if (!va_is_well_aligned(end) &&
-	    va_misalignment(end) > (size_t)(*e - ASAN_BLOCK_SIZE))
+	s = *va_to_shadow((void *)addr);
+	if (s && (s < 0 || misalign + size > (size_t)s))
 		panic();
 }
 
@@ -218,10 +291,10 @@ static void __noreturn report_store(vaddr_t addr __unused, size_t size __unused)
 #define DEFINE_ASAN_FUNC(type, size)				\
 	void __asan_##type##size(vaddr_t addr);			\
 	void __asan_##type##size(vaddr_t addr)			\
-	{ check_##type(addr, size); }				\
+	{ check_access_fixed(addr, size); }			\
 	void __asan_##type##size##_noabort(vaddr_t addr);	\
 	void __asan_##type##size##_noabort(vaddr_t addr)	\
-	{ check_##type(addr, size); }				\
+	{ check_access_fixed(addr, size); }			\
 	void __asan_report_##type##size##_noabort(vaddr_t addr);\
 	void __noreturn __asan_report_##type##size##_noabort(vaddr_t addr) \
 	{ report_##type(addr, size); }
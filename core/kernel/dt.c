@@ -4,26 +4,230 @@
  */
 
 #include <assert.h>
+#include <initcall.h>
+#include <kernel/boot.h>
 #include <kernel/dt.h>
 #include <kernel/linker.h>
 #include <libfdt.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 
+struct dt_compat_entry {
+	const char *compat;
+	int offs;
+};
+
+struct dt_phandle_entry {
+	uint32_t phandle;
+	int offs;
+};
+
+/*
+ * Index of the embedded DT built once at boot, the "compatible" strings
+ * and the phandles of all the nodes mapped to the node offsets. Both
+ * arrays are sorted for a binary search, the compatible entries by string
+ * and then by offset. The compatible strings point into the DT itself.
+ *
+ * The index is only used while the structure block of the DT keeps the
+ * size it had when the index was built, adding or removing a node or a
+ * property moves the node offsets and makes the helpers fall back to a
+ * libfdt scan of the DT.
+ */
+static struct dt_index {
+	const void *fdt;
+	uint32_t struct_size;
+	struct dt_compat_entry *compat;
+	size_t compat_count;
+	struct dt_phandle_entry *phandle;
+	size_t phandle_count;
+} dt_index;
+
+static bool dt_index_is_valid(const void *fdt)
+{
+	return dt_index.fdt && fdt == dt_index.fdt &&
+	       fdt_size_dt_struct(fdt) == dt_index.struct_size;
+}
+
+/* Counts the entries if the arrays of @idx aren't allocated yet */
+static void dt_index_scan(const void *fdt, struct dt_index *idx)
+{
+	const char *prop = NULL;
+	uint32_t phandle = 0;
+	size_t l = 0;
+	int offs = 0;
+	int len = 0;
+
+	idx->compat_count = 0;
+	idx->phandle_count = 0;
+
+	for (offs = fdt_next_node(fdt, -1, NULL); offs >= 0;
+	     offs = fdt_next_node(fdt, offs, NULL)) {
+		phandle = fdt_get_phandle(fdt, offs);
+		if (phandle) {
+			if (idx->phandle) {
+				idx->phandle[idx->phandle_count].phandle =
+					phandle;
+				idx->phandle[idx->phandle_count].offs = offs;
+			}
+			idx->phandle_count++;
+		}
+
+		prop = fdt_getprop(fdt, offs, "compatible", &len);
+		while (prop && len > 0) {
+			l = strnlen(prop, len);
+			if (l == (size_t)len)
+				break;
+			if (idx->compat) {
+				idx->compat[idx->compat_count].compat = prop;
+				idx->compat[idx->compat_count].offs = offs;
+			}
+			idx->compat_count++;
+			prop += l + 1;
+			len -= l + 1;
+		}
+	}
+}
+
+static int cmp_compat_entry(const void *a, const void *b)
+{
+	const struct dt_compat_entry *ea = a;
+	const struct dt_compat_entry *eb = b;
+	int rc = strcmp(ea->compat, eb->compat);
+
+	if (rc)
+		return rc;
+	return CMP_TRILEAN(ea->offs, eb->offs);
+}
+
+static int cmp_phandle_entry(const void *a, const void *b)
+{
+	const struct dt_phandle_entry *ea = a;
+	const struct dt_phandle_entry *eb = b;
+
+	return CMP_TRILEAN(ea->phandle, eb->phandle);
+}
+
+static TEE_Result dt_index_init(void)
+{
+	const void *fdt = get_embedded_dt();
+	struct dt_index idx = { };
+
+	if (!fdt)
+		return TEE_SUCCESS;
+
+	dt_index_scan(fdt, &idx);
+	if (!idx.compat_count && !idx.phandle_count)
+		return TEE_SUCCESS;
+
+	idx.compat = calloc(idx.compat_count + 1, sizeof(*idx.compat));
+	idx.phandle = calloc(idx.phandle_count + 1, sizeof(*idx.phandle));
+	if (!idx.compat || !idx.phandle) {
+		/* The index is only an optimization */
+		EMSG("Can't allocate the DT index");
+		free(idx.compat);
+		free(idx.phandle);
+		return TEE_SUCCESS;
+	}
+
+	dt_index_scan(fdt, &idx);
+	qsort(idx.compat, idx.compat_count, sizeof(*idx.compat),
+	      cmp_compat_entry);
+	qsort(idx.phandle, idx.phandle_count, sizeof(*idx.phandle),
+	      cmp_phandle_entry);
+
+	idx.fdt = fdt;
+	idx.struct_size = fdt_size_dt_struct(fdt);
+	dt_index = idx;
+
+	DMSG("DT index: %zu compatible strings, %zu phandles",
+	     idx.compat_count, idx.phandle_count);
+
+	return TEE_SUCCESS;
+}
+early_init(dt_index_init);
+
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible)
+{
+	const struct dt_compat_entry *e = NULL;
+	size_t hi = 0;
+	size_t lo = 0;
+	size_t n = 0;
+	int rc = 0;
+
+	if (!dt_index_is_valid(fdt))
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	/* Find the first entry of @compatible after @startoffset */
+	hi = dt_index.compat_count;
+	while (lo < hi) {
+		n = lo + (hi - lo) / 2;
+		e = dt_index.compat + n;
+		rc = strcmp(e->compat, compatible);
+		if (rc < 0 || (!rc && e->offs <= startoffset))
+			lo = n + 1;
+		else
+			hi = n;
+	}
+
+	if (lo < dt_index.compat_count &&
+	    !strcmp(dt_index.compat[lo].compat, compatible))
+		return dt_index.compat[lo].offs;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	const struct dt_phandle_entry *e = NULL;
+	size_t hi = 0;
+	size_t lo = 0;
+	size_t n = 0;
+
+	if (!dt_index_is_valid(fdt))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	hi = dt_index.phandle_count;
+	while (lo < hi) {
+		n = lo + (hi - lo) / 2;
+		e = dt_index.phandle + n;
+		if (e->phandle == phandle)
+			return e->offs;
+		if (e->phandle < phandle)
+			lo = n + 1;
+		else
+			hi = n;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
 const struct dt_driver *dt_find_compatible_driver(const void *fdt, int offs)
 {
 	const struct dt_device_match *dm;
 	const struct dt_driver *drv;
+	const char *compat = NULL;
+	int len = 0;
+
+	/* Look up the property once rather than once per match entry */
+	compat = fdt_getprop(fdt, offs, "compatible", &len);
+	if (!compat)
+		return NULL;
 
 	for_each_dt_driver(drv) {
 		for (dm = drv->match_table; dm; dm++) {
 			if (!dm->compatible) {
 				break;
 			}
-			if (!fdt_node_check_compatible(fdt, offs,
-						       dm->compatible)) {
+			if (fdt_stringlist_contains(compat, len,
+						    dm->compatible)) {
 				return drv;
 			}
 		}
@@ -3,6 +3,7 @@
  * Copyright (c) 2014, Linaro Limited
  * Copyright (c) 2020, Arm Limited
  */
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <kernel/handle.h>
@@ -15,6 +16,36 @@
  */
 #define HANDLE_DB_INITIAL_MAX_PTRS	4
 
+/*
+ * Unused entries in db->ptrs are linked in a free list. A free entry
+ * holds the index + 1 of the next free entry (0 ends the list) shifted
+ * one bit left and with bit 0 set, which can't be mistaken for a
+ * registered pointer since those are required to be at least 2-byte
+ * aligned. db->free_list holds the index + 1 of the first free entry.
+ */
+#define FREE_BIT	1UL
+
+static bool is_free(void *p)
+{
+	return (uintptr_t)p & FREE_BIT;
+}
+
+static void *encode_free(size_t next)
+{
+	return (void *)((next << 1) | FREE_BIT);
+}
+
+static size_t decode_free(void *p)
+{
+	return (uintptr_t)p >> 1;
+}
+
+static void push_free(struct handle_db *db, size_t n)
+{
+	db->ptrs[n] = encode_free(db->free_list);
+	db->free_list = n + 1;
+}
+
 void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 {
 	if (db) {
@@ -22,26 +53,20 @@ void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 			size_t n = 0;
 
 			for (n = 0; n < db->max_ptrs; n++)
-				if (db->ptrs[n])
+				if (!is_free(db->ptrs[n]))
 					ptr_destructor(db->ptrs[n]);
 		}
 		free(db->ptrs);
 		db->ptrs = NULL;
 		db->max_ptrs = 0;
+		db->free_list = 0;
+		db->num_ptrs = 0;
 	}
 }
 
 bool handle_db_is_empty(struct handle_db *db)
 {
-	size_t n = 0;
-
-	if (db) {
-		for (n = 0; n < db->max_ptrs; n++) {
-			if (db->ptrs[n])
-				return false;
-		}
-	}
-	return true;
+	return !db || !db->num_ptrs;
 }
 
 int handle_get(struct handle_db *db, void *ptr)
@@ -52,30 +77,29 @@ int handle_get(struct handle_db *db, void *ptr)
 
 	if (!db || !ptr)
 		return -1;
+	assert(!is_free(ptr));
 
-	/* Try to find an empty location */
-	for (n = 0; n < db->max_ptrs; n++) {
-		if (!db->ptrs[n]) {
-			db->ptrs[n] = ptr;
-			return n;
-		}
-	}
+	if (!db->free_list) {
+		/* No location available, grow the ptrs array */
+		if (db->max_ptrs)
+			new_max_ptrs = db->max_ptrs * 2;
+		else
+			new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+		p = realloc(db->ptrs, new_max_ptrs * sizeof(void *));
+		if (!p)
+			return -1;
+		db->ptrs = p;
 
-	/* No location available, grow the ptrs array */
-	if (db->max_ptrs)
-		new_max_ptrs = db->max_ptrs * 2;
-	else
-		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
-	p = realloc(db->ptrs, new_max_ptrs * sizeof(void *));
-	if (!p)
-		return -1;
-	db->ptrs = p;
-	memset(db->ptrs + db->max_ptrs, 0,
-	       (new_max_ptrs - db->max_ptrs) * sizeof(void *));
-	db->max_ptrs = new_max_ptrs;
+		/* Add the new locations to the free list, lowest first */
+		for (n = new_max_ptrs; n > db->max_ptrs; n--)
+			push_free(db, n - 1);
+		db->max_ptrs = new_max_ptrs;
+	}
 
-	/* Since n stopped at db->max_ptrs there is an empty location there */
+	n = db->free_list - 1;
+	db->free_list = decode_free(db->ptrs[n]);
 	db->ptrs[n] = ptr;
+	db->num_ptrs++;
 	return n;
 }
 
@@ -87,14 +111,43 @@ void *handle_put(struct handle_db *db, int handle)
 		return NULL;
 
 	p = db->ptrs[handle];
-	db->ptrs[handle] = NULL;
+	if (is_free(p))
+		return NULL;
+
+	push_free(db, handle);
+	db->num_ptrs--;
 	return p;
 }
 
 void *handle_lookup(struct handle_db *db, int handle)
 {
+	void *p = NULL;
+
 	if (!db || handle < 0 || (size_t)handle >= db->max_ptrs)
 		return NULL;
 
-	return db->ptrs[handle];
+	p = db->ptrs[handle];
+	if (is_free(p))
+		return NULL;
+
+	return p;
+}
+
+bool handle_get_uref(struct handle_db *db, void *ptr, uint32_t *gen,
+		     uint32_t *uref)
+{
+	int h = handle_get(db, ptr);
+
+	if (h < 0)
+		return false;
+	/* Handle + 1 must fit below the generation count */
+	if ((uint32_t)h >= BIT32(HANDLE_UREF_IDX_BITS) - 1) {
+		handle_put(db, h);
+		return false;
+	}
+
+	*uref = SHIFT_U32(*gen, HANDLE_UREF_IDX_BITS) | (h + 1);
+	(*gen)++;
+
+	return true;
 }
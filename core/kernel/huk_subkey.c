@@ -4,10 +4,144 @@
  */
 
 #include <crypto/crypto.h>
+#include <initcall.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/pm.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_common_otp.h>
+#include <string.h>
 #include <string_ext.h>
 #include <tee/tee_fs_key_manager.h>
+#include <util.h>
+
+#if CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES
+/*
+ * Derived subkeys are cached to avoid reading the hardware unique key on
+ * each derivation, only derivations with no more than
+ * HUK_CACHE_CONST_MAX_LEN bytes of constant data are cached.
+ */
+#define HUK_CACHE_CONST_MAX_LEN	64
+
+struct huk_cache_entry {
+	bool valid;
+	enum huk_subkey_usage usage;
+	size_t const_data_len;
+	size_t subkey_len;
+	uint8_t const_data[HUK_CACHE_CONST_MAX_LEN];
+	uint8_t subkey[HUK_SUBKEY_MAX_LEN];
+};
+
+static struct huk_cache_entry huk_cache[CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES];
+static unsigned int huk_cache_next;
+static unsigned int huk_cache_lock = SPINLOCK_UNLOCK;
+
+static struct huk_cache_entry *
+huk_cache_find(enum huk_subkey_usage usage, const void *const_data,
+	       size_t const_data_len, size_t subkey_len)
+{
+	struct huk_cache_entry *e = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(huk_cache); n++) {
+		e = huk_cache + n;
+		if (e->valid && e->usage == usage &&
+		    e->subkey_len == subkey_len &&
+		    e->const_data_len == const_data_len &&
+		    !consttime_memcmp(e->const_data, const_data,
+				      const_data_len))
+			return e;
+	}
+
+	return NULL;
+}
+
+static bool huk_cache_get(enum huk_subkey_usage usage, const void *const_data,
+			  size_t const_data_len, uint8_t *subkey,
+			  size_t subkey_len)
+{
+	struct huk_cache_entry *e = NULL;
+	uint32_t exceptions = 0;
+
+	if (const_data_len > HUK_CACHE_CONST_MAX_LEN)
+		return false;
+
+	exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+	e = huk_cache_find(usage, const_data, const_data_len, subkey_len);
+	if (e)
+		memcpy(subkey, e->subkey, subkey_len);
+	cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+
+	return e;
+}
+
+static void huk_cache_put(enum huk_subkey_usage usage, const void *const_data,
+			  size_t const_data_len, const uint8_t *subkey,
+			  size_t subkey_len)
+{
+	struct huk_cache_entry *e = NULL;
+	uint32_t exceptions = 0;
+
+	if (const_data_len > HUK_CACHE_CONST_MAX_LEN)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+	/* Another thread may have derived the same subkey meanwhile */
+	if (!huk_cache_find(usage, const_data, const_data_len, subkey_len)) {
+		e = huk_cache + huk_cache_next;
+		huk_cache_next = (huk_cache_next + 1) % ARRAY_SIZE(huk_cache);
+
+		memzero_explicit(e, sizeof(*e));
+		e->usage = usage;
+		e->const_data_len = const_data_len;
+		if (const_data_len)
+			memcpy(e->const_data, const_data, const_data_len);
+		e->subkey_len = subkey_len;
+		memcpy(e->subkey, subkey, subkey_len);
+		e->valid = true;
+	}
+	cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+}
+
+static TEE_Result huk_cache_pm(enum pm_op op, uint32_t pm_hint __unused,
+			       const struct pm_callback_handle *hdl __unused)
+{
+	uint32_t exceptions = 0;
+
+	/* Don't keep derived keys in memory across a suspend */
+	if (op == PM_OP_SUSPEND) {
+		exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+		memzero_explicit(huk_cache, sizeof(huk_cache));
+		cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+	}
+
+	return TEE_SUCCESS;
+}
+DECLARE_KEEP_PAGER(huk_cache_pm);
+
+static TEE_Result huk_cache_init(void)
+{
+	register_pm_core_service_cb(huk_cache_pm, NULL);
+
+	return TEE_SUCCESS;
+}
+service_init(huk_cache_init);
+#else
+static bool huk_cache_get(enum huk_subkey_usage usage __unused,
+			  const void *const_data __unused,
+			  size_t const_data_len __unused,
+			  uint8_t *subkey __unused, size_t subkey_len __unused)
+{
+	return false;
+}
+
+static void huk_cache_put(enum huk_subkey_usage usage __unused,
+			  const void *const_data __unused,
+			  size_t const_data_len __unused,
+			  const uint8_t *subkey __unused,
+			  size_t subkey_len __unused)
+{
+}
+#endif /*CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES*/
 
 static TEE_Result mac_usage(void *ctx, uint32_t usage)
 {
@@ -67,6 +201,10 @@ TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 	if (!const_data && const_data_len)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (huk_cache_get(usage, const_data, const_data_len, subkey,
+			  subkey_len))
+		return TEE_SUCCESS;
+
 	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
 	if (res)
 		return res;
@@ -94,6 +232,9 @@ TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 	}
 
 	res = crypto_mac_final(ctx, subkey, subkey_len);
+	if (!res)
+		huk_cache_put(usage, const_data, const_data_len, subkey,
+			      subkey_len);
 out:
 	if (res)
 		memzero_explicit(subkey, subkey_len);
@@ -4,10 +4,56 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <arm.h>
 #include <initcall.h>
 #include <trace.h>
 #include <kernel/linker.h>
 
+#ifdef CFG_CORE_INITCALL_PROFILE
+static uint64_t initcall_profile_begin(void)
+{
+	return barrier_read_cntpct();
+}
+
+static void initcall_profile_end(const struct initcall *call, uint64_t begin,
+				 uint64_t *total_cnt)
+{
+	uint64_t cnt = barrier_read_cntpct() - begin;
+
+	*total_cnt += cnt;
+#if TRACE_LEVEL >= TRACE_DEBUG
+	IMSG("level %d %s(): %" PRIu64 " us", call->level, call->func_name,
+	     cnt * 1000000 / read_cntfrq());
+#else
+	IMSG("__text_start + 0x%08" PRIxVA ": %" PRIu64 " us",
+	     (vaddr_t)call->func - VCORE_START_VA,
+	     cnt * 1000000 / read_cntfrq());
+#endif
+}
+
+static void initcall_profile_total(const char *type, uint64_t total_cnt)
+{
+	IMSG("%s total: %" PRIu64 " us", type,
+	     total_cnt * 1000000 / read_cntfrq());
+}
+#else
+static uint64_t initcall_profile_begin(void)
+{
+	return 0;
+}
+
+static void initcall_profile_end(const struct initcall *call __unused,
+				 uint64_t begin __unused,
+				 uint64_t *total_cnt __unused)
+{
+}
+
+static void initcall_profile_total(const char *type __unused,
+				   uint64_t total_cnt __unused)
+{
+}
+#endif
+
 /*
  * Note: this function is weak just to make it possible to exclude it from
  * the unpaged area.
@@ -16,15 +62,20 @@ void __weak call_initcalls(void)
 {
 	const struct initcall *call = NULL;
 	TEE_Result ret = TEE_SUCCESS;
+	uint64_t total_cnt = 0;
+	uint64_t begin = 0;
 
 	for (call = initcall_begin; call < initcall_end; call++) {
 		DMSG("level %d %s()", call->level, call->func_name);
+		begin = initcall_profile_begin();
 		ret = call->func();
+		initcall_profile_end(call, begin, &total_cnt);
 		if (ret != TEE_SUCCESS) {
 			EMSG("Initcall __text_start + 0x%08" PRIxVA
 			     " failed", (vaddr_t)call - VCORE_START_VA);
 		}
 	}
+	initcall_profile_total("Initcalls", total_cnt);
 }
 
 /*
@@ -35,13 +86,18 @@ void __weak call_finalcalls(void)
 {
 	const struct initcall *call = NULL;
 	TEE_Result ret = TEE_SUCCESS;
+	uint64_t total_cnt = 0;
+	uint64_t begin = 0;
 
 	for (call = finalcall_begin; call < finalcall_end; call++) {
 		DMSG("level %d %s()", call->level, call->func_name);
+		begin = initcall_profile_begin();
 		ret = call->func();
+		initcall_profile_end(call, begin, &total_cnt);
 		if (ret != TEE_SUCCESS) {
 			EMSG("Finalcall __text_start + 0x%08" PRIxVA
 			     " failed", (vaddr_t)call - VCORE_START_VA);
 		}
 	}
+	initcall_profile_total("Finalcalls", total_cnt);
 }
@@ -3,10 +3,12 @@
  * Copyright (c) 2016-2019, Linaro Limited
  */
 
+#include <arm.h>
 #include <kernel/interrupt.h>
 #include <kernel/panic.h>
 #include <trace.h>
 #include <assert.h>
+#include <util.h>
 
 /*
  * NOTE!
@@ -16,9 +18,75 @@
  * we begin to modify settings after boot initialization.
  */
 
+/*
+ * The handlers are kept in a table indexed by a hash of the interrupt
+ * number so that an interrupt doesn't have to be looked up among the
+ * handlers of all the interrupts. The handlers of a shared interrupt are
+ * chained in the same bucket.
+ */
+#define ITR_HASH_SIZE	64
+
 static struct itr_chip *itr_chip __nex_bss;
-static SLIST_HEAD(, itr_handler) handlers __nex_data =
-	SLIST_HEAD_INITIALIZER(handlers);
+static SLIST_HEAD(itr_handler_head, itr_handler) handlers[ITR_HASH_SIZE]
+	__nex_bss;
+
+static struct itr_handler_head *handler_head(size_t it)
+{
+	return handlers + it % ITR_HASH_SIZE;
+}
+
+#ifdef CFG_ITR_STATS
+/*
+ * The counters are updated without any lock, a per-cpu interrupt (PPI)
+ * handled on several cores at the same time may then miss an update.
+ */
+static enum itr_return call_handler(struct itr_handler *h)
+{
+	uint64_t start = barrier_read_cntpct();
+	enum itr_return ret = h->handler(h);
+	uint64_t t = 0;
+
+	if (ret == ITRR_HANDLED) {
+		t = barrier_read_cntpct() - start;
+		h->count++;
+		h->time_total_cnt += t;
+		h->time_max_cnt = MAX(h->time_max_cnt, t);
+	}
+
+	return ret;
+}
+
+size_t itr_stats_get(struct itr_stats *stats, size_t count, bool reset)
+{
+	struct itr_handler *h = NULL;
+	size_t n = 0;
+	size_t i = 0;
+
+	for (i = 0; i < ITR_HASH_SIZE; i++) {
+		SLIST_FOREACH(h, handlers + i, link) {
+			if (n < count) {
+				stats[n].it = h->it;
+				stats[n].count = h->count;
+				stats[n].time_total_cnt = h->time_total_cnt;
+				stats[n].time_max_cnt = h->time_max_cnt;
+			}
+			if (reset) {
+				h->count = 0;
+				h->time_total_cnt = 0;
+				h->time_max_cnt = 0;
+			}
+			n++;
+		}
+	}
+
+	return n;
+}
+#else
+static enum itr_return call_handler(struct itr_handler *h)
+{
+	return h->handler(h);
+}
+#endif
 
 void itr_init(struct itr_chip *chip)
 {
@@ -30,9 +98,9 @@ void itr_handle(size_t it)
 	struct itr_handler *h = NULL;
 	bool was_handled = false;
 
-	SLIST_FOREACH(h, &handlers, link) {
+	SLIST_FOREACH(h, handler_head(it), link) {
 		if (h->it == it) {
-			if (h->handler(h) == ITRR_HANDLED)
+			if (call_handler(h) == ITRR_HANDLED)
 				was_handled = true;
 			else if (!(h->flags & ITRF_SHARED))
 				break;
@@ -49,13 +117,18 @@ void itr_add(struct itr_handler *h)
 {
 	struct itr_handler __maybe_unused *hdl = NULL;
 
-	SLIST_FOREACH(hdl, &handlers, link)
+	SLIST_FOREACH(hdl, handler_head(h->it), link)
 		if (hdl->it == h->it)
 			assert((hdl->flags & ITRF_SHARED) &&
 			       (h->flags & ITRF_SHARED));
 
 	itr_chip->ops->add(itr_chip, h->it, h->flags);
-	SLIST_INSERT_HEAD(&handlers, h, link);
+	SLIST_INSERT_HEAD(handler_head(h->it), h, link);
+}
+
+void itr_add_this_cpu(size_t it, uint32_t flags)
+{
+	itr_chip->ops->add(itr_chip, it, flags);
 }
 
 void itr_enable(size_t it)
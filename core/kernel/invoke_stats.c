@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/invoke_stats.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+static struct invoke_stats stats_table[CFG_TA_INVOKE_STATS_ENTRIES];
+static size_t stats_count;
+static unsigned int stats_lock = SPINLOCK_UNLOCK;
+
+static uint64_t cnt2us(uint64_t cnt)
+{
+	return cnt * 1000000 / read_cntfrq();
+}
+
+static unsigned int hist_bucket(uint64_t us)
+{
+	unsigned int n = 0;
+
+	if (us < 2)
+		return 0;
+
+	n = 63 - __builtin_clzll(us);
+
+	return MIN(n, INVOKE_STATS_HIST_BUCKETS - 1U);
+}
+
+static struct invoke_stats *find_stats(const TEE_UUID *uuid, uint32_t cmd)
+{
+	struct invoke_stats *s = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < stats_count; n++) {
+		s = stats_table + n;
+		if (s->cmd == cmd && !memcmp(&s->uuid, uuid, sizeof(*uuid)))
+			return s;
+	}
+
+	if (stats_count == ARRAY_SIZE(stats_table))
+		return NULL;
+
+	s = stats_table + stats_count;
+	stats_count++;
+	memset(s, 0, sizeof(*s));
+	s->uuid = *uuid;
+	s->cmd = cmd;
+
+	return s;
+}
+
+void invoke_stats_stop(struct invoke_stats_sample *sample,
+		       const TEE_UUID *uuid, uint32_t cmd)
+{
+	uint64_t rpc = thread_get_tsd()->rpc_cnt - sample->rpc_start;
+	uint64_t total = barrier_read_cntpct() - sample->start;
+	uint64_t busy = sample->busy_done - sample->start;
+	struct invoke_stats *s = NULL;
+	uint32_t exceptions = 0;
+	uint64_t total_us = cnt2us(total);
+
+	exceptions = cpu_spin_lock_xsave(&stats_lock);
+	s = find_stats(uuid, cmd);
+	if (s) {
+		s->count++;
+		s->total_us += total_us;
+		s->rpc_us += cnt2us(rpc);
+		s->busy_wait_us += cnt2us(busy);
+		s->hist[hist_bucket(total_us)]++;
+	}
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+size_t invoke_stats_get(struct invoke_stats *stats, size_t count, bool reset)
+{
+	uint32_t exceptions = 0;
+	size_t ret = 0;
+
+	exceptions = cpu_spin_lock_xsave(&stats_lock);
+	ret = stats_count;
+	memcpy(stats, stats_table, MIN(count, ret) * sizeof(*stats));
+	if (reset)
+		stats_count = 0;
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+
+	return ret;
+}
+
+uint32_t invoke_stats_percentile(const struct invoke_stats *stats,
+				 unsigned int pct)
+{
+	uint64_t target = ((uint64_t)stats->count * pct + 99) / 100;
+	uint64_t sum = 0;
+	unsigned int n = 0;
+
+	for (n = 0; n < INVOKE_STATS_HIST_BUCKETS - 1; n++) {
+		sum += stats->hist[n];
+		if (sum >= target)
+			break;
+	}
+
+	return BIT32(n + 1);
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <keep.h>
+#include <kernel/lock_stats.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+static SLIST_HEAD(, lock_stats) stats_list = SLIST_HEAD_INITIALIZER(stats_list);
+static unsigned int stats_lock = SPINLOCK_UNLOCK;
+
+static void register_stats(struct lock_stats *s)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&stats_lock);
+
+	if (!s->registered) {
+		SLIST_INSERT_HEAD(&stats_list, s, link);
+		s->registered = true;
+	}
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+DECLARE_KEEP_PAGER(register_stats);
+
+void lock_stats_acquired(struct lock_stats *s, uint64_t start,
+			 unsigned int sleeps)
+{
+	uint64_t wait = 0;
+
+	if (!s || !s->name)
+		return;
+
+	if (!s->registered)
+		register_stats(s);
+
+	s->acquired++;
+	if (start) {
+		wait = barrier_read_cntpct() - start;
+		s->contended++;
+		s->sleeps += sleeps;
+		s->wait_total_cnt += wait;
+		s->wait_max_cnt = MAX(s->wait_max_cnt, wait);
+	}
+}
+DECLARE_KEEP_PAGER(lock_stats_acquired);
+
+size_t lock_stats_get(struct lock_stats *stats, size_t count, bool reset)
+{
+	struct lock_stats *s = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&stats_lock);
+	SLIST_FOREACH(s, &stats_list, link) {
+		if (n < count)
+			stats[n] = *s;
+		if (reset) {
+			s->acquired = 0;
+			s->contended = 0;
+			s->sleeps = 0;
+			s->wait_total_cnt = 0;
+			s->wait_max_cnt = 0;
+		}
+		n++;
+	}
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+
+	return n;
+}
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <kernel/malloc_prof.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/ts_manager.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * Live buffers and allocation sites are kept in open addressing hash
+ * tables with linear probing. Sites are never removed, buffers are
+ * removed with backward shift deletion so no tombstones are needed.
+ */
+
+#define NUM_BLOCKS	CFG_CORE_MALLOC_PROFILE_BLOCKS
+#define NUM_SITES	CFG_CORE_MALLOC_PROFILE_SITES
+#define NO_IDX		UINT16_MAX
+
+#if !IS_POWER_OF_TWO(NUM_BLOCKS) || !IS_POWER_OF_TWO(NUM_SITES) || \
+	NUM_SITES >= NO_IDX
+#error Invalid CFG_CORE_MALLOC_PROFILE_BLOCKS or _SITES
+#endif
+
+struct prof_block {
+	vaddr_t ptr;
+	uint32_t size;
+	uint16_t site_idx;
+	uint16_t ta_idx;
+};
+
+static struct prof_block blocks[NUM_BLOCKS];
+static size_t num_blocks;
+static struct malloc_prof_site sites[NUM_SITES];
+static size_t num_sites;
+static struct malloc_prof_ta tas[MALLOC_PROF_MAX_TAS];
+static size_t num_tas;
+static uint32_t untracked;
+static unsigned int prof_lock = SPINLOCK_UNLOCK;
+
+static size_t hash(vaddr_t va, size_t num)
+{
+	return (size_t)(((uint64_t)va * 0x9e3779b97f4a7c15ULL) >> 32) &
+	       (num - 1);
+}
+
+static uint16_t get_site_idx(vaddr_t site)
+{
+	size_t n = hash(site, NUM_SITES);
+
+	while (sites[n].site) {
+		if (sites[n].site == site)
+			return n;
+		n = (n + 1) & (NUM_SITES - 1);
+	}
+
+	/* Keep a free entry to terminate the lookups */
+	if (num_sites == NUM_SITES - 1)
+		return NO_IDX;
+
+	num_sites++;
+	sites[n].site = site;
+
+	return n;
+}
+
+static uint16_t get_ta_idx(void)
+{
+	struct ts_session *sess = NULL;
+	size_t n = 0;
+
+	if (thread_get_id_may_fail() < 0)
+		return NO_IDX;
+	sess = ts_get_current_session_may_fail();
+	if (!sess)
+		return NO_IDX;
+
+	for (n = 0; n < num_tas; n++)
+		if (!memcmp(&tas[n].uuid, &sess->ctx->uuid, sizeof(TEE_UUID)))
+			return n;
+
+	if (num_tas == MALLOC_PROF_MAX_TAS)
+		return NO_IDX;
+
+	tas[n].uuid = sess->ctx->uuid;
+	num_tas++;
+
+	return n;
+}
+
+static struct prof_block *find_block(vaddr_t ptr)
+{
+	size_t n = hash(ptr, NUM_BLOCKS);
+
+	while (blocks[n].ptr) {
+		if (blocks[n].ptr == ptr)
+			return blocks + n;
+		n = (n + 1) & (NUM_BLOCKS - 1);
+	}
+
+	return NULL;
+}
+
+static void remove_block(struct prof_block *b)
+{
+	size_t i = b - blocks;
+	size_t j = i;
+	size_t k = 0;
+
+	while (true) {
+		j = (j + 1) & (NUM_BLOCKS - 1);
+		if (!blocks[j].ptr)
+			break;
+		k = hash(blocks[j].ptr, NUM_BLOCKS);
+		/* Entries with their home slot in ]i, j] stay in place */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		blocks[i] = blocks[j];
+		i = j;
+	}
+
+	blocks[i].ptr = 0;
+	num_blocks--;
+}
+
+void malloc_prof_alloc(void *ptr, size_t size, vaddr_t site)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&prof_lock);
+	struct malloc_prof_site *s = NULL;
+	struct malloc_prof_ta *t = NULL;
+	struct prof_block *b = NULL;
+	size_t n = 0;
+
+	/* Keep the load factor at most 3/4 */
+	if (num_blocks >= NUM_BLOCKS / 4 * 3 || size > UINT32_MAX) {
+		untracked++;
+		goto out;
+	}
+
+	n = hash((vaddr_t)ptr, NUM_BLOCKS);
+	while (blocks[n].ptr)
+		n = (n + 1) & (NUM_BLOCKS - 1);
+	b = blocks + n;
+	num_blocks++;
+
+	b->ptr = (vaddr_t)ptr;
+	b->size = size;
+	b->site_idx = get_site_idx(site);
+	b->ta_idx = get_ta_idx();
+
+	if (b->site_idx != NO_IDX) {
+		s = sites + b->site_idx;
+		s->allocs++;
+		s->live_count++;
+		s->live_bytes += size;
+		s->peak_bytes = MAX(s->peak_bytes, s->live_bytes);
+	} else {
+		untracked++;
+	}
+
+	if (b->ta_idx != NO_IDX) {
+		t = tas + b->ta_idx;
+		t->allocs++;
+		t->live_bytes += size;
+		t->peak_bytes = MAX(t->peak_bytes, t->live_bytes);
+	}
+out:
+	cpu_spin_unlock_xrestore(&prof_lock, exceptions);
+}
+
+void malloc_prof_free(void *ptr)
+{
+	uint32_t exceptions = 0;
+	struct prof_block *b = NULL;
+
+	if (!ptr)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&prof_lock);
+	b = find_block((vaddr_t)ptr);
+	if (b) {
+		if (b->site_idx != NO_IDX) {
+			sites[b->site_idx].live_count--;
+			sites[b->site_idx].live_bytes -= b->size;
+		}
+		if (b->ta_idx != NO_IDX)
+			tas[b->ta_idx].live_bytes -= b->size;
+		remove_block(b);
+	}
+	cpu_spin_unlock_xrestore(&prof_lock, exceptions);
+}
+
+size_t malloc_prof_get_sites(struct malloc_prof_site *s, size_t count,
+			     uint32_t *untracked_count)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&prof_lock);
+	size_t ret = 0;
+	size_t n = 0;
+
+	for (n = 0; n < NUM_SITES; n++) {
+		if (!sites[n].site)
+			continue;
+		if (ret < count)
+			s[ret] = sites[n];
+		ret++;
+	}
+	*untracked_count = untracked;
+	cpu_spin_unlock_xrestore(&prof_lock, exceptions);
+
+	return ret;
+}
+
+size_t malloc_prof_get_tas(struct malloc_prof_ta *t, size_t count)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&prof_lock);
+	size_t ret = num_tas;
+
+	memcpy(t, tas, MIN(count, ret) * sizeof(*t));
+	cpu_spin_unlock_xrestore(&prof_lock, exceptions);
+
+	return ret;
+}
+
+void malloc_prof_reset(void)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&prof_lock);
+	size_t n = 0;
+
+	for (n = 0; n < NUM_SITES; n++) {
+		sites[n].allocs = 0;
+		sites[n].peak_bytes = sites[n].live_bytes;
+	}
+	for (n = 0; n < num_tas; n++) {
+		tas[n].allocs = 0;
+		tas[n].peak_bytes = tas[n].live_bytes;
+	}
+	untracked = 0;
+	cpu_spin_unlock_xrestore(&prof_lock, exceptions);
+}
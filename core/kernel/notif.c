@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <atomic.h>
+#include <kernel/interrupt.h>
+#include <kernel/notif.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <mm/core_memprot.h>
+#include <mm/mobj.h>
+#include <optee_rpc_cmd.h>
+#include <sm/optee_smc.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <util.h>
+
+TEE_Result notif_wait(uint32_t value)
+{
+	struct thread_param params =
+		THREAD_PARAM_VALUE(IN, OPTEE_RPC_WAIT_QUEUE_SLEEP, value, 0);
+
+	return thread_rpc_cmd(OPTEE_RPC_CMD_WAIT_QUEUE, 1, &params);
+}
+
+TEE_Result notif_send(uint32_t value)
+{
+	struct thread_param params =
+		THREAD_PARAM_VALUE(IN, OPTEE_RPC_WAIT_QUEUE_WAKEUP, value, 0);
+
+	if (!notif_send_async(value))
+		return TEE_SUCCESS;
+
+	return thread_rpc_cmd(OPTEE_RPC_CMD_WAIT_QUEUE, 1, &params);
+}
+
+#if defined(CFG_CORE_ASYNC_NOTIF)
+/*
+ * Bitmap of the pending values registered with OPTEE_SMC_REGISTER_NOTIF.
+ * Bits are only ever set here, normal world clears them with atomic
+ * exchanges of whole words when it handles CFG_CORE_ASYNC_NOTIF_IT.
+ */
+static struct mobj *notif_mobj;
+static uint32_t *notif_bitmap;
+static size_t notif_num_values;
+static unsigned int notif_lock = SPINLOCK_UNLOCK;
+
+static struct mobj *map_bitmap(paddr_t pa, size_t size)
+{
+	if (core_pbuf_is(CORE_MEM_NSEC_SHM, pa, size))
+		return mobj_shm_alloc(pa, size, 0);
+
+#ifdef CFG_CORE_DYN_SHM
+	/* mobj_mapped_shm_alloc() checks that the page is non-secure */
+	return mobj_mapped_shm_alloc(&pa, 1, 0, 0);
+#else
+	return NULL;
+#endif
+}
+
+uint32_t notif_register_async(paddr_t pa, size_t size)
+{
+	struct mobj *old_mobj = NULL;
+	struct mobj *mobj = NULL;
+	uint32_t *bitmap = NULL;
+	uint32_t exceptions = 0;
+
+	if (pa) {
+		/* Wait queues need one value per thread */
+		if ((pa & SMALL_PAGE_MASK) || size > SMALL_PAGE_SIZE ||
+		    size % sizeof(uint32_t) ||
+		    size * 8 < CFG_NUM_THREADS)
+			return OPTEE_SMC_RETURN_EBADADDR;
+
+		mobj = map_bitmap(pa, size);
+		if (!mobj)
+			return OPTEE_SMC_RETURN_EBADADDR;
+		bitmap = mobj_get_va(mobj, 0);
+		if (!bitmap) {
+			mobj_put(mobj);
+			return OPTEE_SMC_RETURN_EBADADDR;
+		}
+	}
+
+	exceptions = cpu_spin_lock_xsave(&notif_lock);
+	old_mobj = notif_mobj;
+	notif_mobj = mobj;
+	notif_bitmap = bitmap;
+	notif_num_values = size * 8;
+	cpu_spin_unlock_xrestore(&notif_lock, exceptions);
+
+	mobj_put(old_mobj);
+
+	return OPTEE_SMC_RETURN_OK;
+}
+
+TEE_Result notif_send_async(uint32_t value)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	uint32_t *word = NULL;
+	uint32_t old = 0;
+
+	exceptions = cpu_spin_lock_xsave(&notif_lock);
+	if (!notif_bitmap) {
+		res = TEE_ERROR_BAD_STATE;
+	} else if (value >= notif_num_values) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+	} else {
+		word = notif_bitmap + value / 32;
+		old = atomic_load_u32(word);
+		while (!atomic_cas_u32(word, &old, old | BIT(value % 32)))
+			;
+	}
+	cpu_spin_unlock_xrestore(&notif_lock, exceptions);
+
+	if (res)
+		return res;
+
+	FMSG("value %"PRIu32, value);
+	itr_raise_pi(CFG_CORE_ASYNC_NOTIF_IT);
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_CORE_ASYNC_NOTIF*/
@@ -3,11 +3,13 @@
  * Copyright (c) 2018, Linaro Limited
  */
 
+#include <arm.h>
 #include <keep.h>
 #include <kernel/panic.h>
 #include <kernel/pm.h>
 #include <mm/core_memprot.h>
 #include <string.h>
+#include <trace.h>
 #include <types_ext.h>
 
 #define PM_FLAG_SUSPENDED	BIT(0)
@@ -26,10 +28,16 @@ static void verify_cb_args(struct pm_callback_handle *pm_hdl)
 	}
 }
 
+/*
+ * Callbacks are kept sorted by ascending order, preserving the
+ * registration order within an order, so that the callbacks of an order
+ * are found in a contiguous range.
+ */
 void register_pm_cb(struct pm_callback_handle *pm_hdl)
 {
 	size_t count = pm_cb_count;
 	struct pm_callback_handle *ref;
+	size_t pos = count;
 
 	verify_cb_args(pm_hdl);
 
@@ -37,26 +45,50 @@ void register_pm_cb(struct pm_callback_handle *pm_hdl)
 	if (!ref)
 		panic();
 
-	ref[count] = *pm_hdl;
-	ref[count].flags = 0;
+	while (pos && ref[pos - 1].order > pm_hdl->order)
+		pos--;
+	memmove(ref + pos + 1, ref + pos, sizeof(*ref) * (count - pos));
+
+	ref[pos] = *pm_hdl;
+	ref[pos].flags = 0;
 
 	pm_cb_count = count + 1;
 	pm_cb_ref = ref;
 }
 
+static TEE_Result call_one_callback(enum pm_op op, uint32_t pm_hint,
+				    struct pm_callback_handle *hdl)
+{
+	uint64_t start = 0;
+	TEE_Result res;
+
+	if (TRACE_LEVEL < TRACE_FLOW)
+		return hdl->callback(op, pm_hint, hdl);
+
+	start = barrier_read_cntpct();
+	res = hdl->callback(op, pm_hint, hdl);
+	FMSG("%s %p: %"PRIu64" us", op == PM_OP_SUSPEND ? "suspend" : "resume",
+	     (void *)(vaddr_t)hdl->callback,
+	     (barrier_read_cntpct() - start) * 1000000 / read_cntfrq());
+
+	return res;
+}
+
 static TEE_Result call_callbacks(enum pm_op op, uint32_t pm_hint,
 				 enum pm_callback_order order)
 {
-	struct pm_callback_handle *hdl;
-	size_t n;
+	struct pm_callback_handle *hdl = pm_cb_ref;
+	struct pm_callback_handle *end = pm_cb_ref + pm_cb_count;
 	TEE_Result res;
 
-	for (n = 0, hdl = pm_cb_ref; n < pm_cb_count; n++, hdl++) {
-		if (hdl->order != order ||
-		    (hdl->flags & PM_FLAG_SUSPENDED) == (op == PM_OP_SUSPEND))
+	while (hdl < end && hdl->order < order)
+		hdl++;
+
+	for (; hdl < end && hdl->order == order; hdl++) {
+		if ((hdl->flags & PM_FLAG_SUSPENDED) == (op == PM_OP_SUSPEND))
 			continue;
 
-		res = hdl->callback(op, pm_hint, hdl);
+		res = call_one_callback(op, pm_hint, hdl);
 		if (res)
 			return res;
 
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/rpc_stats.h>
+#include <kernel/spinlock.h>
+#include <kernel/ts_manager.h>
+#include <string.h>
+#include <util.h>
+
+static struct rpc_stats stats_table[CFG_RPC_STATS_ENTRIES];
+static size_t stats_count;
+static unsigned int stats_lock = SPINLOCK_UNLOCK;
+
+static uint64_t cnt2us(uint64_t cnt)
+{
+	return cnt * 1000000 / read_cntfrq();
+}
+
+static unsigned int hist_bucket(uint64_t us)
+{
+	unsigned int n = 0;
+
+	if (us < 2)
+		return 0;
+
+	n = 63 - __builtin_clzll(us);
+
+	return MIN(n, RPC_STATS_HIST_BUCKETS - 1U);
+}
+
+static struct rpc_stats *find_stats(const TEE_UUID *uuid, uint32_t cmd)
+{
+	struct rpc_stats *s = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < stats_count; n++) {
+		s = stats_table + n;
+		if (s->cmd == cmd && !memcmp(&s->uuid, uuid, sizeof(*uuid)))
+			return s;
+	}
+
+	if (stats_count == ARRAY_SIZE(stats_table))
+		return NULL;
+
+	s = stats_table + stats_count;
+	stats_count++;
+	memset(s, 0, sizeof(*s));
+	s->uuid = *uuid;
+	s->cmd = cmd;
+
+	return s;
+}
+
+static uint64_t memref_bytes(size_t num_params,
+			     const struct thread_param *params)
+{
+	uint64_t bytes = 0;
+	size_t n = 0;
+
+	for (n = 0; n < num_params; n++) {
+		switch (params[n].attr) {
+		case THREAD_PARAM_ATTR_MEMREF_IN:
+		case THREAD_PARAM_ATTR_MEMREF_OUT:
+		case THREAD_PARAM_ATTR_MEMREF_INOUT:
+			bytes += params[n].u.memref.size;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return bytes;
+}
+
+void rpc_stats_end(uint64_t begin, uint32_t cmd, size_t num_params,
+		   const struct thread_param *params, uint32_t ret)
+{
+	uint64_t us = cnt2us(barrier_read_cntpct() - begin);
+	uint64_t bytes = memref_bytes(num_params, params);
+	struct ts_session *sess = ts_get_current_session_may_fail();
+	TEE_UUID uuid = { };
+	struct rpc_stats *s = NULL;
+	uint32_t exceptions = 0;
+
+	if (sess)
+		uuid = sess->ctx->uuid;
+
+	exceptions = cpu_spin_lock_xsave(&stats_lock);
+	s = find_stats(&uuid, cmd);
+	if (s) {
+		s->count++;
+		if (ret != TEE_SUCCESS)
+			s->failed++;
+		s->bytes += bytes;
+		s->total_us += us;
+		s->max_us = MAX(s->max_us, us);
+		s->hist[hist_bucket(us)]++;
+	}
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+}
+
+size_t rpc_stats_get(struct rpc_stats *stats, size_t count, bool reset)
+{
+	uint32_t exceptions = 0;
+	size_t ret = 0;
+
+	exceptions = cpu_spin_lock_xsave(&stats_lock);
+	ret = stats_count;
+	memcpy(stats, stats_table, MIN(count, ret) * sizeof(*stats));
+	if (reset)
+		stats_count = 0;
+	cpu_spin_unlock_xrestore(&stats_lock, exceptions);
+
+	return ret;
+}
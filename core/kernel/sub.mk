@@ -11,6 +11,7 @@ srcs-$(CFG_LOCKDEP) += lockdep.c
 ifneq ($(CFG_CORE_FFA),y)
 srcs-$(CFG_CORE_DYN_SHM) += msg_param.c
 endif
+srcs-y += notif.c
 srcs-y += panic.c
 srcs-y += refcount.c
 srcs-y += tee_misc.c
@@ -19,6 +20,10 @@ srcs-y += ts_manager.c
 srcs-$(CFG_CORE_SANITIZE_UNDEFINED) += ubsan.c
 srcs-y += scattered_array.c
 srcs-y += huk_subkey.c
+srcs-$(CFG_TA_INVOKE_STATS) += invoke_stats.c
+srcs-$(CFG_LOCK_STATS) += lock_stats.c
+srcs-$(CFG_RPC_STATS) += rpc_stats.c
+srcs-$(CFG_CORE_MALLOC_PROFILE) += malloc_prof.c
 srcs-$(CFG_SHOW_CONF_ON_BOOT) += show_conf.c
 srcs-y += user_mode_ctx.c
 srcs-$(CFG_CORE_TPM_EVENT_LOG) += tpm.c
@@ -6,6 +6,9 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <bench.h>
+#include <kernel/invoke_stats.h>
+#include <kernel/lock_stats.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -20,6 +23,7 @@
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
+#include <mm/slab.h>
 #include <mm/vm.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,15 +40,34 @@
 #include <util.h>
 
 /* This mutex protects the critical section in tee_ta_init_session */
-struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
+struct mutex tee_ta_mutex = MUTEX_INITIALIZER_NAMED("tee_ta");
 /* This condvar is used when waiting for a TA context to become initialized */
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Hash indexes protected by tee_ta_mutex: of the sessions of all the
+ * open_sessions lists by list and session id, and of the contexts in
+ * tee_ctxes by UUID. They keep lookups short with many sessions and TAs.
+ */
+#define SESSION_HASH_SIZE	64
+#define CTX_HASH_SIZE		32
+static SLIST_HEAD(, tee_ta_session) session_hash[SESSION_HASH_SIZE];
+static SLIST_HEAD(, tee_ta_ctx) ctx_hash[CTX_HASH_SIZE];
+
+/* Contention of the locks below, protected by tee_ta_mutex */
+static struct lock_stats ta_busy_stats = LOCK_STATS_INITIALIZER("ta_busy");
+static struct lock_stats session_lock_stats =
+	LOCK_STATS_INITIALIZER("session");
+
+SLAB_CACHE_DEFINE(ta_session_cache, struct tee_ta_session, NULL);
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
 static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
 static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
 static size_t tee_ta_single_instance_count;
+static struct lock_stats single_inst_stats =
+	LOCK_STATS_INITIALIZER("single_instance");
 #endif
 
 #ifdef CFG_CONCURRENT_SINGLE_INSTANCE_TA
@@ -65,9 +88,17 @@ static void lock_single_instance(void)
 {
 	/* Requires tee_ta_mutex to be held */
 	if (tee_ta_single_instance_thread != thread_get_id()) {
+		uint64_t wait_start = 0;
+		unsigned int sleeps = 0;
+
 		/* Wait until the single-instance lock is available. */
-		while (tee_ta_single_instance_thread != THREAD_ID_INVALID)
+		if (tee_ta_single_instance_thread != THREAD_ID_INVALID)
+			wait_start = lock_stats_wait_start(&single_inst_stats);
+		while (tee_ta_single_instance_thread != THREAD_ID_INVALID) {
 			condvar_wait(&tee_ta_cv, &tee_ta_mutex);
+			sleeps++;
+		}
+		lock_stats_acquired(&single_inst_stats, wait_start, sleeps);
 
 		tee_ta_single_instance_thread = thread_get_id();
 		assert(tee_ta_single_instance_count == 0);
@@ -115,6 +146,8 @@ static struct tee_ta_ctx *ts_to_ta_ctx(struct ts_ctx *ctx)
 
 static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 {
+	uint64_t wait_start = 0;
+	unsigned int sleeps = 0;
 	bool rc = true;
 
 	if (ctx->flags & TA_FLAG_CONCURRENT)
@@ -141,8 +174,13 @@ static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 		 * We're not holding the single-instance lock, we're free to
 		 * wait for the TA to become available.
 		 */
-		while (ctx->busy)
+		if (ctx->busy)
+			wait_start = lock_stats_wait_start(&ta_busy_stats);
+		while (ctx->busy) {
 			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+			sleeps++;
+		}
+		lock_stats_acquired(&ta_busy_stats, wait_start, sleeps);
 	}
 
 	/* Either it's already true or we should set it to true */
@@ -198,20 +236,45 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	mutex_unlock(&tee_ta_mutex);
 }
 
+static size_t session_hash_idx(uint32_t id,
+			       struct tee_ta_session_head *open_sessions)
+{
+	return ((vaddr_t)open_sessions / sizeof(*open_sessions) + id) %
+	       SESSION_HASH_SIZE;
+}
+
+static void link_session(struct tee_ta_session *s,
+			 struct tee_ta_session_head *open_sessions)
+{
+	size_t idx = session_hash_idx(s->id, open_sessions);
+
+	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	SLIST_INSERT_HEAD(session_hash + idx, s, hash_link);
+	s->open_sessions = open_sessions;
+}
+
+static void unlink_session(struct tee_ta_session *s,
+			   struct tee_ta_session_head *open_sessions)
+{
+	size_t idx = session_hash_idx(s->id, open_sessions);
+
+	assert(s->open_sessions == open_sessions);
+	TAILQ_REMOVE(open_sessions, s, link);
+	SLIST_REMOVE(session_hash + idx, s, tee_ta_session, hash_link);
+	s->open_sessions = NULL;
+}
+
 static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
+	size_t idx = session_hash_idx(id, open_sessions);
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
-		}
-	}
+	SLIST_FOREACH(s, session_hash + idx, hash_link)
+		if (s->id == id && s->open_sessions == open_sessions)
+			return s;
 
-	return found;
+	return NULL;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -231,6 +294,8 @@ struct tee_ta_session *tee_ta_find_session(uint32_t id,
 struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 			struct tee_ta_session_head *open_sessions)
 {
+	uint64_t wait_start = 0;
+	unsigned int sleeps = 0;
 	struct tee_ta_session *s;
 
 	mutex_lock(&tee_ta_mutex);
@@ -249,8 +314,13 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 
 		assert(s->lock_thread != thread_get_id());
 
-		while (s->lock_thread != THREAD_ID_INVALID && !s->unlink)
+		if (s->lock_thread != THREAD_ID_INVALID)
+			wait_start = lock_stats_wait_start(&session_lock_stats);
+		while (s->lock_thread != THREAD_ID_INVALID && !s->unlink) {
 			condvar_wait(&s->lock_cv, &tee_ta_mutex);
+			sleeps++;
+		}
+		lock_stats_acquired(&session_lock_stats, wait_start, sleeps);
 
 		if (s->unlink) {
 			dec_session_ref_count(s);
@@ -281,11 +351,36 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	while (s->ref_count != 1)
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	unlink_session(s, open_sessions);
 
 	mutex_unlock(&tee_ta_mutex);
 }
 
+#if defined(CFG_FTRACE_SUPPORT) && defined(_CFG_FTRACE_BUF_FORMAT_binary)
+/* Sends the function trace records to normal world when half full */
+static void stream_ftrace(struct tee_ta_session *s)
+{
+	struct ftrace_buf *fbuf = NULL;
+
+	if (!s->ts_sess.ctx || !s->ts_sess.ctx->ops->dump_ftrace)
+		return;
+
+	ts_push_current_session(&s->ts_sess);
+	fbuf = s->ts_sess.fbuf;
+	if (fbuf && (fbuf->rec_wrapped ||
+		     fbuf->curr_size >= fbuf->max_size / 2)) {
+		s->ts_sess.fbuf = NULL;
+		s->ts_sess.ctx->ops->dump_ftrace(s->ts_sess.ctx);
+		s->ts_sess.fbuf = fbuf;
+	}
+	ts_pop_current_session();
+}
+#else
+static void stream_ftrace(struct tee_ta_session *s __unused)
+{
+}
+#endif
+
 static void destroy_session(struct tee_ta_session *s,
 			    struct tee_ta_session_head *open_sessions)
 {
@@ -302,7 +397,7 @@ static void destroy_session(struct tee_ta_session *s,
 #if defined(CFG_TA_GPROF_SUPPORT)
 	free(s->ts_sess.sbuf);
 #endif
-	free(s);
+	slab_free(&ta_session_cache, s);
 }
 
 static void destroy_context(struct tee_ta_ctx *ctx)
@@ -368,13 +463,32 @@ static void destroy_ta_ctx_from_session(struct tee_ta_session *s)
 	ctx = ts_to_ta_ctx(ts_ctx);
 	assert(count == ctx->ref_count);
 
-	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	tee_ta_unregister_ctx(ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	destroy_context(ctx);
 	s->ts_sess.ctx = NULL;
 }
 
+static size_t ctx_hash_idx(const TEE_UUID *uuid)
+{
+	return uuid->timeLow % CTX_HASH_SIZE;
+}
+
+void tee_ta_register_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	SLIST_INSERT_HEAD(ctx_hash + ctx_hash_idx(&ctx->ts_ctx.uuid), ctx,
+			  hash_link);
+}
+
+void tee_ta_unregister_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	SLIST_REMOVE(ctx_hash + ctx_hash_idx(&ctx->ts_ctx.uuid), ctx,
+		     tee_ta_ctx, hash_link);
+}
+
 /*
  * tee_ta_context_find - Find TA in session list based on a UUID (input)
  * Returns a pointer to the session
@@ -383,7 +497,7 @@ static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 {
 	struct tee_ta_ctx *ctx;
 
-	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+	SLIST_FOREACH(ctx, ctx_hash + ctx_hash_idx(uuid), hash_link) {
 		if (memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(TEE_UUID)) == 0)
 			return ctx;
 	}
@@ -391,6 +505,63 @@ static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 	return NULL;
 }
 
+#if CFG_TA_INSTANCE_POOL_SIZE
+/*
+ * An instance of a multi-instance TA with TA_FLAG_INSTANCE_POOL is kept
+ * in tee_ctxes with a zero reference count when its last session is
+ * closed, unless CFG_TA_INSTANCE_POOL_SIZE idle instances of the same TA
+ * are kept already. Such an idle instance is handed out to the next
+ * session opened to the TA instead of loading a new instance.
+ *
+ * The functions below are called with tee_ta_mutex held.
+ */
+static bool is_idle_pooled(struct tee_ta_ctx *ctx, const TEE_UUID *uuid)
+{
+	return !ctx->ref_count && !ctx->panicked &&
+	       !(ctx->flags & TA_FLAG_SINGLE_INSTANCE) &&
+	       (ctx->flags & TA_FLAG_INSTANCE_POOL) &&
+	       is_user_ta_ctx(&ctx->ts_ctx) &&
+	       !memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(*uuid));
+}
+
+static struct tee_ta_ctx *instance_pool_get(const TEE_UUID *uuid)
+{
+	struct tee_ta_ctx *ctx = NULL;
+
+	SLIST_FOREACH(ctx, ctx_hash + ctx_hash_idx(uuid), hash_link)
+		if (is_idle_pooled(ctx, uuid))
+			return ctx;
+
+	return NULL;
+}
+
+static bool instance_pool_keep(struct tee_ta_ctx *ctx)
+{
+	struct tee_ta_ctx *c = NULL;
+	size_t n = 0;
+
+	if (!is_idle_pooled(ctx, &ctx->ts_ctx.uuid))
+		return false;
+
+	SLIST_FOREACH(c, ctx_hash + ctx_hash_idx(&ctx->ts_ctx.uuid),
+		      hash_link)
+		if (c != ctx && is_idle_pooled(c, &ctx->ts_ctx.uuid))
+			n++;
+
+	return n < CFG_TA_INSTANCE_POOL_SIZE;
+}
+#else
+static struct tee_ta_ctx *instance_pool_get(const TEE_UUID *uuid __unused)
+{
+	return NULL;
+}
+
+static bool instance_pool_keep(struct tee_ta_ctx *ctx __unused)
+{
+	return false;
+}
+#endif
+
 /* check if requester (client ID) matches session initial client */
 static TEE_Result check_client(struct tee_ta_session *s, const TEE_Identity *id)
 {
@@ -468,35 +639,18 @@ static bool check_params(struct tee_ta_session *sess,
 static void set_invoke_timeout(struct tee_ta_session *sess,
 				      uint32_t cancel_req_to)
 {
-	TEE_Time current_time;
-	TEE_Time cancel_time;
-
-	if (cancel_req_to == TEE_TIMEOUT_INFINITE)
-		goto infinite;
-
-	if (tee_time_get_sys_time(&current_time) != TEE_SUCCESS)
-		goto infinite;
-
-	if (ADD_OVERFLOW(current_time.seconds, cancel_req_to / 1000,
-			 &cancel_time.seconds))
-		goto infinite;
+	uint64_t now = 0;
 
-	cancel_time.millis = current_time.millis + cancel_req_to % 1000;
-	if (cancel_time.millis > 1000) {
-		if (ADD_OVERFLOW(current_time.seconds, 1,
-				 &cancel_time.seconds))
-			goto infinite;
+	sess->cancel_time_ns = UINT64_MAX;
 
-		cancel_time.seconds++;
-		cancel_time.millis -= 1000;
-	}
+	if (cancel_req_to == TEE_TIMEOUT_INFINITE)
+		return;
 
-	sess->cancel_time = cancel_time;
-	return;
+	if (tee_time_get_sys_time_ns(&now))
+		return;
 
-infinite:
-	sess->cancel_time.seconds = UINT32_MAX;
-	sess->cancel_time.millis = UINT32_MAX;
+	/* Can't overflow before some centuries of uptime */
+	sess->cancel_time_ns = now + cancel_req_to * TEE_TIME_NSEC_PER_MSEC;
 }
 
 /*-----------------------------------------------------------------------------
@@ -555,10 +709,11 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 		panic();
 
 	ctx->ref_count--;
-	keep_alive = (ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
-			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
+	keep_alive = ((ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
+		      (ctx->flags & TA_FLAG_SINGLE_INSTANCE)) ||
+		     (!ctx->ref_count && instance_pool_keep(ctx));
 	if (!ctx->ref_count && !keep_alive) {
-		TAILQ_REMOVE(&tee_ctxes, ctx, link);
+		tee_ta_unregister_ctx(ctx);
 		mutex_unlock(&tee_ta_mutex);
 
 		destroy_context(ctx);
@@ -592,12 +747,15 @@ static TEE_Result tee_ta_init_session_with_context(struct tee_ta_session *s,
 
 	/*
 	 * If TA isn't single instance it should be loaded as new
-	 * instance instead of doing anything with this instance.
-	 * So tell the caller that we didn't find the TA it the
-	 * caller will load a new instance.
+	 * instance instead of doing anything with this instance, unless
+	 * there's an idle instance in the pool. So tell the caller that
+	 * we didn't find the TA it the caller will load a new instance.
 	 */
-	if ((ctx->flags & TA_FLAG_SINGLE_INSTANCE) == 0)
-		return TEE_ERROR_ITEM_NOT_FOUND;
+	if ((ctx->flags & TA_FLAG_SINGLE_INSTANCE) == 0) {
+		ctx = instance_pool_get(uuid);
+		if (!ctx)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+	}
 
 	/*
 	 * The TA is single instance, if it isn't multi session we
@@ -646,7 +804,7 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 				struct tee_ta_session **sess)
 {
 	TEE_Result res;
-	struct tee_ta_session *s = calloc(1, sizeof(struct tee_ta_session));
+	struct tee_ta_session *s = slab_alloc(&ta_session_cache);
 
 	*err = TEE_ORIGIN_TEE;
 	if (!s)
@@ -665,7 +823,7 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 		goto err_mutex_unlock;
 	}
 
-	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	link_session(s, open_sessions);
 
 	/* Look for already loaded TA */
 	res = tee_ta_init_session_with_context(s, uuid);
@@ -693,10 +851,10 @@ out:
 	}
 
 	mutex_lock(&tee_ta_mutex);
-	TAILQ_REMOVE(open_sessions, s, link);
+	unlink_session(s, open_sessions);
 err_mutex_unlock:
 	mutex_unlock(&tee_ta_mutex);
-	free(s);
+	slab_free(&ta_session_cache, s);
 	return res;
 }
 
@@ -754,8 +912,15 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	s->param = NULL;
 
 	tee_ta_put_session(s);
-	if (panicked || (res != TEE_SUCCESS))
+	if (panicked || (res != TEE_SUCCESS)) {
+		/*
+		 * Don't risk handing out an instance which failed to
+		 * open its only session, possibly in TA_CreateEntryPoint().
+		 */
+		if (ctx->ref_count == 1)
+			ctx->flags &= ~TA_FLAG_INSTANCE_POOL;
 		tee_ta_close_session(s, open_sessions, KERN_IDENTITY);
+	}
 
 	/*
 	 * Origin error equal to TEE_ORIGIN_TRUSTED_APP for "regular" error,
@@ -778,6 +943,7 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 				 uint32_t cancel_req_to, uint32_t cmd,
 				 struct tee_ta_param *param)
 {
+	struct invoke_stats_sample sample = { };
 	struct tee_ta_ctx *ta_ctx = NULL;
 	struct ts_ctx *ts_ctx = NULL;
 	TEE_Result res = TEE_SUCCESS;
@@ -803,14 +969,19 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 		return TEE_ERROR_TARGET_DEAD;
 	}
 
+	invoke_stats_start(&sample);
 	tee_ta_set_busy(ta_ctx);
+	invoke_stats_busy_done(&sample);
 
 	sess->param = param;
 	set_invoke_timeout(sess, cancel_req_to);
+	bm_tracepoint(BENCH_TP_TA_ENTER);
 	res = ts_ctx->ops->enter_invoke_cmd(&sess->ts_sess, cmd);
+	bm_tracepoint(BENCH_TP_TA_EXIT);
 
 	sess->param = NULL;
 	tee_ta_clear_busy(ta_ctx);
+	invoke_stats_stop(&sample, &ts_ctx->uuid, cmd);
 
 	if (ta_ctx->panicked) {
 		destroy_ta_ctx_from_session(sess);
@@ -819,6 +990,7 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 	}
 
 	*err = sess->err_origin;
+	stream_ftrace(sess);
 
 	/* Short buffer is not an effective error case */
 	if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
@@ -840,9 +1012,10 @@ TEE_Result tee_ta_cancel_command(TEE_ErrorOrigin *err,
 	return TEE_SUCCESS;
 }
 
-bool tee_ta_session_is_cancelled(struct tee_ta_session *s, TEE_Time *curr_time)
+bool tee_ta_session_is_cancelled(struct tee_ta_session *s,
+				 const uint64_t *curr_time_ns)
 {
-	TEE_Time current_time;
+	uint64_t now = 0;
 
 	if (s->cancel_mask)
 		return false;
@@ -850,21 +1023,15 @@ bool tee_ta_session_is_cancelled(struct tee_ta_session *s, TEE_Time *curr_time)
 	if (s->cancel)
 		return true;
 
-	if (s->cancel_time.seconds == UINT32_MAX)
+	if (s->cancel_time_ns == UINT64_MAX)
 		return false;
 
-	if (curr_time != NULL)
-		current_time = *curr_time;
-	else if (tee_time_get_sys_time(&current_time) != TEE_SUCCESS)
+	if (curr_time_ns)
+		now = *curr_time_ns;
+	else if (tee_time_get_sys_time_ns(&now))
 		return false;
 
-	if (current_time.seconds > s->cancel_time.seconds ||
-	    (current_time.seconds == s->cancel_time.seconds &&
-	     current_time.millis >= s->cancel_time.millis)) {
-		return true;
-	}
-
-	return false;
+	return now >= s->cancel_time_ns;
 }
 
 #if defined(CFG_TA_GPROF_SUPPORT)
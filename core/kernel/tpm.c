@@ -78,7 +78,7 @@ static void get_tpm_phys_params(void *fdt __maybe_unused,
 		return;
 	}
 
-	node = fdt_node_offset_by_compatible(fdt, -1, dt_tpm_match_table);
+	node = dt_node_offset_by_compatible(fdt, -1, dt_tpm_match_table);
 
 	if (node < 0) {
 		EMSG("TPM: Fail to find TPM node %i", node);
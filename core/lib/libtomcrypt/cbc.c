@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
@@ -22,6 +22,8 @@ struct ltc_cbc_ctx {
 	symmetric_CBC state;
 };
 
+SLAB_CACHE_DEFINE(ltc_cbc_ctx_cache, struct ltc_cbc_ctx, NULL);
+
 static const struct crypto_cipher_ops ltc_cbc_ops;
 
 static struct ltc_cbc_ctx *to_cbc_ctx(struct crypto_cipher_ctx *ctx)
@@ -78,7 +80,7 @@ static void ltc_cbc_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_cbc_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_cbc_ctx(ctx));
+	slab_free(&ltc_cbc_ctx_cache, to_cbc_ctx(ctx));
 }
 
 static void ltc_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -108,7 +110,7 @@ static TEE_Result ltc_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&ltc_cbc_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
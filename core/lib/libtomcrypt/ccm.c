@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
@@ -22,11 +22,13 @@ struct tee_ccm_state {
 	size_t tag_len;			/* tag length */
 };
 
+SLAB_CACHE_DEFINE(tee_ccm_state_cache, struct tee_ccm_state, NULL);
+
 static const struct crypto_authenc_ops aes_ccm_ops;
 
 TEE_Result crypto_aes_ccm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 {
-	struct tee_ccm_state *ctx = calloc(1, sizeof(*ctx));
+	struct tee_ccm_state *ctx = slab_alloc(&tee_ccm_state_cache);
 
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -45,7 +47,7 @@ static struct tee_ccm_state *to_tee_ccm_state(struct crypto_authenc_ctx *aectx)
 
 static void crypto_aes_ccm_free_ctx(struct crypto_authenc_ctx *aectx)
 {
-	free(to_tee_ccm_state(aectx));
+	slab_free(&tee_ccm_state_cache, to_tee_ccm_state(aectx));
 }
 
 static void crypto_aes_ccm_copy_state(struct crypto_authenc_ctx *dst_aectx,
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <mm/slab.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <tomcrypt_private.h>
+#include <util.h>
+
+/*
+ * RFC 8439: 256-bit key, 96-bit nonce and 128-bit tag. The 128-bit key
+ * variant of ChaCha20 is only used by the secure storage, see
+ * CFG_REE_FS_HTREE_CHACHA20_POLY1305.
+ */
+#define TEE_CHACHAPOLY_KEY_LENGTH	32
+#define TEE_CHACHAPOLY_KEY128_LENGTH	16
+#define TEE_CHACHAPOLY_NONCE_LENGTH	12
+#define TEE_CHACHAPOLY_TAG_LENGTH	16
+
+struct tee_chachapoly_state {
+	struct crypto_authenc_ctx aectx;
+	chacha20poly1305_state ctx;	/* the state as defined by LTC */
+};
+
+SLAB_CACHE_DEFINE(tee_chachapoly_state_cache, struct tee_chachapoly_state, NULL);
+
+static const struct crypto_authenc_ops chachapoly_ops;
+
+TEE_Result crypto_chacha20_poly1305_alloc_ctx(struct crypto_authenc_ctx **ctx)
+{
+	struct tee_chachapoly_state *c = slab_alloc(&tee_chachapoly_state_cache);
+
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	c->aectx.ops = &chachapoly_ops;
+
+	*ctx = &c->aectx;
+	return TEE_SUCCESS;
+}
+
+static struct tee_chachapoly_state *
+to_tee_chachapoly_state(struct crypto_authenc_ctx *aectx)
+{
+	assert(aectx && aectx->ops == &chachapoly_ops);
+
+	return container_of(aectx, struct tee_chachapoly_state, aectx);
+}
+
+static void chachapoly_free_ctx(struct crypto_authenc_ctx *aectx)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+
+	memzero_explicit(&c->ctx, sizeof(c->ctx));
+	slab_free(&tee_chachapoly_state_cache, c);
+}
+
+static void chachapoly_copy_state(struct crypto_authenc_ctx *dst_aectx,
+				  struct crypto_authenc_ctx *src_aectx)
+{
+	struct tee_chachapoly_state *dst = to_tee_chachapoly_state(dst_aectx);
+	struct tee_chachapoly_state *src = to_tee_chachapoly_state(src_aectx);
+
+	dst->ctx = src->ctx;
+}
+
+static TEE_Result chachapoly_init(struct crypto_authenc_ctx *aectx,
+				  TEE_OperationMode mode __unused,
+				  const uint8_t *key, size_t key_len,
+				  const uint8_t *nonce, size_t nonce_len,
+				  size_t tag_len, size_t aad_len __unused,
+				  size_t payload_len __unused)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+
+	if (!key || (key_len != TEE_CHACHAPOLY_KEY_LENGTH &&
+		     key_len != TEE_CHACHAPOLY_KEY128_LENGTH))
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!nonce || nonce_len != TEE_CHACHAPOLY_NONCE_LENGTH)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (tag_len != TEE_CHACHAPOLY_TAG_LENGTH)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	/* reset the state */
+	memset(&c->ctx, 0, sizeof(c->ctx));
+
+	if (chacha20poly1305_init(&c->ctx, key, key_len) != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+	if (chacha20poly1305_setiv(&c->ctx, nonce, nonce_len) != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result chachapoly_update_aad(struct crypto_authenc_ctx *aectx,
+					const uint8_t *data, size_t len)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+
+	/* Fails if the payload has already been started */
+	if (chacha20poly1305_add_aad(&c->ctx, data, len) != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result chachapoly_update_payload(struct crypto_authenc_ctx *aectx,
+					    TEE_OperationMode mode,
+					    const uint8_t *src_data,
+					    size_t len, uint8_t *dst_data)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+	int ltc_res = 0;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		ltc_res = chacha20poly1305_encrypt(&c->ctx, src_data, len,
+						   dst_data);
+	else
+		ltc_res = chacha20poly1305_decrypt(&c->ctx, src_data, len,
+						   dst_data);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result chachapoly_enc_final(struct crypto_authenc_ctx *aectx,
+				       const uint8_t *src_data, size_t len,
+				       uint8_t *dst_data, uint8_t *dst_tag,
+				       size_t *dst_tag_len)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+	unsigned long ltc_tag_len = TEE_CHACHAPOLY_TAG_LENGTH;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (*dst_tag_len < TEE_CHACHAPOLY_TAG_LENGTH) {
+		*dst_tag_len = TEE_CHACHAPOLY_TAG_LENGTH;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	res = chachapoly_update_payload(aectx, TEE_MODE_ENCRYPT, src_data, len,
+					dst_data);
+	if (res)
+		return res;
+
+	if (chacha20poly1305_done(&c->ctx, dst_tag, &ltc_tag_len) != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+	*dst_tag_len = ltc_tag_len;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result chachapoly_dec_final(struct crypto_authenc_ctx *aectx,
+				       const uint8_t *src_data, size_t len,
+				       uint8_t *dst_data, const uint8_t *tag,
+				       size_t tag_len)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+	uint8_t dst_tag[TEE_CHACHAPOLY_TAG_LENGTH] = { 0 };
+	unsigned long ltc_tag_len = sizeof(dst_tag);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (tag_len != TEE_CHACHAPOLY_TAG_LENGTH)
+		return TEE_ERROR_MAC_INVALID;
+
+	res = chachapoly_update_payload(aectx, TEE_MODE_DECRYPT, src_data, len,
+					dst_data);
+	if (res)
+		return res;
+
+	if (chacha20poly1305_done(&c->ctx, dst_tag, &ltc_tag_len) != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	if (consttime_memcmp(dst_tag, tag, tag_len))
+		return TEE_ERROR_MAC_INVALID;
+
+	return TEE_SUCCESS;
+}
+
+static void chachapoly_final(struct crypto_authenc_ctx *aectx)
+{
+	struct tee_chachapoly_state *c = to_tee_chachapoly_state(aectx);
+
+	memzero_explicit(&c->ctx, sizeof(c->ctx));
+}
+
+static const struct crypto_authenc_ops chachapoly_ops = {
+	.init = chachapoly_init,
+	.update_aad = chachapoly_update_aad,
+	.update_payload = chachapoly_update_payload,
+	.enc_final = chachapoly_enc_final,
+	.dec_final = chachapoly_dec_final,
+	.final = chachapoly_final,
+	.free_ctx = chachapoly_free_ctx,
+	.copy_state = chachapoly_copy_state,
+};
@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
@@ -19,6 +19,8 @@ struct ltc_omac_ctx {
 	omac_state state;
 };
 
+SLAB_CACHE_DEFINE(ltc_omac_ctx_cache, struct ltc_omac_ctx, NULL);
+
 static const struct crypto_mac_ops ltc_omac_ops;
 
 static struct ltc_omac_ctx *to_omac_ctx(struct crypto_mac_ctx *ctx)
@@ -61,7 +63,7 @@ static TEE_Result ltc_omac_final(struct crypto_mac_ctx *ctx, uint8_t *digest,
 
 static void ltc_omac_free_ctx(struct crypto_mac_ctx *ctx)
 {
-	free(to_omac_ctx(ctx));
+	slab_free(&ltc_omac_ctx_cache, to_omac_ctx(ctx));
 }
 
 static void ltc_omac_copy_state(struct crypto_mac_ctx *dst_ctx,
@@ -90,7 +92,7 @@ TEE_Result crypto_aes_cmac_alloc_ctx(struct crypto_mac_ctx **ctx_ret)
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	ctx = calloc(1, sizeof(*ctx));
+	ctx = slab_alloc(&ltc_omac_ctx_cache);
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
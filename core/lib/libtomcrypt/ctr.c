@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
@@ -19,6 +19,8 @@ struct ltc_ctr_ctx {
 	symmetric_CTR state;
 };
 
+SLAB_CACHE_DEFINE(ltc_ctr_ctx_cache, struct ltc_ctr_ctx, NULL);
+
 static const struct crypto_cipher_ops ltc_ctr_ops;
 
 static struct ltc_ctr_ctx *to_ctr_ctx(struct crypto_cipher_ctx *ctx)
@@ -71,7 +73,7 @@ static void ltc_ctr_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_ctr_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_ctr_ctx(ctx));
+	slab_free(&ltc_ctr_ctx_cache, to_ctr_ctx(ctx));
 }
 
 static void ltc_ctr_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -101,7 +103,7 @@ TEE_Result crypto_aes_ctr_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&ltc_ctr_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
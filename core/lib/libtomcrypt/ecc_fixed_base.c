@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <mbedtls/bignum.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+#include <tomcrypt_private.h>
+#include <util.h>
+
+/*
+ * Fixed-base comb multiplication of the generator of a curve, used when
+ * generating ECC keys and thus also for the ephemeral key of each ECDSA
+ * signature.
+ *
+ * The scalar is split into FB_TEETH rows of comb->cols bits each, column
+ * c of the rows selects one of the sums of 2^(j * cols) * G, j being
+ * the rows with a set bit. The multiplication then only needs cols
+ * point doublings and additions instead of one doubling and one
+ * addition per scalar bit.
+ *
+ * Each column does the same point operations regardless of the bits of
+ * the scalar. Table entries are selected by scanning the entire table
+ * with constant-time conditional assignments and the result of adding
+ * an all zero column is discarded the same way.
+ *
+ * The tables are built the first time the generator of a curve is used
+ * and are kept for the lifetime of the TEE.
+ */
+
+#define FB_TEETH	4
+#define FB_NUM_ENTRIES	BIT(FB_TEETH)
+/* Large enough for the scalar of the largest supported curve */
+#define FB_MAX_SCALAR_BYTES	((LTC_MAX_ECC + 7) / 8)
+
+struct fb_comb {
+	mbedtls_mpi prime;
+	mbedtls_mpi gx;
+	mbedtls_mpi gy;
+	unsigned int cols;
+	/* Entry 0 would be the point at infinity and is never used */
+	mbedtls_mpi coord[FB_NUM_ENTRIES][3];
+	ecc_point lut[FB_NUM_ENTRIES];
+	SLIST_ENTRY(fb_comb) link;
+};
+
+static SLIST_HEAD(, fb_comb) fb_combs = SLIST_HEAD_INITIALIZER(fb_combs);
+static struct mutex fb_mutex = MUTEX_INITIALIZER;
+
+static unsigned char ct_eq(unsigned int a, unsigned int b)
+{
+	return ((a ^ b) - 1) >> (sizeof(unsigned int) * 8 - 1);
+}
+
+static int cond_assign_point(ecc_point *dst, const ecc_point *src,
+			     unsigned char assign)
+{
+	if (mbedtls_mpi_safe_cond_assign(dst->x, src->x, assign) ||
+	    mbedtls_mpi_safe_cond_assign(dst->y, src->y, assign) ||
+	    mbedtls_mpi_safe_cond_assign(dst->z, src->z, assign))
+		return CRYPT_MEM;
+	return CRYPT_OK;
+}
+
+static void free_comb(struct fb_comb *comb)
+{
+	size_t n = 0;
+
+	mbedtls_mpi_free(&comb->prime);
+	mbedtls_mpi_free(&comb->gx);
+	mbedtls_mpi_free(&comb->gy);
+	for (n = 0; n < FB_NUM_ENTRIES; n++) {
+		mbedtls_mpi_free(&comb->coord[n][0]);
+		mbedtls_mpi_free(&comb->coord[n][1]);
+		mbedtls_mpi_free(&comb->coord[n][2]);
+	}
+	free(comb);
+}
+
+static struct fb_comb *alloc_comb(void)
+{
+	struct fb_comb *comb = calloc(1, sizeof(*comb));
+	size_t n = 0;
+
+	if (!comb)
+		return NULL;
+
+	/* Not from the mempool since these outlive the current operation */
+	mbedtls_mpi_init(&comb->prime);
+	mbedtls_mpi_init(&comb->gx);
+	mbedtls_mpi_init(&comb->gy);
+	for (n = 0; n < FB_NUM_ENTRIES; n++) {
+		mbedtls_mpi_init(&comb->coord[n][0]);
+		mbedtls_mpi_init(&comb->coord[n][1]);
+		mbedtls_mpi_init(&comb->coord[n][2]);
+		comb->lut[n].x = &comb->coord[n][0];
+		comb->lut[n].y = &comb->coord[n][1];
+		comb->lut[n].z = &comb->coord[n][2];
+	}
+
+	return comb;
+}
+
+static int setup_montgomery(void *a, void *modulus, void **mp, void **mu,
+			    void **ma)
+{
+	void *a_plus3 = NULL;
+	int err = CRYPT_OK;
+
+	*mp = NULL;
+	*mu = NULL;
+	*ma = NULL;
+
+	if ((err = mp_montgomery_setup(modulus, mp)) != CRYPT_OK)
+		return err;
+	if ((err = mp_init_multi(mu, &a_plus3, NULL)) != CRYPT_OK)
+		return err;
+	if ((err = mp_montgomery_normalization(*mu, modulus)) != CRYPT_OK)
+		goto out;
+
+	/* For curves with a == -3 keep ma == NULL */
+	if ((err = mp_add_d(a, 3, a_plus3)) != CRYPT_OK)
+		goto out;
+	if (mp_cmp(a_plus3, modulus) != LTC_MP_EQ) {
+		if ((err = mp_init(ma)) != CRYPT_OK)
+			goto out;
+		err = mp_mulmod(a, *mu, modulus, *ma);
+	}
+out:
+	mp_clear(a_plus3);
+	return err;
+}
+
+static void release_montgomery(void *mp, void *mu, void *ma)
+{
+	if (ma)
+		mp_clear(ma);
+	if (mu)
+		mp_clear(mu);
+	if (mp)
+		mp_montgomery_free(mp);
+}
+
+/*
+ * lut[1 << j] = 2^(j * cols) * G and other entries are the sums of the
+ * entries matching their set bits, all in Montgomery Jacobian form.
+ */
+static int build_comb(struct fb_comb *comb, const ecc_point *G, void *a,
+		      void *modulus)
+{
+	ecc_point *tab[FB_NUM_ENTRIES] = { NULL };
+	void *mp = NULL;
+	void *mu = NULL;
+	void *ma = NULL;
+	unsigned int n = 0;
+	unsigned int m = 0;
+	int err = CRYPT_OK;
+
+	if ((err = setup_montgomery(a, modulus, &mp, &mu, &ma)) != CRYPT_OK)
+		goto out;
+
+	for (n = 1; n < FB_NUM_ENTRIES; n++) {
+		tab[n] = ltc_ecc_new_point();
+		if (!tab[n]) {
+			err = CRYPT_MEM;
+			goto out;
+		}
+	}
+
+	if ((err = mp_mulmod(G->x, mu, modulus, tab[1]->x)) != CRYPT_OK ||
+	    (err = mp_mulmod(G->y, mu, modulus, tab[1]->y)) != CRYPT_OK ||
+	    (err = mp_mulmod(G->z, mu, modulus, tab[1]->z)) != CRYPT_OK)
+		goto out;
+
+	for (n = 2; n < FB_NUM_ENTRIES; n <<= 1) {
+		err = ltc_mp.ecc_ptdbl(tab[n >> 1], tab[n], ma, modulus, mp);
+		for (m = 1; m < comb->cols && err == CRYPT_OK; m++)
+			err = ltc_mp.ecc_ptdbl(tab[n], tab[n], ma, modulus, mp);
+		if (err != CRYPT_OK)
+			goto out;
+	}
+
+	for (n = 3; n < FB_NUM_ENTRIES; n++) {
+		/* Powers of two are already done above */
+		if (IS_POWER_OF_TWO(n))
+			continue;
+		err = ltc_mp.ecc_ptadd(tab[n & (n - 1)], tab[n & -n], tab[n],
+				       ma, modulus, mp);
+		if (err != CRYPT_OK)
+			goto out;
+	}
+
+	for (n = 1; n < FB_NUM_ENTRIES; n++) {
+		if ((err = ltc_ecc_copy_point(tab[n], comb->lut + n)) !=
+		    CRYPT_OK)
+			goto out;
+	}
+out:
+	for (n = 1; n < FB_NUM_ENTRIES; n++)
+		ltc_ecc_del_point(tab[n]);
+	release_montgomery(mp, mu, ma);
+	return err;
+}
+
+static bool mpi_equals_hex(void *tmp, void *val, const char *hex)
+{
+	return mp_read_radix(tmp, hex, 16) == CRYPT_OK &&
+	       mp_cmp(tmp, val) == LTC_MP_EQ;
+}
+
+static struct fb_comb *create_comb(const ecc_point *G, void *a, void *modulus)
+{
+	const ltc_ecc_curve *curve = NULL;
+	struct fb_comb *comb = NULL;
+	void *tmp = NULL;
+
+	if (mp_init(&tmp) != CRYPT_OK)
+		return NULL;
+
+	/* Some curves share the field so the generator has to match too */
+	for (curve = ltc_ecc_curves; curve->prime; curve++)
+		if (mpi_equals_hex(tmp, modulus, curve->prime) &&
+		    mpi_equals_hex(tmp, G->x, curve->Gx) &&
+		    mpi_equals_hex(tmp, G->y, curve->Gy))
+			break;
+	if (!curve->prime || mp_read_radix(tmp, curve->order, 16) != CRYPT_OK)
+		goto err;
+
+	comb = alloc_comb();
+	if (!comb)
+		goto err;
+	comb->cols = ROUNDUP(mp_count_bits(tmp), FB_TEETH) / FB_TEETH;
+	if (mbedtls_mpi_copy(&comb->prime, modulus) ||
+	    mbedtls_mpi_copy(&comb->gx, G->x) ||
+	    mbedtls_mpi_copy(&comb->gy, G->y) ||
+	    build_comb(comb, G, a, modulus) != CRYPT_OK)
+		goto err;
+
+	mp_clear(tmp);
+	return comb;
+err:
+	if (comb)
+		free_comb(comb);
+	mp_clear(tmp);
+	return NULL;
+}
+
+/*
+ * Returns the comb table if @G is the generator of a known curve with the
+ * field @modulus or NULL for any other point. The tables are never freed
+ * once added so the returned pointer stays valid without holding the
+ * mutex.
+ */
+static struct fb_comb *get_comb(const ecc_point *G, void *a, void *modulus)
+{
+	struct fb_comb *comb = NULL;
+
+	if (mp_cmp_d(G->z, 1) != LTC_MP_EQ)
+		return NULL;
+
+	mutex_lock(&fb_mutex);
+	SLIST_FOREACH(comb, &fb_combs, link)
+		if (mp_cmp(&comb->prime, modulus) == LTC_MP_EQ &&
+		    mp_cmp(&comb->gx, G->x) == LTC_MP_EQ &&
+		    mp_cmp(&comb->gy, G->y) == LTC_MP_EQ)
+			break;
+	if (!comb) {
+		comb = create_comb(G, a, modulus);
+		if (comb)
+			SLIST_INSERT_HEAD(&fb_combs, comb, link);
+	}
+	mutex_unlock(&fb_mutex);
+
+	return comb;
+}
+
+static unsigned int get_bit(const uint8_t kb[FB_MAX_SCALAR_BYTES],
+			    unsigned int bit)
+{
+	return (kb[FB_MAX_SCALAR_BYTES - 1 - bit / 8] >> (bit % 8)) & 1;
+}
+
+static int comb_mulmod(struct fb_comb *comb, void *k, ecc_point *R, void *a,
+		       void *modulus, int map)
+{
+	uint8_t kb[FB_MAX_SCALAR_BYTES] = { 0 };
+	ecc_point *acc = NULL;
+	ecc_point *sel = NULL;
+	ecc_point *sum = NULL;
+	unsigned char is_inf = 1;
+	unsigned char nz = 0;
+	unsigned int col = 0;
+	unsigned int z = 0;
+	unsigned int n = 0;
+	unsigned long len = mp_unsigned_bin_size(k);
+	void *mp = NULL;
+	void *mu = NULL;
+	void *ma = NULL;
+	int err = CRYPT_OK;
+
+	if (len > sizeof(kb))
+		return CRYPT_BUFFER_OVERFLOW;
+	if ((err = mp_to_unsigned_bin(k, kb + sizeof(kb) - len)) != CRYPT_OK)
+		return err;
+
+	if ((err = setup_montgomery(a, modulus, &mp, &mu, &ma)) != CRYPT_OK)
+		goto out;
+
+	acc = ltc_ecc_new_point();
+	sel = ltc_ecc_new_point();
+	sum = ltc_ecc_new_point();
+	if (!acc || !sel || !sum) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	/*
+	 * Start from valid points, acc is replaced at the first non-zero
+	 * column. 2G can't match any table entry so the addition below
+	 * doesn't hit the doubling special case while acc is unused.
+	 */
+	if ((err = ltc_mp.ecc_ptdbl(comb->lut + 1, acc, ma, modulus,
+				    mp)) != CRYPT_OK ||
+	    (err = ltc_ecc_copy_point(comb->lut + 1, sel)) != CRYPT_OK)
+		goto out;
+
+	for (col = comb->cols; col--;) {
+		z = 0;
+		for (n = 0; n < FB_TEETH; n++)
+			z |= get_bit(kb, n * comb->cols + col) << n;
+		nz = !ct_eq(z, 0);
+
+		if (col != comb->cols - 1) {
+			err = ltc_mp.ecc_ptdbl(acc, acc, ma, modulus, mp);
+			if (err != CRYPT_OK)
+				goto out;
+		}
+
+		for (n = 1; n < FB_NUM_ENTRIES; n++) {
+			err = cond_assign_point(sel, comb->lut + n,
+						ct_eq(n, z));
+			if (err != CRYPT_OK)
+				goto out;
+		}
+
+		err = ltc_mp.ecc_ptadd(acc, sel, sum, ma, modulus, mp);
+		if (err != CRYPT_OK)
+			goto out;
+
+		if ((err = cond_assign_point(acc, sum, nz & !is_inf)) !=
+		    CRYPT_OK ||
+		    (err = cond_assign_point(acc, sel, nz & is_inf)) !=
+		    CRYPT_OK)
+			goto out;
+		is_inf &= !nz;
+	}
+
+	if (is_inf)
+		err = ltc_ecc_set_point_xyz(1, 1, 0, R);
+	else if ((err = ltc_ecc_copy_point(acc, R)) == CRYPT_OK && map)
+		err = ltc_ecc_map(R, modulus, mp);
+out:
+	ltc_ecc_del_point(acc);
+	ltc_ecc_del_point(sel);
+	ltc_ecc_del_point(sum);
+	release_montgomery(mp, mu, ma);
+	memzero_explicit(kb, sizeof(kb));
+	return err;
+}
+
+int ltc_ecc_fixed_base_mulmod(void *k, const ecc_point *G, ecc_point *R,
+			      void *a, void *modulus, int map)
+{
+	struct fb_comb *comb = NULL;
+
+	LTC_ARGCHK(k != NULL);
+	LTC_ARGCHK(G != NULL);
+	LTC_ARGCHK(R != NULL);
+	LTC_ARGCHK(modulus != NULL);
+
+	comb = get_comb(G, a, modulus);
+	if (!comb || mp_count_bits(k) > (int)(comb->cols * FB_TEETH))
+		return ltc_ecc_mulmod(k, G, R, a, modulus, map);
+
+	return comb_mulmod(comb, k, R, a, modulus, map);
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+
+#include "acipher_helpers.h"
+
+/* Ed25519 keys are 256-bit strings */
+#define ED25519_KEY_SIZE_BITS	256
+
+TEE_Result crypto_acipher_gen_ed25519_key(struct ed25519_keypair *key,
+					  size_t key_size)
+{
+	curve25519_key ltc_tmp_key = { };
+
+	if (key_size != ED25519_KEY_SIZE_BITS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (ed25519_make_key(NULL, find_prng("prng_crypto"),
+			     &ltc_tmp_key) != CRYPT_OK)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(key->priv, ltc_tmp_key.priv, sizeof(key->priv));
+	memcpy(key->pub, ltc_tmp_key.pub, sizeof(key->pub));
+	memzero_explicit(&ltc_tmp_key, sizeof(ltc_tmp_key));
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result crypto_acipher_ed25519_sign(struct ed25519_keypair *key,
+				       const uint8_t *msg, size_t msg_len,
+				       uint8_t *sig, size_t *sig_len)
+{
+	curve25519_key ltc_key = {
+		.type = PK_PRIVATE,
+		.algo = PKA_ED25519,
+	};
+	unsigned long ltc_sig_len = *sig_len;
+	TEE_Result res = TEE_SUCCESS;
+
+	memcpy(ltc_key.priv, key->priv, sizeof(ltc_key.priv));
+	memcpy(ltc_key.pub, key->pub, sizeof(ltc_key.pub));
+
+	switch (ed25519_sign(msg, msg_len, sig, &ltc_sig_len, &ltc_key)) {
+	case CRYPT_OK:
+		break;
+	case CRYPT_BUFFER_OVERFLOW:
+		res = TEE_ERROR_SHORT_BUFFER;
+		break;
+	case CRYPT_MEM:
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		break;
+	default:
+		res = TEE_ERROR_BAD_PARAMETERS;
+		break;
+	}
+	*sig_len = ltc_sig_len;
+
+	memzero_explicit(&ltc_key, sizeof(ltc_key));
+
+	return res;
+}
+
+TEE_Result crypto_acipher_ed25519_verify(struct ed25519_public_key *key,
+					 const uint8_t *msg, size_t msg_len,
+					 const uint8_t *sig, size_t sig_len)
+{
+	curve25519_key ltc_key = {
+		.type = PK_PUBLIC,
+		.algo = PKA_ED25519,
+	};
+	int ltc_stat = 0;
+	int ltc_res = 0;
+
+	memcpy(ltc_key.pub, key->pub, sizeof(ltc_key.pub));
+
+	ltc_res = ed25519_verify(msg, msg_len, sig, sig_len, &ltc_stat,
+				 &ltc_key);
+	/* Malformed signatures and public keys can't verify anything */
+	if (ltc_res == CRYPT_INVALID_ARG || ltc_res == CRYPT_ERROR)
+		return TEE_ERROR_SIGNATURE_INVALID;
+
+	return convert_ltc_verify_status(ltc_res, ltc_stat);
+}
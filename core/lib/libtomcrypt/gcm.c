@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
@@ -20,6 +20,8 @@ struct tee_gcm_state {
 	size_t tag_len;			/* tag length */
 };
 
+SLAB_CACHE_DEFINE(tee_gcm_state_cache, struct tee_gcm_state, NULL);
+
 static const struct crypto_authenc_ops aes_gcm_ops;
 
 static struct tee_gcm_state *to_tee_gcm_state(struct crypto_authenc_ctx *aectx)
@@ -31,7 +33,7 @@ static struct tee_gcm_state *to_tee_gcm_state(struct crypto_authenc_ctx *aectx)
 
 TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 {
-	struct tee_gcm_state *ctx = calloc(1, sizeof(*ctx));
+	struct tee_gcm_state *ctx = slab_alloc(&tee_gcm_state_cache);
 
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -44,7 +46,7 @@ TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 
 static void crypto_aes_gcm_free_ctx(struct crypto_authenc_ctx *aectx)
 {
-	free(to_tee_gcm_state(aectx));
+	slab_free(&tee_gcm_state_cache, to_tee_gcm_state(aectx));
 }
 
 static void crypto_aes_gcm_copy_state(struct crypto_authenc_ctx *dst_aectx,
@@ -4,9 +4,11 @@
  */
 
 #include <assert.h>
+#include <config.h>
+#include <crypto/crypto_accel.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
@@ -23,6 +25,8 @@ struct ltc_hash_ctx {
 	hash_state state;
 };
 
+SLAB_CACHE_DEFINE(ltc_hash_ctx_cache, struct ltc_hash_ctx, NULL);
+
 static const struct crypto_hash_ops ltc_hash_ops;
 
 static struct ltc_hash_ctx *to_hash_ctx(struct crypto_hash_ctx *ctx)
@@ -84,7 +88,7 @@ static TEE_Result ltc_hash_final(struct crypto_hash_ctx *ctx, uint8_t *digest,
 
 static void ltc_hash_free_ctx(struct crypto_hash_ctx *ctx)
 {
-	free(to_hash_ctx(ctx));
+	slab_free(&ltc_hash_ctx_cache, to_hash_ctx(ctx));
 }
 
 static void ltc_hash_copy_state(struct crypto_hash_ctx *dst_ctx,
@@ -113,7 +117,7 @@ static TEE_Result ltc_hash_alloc_ctx(struct crypto_hash_ctx **ctx_ret,
 	if (ltc_hash_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	ctx = calloc(1, sizeof(*ctx));
+	ctx = slab_alloc(&ltc_hash_ctx_cache);
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -174,6 +178,9 @@ TEE_Result hash_sha256_check(const uint8_t *hash, const uint8_t *data,
 	hash_state hs;
 	uint8_t digest[TEE_SHA256_HASH_SIZE];
 
+	if (IS_ENABLED(CFG_CORE_CRYPTO_SHA256_ACCEL))
+		return crypto_accel_sha256_check(hash, data, data_size);
+
 	if (sha256_init(&hs) != CRYPT_OK)
 		return TEE_ERROR_GENERIC;
 	if (sha256_process(&hs, data, data_size) != CRYPT_OK)
@@ -6,19 +6,42 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <utee_defines.h>
 #include <util.h>
 
+/*
+ * struct ltc_hmac_ctx - HMAC context
+ * @ctx:	Generic MAC context
+ * @hash_idx:	Index of the hash in the hash descriptor table
+ * @state:	State of the MAC being computed
+ * @inner:	State after the inner padded key block of @key
+ * @outer:	Hash state after the outer padded key block of @key
+ * @key:	Copy of the last key if @key_cached
+ * @key_len:	Length of @key
+ * @key_cached:	True if @key is valid, keys longer than @key aren't cached
+ *
+ * Initializing again with the same key, as done by TEE_ResetOperation()
+ * or by PBKDF2 and HKDF for each block, only restores @inner while the
+ * outer padded key block is never hashed again for the same key.
+ */
 struct ltc_hmac_ctx {
 	struct crypto_mac_ctx ctx;
 	int hash_idx;
 	hmac_state state;
+	hmac_state inner;
+	hash_state outer;
+	uint8_t key[MAXBLOCKSIZE];
+	size_t key_len;
+	bool key_cached;
 };
 
+SLAB_CACHE_DEFINE(ltc_hmac_ctx_cache, struct ltc_hmac_ctx, NULL);
+
 static const struct crypto_mac_ops ltc_hmac_ops;
 
 static struct ltc_hmac_ctx *to_hmac_ctx(struct crypto_mac_ctx *ctx)
@@ -28,15 +51,48 @@ static struct ltc_hmac_ctx *to_hmac_ctx(struct crypto_mac_ctx *ctx)
 	return container_of(ctx, struct ltc_hmac_ctx, ctx);
 }
 
+static void cache_key(struct ltc_hmac_ctx *hc, const uint8_t *key, size_t len)
+{
+	hc->key_cached = len <= sizeof(hc->key);
+	if (hc->key_cached) {
+		if (len)
+			memcpy(hc->key, key, len);
+		hc->key_len = len;
+	}
+}
+
 static TEE_Result ltc_hmac_init(struct crypto_mac_ctx *ctx, const uint8_t *key,
 				size_t len)
 {
 	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
-
-	if (hmac_init(&hc->state, hc->hash_idx, key, len) == CRYPT_OK)
+	const struct ltc_hash_descriptor *hd = hash_descriptor[hc->hash_idx];
+	uint8_t buf[MAXBLOCKSIZE] = { };
+	TEE_Result res = TEE_ERROR_BAD_STATE;
+	size_t n = 0;
+
+	if (hc->key_cached && hc->key_len == len &&
+	    !consttime_memcmp(hc->key, key, len)) {
+		hc->state = hc->inner;
 		return TEE_SUCCESS;
-	else
-		return TEE_ERROR_BAD_STATE;
+	}
+
+	hc->key_cached = false;
+
+	if (hmac_init(&hc->inner, hc->hash_idx, key, len) != CRYPT_OK)
+		goto out;
+
+	for (n = 0; n < hd->blocksize; n++)
+		buf[n] = hc->inner.key[n] ^ 0x5c;
+	if (hd->init(&hc->outer) != CRYPT_OK ||
+	    hd->process(&hc->outer, buf, hd->blocksize) != CRYPT_OK)
+		goto out;
+
+	hc->state = hc->inner;
+	cache_key(hc, key, len);
+	res = TEE_SUCCESS;
+out:
+	memzero_explicit(buf, sizeof(buf));
+	return res;
 }
 
 static TEE_Result ltc_hmac_update(struct crypto_mac_ctx *ctx,
@@ -51,17 +107,31 @@ static TEE_Result ltc_hmac_update(struct crypto_mac_ctx *ctx,
 static TEE_Result ltc_hmac_final(struct crypto_mac_ctx *ctx, uint8_t *digest,
 				 size_t len)
 {
-	unsigned long l = len;
-
-	if (hmac_done(&to_hmac_ctx(ctx)->state, digest, &l) == CRYPT_OK)
-		return TEE_SUCCESS;
-	else
-		return TEE_ERROR_BAD_STATE;
+	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
+	const struct ltc_hash_descriptor *hd = hash_descriptor[hc->hash_idx];
+	uint8_t buf[MAXBLOCKSIZE] = { };
+	TEE_Result res = TEE_ERROR_BAD_STATE;
+	hash_state md = hc->outer;
+
+	if (hd->done(&hc->state.md, buf) != CRYPT_OK ||
+	    hd->process(&md, buf, hd->hashsize) != CRYPT_OK ||
+	    hd->done(&md, buf) != CRYPT_OK)
+		goto out;
+
+	memcpy(digest, buf, MIN(len, (size_t)hd->hashsize));
+	res = TEE_SUCCESS;
+out:
+	memzero_explicit(buf, sizeof(buf));
+	memzero_explicit(&md, sizeof(md));
+	return res;
 }
 
 static void ltc_hmac_free_ctx(struct crypto_mac_ctx *ctx)
 {
-	free(to_hmac_ctx(ctx));
+	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
+
+	memzero_explicit(hc, sizeof(*hc));
+	slab_free(&ltc_hmac_ctx_cache, hc);
 }
 
 static void ltc_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
@@ -72,6 +142,11 @@ static void ltc_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
 
 	assert(src->hash_idx == dst->hash_idx);
 	dst->state = src->state;
+	dst->inner = src->inner;
+	dst->outer = src->outer;
+	memcpy(dst->key, src->key, sizeof(dst->key));
+	dst->key_len = src->key_len;
+	dst->key_cached = src->key_cached;
 }
 
 static const struct crypto_mac_ops ltc_hmac_ops = {
@@ -90,7 +165,7 @@ static TEE_Result ltc_hmac_alloc_ctx(struct crypto_mac_ctx **ctx_ret,
 	if (hash_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	ctx = calloc(1, sizeof(*ctx));
+	ctx = slab_alloc(&ltc_hmac_ctx_cache);
 	if (!ctx)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
@@ -4,6 +4,7 @@
  */
 
 #include <crypto/crypto.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <mbedtls/bignum.h>
 #include <mempool.h>
@@ -34,11 +35,27 @@ static struct mempool *get_mp_scratch_memory_pool(void)
 	void *data;
 
 	size = ROUNDUP(MPI_MEMPOOL_SIZE, SMALL_PAGE_SIZE);
+#ifdef CFG_CORE_MEMPOOL_PER_THREAD
+	data = tee_pager_alloc(size * CFG_NUM_THREADS);
+	if (!data)
+		panic();
+
+	return mempool_alloc_thread_pool(data, size, tee_pager_release_phys);
+#else
 	data = tee_pager_alloc(size);
 	if (!data)
 		panic();
 
 	return mempool_alloc_pool(data, size, tee_pager_release_phys);
+#endif
+}
+#elif defined(CFG_CORE_MEMPOOL_PER_THREAD)
+static struct mempool *get_mp_scratch_memory_pool(void)
+{
+	static uint8_t data[MPI_MEMPOOL_SIZE * CFG_NUM_THREADS]
+		__aligned(MEMPOOL_ALIGN);
+
+	return mempool_alloc_thread_pool(data, MPI_MEMPOOL_SIZE, NULL);
 }
 #else /* _CFG_CORE_LTC_PAGER */
 static struct mempool *get_mp_scratch_memory_pool(void)
@@ -492,6 +509,120 @@ static int invmod(void *a, void *b, void *c)
 }
 
 
+#ifdef LTC_ECC_SM2
+/*
+ * The SM2 prime p = 2^256 - 2^224 - 2^96 + 2^64 - 1 lets a product be
+ * reduced with a few additions of its 32-bit words instead of a
+ * Montgomery reduction. The "Montgomery" functions below then use R = 1
+ * for this prime: the normalization value is 1 and the reduction is a
+ * plain reduction modulo p, which is all the ECC code needs.
+ */
+#define SM2_WORDS	8
+
+/* Least significant word first */
+static const uint32_t sm2_p[SM2_WORDS] = {
+	0xffffffff, 0xffffffff, 0x00000000, 0xffffffff,
+	0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe,
+};
+
+/*
+ * sm2_fold[j][i] is the multiple of 2^(32 * j) in 2^(32 * (8 + i)) mod p,
+ * column 0 being 2^256 = 2^224 + 2^96 - 2^64 + 1 mod p.
+ */
+static const int8_t sm2_fold[SM2_WORDS][SM2_WORDS] = {
+	{ 1, 1, 1, 1, 1, 2, 2, 2 },
+	{ 0, 1, 1, 1, 1, 1, 2, 2 },
+	{ -1, -1, 0, 0, 0, -1, -1, 0 },
+	{ 1, 0, 0, 1, 1, 2, 1, 1 },
+	{ 0, 1, 0, 0, 1, 1, 2, 1 },
+	{ 0, 0, 1, 0, 0, 1, 1, 2 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1 },
+	{ 1, 1, 1, 1, 2, 2, 2, 3 },
+};
+
+static uint32_t mpi_get_u32(const mbedtls_mpi *x, size_t i)
+{
+	size_t limb = i * 32 / biL;
+
+	if (limb >= x->n)
+		return 0;
+	return x->p[limb] >> (i * 32 % biL);
+}
+
+static bool is_sm2_prime(const mbedtls_mpi *n)
+{
+	size_t i = 0;
+
+	if (n->s < 0 || mbedtls_mpi_bitlen(n) != 256)
+		return false;
+	for (i = 0; i < SM2_WORDS; i++)
+		if (mpi_get_u32(n, i) != sm2_p[i])
+			return false;
+	return true;
+}
+
+static int sm2_reduce(mbedtls_mpi *a, const mbedtls_mpi *p)
+{
+	uint32_t c[2 * SM2_WORDS] = { 0 };
+	uint32_t r[SM2_WORDS] = { 0 };
+	int64_t carry = 0;
+	int64_t acc = 0;
+	int64_t f = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	/* Not the product of two reduced values */
+	if (a->s < 0 || mbedtls_mpi_bitlen(a) > 2 * SM2_WORDS * 32) {
+		if (mbedtls_mpi_mod_mpi(a, a, p))
+			return CRYPT_MEM;
+		return CRYPT_OK;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(c); i++)
+		c[i] = mpi_get_u32(a, i);
+
+	for (j = 0; j < SM2_WORDS; j++) {
+		acc = carry + c[j];
+		for (i = 0; i < SM2_WORDS; i++)
+			acc += sm2_fold[j][i] * (int64_t)c[SM2_WORDS + i];
+		r[j] = acc;
+		carry = acc >> 32;
+	}
+
+	/* Fold the small carry back until r fits in 256 bits */
+	while (carry) {
+		f = carry;
+		carry = 0;
+		for (j = 0; j < SM2_WORDS; j++) {
+			acc = carry + r[j] + sm2_fold[j][0] * f;
+			r[j] = acc;
+			carry = acc >> 32;
+		}
+	}
+
+	if (mbedtls_mpi_lset(a, 0) || mbedtls_mpi_grow(a, BITS_TO_LIMBS(256)))
+		return CRYPT_MEM;
+	for (j = 0; j < SM2_WORDS; j++)
+		a->p[j * 32 / biL] |= (mbedtls_mpi_uint)r[j] << (j * 32 % biL);
+
+	/* 2^256 < 2 * p so one subtraction is enough */
+	if (mbedtls_mpi_cmp_mpi(a, p) >= 0 && mbedtls_mpi_sub_abs(a, a, p))
+		return CRYPT_MEM;
+
+	return CRYPT_OK;
+}
+#else
+static bool is_sm2_prime(const mbedtls_mpi *n __unused)
+{
+	return false;
+}
+
+static int sm2_reduce(mbedtls_mpi *a __unused, const mbedtls_mpi *p __unused)
+{
+	return CRYPT_ERROR;
+}
+#endif
+
 /* setup */
 static int montgomery_setup(void *a, void **b)
 {
@@ -499,7 +630,11 @@ static int montgomery_setup(void *a, void **b)
 	if (!*b)
 		return CRYPT_MEM;
 
-	mbedtls_mpi_montg_init(*b, a);
+	/* A valid Montgomery constant is odd, zero selects sm2_reduce() */
+	if (is_sm2_prime(a))
+		*(mbedtls_mpi_uint *)*b = 0;
+	else
+		mbedtls_mpi_montg_init(*b, a);
 
 	return CRYPT_OK;
 }
@@ -509,6 +644,12 @@ static int montgomery_normalization(void *a, void *b)
 {
 	size_t c = ROUNDUP(mbedtls_mpi_size(b), sizeof(mbedtls_mpi_uint)) * 8;
 
+	if (is_sm2_prime(b)) {
+		if (mbedtls_mpi_lset(a, 1))
+			return CRYPT_MEM;
+		return CRYPT_OK;
+	}
+
 	if (mbedtls_mpi_lset(a, 1))
 		return CRYPT_MEM;
 	if (mbedtls_mpi_shift_l(a, c))
@@ -528,6 +669,9 @@ static int montgomery_reduce(void *a, void *b, void *c)
 	mbedtls_mpi T;
 	int ret = CRYPT_MEM;
 
+	if (!*mm)
+		return sm2_reduce(a, N);
+
 	mbedtls_mpi_init_mempool(&T);
 	mbedtls_mpi_init_mempool(&A);
 
@@ -565,6 +709,154 @@ static void montgomery_deinit(void *a)
 	free(a);
 }
 
+#ifdef _CFG_CORE_LTC_MONT_CACHE
+/*
+ * Cache of the Montgomery constant R^2 mod N used by mbedtls_mpi_exp_mod().
+ *
+ * Entries are owned by a bignum allocated with crypto_bignum_allocate(),
+ * that is an attribute of a key object such as the modulus or one of the
+ * CRT primes of an RSA key. They are dropped and wiped when the bignum is
+ * freed, cleared or assigned through the crypto_bignum_*() functions. A
+ * copy of the modulus is kept in each entry so that an entry is never used
+ * if the value of the bignum was updated by some other means.
+ */
+#define MONT_CACHE_SIZE		8
+
+struct mont_cache_entry {
+	const mbedtls_mpi *owner;
+	mbedtls_mpi n;
+	mbedtls_mpi rr;
+	unsigned int stamp;
+};
+
+static struct mont_cache_entry mont_cache[MONT_CACHE_SIZE];
+static unsigned int mont_cache_stamp;
+static struct mutex mont_cache_mu = MUTEX_INITIALIZER;
+
+static void mont_cache_entry_free(struct mont_cache_entry *e)
+{
+	e->owner = NULL;
+	mbedtls_mpi_free(&e->n);
+	mbedtls_mpi_free(&e->rr);
+}
+
+/* Called with mont_cache_mu held */
+static struct mont_cache_entry *mont_cache_find(const mbedtls_mpi *n)
+{
+	unsigned int lt1 = 0;
+	unsigned int lt2 = 0;
+	size_t i = 0;
+
+	for (i = 0; i < MONT_CACHE_SIZE; i++) {
+		struct mont_cache_entry *e = mont_cache + i;
+
+		if (e->owner != n)
+			continue;
+		/* The modulus may be a secret prime, use constant time */
+		if (mbedtls_mpi_lt_mpi_ct(&e->n, n, &lt1) ||
+		    mbedtls_mpi_lt_mpi_ct(n, &e->n, &lt2) || lt1 || lt2) {
+			mont_cache_entry_free(e);
+			return NULL;
+		}
+		e->stamp = ++mont_cache_stamp;
+		return e;
+	}
+
+	return NULL;
+}
+
+static void mont_cache_drop(const mbedtls_mpi *owner)
+{
+	size_t i = 0;
+
+	mutex_lock(&mont_cache_mu);
+	for (i = 0; i < MONT_CACHE_SIZE; i++)
+		if (mont_cache[i].owner == owner)
+			mont_cache_entry_free(mont_cache + i);
+	mutex_unlock(&mont_cache_mu);
+}
+
+/*
+ * Loads R^2 mod @n into @rr, a scratch bignum, either from the cache or by
+ * computing it. A new entry is added to the cache when @n is an allocated
+ * bignum, replacing the least recently used entry.
+ */
+static int mont_cache_get(const mbedtls_mpi *n, mbedtls_mpi *rr)
+{
+	struct mont_cache_entry *e = NULL;
+	size_t i = 0;
+	int res = 0;
+
+	if (n->use_mempool || !n->n)
+		return MBEDTLS_ERR_MPI_BAD_INPUT_DATA;
+
+	mutex_lock(&mont_cache_mu);
+	e = mont_cache_find(n);
+	if (e)
+		res = mbedtls_mpi_copy(rr, &e->rr);
+	mutex_unlock(&mont_cache_mu);
+	if (e)
+		return res;
+
+	res = mbedtls_mpi_lset(rr, 1);
+	if (!res)
+		res = mbedtls_mpi_shift_l(rr, n->n * 2 * biL);
+	if (!res)
+		res = mbedtls_mpi_mod_mpi(rr, rr, n);
+	if (res)
+		return res;
+
+	mutex_lock(&mont_cache_mu);
+	if (!mont_cache_find(n)) {
+		e = mont_cache;
+		for (i = 1; i < MONT_CACHE_SIZE; i++)
+			if (mont_cache[i].stamp < e->stamp)
+				e = mont_cache + i;
+		mont_cache_entry_free(e);
+
+		mbedtls_mpi_init(&e->n);
+		mbedtls_mpi_init(&e->rr);
+		if (mbedtls_mpi_grow(&e->n, n->n) ||
+		    mbedtls_mpi_copy(&e->n, n) ||
+		    mbedtls_mpi_copy(&e->rr, rr)) {
+			mont_cache_entry_free(e);
+		} else {
+			e->owner = n;
+			e->stamp = ++mont_cache_stamp;
+		}
+	}
+	mutex_unlock(&mont_cache_mu);
+
+	return 0;
+}
+
+static int exp_mod(mbedtls_mpi *d, const mbedtls_mpi *a,
+		   const mbedtls_mpi *b, const mbedtls_mpi *c)
+{
+	mbedtls_mpi rr;
+	int res = 0;
+
+	mbedtls_mpi_init_mempool(&rr);
+	if (mont_cache_get(c, &rr))
+		res = mbedtls_mpi_exp_mod(d, a, b, c, NULL);
+	else
+		res = mbedtls_mpi_exp_mod(d, a, b, c, &rr);
+	mbedtls_mpi_free(&rr);
+
+	return res;
+}
+#else
+static void mont_cache_drop(const mbedtls_mpi *owner __unused)
+{
+}
+
+static int exp_mod(mbedtls_mpi *d, const mbedtls_mpi *a,
+		   const mbedtls_mpi *b, const mbedtls_mpi *c)
+{
+	return mbedtls_mpi_exp_mod(d, a, b, c, NULL);
+}
+#endif /*_CFG_CORE_LTC_MONT_CACHE*/
+
 /*
  * This function calculates:
  *  d = a^b mod c
@@ -582,12 +874,12 @@ static int exptmod(void *a, void *b, void *c, void *d)
 		mbedtls_mpi dest;
 
 		mbedtls_mpi_init_mempool(&dest);
-		res = mbedtls_mpi_exp_mod(&dest, a, b, c, NULL);
+		res = exp_mod(&dest, a, b, c);
 		if (!res)
 			res = mbedtls_mpi_copy(d, &dest);
 		mbedtls_mpi_free(&dest);
 	} else {
-		res = mbedtls_mpi_exp_mod(d, a, b, c, NULL);
+		res = exp_mod(d, a, b, c);
 	}
 
 	if (res)
@@ -682,6 +974,8 @@ ltc_math_descriptor ltc_mp = {
 #ifdef LTC_MECC
 #ifdef LTC_MECC_FP
 	.ecc_ptmul = &ltc_ecc_fp_mulmod,
+#elif defined(_CFG_CORE_LTC_ECC_FIXED_BASE)
+	.ecc_ptmul = &ltc_ecc_fixed_base_mulmod,
 #else
 	.ecc_ptmul = &ltc_ecc_mulmod,
 #endif /* LTC_MECC_FP */
@@ -731,6 +1025,7 @@ void crypto_bignum_bn2bin(const struct bignum *from, uint8_t *to)
 TEE_Result crypto_bignum_bin2bn(const uint8_t *from, size_t fromsize,
 			 struct bignum *to)
 {
+	mont_cache_drop((mbedtls_mpi *)to);
 	if (mbedtls_mpi_read_binary((mbedtls_mpi *)to, (const void *)from,
 				    fromsize))
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -739,6 +1034,7 @@ TEE_Result crypto_bignum_bin2bn(const uint8_t *from, size_t fromsize,
 
 void crypto_bignum_copy(struct bignum *to, const struct bignum *from)
 {
+	mont_cache_drop((mbedtls_mpi *)to);
 	mbedtls_mpi_copy((mbedtls_mpi *)to, (const mbedtls_mpi *)from);
 }
 
@@ -760,6 +1056,7 @@ struct bignum *crypto_bignum_allocate(size_t size_bits)
 
 void crypto_bignum_free(struct bignum *s)
 {
+	mont_cache_drop((mbedtls_mpi *)s);
 	mbedtls_mpi_free((mbedtls_mpi *)s);
 	free(s);
 }
@@ -768,6 +1065,7 @@ void crypto_bignum_clear(struct bignum *s)
 {
 	mbedtls_mpi *bn = (mbedtls_mpi *)s;
 
+	mont_cache_drop(bn);
 	bn->s = 1;
 	if (bn->p)
 		memset(bn->p, 0, sizeof(*bn->p) * bn->n);
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/* LibTomCrypt, modular cryptographic library -- Tom St Denis
+ *
+ * LibTomCrypt is a library that provides various cryptographic
+ * algorithms in a highly modular and flexible manner.
+ *
+ * The library is free for all purposes without any express
+ * guarantee it works.
+ */
+
+#include <crypto/crypto_accel.h>
+#include <tomcrypt_private.h>
+
+#ifdef LTC_OMAC
+
+/*
+ * Runs all the whole blocks of the input but the last one through the
+ * accelerated CBC-MAC, the last block must stay in omac->block since
+ * omac_done() has to xor it with one of the subkeys.
+ */
+static unsigned long _omac_accel_blocks(omac_state *omac,
+                                        const unsigned char *in,
+                                        unsigned long inlen)
+{
+   unsigned long nblocks = 0;
+
+   if (cipher_descriptor[omac->cipher_idx] != &aes_desc ||
+       omac->buflen != 0 || inlen <= (unsigned long)omac->blklen) {
+      return 0;
+   }
+
+   nblocks = (inlen - 1) / omac->blklen;
+   crypto_accel_aes_cbc_mac(omac->prev, in, omac->key.rijndael.eK,
+                            omac->key.rijndael.Nr, nblocks);
+
+   return nblocks * omac->blklen;
+}
+
+/**
+   Process data through OMAC
+   @param omac     The OMAC state
+   @param in       The input data to send through OMAC
+   @param inlen    The length of the input (octets)
+   @return CRYPT_OK if successful
+*/
+int omac_process(omac_state *omac, const unsigned char *in, unsigned long inlen)
+{
+   unsigned long n, x;
+   int           err;
+
+   LTC_ARGCHK(omac  != NULL);
+   LTC_ARGCHK(in    != NULL);
+   if ((err = cipher_is_valid(omac->cipher_idx)) != CRYPT_OK) {
+      return err;
+   }
+
+   if ((omac->buflen > (int)sizeof(omac->block)) || (omac->buflen < 0) ||
+       (omac->blklen > (int)sizeof(omac->block)) || (omac->buflen > omac->blklen)) {
+      return CRYPT_INVALID_ARG;
+   }
+
+   /* complete a pending block if more data follows it */
+   if (omac->buflen > 0 &&
+       inlen > (unsigned long)(omac->blklen - omac->buflen)) {
+      n = omac->blklen - omac->buflen;
+      XMEMCPY(omac->block + omac->buflen, in, n);
+      inlen -= n;
+      in    += n;
+      for (x = 0; x < (unsigned long)omac->blklen; x++) {
+          omac->block[x] ^= omac->prev[x];
+      }
+      if ((err = cipher_descriptor[omac->cipher_idx]->ecb_encrypt(omac->block, omac->prev, &omac->key)) != CRYPT_OK) {
+         return err;
+      }
+      omac->buflen = 0;
+   }
+
+   n = _omac_accel_blocks(omac, in, inlen);
+   inlen -= n;
+   in    += n;
+
+   while (inlen != 0) {
+       /* ok if the block is full we xor in prev, encrypt and replace prev */
+       if (omac->buflen == omac->blklen) {
+          for (x = 0; x < (unsigned long)omac->blklen; x++) {
+              omac->block[x] ^= omac->prev[x];
+          }
+          if ((err = cipher_descriptor[omac->cipher_idx]->ecb_encrypt(omac->block, omac->prev, &omac->key)) != CRYPT_OK) {
+             return err;
+          }
+          omac->buflen = 0;
+       }
+
+       /* add bytes */
+       n = MIN(inlen, (unsigned long)(omac->blklen - omac->buflen));
+       XMEMCPY(omac->block + omac->buflen, in, n);
+       omac->buflen  += n;
+       inlen         -= n;
+       in            += n;
+   }
+
+   return CRYPT_OK;
+}
+
+#endif
@@ -370,8 +370,8 @@ TEE_Result sm2_ltc_pke_encrypt(struct ecc_public_key *key, const uint8_t *src,
 		goto out;
 	}
 
-	ltc_res = ltc_ecc_mulmod(k, &ltc_key.dp.base, C1, ltc_key.dp.A,
-				 ltc_key.dp.prime, 1);
+	ltc_res = ltc_mp.ecc_ptmul(k, &ltc_key.dp.base, C1, ltc_key.dp.A,
+				   ltc_key.dp.prime, 1);
 	if (ltc_res != CRYPT_OK) {
 		res = TEE_ERROR_BAD_STATE;
 		goto out;
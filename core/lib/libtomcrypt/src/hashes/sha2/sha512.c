@@ -8,6 +8,9 @@
  * guarantee it works.
  */
 #include "tomcrypt_private.h"
+#ifdef CFG_CORE_CRYPTO_SHA512_ACCEL
+#include <crypto/crypto_accel.h>
+#endif
 
 /**
    @param sha512.c
@@ -166,6 +169,30 @@ static int sha512_compress(hash_state * md, const unsigned char *buf)
 }
 #endif
 
+#ifdef CFG_CORE_CRYPTO_SHA512_ACCEL
+/* compress n 1024-bit blocks, using the CPU instructions when present */
+static int sha512_compress_nblocks(hash_state *md, const unsigned char *buf,
+                                   int blocks)
+{
+    void *state = md->sha512.state;
+    int err = CRYPT_OK;
+    int i;
+
+    COMPILE_TIME_ASSERT(sizeof(md->sha512.state[0]) == sizeof(uint64_t));
+
+    if (crypto_accel_sha512_compress(state, buf, blocks) == TEE_SUCCESS)
+        return CRYPT_OK;
+
+    for (i = 0; i < blocks && err == CRYPT_OK; i++)
+        err = sha512_compress(md, buf + 128 * i);
+    return err;
+}
+
+#define sha512_compress_one(md, buf)  sha512_compress_nblocks(md, buf, 1)
+#else
+#define sha512_compress_one(md, buf)  sha512_compress(md, buf)
+#endif
+
 /**
    Initialize the hash state
    @param md   The hash state you wish to initialize
@@ -194,7 +221,11 @@ int sha512_init(hash_state * md)
    @param inlen  The length of the data (octets)
    @return CRYPT_OK if successful
 */
+#ifdef CFG_CORE_CRYPTO_SHA512_ACCEL
+HASH_PROCESS_NBLOCKS(sha512_process, sha512_compress_nblocks, sha512, 128)
+#else
 HASH_PROCESS(sha512_process, sha512_compress, sha512, 128)
+#endif
 
 /**
    Terminate the hash to get the digest
@@ -227,7 +258,7 @@ int sha512_done(hash_state * md, unsigned char *out)
         while (md->sha512.curlen < 128) {
             md->sha512.buf[md->sha512.curlen++] = (unsigned char)0;
         }
-        sha512_compress(md, md->sha512.buf);
+        sha512_compress_one(md, md->sha512.buf);
         md->sha512.curlen = 0;
     }
 
@@ -241,7 +272,7 @@ int sha512_done(hash_state * md, unsigned char *out)
 
     /* store length */
     STORE64H(md->sha512.length, md->sha512.buf+120);
-    sha512_compress(md, md->sha512.buf);
+    sha512_compress_one(md, md->sha512.buf);
 
     /* copy output */
     for (i = 0; i < 8; i++) {
@@ -293,6 +293,12 @@ void ltc_ecc_fp_tablelock(int lock);
 /* R = kG */
 int ltc_ecc_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a, void *modulus, int map);
 
+#ifdef _CFG_CORE_LTC_ECC_FIXED_BASE
+/* R = kG, using a cached comb table if G is the generator of a known curve */
+int ltc_ecc_fixed_base_mulmod(void *k, const ecc_point *G, ecc_point *R,
+			      void *a, void *modulus, int map);
+#endif
+
 #ifdef LTC_ECC_SHAMIR
 /* kA*A + kB*B = C */
 int ltc_ecc_mul2add(const ecc_point *A, void *kA,
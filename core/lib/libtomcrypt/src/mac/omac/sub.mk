@@ -4,4 +4,6 @@ srcs-y += omac_done.c
 srcs-y += omac_init.c
 srcs-y += omac_memory.c
 srcs-y += omac_memory_multi.c
+ifneq ($(_CFG_CORE_LTC_AES_ACCEL),y)
 srcs-y += omac_process.c
+endif
@@ -0,0 +1 @@
+srcs-y += poly1305.c
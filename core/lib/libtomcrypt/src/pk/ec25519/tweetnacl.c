@@ -18,32 +18,175 @@ typedef unsigned char u8;
 typedef ulong32 u32;
 typedef ulong64 u64;
 typedef long64 i64;
-typedef i64 gf[16];
+#if defined(__SIZEOF_INT128__)
+/*
+ * Field elements are stored in radix 2^51, the products of limbs being
+ * accumulated in 128 bits. The functions below are derived from
+ * curve25519-donna-c64 (public domain) and replace the 16 limbs of
+ * radix 2^16 of TweetNaCl which need 256 multiplications per product.
+ *
+ * Limbs are below 2^51 once carried, the results of A() and Z() are
+ * below 2^54 which is the maximum input of M() and S().
+ */
+typedef unsigned __int128 u128;
+typedef u64 gf[5];
+
+#define GF_MASK51 0x7ffffffffffffULL
 
 static const u8
   _9[32] = {9};
 static const gf
   gf0,
   gf1 = {1},
-  _121665 = {0xDB41,1},
-  D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070, 0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203},
-  D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0, 0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406},
-  X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
-  Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
-  I = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+  _121665 = {0x1DB41},
+  D = {0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff},
+  D2 = {0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff},
+  X = {0x62d608f25d51a, 0x412a4b4f6592a, 0x75b7171a4b31d, 0x1ff60527118fe, 0x216936d3cd6e5},
+  Y = {0x6666666666658, 0x4cccccccccccc, 0x1999999999999, 0x3333333333333, 0x6666666666666},
+  I = {0x61b274a0ea0b0, 0x0d5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d};
 
-static int vn(const u8 *x,const u8 *y,int n)
+sv set25519(gf r, const gf a)
 {
   int i;
-  u32 d = 0;
-  FOR(i,n) d |= x[i]^y[i];
-  return (1 & ((d - 1) >> 8)) - 1;
+  FOR(i,5) r[i]=a[i];
 }
 
-static int tweetnacl_crypto_verify_32(const u8 *x,const u8 *y)
+sv car25519(gf o)
 {
-  return vn(x,y,32);
+  o[1]+=o[0]>>51; o[0]&=GF_MASK51;
+  o[2]+=o[1]>>51; o[1]&=GF_MASK51;
+  o[3]+=o[2]>>51; o[2]&=GF_MASK51;
+  o[4]+=o[3]>>51; o[3]&=GF_MASK51;
+  o[0]+=19*(o[4]>>51); o[4]&=GF_MASK51;
+}
+
+sv sel25519(gf p,gf q,int b)
+{
+  u64 t,c=~((u64)b-1);
+  int i;
+  FOR(i,5) {
+    t= c&(p[i]^q[i]);
+    p[i]^=t;
+    q[i]^=t;
+  }
+}
+
+sv pack25519(u8 *o,const gf n)
+{
+  int i;
+  gf t;
+  u64 w[4];
+  set25519(t,n);
+  car25519(t);
+  car25519(t);
+  /* t is now below 2^255, add 19 to find out if it's above p */
+  t[0]+=19;
+  car25519(t);
+  /* t is now offset by 19, offset it by 2^255 instead and drop 2^255 */
+  t[0]+=0x8000000000000ULL-19;
+  t[1]+=0x8000000000000ULL-1;
+  t[2]+=0x8000000000000ULL-1;
+  t[3]+=0x8000000000000ULL-1;
+  t[4]+=0x8000000000000ULL-1;
+  t[1]+=t[0]>>51; t[0]&=GF_MASK51;
+  t[2]+=t[1]>>51; t[1]&=GF_MASK51;
+  t[3]+=t[2]>>51; t[2]&=GF_MASK51;
+  t[4]+=t[3]>>51; t[3]&=GF_MASK51;
+  t[4]&=GF_MASK51;
+  w[0]=t[0]|(t[1]<<51);
+  w[1]=(t[1]>>13)|(t[2]<<38);
+  w[2]=(t[2]>>26)|(t[3]<<25);
+  w[3]=(t[3]>>39)|(t[4]<<12);
+  FOR(i,32) o[i]=(u8)(w[i/8]>>(8*(i&7)));
+}
+
+static u64 load64(const u8 *n)
+{
+  u64 r=0;
+  int i;
+  FOR(i,8) r|=(u64)n[i]<<(8*i);
+  return r;
+}
+
+sv unpack25519(gf o, const u8 *n)
+{
+  o[0]=load64(n)&GF_MASK51;
+  o[1]=(load64(n+6)>>3)&GF_MASK51;
+  o[2]=(load64(n+12)>>6)&GF_MASK51;
+  o[3]=(load64(n+19)>>1)&GF_MASK51;
+  o[4]=(load64(n+24)>>12)&GF_MASK51;
+}
+
+sv A(gf o,const gf a,const gf b)
+{
+  int i;
+  FOR(i,5) o[i]=a[i]+b[i];
+}
+
+sv Z(gf o,const gf a,const gf b)
+{
+  /* Add 4*p so that the limbs don't underflow */
+  o[0]=a[0]+0x1fffffffffffb4ULL-b[0];
+  o[1]=a[1]+0x1ffffffffffffcULL-b[1];
+  o[2]=a[2]+0x1ffffffffffffcULL-b[2];
+  o[3]=a[3]+0x1ffffffffffffcULL-b[3];
+  o[4]=a[4]+0x1ffffffffffffcULL-b[4];
+}
+
+sv carry128(gf o,u128 t[5])
+{
+  u64 c;
+  o[0]=(u64)t[0]&GF_MASK51; c=(u64)(t[0]>>51);
+  t[1]+=c; o[1]=(u64)t[1]&GF_MASK51; c=(u64)(t[1]>>51);
+  t[2]+=c; o[2]=(u64)t[2]&GF_MASK51; c=(u64)(t[2]>>51);
+  t[3]+=c; o[3]=(u64)t[3]&GF_MASK51; c=(u64)(t[3]>>51);
+  t[4]+=c; o[4]=(u64)t[4]&GF_MASK51; c=(u64)(t[4]>>51);
+  o[0]+=c*19; c=o[0]>>51; o[0]&=GF_MASK51;
+  o[1]+=c;
+}
+
+sv M(gf o,const gf a,const gf b)
+{
+  u128 t[5];
+  u64 a0=a[0],a1=a[1],a2=a[2],a3=a[3],a4=a[4];
+  u64 b0=b[0],b1=b[1],b2=b[2],b3=b[3],b4=b[4];
+  u64 a1_19=a1*19,a2_19=a2*19,a3_19=a3*19,a4_19=a4*19;
+
+  t[0]=(u128)a0*b0+(u128)a4_19*b1+(u128)a3_19*b2+(u128)a2_19*b3+(u128)a1_19*b4;
+  t[1]=(u128)a0*b1+(u128)a1*b0+(u128)a4_19*b2+(u128)a3_19*b3+(u128)a2_19*b4;
+  t[2]=(u128)a0*b2+(u128)a1*b1+(u128)a2*b0+(u128)a4_19*b3+(u128)a3_19*b4;
+  t[3]=(u128)a0*b3+(u128)a1*b2+(u128)a2*b1+(u128)a3*b0+(u128)a4_19*b4;
+  t[4]=(u128)a0*b4+(u128)a1*b3+(u128)a2*b2+(u128)a3*b1+(u128)a4*b0;
+  carry128(o,t);
+}
+
+sv S(gf o,const gf a)
+{
+  u128 t[5];
+  u64 a0=a[0],a1=a[1],a2=a[2],a3=a[3],a4=a[4];
+  u64 d0=a0*2,d1=a1*2,d2_19=a2*2*19,a3_19=a3*19,a4_19=a4*19,d4_19=a4_19*2;
+
+  t[0]=(u128)a0*a0+(u128)d4_19*a1+(u128)d2_19*a3;
+  t[1]=(u128)d0*a1+(u128)d4_19*a2+(u128)a3*a3_19;
+  t[2]=(u128)d0*a2+(u128)a1*a1+(u128)d4_19*a3;
+  t[3]=(u128)d0*a3+(u128)d1*a2+(u128)a4*a4_19;
+  t[4]=(u128)d0*a4+(u128)d1*a3+(u128)a2*a2;
+  carry128(o,t);
 }
+#else
+typedef i64 gf[16];
+
+static const u8
+  _9[32] = {9};
+static const gf
+  gf0,
+  gf1 = {1},
+  _121665 = {0xDB41,1},
+  D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070, 0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203},
+  D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0, 0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406},
+  X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
+  Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
+  I = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
 
 sv set25519(gf r, const gf a)
 {
@@ -98,21 +241,6 @@ sv pack25519(u8 *o,const gf n)
   }
 }
 
-static int neq25519(const gf a, const gf b)
-{
-  u8 c[32],d[32];
-  pack25519(c,a);
-  pack25519(d,b);
-  return tweetnacl_crypto_verify_32(c,d);
-}
-
-static u8 par25519(const gf a)
-{
-  u8 d[32];
-  pack25519(d,a);
-  return d[0]&1;
-}
-
 sv unpack25519(gf o, const u8 *n)
 {
   int i;
@@ -148,44 +276,73 @@ sv S(gf o,const gf a)
   M(o,a,a);
 }
 
+#endif /* __SIZEOF_INT128__ */
+
+static int vn(const u8 *x,const u8 *y,int n)
+{
+  int i;
+  u32 d = 0;
+  FOR(i,n) d |= x[i]^y[i];
+  return (1 & ((d - 1) >> 8)) - 1;
+}
+
+static int tweetnacl_crypto_verify_32(const u8 *x,const u8 *y)
+{
+  return vn(x,y,32);
+}
+
+static int neq25519(const gf a, const gf b)
+{
+  u8 c[32],d[32];
+  pack25519(c,a);
+  pack25519(d,b);
+  return tweetnacl_crypto_verify_32(c,d);
+}
+
+static u8 par25519(const gf a)
+{
+  u8 d[32];
+  pack25519(d,a);
+  return d[0]&1;
+}
+
 sv inv25519(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=253;a>=0;a--) {
     S(c,c);
     if(a!=2&&a!=4) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
 sv pow2523(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=250;a>=0;a--) {
     S(c,c);
     if(a!=1) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
 int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
 {
   u8 z[32];
-  i64 x[80],r,i;
-  gf a,b,c,d,e,f;
+  i64 r,i;
+  gf x,a,b,c,d,e,f;
   FOR(i,31) z[i]=n[i];
   z[31]=(n[31]&127)|64;
   z[0]&=248;
   unpack25519(x,p);
-  FOR(i,16) {
-    b[i]=x[i];
-    d[i]=a[i]=c[i]=0;
-  }
-  a[0]=d[0]=1;
+  set25519(b,x);
+  set25519(a,gf1);
+  set25519(c,gf0);
+  set25519(d,gf1);
   for(i=254;i>=0;--i) {
     r=(z[i>>3]>>(i&7))&1;
     sel25519(a,b,r);
@@ -211,15 +368,9 @@ int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
     sel25519(a,b,r);
     sel25519(c,d,r);
   }
-  FOR(i,16) {
-    x[i+16]=a[i];
-    x[i+32]=c[i];
-    x[i+48]=b[i];
-    x[i+64]=d[i];
-  }
-  inv25519(x+32,x+32);
-  M(x+16,x+16,x+32);
-  pack25519(q,x+16);
+  inv25519(c,c);
+  M(a,a,c);
+  pack25519(q,a);
   return 0;
 }
 
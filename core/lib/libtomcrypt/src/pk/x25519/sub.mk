@@ -0,0 +1,2 @@
+srcs-y += x25519_make_key.c
+srcs-y += x25519_shared_secret.c
@@ -0,0 +1,8 @@
+srcs-y += chacha_setup.c
+srcs-y += chacha_ivctr32.c
+srcs-y += chacha_ivctr64.c
+srcs-y += chacha_keystream.c
+srcs-y += chacha_done.c
+ifneq ($(_CFG_CORE_LTC_CHACHA20_ACCEL),y)
+srcs-y += chacha_crypt.c
+endif
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <util.h>
+
+#include "acipher_helpers.h"
+
+/* X25519 keys and shared secrets are 256-bit strings */
+#define X25519_KEY_SIZE_BITS	256
+
+TEE_Result crypto_acipher_gen_x25519_key(struct x25519_keypair *key,
+					 size_t key_size)
+{
+	curve25519_key ltc_tmp_key = { };
+
+	if (key_size != X25519_KEY_SIZE_BITS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (x25519_make_key(NULL, find_prng("prng_crypto"),
+			    &ltc_tmp_key) != CRYPT_OK)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(key->priv, ltc_tmp_key.priv, sizeof(key->priv));
+	memcpy(key->pub, ltc_tmp_key.pub, sizeof(key->pub));
+	memzero_explicit(&ltc_tmp_key, sizeof(ltc_tmp_key));
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result crypto_acipher_x25519_shared_secret(struct x25519_keypair
+					       *private_key,
+					       const uint8_t *public_key,
+					       uint8_t *secret,
+					       size_t *secret_len)
+{
+	curve25519_key ltc_private_key = {
+		.type = PK_PRIVATE,
+		.algo = PKA_X25519,
+	};
+	curve25519_key ltc_public_key = {
+		.type = PK_PUBLIC,
+		.algo = PKA_X25519,
+	};
+	unsigned long ltc_secret_len = *secret_len;
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	uint8_t acc = 0;
+	size_t n = 0;
+
+	memcpy(ltc_private_key.priv, private_key->priv,
+	       sizeof(ltc_private_key.priv));
+	memcpy(ltc_public_key.pub, public_key, sizeof(ltc_public_key.pub));
+
+	switch (x25519_shared_secret(&ltc_private_key, &ltc_public_key, secret,
+				     &ltc_secret_len)) {
+	case CRYPT_OK:
+		break;
+	case CRYPT_BUFFER_OVERFLOW:
+		*secret_len = ltc_secret_len;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	default:
+		goto out;
+	}
+
+	/*
+	 * A public key of small order gives an all zero secret, reject it
+	 * as recommended by RFC 7748 without leaking where the secret
+	 * differs from zero.
+	 */
+	for (n = 0; n < ltc_secret_len; n++)
+		acc |= secret[n];
+	if (!acc) {
+		memzero_explicit(secret, ltc_secret_len);
+		goto out;
+	}
+
+	*secret_len = ltc_secret_len;
+	res = TEE_SUCCESS;
+out:
+	memzero_explicit(&ltc_private_key, sizeof(ltc_private_key));
+
+	return res;
+}
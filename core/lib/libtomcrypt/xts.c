@@ -6,7 +6,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
-#include <stdlib.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
@@ -23,6 +23,8 @@ struct ltc_xts_ctx {
 	uint8_t tweak[TEE_AES_BLOCK_SIZE];
 };
 
+SLAB_CACHE_DEFINE(ltc_xts_ctx_cache, struct ltc_xts_ctx, NULL);
+
 static const struct crypto_cipher_ops ltc_xts_ops;
 
 static struct ltc_xts_ctx *to_xts_ctx(struct crypto_cipher_ctx *ctx)
@@ -87,7 +89,7 @@ static void ltc_xts_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_xts_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_xts_ctx(ctx));
+	slab_free(&ltc_xts_ctx_cache, to_xts_ctx(ctx));
 }
 
 static void ltc_xts_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -118,7 +120,7 @@ TEE_Result crypto_aes_xts_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	c = calloc(1, sizeof(*c));
+	c = slab_alloc(&ltc_xts_ctx_cache);
 	if (!c)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
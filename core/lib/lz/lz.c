@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <lz.h>
+#include <string.h>
+
+#define MIN_MATCH	3
+#define MAX_LIT		32
+#define MAX_OFFS	8192
+#define LEN_EXT		7
+#define MAX_MATCH	(LEN_EXT + 255 + 2)
+
+static unsigned int hash(const uint8_t *p)
+{
+	uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+
+	return (v * 2654435761U) >> (32 - LZ_HTAB_BITS);
+}
+
+static bool emit_literals(const uint8_t *lit, size_t len, uint8_t *dst,
+			  size_t dst_len, size_t *op)
+{
+	size_t n = 0;
+
+	while (len) {
+		n = len;
+		if (n > MAX_LIT)
+			n = MAX_LIT;
+		if (dst_len - *op < n + 1)
+			return false;
+		dst[*op] = n - 1;
+		memcpy(dst + *op + 1, lit, n);
+		*op += n + 1;
+		lit += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_len,
+		   uint16_t htab[LZ_HTAB_SIZE])
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	size_t lit_start = 0;
+	size_t max_len = 0;
+	size_t offs = 0;
+	size_t len = 0;
+	size_t ref = 0;
+	size_t ip = 0;
+	size_t op = 0;
+	unsigned int h = 0;
+
+	assert(src_len <= LZ_MAX_SRC_LEN);
+
+	/* Entries hold position + 1, 0 is empty */
+	memset(htab, 0, LZ_HTAB_SIZE * sizeof(*htab));
+
+	while (ip + MIN_MATCH <= src_len) {
+		h = hash(s + ip);
+		ref = htab[h];
+		htab[h] = ip + 1;
+
+		if (!ref || ip - (ref - 1) > MAX_OFFS ||
+		    memcmp(s + ref - 1, s + ip, MIN_MATCH)) {
+			ip++;
+			continue;
+		}
+		ref--;
+
+		max_len = src_len - ip;
+		if (max_len > MAX_MATCH)
+			max_len = MAX_MATCH;
+		len = MIN_MATCH;
+		while (len < max_len && s[ref + len] == s[ip + len])
+			len++;
+
+		if (!emit_literals(s + lit_start, ip - lit_start, d, dst_len,
+				   &op) ||
+		    dst_len - op < 3)
+			return 0;
+
+		offs = ip - ref - 1;
+		if (len - 2 < LEN_EXT) {
+			d[op++] = ((len - 2) << 5) | (offs >> 8);
+		} else {
+			d[op++] = (LEN_EXT << 5) | (offs >> 8);
+			d[op++] = len - 2 - LEN_EXT;
+		}
+		d[op++] = offs;
+
+		ip += len;
+		lit_start = ip;
+	}
+
+	if (!emit_literals(s + lit_start, src_len - lit_start, d, dst_len,
+			   &op))
+		return 0;
+
+	return op;
+}
+
+bool lz_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_len)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	size_t offs = 0;
+	size_t len = 0;
+	size_t ip = 0;
+	size_t op = 0;
+	size_t n = 0;
+	uint8_t c = 0;
+
+	while (ip < src_len) {
+		c = s[ip++];
+
+		if (c < MAX_LIT) {
+			len = c + 1;
+			if (len > src_len - ip || len > dst_len - op)
+				return false;
+			memcpy(d + op, s + ip, len);
+			ip += len;
+			op += len;
+			continue;
+		}
+
+		len = c >> 5;
+		if (len == LEN_EXT) {
+			if (ip == src_len)
+				return false;
+			len += s[ip++];
+		}
+		len += 2;
+		if (ip == src_len)
+			return false;
+		offs = (((size_t)c & 0x1f) << 8 | s[ip++]) + 1;
+		if (offs > op || len > dst_len - op)
+			return false;
+
+		/* Byte by byte since the source may overlap the destination */
+		for (n = 0; n < len; n++)
+			d[op + n] = d[op + n - offs];
+		op += len;
+	}
+
+	return op == dst_len;
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __LZ_H
+#define __LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A small byte oriented LZ77 compressor, aimed at compressing pages of
+ * memory quickly rather than at a high compression ratio.
+ *
+ * The compressed stream is a sequence of items starting with a control
+ * byte:
+ * - 000nnnnn: a run of nnnnn + 1 literal bytes follows
+ * - lllooooo oooooooo: copy lll + 2 bytes from ooooo oooooooo + 1 bytes
+ *   back, if lll is 7 a length byte to add to it follows the control
+ *   byte
+ */
+
+#define LZ_HTAB_BITS	10
+#define LZ_HTAB_SIZE	(1 << LZ_HTAB_BITS)
+
+/* Largest buffer which can be compressed */
+#define LZ_MAX_SRC_LEN	UINT16_MAX
+
+/*
+ * lz_compress() - compress a buffer
+ * @src:	Buffer to compress
+ * @src_len:	Length of @src, at most LZ_MAX_SRC_LEN
+ * @dst:	Output buffer
+ * @dst_len:	Size of @dst
+ * @htab:	Scratch hash table, contents is ignored on entry
+ *
+ * Returns the length of the compressed data in @dst or 0 if it doesn't
+ * fit in @dst_len bytes.
+ */
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_len,
+		   uint16_t htab[LZ_HTAB_SIZE]);
+
+/*
+ * lz_decompress() - decompress a buffer
+ * @src:	Data from lz_compress()
+ * @src_len:	Length of @src
+ * @dst:	Output buffer
+ * @dst_len:	Expected length of the decompressed data
+ *
+ * Returns true if @src decompressed to exactly @dst_len bytes and false
+ * if @src is malformed.
+ */
+bool lz_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_len);
+
+#endif /*__LZ_H*/
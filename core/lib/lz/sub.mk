@@ -0,0 +1,2 @@
+global-incdirs-y += .
+srcs-y += lz.c
@@ -3,11 +3,15 @@
  * Copyright (c) 2019, Linaro Limited
  */
 
+#include <config.h>
 #include <crypto/crypto.h>
 #include <crypto/internal_aes-gcm.h>
 #include <initcall.h>
 #include <kernel/boot.h>
 #include <kernel/panic.h>
+#ifdef CFG_PAGER_RWP_COMPRESS
+#include <lz.h>
+#endif
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/fobj.h>
@@ -31,6 +35,10 @@ struct rwp_aes_gcm_iv {
 struct rwp_state {
 	uint64_t iv;
 	uint8_t tag[RWP_AES_GCM_TAG_LEN];
+#ifdef CFG_PAGER_RWP_COMPRESS
+	tee_mm_entry_t *mm;	/* Stored page in rwpz_pool */
+	uint16_t len;		/* SMALL_PAGE_SIZE if not compressed */
+#endif
 };
 
 struct fobj_rwp {
@@ -64,6 +72,110 @@ static TEE_Result fobj_generate_authenc_key(void)
 }
 driver_init_late(fobj_generate_authenc_key);
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+/*
+ * Compressed backing store of the pages of fobjs allocated with
+ * fobj_rw_paged_alloc(). Instead of a full page of backing store for
+ * each page, evicted pages are compressed and then encrypted into a pool
+ * of CFG_PAGER_RWP_COMPRESS_STORE_SIZE bytes shared by all such fobjs.
+ * Pages which don't compress well are stored as is.
+ *
+ * The pool must be large enough to hold all pages evicted at the same
+ * time, the pager panics if it runs out of space.
+ *
+ * The buffers below are only used with the pager lock held.
+ */
+#define RWPZ_SHIFT		6
+#define RWPZ_MAX_LEN		(SMALL_PAGE_SIZE - SMALL_PAGE_SIZE / 8)
+
+static tee_mm_pool_t rwpz_pool;
+static uint8_t *rwpz_store;
+static uint16_t rwpz_htab[LZ_HTAB_SIZE];
+static uint8_t rwpz_buf[RWPZ_MAX_LEN];
+
+static TEE_Result rwpz_init(void)
+{
+	size_t size = ROUNDUP(CFG_PAGER_RWP_COMPRESS_STORE_SIZE,
+			      SMALL_PAGE_SIZE);
+	tee_mm_entry_t *mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	paddr_t pa = 0;
+
+	if (!mm)
+		panic("failed to allocate compressed store");
+	pa = tee_mm_get_smem(mm);
+	rwpz_store = phys_to_virt(pa, MEM_AREA_TA_RAM);
+	if (!rwpz_store ||
+	    !tee_mm_init(&rwpz_pool, pa, pa + size, RWPZ_SHIFT,
+			 TEE_MM_POOL_LARGE_FLAGS))
+		panic("failed to initialize compressed store");
+
+	return TEE_SUCCESS;
+}
+driver_init_late(rwpz_init);
+
+static uint8_t *rwpz_get_va(struct rwp_state *state)
+{
+	return rwpz_store + (tee_mm_get_smem(state->mm) - rwpz_pool.lo);
+}
+
+static TEE_Result rwpz_load_page(struct rwp_state *state,
+				 struct rwp_aes_gcm_iv *iv, void *va)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (state->len == SMALL_PAGE_SIZE)
+		return internal_aes_gcm_dec(&rwp_ae_key, iv, sizeof(*iv),
+					    NULL, 0, rwpz_get_va(state),
+					    SMALL_PAGE_SIZE, va, state->tag,
+					    sizeof(state->tag));
+
+	res = internal_aes_gcm_dec(&rwp_ae_key, iv, sizeof(*iv), NULL, 0,
+				   rwpz_get_va(state), state->len, rwpz_buf,
+				   state->tag, sizeof(state->tag));
+	if (res)
+		return res;
+	if (!lz_decompress(rwpz_buf, state->len, va, SMALL_PAGE_SIZE))
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result rwpz_save_page(struct rwp_state *state,
+				 struct rwp_aes_gcm_iv *iv, const void *va)
+{
+	size_t tag_len = sizeof(state->tag);
+	const void *src = rwpz_buf;
+	size_t alloc_len = 0;
+	size_t len = 0;
+
+	len = lz_compress(va, SMALL_PAGE_SIZE, rwpz_buf, sizeof(rwpz_buf),
+			  rwpz_htab);
+	if (!len) {
+		src = va;
+		len = SMALL_PAGE_SIZE;
+	}
+
+	/*
+	 * Keep the previous location of the page unless it's too small or
+	 * would waste more than an eighth of a page.
+	 */
+	alloc_len = tee_mm_get_bytes(state->mm);
+	if (alloc_len < len || alloc_len - len > SMALL_PAGE_SIZE / 8) {
+		tee_mm_free(state->mm);
+		state->mm = tee_mm_alloc(&rwpz_pool, len);
+		if (!state->mm) {
+			EMSG("Compressed store exhausted");
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+	}
+	state->len = len;
+
+	return internal_aes_gcm_enc(&rwp_ae_key, iv, sizeof(*iv), NULL, 0,
+				    src, len, rwpz_get_va(state), state->tag,
+				    &tag_len);
+}
+#endif /*CFG_PAGER_RWP_COMPRESS*/
+
 static void fobj_init(struct fobj *fobj, const struct fobj_ops *ops,
 		      unsigned int num_pages)
 {
@@ -96,6 +208,9 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 	if (!rwp->state)
 		goto err;
 
+	if (IS_ENABLED(CFG_PAGER_RWP_COMPRESS))
+		goto out;
+
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
 	mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
@@ -106,6 +221,7 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 	if (!rwp->store)
 		goto err;
 
+out:
 	fobj_init(&rwp->fobj, &ops_rw_paged, num_pages);
 
 	return &rwp->fobj;
@@ -128,9 +244,15 @@ static struct fobj_rwp *to_rwp(struct fobj *fobj)
 static void rwp_free(struct fobj *fobj)
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
+	unsigned int __maybe_unused n = 0;
 
 	fobj_uninit(fobj);
+#ifdef CFG_PAGER_RWP_COMPRESS
+	for (n = 0; n < fobj->num_pages; n++)
+		tee_mm_free(rwp->state[n].mm);
+#else
 	tee_mm_free(tee_mm_find(&tee_mm_sec_ddr, virt_to_phys(rwp->store)));
+#endif
 	free(rwp->state);
 	free(rwp);
 }
@@ -140,7 +262,7 @@ static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
-	uint8_t *src = rwp->store + page_idx * SMALL_PAGE_SIZE;
+	uint8_t __maybe_unused *src = NULL;
 	struct rwp_aes_gcm_iv iv = {
 		.iv = { (vaddr_t)state, state->iv >> 32, state->iv }
 	};
@@ -157,9 +279,14 @@ static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 		return TEE_SUCCESS;
 	}
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+	return rwpz_load_page(state, &iv, va);
+#else
+	src = rwp->store + page_idx * SMALL_PAGE_SIZE;
 	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
 				    NULL, 0, src, SMALL_PAGE_SIZE, va,
 				    state->tag, sizeof(state->tag));
+#endif
 }
 DECLARE_KEEP_PAGER(rwp_load_page);
 
@@ -168,8 +295,8 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
-	size_t tag_len = sizeof(state->tag);
-	uint8_t *dst = rwp->store + page_idx * SMALL_PAGE_SIZE;
+	size_t __maybe_unused tag_len = sizeof(state->tag);
+	uint8_t __maybe_unused *dst = rwp->store + page_idx * SMALL_PAGE_SIZE;
 	struct rwp_aes_gcm_iv iv;
 
 	memset(&iv, 0, sizeof(iv));
@@ -198,9 +325,13 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	iv.iv[1] = state->iv >> 32;
 	iv.iv[2] = state->iv;
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+	return rwpz_save_page(state, &iv, va);
+#else
 	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
 				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
 				    state->tag, &tag_len);
+#endif
 }
 DECLARE_KEEP_PAGER(rwp_save_page);
 
@@ -533,7 +664,8 @@ struct fobj_sec_mem {
 
 static const struct fobj_ops ops_sec_mem;
 
-struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
+static struct fobj *sec_mem_alloc(unsigned int num_pages, size_t align,
+				  paddr_t offs)
 {
 	struct fobj_sec_mem *f = calloc(1, sizeof(*f));
 	size_t size = 0;
@@ -545,7 +677,11 @@ struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
 
-	f->mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	if (align)
+		f->mm = tee_mm_alloc_aligned(&tee_mm_sec_ddr, size, align,
+					     offs);
+	else
+		f->mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
 	if (!f->mm)
 		goto err;
 
@@ -566,6 +702,22 @@ err:
 	return NULL;
 }
 
+struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
+{
+	return sec_mem_alloc(num_pages, 0, 0);
+}
+
+struct fobj *fobj_sec_mem_alloc_aligned(unsigned int num_pages, size_t align,
+					paddr_t offs)
+{
+	return sec_mem_alloc(num_pages, align, offs);
+}
+
+bool fobj_is_contiguous(struct fobj *fobj)
+{
+	return fobj->ops == &ops_sec_mem;
+}
+
 static struct fobj_sec_mem *to_sec_mem(struct fobj *fobj)
 {
 	assert(fobj->ops == &ops_sec_mem);
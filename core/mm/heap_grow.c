@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <initcall.h>
+#include <malloc.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
+#include <mm/tee_mm.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+/*
+ * The core heap borrows memory from the TA RAM pool when it runs out of
+ * memory, in chunks of at least CFG_CORE_HEAP_GROW_SIZE bytes. A chunk is
+ * given back to the TA RAM pool as soon as the heap doesn't use it any
+ * longer.
+ */
+
+static void *heap_grow(size_t size, size_t *len)
+{
+	tee_mm_entry_t *mm = NULL;
+	void *va = NULL;
+
+	if (ROUNDUP_OVERFLOW(MAX(size, (size_t)CFG_CORE_HEAP_GROW_SIZE),
+			     SMALL_PAGE_SIZE, &size))
+		return NULL;
+
+	mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	if (!mm)
+		return NULL;
+
+	va = phys_to_virt(tee_mm_get_smem(mm), MEM_AREA_TA_RAM);
+	if (!va) {
+		tee_mm_free(mm);
+		return NULL;
+	}
+
+	*len = tee_mm_get_bytes(mm);
+	FMSG("Heap grown with %zu bytes at %p", *len, va);
+
+	return va;
+}
+
+static void heap_shrink(void *buf, size_t len)
+{
+	tee_mm_entry_t *mm = tee_mm_find(&tee_mm_sec_ddr, virt_to_phys(buf));
+
+	assert(mm && tee_mm_get_bytes(mm) == len);
+	FMSG("Heap shrunk with %zu bytes at %p", len, buf);
+
+	/* Don't leave anything from the heap behind in TA RAM */
+	memset(buf, 0, len);
+	tee_mm_free(mm);
+}
+
+static const struct malloc_grow_ops heap_grow_ops = {
+	.grow = heap_grow,
+	.shrink = heap_shrink,
+};
+
+static TEE_Result heap_grow_init(void)
+{
+	malloc_set_grow_ops(&heap_grow_ops);
+
+	return TEE_SUCCESS;
+}
+
+service_init(heap_grow_init);
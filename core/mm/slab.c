@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <assert.h>
+#include <kernel/spinlock.h>
+#include <malloc.h>
+#include <mm/slab.h>
+#include <string.h>
+#include <sys/queue.h>
+#include <util.h>
+
+/* Approximate size of the heap buffer backing a slab */
+#define SLAB_SIZE		2048
+#define SLAB_OBJ_ALIGN		(2 * sizeof(void *))
+
+/*
+ * struct slab - a chunk of memory holding objects of a slab cache
+ * @link:	Link in the partial or full list of the cache
+ * @sc:		Cache owning the slab
+ * @free_list:	Free objects in this slab
+ * @num_free:	Number of objects in @free_list
+ * @num_objs:	Total number of objects in this slab
+ *
+ * The objects follow the slab header, each one preceded by a struct
+ * slab_obj.
+ */
+struct slab {
+	LIST_ENTRY(slab) link;
+	struct slab_cache *sc;
+	struct slab_obj *free_list;
+	size_t num_free;
+	size_t num_objs;
+};
+
+struct slab_obj {
+	struct slab *slab;
+	struct slab_obj *next_free;
+};
+
+static size_t slab_hdr_size(void)
+{
+	return ROUNDUP(sizeof(struct slab), SLAB_OBJ_ALIGN);
+}
+
+static size_t obj_stride(struct slab_cache *sc)
+{
+	return ROUNDUP(sizeof(struct slab_obj) + sc->obj_size, SLAB_OBJ_ALIGN);
+}
+
+static struct slab *slab_create(struct slab_cache *sc)
+{
+	size_t stride = obj_stride(sc);
+	size_t num_objs = MAX((SLAB_SIZE - slab_hdr_size()) / stride, 1UL);
+	struct slab *slab = NULL;
+	struct slab_obj *o = NULL;
+	size_t size = slab_hdr_size() + num_objs * stride;
+	size_t n = 0;
+
+	if (sc->flags & SLAB_CACHE_NEXUS)
+		slab = nex_malloc(size);
+	else
+		slab = malloc(size);
+	if (!slab)
+		return NULL;
+
+	slab->sc = sc;
+	slab->free_list = NULL;
+	slab->num_free = num_objs;
+	slab->num_objs = num_objs;
+
+	/* Build the free list so that objects are handed out in order */
+	for (n = num_objs; n > 0; n--) {
+		o = (void *)((vaddr_t)slab + slab_hdr_size() +
+			     (n - 1) * stride);
+		o->slab = slab;
+		o->next_free = slab->free_list;
+		slab->free_list = o;
+		if (sc->ctor)
+			sc->ctor(o + 1);
+	}
+
+	return slab;
+}
+
+static void slab_release(struct slab *slab)
+{
+	if (slab->sc->flags & SLAB_CACHE_NEXUS)
+		nex_free(slab);
+	else
+		free(slab);
+}
+
+void *slab_alloc(struct slab_cache *sc)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sc->spinlock);
+	struct slab *slab = LIST_FIRST(&sc->partial);
+	struct slab_obj *o = NULL;
+
+	if (!slab && sc->empty) {
+		slab = sc->empty;
+		sc->empty = NULL;
+		LIST_INSERT_HEAD(&sc->partial, slab, link);
+	}
+
+	if (!slab) {
+		cpu_spin_unlock_xrestore(&sc->spinlock, exceptions);
+		slab = slab_create(sc);
+		exceptions = cpu_spin_lock_xsave(&sc->spinlock);
+		if (!slab) {
+			sc->stats.num_alloc_fail++;
+			cpu_spin_unlock_xrestore(&sc->spinlock, exceptions);
+			return NULL;
+		}
+		sc->stats.num_slabs++;
+		LIST_INSERT_HEAD(&sc->partial, slab, link);
+	}
+
+	o = slab->free_list;
+	slab->free_list = o->next_free;
+	slab->num_free--;
+	if (!slab->num_free) {
+		LIST_REMOVE(slab, link);
+		LIST_INSERT_HEAD(&sc->full, slab, link);
+	}
+
+	sc->stats.num_objs++;
+	if (sc->stats.num_objs > sc->stats.max_objs)
+		sc->stats.max_objs = sc->stats.num_objs;
+
+	cpu_spin_unlock_xrestore(&sc->spinlock, exceptions);
+
+	if (!sc->ctor)
+		memset(o + 1, 0, sc->obj_size);
+
+	return o + 1;
+}
+
+void slab_free(struct slab_cache *sc, void *obj)
+{
+	struct slab_obj *o = obj;
+	struct slab *release = NULL;
+	struct slab *slab = NULL;
+	uint32_t exceptions = 0;
+
+	if (!obj)
+		return;
+
+	o--;
+	slab = o->slab;
+	assert(slab->sc == sc);
+
+	exceptions = cpu_spin_lock_xsave(&sc->spinlock);
+
+	if (!slab->num_free) {
+		LIST_REMOVE(slab, link);
+		LIST_INSERT_HEAD(&sc->partial, slab, link);
+	}
+
+	o->next_free = slab->free_list;
+	slab->free_list = o;
+	slab->num_free++;
+	sc->stats.num_objs--;
+
+	/* Keep one empty slab in reserve, release the others */
+	if (slab->num_free == slab->num_objs) {
+		LIST_REMOVE(slab, link);
+		if (sc->empty) {
+			release = slab;
+			sc->stats.num_slabs--;
+		} else {
+			sc->empty = slab;
+		}
+	}
+
+	cpu_spin_unlock_xrestore(&sc->spinlock, exceptions);
+
+	if (release)
+		slab_release(release);
+}
+
+void slab_cache_get_stats(struct slab_cache *sc,
+			  struct slab_cache_stats *stats)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&sc->spinlock);
+
+	*stats = sc->stats;
+	cpu_spin_unlock_xrestore(&sc->spinlock, exceptions);
+}
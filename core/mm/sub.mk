@@ -1,3 +1,5 @@
 srcs-y += fobj.c
 srcs-y += file.c
 srcs-y += vm.c
+srcs-y += slab.c
+srcs-$(CFG_CORE_HEAP_GROW) += heap_grow.c
@@ -16,6 +16,7 @@
 #include <kernel/virtualization.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <mm/fobj.h>
 #include <mm/mobj.h>
 #include <mm/pgt_cache.h>
 #include <mm/tee_mm.h>
@@ -162,6 +163,109 @@ static TEE_Result alloc_pgt(struct user_mode_ctx *uctx)
 	return TEE_SUCCESS;
 }
 
+/*
+ * Rebuilds the index of regions and updates the memory usage of the
+ * context, called each time regions are added to or removed from
+ * vmi->regions.
+ */
+static void update_region_index(struct vm_info *vmi)
+{
+	struct vm_region **idx = NULL;
+	struct vm_region *r = NULL;
+	size_t n = 0;
+
+	vmi->map_gen++;
+	vmi->priv_size = 0;
+	vmi->nonpriv_size = 0;
+	vmi->paged_size = 0;
+
+	TAILQ_FOREACH(r, &vmi->regions, link) {
+		if (r->flags & VM_FLAGS_NONPRIV)
+			vmi->nonpriv_size += r->size;
+		else
+			vmi->priv_size += r->size;
+		if (mobj_is_paged(r->mobj))
+			vmi->paged_size += r->size;
+		n++;
+	}
+
+	vmi->num_pgts = 0;
+	if (n) {
+		vaddr_t b = TAILQ_FIRST(&vmi->regions)->va;
+		vaddr_t e = 0;
+
+		r = TAILQ_LAST(&vmi->regions, vm_region_head);
+		e = ROUNDUP(r->va + r->size, CORE_MMU_PGDIR_SIZE);
+		b = ROUNDDOWN(b, CORE_MMU_PGDIR_SIZE);
+		vmi->num_pgts = (e - b) >> CORE_MMU_PGDIR_SHIFT;
+	}
+
+	if (!n) {
+		free(vmi->region_index);
+		vmi->region_index = NULL;
+		vmi->num_regions = 0;
+		return;
+	}
+
+	if (!vmi->region_index || n != vmi->num_regions) {
+		idx = realloc(vmi->region_index, n * sizeof(*idx));
+		if (!idx) {
+			free(vmi->region_index);
+			vmi->region_index = NULL;
+			vmi->num_regions = 0;
+			return;
+		}
+		vmi->region_index = idx;
+		vmi->num_regions = n;
+	}
+
+	n = 0;
+	TAILQ_FOREACH(r, &vmi->regions, link)
+		vmi->region_index[n++] = r;
+}
+
+/* Returns the first region ending above @va or NULL if there's none */
+static struct vm_region *find_region_above(const struct vm_info *vmi,
+					   vaddr_t va)
+{
+	struct vm_region *r = NULL;
+	size_t hi = vmi->num_regions;
+	size_t lo = 0;
+	size_t mid = 0;
+
+	if (!vmi->region_index) {
+		TAILQ_FOREACH(r, &vmi->regions, link)
+			if (va < r->va + r->size)
+				return r;
+		return NULL;
+	}
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		r = vmi->region_index[mid];
+		if (va < r->va + r->size)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if (lo == vmi->num_regions)
+		return NULL;
+	return vmi->region_index[lo];
+}
+
+/* Returns the region covering @va or NULL if there's none */
+static struct vm_region *find_vm_region(const struct vm_info *vmi,
+					vaddr_t va)
+{
+	struct vm_region *r = find_region_above(vmi, va);
+
+	if (r && va >= r->va)
+		return r;
+
+	return NULL;
+}
+
 static void rem_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 {
 	struct thread_specific_data *tsd = thread_get_tsd();
@@ -237,6 +341,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 		if (va) {
 			reg->va = va;
 			TAILQ_INSERT_BEFORE(r, reg, link);
+			update_region_index(vmi);
 			return TEE_SUCCESS;
 		}
 		prev_r = r;
@@ -250,12 +355,35 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (va) {
 		reg->va = va;
 		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+		update_region_index(vmi);
 		return TEE_SUCCESS;
 	}
 
 	return TEE_ERROR_ACCESS_CONFLICT;
 }
 
+/*
+ * The private memory of a context is bounded by CFG_TA_MEM_LIMIT, 0 means
+ * no limit. Parameters and shared memory aren't accounted since they are
+ * owned by someone else.
+ */
+static bool priv_mem_limit_reached(struct vm_info *vmi,
+				   const struct vm_region *reg)
+{
+	size_t sz = 0;
+
+	if (!CFG_TA_MEM_LIMIT || (reg->flags & VM_FLAGS_NONPRIV))
+		return false;
+
+	if (!ADD_OVERFLOW(vmi->priv_size, reg->size, &sz) &&
+	    sz <= CFG_TA_MEM_LIMIT)
+		return false;
+
+	DMSG("Private memory limit reached: %zu + %zu bytes",
+	     vmi->priv_size, reg->size);
+	return true;
+}
+
 TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 		      uint32_t prot, uint32_t flags, struct mobj *mobj,
 		      size_t offs, size_t pad_begin, size_t pad_end,
@@ -291,6 +419,11 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 	reg->attr = attr | prot;
 	reg->flags = flags;
 
+	if (priv_mem_limit_reached(&uctx->vm_info, reg)) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err_free_reg;
+	}
+
 	res = umap_add_region(&uctx->vm_info, reg, pad_begin, pad_end, align);
 	if (res)
 		goto err_free_reg;
@@ -326,23 +459,13 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 
 err_rem_reg:
 	TAILQ_REMOVE(&uctx->vm_info.regions, reg, link);
+	update_region_index(&uctx->vm_info);
 err_free_reg:
 	mobj_put(reg->mobj);
 	free(reg);
 	return res;
 }
 
-static struct vm_region *find_vm_region(struct vm_info *vm_info, vaddr_t va)
-{
-	struct vm_region *r = NULL;
-
-	TAILQ_FOREACH(r, &vm_info->regions, link)
-		if (va >= r->va && va < r->va + r->size)
-			return r;
-
-	return NULL;
-}
-
 static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 				   size_t len,
 				   bool (*cmp_regs)(const struct vm_region *r0,
@@ -402,6 +525,7 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 	r->size = diff;
 
 	TAILQ_INSERT_AFTER(&uctx->vm_info.regions, r, r2, link);
+	update_region_index(&uctx->vm_info);
 
 	return TEE_SUCCESS;
 }
@@ -496,6 +620,7 @@ static void merge_vm_range(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
 		r->size += r_next->size;
 		mobj_put(r_next->mobj);
 		free(r_next);
+		update_region_index(&uctx->vm_info);
 		r_next = r;
 	}
 }
@@ -515,6 +640,53 @@ static bool cmp_region_for_remap(const struct vm_region *r0,
 	       r0->mobj == r->mobj && rn->offset == r->offset + r->size;
 }
 
+TEE_Result vm_map_zi(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
+		     uint32_t flags, size_t pad_begin, size_t pad_end,
+		     bool block_map)
+{
+	unsigned int num_pages = ROUNDUP_DIV(len, SMALL_PAGE_SIZE);
+	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_PRW;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct mobj *mobj = NULL;
+	struct fobj *f = NULL;
+	size_t align = 0;
+
+#ifndef CFG_PAGED_USER_TA
+	/*
+	 * The physical address must match the virtual address modulo
+	 * the block size, which is chosen aligned when free to choose.
+	 */
+	if (block_map && len >= CORE_MMU_PGDIR_SIZE) {
+		f = fobj_sec_mem_alloc_aligned(num_pages, CORE_MMU_PGDIR_SIZE,
+					       *va & CORE_MMU_PGDIR_MASK);
+		if (f && !*va)
+			align = CORE_MMU_PGDIR_SIZE;
+	}
+#else
+	(void)block_map;
+#endif
+	if (!f)
+		f = fobj_ta_mem_alloc(num_pages);
+	if (!f)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	mobj = mobj_with_fobj_alloc(f, NULL);
+	fobj_put(f);
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = vm_map_pad(uctx, va, len, prot, flags, mobj, 0, pad_begin,
+			 pad_end, align);
+	if (res == TEE_ERROR_OUT_OF_MEMORY && align) {
+		/* Map with small pages if no aligned range is free */
+		res = vm_map_pad(uctx, va, len, prot, flags, mobj, 0,
+				 pad_begin, pad_end, 0);
+	}
+	mobj_put(mobj);
+
+	return res;
+}
+
 TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 		    size_t len, size_t pad_begin, size_t pad_end)
 {
@@ -551,6 +723,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 		TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
 		TAILQ_INSERT_TAIL(&regs, r, link);
 	}
+	update_region_index(&uctx->vm_info);
 
 	/*
 	 * Synchronize change to translation tables. Even though the pager
@@ -602,6 +775,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 					TAILQ_INSERT_HEAD(&regs, r, link);
 				r_tmp = r;
 			}
+			update_region_index(&uctx->vm_info);
 
 			goto err_restore_map;
 		}
@@ -719,6 +893,7 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 		r->attr &= ~TEE_MATTR_PROT_MASK;
 		r->attr |= prot;
 	}
+	uctx->vm_info.map_gen++;
 
 	if (need_sync) {
 		/* Synchronize changes to translation tables */
@@ -751,6 +926,7 @@ static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 	TAILQ_REMOVE(&vmi->regions, reg, link);
 	mobj_put(reg->mobj);
 	free(reg);
+	update_region_index(vmi);
 }
 
 TEE_Result vm_unmap(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
@@ -912,9 +1088,33 @@ static int cmp_param_mem(const void *a0, const void *a1)
 	return CMP_TRILEAN(m0->size, m1->size);
 }
 
+/*
+ * A large memref in physically contiguous memory, typically a secure data
+ * path buffer forwarded by a TA invoking another TA, is given a virtual
+ * address aligned like its physical address so that the callee maps it
+ * with directory block entries instead of filling translation tables on
+ * each invocation.
+ */
+static size_t param_mem_align(struct param_mem *mem, bool lazy)
+{
+	paddr_t pa = 0;
+
+	if (IS_ENABLED(CFG_PAGED_USER_TA) || lazy ||
+	    mem->size < CORE_MMU_PGDIR_SIZE || mobj_is_paged(mem->mobj) ||
+	    mem->mobj->phys_granule)
+		return 0;
+
+	if (mobj_get_pa(mem->mobj, mem->offs, 0, &pa) ||
+	    (pa & CORE_MMU_PGDIR_MASK))
+		return 0;
+
+	return CORE_MMU_PGDIR_SIZE;
+}
+
 TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
-			void *param_va[TEE_NUM_PARAMS])
+			void *param_va[TEE_NUM_PARAMS], bool lazy)
 {
+	uint32_t flags = VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE;
 	TEE_Result res = TEE_SUCCESS;
 	size_t n;
 	size_t m;
@@ -932,6 +1132,7 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 		phys_offs = mobj_get_phys_offs(param->u[n].mem.mobj,
 					       CORE_MMU_USER_PARAM_SIZE);
 		mem[n].mobj = param->u[n].mem.mobj;
+		mem[n].readonly = param->u[n].mem.readonly;
 		mem[n].offs = ROUNDDOWN(phys_offs + param->u[n].mem.offs,
 					CORE_MMU_USER_PARAM_SIZE);
 		mem[n].size = ROUNDUP(phys_offs + param->u[n].mem.offs -
@@ -961,6 +1162,8 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 		     core_is_buffer_intersect(mem[m].offs, mem[m].size,
 					      mem[n].offs, mem[n].size))) {
 			mem[m].size = mem[n].offs + mem[n].size - mem[m].offs;
+			/* Pages shared with a writable memref stay writable */
+			mem[m].readonly &= mem[n].readonly;
 			continue;
 		}
 		m++;
@@ -977,13 +1180,23 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 
 	check_param_map_empty(uctx);
 
+	if (lazy)
+		flags |= VM_FLAG_LAZY;
+
 	for (n = 0; n < m; n++) {
+		size_t align = param_mem_align(mem + n, lazy);
+		uint32_t prot = TEE_MATTR_PRW | TEE_MATTR_URW;
 		vaddr_t va = 0;
 
-		res = vm_map(uctx, &va, mem[n].size,
-			     TEE_MATTR_PRW | TEE_MATTR_URW,
-			     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
-			     mem[n].mobj, mem[n].offs);
+		if (mem[n].readonly)
+			prot = TEE_MATTR_PR | TEE_MATTR_UR;
+
+		res = vm_map_pad(uctx, &va, mem[n].size, prot, flags,
+				 mem[n].mobj, mem[n].offs, 0, 0, align);
+		/* Alignment is only an optimization */
+		if (res == TEE_ERROR_ACCESS_CONFLICT && align)
+			res = vm_map(uctx, &va, mem[n].size, prot, flags,
+				     mem[n].mobj, mem[n].offs);
 		if (res)
 			goto out;
 	}
@@ -1012,6 +1225,20 @@ out:
 	return res;
 }
 
+bool vm_map_lazy_region(struct user_mode_ctx *uctx, vaddr_t va)
+{
+	struct vm_region *r = find_vm_region(&uctx->vm_info, va);
+
+	if (!r || !(r->flags & VM_FLAG_LAZY))
+		return false;
+
+	r->flags &= ~VM_FLAG_LAZY;
+	core_mmu_map_user_region(r);
+	uctx->vm_info.map_gen++;
+
+	return true;
+}
+
 TEE_Result vm_add_rwmem(struct user_mode_ctx *uctx, struct mobj *mobj,
 			vaddr_t *va)
 {
@@ -1077,16 +1304,13 @@ void vm_info_final(struct user_mode_ctx *uctx)
 bool vm_buf_is_inside_um_private(const struct user_mode_ctx *uctx,
 				 const void *va, size_t size)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = find_vm_region(&uctx->vm_info, (vaddr_t)va);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (r->flags & VM_FLAGS_NONPRIV)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
-			return true;
-	}
+	/* Regions don't overlap, only the one covering va can match */
+	if (!r || (r->flags & VM_FLAGS_NONPRIV))
+		return false;
 
-	return false;
+	return core_is_buffer_inside((vaddr_t)va, size, r->va, r->size);
 }
 
 /* return true only if buffer intersects TA private memory */
@@ -1095,7 +1319,11 @@ bool vm_buf_intersects_um_private(const struct user_mode_ctx *uctx,
 {
 	struct vm_region *r = NULL;
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
+	for (r = find_region_above(&uctx->vm_info, (vaddr_t)va); r;
+	     r = TAILQ_NEXT(r, link)) {
+		/* Regions are sorted, stop at the first one past the buffer */
+		if (r->va >= (vaddr_t)va && r->va - (vaddr_t)va >= size)
+			break;
 		if (r->attr & VM_FLAGS_NONPRIV)
 			continue;
 		if (core_is_buffer_intersect((vaddr_t)va, size, r->va, r->size))
@@ -1109,69 +1337,60 @@ TEE_Result vm_buf_to_mboj_offs(const struct user_mode_ctx *uctx,
 			       const void *va, size_t size,
 			       struct mobj **mobj, size_t *offs)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = find_vm_region(&uctx->vm_info, (vaddr_t)va);
+	size_t poffs = 0;
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (!r->mobj)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size)) {
-			size_t poffs;
+	if (!r || !r->mobj ||
+	    !core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
+		return TEE_ERROR_BAD_PARAMETERS;
 
-			poffs = mobj_get_phys_offs(r->mobj,
-						   CORE_MMU_USER_PARAM_SIZE);
-			*mobj = r->mobj;
-			*offs = (vaddr_t)va - r->va + r->offset - poffs;
-			return TEE_SUCCESS;
-		}
-	}
+	poffs = mobj_get_phys_offs(r->mobj, CORE_MMU_USER_PARAM_SIZE);
+	*mobj = r->mobj;
+	*offs = (vaddr_t)va - r->va + r->offset - poffs;
 
-	return TEE_ERROR_BAD_PARAMETERS;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_mmu_user_va2pa_attr(const struct user_mode_ctx *uctx,
 					  void *ua, paddr_t *pa, uint32_t *attr)
 {
-	struct vm_region *region = NULL;
+	struct vm_region *region = find_vm_region(&uctx->vm_info,
+						  (vaddr_t)ua);
 
-	TAILQ_FOREACH(region, &uctx->vm_info.regions, link) {
-		if (!core_is_buffer_inside((vaddr_t)ua, 1, region->va,
-					   region->size))
-			continue;
-
-		if (pa) {
-			TEE_Result res;
-			paddr_t p;
-			size_t offset;
-			size_t granule;
+	if (!region)
+		return TEE_ERROR_ACCESS_DENIED;
 
-			/*
-			 * mobj and input user address may each include
-			 * a specific offset-in-granule position.
-			 * Drop both to get target physical page base
-			 * address then apply only user address
-			 * offset-in-granule.
-			 * Mapping lowest granule is the small page.
-			 */
-			granule = MAX(region->mobj->phys_granule,
-				      (size_t)SMALL_PAGE_SIZE);
-			assert(!granule || IS_POWER_OF_TWO(granule));
+	if (pa) {
+		TEE_Result res;
+		paddr_t p;
+		size_t offset;
+		size_t granule;
 
-			offset = region->offset +
-				 ROUNDDOWN((vaddr_t)ua - region->va, granule);
+		/*
+		 * mobj and input user address may each include
+		 * a specific offset-in-granule position.
+		 * Drop both to get target physical page base
+		 * address then apply only user address
+		 * offset-in-granule.
+		 * Mapping lowest granule is the small page.
+		 */
+		granule = MAX(region->mobj->phys_granule,
+			      (size_t)SMALL_PAGE_SIZE);
+		assert(!granule || IS_POWER_OF_TWO(granule));
 
-			res = mobj_get_pa(region->mobj, offset, granule, &p);
-			if (res != TEE_SUCCESS)
-				return res;
+		offset = region->offset +
+			 ROUNDDOWN((vaddr_t)ua - region->va, granule);
 
-			*pa = p | ((vaddr_t)ua & (granule - 1));
-		}
-		if (attr)
-			*attr = region->attr;
+		res = mobj_get_pa(region->mobj, offset, granule, &p);
+		if (res != TEE_SUCCESS)
+			return res;
 
-		return TEE_SUCCESS;
+		*pa = p | ((vaddr_t)ua & (granule - 1));
 	}
+	if (attr)
+		*attr = region->attr;
 
-	return TEE_ERROR_ACCESS_DENIED;
+	return TEE_SUCCESS;
 }
 
 TEE_Result vm_va2pa(const struct user_mode_ctx *uctx, void *ua, paddr_t *pa)
@@ -1231,10 +1450,9 @@ TEE_Result vm_pa2va(const struct user_mode_ctx *uctx, paddr_t pa, void **va)
 TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 				  uint32_t flags, uaddr_t uaddr, size_t len)
 {
-	uaddr_t a = 0;
+	struct vm_region *r = NULL;
 	uaddr_t end_addr = 0;
-	size_t addr_incr = MIN(CORE_MMU_USER_CODE_SIZE,
-			       CORE_MMU_USER_PARAM_SIZE);
+	uaddr_t a = uaddr;
 
 	if (ADD_OVERFLOW(uaddr, len, &end_addr))
 		return TEE_ERROR_ACCESS_DENIED;
@@ -1251,26 +1469,36 @@ TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 	   !vm_buf_is_inside_um_private(uctx, (void *)uaddr, len))
 		return TEE_ERROR_ACCESS_DENIED;
 
-	for (a = ROUNDDOWN(uaddr, addr_incr); a < end_addr; a += addr_incr) {
-		uint32_t attr;
-		TEE_Result res;
-
-		res = tee_mmu_user_va2pa_attr(uctx, (void *)a, NULL, &attr);
-		if (res != TEE_SUCCESS)
-			return res;
+	/*
+	 * The attributes are the same for the whole region so each region
+	 * covering the range is checked once instead of each page. The
+	 * regions are sorted, the range must be covered without holes.
+	 */
+	while (a < end_addr) {
+		if (!r)
+			r = find_vm_region(&uctx->vm_info, a);
+		else
+			r = TAILQ_NEXT(r, link);
+		if (!r || a < r->va || a - r->va >= r->size)
+			return TEE_ERROR_ACCESS_DENIED;
 
 		if ((flags & TEE_MEMORY_ACCESS_NONSECURE) &&
-		    (attr & TEE_MATTR_SECURE))
+		    (r->attr & TEE_MATTR_SECURE))
 			return TEE_ERROR_ACCESS_DENIED;
 
 		if ((flags & TEE_MEMORY_ACCESS_SECURE) &&
-		    !(attr & TEE_MATTR_SECURE))
+		    !(r->attr & TEE_MATTR_SECURE))
 			return TEE_ERROR_ACCESS_DENIED;
 
-		if ((flags & TEE_MEMORY_ACCESS_WRITE) && !(attr & TEE_MATTR_UW))
+		if ((flags & TEE_MEMORY_ACCESS_WRITE) &&
+		    !(r->attr & TEE_MATTR_UW))
 			return TEE_ERROR_ACCESS_DENIED;
-		if ((flags & TEE_MEMORY_ACCESS_READ) && !(attr & TEE_MATTR_UR))
+		if ((flags & TEE_MEMORY_ACCESS_READ) &&
+		    !(r->attr & TEE_MATTR_UR))
 			return TEE_ERROR_ACCESS_DENIED;
+
+		if (ADD_OVERFLOW(r->va, r->size, &a))
+			break;
 	}
 
 	return TEE_SUCCESS;
@@ -1287,15 +1515,27 @@ void vm_set_ctx(struct ts_ctx *ctx)
 	 * This function has to be called before there's a chance that
 	 * pgt_free_unlocked() is called.
 	 *
-	 * Save translation tables in a cache if it's a user TA.
+	 * Save translation tables in a cache if it's a user TA, or park
+	 * them if the thread leaves the user TA for no other context.
 	 */
-	pgt_free(&tsd->pgt_cache, is_user_ta_ctx(tsd->ctx));
+	if (!ctx && is_user_ta_ctx(tsd->ctx))
+		pgt_park(&tsd->pgt_cache, tsd->ctx,
+			 to_user_mode_ctx(tsd->ctx)->vm_info.map_gen);
+	else
+		pgt_free(&tsd->pgt_cache, is_user_ta_ctx(tsd->ctx));
 
 	if (is_user_mode_ctx(ctx)) {
 		struct core_mmu_user_map map = { };
 		struct user_mode_ctx *uctx = to_user_mode_ctx(ctx);
 
-		core_mmu_create_user_map(uctx, &map);
+		/*
+		 * Entering the same TA again, the tables of its last
+		 * entry on this thread are still up to date.
+		 */
+		if (pgt_unpark(&tsd->pgt_cache, ctx, uctx->vm_info.map_gen))
+			core_mmu_reuse_user_map(uctx, &map);
+		else
+			core_mmu_create_user_map(uctx, &map);
 		core_mmu_set_user_map(&map);
 		tee_pager_assign_um_tables(uctx);
 	}
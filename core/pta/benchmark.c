@@ -4,6 +4,7 @@
  */
 #include <bench.h>
 #include <compiler.h>
+#include <keep.h>
 #include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
@@ -181,17 +182,14 @@ pseudo_ta_register(.uuid = BENCHMARK_UUID, .name = TA_NAME,
 		   .flags = PTA_DEFAULT_FLAGS,
 		   .invoke_command_entry_point = invoke_command);
 
-void bm_timestamp(void)
+/* @tp is 0 for the legacy cycle counter timestamps */
+static void bm_record(unsigned int tp, void *ret_addr)
 {
-	struct tee_ts_cpu_buf *cpu_buf;
-	struct tee_time_st ts_data;
-	uint64_t ts_i;
-	void *ret_addr;
-	uint32_t cur_cpu;
-	uint32_t exceptions;
-
-	if (!bench_ts_global)
-		return;
+	struct tee_ts_cpu_buf *cpu_buf = NULL;
+	struct tee_time_st ts_data = { };
+	uint32_t exceptions = 0;
+	uint32_t cur_cpu = 0;
+	uint64_t ts_i = 0;
 
 	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	cur_cpu = get_core_pos();
@@ -201,14 +199,36 @@ void bm_timestamp(void)
 		return;
 	}
 
-	ret_addr = __builtin_return_address(0);
+	if (tp) {
+		ts_data.cnt = barrier_read_cntpct();
+		ts_data.src = TEE_BENCH_TP_SRC(tp, cur_cpu);
+	} else {
+		ts_data.cnt = read_pmccntr() * TEE_BENCH_DIVIDER;
+		ts_data.src = TEE_BENCH_CORE;
+	}
+	ts_data.addr = (uintptr_t)ret_addr;
 
 	cpu_buf = &bench_ts_global->cpu_buf[cur_cpu];
 	ts_i = cpu_buf->head++;
-	ts_data.cnt = read_pmccntr() * TEE_BENCH_DIVIDER;
-	ts_data.addr = (uintptr_t)ret_addr;
-	ts_data.src = TEE_BENCH_CORE;
 	cpu_buf->stamps[ts_i & TEE_BENCH_MAX_MASK] = ts_data;
 
 	thread_unmask_exceptions(exceptions);
 }
+DECLARE_KEEP_PAGER(bm_record);
+
+void bm_timestamp(void)
+{
+	if (!bench_ts_global)
+		return;
+
+	bm_record(0, __builtin_return_address(0));
+}
+
+void bm_tracepoint(enum bench_tp tp)
+{
+	if (!bench_ts_global)
+		return;
+
+	bm_record(tp, __builtin_return_address(0));
+}
+DECLARE_KEEP_PAGER(bm_tracepoint);
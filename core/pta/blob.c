@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <drvcrypt_blob.h>
+#include <kernel/pseudo_ta.h>
+#include <kernel/ts_manager.h>
+#include <kernel/user_ta.h>
+#include <pta_blob.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <util.h>
+
+#define PTA_NAME "blob.pta"
+
+static TEE_Result blob_batch(uint32_t param_types,
+			     TEE_Param params[TEE_NUM_PARAMS], bool encaps)
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_INOUT,
+					  TEE_PARAM_TYPE_NONE);
+	struct drvcrypt_blob_data *data = NULL;
+	struct ts_session *s = ts_get_calling_session();
+	struct drvcrypt_buf *out = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *in_buf = NULL;
+	uint8_t *out_buf = NULL;
+	size_t in_len = 0;
+	size_t out_len = 0;
+	size_t size = 0;
+	size_t nb = 0;
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	nb = params[2].value.a;
+	if (!nb || params[0].memref.size % nb)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	in_buf = params[0].memref.buffer;
+	in_len = params[0].memref.size / nb;
+	out_buf = params[1].memref.buffer;
+	out_len = params[1].memref.size / nb;
+	if (!out_buf)
+		out_len = 0;
+
+	data = calloc(nb, sizeof(*data));
+	if (!data)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/* The UUID of the TA is the key modifier binding the blobs to it */
+	COMPILE_TIME_ASSERT(sizeof(s->ctx->uuid) ==
+			    DRVCRYPT_BLOB_KEY_MOD_SIZE);
+
+	for (n = 0; n < nb; n++) {
+		data[n].key_mod.data = (uint8_t *)&s->ctx->uuid;
+		data[n].key_mod.length = DRVCRYPT_BLOB_KEY_MOD_SIZE;
+		if (encaps) {
+			data[n].payload.data = in_buf + n * in_len;
+			data[n].payload.length = in_len;
+			out = &data[n].blob;
+		} else {
+			data[n].blob.data = in_buf + n * in_len;
+			data[n].blob.length = in_len;
+			out = &data[n].payload;
+		}
+		if (out_len)
+			out->data = out_buf + n * out_len;
+		out->length = out_len;
+	}
+
+	if (encaps)
+		res = drvcrypt_blob_encaps(data, nb);
+	else
+		res = drvcrypt_blob_decaps(data, nb);
+
+	/* All the elements have the same size, so have their outputs */
+	if (!res || res == TEE_ERROR_SHORT_BUFFER) {
+		if (encaps)
+			out = &data[0].blob;
+		else
+			out = &data[0].payload;
+
+		params[2].value.b = out->length;
+		if (res == TEE_ERROR_SHORT_BUFFER) {
+			if (MUL_OVERFLOW(out->length, nb, &size))
+				res = TEE_ERROR_OVERFLOW;
+			else
+				params[1].memref.size = size;
+		}
+	}
+
+	free(data);
+
+	return res;
+}
+
+static TEE_Result open_session(uint32_t param_types __unused,
+			       TEE_Param params[TEE_NUM_PARAMS] __unused,
+			       void **sess_ctx __unused)
+{
+	struct ts_session *s = NULL;
+
+	/* Check that we're called from a user TA */
+	s = ts_get_calling_session();
+	if (!s)
+		return TEE_ERROR_ACCESS_DENIED;
+	if (!is_user_ta_ctx(s->ctx))
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd_id) {
+	case PTA_BLOB_CMD_ENCAPS:
+		return blob_batch(param_types, params, true);
+	case PTA_BLOB_CMD_DECAPS:
+		return blob_batch(param_types, params, false);
+	default:
+		break;
+	}
+
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_BLOB_UUID, .name = PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .open_session_entry_point = open_session,
+		   .invoke_command_entry_point = invoke_command);
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * This pseudo TA controls the PMU sampling profiler and returns the
+ * samples to normal world.
+ */
+
+#include <kernel/linker.h>
+#include <kernel/pmu_profiler.h>
+#include <kernel/pseudo_ta.h>
+#include <pta_pmu_profiler.h>
+#include <util.h>
+
+#define PTA_NAME "pmu_profiler.pta"
+
+static TEE_Result start(uint32_t types, TEE_Param params[TEE_NUM_PARAMS])
+{
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return pmu_profiler_start(params[0].value.a, params[0].value.b);
+}
+
+static TEE_Result stop(uint32_t types)
+{
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pmu_profiler_stop();
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_samples(uint32_t types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct pmu_prof_sample *samples = NULL;
+	uint32_t dropped = 0;
+	size_t count = 0;
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	samples = params[0].memref.buffer;
+	if (!ALIGNMENT_IS_OK(samples, struct pmu_prof_sample))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = pmu_profiler_read(samples, params[0].memref.size /
+					   sizeof(*samples), &dropped);
+
+	params[0].memref.size = count * sizeof(*samples);
+	params[1].value.a = count;
+	params[1].value.b = dropped;
+	reg_pair_from_64(VCORE_START_VA, &params[2].value.a,
+			 &params[2].value.b);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result invoke_command(void *psess __unused,
+				 uint32_t cmd, uint32_t ptypes,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd) {
+	case PTA_PMU_PROFILER_CMD_START:
+		return start(ptypes, params);
+	case PTA_PMU_PROFILER_CMD_STOP:
+		return stop(ptypes);
+	case PTA_PMU_PROFILER_CMD_READ:
+		return read_samples(ptypes, params);
+	default:
+		break;
+	}
+
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_PMU_PROFILER_UUID, .name = PTA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
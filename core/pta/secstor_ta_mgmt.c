@@ -4,6 +4,7 @@
  */
 
 #include <kernel/pseudo_ta.h>
+#include <kernel/ts_store.h>
 #include <tee/tadb.h>
 #include <pta_secstor_ta_mgmt.h>
 #include <signed_hdr.h>
@@ -37,8 +38,13 @@ static TEE_Result check_install_conflict(const struct shdr_bootstrap_ta *bs_ta)
 	return res;
 }
 
-static TEE_Result install_ta(struct shdr *shdr, const uint8_t *nw,
-			     size_t nw_size)
+/*
+ * Writes the encrypted TA to a new file of the TA database, the TA is
+ * installed once committed with tee_tadb_ta_close_and_commit().
+ */
+static TEE_Result write_ta(struct shdr *shdr, const uint8_t *nw,
+			   size_t nw_size, struct tee_tadb_ta_write **ta_ret,
+			   TEE_UUID *uuid)
 {
 	TEE_Result res;
 	struct tee_tadb_ta_write *ta;
@@ -125,7 +131,9 @@ static TEE_Result install_ta(struct shdr *shdr, const uint8_t *nw,
 
 	crypto_hash_free_ctx(hash_ctx);
 	free(buf);
-	return tee_tadb_ta_close_and_commit(ta);
+	*ta_ret = ta;
+	*uuid = property.uuid;
+	return TEE_SUCCESS;
 
 err_ta_finalize:
 	tee_tadb_ta_close_and_delete(ta);
@@ -136,11 +144,31 @@ err:
 	return res;
 }
 
+static TEE_Result verify_and_write_ta(const void *nw, size_t nw_size,
+				      struct tee_tadb_ta_write **ta,
+				      TEE_UUID *uuid)
+{
+	TEE_Result res;
+	struct shdr *shdr;
+
+	shdr = shdr_alloc_and_copy(nw, nw_size);
+	if (!shdr)
+		return TEE_ERROR_SECURITY;
+
+	res = shdr_verify_signature(shdr);
+	if (!res)
+		res = write_ta(shdr, nw, nw_size, ta, uuid);
+
+	shdr_free(shdr);
+	return res;
+}
+
 static TEE_Result bootstrap(uint32_t param_types,
 			    TEE_Param params[TEE_NUM_PARAMS])
 {
 	TEE_Result res;
-	struct shdr *shdr;
+	struct tee_tadb_ta_write *ta;
+	TEE_UUID uuid;
 	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE,
@@ -149,17 +177,99 @@ static TEE_Result bootstrap(uint32_t param_types,
 	if (param_types != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	shdr = shdr_alloc_and_copy(params->memref.buffer, params->memref.size);
-	if (!shdr)
-		return TEE_ERROR_SECURITY;
-
-	res = shdr_verify_signature(shdr);
+	res = verify_and_write_ta(params->memref.buffer, params->memref.size,
+				  &ta, &uuid);
 	if (res)
+		return res;
+
+	res = tee_tadb_ta_close_and_commit(ta);
+	if (!res)
+		ree_fs_ta_cache_evict(&uuid);
+	return res;
+}
+
+static TEE_Result bootstrap_multi(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_tadb_ta_write **ta = NULL;
+	TEE_UUID *uuid = NULL;
+	const uint8_t *nw = params->memref.buffer;
+	size_t nw_size = params->memref.size;
+	size_t offs = 0;
+	size_t count = 0;
+	size_t end = 0;
+	uint32_t len = 0;
+	size_t n = 0;
+	void *p = NULL;
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	while (offs < nw_size) {
+		if (ADD_OVERFLOW(offs, sizeof(len), &end) || end > nw_size) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto err;
+		}
+		memcpy(&len, nw + offs, sizeof(len));
+		offs = end;
+		if (ADD_OVERFLOW(offs, len, &end) || end > nw_size) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto err;
+		}
+
+		p = realloc(ta, (count + 1) * sizeof(*ta));
+		if (!p) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto err;
+		}
+		ta = p;
+		p = realloc(uuid, (count + 1) * sizeof(*uuid));
+		if (!p) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto err;
+		}
+		uuid = p;
+
+		res = verify_and_write_ta(nw + offs, len, ta + count,
+					  uuid + count);
+		if (res)
+			goto err;
+		count++;
+
+		/* The downgrade check can't see the TAs not yet committed */
+		for (n = 0; n < count - 1; n++) {
+			if (!memcmp(uuid + n, uuid + count - 1,
+				    sizeof(*uuid))) {
+				res = TEE_ERROR_BAD_PARAMETERS;
+				goto err;
+			}
+		}
+
+		offs = ROUNDUP(end, sizeof(len));
+	}
+
+	if (!count) {
+		res = TEE_ERROR_BAD_PARAMETERS;
 		goto out;
+	}
 
-	res = install_ta(shdr, params->memref.buffer, params->memref.size);
+	res = tee_tadb_ta_close_and_commit_multi(ta, count);
+	if (!res)
+		for (n = 0; n < count; n++)
+			ree_fs_ta_cache_evict(uuid + n);
+	goto out;
+
+err:
+	for (n = 0; n < count; n++)
+		tee_tadb_ta_close_and_delete(ta[n]);
 out:
-	shdr_free(shdr);
+	free(ta);
+	free(uuid);
 	return res;
 }
 
@@ -170,6 +280,8 @@ static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 	switch (cmd_id) {
 	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP:
 		return bootstrap(param_types, params);
+	case PTA_SECSTOR_TA_MGMT_BOOTSTRAP_MULTI:
+		return bootstrap_multi(param_types, params);
 	default:
 		break;
 	}
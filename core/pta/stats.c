@@ -5,11 +5,24 @@
 #include <compiler.h>
 #include <stdio.h>
 #include <trace.h>
+#include <kernel/interrupt.h>
+#include <kernel/invoke_stats.h>
+#include <kernel/linker.h>
+#include <kernel/lock_stats.h>
+#include <kernel/malloc_prof.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/rpc_stats.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
+#include <kernel/user_mode_ctx.h>
+#include <mm/core_mmu.h>
+#include <mm/pgt_cache.h>
+#include <mm/slab.h>
 #include <mm/tee_pager.h>
 #include <mm/tee_mm.h>
 #include <string.h>
 #include <string_ext.h>
+#include <tee/uuid.h>
 #include <malloc.h>
 
 #define TA_NAME		"stats.ta"
@@ -21,9 +34,28 @@
 #define STATS_CMD_PAGER_STATS		0
 #define STATS_CMD_ALLOC_STATS		1
 #define STATS_CMD_MEMLEAK_STATS		2
+#define STATS_CMD_SLAB_STATS		3
+#define STATS_CMD_PGT_CACHE_STATS	4
+#define STATS_CMD_ASID_STATS		5
+#define STATS_CMD_TA_INVOKE_STATS	6
+#define STATS_CMD_LOCK_STATS		7
+#define STATS_CMD_RPC_STATS		8
+#define STATS_CMD_ITR_STATS		9
+#define STATS_CMD_STACK_STATS		10
+#define STATS_CMD_TA_MEM_STATS		11
+#define STATS_CMD_PAGER_FAULT_LOG	12
 
 #define STATS_NB_POOLS			4
 
+struct stats_slab_cache {
+	char desc[TEE_ALLOCATOR_DESC_LENGTH];
+	uint32_t obj_size;		/* Size of an object */
+	uint32_t num_objs;		/* Objects currently allocated */
+	uint32_t max_objs;		/* Tracks max value of num_objs */
+	uint32_t num_slabs;		/* Slabs currently allocated */
+	uint32_t num_alloc_fail;	/* Number of failed alloc requests */
+};
+
 static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct malloc_stats *stats;
@@ -101,18 +133,91 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_SUCCESS;
 }
 
+struct stats_pager_fault {
+	uint64_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint32_t hist[TEE_PAGER_FAULT_HIST_BUCKETS];
+};
+
+struct stats_pager_ta {
+	uint8_t uuid[16];
+	uint64_t evictions;
+};
+
+struct stats_pager {
+	uint64_t second_chances;
+	uint64_t ro_resident;
+	uint64_t rw_resident;
+	uint64_t hidden;
+	uint64_t read_ahead;
+	uint64_t ro_evictions;
+	uint64_t rw_evictions;
+	uint64_t maint_us;
+	/* Indexed by enum tee_pager_fault_type */
+	struct stats_pager_fault faults[TEE_PAGER_FAULT_TYPE_NUM];
+	/* Unused entries have no evictions */
+	struct stats_pager_ta ta[TEE_PAGER_STATS_MAX_TA];
+};
+
+static void fill_stats_pager(struct stats_pager *sp,
+			     struct tee_pager_stats *stats)
+{
+	size_t n = 0;
+
+	sp->second_chances = stats->second_chances;
+	sp->ro_resident = stats->ro_resident;
+	sp->rw_resident = stats->rw_resident;
+	sp->hidden = stats->hidden;
+	sp->read_ahead = stats->read_ahead;
+	sp->ro_evictions = stats->ro_evictions;
+	sp->rw_evictions = stats->rw_evictions;
+	sp->maint_us = stats->maint_us;
+
+	for (n = 0; n < ARRAY_SIZE(sp->faults); n++) {
+		sp->faults[n].count = stats->faults[n].count;
+		sp->faults[n].total_us = stats->faults[n].total_us;
+		sp->faults[n].max_us = stats->faults[n].max_us;
+		memcpy(sp->faults[n].hist, stats->faults[n].hist,
+		       sizeof(sp->faults[n].hist));
+	}
+
+	for (n = 0; n < ARRAY_SIZE(sp->ta); n++) {
+		tee_uuid_to_octets(sp->ta[n].uuid, &stats->ta[n].uuid);
+		sp->ta[n].evictions = stats->ta[n].evictions;
+	}
+}
+
 static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct tee_pager_stats stats;
+	struct stats_pager *sp = NULL;
+	uint32_t type3 = TEE_PARAM_TYPE_GET(type, 3);
 
+	/*
+	 * p[3] is optional, when supplied:
+	 * p[3].memref.buffer = output buffer to a struct stats_pager
+	 */
 	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_NONE) != type) {
+			    type3) != type ||
+	    (type3 != TEE_PARAM_TYPE_NONE &&
+	     type3 != TEE_PARAM_TYPE_MEMREF_OUTPUT)) {
 		EMSG("expect 3 output values as argument");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
+	if (type3 == TEE_PARAM_TYPE_MEMREF_OUTPUT) {
+		sp = p[3].memref.buffer;
+		if (p[3].memref.size < sizeof(*sp)) {
+			p[3].memref.size = sizeof(*sp);
+			return TEE_ERROR_SHORT_BUFFER;
+		}
+		if (!ALIGNMENT_IS_OK(sp, struct stats_pager))
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+
 	tee_pager_get_stats(&stats);
 	p[0].value.a = stats.npages;
 	p[0].value.b = stats.npages_all;
@@ -121,12 +226,114 @@ static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	p[2].value.a = stats.hidden_hits;
 	p[2].value.b = stats.zi_released;
 
+	if (sp) {
+		fill_stats_pager(sp, &stats);
+		p[3].memref.size = sizeof(*sp);
+	}
+
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_CORE_MALLOC_PROFILE
+struct stats_malloc_site {
+	uint64_t site;			/* Return address of the caller */
+	uint32_t allocs;
+	uint32_t live_count;		/* Buffers currently allocated */
+	uint64_t live_bytes;		/* Bytes currently allocated */
+	uint64_t peak_bytes;		/* Tracks max value of live_bytes */
+};
+
+struct stats_malloc_ta {
+	TEE_UUID uuid;
+	uint32_t allocs;
+	uint32_t reserved;
+	uint64_t live_bytes;
+	uint64_t peak_bytes;
+};
+
+static TEE_Result get_malloc_profile(TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_malloc_site *site_stats = p[0].memref.buffer;
+	struct stats_malloc_ta *ta_stats = p[1].memref.buffer;
+	TEE_Result res = TEE_SUCCESS;
+	struct malloc_prof_site *sites = NULL;
+	struct malloc_prof_ta *tas = NULL;
+	size_t num_sites = 0;
+	size_t num_tas = 0;
+	uint32_t untracked = 0;
+	size_t n = 0;
+
+	if (!ALIGNMENT_IS_OK(site_stats, struct stats_malloc_site) ||
+	    !ALIGNMENT_IS_OK(ta_stats, struct stats_malloc_ta))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	sites = calloc(CFG_CORE_MALLOC_PROFILE_SITES, sizeof(*sites));
+	tas = calloc(MALLOC_PROF_MAX_TAS, sizeof(*tas));
+	if (!sites || !tas) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	num_sites = malloc_prof_get_sites(sites, CFG_CORE_MALLOC_PROFILE_SITES,
+					  &untracked);
+	num_tas = malloc_prof_get_tas(tas, MALLOC_PROF_MAX_TAS);
+	if (p[0].memref.size < num_sites * sizeof(*site_stats) ||
+	    p[1].memref.size < num_tas * sizeof(*ta_stats)) {
+		p[0].memref.size = num_sites * sizeof(*site_stats);
+		p[1].memref.size = num_tas * sizeof(*ta_stats);
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	for (n = 0; n < num_sites; n++) {
+		site_stats[n].site = sites[n].site;
+		site_stats[n].allocs = sites[n].allocs;
+		site_stats[n].live_count = sites[n].live_count;
+		site_stats[n].live_bytes = sites[n].live_bytes;
+		site_stats[n].peak_bytes = sites[n].peak_bytes;
+	}
+	for (n = 0; n < num_tas; n++) {
+		memset(ta_stats + n, 0, sizeof(*ta_stats));
+		ta_stats[n].uuid = tas[n].uuid;
+		ta_stats[n].allocs = tas[n].allocs;
+		ta_stats[n].live_bytes = tas[n].live_bytes;
+		ta_stats[n].peak_bytes = tas[n].peak_bytes;
+	}
+	p[0].memref.size = num_sites * sizeof(*site_stats);
+	p[1].memref.size = num_tas * sizeof(*ta_stats);
+	p[3].value.a = untracked;
+	p[3].value.b = VCORE_START_VA;
+
+	if (p[2].value.a)
+		malloc_prof_reset();
+out:
+	free(sites);
+	free(tas);
+
+	return res;
+}
+#endif
+
 static TEE_Result get_memleak_stats(uint32_t type,
-				    TEE_Param p[TEE_NUM_PARAMS] __unused)
+				    TEE_Param p[TEE_NUM_PARAMS] __maybe_unused)
 {
+#ifdef CFG_CORE_MALLOC_PROFILE
+	/*
+	 * Heap profile instead of a dump of the leaks:
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_malloc_site
+	 * p[1].memref.buffer = output buffer to an array of
+	 *			struct stats_malloc_ta
+	 * p[2].value.a = 0 if no reset of the allocation counts and peaks
+	 * p[3].value.a = number of allocations which couldn't be tracked
+	 * p[3].value.b = load address of the TEE core, for symbolization
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) == type)
+		return get_malloc_profile(p);
+#endif
 
 	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE,
 			    TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE) != type)
@@ -137,6 +344,570 @@ static TEE_Result get_memleak_stats(uint32_t type,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result get_slab_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	const struct slab_cache_ref *ref = NULL;
+	struct stats_slab_cache *stats = NULL;
+	struct slab_cache_stats s = { };
+	size_t size_to_retrieve = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_slab_cache, one per slab cache
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for_each_slab_cache(ref)
+		size_to_retrieve += sizeof(*stats);
+
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = size_to_retrieve;
+	stats = p[0].memref.buffer;
+
+	for_each_slab_cache(ref) {
+		slab_cache_get_stats(ref->sc, &s);
+		strlcpy(stats->desc, ref->sc->name, sizeof(stats->desc));
+		stats->obj_size = ref->sc->obj_size;
+		stats->num_objs = s.num_objs;
+		stats->max_objs = s.max_objs;
+		stats->num_slabs = s.num_slabs;
+		stats->num_alloc_fail = s.num_alloc_fail;
+		stats++;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pgt_cache_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pgt_cache_stats stats = { };
+
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].value.a = hits, p[1].value.b = misses
+	 * p[2].value.a = evictions, p[2].value.b = saved tables
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pgt_get_cache_stats(&stats, p[0].value.a);
+	p[1].value.a = stats.hits;
+	p[1].value.b = stats.misses;
+	p[2].value.a = stats.evictions;
+	p[2].value.b = stats.num_saved;
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_TA_INVOKE_STATS
+struct stats_ta_invoke {
+	TEE_UUID uuid;
+	uint32_t cmd;
+	uint32_t count;
+	uint64_t total_us;		/* Cumulated duration */
+	uint64_t rpc_us;		/* Time spent in RPC */
+	uint64_t busy_wait_us;		/* Time waiting for a busy TA */
+	uint32_t p50_us;		/* Median duration estimate */
+	uint32_t p99_us;		/* 99th percentile duration estimate */
+	uint32_t hist[INVOKE_STATS_HIST_BUCKETS];
+};
+
+static TEE_Result get_ta_invoke_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_ta_invoke *stats = NULL;
+	struct invoke_stats *s = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_ta_invoke, one per TA command
+	 * p[1].value.a = 0 if no reset of the stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	s = calloc(CFG_TA_INVOKE_STATS_ENTRIES, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	count = invoke_stats_get(s, CFG_TA_INVOKE_STATS_ENTRIES, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		free(s);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (p[1].value.a)
+		count = invoke_stats_get(s, CFG_TA_INVOKE_STATS_ENTRIES, true);
+
+	p[0].memref.size = count * sizeof(*stats);
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		stats->uuid = s[n].uuid;
+		stats->cmd = s[n].cmd;
+		stats->count = s[n].count;
+		stats->total_us = s[n].total_us;
+		stats->rpc_us = s[n].rpc_us;
+		stats->busy_wait_us = s[n].busy_wait_us;
+		stats->p50_us = invoke_stats_percentile(s + n, 50);
+		stats->p99_us = invoke_stats_percentile(s + n, 99);
+		memcpy(stats->hist, s[n].hist, sizeof(stats->hist));
+	}
+
+	free(s);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#if defined(CFG_LOCK_STATS) || defined(CFG_ITR_STATS)
+static uint64_t cnt2us(uint64_t cnt)
+{
+	return cnt * 1000000 / read_cntfrq();
+}
+#endif
+
+#ifdef CFG_LOCK_STATS
+#define STATS_LOCK_NAME_LEN		16
+
+struct stats_lock {
+	char name[STATS_LOCK_NAME_LEN];
+	uint64_t acquired;
+	uint64_t contended;
+	uint64_t sleeps;		/* Sleeps in normal world (mutexes) */
+	uint64_t wait_total_us;		/* Cumulated waiting time */
+	uint64_t wait_max_us;		/* Longest waiting time */
+};
+
+static TEE_Result get_lock_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_lock *stats = NULL;
+	struct lock_stats *s = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_lock, one per named lock
+	 * p[1].value.a = 0 if no reset of the stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = lock_stats_get(NULL, 0, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = 0;
+	if (!count)
+		return TEE_SUCCESS;
+
+	s = calloc(count, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/* Locks registered meanwhile are left for the next call */
+	count = MIN(lock_stats_get(s, count, p[1].value.a), count);
+
+	p[0].memref.size = count * sizeof(*stats);
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		strlcpy(stats->name, s[n].name, sizeof(stats->name));
+		stats->acquired = s[n].acquired;
+		stats->contended = s[n].contended;
+		stats->sleeps = s[n].sleeps;
+		stats->wait_total_us = cnt2us(s[n].wait_total_cnt);
+		stats->wait_max_us = cnt2us(s[n].wait_max_cnt);
+	}
+
+	free(s);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_RPC_STATS
+struct stats_rpc {
+	TEE_UUID uuid;			/* Nil UUID outside of sessions */
+	uint32_t cmd;			/* OPTEE_RPC_CMD_* */
+	uint32_t count;
+	uint32_t failed;		/* RPCs not returning TEE_SUCCESS */
+	uint32_t reserved;
+	uint64_t bytes;			/* Size of the memory references */
+	uint64_t total_us;		/* Cumulated duration */
+	uint64_t max_us;		/* Longest RPC */
+	uint32_t hist[RPC_STATS_HIST_BUCKETS];
+};
+
+static TEE_Result get_rpc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_rpc *stats = NULL;
+	struct rpc_stats *s = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_rpc, one per TA and RPC command
+	 * p[1].value.a = 0 if no reset of the stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	s = calloc(CFG_RPC_STATS_ENTRIES, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	count = rpc_stats_get(s, CFG_RPC_STATS_ENTRIES, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		free(s);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (p[1].value.a)
+		count = rpc_stats_get(s, CFG_RPC_STATS_ENTRIES, true);
+
+	p[0].memref.size = count * sizeof(*stats);
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		memset(stats, 0, sizeof(*stats));
+		stats->uuid = s[n].uuid;
+		stats->cmd = s[n].cmd;
+		stats->count = s[n].count;
+		stats->failed = s[n].failed;
+		stats->bytes = s[n].bytes;
+		stats->total_us = s[n].total_us;
+		stats->max_us = s[n].max_us;
+		memcpy(stats->hist, s[n].hist, sizeof(stats->hist));
+	}
+
+	free(s);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_ITR_STATS
+struct stats_itr {
+	uint32_t it;
+	uint32_t reserved;
+	uint64_t count;			/* Interrupts handled */
+	uint64_t time_total_us;		/* Cumulated handling time */
+	uint64_t time_max_us;		/* Longest handling time */
+};
+
+static TEE_Result get_itr_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_itr *stats = NULL;
+	struct itr_stats *s = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_itr, one per interrupt handler
+	 * p[1].value.a = 0 if no reset of the stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = itr_stats_get(NULL, 0, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = 0;
+	if (!count)
+		return TEE_SUCCESS;
+
+	s = calloc(count, sizeof(*s));
+	if (!s)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	count = MIN(itr_stats_get(s, count, p[1].value.a), count);
+
+	p[0].memref.size = count * sizeof(*stats);
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		memset(stats, 0, sizeof(*stats));
+		stats->it = s[n].it;
+		stats->count = s[n].count;
+		stats->time_total_us = cnt2us(s[n].time_total_cnt);
+		stats->time_max_us = cnt2us(s[n].time_max_cnt);
+	}
+
+	free(s);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_CORE_DEBUG_CHECK_STACKS
+struct stats_stack {
+	uint32_t type;			/* 0: tmp, 1: abort, 2: thread */
+	uint32_t index;			/* Core position or thread id */
+	uint32_t size;			/* Usable size of the stack */
+	uint32_t max_used;		/* Deepest use seen */
+};
+
+static TEE_Result get_stack_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_stack_usage *u = NULL;
+	struct stats_stack *stats = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_stack, one per stack
+	 * p[1].value.a = 0 if no reset of the stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = thread_get_stack_usage(NULL, 0, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	u = calloc(count, sizeof(*u));
+	if (!u)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	count = thread_get_stack_usage(u, count, p[1].value.a);
+
+	p[0].memref.size = count * sizeof(*stats);
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		memset(stats, 0, sizeof(*stats));
+		stats->type = u[n].type;
+		stats->index = u[n].index;
+		stats->size = u[n].size;
+		stats->max_used = u[n].max_used;
+	}
+
+	free(u);
+
+	return TEE_SUCCESS;
+}
+#endif
+
+#ifdef CFG_CORE_MMU_LAZY_TLBI
+static TEE_Result get_asid_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct asid_stats stats = { };
+
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].value.a = user map switches, p[1].value.b = TLB flushes
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	asid_get_stats(&stats, p[0].value.a);
+	p[1].value.a = stats.switches;
+	p[1].value.b = stats.flushes;
+
+	return TEE_SUCCESS;
+}
+#endif
+
+struct stats_ta_mem {
+	TEE_UUID uuid;
+	uint32_t num_ctx;		/* Contexts (instances) of the TA */
+	uint32_t num_pgts;		/* Translation tables needed */
+	uint64_t priv_size;		/* Code, data, heap and stacks */
+	uint64_t nonpriv_size;		/* Parameters and shared memory */
+	uint64_t paged_size;		/* Part backed by the pager */
+	uint64_t max_ctx_priv_size;	/* Largest priv_size of a context */
+};
+
+static void add_ta_mem(struct stats_ta_mem *st, size_t *count,
+		       struct ts_ctx *ctx)
+{
+	struct vm_info *vmi = &to_user_mode_ctx(ctx)->vm_info;
+	struct stats_ta_mem *s = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < *count; n++)
+		if (!memcmp(&st[n].uuid, &ctx->uuid, sizeof(ctx->uuid)))
+			break;
+	s = st + n;
+	if (n == *count) {
+		s->uuid = ctx->uuid;
+		(*count)++;
+	}
+
+	s->num_ctx++;
+	s->num_pgts += vmi->num_pgts;
+	s->priv_size += vmi->priv_size;
+	s->nonpriv_size += vmi->nonpriv_size;
+	s->paged_size += vmi->paged_size;
+	s->max_ctx_priv_size = MAX(s->max_ctx_priv_size,
+				   (uint64_t)vmi->priv_size);
+}
+
+static TEE_Result get_ta_mem_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct stats_ta_mem *st = NULL;
+	struct tee_ta_ctx *ctx = NULL;
+	size_t size_to_retrieve = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_ta_mem, one per TA UUID
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/*
+	 * The sizes are updated by the contexts as they map and unmap
+	 * memory, they're only read here so a snapshot of a running TA
+	 * may be slightly off.
+	 */
+	mutex_lock(&tee_ta_mutex);
+	TAILQ_FOREACH(ctx, &tee_ctxes, link)
+		n++;
+	if (n)
+		st = calloc(n, sizeof(*st));
+	if (n && !st) {
+		mutex_unlock(&tee_ta_mutex);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	TAILQ_FOREACH(ctx, &tee_ctxes, link)
+		if (is_user_mode_ctx(&ctx->ts_ctx))
+			add_ta_mem(st, &count, &ctx->ts_ctx);
+	mutex_unlock(&tee_ta_mutex);
+
+	size_to_retrieve = count * sizeof(*st);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		free(st);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	p[0].memref.size = size_to_retrieve;
+	if (count)
+		memcpy(p[0].memref.buffer, st, size_to_retrieve);
+	free(st);
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_CORE_PAGER_FAULT_LOG
+struct stats_pager_fault_rec {
+	uint64_t va;			/* Link address in tee.elf */
+	uint32_t count;
+	uint32_t reserved;
+};
+
+static TEE_Result get_pager_fault_log(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pager_fault_rec *recs = NULL;
+	struct stats_pager_fault_rec *stats = NULL;
+	size_t size_to_retrieve = 0;
+	uint32_t dropped = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to an array of
+	 *			struct stats_pager_fault_rec
+	 * p[1].value.a = 0 if no reset of the log
+	 * p[2].value.a = faults not counted because the log was full
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	recs = calloc(CFG_CORE_PAGER_FAULT_LOG_ENTRIES, sizeof(*recs));
+	if (!recs)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	count = tee_pager_get_fault_log(recs, CFG_CORE_PAGER_FAULT_LOG_ENTRIES,
+					&dropped, false);
+	size_to_retrieve = count * sizeof(*stats);
+	if (p[0].memref.size < size_to_retrieve) {
+		p[0].memref.size = size_to_retrieve;
+		free(recs);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (p[1].value.a)
+		count = tee_pager_get_fault_log(recs,
+						CFG_CORE_PAGER_FAULT_LOG_ENTRIES,
+						&dropped, true);
+
+	p[0].memref.size = count * sizeof(*stats);
+	p[2].value.a = dropped;
+	stats = p[0].memref.buffer;
+
+	for (n = 0; n < count; n++, stats++) {
+		memset(stats, 0, sizeof(*stats));
+		stats->va = recs[n].va;
+		stats->count = recs[n].count;
+	}
+
+	free(recs);
+
+	return TEE_SUCCESS;
+}
+#endif
+
 /*
  * Trusted Application Entry Points
  */
@@ -152,6 +923,40 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_alloc_stats(ptypes, params);
 	case STATS_CMD_MEMLEAK_STATS:
 		return get_memleak_stats(ptypes, params);
+	case STATS_CMD_SLAB_STATS:
+		return get_slab_stats(ptypes, params);
+	case STATS_CMD_PGT_CACHE_STATS:
+		return get_pgt_cache_stats(ptypes, params);
+#ifdef CFG_CORE_MMU_LAZY_TLBI
+	case STATS_CMD_ASID_STATS:
+		return get_asid_stats(ptypes, params);
+#endif
+#ifdef CFG_TA_INVOKE_STATS
+	case STATS_CMD_TA_INVOKE_STATS:
+		return get_ta_invoke_stats(ptypes, params);
+#endif
+#ifdef CFG_LOCK_STATS
+	case STATS_CMD_LOCK_STATS:
+		return get_lock_stats(ptypes, params);
+#endif
+#ifdef CFG_RPC_STATS
+	case STATS_CMD_RPC_STATS:
+		return get_rpc_stats(ptypes, params);
+#endif
+#ifdef CFG_ITR_STATS
+	case STATS_CMD_ITR_STATS:
+		return get_itr_stats(ptypes, params);
+#endif
+#ifdef CFG_CORE_DEBUG_CHECK_STACKS
+	case STATS_CMD_STACK_STATS:
+		return get_stack_stats(ptypes, params);
+#endif
+	case STATS_CMD_TA_MEM_STATS:
+		return get_ta_mem_stats(ptypes, params);
+#ifdef CFG_CORE_PAGER_FAULT_LOG
+	case STATS_CMD_PAGER_FAULT_LOG:
+		return get_pager_fault_log(ptypes, params);
+#endif
 	default:
 		break;
 	}
@@ -8,7 +8,9 @@ ifeq ($(CFG_WITH_USER_TA),y)
 srcs-$(CFG_SECSTOR_TA_MGMT_PTA) += secstor_ta_mgmt.c
 endif
 srcs-$(CFG_WITH_STATS) += stats.c
+srcs-$(CFG_CORE_PMU_PROFILER) += pmu_profiler.c
 srcs-$(CFG_SYSTEM_PTA) += system.c
 srcs-$(CFG_NXP_SE05X) += scp03.c
+srcs-$(CFG_CRYPTO_DRV_BLOB) += blob.c
 
 subdirs-y += bcm
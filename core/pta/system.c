@@ -119,19 +119,18 @@ static TEE_Result system_map_zi(struct user_mode_ctx *uctx,
 					  TEE_PARAM_TYPE_VALUE_INOUT,
 					  TEE_PARAM_TYPE_VALUE_INPUT,
 					  TEE_PARAM_TYPE_NONE);
-	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_PRW;
+	uint32_t accept_flags = PTA_SYSTEM_MAP_FLAG_SHAREABLE |
+				PTA_SYSTEM_MAP_FLAG_BLOCK_MAPPED;
 	TEE_Result res = TEE_ERROR_GENERIC;
-	struct mobj *mobj = NULL;
 	uint32_t pad_begin = 0;
 	uint32_t vm_flags = 0;
-	struct fobj *f = NULL;
 	uint32_t pad_end = 0;
 	size_t num_bytes = 0;
 	vaddr_t va = 0;
 
 	if (exp_pt != param_types)
 		return TEE_ERROR_BAD_PARAMETERS;
-	if (params[0].value.b & ~PTA_SYSTEM_MAP_FLAG_SHAREABLE)
+	if (params[0].value.b & ~accept_flags)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	if (params[0].value.b & PTA_SYSTEM_MAP_FLAG_SHAREABLE)
@@ -142,16 +141,8 @@ static TEE_Result system_map_zi(struct user_mode_ctx *uctx,
 	pad_begin = params[2].value.a;
 	pad_end = params[2].value.b;
 
-	f = fobj_ta_mem_alloc(ROUNDUP_DIV(num_bytes, SMALL_PAGE_SIZE));
-	if (!f)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	mobj = mobj_with_fobj_alloc(f, NULL);
-	fobj_put(f);
-	if (!mobj)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = vm_map_pad(uctx, &va, num_bytes, prot, vm_flags,
-			 mobj, 0, pad_begin, pad_end, 0);
-	mobj_put(mobj);
+	res = vm_map_zi(uctx, &va, num_bytes, vm_flags, pad_begin, pad_end,
+			params[0].value.b & PTA_SYSTEM_MAP_FLAG_BLOCK_MAPPED);
 	if (!res)
 		reg_pair_from_64(va, &params[1].value.a, &params[1].value.b);
 
@@ -263,6 +254,48 @@ static TEE_Result system_dlsym(struct user_mode_ctx *uctx, uint32_t param_types,
 	return res;
 }
 
+static TEE_Result system_dlsym_table(struct user_mode_ctx *uctx,
+				     uint32_t param_types,
+				     TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct ts_session *s = NULL;
+	const char *names = NULL;
+	TEE_UUID *uuid = NULL;
+	uint64_t *vals = NULL;
+	size_t names_len = 0;
+	size_t vals_size = 0;
+	size_t sz = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	uuid = params[0].memref.buffer;
+	if (!uuid || params[0].memref.size != sizeof(*uuid))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	names = params[1].memref.buffer;
+	names_len = params[1].memref.size;
+	vals = params[2].memref.buffer;
+	vals_size = params[2].memref.size;
+	if (!names || !vals || !ALIGNMENT_IS_OK(vals, uint64_t) ||
+	    vals_size % sizeof(*vals) ||
+	    ADD_OVERFLOW(names_len, vals_size, &sz) ||
+	    sz > PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	s = ts_pop_current_session();
+	res = ldelf_dlsym_table(uctx, uuid, names, names_len,
+				vals_size / sizeof(*vals), vals);
+	ts_push_current_session(s);
+
+	return res;
+}
+
 static TEE_Result system_get_tpm_event_log(uint32_t param_types,
 					   TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -319,6 +352,8 @@ static TEE_Result invoke_command(void *sess_ctx __unused, uint32_t cmd_id,
 		return system_dlopen(uctx, param_types, params);
 	case PTA_SYSTEM_DLSYM:
 		return system_dlsym(uctx, param_types, params);
+	case PTA_SYSTEM_DLSYM_TABLE:
+		return system_dlsym_table(uctx, param_types, params);
 	case PTA_SYSTEM_GET_TPM_EVENT_LOG:
 		return system_get_tpm_event_log(param_types, params);
 	default:
@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <crypto/crypto.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "misc.h"
+
+/*
+ * As in aes_perf.c the values of the keys and IV don't matter, only their
+ * sizes do.
+ */
+static const uint8_t perf_key[] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+	0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F
+};
+
+static const uint8_t perf_iv[] = {
+	0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF
+};
+
+#define PERF_MAX_DIGEST_SIZE	TEE_SHA512_HASH_SIZE
+
+/*
+ * struct perf_op - one benchmarked operation
+ * @algo:	TEE_ALG_* or PTA_INVOKE_TESTS_CRYPTO_PERF_RNG
+ * @key_len:	Key size in bytes
+ * @unit_size:	Number of bytes passed to each update
+ * @buf:	Data, also receives the output of ciphers
+ * @len:	Size of @buf
+ */
+struct perf_op {
+	uint32_t algo;
+	size_t key_len;
+	size_t unit_size;
+	uint8_t *buf;
+	size_t len;
+};
+
+static TEE_Result perf_hash(void *ctx, struct perf_op *op)
+{
+	uint8_t digest[PERF_MAX_DIGEST_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	res = crypto_hash_init(ctx);
+	for (n = 0; !res && n < op->len; n += op->unit_size)
+		res = crypto_hash_update(ctx, op->buf + n,
+					 MIN(op->unit_size, op->len - n));
+	if (!res)
+		res = crypto_hash_final(ctx, digest, sizeof(digest));
+
+	return res;
+}
+
+static TEE_Result perf_mac(void *ctx, struct perf_op *op)
+{
+	uint8_t digest[PERF_MAX_DIGEST_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	res = crypto_mac_init(ctx, perf_key, op->key_len);
+	for (n = 0; !res && n < op->len; n += op->unit_size)
+		res = crypto_mac_update(ctx, op->buf + n,
+					MIN(op->unit_size, op->len - n));
+	if (!res)
+		res = crypto_mac_final(ctx, digest, sizeof(digest));
+
+	return res;
+}
+
+static TEE_Result perf_cipher(void *ctx, struct perf_op *op)
+{
+	TEE_Result res = TEE_SUCCESS;
+	const uint8_t *key2 = NULL;
+	size_t key2_len = 0;
+	size_t iv_len = 0;
+	size_t n = 0;
+
+	switch (TEE_ALG_GET_MAIN_ALG(op->algo)) {
+	case TEE_MAIN_ALGO_DES:
+	case TEE_MAIN_ALGO_DES3:
+		iv_len = 8;
+		break;
+	default:
+		iv_len = sizeof(perf_iv);
+		break;
+	}
+	if (op->algo == TEE_ALG_AES_XTS) {
+		key2 = perf_key + sizeof(perf_key) - op->key_len;
+		key2_len = op->key_len;
+	}
+
+	res = crypto_cipher_init(ctx, TEE_MODE_ENCRYPT, perf_key, op->key_len,
+				 key2, key2_len, perf_iv, iv_len);
+	for (n = 0; !res && n < op->len; n += op->unit_size)
+		res = crypto_cipher_update(ctx, TEE_MODE_ENCRYPT,
+					   n + op->unit_size >= op->len,
+					   op->buf + n,
+					   MIN(op->unit_size, op->len - n),
+					   op->buf + n);
+	crypto_cipher_final(ctx);
+
+	return res;
+}
+
+static TEE_Result perf_authenc(void *ctx, struct perf_op *op)
+{
+	uint8_t tag[TEE_AES_BLOCK_SIZE] = { };
+	size_t tag_len = sizeof(tag);
+	TEE_Result res = TEE_SUCCESS;
+	size_t nonce_len = 12;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	if (op->algo == TEE_ALG_AES_CCM)
+		nonce_len = 13;
+
+	res = crypto_authenc_init(ctx, TEE_MODE_ENCRYPT, perf_key, op->key_len,
+				  perf_iv, nonce_len, tag_len, 0, op->len);
+	for (n = 0; !res && n + op->unit_size < op->len; n += op->unit_size) {
+		dlen = op->unit_size;
+		res = crypto_authenc_update_payload(ctx, TEE_MODE_ENCRYPT,
+						    op->buf + n, dlen,
+						    op->buf + n, &dlen);
+	}
+	if (!res) {
+		dlen = op->len - n;
+		res = crypto_authenc_enc_final(ctx, op->buf + n, dlen,
+					       op->buf + n, &dlen, tag,
+					       &tag_len);
+	}
+	crypto_authenc_final(ctx);
+
+	return res;
+}
+
+static uint32_t ecc_curve(uint32_t algo)
+{
+	switch (algo) {
+	case TEE_ALG_ECDSA_P192:
+		return TEE_ECC_CURVE_NIST_P192;
+	case TEE_ALG_ECDSA_P224:
+		return TEE_ECC_CURVE_NIST_P224;
+	case TEE_ALG_ECDSA_P256:
+		return TEE_ECC_CURVE_NIST_P256;
+	case TEE_ALG_ECDSA_P384:
+		return TEE_ECC_CURVE_NIST_P384;
+	case TEE_ALG_ECDSA_P521:
+		return TEE_ECC_CURVE_NIST_P521;
+	default:
+		return 0;
+	}
+}
+
+static TEE_Result perf_sign(void *key, struct perf_op *op)
+{
+	size_t digest_len = MIN(op->len, (size_t)TEE_SHA256_HASH_SIZE);
+	size_t sig_len = op->len - digest_len;
+	uint8_t *sig = op->buf + digest_len;
+
+	/* The digest is followed by room for the signature in the buffer */
+	if (TEE_ALG_GET_MAIN_ALG(op->algo) == TEE_MAIN_ALGO_RSA)
+		return crypto_acipher_rsassa_sign(op->algo, key, -1, op->buf,
+						  digest_len, sig, &sig_len);
+
+	return crypto_acipher_ecc_sign(op->algo, key, op->buf, digest_len,
+				       sig, &sig_len);
+}
+
+static TEE_Result perf_rng(void *ctx __unused, struct perf_op *op)
+{
+	return crypto_rng_read(op->buf, op->len);
+}
+
+static void free_sign_key(void *key, uint32_t algo)
+{
+	struct ecc_keypair *ecc = key;
+
+	if (!key)
+		return;
+
+	if (TEE_ALG_GET_MAIN_ALG(algo) == TEE_MAIN_ALGO_RSA) {
+		crypto_acipher_free_rsa_keypair(key);
+	} else {
+		crypto_bignum_free(ecc->d);
+		crypto_bignum_free(ecc->x);
+		crypto_bignum_free(ecc->y);
+	}
+	free(key);
+}
+
+static TEE_Result alloc_sign_key(void **key_ret, uint32_t algo,
+				 size_t key_size_bits)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct ecc_keypair *ecc = NULL;
+	struct rsa_keypair *rsa = NULL;
+
+	if (TEE_ALG_GET_MAIN_ALG(algo) == TEE_MAIN_ALGO_RSA) {
+		rsa = calloc(1, sizeof(*rsa));
+		if (!rsa)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		*key_ret = rsa;
+		res = crypto_acipher_alloc_rsa_keypair(rsa, key_size_bits);
+		if (!res)
+			res = crypto_acipher_gen_rsa_key(rsa, key_size_bits);
+		return res;
+	}
+
+	if (!ecc_curve(algo))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	ecc = calloc(1, sizeof(*ecc));
+	if (!ecc)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	*key_ret = ecc;
+	res = crypto_acipher_alloc_ecc_keypair(ecc, TEE_TYPE_ECDSA_KEYPAIR,
+					       key_size_bits);
+	if (!res) {
+		ecc->curve = ecc_curve(algo);
+		res = crypto_acipher_gen_ecc_key(ecc, key_size_bits);
+	}
+
+	return res;
+}
+
+static TEE_Result run_perf(struct perf_op *op, unsigned int rep_count,
+			   size_t key_size_bits, uint32_t *elapsed_ms)
+{
+	TEE_Result (*perf_func)(void *ctx, struct perf_op *op) = NULL;
+	void (*free_func)(void *ctx) = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	TEE_Time t = { };
+	void *ctx = NULL;
+	unsigned int n = 0;
+
+	if (op->algo == PTA_INVOKE_TESTS_CRYPTO_PERF_RNG) {
+		perf_func = perf_rng;
+		goto run;
+	}
+
+	switch (TEE_ALG_GET_CLASS(op->algo)) {
+	case TEE_OPERATION_DIGEST:
+		res = crypto_hash_alloc_ctx(&ctx, op->algo);
+		perf_func = perf_hash;
+		free_func = crypto_hash_free_ctx;
+		break;
+	case TEE_OPERATION_MAC:
+		res = crypto_mac_alloc_ctx(&ctx, op->algo);
+		perf_func = perf_mac;
+		free_func = crypto_mac_free_ctx;
+		break;
+	case TEE_OPERATION_CIPHER:
+		res = crypto_cipher_alloc_ctx(&ctx, op->algo);
+		perf_func = perf_cipher;
+		free_func = crypto_cipher_free_ctx;
+		break;
+	case TEE_OPERATION_AE:
+		res = crypto_authenc_alloc_ctx(&ctx, op->algo);
+		perf_func = perf_authenc;
+		free_func = crypto_authenc_free_ctx;
+		break;
+	case TEE_OPERATION_ASYMMETRIC_SIGNATURE:
+		/* Key generation isn't part of the measurement */
+		res = alloc_sign_key(&ctx, op->algo, key_size_bits);
+		perf_func = perf_sign;
+		break;
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+	if (res)
+		goto out;
+
+run:
+	res = tee_time_get_sys_time(&start);
+	for (n = 0; !res && n < rep_count; n++)
+		res = perf_func(ctx, op);
+	if (!res)
+		res = tee_time_get_sys_time(&end);
+	if (!res) {
+		TEE_TIME_SUB(end, start, t);
+		*elapsed_ms = t.seconds * TEE_TIME_MILLIS_BASE + t.millis;
+	}
+
+out:
+	if (free_func)
+		free_func(ctx);
+	else if (TEE_ALG_GET_CLASS(op->algo) ==
+		 TEE_OPERATION_ASYMMETRIC_SIGNATURE)
+		free_sign_key(ctx, op->algo);
+
+	return res;
+}
+
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_INOUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	struct perf_op op = { };
+	size_t key_size_bits = 0;
+	unsigned int rep_count = 0;
+	uint32_t elapsed_ms = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	op.algo = params[0].value.a;
+	key_size_bits = params[0].value.b;
+	rep_count = params[1].value.a;
+	op.unit_size = params[1].value.b;
+	op.buf = params[2].memref.buffer;
+	op.len = params[2].memref.size;
+
+	if (key_size_bits % 8 || !op.unit_size || !op.buf)
+		return TEE_ERROR_BAD_PARAMETERS;
+	op.key_len = key_size_bits / 8;
+	if (TEE_ALG_GET_CLASS(op.algo) != TEE_OPERATION_ASYMMETRIC_SIGNATURE &&
+	    op.key_len > sizeof(perf_key) / 2)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = run_perf(&op, rep_count, key_size_bits, &elapsed_ms);
+	if (res)
+		return res;
+
+	params[3].value.a = elapsed_ms;
+	params[3].value.b = 0;
+
+	return TEE_SUCCESS;
+}
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <kernel/tee_time.h>
+#include <kernel/ts_manager.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/tee_fs.h>
+#include <tee/tee_pobj.h>
+#include <tee/tee_svc_storage.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "misc.h"
+
+static const char fs_perf_obj_id[] = "fs_perf.bench";
+
+struct fs_perf {
+	const struct tee_file_operations *ops;
+	struct tee_file_handle *fh;
+	uint32_t pattern;
+	size_t size;
+	size_t chunk_size;
+	bool staged;
+	uint8_t *buf;
+	uint32_t seed;
+};
+
+static size_t next_rand_pos(struct fs_perf *p)
+{
+	size_t num_chunks = p->size / p->chunk_size;
+
+	/* xorshift32 */
+	p->seed ^= p->seed << 13;
+	p->seed ^= p->seed >> 17;
+	p->seed ^= p->seed << 5;
+
+	return (p->seed % num_chunks) * p->chunk_size;
+}
+
+static TEE_Result fill_object(struct fs_perf *p)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t pos = 0;
+
+	for (pos = 0; pos < p->size; pos += p->chunk_size) {
+		res = p->ops->write(p->fh, pos, p->buf,
+				    MIN(p->chunk_size, p->size - pos));
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result access_chunk(struct fs_perf *p, size_t n)
+{
+	size_t len = p->chunk_size;
+	size_t pos = 0;
+
+	switch (p->pattern) {
+	case PTA_INVOKE_TESTS_FS_PERF_SEQ_WRITE:
+	case PTA_INVOKE_TESTS_FS_PERF_APPEND:
+		/* When appending this is the end of the object */
+		pos = n * p->chunk_size;
+		return p->ops->write(p->fh, pos, p->buf,
+				     MIN(len, p->size - pos));
+	case PTA_INVOKE_TESTS_FS_PERF_SEQ_READ:
+		return p->ops->read(p->fh, n * p->chunk_size, p->buf, &len);
+	case PTA_INVOKE_TESTS_FS_PERF_RAND_WRITE:
+		return p->ops->write(p->fh, next_rand_pos(p), p->buf, len);
+	case PTA_INVOKE_TESTS_FS_PERF_RAND_READ:
+		return p->ops->read(p->fh, next_rand_pos(p), p->buf, &len);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static TEE_Result run_test(struct fs_perf *p, size_t num_chunks,
+			   uint32_t *elapsed_ms)
+{
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	TEE_Time t = { };
+	size_t n = 0;
+
+	if (p->staged)
+		p->ops->stage(p->fh);
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		return res;
+
+	for (n = 0; n < num_chunks; n++) {
+		res = access_chunk(p, n);
+		if (res)
+			return res;
+	}
+	if (p->staged) {
+		res = p->ops->commit_staged(&p->fh, 1);
+		if (res)
+			return res;
+	}
+
+	res = tee_time_get_sys_time(&end);
+	if (res)
+		return res;
+
+	TEE_TIME_SUB(end, start, t);
+	*elapsed_ms = t.seconds * TEE_TIME_MILLIS_BASE + t.millis;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	struct tee_pobj po = {
+		.obj_id = (void *)fs_perf_obj_id,
+		.obj_id_len = sizeof(fs_perf_obj_id),
+	};
+	struct fs_perf p = { .seed = 0x12345678 };
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t elapsed_ms = 0;
+	size_t num_chunks = 0;
+	bool prefill = false;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p.ops = tee_svc_storage_file_ops(params[0].value.a);
+	if (!p.ops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	p.pattern = params[0].value.b;
+	p.size = params[1].value.a;
+	p.chunk_size = params[1].value.b;
+	p.staged = params[2].value.a & PTA_INVOKE_TESTS_FS_PERF_STAGED &&
+		   p.ops->stage && p.ops->commit_staged;
+	if (!p.size || !p.chunk_size ||
+	    params[2].value.a & ~PTA_INVOKE_TESTS_FS_PERF_STAGED)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (p.pattern) {
+	case PTA_INVOKE_TESTS_FS_PERF_SEQ_WRITE:
+	case PTA_INVOKE_TESTS_FS_PERF_APPEND:
+	case PTA_INVOKE_TESTS_FS_PERF_SEQ_READ:
+		num_chunks = ROUNDUP_DIV(p.size, p.chunk_size);
+		break;
+	case PTA_INVOKE_TESTS_FS_PERF_RAND_WRITE:
+	case PTA_INVOKE_TESTS_FS_PERF_RAND_READ:
+		if (p.chunk_size > p.size)
+			return TEE_ERROR_BAD_PARAMETERS;
+		num_chunks = p.size / p.chunk_size;
+		break;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+	prefill = p.pattern != PTA_INVOKE_TESTS_FS_PERF_APPEND;
+
+	/* Files are stored on behalf of this pseudo TA */
+	po.uuid = ts_get_current_session()->ctx->uuid;
+
+	p.buf = malloc(p.chunk_size);
+	if (!p.buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(p.buf, 0x5a, p.chunk_size);
+
+	res = p.ops->create(&po, true, NULL, 0, NULL, 0, NULL, 0, &p.fh);
+	if (res)
+		goto out;
+
+	if (prefill)
+		res = fill_object(&p);
+	if (!res)
+		res = run_test(&p, num_chunks, &elapsed_ms);
+
+	p.ops->close(&p.fh);
+	p.ops->remove(&po);
+
+	if (!res) {
+		params[3].value.a = elapsed_ms;
+		params[3].value.b = num_chunks;
+	} else {
+		EMSG("Pattern %"PRIu32" failed: %#"PRIx32, p.pattern, res);
+	}
+out:
+	free(p.buf);
+
+	return res;
+}
@@ -427,6 +427,8 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 #if defined(CFG_WITH_USER_TA)
 	case PTA_INVOKE_TESTS_CMD_FS_HTREE:
 		return core_fs_htree_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_FS_PERF:
+		return core_fs_perf_tests(nParamTypes, pParams);
 #endif
 	case PTA_INVOKE_TESTS_CMD_MUTEX:
 		return core_mutex_tests(nParamTypes, pParams);
@@ -434,6 +436,14 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_lockdep_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TEST_CMD_AES_PERF:
 		return core_aes_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_CRYPTO_PERF:
+		return core_crypto_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_SORT_PERF:
+		return core_sort_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_LATENCY:
+		return core_latency_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_PAGER_PERF:
+		return core_pager_perf_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <compiler.h>
+#include <kernel/mutex.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <tee_api_defines.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+static struct mutex latency_mutex = MUTEX_INITIALIZER;
+
+static TEE_Result run_op(uint32_t op, size_t size)
+{
+	TEE_Time t = { };
+	void *p = NULL;
+
+	switch (op) {
+	case PTA_INVOKE_TESTS_LATENCY_NULL:
+		return TEE_SUCCESS;
+	case PTA_INVOKE_TESTS_LATENCY_MALLOC:
+		p = malloc(size);
+		if (!p)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		free(p);
+		return TEE_SUCCESS;
+	case PTA_INVOKE_TESTS_LATENCY_MUTEX:
+		mutex_lock(&latency_mutex);
+		mutex_unlock(&latency_mutex);
+		return TEE_SUCCESS;
+	case PTA_INVOKE_TESTS_LATENCY_SYS_TIME:
+		return tee_time_get_sys_time(&t);
+	case PTA_INVOKE_TESTS_LATENCY_RPC:
+		return tee_time_get_ree_time(&t);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t va = *(const uint64_t *)a;
+	uint64_t vb = *(const uint64_t *)b;
+
+	return (va > vb) - (va < vb);
+}
+
+static uint32_t clamp_u32(uint64_t v)
+{
+	return MIN(v, (uint64_t)UINT32_MAX);
+}
+
+TEE_Result core_latency_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INOUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t *samples = NULL;
+	uint64_t start = 0;
+	uint64_t total = 0;
+	size_t rep_count = 0;
+	uint32_t op = 0;
+	size_t size = 0;
+	size_t n = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	op = params[0].value.a;
+	size = params[0].value.b;
+	rep_count = params[1].value.a;
+	if (!rep_count)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	samples = calloc(rep_count, sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < rep_count; n++) {
+		start = barrier_read_cntpct();
+		res = run_op(op, size);
+		samples[n] = barrier_read_cntpct() - start;
+		if (res)
+			goto out;
+		total += samples[n];
+	}
+
+	qsort(samples, rep_count, sizeof(*samples), cmp_u64);
+
+	params[1].value.b = read_cntfrq();
+	params[2].value.a = clamp_u32(samples[0]);
+	params[2].value.b = clamp_u32(total / rep_count);
+	params[3].value.a = clamp_u32(samples[(rep_count * 99) / 100]);
+	params[3].value.b = clamp_u32(samples[rep_count - 1]);
+out:
+	free(samples);
+
+	return res;
+}
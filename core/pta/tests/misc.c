@@ -5,8 +5,11 @@
 #include <assert.h>
 #include <malloc.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <trace.h>
+#include <kernel/handle.h>
 #include <kernel/panic.h>
+#include <tee/cache.h>
 #include <util.h>
 
 #include "misc.h"
@@ -548,6 +551,137 @@ static int self_test_nex_malloc(void)
 	return 0;
 }
 #endif
+static int self_test_handle_db(void)
+{
+	struct handle_db db = HANDLE_DB_INITIALIZER;
+	uint32_t objs[16] = { 0 };
+	int handles[ARRAY_SIZE(objs)] = { 0 };
+	uint32_t uref2 = 0;
+	uint32_t uref = 0;
+	uint32_t gen = 0;
+	int ret = -1;
+	size_t n = 0;
+
+	LOG("handle_db tests:");
+
+	for (n = 0; n < ARRAY_SIZE(objs); n++) {
+		handles[n] = handle_get(&db, objs + n);
+		if (handles[n] < 0)
+			goto out;
+	}
+	for (n = 0; n < ARRAY_SIZE(objs); n++)
+		if (handle_lookup(&db, handles[n]) != objs + n)
+			goto out;
+
+	/* Released handles must not resolve and be reused */
+	if (handle_put(&db, handles[3]) != objs + 3 ||
+	    handle_lookup(&db, handles[3]) || handle_put(&db, handles[3]))
+		goto out;
+	if (handle_get(&db, objs + 3) != handles[3])
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(objs); n++)
+		if (handle_put(&db, handles[n]) != objs + n)
+			goto out;
+	if (!handle_db_is_empty(&db) || handle_lookup(&db, handles[0]))
+		goto out;
+
+	/* A reused handle must be given another user space handle */
+	if (!handle_get_uref(&db, objs, &gen, &uref) || !uref ||
+	    handle_lookup(&db, uref_to_handle(uref)) != objs)
+		goto out;
+	handle_put(&db, uref_to_handle(uref));
+	if (!handle_get_uref(&db, objs, &gen, &uref2) || uref2 == uref ||
+	    uref_to_handle(uref2) != uref_to_handle(uref))
+		goto out;
+
+	ret = 0;
+out:
+	handle_db_destroy(&db, NULL);
+	LOG("- handle_db tests %s", ret ? "failed" : "passed");
+	return ret;
+}
+
+struct sort_elem {
+	uint8_t key;
+	uint8_t pos;
+};
+
+static int cmp_sort_elem(const void *a, const void *b)
+{
+	const struct sort_elem *ea = a;
+	const struct sort_elem *eb = b;
+
+	return (int)ea->key - (int)eb->key;
+}
+
+static int self_test_sort(void)
+{
+	struct sort_elem elems[200] = { };
+	size_t n = 0;
+
+	LOG("sort tests:");
+
+	for (n = 0; n < ARRAY_SIZE(elems); n++) {
+		elems[n].key = (n * 37) % 11;
+		elems[n].pos = n;
+	}
+	qsort(elems, ARRAY_SIZE(elems), sizeof(*elems), cmp_sort_elem);
+	for (n = 1; n < ARRAY_SIZE(elems); n++)
+		if (elems[n - 1].key > elems[n].key)
+			goto err;
+
+	/* mergesort() must keep the order of elements with the same key */
+	for (n = 0; n < ARRAY_SIZE(elems); n++) {
+		elems[n].key = (ARRAY_SIZE(elems) - n) % 7;
+		elems[n].pos = n;
+	}
+	if (mergesort(elems, ARRAY_SIZE(elems), sizeof(*elems),
+		      cmp_sort_elem))
+		goto err;
+	for (n = 1; n < ARRAY_SIZE(elems); n++)
+		if (elems[n - 1].key > elems[n].key ||
+		    (elems[n - 1].key == elems[n].key &&
+		     elems[n - 1].pos > elems[n].pos))
+			goto err;
+
+	LOG("- sort tests passed");
+	return 0;
+err:
+	LOG("- sort tests failed");
+	return -1;
+}
+
+static int self_test_cache_op_batch(void)
+{
+	static uint8_t buf[1024] __aligned(128);
+	struct cache_op_batch batch = { };
+	int ret = -1;
+
+	LOG("cache_op_batch tests:");
+
+	cache_op_batch_init(&batch, TEE_CACHECLEAN);
+	/* Adjacent ranges are merged, distant ones aren't */
+	if (cache_op_batch_add(&batch, buf, 32) ||
+	    cache_op_batch_add(&batch, buf + 32, 32) || batch.count != 1 ||
+	    batch.range[0].len != 64)
+		goto out;
+	if (cache_op_batch_add(&batch, buf + 512, 64) || batch.count != 2)
+		goto out;
+	if (cache_op_batch_add(&batch, buf + 64, 64) || batch.count != 2 ||
+	    batch.range[0].va != (vaddr_t)buf || batch.range[0].len != 128)
+		goto out;
+	if (cache_op_batch_add(&batch, buf, 0) || batch.count != 2)
+		goto out;
+	if (cache_op_batch_flush(&batch) || batch.count)
+		goto out;
+
+	ret = 0;
+out:
+	LOG("- cache_op_batch tests %s", ret ? "failed" : "passed");
+	return ret;
+}
+
 /* exported entry points for some basic test */
 TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 		TEE_Param pParams[TEE_NUM_PARAMS] __unused)
@@ -555,7 +689,8 @@ TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 	if (self_test_mul_signed_overflow() || self_test_add_overflow() ||
 	    self_test_sub_overflow() || self_test_mul_unsigned_overflow() ||
 	    self_test_division() || self_test_malloc() ||
-	    self_test_nex_malloc()) {
+	    self_test_nex_malloc() || self_test_handle_db() ||
+	    self_test_sort() || self_test_cache_op_batch()) {
 		EMSG("some self_test_xxx failed! you should enable local LOG");
 		return TEE_ERROR_GENERIC;
 	}
@@ -16,6 +16,9 @@ TEE_Result core_self_tests(uint32_t nParamTypes,
 TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 			       TEE_Param pParams[TEE_NUM_PARAMS]);
 
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS]);
+
 TEE_Result core_mutex_tests(uint32_t nParamTypes,
 			    TEE_Param pParams[TEE_NUM_PARAMS]);
 
@@ -33,5 +36,23 @@ static inline TEE_Result core_lockdep_tests(
 
 TEE_Result core_aes_perf_tests(uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS]);
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS]);
+TEE_Result core_sort_perf_tests(uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS]);
+TEE_Result core_latency_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS]);
+
+#ifdef CFG_WITH_PAGER
+TEE_Result core_pager_perf_tests(uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_pager_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
 
 #endif /*CORE_PTA_TESTS_MISC_H*/
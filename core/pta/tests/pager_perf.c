@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/mutex.h>
+#include <mm/fobj.h>
+#include <mm/tee_mm.h>
+#include <mm/tee_pager.h>
+#include <pta_invoke_tests.h>
+#include <tee_api_defines.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+struct pager_perf_region {
+	uint8_t *base;
+	size_t num_pages;
+};
+
+static struct pager_perf_region regions[2];
+static struct mutex pager_perf_mutex = MUTEX_INITIALIZER;
+
+static uint8_t *alloc_rw_region(size_t num_pages)
+{
+	tee_mm_entry_t *mm = NULL;
+	struct fobj *fobj = NULL;
+	vaddr_t va = 0;
+
+	mm = tee_mm_alloc(&tee_mm_vcore, num_pages * SMALL_PAGE_SIZE);
+	if (!mm)
+		return NULL;
+
+	fobj = fobj_rw_paged_alloc(num_pages);
+	if (!fobj) {
+		tee_mm_free(mm);
+		return NULL;
+	}
+
+	va = tee_mm_get_smem(mm);
+	tee_pager_add_core_area(va, PAGER_AREA_TYPE_RW, fobj);
+	fobj_put(fobj);
+
+	return (uint8_t *)va;
+}
+
+static TEE_Result get_region(uint32_t type, size_t num_pages,
+			     struct pager_perf_region **region)
+{
+	struct pager_perf_region *r = NULL;
+	size_t size = 0;
+
+	if (type >= ARRAY_SIZE(regions) || !num_pages)
+		return TEE_ERROR_BAD_PARAMETERS;
+	r = regions + type;
+
+	if (!r->base) {
+		if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (type == PTA_INVOKE_TESTS_PAGER_PERF_RW)
+			r->base = alloc_rw_region(num_pages);
+		else
+			r->base = tee_pager_alloc(size);
+		if (!r->base)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		r->num_pages = num_pages;
+	} else if (num_pages > r->num_pages) {
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	*region = r;
+	return TEE_SUCCESS;
+}
+
+static uint32_t next_rand(uint32_t *seed)
+{
+	/* xorshift32 */
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+static size_t next_page(uint32_t pattern, size_t n, size_t num_pages,
+			size_t ws_pages, uint32_t *seed)
+{
+	if (pattern == PTA_INVOKE_TESTS_PAGER_PERF_SEQ)
+		return n % num_pages;
+	if (pattern == PTA_INVOKE_TESTS_PAGER_PERF_WORKING_SET &&
+	    next_rand(seed) % 10)
+		return next_rand(seed) % ws_pages;
+
+	return next_rand(seed) % num_pages;
+}
+
+TEE_Result core_pager_perf_tests(uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INOUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	static struct tee_pager_stats stats;
+	struct pager_perf_region *r = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	volatile uint32_t *p = NULL;
+	uint32_t seed = 0x12345678;
+	uint32_t pattern = 0;
+	size_t num_pages = 0;
+	size_t ws_pages = 0;
+	size_t count = 0;
+	uint64_t start = 0;
+	uint64_t cnt = 0;
+	uint64_t fault_us = 0;
+	size_t faults = 0;
+	size_t n = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pattern = params[0].value.b;
+	num_pages = params[1].value.a;
+	count = params[1].value.b;
+	ws_pages = params[2].value.a;
+	if (pattern > PTA_INVOKE_TESTS_PAGER_PERF_WORKING_SET ||
+	    (pattern == PTA_INVOKE_TESTS_PAGER_PERF_WORKING_SET &&
+	     (!ws_pages || ws_pages > num_pages)))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&pager_perf_mutex);
+
+	res = get_region(params[0].value.a, num_pages, &r);
+	if (res)
+		goto out;
+
+	if (params[0].value.a == PTA_INVOKE_TESTS_PAGER_PERF_LOCKED)
+		tee_pager_release_phys(r->base, r->num_pages * SMALL_PAGE_SIZE);
+
+	/* Resets the counters, @stats is too large for the stack */
+	tee_pager_get_stats(&stats);
+
+	start = barrier_read_cntpct();
+	for (n = 0; n < count; n++) {
+		p = (volatile uint32_t *)(r->base +
+					  next_page(pattern, n, num_pages,
+						    ws_pages, &seed) *
+					  SMALL_PAGE_SIZE);
+		*p = *p + 1;
+	}
+	cnt = barrier_read_cntpct() - start;
+
+	tee_pager_get_stats(&stats);
+	for (n = 0; n < ARRAY_SIZE(stats.faults); n++) {
+		faults += stats.faults[n].count;
+		fault_us += stats.faults[n].total_us;
+	}
+
+	params[2].value.a = cnt * 1000000 / read_cntfrq();
+	params[2].value.b = faults;
+	params[3].value.a = fault_us;
+	params[3].value.b = stats.ro_evictions + stats.rw_evictions;
+out:
+	mutex_unlock(&pager_perf_mutex);
+
+	return res;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <tee_api_defines.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <utee_defines.h>
+
+#include "misc.h"
+
+static uint32_t cmp_count;
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t va = *(const uint32_t *)a;
+	uint32_t vb = *(const uint32_t *)b;
+
+	cmp_count++;
+	return (va > vb) - (va < vb);
+}
+
+static TEE_Result fill(uint32_t *elems, size_t count, uint32_t pattern)
+{
+	uint32_t seed = 0x12345678;
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		switch (pattern) {
+		case PTA_INVOKE_TESTS_SORT_RANDOM:
+			/* xorshift32 */
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			elems[n] = seed;
+			break;
+		case PTA_INVOKE_TESTS_SORT_SORTED:
+			elems[n] = n;
+			break;
+		case PTA_INVOKE_TESTS_SORT_REVERSED:
+			elems[n] = count - n;
+			break;
+		case PTA_INVOKE_TESTS_SORT_ORGAN_PIPE:
+			elems[n] = n < count / 2 ? n : count - n;
+			break;
+		case PTA_INVOKE_TESTS_SORT_EQUAL:
+			elems[n] = 1;
+			break;
+		default:
+			return TEE_ERROR_BAD_PARAMETERS;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+
+static bool is_sorted(uint32_t *elems, size_t count)
+{
+	size_t n = 0;
+
+	for (n = 1; n < count; n++)
+		if (elems[n - 1] > elems[n])
+			return false;
+
+	return true;
+}
+
+TEE_Result core_sort_perf_tests(uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT,
+						   TEE_PARAM_TYPE_NONE);
+	TEE_Time start = { };
+	TEE_Time end = { };
+	TEE_Time t = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t *elems = NULL;
+	uint32_t algo = 0;
+	uint32_t pattern = 0;
+	unsigned int rep_count = 0;
+	uint32_t elapsed_ms = 0;
+	uint32_t cmps = 0;
+	size_t count = 0;
+	unsigned int n = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = params[0].value.a;
+	pattern = params[0].value.b;
+	algo = params[1].value.a;
+	rep_count = params[1].value.b;
+
+	if (algo != PTA_INVOKE_TESTS_SORT_QSORT &&
+	    algo != PTA_INVOKE_TESTS_SORT_MERGESORT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	elems = calloc(count, sizeof(*elems));
+	if (!elems)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < rep_count; n++) {
+		/* Only the sorting is measured */
+		res = fill(elems, count, pattern);
+		if (res)
+			goto out;
+
+		cmp_count = 0;
+		res = tee_time_get_sys_time(&start);
+		if (res)
+			goto out;
+		if (algo == PTA_INVOKE_TESTS_SORT_QSORT)
+			qsort(elems, count, sizeof(*elems), cmp_u32);
+		else if (mergesort(elems, count, sizeof(*elems), cmp_u32))
+			res = TEE_ERROR_OUT_OF_MEMORY;
+		if (!res)
+			res = tee_time_get_sys_time(&end);
+		if (res)
+			goto out;
+
+		TEE_TIME_SUB(end, start, t);
+		elapsed_ms += t.seconds * TEE_TIME_MILLIS_BASE + t.millis;
+		cmps = cmp_count;
+
+		if (!is_sorted(elems, count)) {
+			EMSG("Sort %"PRIu32" failed", algo);
+			res = TEE_ERROR_GENERIC;
+			goto out;
+		}
+	}
+
+	params[2].value.a = elapsed_ms;
+	params[2].value.b = cmps;
+out:
+	free(elems);
+
+	return res;
+}
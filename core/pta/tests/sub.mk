@@ -1,4 +1,5 @@
 srcs-$(CFG_WITH_USER_TA) += fs_htree.c
+srcs-$(CFG_WITH_USER_TA) += fs_perf.c
 srcs-y += interrupt.c
 srcs-y += invoke.c
 srcs-$(CFG_LOCKDEP) += lockdep.c
@@ -6,3 +7,7 @@ srcs-y += misc.c
 cflags-misc.c-y += -fno-builtin
 srcs-y += mutex.c
 srcs-y += aes_perf.c
+srcs-y += crypto_perf.c
+srcs-y += sort_perf.c
+srcs-y += latency.c
+srcs-$(CFG_WITH_PAGER) += pager_perf.c
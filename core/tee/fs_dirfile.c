@@ -8,15 +8,43 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/fs_dirfile.h>
 #include <types_ext.h>
+#include <util.h>
 
+#define DENT_HASH_BUCKETS	128
+
+/*
+ * struct dent_node - index of a used entry in the dirfile
+ * @key:	hash of the TA UUID and object id of the entry
+ * @idx:	index of the entry in the dirfile
+ */
+struct dent_node {
+	uint32_t key;
+	int idx;
+	SLIST_ENTRY(dent_node) link;
+};
+
+SLIST_HEAD(dent_node_head, dent_node);
+
+/*
+ * The used entries of the dirfile are indexed in @dent_hash when the
+ * dirfile is opened so that looking up an object doesn't have to read
+ * all the entries before it. @dents holds the node of each entry by
+ * index, NULL for unused entries. The index is updated with each entry
+ * written and discarded together with uncommitted writes when the
+ * dirfile is closed.
+ */
 struct tee_fs_dirfile_dirh {
 	const struct tee_fs_dirfile_operations *fops;
 	struct tee_file_handle *fh;
 	int nbits;
 	bitstr_t *files;
 	size_t ndents;
+	size_t nnodes;
+	struct dent_node **dents;
+	struct dent_node_head dent_hash[DENT_HASH_BUCKETS];
 };
 
 struct dirfile_entry {
@@ -79,6 +107,100 @@ static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 	return false;
 }
 
+/* FNV-1a hash of the TA UUID and the object id */
+static uint32_t dent_key(const TEE_UUID *uuid, const void *oid,
+			 size_t oidlen)
+{
+	const uint8_t *p = (const uint8_t *)uuid;
+	uint32_t h = 2166136261U;
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(*uuid); n++)
+		h = (h ^ p[n]) * 16777619U;
+	p = oid;
+	for (n = 0; n < oidlen; n++)
+		h = (h ^ p[n]) * 16777619U;
+
+	return h;
+}
+
+static struct dent_node_head *dent_head(struct tee_fs_dirfile_dirh *dirh,
+					uint32_t key)
+{
+	return dirh->dent_hash + key % DENT_HASH_BUCKETS;
+}
+
+static TEE_Result maybe_grow_dents(struct tee_fs_dirfile_dirh *dirh,
+				   size_t idx)
+{
+	size_t n = MAX(idx + 1, dirh->nnodes * 2);
+	void *p = NULL;
+
+	if (idx < dirh->nnodes)
+		return TEE_SUCCESS;
+
+	p = realloc(dirh->dents, n * sizeof(*dirh->dents));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->dents = p;
+
+	memset(dirh->dents + dirh->nnodes, 0,
+	       (n - dirh->nnodes) * sizeof(*dirh->dents));
+	dirh->nnodes = n;
+
+	return TEE_SUCCESS;
+}
+
+/* Updates the index with the entry at @idx */
+static TEE_Result index_dent(struct tee_fs_dirfile_dirh *dirh, size_t idx,
+			     const struct dirfile_entry *dent)
+{
+	struct dent_node *node = NULL;
+	uint32_t key = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (dent->oidlen)
+		key = dent_key(&dent->uuid, dent->oid, dent->oidlen);
+
+	if (idx < dirh->nnodes)
+		node = dirh->dents[idx];
+	if (node) {
+		if (dent->oidlen && node->key == key)
+			return TEE_SUCCESS;
+		SLIST_REMOVE(dent_head(dirh, node->key), node, dent_node,
+			     link);
+		dirh->dents[idx] = NULL;
+	}
+
+	if (!dent->oidlen) {
+		free(node);
+		return TEE_SUCCESS;
+	}
+
+	res = maybe_grow_dents(dirh, idx);
+	if (res)
+		goto err;
+	if (!node) {
+		node = malloc(sizeof(*node));
+		if (!node)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	node->key = key;
+	node->idx = idx;
+	SLIST_INSERT_HEAD(dent_head(dirh, key), node, link);
+	dirh->dents[idx] = node;
+
+	return TEE_SUCCESS;
+err:
+	free(node);
+	return res;
+}
+
+static bool dent_is_free(struct tee_fs_dirfile_dirh *dirh, size_t idx)
+{
+	return idx >= dirh->nnodes || !dirh->dents[idx];
+}
+
 static TEE_Result read_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
 			    struct dirfile_entry *dent)
 {
@@ -101,10 +223,13 @@ static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
 
 	res = dirh->fops->write(dirh->fh, sizeof(*dent) * n,
 				dent, sizeof(*dent));
-	if (!res && n >= dirh->ndents)
+	if (res)
+		return res;
+
+	if (n >= dirh->ndents)
 		dirh->ndents = n + 1;
 
-	return res;
+	return index_dent(dirh, n, dent);
 }
 
 TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
@@ -149,6 +274,10 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
 		res = set_file(dirh, dent.file_number);
 		if (res != TEE_SUCCESS)
 			goto out;
+
+		res = index_dent(dirh, n, &dent);
+		if (res)
+			goto out;
 	}
 out:
 	if (!res) {
@@ -162,8 +291,13 @@ out:
 
 void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 {
+	size_t n = 0;
+
 	if (dirh) {
 		dirh->fops->close(dirh->fh);
+		for (n = 0; n < dirh->nnodes; n++)
+			free(dirh->dents[n]);
+		free(dirh->dents);
 		free(dirh->files);
 		free(dirh);
 	}
@@ -200,35 +334,39 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 {
 	TEE_Result res;
 	struct dirfile_entry dent;
-	int n;
-	int first_free = -1;
+	struct dent_node *node = NULL;
+	uint32_t key = 0;
+	size_t n = 0;
+
+	if (!oidlen) {
+		/* Look for the first unused entry */
+		while (n < dirh->ndents && !dent_is_free(dirh, n))
+			n++;
+		memset(&dent, 0, sizeof(dent));
+		goto out;
+	}
 
-	for (n = 0;; n++) {
-		res = read_dent(dirh, n, &dent);
-		if (res == TEE_ERROR_ITEM_NOT_FOUND && !oidlen) {
-			memset(&dent, 0, sizeof(dent));
-			if (first_free != -1)
-				n = first_free;
-			break;
-		}
+	key = dent_key(uuid, oid, oidlen);
+	SLIST_FOREACH(node, dent_head(dirh, key), link) {
+		if (node->key != key)
+			continue;
+
+		res = read_dent(dirh, node->idx, &dent);
 		if (res)
 			return res;
 
-		/* TODO check this loop when oidlen == 0 */
+		assert(test_file(dirh, dent.file_number));
 
-		if (!dent.oidlen && first_free == -1)
-			first_free = n;
-		if (dent.oidlen != oidlen)
-			continue;
-
-		assert(!oidlen || !dent.oidlen ||
-		       test_file(dirh, dent.file_number));
-
-		if (!memcmp(&dent.uuid, uuid, sizeof(dent.uuid)) &&
-		    !memcmp(&dent.oid, oid, oidlen))
-			break;
+		if (dent.oidlen == oidlen &&
+		    !memcmp(&dent.uuid, uuid, sizeof(dent.uuid)) &&
+		    !memcmp(&dent.oid, oid, oidlen)) {
+			n = node->idx;
+			goto out;
+		}
 	}
 
+	return TEE_ERROR_ITEM_NOT_FOUND;
+out:
 	if (dfh) {
 		dfh->idx = n;
 		dfh->file_number = dent.file_number;
@@ -348,6 +486,8 @@ TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 		i = 0;
 
 	for (;; i++) {
+		if ((size_t)i < dirh->ndents && dent_is_free(dirh, i))
+			continue;
 		res = read_dent(dirh, i, &dent);
 		if (res)
 			return res;
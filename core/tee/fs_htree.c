@@ -4,12 +4,18 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
 #include <kernel/tee_common_otp.h>
+#ifdef CFG_REE_FS_COMPRESS
+#include <lz.h>
+#endif
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <string_ext.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/fs_htree.h>
 #include <tee/tee_fs_key_manager.h>
 #include <tee/tee_fs_rpc.h>
@@ -23,17 +29,49 @@
 #define TEE_FS_HTREE_ENC_SIZE		TEE_AES_BLOCK_SIZE
 #define TEE_FS_HTREE_SSK_SIZE		TEE_FS_HTREE_HASH_SIZE
 
+#ifdef CFG_REE_FS_HTREE_CHACHA20_POLY1305
+#define TEE_FS_HTREE_AUTH_ENC_ALG	TEE_ALG_CHACHA20_POLY1305
+/* The 96-bit nonce is made of the first bytes of the IV */
+#define TEE_FS_HTREE_NONCE_SIZE		12
+#else
 #define TEE_FS_HTREE_AUTH_ENC_ALG	TEE_ALG_AES_GCM
+#define TEE_FS_HTREE_NONCE_SIZE		TEE_FS_HTREE_IV_SIZE
+#endif
 #define TEE_FS_HTREE_HMAC_ALG		TEE_ALG_HMAC_SHA256
 
+/*
+ * Bounds of a vectored write used while syncing a hash tree to storage,
+ * the blocks and nodes are sent with as few RPCs as these allow.
+ */
+#define HTREE_WRITEV_MAX_ENTRIES	64
+#define HTREE_WRITEV_MAX_BLOCKS		8
+
 #define BLOCK_NUM_TO_NODE_ID(num)	((num) + 1)
 
 #define NODE_ID_TO_BLOCK_NUM(id)	((id) - 1)
 
+/* The node flags must have room for HTREE_NODE_COMPRESSED_BLOCK */
+#if CFG_REE_FS_HTREE_FANOUT < 2 || CFG_REE_FS_HTREE_FANOUT > 14
+#error CFG_REE_FS_HTREE_FANOUT out of range
+#endif
+
+/* Size of the length of the compressed data stored before it in a block */
+#define HTREE_ZLEN_SIZE			2
+
+/* Depth of a binary tree with UINT_MAX nodes, any larger fanout is less */
+#define HTREE_MAX_DEPTH			32
+
 /*
- * The hash tree is implemented as a binary tree with the purpose to ensure
- * integrity of the data in the nodes. The data in the nodes their turn
- * provides both integrity and confidentiality of the data blocks.
+ * The hash tree is implemented as a tree with a fanout of 2 (binary tree)
+ * up to CFG_REE_FS_HTREE_FANOUT with the purpose to ensure integrity of the
+ * data in the nodes. The data in the nodes their turn provides both
+ * integrity and confidentiality of the data blocks.
+ *
+ * With a fanout of k, the children of node n are the nodes k * (n - 1) + 2
+ * to k * (n - 1) + k + 1, for k = 2 it's the classical 2 * n and
+ * 2 * n + 1. The fanout of a file is stored in the encrypted part of its
+ * header, files created before that field was introduced have it 0 and
+ * are binary trees.
  *
  * The hash tree is saved in a file as:
  * +----------------------------+
@@ -73,8 +111,28 @@
  */
 
 #define HTREE_NODE_COMMITTED_BLOCK	BIT32(0)
-/* n is 0 or 1 */
+/* n is the index of the child, 0 to fanout - 1 */
 #define HTREE_NODE_COMMITTED_CHILD(n)	BIT32(1 + (n))
+/*
+ * The block of the node is compressed: the stored block starts with the
+ * 16-bit little endian length of the encrypted compressed data which
+ * follows it, the rest of the block is zero.
+ */
+#define HTREE_NODE_COMPRESSED_BLOCK	BIT32(15)
+
+/*
+ * With CFG_REE_FS_BLOCK_CACHE_SIZE > 0 up to that many decrypted and
+ * verified data blocks are kept per open hash tree, in LRU order with the
+ * most recently used first. Written blocks are only marked dirty in the
+ * cache, they are encrypted and written to storage when evicted or when
+ * tee_fs_htree_sync_to_storage() is called.
+ */
+struct htree_block {
+	TAILQ_ENTRY(htree_block) link;
+	struct htree_node *node;
+	bool dirty;
+	uint8_t data[];
+};
 
 struct htree_node {
 	size_t id;
@@ -82,7 +140,8 @@ struct htree_node {
 	bool block_updated;
 	struct tee_fs_htree_node_image node;
 	struct htree_node *parent;
-	struct htree_node *child[2];
+	struct htree_node *child[CFG_REE_FS_HTREE_FANOUT];
+	struct htree_block *block;
 };
 
 struct tee_fs_htree {
@@ -90,10 +149,16 @@ struct tee_fs_htree {
 	struct tee_fs_htree_image head;
 	uint8_t fek[TEE_FS_HTREE_FEK_SIZE];
 	struct tee_fs_htree_imeta imeta;
+	size_t fanout;
 	bool dirty;
 	const TEE_UUID *uuid;
 	const struct tee_fs_htree_storage *stor;
 	void *stor_aux;
+	TAILQ_HEAD(htree_block_head, htree_block) blocks;
+	size_t num_blocks;
+	struct tee_fs_rpc_writev *wv;
+	bool compress;
+	uint8_t *zbuf;
 };
 
 struct traverse_arg;
@@ -143,6 +208,56 @@ static TEE_Result rpc_read_node(struct tee_fs_htree *ht, size_t node_id,
 			node, sizeof(*node));
 }
 
+static TEE_Result writev_init(struct tee_fs_htree *ht,
+			      struct tee_fs_rpc_writev *wv)
+{
+	return ht->stor->rpc_writev_init(ht->stor_aux, wv,
+					 HTREE_WRITEV_MAX_ENTRIES,
+					 HTREE_WRITEV_MAX_BLOCKS *
+					 ht->stor->block_size);
+}
+
+/*
+ * Get the buffer in shared memory where to store data for an RPC write.
+ * While a vectored write is in progress the data is added to it and sent
+ * when full or at the end of the sync, else rpc_write_final() sends it.
+ */
+static TEE_Result rpc_write_init(struct tee_fs_htree *ht,
+				 struct tee_fs_rpc_operation *op,
+				 enum tee_fs_htree_type type, size_t idx,
+				 size_t vers, void **data)
+{
+	TEE_Result res;
+
+	if (!ht->wv)
+		return ht->stor->rpc_write_init(ht->stor_aux, op, type, idx,
+						vers, data);
+
+	res = ht->stor->rpc_writev_add(ht->stor_aux, ht->wv, type, idx, vers,
+				       data);
+	if (res != TEE_ERROR_SHORT_BUFFER)
+		return res;
+
+	res = ht->stor->rpc_writev_final(ht->wv);
+	if (res != TEE_SUCCESS)
+		return res;
+	res = writev_init(ht, ht->wv);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return ht->stor->rpc_writev_add(ht->stor_aux, ht->wv, type, idx, vers,
+					data);
+}
+
+static TEE_Result rpc_write_final(struct tee_fs_htree *ht,
+				  struct tee_fs_rpc_operation *op)
+{
+	if (ht->wv)
+		return TEE_SUCCESS;
+
+	return ht->stor->rpc_write_final(op);
+}
+
 static TEE_Result rpc_write(struct tee_fs_htree *ht,
 			    enum tee_fs_htree_type type, size_t idx,
 			    size_t vers, const void *data, size_t dlen)
@@ -151,12 +266,12 @@ static TEE_Result rpc_write(struct tee_fs_htree *ht,
 	struct tee_fs_rpc_operation op;
 	void *p;
 
-	res = ht->stor->rpc_write_init(ht->stor_aux, &op, type, idx, vers, &p);
+	res = rpc_write_init(ht, &op, type, idx, vers, &p);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	memcpy(p, data, dlen);
-	return ht->stor->rpc_write_final(&op);
+	return rpc_write_final(ht, &op);
 }
 
 static TEE_Result rpc_write_head(struct tee_fs_htree *ht, size_t vers,
@@ -178,6 +293,7 @@ static TEE_Result traverse_post_order(struct traverse_arg *targ,
 				      struct htree_node *node)
 {
 	TEE_Result res;
+	size_t n = 0;
 
 	/*
 	 * This function is recursing but not very deep, only with Log(N)
@@ -187,13 +303,11 @@ static TEE_Result traverse_post_order(struct traverse_arg *targ,
 	if (!node)
 		return TEE_SUCCESS;
 
-	res = traverse_post_order(targ, node->child[0]);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = traverse_post_order(targ, node->child[1]);
-	if (res != TEE_SUCCESS)
-		return res;
+	for (n = 0; n < targ->ht->fanout; n++) {
+		res = traverse_post_order(targ, node->child[n]);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
 
 	return targ->cb(targ, node);
 }
@@ -206,34 +320,41 @@ static TEE_Result htree_traverse_post_order(struct tee_fs_htree *ht,
 	return traverse_post_order(&targ, &ht->root);
 }
 
-static size_t node_id_to_level(size_t node_id)
+/* Returns the id of the parent of node @node_id, which isn't the root */
+static size_t node_parent_id(struct tee_fs_htree *ht, size_t node_id)
 {
-	assert(node_id && node_id < UINT_MAX);
-	/* Calculate level of the node, root node (1) has level 1 */
-	return sizeof(unsigned int) * 8 - __builtin_clz(node_id);
+	assert(node_id > 1);
+	return (node_id - 2) / ht->fanout + 1;
+}
+
+/* Returns the index of node @node_id among the children of its parent */
+static size_t node_child_idx(struct tee_fs_htree *ht, size_t node_id)
+{
+	assert(node_id > 1);
+	return (node_id - 2) % ht->fanout;
 }
 
 static struct htree_node *find_closest_node(struct tee_fs_htree *ht,
 					    size_t node_id)
 {
 	struct htree_node *node = &ht->root;
-	size_t level = node_id_to_level(node_id);
-	size_t n;
+	size_t path[HTREE_MAX_DEPTH] = { };
+	size_t id = node_id;
+	size_t n = 0;
+
+	assert(node_id && node_id < UINT_MAX);
 
-	/* n = 1 because root node is level 1 */
-	for (n = 1; n < level; n++) {
+	/* Collect the ancestors of the node, the root excluded */
+	while (id > 1) {
+		assert(n < ARRAY_SIZE(path));
+		path[n++] = id;
+		id = node_parent_id(ht, id);
+	}
+
+	while (n) {
 		struct htree_node *child;
-		size_t bit_idx;
 
-		/*
-		 * The difference between levels of the current node and
-		 * the node we're looking for tells which bit decides
-		 * direction in the tree.
-		 *
-		 * As the first bit has index 0 we'll subtract 1
-		 */
-		bit_idx = level - n - 1;
-		child = node->child[((node_id >> bit_idx) & 1)];
+		child = node->child[node_child_idx(ht, path[--n])];
 		if (!child)
 			return node;
 		node = child;
@@ -280,15 +401,15 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 		if (node->id == n)
 			continue;
 		/* Node id n should be a child of node */
-		assert((n >> 1) == node->id);
-		assert(!node->child[n & 1]);
+		assert(node_parent_id(ht, n) == node->id);
+		assert(!node->child[node_child_idx(ht, n)]);
 
 		nc = calloc(1, sizeof(*nc));
 		if (!nc)
 			return TEE_ERROR_OUT_OF_MEMORY;
 		nc->id = n;
 		nc->parent = node;
-		node->child[n & 1] = nc;
+		node->child[node_child_idx(ht, n)] = nc;
 		node = nc;
 	}
 
@@ -373,13 +494,15 @@ static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 	struct htree_node *nc;
 	size_t committed_version;
 	size_t node_id = 2;
+	size_t idx = 0;
 
 	while (node_id <= ht->imeta.max_node_id) {
-		node = find_node(ht, node_id >> 1);
+		node = find_node(ht, node_parent_id(ht, node_id));
 		if (!node)
 			return TEE_ERROR_GENERIC;
+		idx = node_child_idx(ht, node_id);
 		committed_version = !!(node->node.flags &
-				    HTREE_NODE_COMMITTED_CHILD(node_id & 1));
+				       HTREE_NODE_COMMITTED_CHILD(idx));
 
 		res = rpc_read_node(ht, node_id, committed_version,
 				    &node_image);
@@ -396,13 +519,15 @@ static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 	return TEE_SUCCESS;
 }
 
-static TEE_Result calc_node_hash(struct htree_node *node,
+static TEE_Result calc_node_hash(struct tee_fs_htree *ht,
+				 struct htree_node *node,
 				 struct tee_fs_htree_meta *meta, void *ctx,
 				 uint8_t *digest)
 {
 	TEE_Result res;
 	uint8_t *ndata = (uint8_t *)&node->node + sizeof(node->node.hash);
 	size_t nsize = sizeof(node->node) - sizeof(node->node.hash);
+	size_t n = 0;
 
 	res = crypto_hash_init(ctx);
 	if (res != TEE_SUCCESS)
@@ -418,16 +543,11 @@ static TEE_Result calc_node_hash(struct htree_node *node,
 			return res;
 	}
 
-	if (node->child[0]) {
-		res = crypto_hash_update(ctx, node->child[0]->node.hash,
-					 sizeof(node->child[0]->node.hash));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
-
-	if (node->child[1]) {
-		res = crypto_hash_update(ctx, node->child[1]->node.hash,
-					 sizeof(node->child[1]->node.hash));
+	for (n = 0; n < ht->fanout; n++) {
+		if (!node->child[n])
+			continue;
+		res = crypto_hash_update(ctx, node->child[n]->node.hash,
+					 sizeof(node->child[n]->node.hash));
 		if (res != TEE_SUCCESS)
 			return res;
 	}
@@ -464,7 +584,7 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 		return res;
 
 	res = crypto_authenc_init(ctx, mode, ht->fek, TEE_FS_HTREE_FEK_SIZE, iv,
-				  TEE_FS_HTREE_IV_SIZE, TEE_FS_HTREE_TAG_SIZE,
+				  TEE_FS_HTREE_NONCE_SIZE, TEE_FS_HTREE_TAG_SIZE,
 				  aad_len, payload_len);
 	if (res != TEE_SUCCESS)
 		goto err_free;
@@ -567,9 +687,10 @@ static TEE_Result verify_node(struct traverse_arg *targ,
 	uint8_t digest[TEE_FS_HTREE_HASH_SIZE];
 
 	if (node->parent)
-		res = calc_node_hash(node, NULL, ctx, digest);
+		res = calc_node_hash(targ->ht, node, NULL, ctx, digest);
 	else
-		res = calc_node_hash(node, &targ->ht->imeta.meta, ctx, digest);
+		res = calc_node_hash(targ->ht, node, &targ->ht->imeta.meta,
+				     ctx, digest);
 	if (res == TEE_SUCCESS &&
 	    consttime_memcmp(digest, node->node.hash, sizeof(digest)))
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -604,7 +725,7 @@ static TEE_Result init_root_node(struct tee_fs_htree *ht)
 	ht->root.id = 1;
 	ht->root.dirty = true;
 
-	res = calc_node_hash(&ht->root, &ht->imeta.meta, ctx,
+	res = calc_node_hash(ht, &ht->root, &ht->imeta.meta, ctx,
 			     ht->root.node.hash);
 	crypto_hash_free_ctx(ctx);
 
@@ -624,10 +745,16 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 	ht->uuid = uuid;
 	ht->stor = stor;
 	ht->stor_aux = stor_aux;
+	TAILQ_INIT(&ht->blocks);
 
 	if (create) {
 		const struct tee_fs_htree_image dummy_head = { .counter = 0 };
 
+		/* Binary trees stay readable by older versions */
+		ht->fanout = CFG_REE_FS_HTREE_FANOUT;
+		if (ht->fanout != 2)
+			ht->imeta.fanout = ht->fanout;
+
 		res = crypto_rng_read(ht->fek, sizeof(ht->fek));
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -655,6 +782,14 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		ht->fanout = ht->imeta.fanout;
+		if (!ht->fanout)
+			ht->fanout = 2;
+		if (ht->fanout < 2 || ht->fanout > CFG_REE_FS_HTREE_FANOUT) {
+			res = TEE_ERROR_NOT_SUPPORTED;
+			goto out;
+		}
+
 		res = init_tree_from_data(ht);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -688,11 +823,28 @@ static TEE_Result free_node(struct traverse_arg *targ __unused,
 	return TEE_SUCCESS;
 }
 
+static void free_block(struct tee_fs_htree *ht, struct htree_block *blk)
+{
+	TAILQ_REMOVE(&ht->blocks, blk, link);
+	ht->num_blocks--;
+	blk->node->block = NULL;
+	free_wipe(blk);
+}
+
+void tee_fs_htree_set_compress(struct tee_fs_htree *ht, bool compress)
+{
+	ht->compress = IS_ENABLED(CFG_REE_FS_COMPRESS) && compress;
+}
+
 void tee_fs_htree_close(struct tee_fs_htree **ht)
 {
 	if (!*ht)
 		return;
+	/* Dirty blocks are dropped like any change not synced to storage */
+	while (!TAILQ_EMPTY(&(*ht)->blocks))
+		free_block(*ht, TAILQ_FIRST(&(*ht)->blocks));
 	htree_traverse_post_order(*ht, free_node, NULL);
+	free_wipe((*ht)->zbuf);
 	free(*ht);
 	*ht = NULL;
 }
@@ -715,7 +867,8 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 		return TEE_SUCCESS;
 
 	if (node->parent) {
-		uint32_t f = HTREE_NODE_COMMITTED_CHILD(node->id & 1);
+		size_t idx = node_child_idx(targ->ht, node->id);
+		uint32_t f = HTREE_NODE_COMMITTED_CHILD(idx);
 
 		node->parent->dirty = true;
 		node->parent->node.flags ^= f;
@@ -729,7 +882,7 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 		meta = &targ->ht->imeta.meta;
 	}
 
-	res = calc_node_hash(node, meta, targ->arg, node->node.hash);
+	res = calc_node_hash(targ->ht, node, meta, targ->arg, node->node.hash);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -754,11 +907,219 @@ static TEE_Result update_root(struct tee_fs_htree *ht)
 				     sizeof(ht->imeta), &ht->head.imeta);
 }
 
+#ifdef CFG_REE_FS_COMPRESS
+/*
+ * Returns the buffer receiving compressed blocks, followed by the hash
+ * table needed by lz_compress().
+ */
+static uint8_t *get_zbuf(struct tee_fs_htree *ht)
+{
+	if (!ht->zbuf)
+		ht->zbuf = malloc(ht->stor->block_size +
+				  sizeof(uint16_t) * LZ_HTAB_SIZE);
+	return ht->zbuf;
+}
+
+/* Returns the length of @block compressed into ht->zbuf or 0 */
+static size_t compress_block(struct tee_fs_htree *ht, const void *block)
+{
+	size_t bs = ht->stor->block_size;
+	uint8_t *zbuf = get_zbuf(ht);
+
+	if (!zbuf)
+		return 0;
+
+	return lz_compress(block, bs, zbuf, bs - HTREE_ZLEN_SIZE,
+			   (uint16_t *)(zbuf + bs));
+}
+
+static TEE_Result decompress_block(struct tee_fs_htree *ht, size_t zlen,
+				   void *block)
+{
+	if (!lz_decompress(ht->zbuf, zlen, block, ht->stor->block_size))
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+}
+#else
+static uint8_t *get_zbuf(struct tee_fs_htree *ht __unused)
+{
+	return NULL;
+}
+
+static size_t compress_block(struct tee_fs_htree *ht __unused,
+			     const void *block __unused)
+{
+	return 0;
+}
+
+static TEE_Result decompress_block(struct tee_fs_htree *ht __unused,
+				   size_t zlen __unused, void *block __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+static TEE_Result decrypt_compressed_block(struct tee_fs_htree *ht,
+					   struct htree_node *node,
+					   const uint8_t *enc_block,
+					   void *block)
+{
+	size_t zlen = enc_block[0] | (enc_block[1] << 8);
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+
+	if (!IS_ENABLED(CFG_REE_FS_COMPRESS))
+		return TEE_ERROR_NOT_SUPPORTED;
+	if (!zlen || zlen > ht->stor->block_size - HTREE_ZLEN_SIZE)
+		return TEE_ERROR_CORRUPT_OBJECT;
+	if (!get_zbuf(ht))
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node, zlen);
+	if (res != TEE_SUCCESS)
+		return res;
+	res = authenc_decrypt_final(ctx, node->node.tag,
+				    enc_block + HTREE_ZLEN_SIZE, zlen,
+				    ht->zbuf);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return decompress_block(ht, zlen, block);
+}
+
+static TEE_Result write_block_to_storage(struct tee_fs_htree *ht,
+					 struct htree_node *node,
+					 const void *block)
+{
+	TEE_Result res;
+	struct tee_fs_rpc_operation op;
+	size_t bs = ht->stor->block_size;
+	const void *payload = block;
+	size_t payload_len = bs;
+	uint8_t block_vers;
+	size_t zlen = 0;
+	uint8_t *dst;
+	void *ctx;
+	void *enc_block;
+
+	if (!node->block_updated)
+		node->node.flags ^= HTREE_NODE_COMMITTED_BLOCK;
+
+	if (ht->compress)
+		zlen = compress_block(ht, block);
+	if (zlen) {
+		node->node.flags |= HTREE_NODE_COMPRESSED_BLOCK;
+		payload = ht->zbuf;
+		payload_len = zlen;
+	} else {
+		node->node.flags &= ~HTREE_NODE_COMPRESSED_BLOCK;
+	}
+
+	block_vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
+	res = rpc_write_init(ht, &op, TEE_FS_HTREE_TYPE_BLOCK,
+			     NODE_ID_TO_BLOCK_NUM(node->id), block_vers,
+			     &enc_block);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	dst = enc_block;
+	if (zlen) {
+		dst[0] = zlen;
+		dst[1] = zlen >> 8;
+		dst += HTREE_ZLEN_SIZE;
+		memset(dst + zlen, 0, bs - HTREE_ZLEN_SIZE - zlen);
+	}
+
+	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, &node->node,
+			   payload_len);
+	if (res != TEE_SUCCESS)
+		return res;
+	res = authenc_encrypt_final(ctx, node->node.tag, payload,
+				    payload_len, dst);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = rpc_write_final(ht, &op);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	node->block_updated = true;
+	node->dirty = true;
+	ht->dirty = true;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result flush_block(struct tee_fs_htree *ht, struct htree_block *blk)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!blk->dirty)
+		return TEE_SUCCESS;
+
+	res = write_block_to_storage(ht, blk->node, blk->data);
+	if (res == TEE_SUCCESS)
+		blk->dirty = false;
+
+	return res;
+}
+
+/*
+ * Return the cache entry of the block of @node, allocating or recycling
+ * one if needed. *blk_ret is NULL if caching is disabled or no memory is
+ * available.
+ */
+static TEE_Result get_cached_block(struct tee_fs_htree *ht,
+				   struct htree_node *node,
+				   struct htree_block **blk_ret)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct htree_block *blk = node->block;
+
+	*blk_ret = NULL;
+
+	if (!CFG_REE_FS_BLOCK_CACHE_SIZE)
+		return TEE_SUCCESS;
+
+	if (blk) {
+		TAILQ_REMOVE(&ht->blocks, blk, link);
+		TAILQ_INSERT_HEAD(&ht->blocks, blk, link);
+		*blk_ret = blk;
+		return TEE_SUCCESS;
+	}
+
+	if (ht->num_blocks == CFG_REE_FS_BLOCK_CACHE_SIZE) {
+		/* Recycle the least recently used entry */
+		blk = TAILQ_LAST(&ht->blocks, htree_block_head);
+		res = flush_block(ht, blk);
+		if (res != TEE_SUCCESS)
+			return res;
+		TAILQ_REMOVE(&ht->blocks, blk, link);
+		blk->node->block = NULL;
+	} else {
+		blk = malloc(sizeof(*blk) + ht->stor->block_size);
+		if (!blk)
+			return TEE_SUCCESS;
+		ht->num_blocks++;
+	}
+
+	blk->node = node;
+	blk->dirty = false;
+	node->block = blk;
+	TAILQ_INSERT_HEAD(&ht->blocks, blk, link);
+	*blk_ret = blk;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 					uint8_t *hash)
 {
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
+	struct tee_fs_rpc_writev wv = { };
+	struct htree_block *blk = NULL;
 	void *ctx;
 
 	if (!ht)
@@ -771,10 +1132,29 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		return res;
 
+	/* Without a vectored write each block and node is sent separately */
+	if (ht->stor->rpc_writev_init && writev_init(ht, &wv) == TEE_SUCCESS)
+		ht->wv = &wv;
+
+	/* Write back the cached blocks before the nodes referring them */
+	TAILQ_FOREACH(blk, &ht->blocks, link) {
+		res = flush_block(ht, blk);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
 	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, ctx);
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	/* Blocks and nodes must be in storage before the head is updated */
+	if (ht->wv) {
+		ht->wv = NULL;
+		res = ht->stor->rpc_writev_final(&wv);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
 	/* All the nodes are written to storage now. Time to update root. */
 	res = update_root(ht);
 	if (res != TEE_SUCCESS)
@@ -788,6 +1168,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (hash)
 		memcpy(hash, ht->root.node.hash, sizeof(ht->root.node.hash));
 out:
+	ht->wv = NULL;
 	crypto_hash_free_ctx(ctx);
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
@@ -812,11 +1193,8 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 {
 	struct tee_fs_htree *ht = *ht_arg;
 	TEE_Result res;
-	struct tee_fs_rpc_operation op;
 	struct htree_node *node = NULL;
-	uint8_t block_vers;
-	void *ctx;
-	void *enc_block;
+	struct htree_block *blk = NULL;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -825,32 +1203,17 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	if (!node->block_updated)
-		node->node.flags ^= HTREE_NODE_COMMITTED_BLOCK;
-
-	block_vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
-	res = ht->stor->rpc_write_init(ht->stor_aux, &op,
-				       TEE_FS_HTREE_TYPE_BLOCK, block_num,
-				       block_vers, &enc_block);
+	res = get_cached_block(ht, node, &blk);
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, &node->node,
-			   ht->stor->block_size);
-	if (res != TEE_SUCCESS)
-		goto out;
-	res = authenc_encrypt_final(ctx, node->node.tag, block,
-				    ht->stor->block_size, enc_block);
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	res = ht->stor->rpc_write_final(&op);
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	node->block_updated = true;
-	node->dirty = true;
-	ht->dirty = true;
+	if (blk) {
+		memcpy(blk->data, block, ht->stor->block_size);
+		blk->dirty = true;
+		ht->dirty = true;
+	} else {
+		res = write_block_to_storage(ht, node, block);
+	}
 out:
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
@@ -864,6 +1227,7 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 	TEE_Result res;
 	struct tee_fs_rpc_operation op;
 	struct htree_node *node;
+	struct htree_block *blk = NULL;
 	uint8_t block_vers;
 	size_t len;
 	void *ctx;
@@ -876,6 +1240,14 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	if (node->block) {
+		res = get_cached_block(ht, node, &blk);
+		if (res != TEE_SUCCESS)
+			goto out;
+		memcpy(block, blk->data, ht->stor->block_size);
+		return TEE_SUCCESS;
+	}
+
 	block_vers = !!(node->node.flags & HTREE_NODE_COMMITTED_BLOCK);
 	res = ht->stor->rpc_read_init(ht->stor_aux, &op,
 				      TEE_FS_HTREE_TYPE_BLOCK, block_num,
@@ -891,13 +1263,26 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 		goto out;
 	}
 
-	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node,
-			   ht->stor->block_size);
-	if (res != TEE_SUCCESS)
-		goto out;
+	if (node->node.flags & HTREE_NODE_COMPRESSED_BLOCK) {
+		res = decrypt_compressed_block(ht, node, enc_block, block);
+		if (res != TEE_SUCCESS)
+			goto out;
+	} else {
+		res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node,
+				   ht->stor->block_size);
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
+					    ht->stor->block_size, block);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
 
-	res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
-				    ht->stor->block_size, block);
+	/* Keep the verified block for subsequent accesses */
+	res = get_cached_block(ht, node, &blk);
+	if (res == TEE_SUCCESS && blk)
+		memcpy(blk->data, block, ht->stor->block_size);
 out:
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
@@ -909,6 +1294,7 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 	struct tee_fs_htree *ht = *ht_arg;
 	size_t node_id = BLOCK_NUM_TO_NODE_ID(block_num);
 	struct htree_node *node;
+	size_t idx = 0;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -916,10 +1302,12 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 	while (node_id < ht->imeta.max_node_id) {
 		node = find_closest_node(ht, ht->imeta.max_node_id);
 		assert(node && node->id == ht->imeta.max_node_id);
-		assert(!node->child[0] && !node->child[1]);
 		assert(node->parent);
-		assert(node->parent->child[node->id & 1] == node);
-		node->parent->child[node->id & 1] = NULL;
+		idx = node_child_idx(ht, node->id);
+		assert(node->parent->child[idx] == node);
+		node->parent->child[idx] = NULL;
+		if (node->block)
+			free_block(ht, node->block);
 		free(node);
 		ht->imeta.max_node_id--;
 		ht->dirty = true;
@@ -10,6 +10,7 @@
 #include <pta_socket.h>
 #include <string.h>
 #include <tee/tee_fs_rpc.h>
+#include <util.h>
 
 static uint32_t get_instance_id(struct ts_session *sess)
 {
@@ -206,6 +207,112 @@ static TEE_Result socket_ioctl(uint32_t instance_id, uint32_t param_types,
 	return res;
 }
 
+static TEE_Result socket_sendv(uint32_t instance_id, uint32_t param_types,
+			       TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct mobj *mobj = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t data_size = params[1].memref.size;
+	size_t lens_size = params[2].memref.size;
+	size_t lens_offs = ROUNDUP(data_size, sizeof(uint32_t));
+	size_t size = 0;
+	uint8_t *va = NULL;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!lens_size || lens_size % sizeof(uint32_t) ||
+	    lens_offs < data_size ||
+	    ADD_OVERFLOW(lens_offs, lens_size, &size))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Both the records and their lengths go in the same payload */
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_SOCKET,
+					THREAD_SHM_TYPE_APPLICATION,
+					size, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	memcpy(va, params[1].memref.buffer, data_size);
+	memcpy(va + lens_offs, params[2].memref.buffer, lens_size);
+
+	struct thread_param tpm[4] = {
+		[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_SENDV,
+					 instance_id,
+					 params[0].value.a /* handle */),
+		[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, data_size),
+		[2] = THREAD_PARAM_MEMREF(IN, mobj, lens_offs, lens_size),
+		[3] = THREAD_PARAM_VALUE(INOUT, params[0].value.b, /* timeout */
+					 0, 0),
+	};
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 4, tpm);
+	params[3].value.a = tpm[3].u.value.b; /* transmitted records */
+	params[3].value.b = tpm[3].u.value.c; /* transmitted bytes */
+
+	return res;
+}
+
+static TEE_Result socket_poll(uint32_t instance_id, uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct mobj *mobj = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t size = params[1].memref.size;
+	void *va = NULL;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+
+	/* The array is passed as is to normal world */
+	COMPILE_TIME_ASSERT(PTA_SOCKET_POLL_IN == OPTEE_RPC_SOCKET_POLL_IN &&
+			    PTA_SOCKET_POLL_OUT == OPTEE_RPC_SOCKET_POLL_OUT &&
+			    PTA_SOCKET_POLL_ERR == OPTEE_RPC_SOCKET_POLL_ERR);
+
+	if (exp_pt != param_types) {
+		DMSG("got param_types 0x%x, expected 0x%x",
+		     param_types, exp_pt);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!size || size % sizeof(struct pta_socket_pollfd))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_SOCKET,
+					THREAD_SHM_TYPE_APPLICATION,
+					size, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	memcpy(va, params[1].memref.buffer, size);
+
+	struct thread_param tpm[3] = {
+		[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_SOCKET_POLL,
+					 instance_id, 0),
+		[1] = THREAD_PARAM_MEMREF(INOUT, mobj, 0, size),
+		[2] = THREAD_PARAM_VALUE(INOUT, params[0].value.a, /* timeout */
+					 0, 0),
+	};
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_SOCKET, 3, tpm);
+	if (res == TEE_SUCCESS) {
+		if (tpm[1].u.memref.size != size)
+			return TEE_ERROR_GENERIC;
+		memcpy(params[1].memref.buffer, va, size);
+		params[2].value.a = tpm[2].u.value.b; /* ready sockets */
+	}
+
+	return res;
+}
+
 typedef TEE_Result (*ta_func)(uint32_t instance_id, uint32_t param_types,
 			      TEE_Param params[TEE_NUM_PARAMS]);
 
@@ -215,6 +322,8 @@ static const ta_func ta_funcs[] = {
 	[PTA_SOCKET_SEND] = socket_send,
 	[PTA_SOCKET_RECV] = socket_recv,
 	[PTA_SOCKET_IOCTL] = socket_ioctl,
+	[PTA_SOCKET_SENDV] = socket_sendv,
+	[PTA_SOCKET_POLL] = socket_poll,
 };
 
 /*
@@ -12,6 +12,8 @@
 #include <optee_rpc_cmd.h>
 #include <stdio.h>
 #include <string.h>
+#include <string_ext.h>
+#include <sys/queue.h>
 #include <tee_api_defines_extensions.h>
 #include <tee/tadb.h>
 #include <tee/tee_fs.h>
@@ -20,13 +22,13 @@
 #include <tee/tee_svc_storage.h>
 #include <utee_defines.h>
 
-#define TADB_MAX_BUFFER_SIZE	(64U * 1024)
-
 #define TADB_AUTH_ENC_ALG	TEE_ALG_AES_GCM
 #define TADB_IV_SIZE		TEE_AES_BLOCK_SIZE
 #define TADB_TAG_SIZE		TEE_AES_BLOCK_SIZE
 #define TADB_KEY_SIZE		TEE_AES_MAX_KEY_SIZE
 
+#define TADB_INDEX_BUCKETS	32
+
 struct tee_tadb_dir {
 	const struct tee_file_operations *ops;
 	struct tee_file_handle *fh;
@@ -55,12 +57,19 @@ struct tadb_header {
 	uint8_t opaque[];
 };
 
+/*
+ * The encrypted TA is stored in @ta_mobj as it's written and sent to
+ * normal world with a single request when committed, as the TA is read
+ * with a single request by tee_tadb_ta_read().
+ */
 struct tee_tadb_ta_write {
 	struct tee_tadb_dir *db;
 	int fd;
 	struct tadb_entry entry;
 	size_t pos;
 	void *ctx;
+	struct mobj *ta_mobj;
+	uint8_t *ta_buf;
 };
 
 struct tee_tadb_ta_read {
@@ -73,11 +82,35 @@ struct tee_tadb_ta_read {
 	uint8_t *ta_buf;
 };
 
+/*
+ * struct tadb_index_node - index of a used entry in the TA database
+ * @uuid:	UUID of the TA
+ * @idx:	index of the entry in the TA database
+ */
+struct tadb_index_node {
+	TEE_UUID uuid;
+	size_t idx;
+	SLIST_ENTRY(tadb_index_node) link;
+};
+
+SLIST_HEAD(tadb_index_head, tadb_index_node);
+
 static const char tadb_obj_id[] = "ta.db";
 static struct tee_tadb_dir *tadb_db;
 static unsigned int tadb_db_refc;
 static struct mutex tadb_mutex = MUTEX_INITIALIZER;
 
+/*
+ * The used entries of the TA database are indexed by UUID when the
+ * database is first opened, so that looking up a TA reads a single entry
+ * instead of all the entries before it and a TA which isn't installed is
+ * found missing without any request to normal world. The index outlives
+ * the opened database and is updated with each entry written. Protected
+ * by tadb_mutex.
+ */
+static struct tadb_index_head tadb_index[TADB_INDEX_BUCKETS];
+static bool tadb_index_valid;
+
 static void file_num_to_str(char *buf, size_t blen, uint32_t file_number)
 {
 	snprintf(buf, blen, "%" PRIu32 ".ta", file_number);
@@ -90,6 +123,91 @@ static bool is_null_uuid(const TEE_UUID *uuid)
 	return !memcmp(uuid, &null_uuid, sizeof(*uuid));
 }
 
+/* FNV-1a hash of the TA UUID */
+static struct tadb_index_head *index_head(const TEE_UUID *uuid)
+{
+	const uint8_t *p = (const uint8_t *)uuid;
+	uint32_t h = 2166136261U;
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(*uuid); n++)
+		h = (h ^ p[n]) * 16777619U;
+
+	return tadb_index + h % TADB_INDEX_BUCKETS;
+}
+
+static struct tadb_index_node *index_find(const TEE_UUID *uuid)
+{
+	struct tadb_index_node *node = NULL;
+
+	SLIST_FOREACH(node, index_head(uuid), link)
+		if (!memcmp(&node->uuid, uuid, sizeof(*uuid)))
+			return node;
+
+	return NULL;
+}
+
+static void index_clear(void)
+{
+	struct tadb_index_node *node = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tadb_index); n++) {
+		while ((node = SLIST_FIRST(tadb_index + n))) {
+			SLIST_REMOVE_HEAD(tadb_index + n, link);
+			free(node);
+		}
+	}
+	tadb_index_valid = false;
+}
+
+/* Indexes @uuid at @idx, returns false if out of memory */
+static bool index_set(const TEE_UUID *uuid, size_t idx)
+{
+	struct tadb_index_node *node = index_find(uuid);
+
+	if (!node) {
+		node = malloc(sizeof(*node));
+		if (!node)
+			return false;
+		node->uuid = *uuid;
+		SLIST_INSERT_HEAD(index_head(uuid), node, link);
+	}
+	node->idx = idx;
+
+	return true;
+}
+
+/*
+ * Builds the index from the @num_ents entries in @ents. Without memory
+ * for the index the entries are searched as they're read.
+ */
+static void index_build(const struct tadb_entry *ents, size_t num_ents)
+{
+	size_t n = 0;
+
+	index_clear();
+	for (n = 0; n < num_ents; n++) {
+		if (is_null_uuid(&ents[n].prop.uuid))
+			continue;
+		if (!index_set(&ents[n].prop.uuid, n)) {
+			index_clear();
+			return;
+		}
+	}
+	tadb_index_valid = true;
+}
+
+static void index_del(const TEE_UUID *uuid)
+{
+	struct tadb_index_node *node = index_find(uuid);
+
+	if (node) {
+		SLIST_REMOVE(index_head(uuid), node, tadb_index_node, link);
+		free(node);
+	}
+}
+
 static TEE_Result ta_operation_open(unsigned int cmd, uint32_t file_number,
 				    int *fd)
 {
@@ -228,6 +346,61 @@ static TEE_Result tadb_open(struct tee_tadb_dir **db_ret)
 	return res;
 }
 
+static TEE_Result read_all_ents(struct tee_tadb_dir *db,
+				struct tadb_entry **ents_ret, size_t *num_ret)
+{
+	struct tadb_entry *ents = NULL;
+	size_t num_ents = 0;
+	TEE_Result res;
+	size_t idx;
+	void *p;
+
+	for (idx = 0;; idx++) {
+		if (idx == num_ents) {
+			num_ents = MAX(num_ents * 2, 8U);
+			p = realloc(ents, num_ents * sizeof(*ents));
+			if (!p) {
+				res = TEE_ERROR_OUT_OF_MEMORY;
+				goto err;
+			}
+			ents = p;
+		}
+
+		res = read_ent(db, idx, ents + idx);
+		if (res == TEE_ERROR_ITEM_NOT_FOUND)
+			break;
+		if (res)
+			goto err;
+	}
+
+	*ents_ret = ents;
+	*num_ret = idx;
+	return TEE_SUCCESS;
+err:
+	free(ents);
+	return res;
+}
+
+static TEE_Result populate_index(struct tee_tadb_dir *db)
+{
+	struct tadb_entry *ents = NULL;
+	size_t num_ents = 0;
+	TEE_Result res;
+
+	if (tadb_index_valid)
+		return TEE_SUCCESS;
+
+	res = read_all_ents(db, &ents, &num_ents);
+	if (res)
+		return res;
+
+	index_build(ents, num_ents);
+	memzero_explicit(ents, num_ents * sizeof(*ents));
+	free(ents);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result tee_tadb_open(struct tee_tadb_dir **db)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -238,6 +411,13 @@ static TEE_Result tee_tadb_open(struct tee_tadb_dir **db)
 		res = tadb_open(&tadb_db);
 		if (res)
 			goto err;
+		res = populate_index(tadb_db);
+		if (res) {
+			tadb_db->ops->close(&tadb_db->fh);
+			free(tadb_db);
+			tadb_db = NULL;
+			goto err;
+		}
 	}
 	tadb_db_refc++;
 	*db = tadb_db;
@@ -344,6 +524,8 @@ static TEE_Result populate_files(struct tee_tadb_dir *db)
 			res = write_ent(db, idx, &entry);
 			if (res)
 				goto err;
+			/* Built again when the database is opened next */
+			index_clear();
 			continue;
 		}
 
@@ -437,154 +619,246 @@ err_free:
 TEE_Result tee_tadb_ta_write(struct tee_tadb_ta_write *ta, const void *buf,
 			     size_t len)
 {
-	TEE_Result res;
-	const uint8_t *rb = buf;
-	size_t rl = len;
-	struct tee_fs_rpc_operation op;
-
-	while (rl) {
-		size_t wl = MIN(rl, TADB_MAX_BUFFER_SIZE);
-		void *wb;
-
-		res = tee_fs_rpc_write_init(&op, OPTEE_RPC_CMD_FS, ta->fd,
-					    ta->pos, wl, &wb);
-		if (res)
-			return res;
-
-		res = tadb_update_payload(ta->ctx, TEE_MODE_ENCRYPT,
-					  rb, wl, wb);
-		if (res)
-			return res;
+	const size_t sz = ta->entry.prop.custom_size + ta->entry.prop.bin_size;
+	TEE_Result res = TEE_SUCCESS;
+	size_t end = 0;
 
-		res = tee_fs_rpc_write_final(&op);
-		if (res)
-			return res;
+	if (!len)
+		return TEE_SUCCESS;
+	if (ADD_OVERFLOW(ta->pos, len, &end) || end > sz)
+		return TEE_ERROR_BAD_PARAMETERS;
 
-		rl -= wl;
-		rb += wl;
-		ta->pos += wl;
+	if (!ta->ta_mobj) {
+		ta->ta_mobj = thread_rpc_alloc_payload(sz);
+		if (!ta->ta_mobj)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		ta->ta_buf = mobj_get_va(ta->ta_mobj, 0);
+		assert(ta->ta_buf);
 	}
 
+	res = tadb_update_payload(ta->ctx, TEE_MODE_ENCRYPT, buf, len,
+				  ta->ta_buf + ta->pos);
+	if (res)
+		return res;
+
+	ta->pos += len;
 	return TEE_SUCCESS;
 }
 
-void tee_tadb_ta_close_and_delete(struct tee_tadb_ta_write *ta)
+static void ta_write_free(struct tee_tadb_ta_write *ta)
 {
 	crypto_authenc_final(ta->ctx);
 	crypto_authenc_free_ctx(ta->ctx);
-	tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
-	ta_operation_remove(ta->entry.file_number);
+	if (ta->ta_mobj)
+		thread_rpc_free_payload(ta->ta_mobj);
+	if (ta->fd >= 0)
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
+	tadb_put(ta->db);
+	free(ta);
+}
+
+void tee_tadb_ta_close_and_delete(struct tee_tadb_ta_write *ta)
+{
+	uint32_t file_number = ta->entry.file_number;
+	struct tee_tadb_dir *db = ta->db;
+
+	if (ta->fd >= 0) {
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
+		ta->fd = -1;
+	}
+	ta_operation_remove(file_number);
 
 	mutex_lock(&tadb_mutex);
-	clear_file(ta->db, ta->entry.file_number);
+	clear_file(db, file_number);
 	mutex_unlock(&tadb_mutex);
 
-	tadb_put(ta->db);
-	free(ta);
+	ta_write_free(ta);
+}
+
+/* Computes the tag and writes the encrypted TA, then closes the file */
+static TEE_Result ta_write_finish(struct tee_tadb_ta_write *ta)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t dsz = 0;
+	size_t sz = sizeof(ta->entry.tag);
+
+	res = crypto_authenc_enc_final(ta->ctx, NULL, 0, NULL, &dsz,
+				       ta->entry.tag, &sz);
+	if (res)
+		return res;
+
+	if (ta->pos) {
+		struct thread_param params[] = {
+			[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_FS_WRITE,
+						 ta->fd, 0),
+			[1] = THREAD_PARAM_MEMREF(IN, ta->ta_mobj, 0, ta->pos),
+		};
+
+		res = thread_rpc_cmd(OPTEE_RPC_CMD_FS, ARRAY_SIZE(params),
+				     params);
+		if (res)
+			return res;
+	}
+
+	tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
+	ta->fd = -1;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 			   size_t *idx_ret, struct tadb_entry *entry_ret)
 {
+	struct tadb_index_node *node = NULL;
 	TEE_Result res;
 	size_t idx;
 
 	/*
 	 * Search for the provided uuid, if it's found return the index it
-	 * has together with TEE_SUCCESS.
+	 * has together with TEE_SUCCESS, else TEE_ERROR_ITEM_NOT_FOUND.
 	 *
-	 * If the uuid can't be found return the number indexes together
-	 * with TEE_ERROR_ITEM_NOT_FOUND.
+	 * The indexed entry is checked once read, if it doesn't match the
+	 * index is dropped, to be built again when the database is opened
+	 * next, and all entries are searched.
 	 */
-	for (idx = 0;; idx++) {
-		struct tadb_entry entry;
+	if (tadb_index_valid) {
+		node = index_find(uuid);
+		if (!node)
+			return TEE_ERROR_ITEM_NOT_FOUND;
 
-		res = read_ent(db, idx, &entry);
-		if (res) {
-			if (res == TEE_ERROR_ITEM_NOT_FOUND)
-				break;
+		res = read_ent(db, node->idx, entry_ret);
+		if (res && res != TEE_ERROR_ITEM_NOT_FOUND)
 			return res;
+		if (!res && !memcmp(&entry_ret->prop.uuid, uuid,
+				    sizeof(*uuid))) {
+			*idx_ret = node->idx;
+			return TEE_SUCCESS;
 		}
+		EMSG("Stale index for %pUl", (void *)uuid);
+		index_clear();
+	}
 
-		if (!memcmp(&entry.prop.uuid, uuid, sizeof(*uuid))) {
-			if (entry_ret)
-				*entry_ret = entry;
-			break;
+	for (idx = 0;; idx++) {
+		res = read_ent(db, idx, entry_ret);
+		if (res)
+			return res;
+
+		if (!memcmp(&entry_ret->prop.uuid, uuid, sizeof(*uuid))) {
+			*idx_ret = idx;
+			return TEE_SUCCESS;
 		}
 	}
-
-	*idx_ret = idx;
-	return res;
 }
 
-static TEE_Result find_free_ent_idx(struct tee_tadb_dir *db, size_t *idx)
+static TEE_Result add_ent(struct tadb_entry **ents, size_t *num_ents,
+			  const struct tadb_entry *entry,
+			  struct tadb_entry *old_ent)
 {
 	const TEE_UUID null_uuid = { 0 };
-	TEE_Result res = find_ent(db, &null_uuid, idx, NULL);
+	size_t free_idx = *num_ents;
+	size_t idx = 0;
+	void *p = NULL;
+
+	memset(old_ent, 0, sizeof(*old_ent));
 
 	/*
-	 * Note that *idx is set to the number of entries on
-	 * TEE_ERROR_ITEM_NOT_FOUND.
+	 * An existing TA is replaced in its entry, the old encrypted file
+	 * is removed once the directory is committed. Else the first free
+	 * entry is used or a new entry is appended.
 	 */
-	if (res == TEE_ERROR_ITEM_NOT_FOUND)
-		return TEE_SUCCESS;
-	return res;
+	for (idx = 0; idx < *num_ents; idx++) {
+		if (!memcmp(&(*ents)[idx].prop.uuid, &entry->prop.uuid,
+			    sizeof(entry->prop.uuid))) {
+			*old_ent = (*ents)[idx];
+			(*ents)[idx] = *entry;
+			return TEE_SUCCESS;
+		}
+		if (free_idx == *num_ents &&
+		    !memcmp(&(*ents)[idx].prop.uuid, &null_uuid,
+			    sizeof(null_uuid)))
+			free_idx = idx;
+	}
+
+	if (free_idx == *num_ents) {
+		p = realloc(*ents, (*num_ents + 1) * sizeof(**ents));
+		if (!p)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		*ents = p;
+		(*num_ents)++;
+	}
+	(*ents)[free_idx] = *entry;
+
+	return TEE_SUCCESS;
 }
 
-TEE_Result tee_tadb_ta_close_and_commit(struct tee_tadb_ta_write *ta)
+TEE_Result tee_tadb_ta_close_and_commit_multi(struct tee_tadb_ta_write **ta,
+					      size_t count)
 {
+	struct tee_tadb_dir *db = ta[0]->db;
+	struct tadb_entry *old_ents = NULL;
+	struct tadb_entry *ents = NULL;
+	size_t num_ents = 0;
 	TEE_Result res;
-	size_t dsz = 0;
-	size_t sz = sizeof(ta->entry.tag);
-	size_t idx;
-	struct tadb_entry old_ent;
-	bool have_old_ent = false;
+	size_t n;
 
-	res = crypto_authenc_enc_final(ta->ctx, NULL, 0, NULL, &dsz,
-				       ta->entry.tag, &sz);
-	if (res)
-		goto err;
+	for (n = 0; n < count; n++) {
+		res = ta_write_finish(ta[n]);
+		if (res)
+			goto err;
+	}
 
-	tee_fs_rpc_close(OPTEE_RPC_CMD_FS, ta->fd);
+	old_ents = calloc(count, sizeof(*old_ents));
+	if (!old_ents) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err;
+	}
 
 	mutex_lock(&tadb_mutex);
-	/*
-	 * First try to find an existing TA to replace. If there's one
-	 * we'll use the entry, but we should also remove the old encrypted
-	 * file.
-	 *
-	 * If there isn't an existing TA to replace, grab a new entry.
-	 */
-	res = find_ent(ta->db, &ta->entry.prop.uuid, &idx, &old_ent);
-	if (!res) {
-		have_old_ent = true;
-	} else {
-		res = find_free_ent_idx(ta->db, &idx);
+	res = read_all_ents(db, &ents, &num_ents);
+	if (res)
+		goto err_mutex;
+	for (n = 0; n < count; n++) {
+		res = add_ent(&ents, &num_ents, &ta[n]->entry, old_ents + n);
 		if (res)
 			goto err_mutex;
 	}
-	res = write_ent(ta->db, idx, &ta->entry);
+
+	/* All the entries are updated with a single write of the file */
+	res = db->ops->write(db->fh, 0, ents, num_ents * sizeof(*ents));
 	if (res)
 		goto err_mutex;
-	if (have_old_ent)
-		clear_file(ta->db, old_ent.file_number);
+	for (n = 0; n < count; n++)
+		if (!is_null_uuid(&old_ents[n].prop.uuid))
+			clear_file(db, old_ents[n].file_number);
+	index_build(ents, num_ents);
 	mutex_unlock(&tadb_mutex);
 
-	crypto_authenc_final(ta->ctx);
-	crypto_authenc_free_ctx(ta->ctx);
-	tadb_put(ta->db);
-	free(ta);
-	if (have_old_ent)
-		ta_operation_remove(old_ent.file_number);
+	for (n = 0; n < count; n++) {
+		ta_write_free(ta[n]);
+		if (!is_null_uuid(&old_ents[n].prop.uuid))
+			ta_operation_remove(old_ents[n].file_number);
+	}
+	free(old_ents);
+	memzero_explicit(ents, num_ents * sizeof(*ents));
+	free(ents);
 	return TEE_SUCCESS;
 
 err_mutex:
 	mutex_unlock(&tadb_mutex);
 err:
-	tee_tadb_ta_close_and_delete(ta);
+	free(old_ents);
+	memzero_explicit(ents, num_ents * sizeof(*ents));
+	free(ents);
+	for (n = 0; n < count; n++)
+		tee_tadb_ta_close_and_delete(ta[n]);
 	return res;
 }
 
+TEE_Result tee_tadb_ta_close_and_commit(struct tee_tadb_ta_write *ta)
+{
+	return tee_tadb_ta_close_and_commit_multi(&ta, 1);
+}
+
 TEE_Result tee_tadb_ta_delete(const TEE_UUID *uuid)
 {
 	const struct tadb_entry null_entry = { { { 0 } } };
@@ -610,6 +884,10 @@ TEE_Result tee_tadb_ta_delete(const TEE_UUID *uuid)
 
 	clear_file(db, entry.file_number);
 	res = write_ent(db, idx, &null_entry);
+	if (res)
+		index_clear();
+	else
+		index_del(uuid);
 	mutex_unlock(&tadb_mutex);
 
 	tee_tadb_close(db);
@@ -630,6 +908,14 @@ TEE_Result tee_tadb_ta_open(const TEE_UUID *uuid,
 	if (is_null_uuid(uuid))
 		return TEE_ERROR_GENERIC;
 
+	/* Most TAs aren't in the database, spare opening it */
+	mutex_read_lock(&tadb_mutex);
+	if (tadb_index_valid && !index_find(uuid))
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+	mutex_read_unlock(&tadb_mutex);
+	if (res)
+		return res;
+
 	ta = calloc(1, sizeof(*ta));
 	if (!ta)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -638,9 +924,9 @@ TEE_Result tee_tadb_ta_open(const TEE_UUID *uuid,
 	if (res)
 		goto err_free; /* Mustn't call tadb_put() */
 
-	mutex_read_lock(&tadb_mutex);
+	mutex_lock(&tadb_mutex);
 	res = find_ent(ta->db, uuid, &idx, &ta->entry);
-	mutex_read_unlock(&tadb_mutex);
+	mutex_unlock(&tadb_mutex);
 	if (res)
 		goto err;
 
@@ -20,12 +20,15 @@
 #include <crypto/crypto.h>
 #include <initcall.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/tee_common_otp.h>
 #include <kernel/tee_ta_manager.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <string.h>
 #include <string_ext.h>
+#include <sys/queue.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/tee_fs_key_manager.h>
 #include <trace.h>
@@ -38,6 +41,131 @@ struct tee_fs_ssk {
 
 static struct tee_fs_ssk tee_fs_ssk;
 
+/*
+ * struct key_cache_entry - cached TSK or decrypted FEK
+ * @uuid:	TA the key belongs to, if @have_uuid
+ * @have_uuid:	false for the keys of the storage not owned by a TA
+ * @is_fek:	@key is the FEK encrypted as @enc_fek, else the TSK
+ * @enc_fek:	Encrypted FEK
+ * @key:	TSK or first TEE_FS_KM_FEK_SIZE bytes for a FEK
+ * @link:	Link in the LRU list, most recently used first
+ */
+struct key_cache_entry {
+	TEE_UUID uuid;
+	bool have_uuid;
+	bool is_fek;
+	uint8_t enc_fek[TEE_FS_KM_FEK_SIZE];
+	uint8_t key[TEE_FS_KM_TSK_SIZE];
+	TAILQ_ENTRY(key_cache_entry) link;
+};
+
+static TAILQ_HEAD(key_cache_head, key_cache_entry) key_cache =
+	TAILQ_HEAD_INITIALIZER(key_cache);
+static size_t key_cache_count;
+static struct mutex key_cache_mutex = MUTEX_INITIALIZER;
+
+static struct key_cache_entry *key_cache_find(const TEE_UUID *uuid,
+					      const uint8_t *enc_fek)
+{
+	struct key_cache_entry *e = NULL;
+
+	TAILQ_FOREACH(e, &key_cache, link) {
+		if (e->have_uuid != !!uuid || e->is_fek != !!enc_fek)
+			continue;
+		if (uuid && memcmp(&e->uuid, uuid, sizeof(*uuid)))
+			continue;
+		if (enc_fek && memcmp(e->enc_fek, enc_fek, sizeof(e->enc_fek)))
+			continue;
+		return e;
+	}
+
+	return NULL;
+}
+
+static void key_cache_free(struct key_cache_entry *e)
+{
+	TAILQ_REMOVE(&key_cache, e, link);
+	key_cache_count--;
+	free_wipe(e);
+}
+
+/*
+ * Copies the cached TSK of @uuid, or the FEK encrypted as @enc_fek if not
+ * NULL, to @key of @key_size bytes. Returns false if not cached.
+ */
+static bool key_cache_get(const TEE_UUID *uuid, const uint8_t *enc_fek,
+			  uint8_t *key, size_t key_size)
+{
+	struct key_cache_entry *e = NULL;
+
+	if (!CFG_FS_KEY_CACHE_ENTRIES)
+		return false;
+
+	mutex_lock(&key_cache_mutex);
+	e = key_cache_find(uuid, enc_fek);
+	if (e) {
+		memcpy(key, e->key, key_size);
+		TAILQ_REMOVE(&key_cache, e, link);
+		TAILQ_INSERT_HEAD(&key_cache, e, link);
+	}
+	mutex_unlock(&key_cache_mutex);
+
+	return e;
+}
+
+static void key_cache_put(const TEE_UUID *uuid, const uint8_t *enc_fek,
+			  const uint8_t *key, size_t key_size)
+{
+	struct key_cache_entry *e = NULL;
+
+	if (!CFG_FS_KEY_CACHE_ENTRIES)
+		return;
+
+	assert(key_size <= sizeof(e->key));
+
+	mutex_lock(&key_cache_mutex);
+
+	if (key_cache_find(uuid, enc_fek))
+		goto out;
+
+	if (key_cache_count == CFG_FS_KEY_CACHE_ENTRIES)
+		key_cache_free(TAILQ_LAST(&key_cache, key_cache_head));
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		goto out;
+
+	if (uuid) {
+		e->uuid = *uuid;
+		e->have_uuid = true;
+	}
+	if (enc_fek) {
+		memcpy(e->enc_fek, enc_fek, sizeof(e->enc_fek));
+		e->is_fek = true;
+	}
+	memcpy(e->key, key, key_size);
+
+	TAILQ_INSERT_HEAD(&key_cache, e, link);
+	key_cache_count++;
+out:
+	mutex_unlock(&key_cache_mutex);
+}
+
+void tee_fs_key_cache_flush(const TEE_UUID *uuid)
+{
+	struct key_cache_entry *next = NULL;
+	struct key_cache_entry *e = NULL;
+
+	if (!CFG_FS_KEY_CACHE_ENTRIES)
+		return;
+
+	mutex_lock(&key_cache_mutex);
+	TAILQ_FOREACH_SAFE(e, &key_cache, link, next)
+		if (e->have_uuid && !memcmp(&e->uuid, uuid, sizeof(*uuid)))
+			key_cache_free(e);
+	mutex_unlock(&key_cache_mutex);
+}
+
 static TEE_Result do_hmac(void *out_key, size_t out_key_size,
 			  const void *in_key, size_t in_key_size,
 			  const void *message, size_t message_size)
@@ -71,6 +199,33 @@ exit:
 	return res;
 }
 
+static TEE_Result get_tsk(const TEE_UUID *uuid,
+			  uint8_t tsk[TEE_FS_KM_TSK_SIZE])
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (key_cache_get(uuid, NULL, tsk, TEE_FS_KM_TSK_SIZE))
+		return TEE_SUCCESS;
+
+	if (uuid) {
+		res = do_hmac(tsk, TEE_FS_KM_TSK_SIZE, tee_fs_ssk.key,
+			      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
+	} else {
+		/*
+		 * Pick something of a different size than TEE_UUID to
+		 * guarantee that there's never a conflict.
+		 */
+		uint8_t dummy[1] = { 0 };
+
+		res = do_hmac(tsk, TEE_FS_KM_TSK_SIZE, tee_fs_ssk.key,
+			      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
+	}
+	if (res == TEE_SUCCESS)
+		key_cache_put(uuid, NULL, tsk, TEE_FS_KM_TSK_SIZE);
+
+	return res;
+}
+
 TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 			    const uint8_t *in_key, size_t size,
 			    uint8_t *out_key)
@@ -89,23 +244,13 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 	if (tee_fs_ssk.is_init == 0)
 		return TEE_ERROR_GENERIC;
 
-	if (uuid) {
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, uuid, sizeof(*uuid));
-		if (res != TEE_SUCCESS)
-			return res;
-	} else {
-		/*
-		 * Pick something of a different size than TEE_UUID to
-		 * guarantee that there's never a conflict.
-		 */
-		uint8_t dummy[1] = { 0 };
+	if (mode == TEE_MODE_DECRYPT &&
+	    key_cache_get(uuid, in_key, out_key, size))
+		return TEE_SUCCESS;
 
-		res = do_hmac(tsk, sizeof(tsk), tee_fs_ssk.key,
-			      TEE_FS_KM_SSK_SIZE, dummy, sizeof(dummy));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
+	res = get_tsk(uuid, tsk);
+	if (res != TEE_SUCCESS)
+		return res;
 
 	res = crypto_cipher_alloc_ctx(&ctx, TEE_FS_KM_ENC_FEK_ALG);
 	if (res != TEE_SUCCESS)
@@ -121,6 +266,9 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 
 	crypto_cipher_final(ctx);
 
+	/* @in_key may be @out_key */
+	if (mode == TEE_MODE_DECRYPT)
+		key_cache_put(uuid, in_key, dst_key, sizeof(dst_key));
 	memcpy(out_key, dst_key, sizeof(dst_key));
 
 exit:
@@ -201,6 +201,79 @@ TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op)
 	return operation_commit(op);
 }
 
+TEE_Result tee_fs_rpc_writev_init(struct tee_fs_rpc_writev *wv,
+				  uint32_t id, int fd, size_t max_extents,
+				  size_t max_data_len)
+{
+	struct mobj *mobj = NULL;
+	size_t ext_len = 0;
+	size_t sz = 0;
+	uint8_t *va = NULL;
+
+	if (MUL_OVERFLOW(max_extents, 2 * sizeof(uint64_t), &ext_len) ||
+	    ADD_OVERFLOW(ext_len, max_data_len, &sz))
+		return TEE_ERROR_OVERFLOW;
+
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_FS,
+					THREAD_SHM_TYPE_APPLICATION,
+					sz, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	*wv = (struct tee_fs_rpc_writev){
+		.op = {
+			.id = id, .num_params = 3, .params = {
+				[0] = THREAD_PARAM_VALUE(IN,
+							 OPTEE_RPC_FS_WRITEV,
+							 fd, 0),
+				[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, 0),
+				[2] = THREAD_PARAM_MEMREF(IN, mobj, ext_len, 0),
+			},
+		},
+		.extents = (uint64_t *)(void *)va,
+		.data = va + ext_len,
+		.max_extents = max_extents,
+		.max_data_len = max_data_len,
+	};
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_fs_rpc_writev_add(struct tee_fs_rpc_writev *wv,
+				 tee_fs_off_t offset, size_t data_len,
+				 void **data)
+{
+	if (offset < 0)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (wv->num_extents == wv->max_extents ||
+	    data_len > wv->max_data_len - wv->data_len)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	wv->extents[2 * wv->num_extents] = offset;
+	wv->extents[2 * wv->num_extents + 1] = data_len;
+	wv->num_extents++;
+
+	*data = wv->data + wv->data_len;
+	wv->data_len += data_len;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_fs_rpc_writev_final(struct tee_fs_rpc_writev *wv)
+{
+	struct thread_param *params = wv->op.params;
+
+	if (!wv->num_extents)
+		return TEE_SUCCESS;
+
+	params[0].u.value.c = wv->num_extents;
+	params[1].u.memref.size = wv->num_extents * 2 * sizeof(uint64_t);
+	params[2].u.memref.size = wv->data_len;
+
+	return operation_commit(&wv->op);
+}
+
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len)
 {
 	struct tee_fs_rpc_operation op = {
@@ -3,6 +3,8 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <kernel/handle.h>
+#include <mm/slab.h>
 #include <mm/vm.h>
 #include <stdlib.h>
 #include <tee_api_defines.h>
@@ -13,28 +15,44 @@
 #include <tee/tee_svc_storage.h>
 #include <trace.h>
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
+SLAB_CACHE_DEFINE(tee_obj_cache, struct tee_obj, NULL);
+
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
 {
+	if (!handle_get_uref(&utc->obj_db, o, &utc->uref_gen, &o->uref))
+		return TEE_ERROR_OUT_OF_MEMORY;
 	TAILQ_INSERT_TAIL(&utc->objects, o, link);
+
+	return TEE_SUCCESS;
 }
 
-TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
+TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj)
 {
-	struct tee_obj *o;
+	struct tee_obj *o = NULL;
 
-	TAILQ_FOREACH(o, &utc->objects, link) {
-		if (obj_id == (vaddr_t)o) {
-			*obj = o;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_STATE;
+	/* The generation count rejects stale handles of closed objects */
+	o = handle_lookup(&utc->obj_db, uref_to_handle(obj_id));
+	if (!o || o->uref != obj_id)
+		return TEE_ERROR_BAD_STATE;
+
+	*obj = o;
+	return TEE_SUCCESS;
 }
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 {
+	TEE_Result res = TEE_SUCCESS;
+
+	/* Staged writes would be lost with the file handle */
+	if (o->staged) {
+		res = tee_svc_storage_commit_staged(utc);
+		if (res)
+			EMSG("Staged writes lost: %#"PRIx32, res);
+	}
+
 	TAILQ_REMOVE(&utc->objects, o, link);
+	handle_put(&utc->obj_db, uref_to_handle(o->uref));
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
 		o->pobj->fops->close(&o->fh);
@@ -47,9 +65,21 @@ void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 void tee_obj_close_all(struct user_ta_ctx *utc)
 {
 	struct tee_obj_head *objects = &utc->objects;
+	struct tee_obj *o = NULL;
+
+	/*
+	 * An uncommitted transaction is discarded, staged writes of write
+	 * behind objects are committed when closed.
+	 */
+	if (utc->storage_tx) {
+		utc->storage_tx = false;
+		TAILQ_FOREACH(o, objects, link)
+			o->staged = false;
+	}
 
 	while (!TAILQ_EMPTY(objects))
 		tee_obj_close(utc, TAILQ_FIRST(objects));
+	handle_db_destroy(&utc->obj_db, NULL);
 }
 
 TEE_Result tee_obj_verify(struct tee_ta_session *sess, struct tee_obj *o)
@@ -64,6 +94,7 @@ TEE_Result tee_obj_verify(struct tee_ta_session *sess, struct tee_obj *o)
 	res = fops->open(o->pobj, NULL, &fh);
 	if (res == TEE_ERROR_CORRUPT_OBJECT) {
 		EMSG("Object corrupt");
+		tee_svc_storage_head_cache_invalidate(o->pobj);
 		fops->remove(o->pobj);
 		tee_obj_close(to_user_ta_ctx(sess->ts_sess.ctx), o);
 	}
@@ -74,7 +105,7 @@ TEE_Result tee_obj_verify(struct tee_ta_session *sess, struct tee_obj *o)
 
 struct tee_obj *tee_obj_alloc(void)
 {
-	return calloc(1, sizeof(struct tee_obj));
+	return slab_alloc(&tee_obj_cache);
 }
 
 void tee_obj_free(struct tee_obj *o)
@@ -82,6 +113,6 @@ void tee_obj_free(struct tee_obj *o)
 	if (o) {
 		tee_obj_attr_free(o);
 		free(o->attr);
-		free(o);
+		slab_free(&tee_obj_cache, o);
 	}
 }
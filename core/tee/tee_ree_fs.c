@@ -16,6 +16,7 @@
 #include <string_ext.h>
 #include <string.h>
 #include <sys/queue.h>
+#include <tee_api_defines_extensions.h>
 #include <tee/fs_dirfile.h>
 #include <tee/fs_htree.h>
 #include <tee/tee_fs.h>
@@ -34,6 +35,7 @@ struct tee_fs_fd {
 	int fd;
 	struct tee_fs_dirfile_fileh dfh;
 	const TEE_UUID *uuid;
+	bool staged;
 };
 
 struct tee_fs_dir {
@@ -48,7 +50,13 @@ static int pos_to_block_num(int position)
 	return position >> BLOCK_SHIFT;
 }
 
-static struct mutex ree_fs_mutex = MUTEX_INITIALIZER;
+/*
+ * Protects ree_fs_dirh and the dirfile. The data of a file is only
+ * accessed through its struct tee_fs_fd which is used by one thread at a
+ * time, reading or writing it doesn't need the mutex. Only the update of
+ * the hash of the file in the dirfile does.
+ */
+static struct mutex ree_fs_mutex = MUTEX_INITIALIZER_NAMED("dirh");
 
 static void *get_tmp_block(void)
 {
@@ -247,12 +255,45 @@ static TEE_Result ree_fs_rpc_write_init(void *aux,
 				     offs, size, data);
 }
 
+#ifdef CFG_REE_FS_RPC_WRITEV
+static TEE_Result ree_fs_rpc_writev_init(void *aux,
+					 struct tee_fs_rpc_writev *wv,
+					 size_t max_entries, size_t max_len)
+{
+	struct tee_fs_fd *fdp = aux;
+
+	return tee_fs_rpc_writev_init(wv, OPTEE_RPC_CMD_FS, fdp->fd,
+				      max_entries, max_len);
+}
+
+static TEE_Result ree_fs_rpc_writev_add(void *aux __unused,
+					struct tee_fs_rpc_writev *wv,
+					enum tee_fs_htree_type type,
+					size_t idx, uint8_t vers, void **data)
+{
+	TEE_Result res;
+	size_t offs;
+	size_t size;
+
+	res = get_offs_size(type, idx, vers, &offs, &size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return tee_fs_rpc_writev_add(wv, offs, size, data);
+}
+#endif
+
 static const struct tee_fs_htree_storage ree_fs_storage_ops = {
 	.block_size = BLOCK_SIZE,
 	.rpc_read_init = ree_fs_rpc_read_init,
 	.rpc_read_final = tee_fs_rpc_read_final,
 	.rpc_write_init = ree_fs_rpc_write_init,
 	.rpc_write_final = tee_fs_rpc_write_final,
+#ifdef CFG_REE_FS_RPC_WRITEV
+	.rpc_writev_init = ree_fs_rpc_writev_init,
+	.rpc_writev_add = ree_fs_rpc_writev_add,
+	.rpc_writev_final = tee_fs_rpc_writev_final,
+#endif
 };
 
 static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
@@ -357,13 +398,7 @@ exit:
 static TEE_Result ree_fs_read(struct tee_file_handle *fh, size_t pos,
 			      void *buf, size_t *len)
 {
-	TEE_Result res;
-
-	mutex_lock(&ree_fs_mutex);
-	res = ree_fs_read_primitive(fh, pos, buf, len);
-	mutex_unlock(&ree_fs_mutex);
-
-	return res;
+	return ree_fs_read_primitive(fh, pos, buf, len);
 }
 
 static TEE_Result ree_fs_write_primitive(struct tee_file_handle *fh, size_t pos,
@@ -594,6 +629,13 @@ static void put_dirh(struct tee_fs_dirfile_dirh *dirh, bool close)
 	}
 }
 
+static void set_compress(struct tee_file_handle *fh, struct tee_pobj *po)
+{
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+
+	tee_fs_htree_set_compress(fdp->ht, po->flags & TEE_DATA_FLAG_COMPRESS);
+}
+
 static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 			      struct tee_file_handle **fh)
 {
@@ -619,10 +661,12 @@ static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 		 * treat it as corrupt.
 		 */
 		res = TEE_ERROR_CORRUPT_OBJECT;
-	} else if (!res && size) {
+	} else if (!res) {
 		struct tee_fs_fd *fdp = (struct tee_fs_fd *)*fh;
 
-		*size = tee_fs_htree_get_meta(fdp->ht)->length;
+		set_compress(*fh, po);
+		if (size)
+			*size = tee_fs_htree_get_meta(fdp->ht)->length;
 	}
 
 out:
@@ -675,10 +719,10 @@ static void ree_fs_close(struct tee_file_handle **fh)
 	if (*fh) {
 		mutex_lock(&ree_fs_mutex);
 		put_dirh_primitive(false);
-		ree_fs_close_primitive(*fh);
-		*fh = NULL;
 		mutex_unlock(&ree_fs_mutex);
 
+		ree_fs_close_primitive(*fh);
+		*fh = NULL;
 	}
 }
 
@@ -709,6 +753,8 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 	if (res)
 		goto out;
 
+	set_compress(*fh, po);
+
 	if (head && head_size) {
 		res = ree_fs_write_primitive(*fh, pos, head, head_size);
 		if (res)
@@ -749,12 +795,12 @@ out:
 	return res;
 }
 
-static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
-			       const void *buf, size_t len)
+/* Records the new hashes of the files in the dirfile with a single commit */
+static TEE_Result update_dirh_hash(struct tee_fs_fd **fdp, size_t num_fdp)
 {
 	TEE_Result res;
 	struct tee_fs_dirfile_dirh *dirh = NULL;
-	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+	size_t n = 0;
 
 	mutex_lock(&ree_fs_mutex);
 
@@ -762,17 +808,11 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 	if (res)
 		goto out;
 
-	res = ree_fs_write_primitive(fh, pos, buf, len);
-	if (res)
-		goto out;
-
-	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
-	if (res)
-		goto out;
-
-	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
-	if (res)
-		goto out;
+	for (n = 0; n < num_fdp; n++) {
+		res = tee_fs_dirfile_update_hash(dirh, &fdp[n]->dfh);
+		if (res)
+			goto out;
+	}
 	res = commit_dirh_writes(dirh);
 out:
 	put_dirh(dirh, res);
@@ -781,6 +821,23 @@ out:
 	return res;
 }
 
+static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
+			       const void *buf, size_t len)
+{
+	TEE_Result res;
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+
+	res = ree_fs_write_primitive(fh, pos, buf, len);
+	if (res || fdp->staged)
+		return res;
+
+	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+	if (res)
+		return res;
+
+	return update_dirh_hash(&fdp, 1);
+}
+
 static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 				bool overwrite)
 {
@@ -873,32 +930,53 @@ out:
 static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 {
 	TEE_Result res;
-	struct tee_fs_dirfile_dirh *dirh = NULL;
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
-	mutex_lock(&ree_fs_mutex);
-
-	res = get_dirh(&dirh);
-	if (res)
-		goto out;
-
 	res = ree_fs_ftruncate_internal(fdp, len);
-	if (res)
-		goto out;
+	if (res || fdp->staged)
+		return res;
 
 	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
 	if (res)
-		goto out;
+		return res;
+
+	return update_dirh_hash(&fdp, 1);
+}
+
+static void ree_fs_stage(struct tee_file_handle *fh)
+{
+	((struct tee_fs_fd *)fh)->staged = true;
+}
+
+/*
+ * The hash trees are synced one by one, each one is written to the
+ * version of its header not referenced by the dirfile. The new hashes
+ * only take effect when the dirfile is committed at the end so until then
+ * all the files remain in the state they had before they were staged.
+ */
+static TEE_Result ree_fs_commit_staged(struct tee_file_handle **fh,
+				       size_t num_fh)
+{
+	struct tee_fs_fd **fdp = (struct tee_fs_fd **)fh;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	for (n = 0; n < num_fh; n++) {
+		assert(fdp[n]->staged);
+		res = tee_fs_htree_sync_to_storage(&fdp[n]->ht,
+						   fdp[n]->dfh.hash);
+		if (res)
+			return res;
+	}
 
-	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+	res = update_dirh_hash(fdp, num_fh);
 	if (res)
-		goto out;
-	res = commit_dirh_writes(dirh);
-out:
-	put_dirh(dirh, res);
-	mutex_unlock(&ree_fs_mutex);
+		return res;
 
-	return res;
+	for (n = 0; n < num_fh; n++)
+		fdp[n]->staged = false;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result ree_fs_opendir_rpc(const TEE_UUID *uuid,
@@ -976,6 +1054,8 @@ const struct tee_file_operations ree_fs_ops = {
 	.read = ree_fs_read,
 	.write = ree_fs_write,
 	.truncate = ree_fs_truncate,
+	.stage = ree_fs_stage,
+	.commit_staged = ree_fs_commit_staged,
 	.rename = ree_fs_rename,
 	.remove = ree_fs_remove,
 	.opendir = ree_fs_opendir_rpc,
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <crypto/crypto.h>
 #include <kernel/huk_subkey.h>
 #include <kernel/misc.h>
@@ -37,12 +38,14 @@
 #define RPMB_CID_CRC_OFFSET             15
 
 #define RPMB_FS_MAGIC                   0x52504D42
-#define FS_VERSION                      2
+#define FS_VERSION                      3
+/* Version 2 didn't have rpmb_fat_entry::alloc_size, always cleared */
+#define FS_VERSION_NO_ALLOC_SIZE        2
 
 #define FILE_IS_ACTIVE                  (1u << 0)
 #define FILE_IS_LAST_ENTRY              (1u << 1)
 
-#define TEE_RPMB_FS_FILENAME_LENGTH 224
+#define TEE_RPMB_FS_FILENAME_LENGTH 220
 
 #define TMP_BLOCK_SIZE			4096U
 
@@ -68,6 +71,8 @@ struct rpmb_fs_parameters {
 
 /**
  * File entry for a single file in a RPMB_FS partition.
+ * @alloc_size is the size of the area reserved at @start_address, the
+ * data and the spare room after it. Only @data_size is reserved if lower.
  */
 struct rpmb_fat_entry {
 	uint32_t start_address;
@@ -76,6 +81,7 @@ struct rpmb_fat_entry {
 	uint32_t write_counter;
 	uint8_t fek[TEE_FS_KM_FEK_SIZE];
 	char filename[TEE_RPMB_FS_FILENAME_LENGTH];
+	uint32_t alloc_size;
 };
 
 /**
@@ -144,8 +150,28 @@ struct tee_fs_dir {
 	SIMPLEQ_HEAD(next_head, tee_rpmb_fs_dirent) next;
 };
 
+/**
+ * In-memory index of all FAT FS entries, used when CFG_RPMB_FS_FAT_INDEX is
+ * enabled. The entries are kept in FAT order, the last one being flagged
+ * with FILE_IS_LAST_ENTRY, and active entries are hashed by filename.
+ */
+struct rpmb_fat_index {
+	struct rpmb_fat_entry *entries;
+	/* Next entry in the same hash bucket, or FAT_INDEX_NONE */
+	uint32_t *chain;
+	uint32_t *buckets;
+	uint32_t num_entries;
+	uint32_t max_entries;
+	/* Always a power of 2 */
+	uint32_t num_buckets;
+};
+
+#define FAT_INDEX_NONE			UINT32_MAX
+#define FAT_INDEX_MIN_BUCKETS		16
+
 static struct rpmb_fs_parameters *fs_par;
 static struct rpmb_fat_entry_dir *fat_entry_dir;
+static struct rpmb_fat_index *fat_index;
 
 /*
  * Lower interface to RPMB device
@@ -404,70 +430,62 @@ func_exit:
 }
 
 struct tee_rpmb_mem {
-	struct mobj *phreq_mobj;
-	struct mobj *phresp_mobj;
+	struct mobj *mobj;
 	size_t req_size;
+	size_t resp_offs;
 	size_t resp_size;
 };
 
 static void tee_rpmb_free(struct tee_rpmb_mem *mem)
 {
-	if (!mem)
-		return;
-
-	if (mem->phreq_mobj) {
-		thread_rpc_free_payload(mem->phreq_mobj);
-		mem->phreq_mobj = NULL;
-	}
-	if (mem->phresp_mobj) {
-		thread_rpc_free_payload(mem->phresp_mobj);
-		mem->phresp_mobj = NULL;
-	}
+	/*
+	 * The buffer belongs to the per-thread RPC memory cache which is
+	 * released when the thread returns to normal world.
+	 */
+	if (mem)
+		mem->mobj = NULL;
 }
 
-
 static TEE_Result tee_rpmb_alloc(size_t req_size, size_t resp_size,
 		struct tee_rpmb_mem *mem, void **req, void **resp)
 {
-	TEE_Result res = TEE_SUCCESS;
 	size_t req_s = ROUNDUP(req_size, sizeof(uint32_t));
 	size_t resp_s = ROUNDUP(resp_size, sizeof(uint32_t));
+	size_t sz = 0;
+	uint8_t *va = NULL;
 
 	if (!mem)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	memset(mem, 0, sizeof(*mem));
 
-	mem->phreq_mobj = thread_rpc_alloc_payload(req_s);
-	mem->phresp_mobj = thread_rpc_alloc_payload(resp_s);
-
-	if (!mem->phreq_mobj || !mem->phresp_mobj) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
+	if (ADD_OVERFLOW(req_s, resp_s, &sz))
+		return TEE_ERROR_OVERFLOW;
 
-	*req = mobj_get_va(mem->phreq_mobj, 0);
-	*resp = mobj_get_va(mem->phresp_mobj, 0);
-	if (!*req || !*resp) {
-		res = TEE_ERROR_GENERIC;
-		goto out;
-	}
+	/*
+	 * Request and response share one buffer from the RPC memory cache,
+	 * saving the RPCs to allocate and free them for each request.
+	 */
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_RPMB,
+					THREAD_SHM_TYPE_APPLICATION, sz,
+					&mem->mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
 
+	*req = va;
+	*resp = va + req_s;
 	mem->req_size = req_size;
+	mem->resp_offs = req_s;
 	mem->resp_size = resp_size;
 
-out:
-	if (res != TEE_SUCCESS)
-		tee_rpmb_free(mem);
-	return res;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_rpmb_invoke(struct tee_rpmb_mem *mem)
 {
 	struct thread_param params[2] = {
-		[0] = THREAD_PARAM_MEMREF(IN, mem->phreq_mobj, 0,
-					  mem->req_size),
-		[1] = THREAD_PARAM_MEMREF(OUT, mem->phresp_mobj, 0,
+		[0] = THREAD_PARAM_MEMREF(IN, mem->mobj, 0, mem->req_size),
+		[1] = THREAD_PARAM_MEMREF(OUT, mem->mobj, mem->resp_offs,
 					  mem->resp_size),
 	};
 
@@ -827,7 +845,6 @@ static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 				     *rawdata->write_counter, wr_cnt + 1);
 				return TEE_ERROR_SECURITY;
 			}
-			rpmb_ctx->wr_cnt++;
 		}
 	}
 
@@ -1136,11 +1153,16 @@ static TEE_Result tee_rpmb_init(uint16_t dev_id)
 
 		memcpy(rpmb_ctx->cid, dev_info.cid, RPMB_EMMC_CID_SIZE);
 
-#ifdef RPMB_DRIVER_MULTIPLE_WRITE_FIXED
+		/*
+		 * The reliable write sector count is in units of 512 bytes,
+		 * that is two RPMB data frames per sector.
+		 */
+#if defined(CFG_RPMB_FS_MULTI_BLOCK_WRITE) || \
+	defined(RPMB_DRIVER_MULTIPLE_WRITE_FIXED)
 		rpmb_ctx->rel_wr_blkcnt = dev_info.rel_wr_sec_c * 2;
-#else
-		rpmb_ctx->rel_wr_blkcnt = 1;
 #endif
+		if (!rpmb_ctx->rel_wr_blkcnt)
+			rpmb_ctx->rel_wr_blkcnt = 1;
 
 		rpmb_ctx->dev_info_synced = true;
 	}
@@ -1184,6 +1206,10 @@ func_exit:
 /*
  * Read RPMB data in bytes.
  *
+ * Large reads are split into requests of at most CFG_RPMB_FS_RD_MAX_BLOCKS
+ * frames, all using the same RPC buffers. Each request is answered with a
+ * single MAC covering all its frames.
+ *
  * @dev_id     Device ID of the eMMC device.
  * @addr       Byte address of data.
  * @data       Pointer to the data.
@@ -1206,6 +1232,7 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	uint32_t resp_size;
 	uint16_t blk_idx;
 	uint16_t blkcnt;
+	uint16_t max_blkcnt;
 	uint8_t byte_offset;
 
 	if (!data || !len)
@@ -1224,51 +1251,71 @@ static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
+	max_blkcnt = blkcnt;
+	if (CFG_RPMB_FS_RD_MAX_BLOCKS)
+		max_blkcnt = MIN(blkcnt, CFG_RPMB_FS_RD_MAX_BLOCKS);
+
 	req_size = sizeof(struct rpmb_req) + RPMB_DATA_FRAME_SIZE;
-	resp_size = RPMB_DATA_FRAME_SIZE * blkcnt;
+	resp_size = RPMB_DATA_FRAME_SIZE * max_blkcnt;
 	res = tee_rpmb_alloc(req_size, resp_size, &mem,
 			     (void *)&req, (void *)&resp);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
-	msg_type = RPMB_MSG_TYPE_REQ_AUTH_DATA_READ;
-	res = crypto_rng_read(nonce, RPMB_NONCE_SIZE);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+	while (blkcnt) {
+		uint16_t cnt = MIN(blkcnt, max_blkcnt);
+		uint32_t cnt_len = MIN(len, (uint32_t)cnt * RPMB_DATA_SIZE -
+					    byte_offset);
 
-	memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
-	rawdata.msg_type = msg_type;
-	rawdata.nonce = nonce;
-	rawdata.blk_idx = &blk_idx;
-	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+		memset(req, 0, req_size);
+		msg_type = RPMB_MSG_TYPE_REQ_AUTH_DATA_READ;
+		res = crypto_rng_read(nonce, RPMB_NONCE_SIZE);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
 
-	req->block_count = blkcnt;
+		memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
+		rawdata.msg_type = msg_type;
+		rawdata.nonce = nonce;
+		rawdata.blk_idx = &blk_idx;
+		res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
 
-	DMSG("Read %u block%s at index %u", blkcnt, ((blkcnt > 1) ? "s" : ""),
-	     blk_idx);
+		req->block_count = cnt;
+		/* The response buffer must match the requested frame count */
+		mem.resp_size = RPMB_DATA_FRAME_SIZE * cnt;
 
-	res = tee_rpmb_invoke(&mem);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+		DMSG("Read %u block%s at index %u", cnt,
+		     ((cnt > 1) ? "s" : ""), blk_idx);
 
-	msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_READ;
+		res = tee_rpmb_invoke(&mem);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
 
-	memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
-	rawdata.msg_type = msg_type;
-	rawdata.block_count = &blkcnt;
-	rawdata.blk_idx = &blk_idx;
-	rawdata.nonce = nonce;
-	rawdata.key_mac = hmac;
-	rawdata.data = data;
+		msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_READ;
 
-	rawdata.len = len;
-	rawdata.byte_offset = byte_offset;
+		memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
+		rawdata.msg_type = msg_type;
+		rawdata.block_count = &cnt;
+		rawdata.blk_idx = &blk_idx;
+		rawdata.nonce = nonce;
+		rawdata.key_mac = hmac;
+		rawdata.data = data;
 
-	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, blkcnt, fek, uuid);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+		rawdata.len = cnt_len;
+		rawdata.byte_offset = byte_offset;
+
+		res = tee_rpmb_resp_unpack_verify(resp, &rawdata, cnt, fek,
+						  uuid);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
+
+		data += cnt_len;
+		len -= cnt_len;
+		blk_idx += cnt;
+		blkcnt -= cnt;
+		byte_offset = 0;
+	}
 
 	res = TEE_SUCCESS;
 
@@ -1284,7 +1331,7 @@ static TEE_Result write_req(uint16_t dev_id, uint16_t blk_idx,
 {
 	TEE_Result res = TEE_SUCCESS;
 	uint8_t hmac[RPMB_KEY_MAC_SIZE] = { };
-	uint32_t wr_cnt = rpmb_ctx->wr_cnt;
+	uint32_t wr_cnt = 0;
 	struct rpmb_raw_data rawdata = { };
 	size_t retry_count = 0;
 
@@ -1293,6 +1340,24 @@ static TEE_Result write_req(uint16_t dev_id, uint16_t blk_idx,
 	assert(mem->resp_size <= RPMB_DATA_FRAME_SIZE);
 
 	while (true) {
+		/*
+		 * The write counter is only read back from the device
+		 * after a failed attempt, else the value returned in the
+		 * last authenticated write response is used.
+		 */
+		if (!rpmb_ctx->wr_cnt_synced) {
+			res = tee_rpmb_verify_key_sync_counter(dev_id);
+			if (res) {
+				retry_count++;
+				if (retry_count >= RPMB_MAX_RETRIES)
+					goto out_of_retries;
+				DMSG("Counter sync failed, retrying %zu",
+				     retry_count);
+				continue;
+			}
+		}
+		wr_cnt = rpmb_ctx->wr_cnt;
+
 		memset(req, 0, mem->req_size);
 		memset(resp, 0, mem->resp_size);
 
@@ -1330,8 +1395,9 @@ static TEE_Result write_req(uint16_t dev_id, uint16_t blk_idx,
 			if (retry_count >= RPMB_MAX_RETRIES)
 				goto out_of_retries;
 			/*
-			 * To force wr_cnt sync next time, as it might get
-			 * out of sync due to inconsistent operation result!
+			 * To force wr_cnt sync before the next attempt, as
+			 * it might get out of sync due to inconsistent
+			 * operation result!
 			 */
 			rpmb_ctx->wr_cnt_synced = false;
 			DMSG("Write invoke failed, retrying %zu", retry_count);
@@ -1352,8 +1418,9 @@ static TEE_Result write_req(uint16_t dev_id, uint16_t blk_idx,
 			if (retry_count >= RPMB_MAX_RETRIES)
 				goto out_of_retries;
 			/*
-			 * To force wr_cnt sync next time, as it might get
-			 * out of sync due to inconsistent operation result!
+			 * To force wr_cnt sync before the next attempt, as
+			 * it might get out of sync due to inconsistent
+			 * operation result!
 			 */
 			rpmb_ctx->wr_cnt_synced = false;
 			DMSG("Write resp unpack verify failed, retrying %zu",
@@ -1361,6 +1428,9 @@ static TEE_Result write_req(uint16_t dev_id, uint16_t blk_idx,
 			continue;
 		}
 
+		/* wr_cnt is the authenticated counter of the response */
+		rpmb_ctx->wr_cnt = wr_cnt;
+
 		return TEE_SUCCESS;
 	}
 
@@ -1580,6 +1650,224 @@ func_exit:
 static TEE_Result get_fat_start_address(uint32_t *addr);
 static TEE_Result rpmb_fs_setup(void);
 
+static uint32_t fat_index_hash(const char *filename)
+{
+	uint32_t h = 2166136261U;
+	size_t n = 0;
+
+	for (n = 0; n < TEE_RPMB_FS_FILENAME_LENGTH && filename[n]; n++)
+		h = (h ^ (uint8_t)filename[n]) * 16777619U;
+
+	return h;
+}
+
+static void fat_index_free(void)
+{
+	if (fat_index) {
+		free(fat_index->entries);
+		free(fat_index->chain);
+		free(fat_index->buckets);
+		free(fat_index);
+		fat_index = NULL;
+	}
+}
+
+static void fat_index_link(uint32_t idx)
+{
+	struct rpmb_fat_entry *fe = fat_index->entries + idx;
+	uint32_t b = 0;
+
+	fat_index->chain[idx] = FAT_INDEX_NONE;
+	if (!(fe->flags & FILE_IS_ACTIVE))
+		return;
+
+	b = fat_index_hash(fe->filename) & (fat_index->num_buckets - 1);
+	fat_index->chain[idx] = fat_index->buckets[b];
+	fat_index->buckets[b] = idx;
+}
+
+static void fat_index_unlink(uint32_t idx)
+{
+	struct rpmb_fat_entry *fe = fat_index->entries + idx;
+	uint32_t *p = NULL;
+
+	if (!(fe->flags & FILE_IS_ACTIVE))
+		return;
+
+	p = fat_index->buckets +
+	    (fat_index_hash(fe->filename) & (fat_index->num_buckets - 1));
+	while (*p != FAT_INDEX_NONE) {
+		if (*p == idx) {
+			*p = fat_index->chain[idx];
+			return;
+		}
+		p = fat_index->chain + *p;
+	}
+}
+
+static TEE_Result fat_index_rehash(uint32_t num_buckets)
+{
+	uint32_t *buckets = NULL;
+	uint32_t n = 0;
+
+	buckets = malloc(num_buckets * sizeof(*buckets));
+	if (!buckets)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < num_buckets; n++)
+		buckets[n] = FAT_INDEX_NONE;
+
+	free(fat_index->buckets);
+	fat_index->buckets = buckets;
+	fat_index->num_buckets = num_buckets;
+
+	for (n = 0; n < fat_index->num_entries; n++)
+		fat_index_link(n);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result fat_index_grow(uint32_t max_entries)
+{
+	struct rpmb_fat_entry *entries = NULL;
+	uint32_t *chain = NULL;
+
+	entries = realloc(fat_index->entries, max_entries * sizeof(*entries));
+	if (!entries)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	fat_index->entries = entries;
+
+	chain = realloc(fat_index->chain, max_entries * sizeof(*chain));
+	if (!chain)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	fat_index->chain = chain;
+
+	fat_index->max_entries = max_entries;
+
+	return TEE_SUCCESS;
+}
+
+/**
+ * fat_index_init: Read in all FAT FS entries from RPMB storage and build the
+ * in-memory index. Does nothing if the index is already built.
+ */
+static TEE_Result fat_index_init(void)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct rpmb_fat_entry *fe = NULL;
+	uint32_t fat_address = 0;
+	uint32_t num_buckets = FAT_INDEX_MIN_BUCKETS;
+	uint32_t n = 0;
+
+	if (fat_index)
+		return TEE_SUCCESS;
+
+	res = get_fat_start_address(&fat_address);
+	if (res)
+		return res;
+
+	fat_index = calloc(1, sizeof(*fat_index));
+	if (!fat_index)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	while (true) {
+		if (fat_index->max_entries - fat_index->num_entries <
+		    CFG_RPMB_FS_RD_ENTRIES) {
+			res = fat_index_grow(MAX(fat_index->max_entries * 2,
+						 fat_index->num_entries +
+						 CFG_RPMB_FS_RD_ENTRIES));
+			if (res)
+				goto err;
+		}
+
+		fe = fat_index->entries + fat_index->num_entries;
+		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, fat_address +
+				    fat_index->num_entries * sizeof(*fe),
+				    (uint8_t *)fe,
+				    CFG_RPMB_FS_RD_ENTRIES * sizeof(*fe),
+				    NULL, NULL);
+		if (res)
+			goto err;
+
+		for (n = 0; n < CFG_RPMB_FS_RD_ENTRIES; n++) {
+			fat_index->num_entries++;
+			if (fe[n].flags & FILE_IS_LAST_ENTRY)
+				goto out;
+		}
+	}
+
+out:
+	while (num_buckets < fat_index->num_entries)
+		num_buckets *= 2;
+
+	res = fat_index_rehash(num_buckets);
+	if (!res)
+		return TEE_SUCCESS;
+err:
+	fat_index_free();
+	return res;
+}
+
+/**
+ * fat_index_find: Return the index of the first active FAT FS entry named
+ * filename, or FAT_INDEX_NONE if there's none.
+ */
+static uint32_t fat_index_find(const char *filename)
+{
+	uint32_t found = FAT_INDEX_NONE;
+	uint32_t idx = 0;
+
+	idx = fat_index->buckets[fat_index_hash(filename) &
+				 (fat_index->num_buckets - 1)];
+	for (; idx != FAT_INDEX_NONE; idx = fat_index->chain[idx])
+		if (idx < found &&
+		    !strcmp(fat_index->entries[idx].filename, filename))
+			found = idx;
+
+	return found;
+}
+
+/**
+ * fat_index_update: Update the index with the FAT FS entry fat_entry written
+ * to address fat_address in RPMB storage. The index is dropped if it can't be
+ * updated, it's then read in again from storage on next use.
+ */
+static void fat_index_update(struct rpmb_fat_entry *fat_entry,
+			     uint32_t fat_address)
+{
+	uint32_t idx = 0;
+
+	if (!fat_index)
+		return;
+
+	idx = (fat_address - RPMB_FS_FAT_START_ADDRESS) /
+	      sizeof(struct rpmb_fat_entry);
+
+	if (idx > fat_index->num_entries)
+		goto err;
+
+	if (idx == fat_index->num_entries) {
+		/* The FAT is expanded by one entry */
+		if (fat_index->num_entries == fat_index->max_entries &&
+		    fat_index_grow(fat_index->max_entries * 2))
+			goto err;
+		fat_index->num_entries++;
+	} else {
+		fat_index_unlink(idx);
+	}
+
+	memcpy(fat_index->entries + idx, fat_entry, sizeof(*fat_entry));
+	fat_index_link(idx);
+
+	if (fat_index->num_entries > fat_index->num_buckets &&
+	    fat_index_rehash(fat_index->num_buckets * 2))
+		goto err;
+
+	return;
+err:
+	fat_index_free();
+}
+
 /**
  * fat_entry_dir_free: Free the FAT entry dir.
  */
@@ -1620,6 +1908,14 @@ static TEE_Result fat_entry_dir_init(void)
 	if (!fat_entry_dir)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	/*
+	 * With the FAT FS entries all in memory there's nothing to buffer.
+	 * If the index can't be built, fall back to reading in the entries
+	 * from RPMB storage.
+	 */
+	if (IS_ENABLED(CFG_RPMB_FS_FAT_INDEX) && !fat_index_init())
+		return TEE_SUCCESS;
+
 	/*
 	 * If caching is enabled, read in up to the maximum cache size, but
 	 * never more than the single read in size. Otherwise, read in as many
@@ -1771,6 +2067,17 @@ static TEE_Result fat_entry_dir_get_next(struct rpmb_fat_entry **fat_entry,
 			(fat_entry_dir->num_total_read *
 			sizeof(struct rpmb_fat_entry));
 
+	/* All entries are in the index, no need to read from storage. */
+	if (fat_index) {
+		if (fat_entry_dir->num_total_read >= fat_index->num_entries) {
+			*fat_entry = NULL;
+			return TEE_SUCCESS;
+		}
+		fe = fat_index->entries;
+		fat_entry_dir->idx_curr = fat_entry_dir->num_total_read;
+		goto post_read_in;
+	}
+
 	/*
 	 * We've read all so-far buffered elements, so we need to
 	 * read in more entries from RPMB storage.
@@ -1893,9 +2200,10 @@ static void dump_fat(void)
 		if (res || !fe)
 			break;
 
-		FMSG("flags %#"PRIx32", size %"PRIu32", address %#"PRIx32
-		     ", filename '%s'",
-		     fe->flags, fe->data_size, fe->start_address, fe->filename);
+		FMSG("flags %#"PRIx32", size %"PRIu32", alloc %"PRIu32
+		     ", address %#"PRIx32", filename '%s'",
+		     fe->flags, fe->data_size, fe->alloc_size,
+		     fe->start_address, fe->filename);
 	}
 
 	fat_entry_dir_deinit();
@@ -1967,6 +2275,15 @@ static TEE_Result write_fat_entry(struct rpmb_file_handle *fh,
 			     (uint8_t *)&fh->fat_entry,
 			     sizeof(struct rpmb_fat_entry), NULL, NULL);
 
+	/*
+	 * The entry may or may not have been written if the write failed,
+	 * in that case rebuild the index from storage on next use.
+	 */
+	if (res)
+		fat_index_free();
+	else
+		fat_index_update(&fh->fat_entry, fh->rpmb_fat_address);
+
 	dump_fat();
 
 	/* If caching enabled, update a successfully written entry in cache. */
@@ -2005,6 +2322,8 @@ static TEE_Result rpmb_fs_setup(void)
 	 */
 	COMPILE_TIME_ASSERT(sizeof(struct rpmb_fs_partition) <=
 			    RPMB_DATA_SIZE);
+	/* FAT entries are written one RPMB block each */
+	COMPILE_TIME_ASSERT(sizeof(struct rpmb_fat_entry) == RPMB_DATA_SIZE);
 	partition_data = calloc(1, RPMB_DATA_SIZE);
 	if (!partition_data) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
@@ -2043,6 +2362,22 @@ static TEE_Result rpmb_fs_setup(void)
 		if (partition_data->fs_version == FS_VERSION) {
 			res = TEE_SUCCESS;
 			goto store_fs_par;
+		} else if (partition_data->fs_version ==
+			   FS_VERSION_NO_ALLOC_SIZE) {
+			/*
+			 * The entries have no spare room, only the version
+			 * is updated so older software doesn't reuse it.
+			 */
+			DMSG("Updating FS version");
+			partition_data->fs_version = FS_VERSION;
+			res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID,
+					     RPMB_STORAGE_START_ADDRESS,
+					     (uint8_t *)partition_data,
+					     sizeof(struct rpmb_fs_partition),
+					     NULL, NULL);
+			if (res != TEE_SUCCESS)
+				goto out;
+			goto store_fs_par;
 		} else {
 			EMSG("Wrong software is in use.");
 			res = TEE_ERROR_ACCESS_DENIED;
@@ -2095,6 +2430,10 @@ store_fs_par:
 	fs_par->fat_start_address = partition_data->fat_start_address;
 	fs_par->max_rpmb_address = max_rpmb_block << RPMB_BLOCK_SIZE_SHIFT;
 
+	/* Not fatal, the index is built on first use instead */
+	if (IS_ENABLED(CFG_RPMB_FS_FAT_INDEX) && fat_index_init())
+		DMSG("Failed to build the FAT FS index");
+
 	dump_fat();
 
 out:
@@ -2117,6 +2456,22 @@ static TEE_Result get_fat_start_address(uint32_t *addr)
 	return TEE_SUCCESS;
 }
 
+static uint32_t fat_entry_alloc_size(const struct rpmb_fat_entry *fe)
+{
+	return MAX(fe->alloc_size, fe->data_size);
+}
+
+/*
+ * Returns the size to allocate for a file with @data_size bytes of data
+ * including spare room for the file to grow without being moved.
+ */
+static size_t alloc_size_with_spare(size_t data_size)
+{
+	size_t spare = MIN(data_size, (size_t)CFG_RPMB_FS_PREALLOC_MAX);
+
+	return ROUNDUP(data_size + spare, RPMB_DATA_SIZE);
+}
+
 /**
  * read_fat: Read FAT entries
  * Return matching FAT entry for read, rm rename and stat.
@@ -2139,6 +2494,19 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 	if (res)
 		goto out;
 
+	/* Only the pool requires traversing the whole FAT. */
+	if (fat_index && !p) {
+		uint32_t idx = fat_index_find(fh->filename);
+
+		if (idx != FAT_INDEX_NONE) {
+			fh->rpmb_fat_address = RPMB_FS_FAT_START_ADDRESS +
+					       idx * sizeof(*fe);
+			memcpy(&fh->fat_entry, fat_index->entries + idx,
+			       sizeof(*fe));
+		}
+		goto check_found;
+	}
+
 	/*
 	 * The pool is used to represent the current RPMB layout. To find
 	 * a slot for the file tee_mm_alloc is called on the pool. Thus
@@ -2165,10 +2533,10 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 
 		/* Add existing files to memory pool. (write) */
 		if (p) {
-			if ((fe->flags & FILE_IS_ACTIVE) && fe->data_size > 0) {
-
+			if ((fe->flags & FILE_IS_ACTIVE) &&
+			    fat_entry_alloc_size(fe) > 0) {
 				mm = tee_mm_alloc2(p, fe->start_address,
-						   fe->data_size);
+						   fat_entry_alloc_size(fe));
 				if (!mm) {
 					res = TEE_ERROR_OUT_OF_MEMORY;
 					goto out;
@@ -2237,6 +2605,7 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 		}
 	}
 
+check_found:
 	if (!fh->rpmb_fat_address)
 		res = TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -2448,6 +2817,58 @@ static TEE_Result update_write_helper(struct rpmb_file_handle *fh,
 	return res;
 }
 
+/* Writes zeroes in the spare room of the file between @pos and @end */
+static TEE_Result write_zeroes(struct rpmb_file_handle *fh, size_t pos,
+			       size_t end)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *blk_buf = NULL;
+	size_t n = 0;
+
+	blk_buf = mempool_calloc(mempool_default, 1, TMP_BLOCK_SIZE);
+	if (!blk_buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	while (pos < end) {
+		n = MIN(TMP_BLOCK_SIZE, end - pos);
+		res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID,
+				     fh->fat_entry.start_address + pos,
+				     blk_buf, n, fh->fat_entry.fek, fh->uuid);
+		if (res != TEE_SUCCESS)
+			break;
+		pos += n;
+	}
+
+	mempool_free(mempool_default, blk_buf);
+
+	return res;
+}
+
+/*
+ * Writes at or beyond the end of the data of the file, in its spare room.
+ * The data written only becomes part of the file once the FAT entry with
+ * the new size is written.
+ */
+static TEE_Result append_in_place(struct rpmb_file_handle *fh, size_t pos,
+				  const void *buf, size_t size)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = write_zeroes(fh, fh->fat_entry.data_size, pos);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID,
+			     fh->fat_entry.start_address + pos, buf, size,
+			     fh->fat_entry.fek, fh->uuid);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	fh->fat_entry.data_size = pos + size;
+
+	return write_fat_entry(fh, true);
+}
+
 static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 					  size_t pos, const void *buf,
 					  size_t size)
@@ -2455,8 +2876,11 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 	TEE_Result res = TEE_ERROR_GENERIC;
 	tee_mm_pool_t p = { };
 	bool pool_result = false;
+	size_t new_size = 0;
 	size_t end = 0;
 	uint32_t start_addr = 0;
+	tee_mm_entry_t *mm = NULL;
+	uintptr_t new_fat_entry = 0;
 
 	if (!size)
 		return TEE_SUCCESS;
@@ -2468,18 +2892,7 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 
 	dump_fh(fh);
 
-	/* Upper memory allocation must be used for RPMB_FS. */
-	pool_result = tee_mm_init(&p,
-				  RPMB_STORAGE_START_ADDRESS,
-				  fs_par->max_rpmb_address,
-				  RPMB_BLOCK_SIZE_SHIFT,
-				  TEE_MM_POOL_HI_ALLOC);
-	if (!pool_result) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
-
-	res = read_fat(fh, &p);
+	res = read_fat(fh, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2501,32 +2914,60 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 		DMSG("Updating data in-place");
 		res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, start_addr, buf,
 				     size, fh->fat_entry.fek, fh->uuid);
-	} else {
-		/*
-		 * File must be extended, or update cannot be atomic: allocate,
-		 * read, update, write.
-		 */
-		size_t new_size = MAX(end, fh->fat_entry.data_size);
-		tee_mm_entry_t *mm = tee_mm_alloc(&p, new_size);
-		uintptr_t new_fat_entry = 0;
+		goto out;
+	}
 
-		DMSG("Need to re-allocate");
-		if (!mm) {
-			DMSG("RPMB: No space left");
-			res = TEE_ERROR_STORAGE_NO_SPACE;
-			goto out;
-		}
+	if (pos >= fh->fat_entry.data_size &&
+	    end <= fat_entry_alloc_size(&fh->fat_entry)) {
+		DMSG("Appending in spare room");
+		res = append_in_place(fh, pos, buf, size);
+		goto out;
+	}
 
-		new_fat_entry = tee_mm_get_smem(mm);
+	/*
+	 * File must be extended, or update cannot be atomic: allocate,
+	 * read, update, write. The pool is only needed here since it
+	 * requires traversing the whole FAT.
+	 */
 
-		res = update_write_helper(fh, pos, buf, size,
-					  new_fat_entry, new_size);
-		if (res == TEE_SUCCESS) {
-			fh->fat_entry.data_size = new_size;
-			fh->fat_entry.start_address = new_fat_entry;
+	/* Upper memory allocation must be used for RPMB_FS. */
+	pool_result = tee_mm_init(&p,
+				  RPMB_STORAGE_START_ADDRESS,
+				  fs_par->max_rpmb_address,
+				  RPMB_BLOCK_SIZE_SHIFT,
+				  TEE_MM_POOL_HI_ALLOC);
+	if (!pool_result) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
 
-			res = write_fat_entry(fh, true);
-		}
+	res = read_fat(fh, &p);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	DMSG("Need to re-allocate");
+	new_size = MAX(end, fh->fat_entry.data_size);
+	if (new_size > fh->fat_entry.data_size) {
+		/* Growing, reserve spare room for the next appends */
+		mm = tee_mm_alloc(&p, alloc_size_with_spare(new_size));
+	}
+	if (!mm)
+		mm = tee_mm_alloc(&p, new_size);
+	if (!mm) {
+		DMSG("RPMB: No space left");
+		res = TEE_ERROR_STORAGE_NO_SPACE;
+		goto out;
+	}
+
+	new_fat_entry = tee_mm_get_smem(mm);
+
+	res = update_write_helper(fh, pos, buf, size, new_fat_entry, new_size);
+	if (res == TEE_SUCCESS) {
+		fh->fat_entry.data_size = new_size;
+		fh->fat_entry.alloc_size = tee_mm_get_bytes(mm);
+		fh->fat_entry.start_address = new_fat_entry;
+
+		res = write_fat_entry(fh, true);
 	}
 
 out:
@@ -2661,6 +3102,7 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 	bool pool_result = false;
 	tee_mm_entry_t *mm;
 	uint32_t newsize;
+	uint32_t newalloc = 0;
 	uint8_t *newbuf = NULL;
 	uintptr_t newaddr;
 	TEE_Result res = TEE_ERROR_GENERIC;
@@ -2677,7 +3119,15 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	if (newsize > fh->fat_entry.data_size) {
+	if (newsize > fh->fat_entry.data_size &&
+	    newsize <= fat_entry_alloc_size(&fh->fat_entry)) {
+		/* Extend file in its spare room */
+		res = write_zeroes(fh, fh->fat_entry.data_size, newsize);
+		if (res != TEE_SUCCESS)
+			goto out;
+		newaddr = fh->fat_entry.start_address;
+		newalloc = fh->fat_entry.alloc_size;
+	} else if (newsize > fh->fat_entry.data_size) {
 		/* Extend file */
 
 		pool_result = tee_mm_init(&p,
@@ -2714,14 +3164,20 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 				     newsize, fh->fat_entry.fek, fh->uuid);
 		if (res != TEE_SUCCESS)
 			goto out;
-
+		newalloc = 0;
 	} else {
-		/* Don't change file location */
+		/*
+		 * Don't change file location, keep only the spare room the
+		 * file would have been given with its new size.
+		 */
 		newaddr = fh->fat_entry.start_address;
+		newalloc = MIN(fat_entry_alloc_size(&fh->fat_entry),
+			       alloc_size_with_spare(newsize));
 	}
 
 	/* fh->pos is unchanged */
 	fh->fat_entry.data_size = newsize;
+	fh->fat_entry.alloc_size = newalloc;
 	fh->fat_entry.start_address = newaddr;
 	res = write_fat_entry(fh, true);
 
@@ -5,12 +5,15 @@
  */
 
 #include <compiler.h>
+#include <config.h>
 #include <kernel/chip_services.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_common.h>
 #include <kernel/tee_common_otp.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/tee_time.h>
+#include <kernel/time_page.h>
 #include <kernel/trace_ta.h>
 #include <kernel/user_access.h>
 #include <mm/core_memprot.h>
@@ -109,26 +112,23 @@ static const uint32_t fw_impl_bin_version; /* 0 by default */
 /* Trusted firmware manufacturer name */
 static const char fw_manufacturer[] = TO_STR(CFG_TEE_FW_MANUFACTURER);
 
-static TEE_Result get_prop_tee_dev_id(struct ts_session *sess __unused,
-				      void *buf, size_t *blen)
+/* The device ID is derived from the die ID once, on first use */
+static TEE_UUID tee_dev_id;
+static bool tee_dev_id_valid;
+static struct mutex tee_dev_id_mu = MUTEX_INITIALIZER;
+
+static TEE_Result derive_tee_dev_id(TEE_UUID *uuid)
 {
 	TEE_Result res;
-	TEE_UUID uuid;
 	const size_t nslen = 5;
 	uint8_t data[5 + FVR_DIE_ID_NUM_REGS * sizeof(uint32_t)] = {
 	    'O', 'P', 'T', 'E', 'E' };
 
-	if (*blen < sizeof(uuid)) {
-		*blen = sizeof(uuid);
-		return TEE_ERROR_SHORT_BUFFER;
-	}
-	*blen = sizeof(uuid);
-
 	if (tee_otp_get_die_id(data + nslen, sizeof(data) - nslen))
 		return TEE_ERROR_BAD_STATE;
 
 	res = tee_hash_createdigest(TEE_ALG_SHA256, data, sizeof(data),
-				    (uint8_t *)&uuid, sizeof(uuid));
+				    (uint8_t *)uuid, sizeof(*uuid));
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_BAD_STATE;
 
@@ -141,12 +141,37 @@ static TEE_Result get_prop_tee_dev_id(struct ts_session *sess __unused,
 	 * but close enough for our purpose.
 	 */
 
-	uuid.timeHiAndVersion &= 0x0fff;
-	uuid.timeHiAndVersion |= 5 << 12;
+	uuid->timeHiAndVersion &= 0x0fff;
+	uuid->timeHiAndVersion |= 5 << 12;
 
 	/* uuid.clock_seq_hi_and_reserved in the RFC */
-	uuid.clockSeqAndNode[0] &= 0x3f;
-	uuid.clockSeqAndNode[0] |= 0x80;
+	uuid->clockSeqAndNode[0] &= 0x3f;
+	uuid->clockSeqAndNode[0] |= 0x80;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_prop_tee_dev_id(struct ts_session *sess __unused,
+				      void *buf, size_t *blen)
+{
+	TEE_Result res = TEE_SUCCESS;
+	TEE_UUID uuid = { };
+
+	if (*blen < sizeof(uuid)) {
+		*blen = sizeof(uuid);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	*blen = sizeof(uuid);
+
+	mutex_lock(&tee_dev_id_mu);
+	if (!tee_dev_id_valid) {
+		res = derive_tee_dev_id(&tee_dev_id);
+		tee_dev_id_valid = !res;
+	}
+	uuid = tee_dev_id;
+	mutex_unlock(&tee_dev_id_mu);
+	if (res)
+		return res;
 
 	return copy_to_user(buf, &uuid, sizeof(TEE_UUID));
 }
@@ -488,6 +513,103 @@ out:
 	return res;
 }
 
+/*
+ * Writes the property as a struct utee_prop_rec at @offs of @buf, if
+ * there's room for it in @buf_len, and updates @offs past it in any case.
+ * Returns TEE_ERROR_SHORT_BUFFER if the property doesn't fit.
+ */
+static TEE_Result put_prop_rec(struct ts_session *sess,
+			       const struct tee_props *prop, uint8_t *buf,
+			       size_t buf_len, size_t *offs)
+{
+	struct utee_prop_rec rec = { .prop_type = prop->prop_type };
+	size_t value_offs = 0;
+	size_t rec_len = 0;
+	size_t vlen = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	rec.name_len = strlen(prop->name) + 1;
+	value_offs = *offs + sizeof(rec) + rec.name_len;
+
+	if (prop->get_prop_func) {
+		/* Only gives the length of the value if there's no room */
+		if (value_offs < buf_len)
+			vlen = buf_len - value_offs;
+		res = prop->get_prop_func(sess, buf + value_offs, &vlen);
+		if (res && res != TEE_ERROR_SHORT_BUFFER)
+			return res;
+	} else {
+		vlen = prop->len;
+		if (value_offs + vlen > buf_len)
+			res = TEE_ERROR_SHORT_BUFFER;
+		else
+			res = copy_to_user(buf + value_offs, prop->data, vlen);
+		if (res && res != TEE_ERROR_SHORT_BUFFER)
+			return res;
+	}
+	rec.value_len = vlen;
+
+	rec_len = ROUNDUP(sizeof(rec) + rec.name_len + vlen,
+			  UTEE_PROP_REC_ALIGN);
+	if (!res && *offs + rec_len <= buf_len) {
+		res = copy_to_user(buf + *offs, &rec, sizeof(rec));
+		if (!res)
+			res = copy_to_user(buf + *offs + sizeof(rec),
+					   prop->name, rec.name_len);
+		if (res)
+			return res;
+	} else {
+		res = TEE_ERROR_SHORT_BUFFER;
+	}
+	*offs += rec_len;
+
+	return res;
+}
+
+TEE_Result syscall_get_property_set(unsigned long prop_set, void *buf,
+				    uint32_t *blen)
+{
+	struct ts_session *sess = ts_get_current_session();
+	TEE_Result short_res = TEE_SUCCESS;
+	TEE_Result res = TEE_SUCCESS;
+	const struct tee_props *props = NULL;
+	const struct tee_props *vendor_props = NULL;
+	size_t vendor_size = 0;
+	size_t size = 0;
+	size_t offs = 0;
+	uint32_t klen = 0;
+	size_t n = 0;
+
+	get_prop_set(prop_set, &props, &size, &vendor_props, &vendor_size);
+	if (!props)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	res = copy_from_user(&klen, blen, sizeof(klen));
+	if (res)
+		return res;
+	if (!buf)
+		klen = 0;
+
+	for (n = 0; n < size + vendor_size; n++) {
+		if (n < size)
+			res = put_prop_rec(sess, props + n, buf, klen, &offs);
+		else
+			res = put_prop_rec(sess, vendor_props + n - size, buf,
+					   klen, &offs);
+		if (res == TEE_ERROR_SHORT_BUFFER)
+			short_res = res;
+		else if (res)
+			return res;
+	}
+
+	klen = offs;
+	res = copy_to_user(blen, &klen, sizeof(klen));
+	if (res)
+		return res;
+
+	return short_res;
+}
+
 static TEE_Result utee_param_to_param(struct user_ta_ctx *utc,
 				      struct tee_ta_param *p,
 				      struct utee_params *up)
@@ -510,6 +632,7 @@ static TEE_Result utee_param_to_param(struct user_ta_ctx *utc,
 		case TEE_PARAM_TYPE_MEMREF_INPUT:
 			p->u[n].mem.offs = a;
 			p->u[n].mem.size = b;
+			p->u[n].mem.readonly = false;
 
 			if (!p->u[n].mem.offs) {
 				/* Allow NULL memrefs if of size 0 */
@@ -554,11 +677,38 @@ static TEE_Result alloc_temp_sec_mem(size_t size, struct mobj **mobj,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Private memory of the calling TA made of whole pages can be mapped into
+ * the called TA instead of being copied, the calling TA is blocked until
+ * the called TA returns.
+ */
+static bool can_lend_memref(void *va, size_t size)
+{
+	if (!IS_ENABLED(CFG_TA_LEND_PRIV_MEMREF))
+		return false;
+
+	return !((vaddr_t)va & CORE_MMU_USER_PARAM_MASK) &&
+	       !(size & CORE_MMU_USER_PARAM_MASK);
+}
+
+static TEE_Result lend_memref(const struct user_mode_ctx *uctx,
+			      uint32_t types, size_t n, struct param_mem *mem)
+{
+	void *va = (void *)mem->offs;
+
+	mem->readonly = TEE_PARAM_TYPE_GET(types, n) ==
+			TEE_PARAM_TYPE_MEMREF_INPUT;
+
+	return vm_buf_to_mboj_offs(uctx, va, mem->size, &mem->mobj,
+				   &mem->offs);
+}
+
 /*
  * TA invokes some TA with parameter.
  * If some parameters are memory references:
  * - either the memref is inside TA private RAM: TA is not allowed to expose
- *   its private RAM: use a temporary memory buffer and copy the data.
+ *   its private RAM: use a temporary memory buffer and copy the data,
+ *   unless the memref can be lent to the called TA.
  * - or the memref is not in the TA private RAM:
  *   - if the memref was mapped to the TA, TA is allowed to expose it.
  *   - if so, converts memref virtual address into a physical address.
@@ -623,6 +773,14 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 			}
 			/* uTA cannot expose its private memory */
 			if (vm_buf_is_inside_um_private(&utc->uctx, va, s)) {
+				if (can_lend_memref(va, s)) {
+					res = lend_memref(&utc->uctx,
+							  param->types, n,
+							  &param->u[n].mem);
+					if (res != TEE_SUCCESS)
+						return res;
+					break;
+				}
 				s = ROUNDUP(s, sizeof(uint32_t));
 				if (ADD_OVERFLOW(req_mem, s, &req_mem))
 					return TEE_ERROR_BAD_PARAMETERS;
@@ -935,32 +1093,29 @@ TEE_Result syscall_wait(unsigned long timeout)
 {
 	struct ts_session *s = ts_get_current_session();
 	TEE_Result res = TEE_SUCCESS;
-	uint32_t mytime = 0;
-	TEE_Time base_time = { };
-	TEE_Time current_time = { };
+	uint64_t elapsed_ms = 0;
+	uint64_t base_ns = 0;
+	uint64_t now_ns = 0;
 
-	res = tee_time_get_sys_time(&base_time);
+	res = tee_time_get_sys_time_ns(&base_ns);
 	if (res != TEE_SUCCESS)
 		return res;
+	now_ns = base_ns;
 
 	while (true) {
-		res = tee_time_get_sys_time(&current_time);
-		if (res != TEE_SUCCESS)
-			return res;
-
-		if (tee_ta_session_is_cancelled(to_ta_session(s),
-						&current_time))
+		if (tee_ta_session_is_cancelled(to_ta_session(s), &now_ns))
 			return TEE_ERROR_CANCEL;
 
-		mytime = (current_time.seconds - base_time.seconds) * 1000 +
-		    (int)current_time.millis - (int)base_time.millis;
-		if (mytime >= timeout)
+		elapsed_ms = (now_ns - base_ns) / TEE_TIME_NSEC_PER_MSEC;
+		if (elapsed_ms >= timeout)
 			return TEE_SUCCESS;
 
-		tee_time_wait(timeout - mytime);
-	}
+		tee_time_wait(timeout - elapsed_ms);
 
-	return res;
+		res = tee_time_get_sys_time_ns(&now_ns);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
 }
 
 TEE_Result syscall_get_time(unsigned long cat, TEE_Time *mytime)
@@ -994,6 +1149,22 @@ TEE_Result syscall_get_time(unsigned long cat, TEE_Time *mytime)
 	return res;
 }
 
+TEE_Result syscall_get_time_page(uint64_t *va)
+{
+	struct ts_session *s = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t v = 0;
+	uint64_t v64 = 0;
+
+	res = time_page_map(&utc->uctx, &v);
+	if (res)
+		return res;
+
+	v64 = v;
+	return copy_to_user_private(va, &v64, sizeof(v64));
+}
+
 TEE_Result syscall_set_ta_time(const TEE_Time *mytime)
 {
 	struct ts_session *s = ts_get_current_session();
@@ -9,8 +9,10 @@
 #include <compiler.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <kernel/handle.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/user_access.h>
+#include <mm/slab.h>
 #include <mm/vm.h>
 #include <stdlib_ext.h>
 #include <string_ext.h>
@@ -45,13 +47,16 @@ struct tee_cryp_state {
 	TAILQ_ENTRY(tee_cryp_state) link;
 	uint32_t algo;
 	uint32_t mode;
-	vaddr_t key1;
-	vaddr_t key2;
+	uint32_t key1;
+	uint32_t key2;
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 	enum cryp_state state;
+	uint32_t uref;
 };
 
+SLAB_CACHE_DEFINE(cryp_state_cache, struct tee_cryp_state, NULL);
+
 struct tee_cryp_obj_secret {
 	uint32_t key_size;
 	uint32_t alloc_size;
@@ -78,6 +83,10 @@ struct tee_cryp_obj_secret {
 #define ATTR_OPS_INDEX_BIGNUM     1
     /* Convert to/from value attribute depending on direction */
 #define ATTR_OPS_INDEX_VALUE      2
+    /* Handle storing of fixed size X25519 and Ed25519 keys */
+#define ATTR_OPS_INDEX_25519      3
+
+#define KEY_SIZE_BYTES_25519	32
 
 struct tee_cryp_obj_type_attrs {
 	uint32_t attr_id;
@@ -383,6 +392,50 @@ static const struct tee_cryp_obj_type_attrs tee_cryp_obj_ecc_keypair_attrs[] = {
 	},
 };
 
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_x25519_keypair_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_X25519_PRIVATE_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct x25519_keypair, priv)
+	},
+
+	{
+	.attr_id = TEE_ATTR_X25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct x25519_keypair, pub)
+	},
+};
+
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_ed25519_pub_key_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_ED25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_public_key, pub)
+	},
+};
+
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_ed25519_keypair_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_ED25519_PRIVATE_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_keypair, priv)
+	},
+
+	{
+	.attr_id = TEE_ATTR_ED25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_keypair, pub)
+	},
+};
+
 struct tee_cryp_obj_type_props {
 	TEE_ObjectType obj_type;
 	uint16_t min_size;	/* may not be smaller than this */
@@ -394,11 +447,24 @@ struct tee_cryp_obj_type_props {
 	const struct tee_cryp_obj_type_attrs *type_attrs;
 };
 
+/*
+ * tee_cryp_obj_props[] is indexed with a multiplicative hash of the object
+ * type, the multiplier is chosen so that none of the supported types
+ * collide. Two types ending up in the same slot are caught at build time
+ * by -Woverride-init since the array has designated initializers.
+ */
+#define TYPE_PROPS_SLOT_BITS	6
+#define TYPE_PROPS_SLOT(obj_type) \
+		(((uint32_t)(obj_type) * 0xf91c85fdU) >> \
+		 (32 - TYPE_PROPS_SLOT_BITS))
+
 #define PROP(obj_type, quanta, min_size, max_size, alloc_size, type_attrs) \
+		[TYPE_PROPS_SLOT(obj_type)] = \
 		{ (obj_type), (min_size), (max_size), (alloc_size), (quanta), \
 		  ARRAY_SIZE(type_attrs), (type_attrs) }
 
-static const struct tee_cryp_obj_type_props tee_cryp_obj_props[] = {
+static const struct tee_cryp_obj_type_props
+	tee_cryp_obj_props[BIT(TYPE_PROPS_SLOT_BITS)] = {
 	PROP(TEE_TYPE_AES, 64, 128, 256,	/* valid sizes 128, 192, 256 */
 		256 / 8 + sizeof(struct tee_cryp_obj_secret),
 		tee_cryp_obj_secret_value_attrs),
@@ -413,6 +479,9 @@ static const struct tee_cryp_obj_type_props tee_cryp_obj_props[] = {
 	PROP(TEE_TYPE_SM4, 128, 128, 128,
 		128 / 8 + sizeof(struct tee_cryp_obj_secret),
 		tee_cryp_obj_secret_value_attrs),
+	PROP(TEE_TYPE_CHACHA20, 8, 256, 256,
+		256 / 8 + sizeof(struct tee_cryp_obj_secret),
+		tee_cryp_obj_secret_value_attrs),
 	PROP(TEE_TYPE_HMAC_MD5, 8, 64, 512,
 		512 / 8 + sizeof(struct tee_cryp_obj_secret),
 		tee_cryp_obj_secret_value_attrs),
@@ -511,6 +580,18 @@ static const struct tee_cryp_obj_type_props tee_cryp_obj_props[] = {
 	PROP(TEE_TYPE_SM2_KEP_KEYPAIR, 1, 256, 256,
 	     sizeof(struct ecc_keypair),
 	     tee_cryp_obj_ecc_keypair_attrs),
+
+	PROP(TEE_TYPE_X25519_KEYPAIR, 1, 256, 256,
+	     sizeof(struct x25519_keypair),
+	     tee_cryp_obj_x25519_keypair_attrs),
+
+	PROP(TEE_TYPE_ED25519_PUBLIC_KEY, 1, 256, 256,
+	     sizeof(struct ed25519_public_key),
+	     tee_cryp_obj_ed25519_pub_key_attrs),
+
+	PROP(TEE_TYPE_ED25519_KEYPAIR, 1, 256, 256,
+	     sizeof(struct ed25519_keypair),
+	     tee_cryp_obj_ed25519_keypair_attrs),
 };
 
 struct attr_ops {
@@ -832,6 +913,86 @@ static void op_attr_value_clear(void *attr)
 	*v = 0;
 }
 
+static TEE_Result op_attr_25519_from_user(void *attr, const void *buffer,
+					  size_t size)
+{
+	if (size != KEY_SIZE_BYTES_25519)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(attr, buffer, size);
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_attr_25519_to_user(void *attr,
+					struct ts_session *sess __unused,
+					void *buffer, uint64_t *size)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t req_size = KEY_SIZE_BYTES_25519;
+	uint64_t s = 0;
+
+	res = copy_from_user(&s, size, sizeof(s));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = copy_to_user(size, &req_size, sizeof(req_size));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (s < req_size || !buffer)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	return copy_to_user(buffer, attr, req_size);
+}
+
+static TEE_Result op_attr_25519_to_binary(void *attr, void *data,
+					  size_t data_len, size_t *offs)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t next_offs = 0;
+
+	res = op_u32_to_binary_helper(KEY_SIZE_BYTES_25519, data, data_len,
+				      offs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (ADD_OVERFLOW(*offs, KEY_SIZE_BYTES_25519, &next_offs))
+		return TEE_ERROR_OVERFLOW;
+
+	if (data && next_offs <= data_len)
+		memcpy((uint8_t *)data + *offs, attr, KEY_SIZE_BYTES_25519);
+	(*offs) = next_offs;
+
+	return TEE_SUCCESS;
+}
+
+static bool op_attr_25519_from_binary(void *attr, const void *data,
+				      size_t data_len, size_t *offs)
+{
+	uint32_t s = 0;
+
+	if (!op_u32_from_binary_helper(&s, data, data_len, offs))
+		return false;
+
+	if (s != KEY_SIZE_BYTES_25519 || (*offs + s) > data_len)
+		return false;
+
+	memcpy(attr, (const uint8_t *)data + *offs, s);
+	(*offs) += s;
+	return true;
+}
+
+static TEE_Result op_attr_25519_from_obj(void *attr, void *src_attr)
+{
+	memcpy(attr, src_attr, KEY_SIZE_BYTES_25519);
+	return TEE_SUCCESS;
+}
+
+static void op_attr_25519_clear(void *attr)
+{
+	memzero_explicit(attr, KEY_SIZE_BYTES_25519);
+}
+
 static const struct attr_ops attr_ops[] = {
 	[ATTR_OPS_INDEX_SECRET] = {
 		.from_user = op_attr_secret_value_from_user,
@@ -860,6 +1021,15 @@ static const struct attr_ops attr_ops[] = {
 		.free = op_attr_value_clear, /* not a typo */
 		.clear = op_attr_value_clear,
 	},
+	[ATTR_OPS_INDEX_25519] = {
+		.from_user = op_attr_25519_from_user,
+		.to_user = op_attr_25519_to_user,
+		.to_binary = op_attr_25519_to_binary,
+		.from_binary = op_attr_25519_from_binary,
+		.from_obj = op_attr_25519_from_obj,
+		.free = op_attr_25519_clear, /* not a typo */
+		.clear = op_attr_25519_clear,
+	},
 };
 
 static TEE_Result get_user_u64_as_size_t(size_t *dst, uint64_t *src)
@@ -891,7 +1061,7 @@ TEE_Result syscall_cryp_obj_get_info(unsigned long obj, TEE_ObjectInfo *info)
 	struct tee_obj *o = NULL;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(obj), &o);
+			  obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -908,7 +1078,7 @@ TEE_Result syscall_cryp_obj_restrict_usage(unsigned long obj,
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -934,14 +1104,14 @@ static int tee_svc_cryp_obj_find_type_attr_idx(
 static const struct tee_cryp_obj_type_props *tee_svc_find_type_props(
 		TEE_ObjectType obj_type)
 {
-	size_t n;
+	const struct tee_cryp_obj_type_props *tp = NULL;
 
-	for (n = 0; n < ARRAY_SIZE(tee_cryp_obj_props); n++) {
-		if (tee_cryp_obj_props[n].obj_type == obj_type)
-			return tee_cryp_obj_props + n;
-	}
+	tp = tee_cryp_obj_props + TYPE_PROPS_SLOT(obj_type);
+	/* Unused slots are all zero */
+	if (!tp->type_attrs || tp->obj_type != obj_type)
+		return NULL;
 
-	return NULL;
+	return tp;
 }
 
 /* Set an attribute on an object */
@@ -979,7 +1149,7 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	const struct attr_ops *ops = NULL;
 	void *attr = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -1157,6 +1327,9 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 		} else if (o->info.objectType == TEE_TYPE_SM2_KEP_PUBLIC_KEY) {
 			if (src->info.objectType != TEE_TYPE_SM2_KEP_KEYPAIR)
 				return TEE_ERROR_BAD_PARAMETERS;
+		} else if (o->info.objectType == TEE_TYPE_ED25519_PUBLIC_KEY) {
+			if (src->info.objectType != TEE_TYPE_ED25519_KEYPAIR)
+				return TEE_ERROR_BAD_PARAMETERS;
 		} else {
 			return TEE_ERROR_BAD_PARAMETERS;
 		}
@@ -1286,6 +1459,11 @@ TEE_Result tee_obj_set_type(struct tee_obj *o, uint32_t obj_type,
 		res = crypto_acipher_alloc_ecc_keypair(o->attr, obj_type,
 						       max_key_size);
 		break;
+	case TEE_TYPE_X25519_KEYPAIR:
+	case TEE_TYPE_ED25519_PUBLIC_KEY:
+	case TEE_TYPE_ED25519_KEYPAIR:
+		/* The keys are stored in fixed size arrays, nothing to do */
+		break;
 	default:
 		if (obj_type != TEE_TYPE_DATA) {
 			struct tee_cryp_obj_secret *key = o->attr;
@@ -1324,9 +1502,13 @@ TEE_Result syscall_cryp_obj_alloc(unsigned long obj_type,
 		return res;
 	}
 
-	tee_obj_add(to_user_ta_ctx(sess->ctx), o);
+	res = tee_obj_add(to_user_ta_ctx(sess->ctx), o);
+	if (res != TEE_SUCCESS) {
+		tee_obj_free(o);
+		return res;
+	}
 
-	res = copy_kaddr_to_uref(obj, o);
+	res = copy_to_user_private(obj, &o->uref, sizeof(o->uref));
 	if (res != TEE_SUCCESS)
 		tee_obj_close(to_user_ta_ctx(sess->ctx), o);
 	return res;
@@ -1338,7 +1520,7 @@ TEE_Result syscall_cryp_obj_close(unsigned long obj)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1359,7 +1541,7 @@ TEE_Result syscall_cryp_obj_reset(unsigned long obj)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1636,17 +1818,17 @@ static TEE_Result tee_svc_cryp_obj_populate_type(
 	return TEE_SUCCESS;
 }
 
-TEE_Result syscall_cryp_obj_populate(unsigned long obj,
-			struct utee_attribute *usr_attrs,
-			unsigned long attr_count)
+static TEE_Result obj_populate(struct user_ta_ctx *utc, uint32_t obj,
+			       const struct utee_attribute *usr_attrs,
+			       size_t attr_count)
 {
-	struct ts_session *sess = ts_get_current_session();
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 	const struct tee_cryp_obj_type_props *type_props = NULL;
 	TEE_Attribute *attrs = NULL;
+	size_t alloc_size = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1662,8 +1844,6 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 	if (!type_props)
 		return TEE_ERROR_NOT_IMPLEMENTED;
 
-	size_t alloc_size = 0;
-
 	if (MUL_OVERFLOW(sizeof(TEE_Attribute), attr_count, &alloc_size))
 		return TEE_ERROR_OVERFLOW;
 
@@ -1671,8 +1851,7 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 	if (!attrs)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	res = copy_in_attrs(to_user_ta_ctx(sess->ctx), usr_attrs, attr_count,
-			    attrs);
+	res = copy_in_attrs(utc, usr_attrs, attr_count, attrs);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -1690,6 +1869,49 @@ out:
 	return res;
 }
 
+TEE_Result syscall_cryp_obj_populate(unsigned long obj,
+			struct utee_attribute *usr_attrs,
+			unsigned long attr_count)
+{
+	struct ts_session *sess = ts_get_current_session();
+
+	return obj_populate(to_user_ta_ctx(sess->ctx), obj,
+			    usr_attrs, attr_count);
+}
+
+TEE_Result syscall_cryp_obj_populate_batch(struct utee_populate_item *usr_items,
+					   size_t num_items)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct utee_populate_item items[UTEE_POPULATE_BATCH_MAX_CNT] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (!num_items || num_items > ARRAY_SIZE(items))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = copy_from_user(items, usr_items, num_items * sizeof(*items));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/*
+	 * Each object is populated on its own, a failure is reported in the
+	 * result of the item and doesn't stop the batch.
+	 */
+	for (n = 0; n < num_items; n++) {
+		if (items[n].attrs > UINTPTR_MAX) {
+			items[n].result = TEE_ERROR_BAD_PARAMETERS;
+			continue;
+		}
+		items[n].result = obj_populate(utc, items[n].obj,
+					       (void *)(vaddr_t)items[n].attrs,
+					       items[n].attr_count);
+	}
+
+	return copy_to_user(usr_items, items, num_items * sizeof(*items));
+}
+
 TEE_Result syscall_cryp_obj_copy(unsigned long dst, unsigned long src)
 {
 	struct ts_session *sess = ts_get_current_session();
@@ -1698,12 +1920,12 @@ TEE_Result syscall_cryp_obj_copy(unsigned long dst, unsigned long src)
 	struct tee_obj *src_o = NULL;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(dst), &dst_o);
+			  dst, &dst_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(src), &src_o);
+			  src, &src_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1870,6 +2092,50 @@ static TEE_Result tee_svc_obj_generate_key_ecc(
 	return TEE_SUCCESS;
 }
 
+static TEE_Result tee_svc_obj_generate_key_x25519(
+	struct tee_obj *o, const struct tee_cryp_obj_type_props *type_props,
+	uint32_t key_size, const TEE_Attribute *params, uint32_t param_count)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	/* Copy the present attributes into the obj before starting */
+	res = tee_svc_cryp_obj_populate_type(o, type_props, params,
+					     param_count);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = crypto_acipher_gen_x25519_key(o->attr, key_size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Set bits for the generated public and private key */
+	set_attribute(o, type_props, TEE_ATTR_X25519_PRIVATE_VALUE);
+	set_attribute(o, type_props, TEE_ATTR_X25519_PUBLIC_VALUE);
+	return TEE_SUCCESS;
+}
+
+static TEE_Result tee_svc_obj_generate_key_ed25519(
+	struct tee_obj *o, const struct tee_cryp_obj_type_props *type_props,
+	uint32_t key_size, const TEE_Attribute *params, uint32_t param_count)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	/* Copy the present attributes into the obj before starting */
+	res = tee_svc_cryp_obj_populate_type(o, type_props, params,
+					     param_count);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = crypto_acipher_gen_ed25519_key(o->attr, key_size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Set bits for the generated public and private key */
+	set_attribute(o, type_props, TEE_ATTR_ED25519_PRIVATE_VALUE);
+	set_attribute(o, type_props, TEE_ATTR_ED25519_PUBLIC_VALUE);
+	return TEE_SUCCESS;
+}
+
 TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 			const struct utee_attribute *usr_params,
 			unsigned long param_count)
@@ -1882,7 +2148,7 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	size_t byte_size = 0;
 	TEE_Attribute *params = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1927,6 +2193,7 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	case TEE_TYPE_DES:
 	case TEE_TYPE_DES3:
 	case TEE_TYPE_SM4:
+	case TEE_TYPE_CHACHA20:
 	case TEE_TYPE_HMAC_MD5:
 	case TEE_TYPE_HMAC_SHA1:
 	case TEE_TYPE_HMAC_SHA224:
@@ -1991,6 +2258,20 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 			goto out;
 		break;
 
+	case TEE_TYPE_X25519_KEYPAIR:
+		res = tee_svc_obj_generate_key_x25519(o, type_props, key_size,
+						      params, param_count);
+		if (res != TEE_SUCCESS)
+			goto out;
+		break;
+
+	case TEE_TYPE_ED25519_KEYPAIR:
+		res = tee_svc_obj_generate_key_ed25519(o, type_props, key_size,
+						       params, param_count);
+		if (res != TEE_SUCCESS)
+			goto out;
+		break;
+
 	default:
 		res = TEE_ERROR_BAD_FORMAT;
 	}
@@ -2005,19 +2286,19 @@ out:
 }
 
 static TEE_Result tee_svc_cryp_get_state(struct ts_session *sess,
-					 vaddr_t state_id,
+					 uint32_t state_id,
 					 struct tee_cryp_state **state)
 {
-	struct tee_cryp_state *s;
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *s = NULL;
 
-	TAILQ_FOREACH(s, &utc->cryp_states, link) {
-		if (state_id == (vaddr_t)s) {
-			*state = s;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	/* The generation count rejects stale handles of freed states */
+	s = handle_lookup(&utc->cryp_db, uref_to_handle(state_id));
+	if (!s || s->uref != state_id)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*state = s;
+	return TEE_SUCCESS;
 }
 
 static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
@@ -2030,6 +2311,7 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 		tee_obj_close(utc, o);
 
 	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+	handle_put(&utc->cryp_db, uref_to_handle(cs->uref));
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx);
 
@@ -2050,7 +2332,7 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 		assert(!cs->ctx);
 	}
 
-	free(cs);
+	slab_free(&cryp_state_cache, cs);
 }
 
 static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
@@ -2094,6 +2376,9 @@ static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
 	case TEE_MAIN_ALGO_SM4:
 		req_key_type = TEE_TYPE_SM4;
 		break;
+	case TEE_MAIN_ALGO_CHACHA20:
+		req_key_type = TEE_TYPE_CHACHA20;
+		break;
 	case TEE_MAIN_ALGO_RSA:
 		req_key_type = TEE_TYPE_RSA_KEYPAIR;
 		if (mode == TEE_MODE_ENCRYPT || mode == TEE_MODE_VERIFY)
@@ -2115,6 +2400,14 @@ static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
 	case TEE_MAIN_ALGO_ECDH:
 		req_key_type = TEE_TYPE_ECDH_KEYPAIR;
 		break;
+	case TEE_MAIN_ALGO_ED25519:
+		req_key_type = TEE_TYPE_ED25519_KEYPAIR;
+		if (mode == TEE_MODE_VERIFY)
+			req_key_type2 = TEE_TYPE_ED25519_PUBLIC_KEY;
+		break;
+	case TEE_MAIN_ALGO_X25519:
+		req_key_type = TEE_TYPE_X25519_KEYPAIR;
+		break;
 	case TEE_MAIN_ALGO_SM2_PKE:
 		if (mode == TEE_MODE_ENCRYPT)
 			req_key_type = TEE_TYPE_SM2_PKE_PUBLIC_KEY;
@@ -2170,7 +2463,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	struct tee_obj *o2 = NULL;
 
 	if (key1 != 0) {
-		res = tee_obj_get(utc, uref_to_vaddr(key1), &o1);
+		res = tee_obj_get(utc, key1, &o1);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o1->busy)
@@ -2180,7 +2473,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 			return res;
 	}
 	if (key2 != 0) {
-		res = tee_obj_get(utc, uref_to_vaddr(key2), &o2);
+		res = tee_obj_get(utc, key2, &o2);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o2->busy)
@@ -2190,9 +2483,13 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 			return res;
 	}
 
-	cs = calloc(1, sizeof(struct tee_cryp_state));
+	cs = slab_alloc(&cryp_state_cache);
 	if (!cs)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	if (!handle_get_uref(&utc->cryp_db, cs, &utc->uref_gen, &cs->uref)) {
+		slab_free(&cryp_state_cache, cs);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
 	TAILQ_INSERT_TAIL(&utc->cryp_states, cs, link);
 	cs->algo = algo;
 	cs->mode = mode;
@@ -2262,18 +2559,18 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = copy_kaddr_to_uref(state, cs);
+	res = copy_to_user_private(state, &cs->uref, sizeof(cs->uref));
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Register keys */
 	if (o1 != NULL) {
 		o1->busy = true;
-		cs->key1 = (vaddr_t)o1;
+		cs->key1 = o1->uref;
 	}
 	if (o2 != NULL) {
 		o2->busy = true;
-		cs->key2 = (vaddr_t)o2;
+		cs->key2 = o2->uref;
 	}
 
 out:
@@ -2289,11 +2586,11 @@ TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 	struct tee_cryp_state *cs_dst = NULL;
 	struct tee_cryp_state *cs_src = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(dst), &cs_dst);
+	res = tee_svc_cryp_get_state(sess, dst, &cs_dst);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(src), &cs_src);
+	res = tee_svc_cryp_get_state(sess, src, &cs_src);
 	if (res != TEE_SUCCESS)
 		return res;
 	if (cs_dst->algo != cs_src->algo || cs_dst->mode != cs_src->mode)
@@ -2328,6 +2625,7 @@ void tee_svc_cryp_free_states(struct user_ta_ctx *utc)
 
 	while (!TAILQ_EMPTY(states))
 		cryp_state_free(utc, TAILQ_FIRST(states));
+	handle_db_destroy(&utc->cryp_db, NULL);
 }
 
 TEE_Result syscall_cryp_state_free(unsigned long state)
@@ -2336,7 +2634,7 @@ TEE_Result syscall_cryp_state_free(unsigned long state)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_cryp_state *cs = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 	cryp_state_free(to_user_ta_ctx(sess->ctx), cs);
@@ -2351,7 +2649,7 @@ TEE_Result syscall_hash_init(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_cryp_state *cs = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2412,7 +2710,7 @@ TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2470,7 +2768,7 @@ TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2538,7 +2836,7 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2584,6 +2882,113 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Returns the size of the next chunk to process out of @len remaining
+ * bytes. The remainder of a split is always more than one chunk, so that
+ * it's large enough for the modes needing at least two blocks in the last
+ * update.
+ */
+static size_t crypto_update_chunk(size_t len)
+{
+	const size_t chunk = CFG_CORE_CRYPTO_UPDATE_CHUNK_SIZE;
+
+	COMPILE_TIME_ASSERT(!(CFG_CORE_CRYPTO_UPDATE_CHUNK_SIZE % 64));
+
+	if (len > 2 * chunk)
+		return chunk;
+	return len;
+}
+
+/* Feeds @len bytes at @src to a cipher operation in chunks */
+static TEE_Result cipher_update_chunks(struct tee_cryp_state *cs,
+				       bool last_block, const uint8_t *src,
+				       size_t len, uint8_t *dst)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t chunk = 0;
+	size_t offs = 0;
+
+	while (offs < len) {
+		chunk = crypto_update_chunk(len - offs);
+		res = tee_do_cipher_update(cs->ctx, cs->algo, cs->mode,
+					   last_block && offs + chunk == len,
+					   src + offs, chunk, dst + offs);
+		if (res != TEE_SUCCESS)
+			return res;
+		offs += chunk;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Feeds @len bytes at @src to an authenticated encryption operation in
+ * chunks. @dst_len holds the size of @dst on input and the number of bytes
+ * written on output.
+ */
+static TEE_Result authenc_update_chunks(struct tee_cryp_state *cs,
+					const uint8_t *src, size_t len,
+					uint8_t *dst, size_t *dst_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t out_offs = 0;
+	size_t out_len = 0;
+	size_t chunk = 0;
+	size_t offs = 0;
+
+	while (offs < len) {
+		chunk = crypto_update_chunk(len - offs);
+		out_len = *dst_len - out_offs;
+		res = crypto_authenc_update_payload(cs->ctx, cs->mode,
+						    src + offs, chunk,
+						    dst + out_offs, &out_len);
+		if (res != TEE_SUCCESS)
+			return res;
+		offs += chunk;
+		out_offs += out_len;
+	}
+	*dst_len = out_offs;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Copies in and checks the buffers of a vectored update, @src_len is the
+ * total size of the buffers
+ */
+static TEE_Result copy_in_iovec(struct user_mode_ctx *uctx,
+				const struct utee_iovec *usr_iov,
+				size_t iov_cnt, struct utee_iovec *iov,
+				size_t *src_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	*src_len = 0;
+	if (!iov_cnt || iov_cnt > UTEE_IOVEC_MAX_CNT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = copy_from_user(iov, usr_iov, iov_cnt * sizeof(*iov));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; n < iov_cnt; n++) {
+		if (iov[n].addr > UINTPTR_MAX || iov[n].len > SIZE_MAX)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		res = vm_check_access_rights(uctx, TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     iov[n].addr, iov[n].len);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		if (ADD_OVERFLOW(*src_len, iov[n].len, src_len))
+			return TEE_ERROR_OVERFLOW;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 			bool last_block, const void *src, size_t src_len,
 			void *dst, uint64_t *dst_len)
@@ -2593,7 +2998,7 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2629,11 +3034,8 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 		goto out;
 	}
 
-	if (src_len > 0) {
-		/* Permit src_len == 0 to finalize the operation */
-		res = tee_do_cipher_update(cs->ctx, cs->algo, cs->mode,
-					   last_block, src, src_len, dst);
-	}
+	/* Permit src_len == 0 to finalize the operation */
+	res = cipher_update_chunks(cs, last_block, src, src_len, dst);
 
 	if (last_block && cs->ctx_finalize != NULL) {
 		cs->ctx_finalize(cs->ctx);
@@ -2667,14 +3069,79 @@ TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 					    src, src_len, dst, dst_len);
 }
 
-#if defined(CFG_CRYPTO_HKDF)
-static TEE_Result get_hkdf_params(const TEE_Attribute *params,
-				  uint32_t param_count,
-				  void **salt, size_t *salt_len, void **info,
-				  size_t *info_len, size_t *okm_len)
+TEE_Result syscall_cipher_update_vec(unsigned long state,
+				     const struct utee_iovec *usr_iov,
+				     size_t iov_cnt, void *dst,
+				     uint64_t *dst_len)
 {
-	size_t n;
-	enum { SALT = 0x1, LENGTH = 0x2, INFO = 0x4 };
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct utee_iovec iov[UTEE_IOVEC_MAX_CNT] = { };
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t src_len = 0;
+	size_t offs = 0;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_CIPHER)
+		return TEE_ERROR_BAD_STATE;
+
+	res = copy_in_iovec(uctx, usr_iov, iov_cnt, iov, &src_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = get_user_u64_as_size_t(&dlen, dst_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = vm_check_access_rights(uctx, TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)dst, dlen);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (dlen < src_len) {
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	for (n = 0; n < iov_cnt; n++) {
+		res = cipher_update_chunks(cs, false /* last_block */,
+					   (const void *)(vaddr_t)iov[n].addr,
+					   iov[n].len, (uint8_t *)dst + offs);
+		if (res != TEE_SUCCESS)
+			return res;
+		offs += iov[n].len;
+	}
+
+out:
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
+		TEE_Result res2 = put_user_u64(dst_len, src_len);
+
+		if (res2 != TEE_SUCCESS)
+			res = res2;
+	}
+
+	return res;
+}
+
+#if defined(CFG_CRYPTO_HKDF)
+static TEE_Result get_hkdf_params(const TEE_Attribute *params,
+				  uint32_t param_count,
+				  void **salt, size_t *salt_len, void **info,
+				  size_t *info_len, size_t *okm_len)
+{
+	size_t n;
+	enum { SALT = 0x1, LENGTH = 0x2, INFO = 0x4 };
 	uint8_t found = 0;
 
 	*salt = *info = NULL;
@@ -2928,7 +3395,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	TEE_Attribute *params = NULL;
 	size_t alloc_size = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2947,7 +3414,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_obj_get(utc, uref_to_vaddr(derived_key), &so);
+	res = tee_obj_get(utc, derived_key, &so);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -3060,6 +3527,27 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 		/* free the public key */
 		crypto_acipher_free_ecc_public_key(&key_public);
 	}
+	else if (TEE_ALG_GET_MAIN_ALG(cs->algo) == TEE_MAIN_ALGO_X25519) {
+		uint8_t *x25519_secret = (uint8_t *)(sk + 1);
+		size_t x25519_secret_len = sk->alloc_size;
+
+		if (param_count != 1 ||
+		    params[0].attributeID != TEE_ATTR_X25519_PUBLIC_VALUE ||
+		    params[0].content.ref.length != KEY_SIZE_BYTES_25519) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+
+		res = crypto_acipher_x25519_shared_secret(ko->attr,
+						params[0].content.ref.buffer,
+						x25519_secret,
+						&x25519_secret_len);
+		if (res == TEE_SUCCESS) {
+			sk->key_size = x25519_secret_len;
+			so->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
+			set_attribute(so, type_props, TEE_ATTR_SECRET_VALUE);
+		}
+	}
 #if defined(CFG_CRYPTO_HKDF)
 	else if (TEE_ALG_GET_MAIN_ALG(cs->algo) == TEE_MAIN_ALGO_HKDF) {
 		void *salt, *info;
@@ -3226,7 +3714,7 @@ TEE_Result syscall_authenc_init(unsigned long state, const void *nonce,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3263,7 +3751,7 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3291,7 +3779,7 @@ TEE_Result syscall_authenc_update_payload(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3325,8 +3813,78 @@ TEE_Result syscall_authenc_update_payload(unsigned long state,
 		goto out;
 	}
 
-	res = crypto_authenc_update_payload(cs->ctx, cs->mode, src_data,
-					    src_len, dst_data, &dlen);
+	res = authenc_update_chunks(cs, src_data, src_len, dst_data, &dlen);
+out:
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
+		TEE_Result res2 = put_user_u64(dst_len, dlen);
+
+		if (res2 != TEE_SUCCESS)
+			res = res2;
+	}
+
+	return res;
+}
+
+TEE_Result syscall_authenc_update_payload_vec(unsigned long state,
+					      const struct utee_iovec *usr_iov,
+					      size_t iov_cnt, void *dst_data,
+					      uint64_t *dst_len)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct utee_iovec iov[UTEE_IOVEC_MAX_CNT] = { };
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t src_len = 0;
+	size_t out_len = 0;
+	size_t offs = 0;
+	size_t dlen = 0;
+	size_t n = 0;
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_AE)
+		return TEE_ERROR_BAD_STATE;
+
+	res = copy_in_iovec(uctx, usr_iov, iov_cnt, iov, &src_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = get_user_u64_as_size_t(&dlen, dst_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = vm_check_access_rights(uctx, TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_WRITE |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)dst_data, dlen);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (dlen < src_len) {
+		dlen = src_len;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	for (n = 0; n < iov_cnt; n++) {
+		out_len = dlen - offs;
+		res = authenc_update_chunks(cs,
+					    (const void *)(vaddr_t)iov[n].addr,
+					    iov[n].len,
+					    (uint8_t *)dst_data + offs,
+					    &out_len);
+		if (res != TEE_SUCCESS)
+			return res;
+		offs += out_len;
+	}
+	dlen = offs;
+
 out:
 	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
 		TEE_Result res2 = put_user_u64(dst_len, dlen);
@@ -3350,7 +3908,7 @@ TEE_Result syscall_authenc_enc_final(unsigned long state, const void *src_data,
 	size_t dlen = 0;
 	size_t tlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3434,7 +3992,7 @@ TEE_Result syscall_authenc_dec_final(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3533,7 +4091,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	int salt_len = 0;
 	TEE_Attribute *params = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3676,6 +4234,10 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 		res = crypto_acipher_ecc_sign(cs->algo, o->attr, src_data,
 					      src_len, dst_data, &dlen);
 		break;
+	case TEE_ALG_ED25519:
+		res = crypto_acipher_ed25519_sign(o->attr, src_data, src_len,
+						  dst_data, &dlen);
+		break;
 	default:
 		res = TEE_ERROR_BAD_PARAMETERS;
 		break;
@@ -3694,62 +4256,16 @@ out:
 	return res;
 }
 
-TEE_Result syscall_asymm_verify(unsigned long state,
-			const struct utee_attribute *usr_params,
-			size_t num_params, const void *data, size_t data_len,
-			const void *sig, size_t sig_len)
+static TEE_Result asymm_verify(struct tee_cryp_state *cs, struct tee_obj *o,
+			       const TEE_Attribute *params, size_t num_params,
+			       const void *data, size_t data_len,
+			       const void *sig, size_t sig_len)
 {
-	struct ts_session *sess = ts_get_current_session();
-	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
-	struct tee_cryp_state *cs = NULL;
 	TEE_Result res = TEE_SUCCESS;
-	TEE_Attribute *params = NULL;
-	struct tee_obj *o = NULL;
 	size_t hash_size = 0;
 	uint32_t hash_algo = 0;
 	int salt_len = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	if (cs->mode != TEE_MODE_VERIFY)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	res = vm_check_access_rights(&utc->uctx,
-				     TEE_MEMORY_ACCESS_READ |
-				     TEE_MEMORY_ACCESS_ANY_OWNER,
-				     (uaddr_t)data, data_len);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = vm_check_access_rights(&utc->uctx,
-				     TEE_MEMORY_ACCESS_READ |
-				     TEE_MEMORY_ACCESS_ANY_OWNER,
-				     (uaddr_t)sig, sig_len);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(utc, usr_params, num_params, params);
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	res = tee_obj_get(utc, cs->key1, &o);
-	if (res != TEE_SUCCESS)
-		goto out;
-	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
-		res = TEE_ERROR_BAD_PARAMETERS;
-		goto out;
-	}
-
 	switch (TEE_ALG_GET_MAIN_ALG(cs->algo)) {
 	case TEE_MAIN_ALGO_RSA:
 		if (cs->algo != TEE_ALG_RSASSA_PKCS1_V1_5) {
@@ -3817,10 +4333,166 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 						data_len, sig, sig_len);
 		break;
 
+	case TEE_MAIN_ALGO_ED25519:
+		res = crypto_acipher_ed25519_verify(o->attr, data, data_len,
+						    sig, sig_len);
+		break;
+
 	default:
 		res = TEE_ERROR_NOT_SUPPORTED;
 	}
 
+	return res;
+}
+
+TEE_Result syscall_asymm_verify(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, const void *data, size_t data_len,
+			const void *sig, size_t sig_len)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Attribute *params = NULL;
+	struct tee_obj *o = NULL;
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->mode != TEE_MODE_VERIFY)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)data, data_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = vm_check_access_rights(&utc->uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     (uaddr_t)sig, sig_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	size_t alloc_size = 0;
+
+	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
+		return TEE_ERROR_OVERFLOW;
+
+	params = malloc(alloc_size);
+	if (!params)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	res = copy_in_attrs(utc, usr_params, num_params, params);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = tee_obj_get(utc, cs->key1, &o);
+	if (res != TEE_SUCCESS)
+		goto out;
+	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = asymm_verify(cs, o, params, num_params, data, data_len, sig,
+			   sig_len);
+
+out:
+	free_wipe(params);
+	return res;
+}
+
+TEE_Result syscall_asymm_verify_batch(unsigned long state,
+			const struct utee_attribute *usr_params,
+			size_t num_params, struct utee_verify_item *usr_items,
+			size_t num_items)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct utee_verify_item items[UTEE_VERIFY_BATCH_MAX_CNT] = { };
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Attribute *params = NULL;
+	struct tee_obj *o = NULL;
+	size_t alloc_size = 0;
+	bool invalid = false;
+	size_t n = 0;
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->mode != TEE_MODE_VERIFY)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!num_items || num_items > ARRAY_SIZE(items))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = copy_from_user(items, usr_items, num_items * sizeof(*items));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; n < num_items; n++) {
+		if (items[n].digest > UINTPTR_MAX ||
+		    items[n].digest_len > SIZE_MAX ||
+		    items[n].sig > UINTPTR_MAX || items[n].sig_len > SIZE_MAX)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		res = vm_check_access_rights(&utc->uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     items[n].digest,
+					     items[n].digest_len);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		res = vm_check_access_rights(&utc->uctx,
+					     TEE_MEMORY_ACCESS_READ |
+					     TEE_MEMORY_ACCESS_ANY_OWNER,
+					     items[n].sig, items[n].sig_len);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
+		return TEE_ERROR_OVERFLOW;
+
+	params = malloc(alloc_size);
+	if (!params)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	res = copy_in_attrs(utc, usr_params, num_params, params);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	/* The key and parameters are checked once for the whole batch */
+	res = tee_obj_get(utc, cs->key1, &o);
+	if (res != TEE_SUCCESS)
+		goto out;
+	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	for (n = 0; n < num_items; n++) {
+		res = asymm_verify(cs, o, params, num_params,
+				   (const void *)(vaddr_t)items[n].digest,
+				   items[n].digest_len,
+				   (const void *)(vaddr_t)items[n].sig,
+				   items[n].sig_len);
+		if (res == TEE_ERROR_SIGNATURE_INVALID)
+			invalid = true;
+		else if (res != TEE_SUCCESS)
+			goto out;
+		items[n].result = res;
+	}
+
+	res = copy_to_user(usr_items, items, num_items * sizeof(*items));
+	if (res == TEE_SUCCESS && invalid)
+		res = TEE_ERROR_SIGNATURE_INVALID;
 out:
 	free_wipe(params);
 	return res;
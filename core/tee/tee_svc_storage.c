@@ -4,6 +4,7 @@
  * Copyright (c) 2020, Linaro Limited
  */
 
+#include <assert.h>
 #include <config.h>
 #include <crypto/crypto.h>
 #include <kernel/mutex.h>
@@ -12,6 +13,7 @@
 #include <kernel/ts_manager.h>
 #include <kernel/user_access.h>
 #include <mm/vm.h>
+#include <stdlib_ext.h>
 #include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_defines.h>
@@ -23,6 +25,7 @@
 #include <tee/tee_svc.h>
 #include <tee/tee_svc_storage.h>
 #include <trace.h>
+#include <util.h>
 
 const struct tee_file_operations *tee_svc_storage_file_ops(uint32_t storage_id)
 {
@@ -168,37 +171,260 @@ TEE_Result tee_svc_storage_create_dirname(void *buf, size_t blen,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Cache of the header and attributes of recently opened persistent objects,
+ * both already authenticated by the file system when loaded. Entries are
+ * kept in LRU order, most recently used first, and are dropped whenever the
+ * object file is created, renamed or removed.
+ *
+ * An object header is only inserted if no entry was invalidated since the
+ * header was read: head_cache_gen counts invalidations.
+ */
+struct head_cache_entry {
+	TAILQ_ENTRY(head_cache_entry) link;
+	uint32_t hash;
+	TEE_UUID uuid;
+	const struct tee_file_operations *fops;
+	uint8_t obj_id[TEE_OBJECT_ID_MAX_LEN];
+	uint32_t obj_id_len;
+	struct tee_svc_storage_head head;
+	uint8_t attr[];
+};
+
+/* Larger attributes aren't worth keeping in heap memory */
+#define HEAD_CACHE_MAX_ATTR_SIZE	4096
+
+static TAILQ_HEAD(head_cache_head, head_cache_entry) head_cache =
+		TAILQ_HEAD_INITIALIZER(head_cache);
+static struct mutex head_cache_mutex = MUTEX_INITIALIZER;
+static size_t head_cache_count;
+static unsigned int head_cache_gen;
+
+static uint32_t head_cache_hash(struct tee_pobj *po)
+{
+	const uint8_t *p = (const uint8_t *)&po->uuid;
+	uint32_t hash = 2166136261U;
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(po->uuid); n++)
+		hash = (hash ^ p[n]) * 16777619U;
+	for (n = 0, p = po->obj_id; n < po->obj_id_len; n++)
+		hash = (hash ^ p[n]) * 16777619U;
+
+	return hash;
+}
+
+static struct head_cache_entry *head_cache_find(struct tee_pobj *po,
+						uint32_t hash)
+{
+	struct head_cache_entry *e = NULL;
+
+	TAILQ_FOREACH(e, &head_cache, link)
+		if (e->hash == hash && e->fops == po->fops &&
+		    e->obj_id_len == po->obj_id_len &&
+		    !memcmp(&e->uuid, &po->uuid, sizeof(e->uuid)) &&
+		    !memcmp(e->obj_id, po->obj_id, po->obj_id_len))
+			return e;
+
+	return NULL;
+}
+
+static void head_cache_free(struct head_cache_entry *e)
+{
+	TAILQ_REMOVE(&head_cache, e, link);
+	head_cache_count--;
+	/* Attributes may hold secret key material */
+	free_wipe(e);
+}
+
+/*
+ * Return true and a copy of the cached header and attributes of @po if
+ * found. Attributes are returned in a buffer to free by the caller.
+ */
+static bool head_cache_get(struct tee_pobj *po,
+			   struct tee_svc_storage_head *head, void **attr)
+{
+	struct head_cache_entry *e = NULL;
+	bool found = false;
+
+	if (!CFG_STORAGE_HEAD_CACHE_ENTRIES)
+		return false;
+
+	mutex_lock(&head_cache_mutex);
+
+	e = head_cache_find(po, head_cache_hash(po));
+	if (!e)
+		goto out;
+
+	*attr = NULL;
+	if (e->head.attr_size) {
+		*attr = malloc(e->head.attr_size);
+		if (!*attr)
+			goto out;
+		memcpy(*attr, e->attr, e->head.attr_size);
+	}
+	*head = e->head;
+
+	TAILQ_REMOVE(&head_cache, e, link);
+	TAILQ_INSERT_HEAD(&head_cache, e, link);
+	found = true;
+out:
+	mutex_unlock(&head_cache_mutex);
+
+	return found;
+}
+
+static unsigned int head_cache_generation(void)
+{
+	unsigned int gen = 0;
+
+	mutex_lock(&head_cache_mutex);
+	gen = head_cache_gen;
+	mutex_unlock(&head_cache_mutex);
+
+	return gen;
+}
+
+static void head_cache_put(struct tee_pobj *po,
+			   const struct tee_svc_storage_head *head,
+			   const void *attr, unsigned int gen)
+{
+	struct head_cache_entry *e = NULL;
+	uint32_t hash = 0;
+
+	if (!CFG_STORAGE_HEAD_CACHE_ENTRIES ||
+	    head->attr_size > HEAD_CACHE_MAX_ATTR_SIZE ||
+	    po->obj_id_len > sizeof(e->obj_id))
+		return;
+
+	mutex_lock(&head_cache_mutex);
+
+	hash = head_cache_hash(po);
+	if (gen != head_cache_gen || head_cache_find(po, hash))
+		goto out;
+
+	if (head_cache_count == CFG_STORAGE_HEAD_CACHE_ENTRIES)
+		head_cache_free(TAILQ_LAST(&head_cache, head_cache_head));
+
+	e = malloc(sizeof(*e) + head->attr_size);
+	if (!e)
+		goto out;
+
+	e->hash = hash;
+	e->uuid = po->uuid;
+	e->fops = po->fops;
+	memcpy(e->obj_id, po->obj_id, po->obj_id_len);
+	e->obj_id_len = po->obj_id_len;
+	e->head = *head;
+	memcpy(e->attr, attr, head->attr_size);
+
+	TAILQ_INSERT_HEAD(&head_cache, e, link);
+	head_cache_count++;
+out:
+	mutex_unlock(&head_cache_mutex);
+}
+
+void tee_svc_storage_head_cache_invalidate(struct tee_pobj *po)
+{
+	struct head_cache_entry *e = NULL;
+
+	if (!CFG_STORAGE_HEAD_CACHE_ENTRIES)
+		return;
+
+	mutex_lock(&head_cache_mutex);
+
+	head_cache_gen++;
+	e = head_cache_find(po, head_cache_hash(po));
+	if (e)
+		head_cache_free(e);
+
+	mutex_unlock(&head_cache_mutex);
+}
+
 static TEE_Result tee_svc_storage_remove_corrupt_obj(struct ts_session *sess,
 						     struct tee_obj *o)
 {
+	tee_svc_storage_head_cache_invalidate(o->pobj);
 	o->pobj->fops->remove(o->pobj);
+	o->staged = false;
 	tee_obj_close(to_user_ta_ctx(sess->ctx), o);
 
 	return TEE_SUCCESS;
 }
 
+/* Read and check the header and attributes of an object from its file */
+static TEE_Result read_head_from_file(struct tee_obj *o, size_t size,
+				      struct tee_svc_storage_head *head,
+				      void **attr_out)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t bytes = 0;
+	const struct tee_file_operations *fops = o->pobj->fops;
+	void *attr = NULL;
+	size_t tmp = 0;
+
+	/* read head */
+	bytes = sizeof(struct tee_svc_storage_head);
+	res = fops->read(o->fh, 0, head, &bytes);
+	if (res != TEE_SUCCESS) {
+		if (res == TEE_ERROR_CORRUPT_OBJECT)
+			EMSG("Head corrupt");
+		return res;
+	}
+
+	if (ADD_OVERFLOW(sizeof(*head), head->attr_size, &tmp))
+		return TEE_ERROR_OVERFLOW;
+	if (tmp > size)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	if (bytes != sizeof(struct tee_svc_storage_head))
+		return TEE_ERROR_BAD_FORMAT;
+
+	if (head->attr_size) {
+		attr = malloc(head->attr_size);
+		if (!attr)
+			return TEE_ERROR_OUT_OF_MEMORY;
+
+		/* read meta */
+		bytes = head->attr_size;
+		res = fops->read(o->fh, sizeof(struct tee_svc_storage_head),
+				 attr, &bytes);
+		if (res == TEE_ERROR_OUT_OF_MEMORY)
+			goto err;
+		if (res != TEE_SUCCESS || bytes != head->attr_size)
+			res = TEE_ERROR_CORRUPT_OBJECT;
+		if (res)
+			goto err;
+	}
+
+	*attr_out = attr;
+	return TEE_SUCCESS;
+err:
+	free(attr);
+	return res;
+}
+
 static TEE_Result tee_svc_storage_read_head(struct tee_obj *o)
 {
 	TEE_Result res = TEE_SUCCESS;
-	size_t bytes;
 	struct tee_svc_storage_head head;
 	const struct tee_file_operations *fops = o->pobj->fops;
 	void *attr = NULL;
 	size_t size;
 	size_t tmp = 0;
+	unsigned int gen = 0;
 
 	assert(!o->fh);
 	res = fops->open(o->pobj, &size, &o->fh);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
-	/* read head */
-	bytes = sizeof(struct tee_svc_storage_head);
-	res = fops->read(o->fh, 0, &head, &bytes);
-	if (res != TEE_SUCCESS) {
-		if (res == TEE_ERROR_CORRUPT_OBJECT)
-			EMSG("Head corrupt");
-		goto exit;
+	if (!head_cache_get(o->pobj, &head, &attr)) {
+		gen = head_cache_generation();
+		res = read_head_from_file(o, size, &head, &attr);
+		if (res != TEE_SUCCESS)
+			goto exit;
+		head_cache_put(o->pobj, &head, attr, gen);
 	}
 
 	if (ADD_OVERFLOW(sizeof(head), head.attr_size, &tmp)) {
@@ -210,36 +436,12 @@ static TEE_Result tee_svc_storage_read_head(struct tee_obj *o)
 		goto exit;
 	}
 
-	if (bytes != sizeof(struct tee_svc_storage_head)) {
-		res = TEE_ERROR_BAD_FORMAT;
-		goto exit;
-	}
-
 	res = tee_obj_set_type(o, head.objectType, head.maxKeySize);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
 	o->ds_pos = tmp;
 
-	if (head.attr_size) {
-		attr = malloc(head.attr_size);
-		if (!attr) {
-			res = TEE_ERROR_OUT_OF_MEMORY;
-			goto exit;
-		}
-
-		/* read meta */
-		bytes = head.attr_size;
-		res = fops->read(o->fh, sizeof(struct tee_svc_storage_head),
-				 attr, &bytes);
-		if (res == TEE_ERROR_OUT_OF_MEMORY)
-			goto exit;
-		if (res != TEE_SUCCESS || bytes != head.attr_size)
-			res = TEE_ERROR_CORRUPT_OBJECT;
-		if (res)
-			goto exit;
-	}
-
 	res = tee_obj_attr_from_binary(o, attr, head.attr_size);
 	if (res != TEE_SUCCESS)
 		goto exit;
@@ -251,7 +453,7 @@ static TEE_Result tee_svc_storage_read_head(struct tee_obj *o)
 	o->have_attrs = head.have_attrs;
 
 exit:
-	free(attr);
+	free_wipe(attr);
 
 	return res;
 }
@@ -264,7 +466,9 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 					  TEE_DATA_FLAG_ACCESS_WRITE |
 					  TEE_DATA_FLAG_ACCESS_WRITE_META |
 					  TEE_DATA_FLAG_SHARE_READ |
-					  TEE_DATA_FLAG_SHARE_WRITE;
+					  TEE_DATA_FLAG_SHARE_WRITE |
+					  TEE_DATA_FLAG_WRITE_BEHIND |
+					  TEE_DATA_FLAG_COMPRESS;
 	const struct tee_file_operations *fops =
 			tee_svc_storage_file_ops(storage_id);
 	struct ts_session *sess = ts_get_current_session();
@@ -308,7 +512,13 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 	o->info.handleFlags = TEE_HANDLE_FLAG_PERSISTENT |
 			      TEE_HANDLE_FLAG_INITIALIZED | flags;
 	o->pobj = po;
-	tee_obj_add(utc, o);
+	res = tee_obj_add(utc, o);
+	if (res != TEE_SUCCESS) {
+		tee_obj_free(o);
+		o = NULL;
+		tee_pobj_release(po);
+		goto err;
+	}
 
 	res = tee_svc_storage_read_head(o);
 	if (res != TEE_SUCCESS) {
@@ -319,7 +529,7 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 		goto oclose;
 	}
 
-	res = copy_kaddr_to_uref(obj, o);
+	res = copy_to_user_private(obj, &o->uref, sizeof(o->uref));
 	if (res != TEE_SUCCESS)
 		goto oclose;
 
@@ -389,6 +599,7 @@ static TEE_Result tee_svc_storage_init_file(struct tee_obj *o, bool overwrite,
 	head.objectType = o->info.objectType;
 	head.have_attrs = o->have_attrs;
 
+	tee_svc_storage_head_cache_invalidate(o->pobj);
 	res = fops->create(o->pobj, overwrite, &head, sizeof(head), attr,
 			   attr_size, data, len, &o->fh);
 
@@ -409,7 +620,9 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 					  TEE_DATA_FLAG_ACCESS_WRITE_META |
 					  TEE_DATA_FLAG_SHARE_READ |
 					  TEE_DATA_FLAG_SHARE_WRITE |
-					  TEE_DATA_FLAG_OVERWRITE;
+					  TEE_DATA_FLAG_OVERWRITE |
+					  TEE_DATA_FLAG_WRITE_BEHIND |
+					  TEE_DATA_FLAG_COMPRESS;
 	const struct tee_file_operations *fops =
 			tee_svc_storage_file_ops(storage_id);
 	struct ts_session *sess = ts_get_current_session();
@@ -467,7 +680,7 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 	o->pobj = po;
 
 	if (attr != TEE_HANDLE_NULL) {
-		res = tee_obj_get(utc, uref_to_vaddr(attr), &attr_o);
+		res = tee_obj_get(utc, attr, &attr_o);
 		if (res != TEE_SUCCESS)
 			goto err;
 		/* The supplied handle must be one of an initialized object */
@@ -482,10 +695,12 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 	if (res != TEE_SUCCESS)
 		goto err;
 
+	res = tee_obj_add(utc, o);
+	if (res != TEE_SUCCESS)
+		goto err;
 	po = NULL; /* o owns it from now on */
-	tee_obj_add(utc, o);
 
-	res = copy_kaddr_to_uref(obj, o);
+	res = copy_to_user_private(obj, &o->uref, sizeof(o->uref));
 	if (res != TEE_SUCCESS)
 		goto oclose;
 
@@ -499,8 +714,10 @@ oclose:
 err:
 	if (res == TEE_ERROR_NO_DATA || res == TEE_ERROR_BAD_FORMAT)
 		res = TEE_ERROR_CORRUPT_OBJECT;
-	if (res == TEE_ERROR_CORRUPT_OBJECT && po)
+	if (res == TEE_ERROR_CORRUPT_OBJECT && po) {
+		tee_svc_storage_head_cache_invalidate(po);
 		fops->remove(po);
+	}
 	if (o) {
 		fops->close(&o->fh);
 		tee_obj_free(o);
@@ -520,7 +737,7 @@ TEE_Result syscall_storage_obj_del(unsigned long obj)
 	uint8_t *data = NULL;
 	size_t len = 0;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -543,7 +760,9 @@ TEE_Result syscall_storage_obj_del(unsigned long obj)
 		free(data);
 	}
 
+	tee_svc_storage_head_cache_invalidate(o->pobj);
 	res = o->pobj->fops->remove(o->pobj);
+	o->staged = false;
 	tee_obj_close(utc, o);
 
 	return res;
@@ -564,7 +783,7 @@ TEE_Result syscall_storage_obj_rename(unsigned long obj, void *object_id,
 	if (object_id_len > TEE_OBJECT_ID_MAX_LEN)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -597,6 +816,8 @@ TEE_Result syscall_storage_obj_rename(unsigned long obj, void *object_id,
 		goto exit;
 
 	/* move */
+	tee_svc_storage_head_cache_invalidate(o->pobj);
+	tee_svc_storage_head_cache_invalidate(po);
 	res = fops->rename(o->pobj, po, false /* no overwrite */);
 	if (res)
 		goto exit;
@@ -695,6 +916,42 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 	return fops->opendir(&sess->ctx->uuid, &e->dir);
 }
 
+/* Reads the object info from the header of the enumerated object @d */
+static TEE_Result enum_read_info(struct ts_session *sess,
+				 struct tee_storage_enum *e,
+				 struct tee_fs_dirent *d, TEE_ObjectInfo *info)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_obj *o = NULL;
+
+	o = tee_obj_alloc();
+	if (o == NULL)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = tee_pobj_get(&sess->ctx->uuid, d->oid, d->oidlen, 0,
+			   TEE_POBJ_USAGE_ENUM, e->fops, &o->pobj);
+	if (res)
+		goto exit;
+
+	o->info.handleFlags = o->pobj->flags | TEE_HANDLE_FLAG_PERSISTENT |
+			      TEE_HANDLE_FLAG_INITIALIZED;
+
+	res = tee_svc_storage_read_head(o);
+	if (res != TEE_SUCCESS)
+		goto exit;
+
+	*info = o->info;
+
+exit:
+	if (o->pobj) {
+		o->pobj->fops->close(&o->fh);
+		tee_pobj_release(o->pobj);
+	}
+	tee_obj_free(o);
+
+	return res;
+}
+
 TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 			TEE_ObjectInfo *info, void *obj_id, uint64_t *len)
 {
@@ -702,8 +959,8 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 	struct tee_storage_enum *e = NULL;
 	struct tee_fs_dirent *d = NULL;
+	TEE_ObjectInfo kinfo = { };
 	TEE_Result res = TEE_SUCCESS;
-	struct tee_obj *o = NULL;
 	uint64_t l = 0;
 
 	res = tee_svc_storage_get_enum(utc, uref_to_vaddr(obj_enum), &e);
@@ -730,39 +987,91 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 	if (res != TEE_SUCCESS)
 		goto exit;
 
-	o = tee_obj_alloc();
-	if (o == NULL) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
+	res = enum_read_info(sess, e, d, &kinfo);
+	if (res != TEE_SUCCESS)
 		goto exit;
-	}
 
-	res = tee_pobj_get(&sess->ctx->uuid, d->oid, d->oidlen, 0,
-			   TEE_POBJ_USAGE_ENUM, e->fops, &o->pobj);
-	if (res)
-		goto exit;
+	memcpy(info, &kinfo, sizeof(TEE_ObjectInfo));
+	memcpy(obj_id, d->oid, d->oidlen);
 
-	o->info.handleFlags = o->pobj->flags | TEE_HANDLE_FLAG_PERSISTENT |
-			      TEE_HANDLE_FLAG_INITIALIZED;
+	l = d->oidlen;
+	res = copy_to_user_private(len, &l, sizeof(*len));
 
-	res = tee_svc_storage_read_head(o);
+exit:
+	return res;
+}
+
+TEE_Result syscall_storage_next_enum_batch(unsigned long obj_enum,
+			struct utee_enum_item *usr_items, size_t num_items,
+			uint64_t *count)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_storage_enum *e = NULL;
+	struct tee_fs_dirent *d = NULL;
+	struct utee_enum_item *items = NULL;
+	struct utee_enum_item *item = NULL;
+	TEE_ObjectInfo info = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t n = 0;
+
+	res = tee_svc_storage_get_enum(utc, uref_to_vaddr(obj_enum), &e);
 	if (res != TEE_SUCCESS)
-		goto exit;
+		return res;
 
-	memcpy(info, &o->info, sizeof(TEE_ObjectInfo));
-	memcpy(obj_id, o->pobj->obj_id, o->pobj->obj_id_len);
+	if (!num_items || num_items > UTEE_ENUM_BATCH_MAX_CNT)
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	l = o->pobj->obj_id_len;
-	res = copy_to_user_private(len, &l, sizeof(*len));
+	if (!e->fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
 
-exit:
-	if (o) {
-		if (o->pobj) {
-			o->pobj->fops->close(&o->fh);
-			tee_pobj_release(o->pobj);
+	items = calloc(num_items, sizeof(*items));
+	if (!items)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	while (n < num_items) {
+		res = e->fops->readdir(e->dir, &d);
+		if (res == TEE_ERROR_ITEM_NOT_FOUND && n)
+			break;
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		if (d->oidlen > sizeof(item->obj_id)) {
+			res = TEE_ERROR_CORRUPT_OBJECT;
+			goto out;
 		}
-		tee_obj_free(o);
+
+		item = items + n;
+		memcpy(item->obj_id, d->oid, d->oidlen);
+		item->obj_id_len = d->oidlen;
+
+		/*
+		 * An object which can't be read doesn't end the batch, its
+		 * error is returned in its item instead.
+		 */
+		res = enum_read_info(sess, e, d, &info);
+		if (res == TEE_ERROR_OUT_OF_MEMORY)
+			goto out;
+		item->result = res;
+		if (res == TEE_SUCCESS) {
+			item->obj_type = info.objectType;
+			item->obj_size = info.objectSize;
+			item->max_obj_size = info.maxObjectSize;
+			item->obj_usage = info.objectUsage;
+			item->data_size = info.dataSize;
+			item->data_position = info.dataPosition;
+			item->handle_flags = info.handleFlags;
+		}
+		n++;
 	}
 
+	res = copy_to_user(usr_items, items, n * sizeof(*items));
+	if (res == TEE_SUCCESS)
+		res = copy_to_user_private(count, &n, sizeof(*count));
+
+out:
+	free(items);
+
 	return res;
 }
 
@@ -777,7 +1086,7 @@ TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 	size_t pos_tmp = 0;
 	size_t bytes = 0;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -825,6 +1134,21 @@ exit:
 	return res;
 }
 
+/*
+ * Holds back the writes to @o until the transaction is committed or, with
+ * TEE_DATA_FLAG_WRITE_BEHIND, until the next sync point.
+ */
+static void stage_obj(struct user_ta_ctx *utc, struct tee_obj *o)
+{
+	bool stage = utc->storage_tx ||
+		     (o->info.handleFlags & TEE_DATA_FLAG_WRITE_BEHIND);
+
+	if (stage && !o->staged && o->pobj->fops->stage) {
+		o->pobj->fops->stage(o->fh);
+		o->staged = true;
+	}
+}
+
 TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 {
 	struct ts_session *sess = ts_get_current_session();
@@ -833,7 +1157,7 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 	struct tee_obj *o = NULL;
 	size_t pos_tmp = 0;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -863,6 +1187,7 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 		res = TEE_ERROR_ACCESS_CONFLICT;
 		goto exit;
 	}
+	stage_obj(utc, o);
 	res = o->pobj->fops->write(o->fh, pos_tmp, data, len);
 	if (res != TEE_SUCCESS)
 		goto exit;
@@ -878,12 +1203,13 @@ exit:
 TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 {
 	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 	size_t off = 0;
 	size_t attr_size = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -910,6 +1236,7 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 		res = TEE_ERROR_OVERFLOW;
 		goto exit;
 	}
+	stage_obj(utc, o);
 	res = o->pobj->fops->truncate(o->fh, off);
 	switch (res) {
 	case TEE_SUCCESS:
@@ -936,7 +1263,7 @@ TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 	struct tee_obj *o = NULL;
 	tee_fs_off_t new_pos = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -980,3 +1307,69 @@ void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc)
 	while (!TAILQ_EMPTY(eh))
 		tee_svc_close_enum(utc, TAILQ_FIRST(eh));
 }
+
+TEE_Result tee_svc_storage_commit_staged(struct user_ta_ctx *utc)
+{
+	const struct tee_file_operations *fops = NULL;
+	struct tee_file_handle **fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_obj *o = NULL;
+	size_t n = 0;
+
+	TAILQ_FOREACH(o, &utc->objects, link)
+		if (o->staged)
+			n++;
+	if (!n)
+		return TEE_SUCCESS;
+
+	fh = malloc(n * sizeof(*fh));
+	if (!fh)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	n = 0;
+	TAILQ_FOREACH(o, &utc->objects, link) {
+		if (!o->staged)
+			continue;
+		/* Only one storage supports staging */
+		assert(!fops || fops == o->pobj->fops);
+		fops = o->pobj->fops;
+		fh[n++] = o->fh;
+	}
+
+	res = fops->commit_staged(fh, n);
+	if (!res)
+		TAILQ_FOREACH(o, &utc->objects, link)
+			o->staged = false;
+
+	free(fh);
+
+	return res;
+}
+
+TEE_Result syscall_storage_tx_begin(void)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+
+	if (utc->storage_tx)
+		return TEE_ERROR_BAD_STATE;
+
+	utc->storage_tx = true;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result syscall_storage_tx_commit(void)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	res = tee_svc_storage_commit_staged(utc);
+	if (res)
+		return res;
+
+	utc->storage_tx = false;
+
+	return TEE_SUCCESS;
+}
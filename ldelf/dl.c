@@ -21,18 +21,59 @@ TEE_Result dlopen_entry(struct dl_entry_arg *arg)
 	return ta_elf_add_library(&arg->dlopen.uuid);
 }
 
-TEE_Result dlsym_entry(struct dl_entry_arg *arg)
+static TEE_Result find_elf(const TEE_UUID *uuid, struct ta_elf **elf)
 {
-	struct ta_elf *elf = NULL;
 	TEE_UUID zero = { };
 
-	if (memcmp(&arg->dlsym.uuid, &zero, sizeof(zero))) {
-		elf = ta_elf_find_elf(&arg->dlsym.uuid);
-		if (!elf)
+	*elf = NULL;
+	if (memcmp(uuid, &zero, sizeof(zero))) {
+		*elf = ta_elf_find_elf(uuid);
+		if (!*elf)
 			return TEE_ERROR_ITEM_NOT_FOUND;
 	}
 
+	return TEE_SUCCESS;
+}
+
+TEE_Result dlsym_entry(struct dl_entry_arg *arg)
+{
+	struct ta_elf *elf = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = find_elf(&arg->dlsym.uuid, &elf);
+	if (res)
+		return res;
+
 	return ta_elf_resolve_sym(arg->dlsym.symbol, &arg->dlsym.val, NULL,
 				  elf);
 }
 
+TEE_Result dlsym_table_entry(struct dl_entry_arg *arg)
+{
+	uint32_t num_syms = arg->dlsym_table.num_syms;
+	vaddr_t *vals = arg->dlsym_table.vals;
+	const char *name = (const char *)(vals + num_syms);
+	const char *end = name + arg->dlsym_table.names_len;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct ta_elf *elf = NULL;
+	uint32_t n = 0;
+
+	res = find_elf(&arg->dlsym_table.uuid, &elf);
+	if (res)
+		return res;
+
+	/* Symbols which aren't found are reported as 0 */
+	for (n = 0; n < num_syms; n++) {
+		if (name >= end)
+			return TEE_ERROR_BAD_PARAMETERS;
+		res = ta_elf_resolve_sym(name, vals + n, NULL, elf);
+		if (res == TEE_ERROR_ITEM_NOT_FOUND)
+			vals[n] = 0;
+		else if (res)
+			return res;
+		name += strnlen(name, end - name) + 1;
+	}
+
+	return TEE_SUCCESS;
+}
+
@@ -11,6 +11,7 @@
 
 TEE_Result dlopen_entry(struct dl_entry_arg *arg);
 TEE_Result dlsym_entry(struct dl_entry_arg *arg);
+TEE_Result dlsym_table_entry(struct dl_entry_arg *arg);
 
 #endif /*LDELF_DL_H*/
 
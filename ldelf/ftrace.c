@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <printk.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <types_ext.h>
 #include <util.h>
@@ -15,6 +16,12 @@
 #define MIN_FTRACE_BUF_SIZE	1024
 #define MAX_HEADER_STRLEN	128
 
+#if defined(_CFG_FTRACE_BUF_FORMAT_binary)
+#define HEADER_FMT	"Function trace records for TA: %pUl @ %lx\n"
+#else
+#define HEADER_FMT	"Function graph for TA: %pUl @ %lx\n"
+#endif
+
 static struct ftrace_buf *fbuf;
 
 bool ftrace_init(struct ftrace_buf **fbuf_ptr)
@@ -46,8 +53,7 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	fbuf = (struct ftrace_buf *)(vaddr_t)finfo->buf_start.ptr64;
 	fbuf->head_off = sizeof(struct ftrace_buf);
 	count = snprintk((char *)fbuf + fbuf->head_off, MAX_HEADER_STRLEN,
-			 "Function graph for TA: %pUl @ %lx\n",
-			 (void *)&elf->uuid, elf->load_addr);
+			 HEADER_FMT, (void *)&elf->uuid, elf->load_addr);
 	assert(count < MAX_HEADER_STRLEN);
 
 	fbuf->ret_func_ptr = finfo->ret_ptr.ptr64;
@@ -55,16 +61,52 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	fbuf->lr_idx = 0;
 	fbuf->suspend_time = 0;
 	fbuf->buf_off = fbuf->head_off + count;
+#if defined(_CFG_FTRACE_BUF_FORMAT_binary)
+	/* Records are accessed with 64-bit loads and stores */
+	fbuf->buf_off = ROUNDUP(fbuf->buf_off, sizeof(uint64_t));
+#endif
 	fbuf->curr_size = 0;
-	fbuf->max_size = fbuf_size - sizeof(struct ftrace_buf) - count;
+	fbuf->max_size = fbuf_size - fbuf->buf_off;
 	fbuf->syscall_trace_enabled = false;
 	fbuf->syscall_trace_suspended = false;
+	fbuf->rec_wrapped = false;
 
 	*fbuf_ptr = fbuf;
 
 	return true;
 }
 
+#if defined(_CFG_FTRACE_BUF_FORMAT_binary)
+void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
+						   size_t bl))
+{
+	char *hdr = NULL;
+	char *recs = NULL;
+	size_t rec_size = 0;
+
+	if (!fbuf)
+		return;
+
+	/* Header line followed by the records, oldest first */
+	hdr = (char *)fbuf + fbuf->head_off;
+	copy_func(pctx, hdr, strnlen(hdr, fbuf->buf_off - fbuf->head_off));
+
+	recs = (char *)fbuf + fbuf->buf_off;
+	rec_size = ROUNDDOWN(fbuf->max_size, sizeof(struct ftrace_rec));
+	if (fbuf->rec_wrapped)
+		copy_func(pctx, recs + fbuf->curr_size,
+			  rec_size - fbuf->curr_size);
+	copy_func(pctx, recs, fbuf->curr_size);
+}
+
+void ftrace_reset_buf(void)
+{
+	if (fbuf) {
+		fbuf->curr_size = 0;
+		fbuf->rec_wrapped = false;
+	}
+}
+#else
 void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
 						   size_t bl))
 {
@@ -78,6 +120,11 @@ void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
 	}
 }
 
+void ftrace_reset_buf(void)
+{
+}
+#endif
+
 void ftrace_map_lr(uint64_t *lr)
 {
 	if (fbuf) {
@@ -86,6 +86,13 @@ struct dl_entry_arg {
 			vaddr_t val;	/* out */
 			char symbol[];	/* in */
 		} dlsym;
+		struct {
+			TEE_UUID uuid;		/* in */
+			uint32_t num_syms;	/* in */
+			uint32_t names_len;	/* in */
+			/* out, followed by the NUL terminated names (in) */
+			vaddr_t vals[];
+		} dlsym_table;
 	};
 };
 
@@ -94,6 +101,7 @@ struct dl_entry_arg {
  */
 #define LDELF_DL_ENTRY_DLOPEN	0
 #define LDELF_DL_ENTRY_DLSYM	1
+#define LDELF_DL_ENTRY_DLSYM_TABLE	2
 
 /*
  * Values for dl_entry_arg::dlopen::flags
@@ -105,6 +113,7 @@ struct dl_entry_arg {
 #define LDELF_MAP_FLAG_SHAREABLE	BIT32(0)
 #define LDELF_MAP_FLAG_WRITEABLE	BIT32(1)
 #define LDELF_MAP_FLAG_EXECUTABLE	BIT32(2)
+#define LDELF_MAP_FLAG_BLOCK_MAPPED	BIT32(3)
 
 #endif /*!__ASSEMBLER__*/
 
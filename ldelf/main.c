@@ -98,6 +98,8 @@ static void __noreturn ftrace_dump(void *buf, size_t *blen)
 	ta_elf_print_mappings(&pbuf, print_to_pbuf, &main_elf_queue,
 			      0, NULL, mpool_base);
 	ftrace_copy_buf(&pbuf, copy_to_pbuf);
+	if (buf && pbuf.ret <= pbuf.blen)
+		ftrace_reset_buf();
 	*blen = pbuf.ret;
 	sys_return_cleanup();
 }
@@ -112,6 +114,9 @@ static void __noreturn dl_entry(struct dl_entry_arg *arg)
 	case LDELF_DL_ENTRY_DLSYM:
 		arg->ret = dlsym_entry(arg);
 		break;
+	case LDELF_DL_ENTRY_DLSYM_TABLE:
+		arg->ret = dlsym_table_entry(arg);
+		break;
 	default:
 		arg->ret = TEE_ERROR_NOT_SUPPORTED;
 	}
@@ -213,10 +213,10 @@ static void save_hashtab_from_segment(struct ta_elf *elf, unsigned int type,
 
 	for (n = 0; n < num_dyns; n++) {
 		read_dyn(elf, addr, n, &tag, &val);
-		if (tag == DT_HASH) {
+		if (tag == DT_HASH)
 			elf->hashtab = (void *)(val + elf->load_addr);
-			break;
-		}
+		else if (tag == DT_GNU_HASH)
+			elf->gnu_hashtab = (void *)(val + elf->load_addr);
 	}
 }
 
@@ -260,6 +260,42 @@ static void check_hashtab(struct ta_elf *elf, void *ptr, size_t num_buckets,
 	check_range(elf, "DT_HASH", ptr, sz);
 }
 
+static void check_gnu_hashtab(struct ta_elf *elf, void *ptr)
+{
+	/*
+	 * The table starts with four words: num_buckets, sym_offset,
+	 * bloom_size and bloom_shift. They're followed by bloom_size
+	 * bloom filter words of the ELF class size, num_buckets buckets and
+	 * one chain entry per symbol from sym_offset.
+	 */
+	uint32_t *hashtab = ptr;
+	size_t bloom_word_size = elf->is_32bit ? 4 : 8;
+	size_t num_words = 4;
+	size_t bloom_sz = 0;
+	size_t sz = 0;
+
+	if (elf->is_32bit ? !ALIGNMENT_IS_OK(ptr, uint32_t) :
+			    !ALIGNMENT_IS_OK(ptr, uint64_t))
+		err(TEE_ERROR_BAD_FORMAT, "Bad alignment of DT_GNU_HASH %p",
+		    ptr);
+
+	check_range(elf, "DT_GNU_HASH", ptr, num_words * sizeof(uint32_t));
+
+	if (!hashtab[0] || !IS_POWER_OF_TWO(hashtab[2]) ||
+	    hashtab[3] >= 32 || hashtab[1] > elf->num_dynsyms)
+		err(TEE_ERROR_BAD_FORMAT, "Bad DT_GNU_HASH header");
+
+	if (MUL_OVERFLOW(hashtab[2], bloom_word_size, &bloom_sz) ||
+	    ADD_OVERFLOW(num_words, hashtab[0], &num_words) ||
+	    ADD_OVERFLOW(num_words, elf->num_dynsyms - hashtab[1],
+			 &num_words) ||
+	    MUL_OVERFLOW(num_words, sizeof(uint32_t), &sz) ||
+	    ADD_OVERFLOW(sz, bloom_sz, &sz))
+		err(TEE_ERROR_BAD_FORMAT, "DT_GNU_HASH overflow");
+
+	check_range(elf, "DT_GNU_HASH", ptr, sz);
+}
+
 static void save_hashtab(struct ta_elf *elf)
 {
 	uint32_t *hashtab = NULL;
@@ -281,6 +317,11 @@ static void save_hashtab(struct ta_elf *elf)
 						  phdr[n].p_memsz);
 	}
 
+	if (elf->gnu_hashtab) {
+		check_gnu_hashtab(elf, elf->gnu_hashtab);
+		return;
+	}
+
 	check_hashtab(elf, elf->hashtab, 0, 0);
 	hashtab = elf->hashtab;
 	check_hashtab(elf, elf->hashtab, hashtab[0], hashtab[1]);
@@ -425,6 +466,29 @@ static void save_symtab(struct ta_elf *elf)
 	save_soname(elf);
 }
 
+static void open_elf(struct ta_elf *elf)
+{
+	TEE_Result res = sys_open_ta_bin(&elf->uuid, &elf->handle);
+
+	if (res)
+		err(res, "sys_open_ta_bin(%pUl)", (void *)&elf->uuid);
+	elf->is_open = true;
+}
+
+/*
+ * Opens the ELFs queued after @elf, that is the ones not loaded yet.
+ * Opening a binary is where the TA store fetches it and checks its
+ * signature, so all the direct dependencies of @elf are fetched and
+ * checked before the first one is mapped and a missing or corrupt
+ * library is reported before any work is done on its siblings.
+ */
+static void open_queued_elfs(struct ta_elf *elf)
+{
+	for (elf = TAILQ_NEXT(elf, link); elf; elf = TAILQ_NEXT(elf, link))
+		if (!elf->is_open && !elf->is_main)
+			open_elf(elf);
+}
+
 static void init_elf(struct ta_elf *elf)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -432,9 +496,8 @@ static void init_elf(struct ta_elf *elf)
 	uint32_t flags = LDELF_MAP_FLAG_SHAREABLE;
 	size_t sz = 0;
 
-	res = sys_open_ta_bin(&elf->uuid, &elf->handle);
-	if (res)
-		err(res, "sys_open_ta_bin(%pUl)", (void *)&elf->uuid);
+	if (!elf->is_open)
+		open_elf(elf);
 
 	/*
 	 * Map it read-only executable when we're loading a library where
@@ -810,6 +873,13 @@ static void populate_segments(struct ta_elf *elf)
 				pad_begin = 0;
 			}
 
+			/*
+			 * Read-only segments are mapped shareable, the
+			 * core then backs them with one fobj per slice of
+			 * the binary (identified by its tag) which is
+			 * shared by all instances mapping the same binary.
+			 * Only writeable segments get private copies.
+			 */
 			if (seg->flags & PF_W)
 				flags |= LDELF_MAP_FLAG_WRITEABLE;
 			else
@@ -820,11 +890,13 @@ static void populate_segments(struct ta_elf *elf)
 				err(TEE_ERROR_NOT_SUPPORTED,
 				    "Segment must be readable");
 			if (flags & LDELF_MAP_FLAG_WRITEABLE) {
-				res = sys_map_zi(memsz, 0, &va, pad_begin,
-						 pad_end);
+				res = sys_map_zi(memsz,
+						 LDELF_MAP_FLAG_BLOCK_MAPPED,
+						 &va, pad_begin, pad_end);
 				if (pad_begin && res == TEE_ERROR_OUT_OF_MEMORY)
-					res = sys_map_zi(memsz, 0, &va, 0,
-							 pad_end);
+					res = sys_map_zi(memsz,
+						LDELF_MAP_FLAG_BLOCK_MAPPED,
+						&va, 0, pad_end);
 				if (res)
 					err(res, "sys_map_zi");
 				res = sys_copy_from_ta_bin((void *)va, filesz,
@@ -998,6 +1070,7 @@ static void close_handle(struct ta_elf *elf)
 	if (res)
 		err(res, "sys_close_ta_bin");
 	elf->handle = -1;
+	elf->is_open = false;
 }
 
 static void clean_elf_load_main(struct ta_elf *elf)
@@ -1069,6 +1142,7 @@ static void load_main(struct ta_elf *elf)
 	save_symtab(elf);
 	close_handle(elf);
 	set_tls_offset(elf);
+	open_queued_elfs(elf);
 
 	elf->head = (struct ta_head *)elf->load_addr;
 	if (elf->head->depr_entry != UINT64_MAX) {
@@ -1123,13 +1197,17 @@ void ta_elf_load_main(const TEE_UUID *uuid, uint32_t *is_32bit, uint64_t *sp,
 	load_main(elf);
 
 	*is_32bit = elf->is_32bit;
-	res = sys_map_zi(elf->head->stack_size, 0, &va, 0, 0);
+	res = sys_map_zi(elf->head->stack_size, LDELF_MAP_FLAG_BLOCK_MAPPED,
+			 &va, 0, 0);
 	if (res)
 		err(res, "sys_map_zi stack");
 
 	if (elf->head->flags & ~TA_FLAGS_MASK)
 		err(TEE_ERROR_BAD_FORMAT, "Invalid TA flags(s) %#"PRIx32,
 		    elf->head->flags & ~TA_FLAGS_MASK);
+	if (elf->head->flags & TA_FLAG_CONCURRENT)
+		err(TEE_ERROR_BAD_FORMAT,
+		    "TA_FLAG_CONCURRENT is for pseudo TAs only");
 
 	*ta_flags = elf->head->flags;
 	*sp = va + elf->head->stack_size;
@@ -1176,6 +1254,7 @@ void ta_elf_load_dependency(struct ta_elf *elf, bool is_32bit)
 	save_symtab(elf);
 	close_handle(elf);
 	set_tls_offset(elf);
+	open_queued_elfs(elf);
 }
 
 void ta_elf_finalize_mappings(struct ta_elf *elf)
@@ -58,6 +58,8 @@ struct ta_elf {
 
 	/* DT_HASH hash table for faster resolution of external symbols */
 	void *hashtab;
+	/* DT_GNU_HASH hash table, used instead of hashtab when present */
+	void *gnu_hashtab;
 
 	/* DT_SONAME */
 	char *soname;
@@ -80,6 +82,8 @@ struct ta_elf {
 #endif
 
 	uint32_t handle;
+	/* Set while @handle is an open binary of the TA store */
+	bool is_open;
 
 	struct ta_head *head;
 
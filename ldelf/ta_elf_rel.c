@@ -78,9 +78,55 @@ static bool __resolve_sym(struct ta_elf *elf, unsigned int st_bind,
 	return true;
 }
 
-static TEE_Result resolve_sym_helper(uint32_t hash, const char *name,
-				     vaddr_t *val, struct ta_elf *elf,
-				     bool weak_ok)
+static uint32_t gnu_hash(const char *name)
+{
+	const unsigned char *p = (const unsigned char *)name;
+	uint32_t h = 5381;
+
+	while (*p)
+		h = (h << 5) + h + *p++;
+
+	return h;
+}
+
+struct sym_hash {
+	uint32_t sysv;
+	uint32_t gnu;
+};
+
+static bool resolve_sym_idx(struct ta_elf *elf, size_t n, const char *name,
+			    vaddr_t *val, bool weak_ok)
+{
+	if (n >= elf->num_dynsyms)
+		err(TEE_ERROR_BAD_FORMAT, "Index out of range");
+	/*
+	 * We're loading values from sym[] which later will be used to load
+	 * something.
+	 * => Spectre V1 pattern, need to cap the index against
+	 * speculation.
+	 */
+	n = confine_array_index(n, elf->num_dynsyms);
+
+	if (elf->is_32bit) {
+		Elf32_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF32_ST_BIND(sym[n].st_info),
+				     ELF32_ST_TYPE(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val, weak_ok);
+	} else {
+		Elf64_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF64_ST_BIND(sym[n].st_info),
+				     ELF64_ST_TYPE(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val, weak_ok);
+	}
+}
+
+static TEE_Result resolve_sysv_sym(uint32_t hash, const char *name,
+				   vaddr_t *val, struct ta_elf *elf,
+				   bool weak_ok)
 {
 	/*
 	 * Using uint32_t here for convenience because both Elf64_Word
@@ -93,69 +139,92 @@ static TEE_Result resolve_sym_helper(uint32_t hash, const char *name,
 	uint32_t *chain = &bucket[nbuckets];
 	size_t n = 0;
 
-	if (elf->is_32bit) {
-		Elf32_Sym *sym = elf->dynsymtab;
-
-		for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-			if (n >= nchains || n >= elf->num_dynsyms)
-				err(TEE_ERROR_BAD_FORMAT,
-				    "Index out of range");
-			/*
-			 * We're loading values from sym[] which later
-			 * will be used to load something.
-			 * => Spectre V1 pattern, need to cap the index
-			 * against speculation.
-			 */
-			n = confine_array_index(n, elf->num_dynsyms);
-			if (__resolve_sym(elf,
-					  ELF32_ST_BIND(sym[n].st_info),
-					  ELF32_ST_TYPE(sym[n].st_info),
-					  sym[n].st_shndx,
-					  sym[n].st_name,
-					  sym[n].st_value, name, val, weak_ok))
-				return TEE_SUCCESS;
-		}
-	} else {
-		Elf64_Sym *sym = elf->dynsymtab;
-
-		for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-			if (n >= nchains || n >= elf->num_dynsyms)
-				err(TEE_ERROR_BAD_FORMAT,
-				    "Index out of range");
-			/*
-			 * We're loading values from sym[] which later
-			 * will be used to load something.
-			 * => Spectre V1 pattern, need to cap the index
-			 * against speculation.
-			 */
-			n = confine_array_index(n, elf->num_dynsyms);
-			if (__resolve_sym(elf,
-					  ELF64_ST_BIND(sym[n].st_info),
-					  ELF64_ST_TYPE(sym[n].st_info),
-					  sym[n].st_shndx,
-					  sym[n].st_name,
-					  sym[n].st_value, name, val, weak_ok))
-				return TEE_SUCCESS;
-		}
+	for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
+		if (n >= nchains)
+			err(TEE_ERROR_BAD_FORMAT, "Index out of range");
+		if (resolve_sym_idx(elf, n, name, val, weak_ok))
+			return TEE_SUCCESS;
 	}
 
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
 /*
- * Look for named symbol in @elf, or all modules if @elf == NULL. Global symbols
- * are searched first, then weak ones. Last option, when at least one weak but
- * undefined symbol exists, resolve to zero. Otherwise return
- * TEE_ERROR_ITEM_NOT_FOUND.
- * @val (if != 0) receives the symbol value
- * @found_elf (if != 0) receives the module where the symbol is found
+ * See https://sourceware.org/ml/binutils/2006-10/msg00377.html for the
+ * layout of the GNU hash table. The bloom filter, with words of the size
+ * of the ELF class, rules out most of the symbols not defined by the
+ * module without touching the buckets and chains.
  */
-TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val,
-			      struct ta_elf **found_elf,
-			      struct ta_elf *elf)
+static TEE_Result resolve_gnu_sym(uint32_t hash, const char *name,
+				  vaddr_t *val, struct ta_elf *elf,
+				  bool weak_ok)
 {
-	uint32_t hash = elf_hash(name);
+	uint32_t *hashtab = elf->gnu_hashtab;
+	uint32_t nbuckets = hashtab[0];
+	uint32_t symoffs = hashtab[1];
+	uint32_t bloom_size = hashtab[2];
+	uint32_t bloom_shift = hashtab[3];
+	uint32_t *bucket = NULL;
+	uint32_t *chain = NULL;
+	uint32_t h = 0;
+	size_t n = 0;
 
+	if (elf->is_32bit) {
+		uint32_t *bloom = hashtab + 4;
+		uint32_t word = bloom[(hash / 32) & (bloom_size - 1)];
+		uint32_t mask = BIT32(hash % 32) |
+				BIT32((hash >> bloom_shift) % 32);
+
+		if ((word & mask) != mask)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		bucket = bloom + bloom_size;
+	} else {
+		uint64_t *bloom = (uint64_t *)(hashtab + 4);
+		uint64_t word = bloom[(hash / 64) & (bloom_size - 1)];
+		uint64_t mask = BIT64(hash % 64) |
+				BIT64((hash >> bloom_shift) % 64);
+
+		if ((word & mask) != mask)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		bucket = (uint32_t *)(bloom + bloom_size);
+	}
+	chain = bucket + nbuckets;
+
+	n = bucket[hash % nbuckets];
+	if (!n)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (n < symoffs)
+		err(TEE_ERROR_BAD_FORMAT, "Index out of range");
+
+	/* The last symbol of a chain has the lowest bit of its hash set */
+	do {
+		if (n >= elf->num_dynsyms)
+			err(TEE_ERROR_BAD_FORMAT, "Index out of range");
+		h = chain[n - symoffs];
+		if ((h | 1) == (hash | 1) &&
+		    resolve_sym_idx(elf, n, name, val, weak_ok))
+			return TEE_SUCCESS;
+		n++;
+	} while (!(h & 1));
+
+	return TEE_ERROR_ITEM_NOT_FOUND;
+}
+
+static TEE_Result resolve_sym_helper(const struct sym_hash *hash,
+				     const char *name, vaddr_t *val,
+				     struct ta_elf *elf, bool weak_ok)
+{
+	if (elf->gnu_hashtab)
+		return resolve_gnu_sym(hash->gnu, name, val, elf, weak_ok);
+
+	return resolve_sysv_sym(hash->sysv, name, val, elf, weak_ok);
+}
+
+static TEE_Result resolve_sym_hashed(const struct sym_hash *hash,
+				     const char *name, vaddr_t *val,
+				     struct ta_elf **found_elf,
+				     struct ta_elf *elf)
+{
 	if (elf) {
 		/* Search global symbols */
 		if (!resolve_sym_helper(hash, name, val, elf,
@@ -184,6 +253,26 @@ success:
 	return TEE_SUCCESS;
 }
 
+/*
+ * Look for named symbol in @elf, or all modules if @elf == NULL. Global symbols
+ * are searched first, then weak ones. Last option, when at least one weak but
+ * undefined symbol exists, resolve to zero. Otherwise return
+ * TEE_ERROR_ITEM_NOT_FOUND.
+ * @val (if != 0) receives the symbol value
+ * @found_elf (if != 0) receives the module where the symbol is found
+ */
+TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val,
+			      struct ta_elf **found_elf,
+			      struct ta_elf *elf)
+{
+	struct sym_hash hash = {
+		.sysv = elf_hash(name),
+		.gnu = gnu_hash(name),
+	};
+
+	return resolve_sym_hashed(&hash, name, val, found_elf, elf);
+}
+
 static void e32_get_sym_name(const Elf32_Sym *sym_tab, size_t num_syms,
 			     const char *str_tab, size_t str_tab_size,
 			     Elf32_Rel *rel, const char **name)
@@ -202,12 +291,54 @@ static void e32_get_sym_name(const Elf32_Sym *sym_tab, size_t num_syms,
 	*name = str_tab + name_idx;
 }
 
+/*
+ * Cache of the symbols resolved for relocations. The same symbols are
+ * typically imported by several modules, for instance the libutee
+ * functions. Modules are only appended to main_elf_queue and never
+ * unloaded so a resolved symbol stays valid, and so does the name which
+ * points into the string table of a loaded module.
+ *
+ * The cache only lives as long as this ldelf instance. Keeping resolved
+ * symbols across TA instances would need the core to store them, but
+ * both ldelf and the TA can invoke the system PTA so the TA could feed
+ * bogus offsets to the next instance of itself, and only the symbol
+ * lookups would be saved since ASLR changes all the load addresses.
+ */
+#define SYM_CACHE_SIZE	64
+
+struct sym_cache_entry {
+	const char *name;
+	uint32_t hash;
+	vaddr_t val;
+	struct ta_elf *mod;
+};
+
+static struct sym_cache_entry sym_cache[SYM_CACHE_SIZE];
+
 static void resolve_sym(const char *name, vaddr_t *val, struct ta_elf **mod)
 {
-	TEE_Result res = ta_elf_resolve_sym(name, val, mod, NULL);
+	struct sym_hash hash = {
+		.sysv = elf_hash(name),
+		.gnu = gnu_hash(name),
+	};
+	struct sym_cache_entry *ce = sym_cache + hash.gnu % SYM_CACHE_SIZE;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!ce->name || ce->hash != hash.gnu || strcmp(ce->name, name)) {
+		res = resolve_sym_hashed(&hash, name, &ce->val, &ce->mod,
+					 NULL);
+		if (res) {
+			ce->name = NULL;
+			err(res, "Symbol %s not found", name);
+		}
+		ce->name = name;
+		ce->hash = hash.gnu;
+	}
 
-	if (res)
-		err(res, "Symbol %s not found", name);
+	if (val)
+		*val = ce->val;
+	if (mod)
+		*mod = ce->mod;
 }
 
 static void e32_process_dyn_rel(const Elf32_Sym *sym_tab, size_t num_syms,
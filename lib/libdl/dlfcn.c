@@ -8,6 +8,7 @@
 #include <pta_system.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee_api.h>
 #include <tee_internal_api_extensions.h>
 #include <user_ta_header.h>
@@ -31,10 +32,46 @@ static TEE_Result invoke_system_pta(uint32_t cmd_id, uint32_t param_types,
 				   cmd_id, param_types, params, NULL);
 }
 
+/*
+ * Libraries are loaded with RTLD_NODELETE so a resolved symbol keeps its
+ * address, successful lookups are cached in the handle.
+ */
+struct dl_sym {
+	SLIST_ENTRY(dl_sym) link;
+	void *ptr;
+	char name[];
+};
+
 struct dl_handle {
 	TEE_UUID uuid;
+	SLIST_HEAD(, dl_sym) syms;
 };
 
+static void *find_cached_sym(struct dl_handle *h, const char *symbol)
+{
+	struct dl_sym *s = NULL;
+
+	SLIST_FOREACH(s, &h->syms, link)
+		if (!strcmp(s->name, symbol))
+			return s->ptr;
+
+	return NULL;
+}
+
+static void cache_sym(struct dl_handle *h, const char *symbol, void *ptr)
+{
+	size_t len = strlen(symbol) + 1;
+	struct dl_sym *s = malloc(sizeof(*s) + len);
+
+	/* Not caching is harmless, the next lookup asks the core again */
+	if (!s)
+		return;
+
+	s->ptr = ptr;
+	memcpy(s->name, symbol, len);
+	SLIST_INSERT_HEAD(&h->syms, s, link);
+}
+
 void *dlopen(const char *filename, int flags)
 {
 	TEE_Param params[TEE_NUM_PARAMS] = { };
@@ -71,6 +108,7 @@ void *dlopen(const char *filename, int flags)
 
 	hcount++;
 	h->uuid = uuid;
+	SLIST_INIT(&h->syms);
 	return (void *)h;
 err:
 	free(h);
@@ -79,6 +117,14 @@ err:
 
 int dlclose(void *handle)
 {
+	struct dl_handle *h = handle;
+	struct dl_sym *s = NULL;
+
+	while (h && !SLIST_EMPTY(&h->syms)) {
+		s = SLIST_FIRST(&h->syms);
+		SLIST_REMOVE_HEAD(&h->syms, link);
+		free(s);
+	}
 	free(handle);
 	hcount--;
 	if (!hcount && sess != TEE_HANDLE_NULL) {
@@ -99,6 +145,10 @@ void *dlsym(void *handle, const char *symbol)
 	if (!handle || !symbol)
 		return NULL;
 
+	ptr = find_cached_sym(h, symbol);
+	if (ptr)
+		return ptr;
+
 	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
 				      TEE_PARAM_TYPE_MEMREF_INPUT,
 				      TEE_PARAM_TYPE_VALUE_OUTPUT,
@@ -110,10 +160,117 @@ void *dlsym(void *handle, const char *symbol)
 	params[1].memref.size = strlen(symbol) + 1;
 
 	res = invoke_system_pta(PTA_SYSTEM_DLSYM, param_types, params);
-	if (!res)
+	if (!res) {
 		ptr = (void *)(vaddr_t)reg_pair_to_64(params[2].value.a,
 						      params[2].value.b);
+		if (ptr)
+			cache_sym(h, symbol, ptr);
+	}
 
 	return ptr;
 }
 
+#define DLSYM_TABLE_MAX_SYMS	(PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE / 16)
+#define DLSYM_TABLE_NAMES_SIZE	(PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE / 2)
+
+/*
+ * Resolves the symbols from @first up to @last - 1 which aren't cached
+ * and fit in one PTA_SYSTEM_DLSYM_TABLE request. @buf is used for the
+ * request, @next receives the index of the first symbol left for the
+ * next request.
+ */
+static TEE_Result dlsym_table_chunk(struct dl_handle *h,
+				    const char *const *symbols, void **ptrs,
+				    size_t first, size_t last, size_t *next,
+				    void *buf)
+{
+	uint64_t *vals = buf;
+	char *names = (char *)(vals + DLSYM_TABLE_MAX_SYMS);
+	TEE_Param params[TEE_NUM_PARAMS] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t param_types = 0;
+	size_t names_len = 0;
+	size_t count = 0;
+	size_t len = 0;
+	size_t n = 0;
+
+	for (n = first; n < last && count < DLSYM_TABLE_MAX_SYMS; n++) {
+		if (ptrs[n])
+			continue;
+		len = strlen(symbols[n]) + 1;
+		if (len > DLSYM_TABLE_NAMES_SIZE)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (names_len + len > DLSYM_TABLE_NAMES_SIZE)
+			break;
+		memcpy(names + names_len, symbols[n], len);
+		names_len += len;
+		count++;
+	}
+	*next = n;
+	if (!count)
+		return TEE_SUCCESS;
+
+	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				      TEE_PARAM_TYPE_NONE);
+
+	params[0].memref.buffer = &h->uuid;
+	params[0].memref.size = sizeof(h->uuid);
+	params[1].memref.buffer = names;
+	params[1].memref.size = names_len;
+	params[2].memref.buffer = vals;
+	params[2].memref.size = count * sizeof(*vals);
+
+	res = invoke_system_pta(PTA_SYSTEM_DLSYM_TABLE, param_types, params);
+	if (res)
+		return res;
+
+	count = 0;
+	for (n = first; n < *next; n++) {
+		if (ptrs[n])
+			continue;
+		ptrs[n] = (void *)(vaddr_t)vals[count++];
+		if (ptrs[n])
+			cache_sym(h, symbols[n], ptrs[n]);
+	}
+
+	return TEE_SUCCESS;
+}
+
+int dlsym_table(void *handle, const char *const *symbols, void **ptrs,
+		size_t count)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct dl_handle *h = handle;
+	bool all_cached = true;
+	void *buf = NULL;
+	size_t next = 0;
+	size_t n = 0;
+
+	if (!handle || (count && (!symbols || !ptrs)))
+		return -1;
+
+	for (n = 0; n < count; n++) {
+		if (!symbols[n])
+			return -1;
+		ptrs[n] = find_cached_sym(h, symbols[n]);
+		if (!ptrs[n])
+			all_cached = false;
+	}
+	if (all_cached)
+		return 0;
+
+	buf = malloc(PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE);
+	if (!buf)
+		return -1;
+
+	for (n = 0; !res && n < count; n = next)
+		res = dlsym_table_chunk(h, symbols, ptrs, n, count, &next,
+					buf);
+
+	free(buf);
+
+	return res ? -1 : 0;
+}
+
@@ -6,6 +6,8 @@
 #ifndef _DLFCN_H_
 #define _DLFCN_H_
 
+#include <stddef.h>
+
 /* Relocations are performed when the object is loaded. */
 #define RTLD_NOW	2
 /* All symbols are available for relocation processing of other modules. */
@@ -19,4 +21,12 @@ void *dlopen(const char *filename, int flags);
 int dlclose(void *handle);
 void *dlsym(void *handle, const char *symbol);
 
+/*
+ * Non-standard extension: resolves the @count symbols of @symbols with as
+ * few requests to the core as possible, @ptrs[n] receives the address of
+ * @symbols[n] or NULL if not found. Returns 0 on success or -1 on error.
+ */
+int dlsym_table(void *handle, const char *const *symbols, void **ptrs,
+		size_t count);
+
 #endif /* _DLFCN_H_ */
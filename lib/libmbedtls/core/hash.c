@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <compiler.h>
+#include <config.h>
 #include <crypto/crypto_accel.h>
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
@@ -183,6 +184,9 @@ TEE_Result hash_sha256_check(const uint8_t *hash, const uint8_t *data,
 	mbedtls_sha256_context hs;
 	uint8_t digest[TEE_SHA256_HASH_SIZE] = { 0 };
 
+	if (IS_ENABLED(CFG_CORE_CRYPTO_SHA256_ACCEL))
+		return crypto_accel_sha256_check(hash, data, data_size);
+
 	memset(&hs, 0, sizeof(hs));
 	mbedtls_sha256_init(&hs);
 	mbedtls_sha256_starts(&hs, 0);
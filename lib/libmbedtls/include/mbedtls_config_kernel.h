@@ -3,12 +3,17 @@
 #ifndef __MBEDTLS_CONFIG_KERNEL_H
 #define __MBEDTLS_CONFIG_KERNEL_H
 
+#ifdef CFG_CORE_MBEDTLS_MPI_ASM
+/* The limb size follows the architecture, see mbedtls/bignum.h */
+#define MBEDTLS_HAVE_ASM
+#else
 #ifdef ARM32
 #define MBEDTLS_HAVE_INT32
 #endif
 #ifdef ARM64
 #define MBEDTLS_HAVE_INT64
 #endif
+#endif
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_GENPRIME
 
@@ -8,6 +8,9 @@
  * use 32-bit arithmetics.
  */
 #define MBEDTLS_HAVE_INT32
+#ifdef CFG_TA_MBEDTLS_MPI_ASM
+#define MBEDTLS_HAVE_ASM
+#endif
 
 #define MBEDTLS_CIPHER_MODE_CBC
 #define MBEDTLS_PKCS1_V15
@@ -15,9 +18,16 @@
 #define MBEDTLS_CIPHER_C
 #define MBEDTLS_DES_C
 #define MBEDTLS_AES_C
+#ifdef CFG_TA_MBEDTLS_ARM_CE
+#define MBEDTLS_AES_ALT
+#endif
 
 #define MBEDTLS_SHA1_C
 #define MBEDTLS_SHA256_C
+#ifdef CFG_TA_MBEDTLS_ARM_CE
+#define MBEDTLS_SHA1_PROCESS_ALT
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 #define MBEDTLS_MD_C
 #define MBEDTLS_MD5_C
 
@@ -198,7 +198,7 @@
 
 #endif /* AMD64 */
 
-#if defined(__aarch64__)
+#if defined(__aarch64__) && defined(MBEDTLS_HAVE_INT64)
 
 #define MULADDC_INIT                \
     asm(
@@ -220,6 +220,29 @@
          : "x4", "x5", "x6", "x7", "cc"     \
     );
 
+#elif defined(__aarch64__)
+
+/*
+ * 32-bit limbs, s * b + d + c can't overflow 64 bits so a single UMADDL
+ * and an extended add do the whole multiply-accumulate.
+ */
+#define MULADDC_INIT                        \
+    asm(
+
+#define MULADDC_CORE                        \
+        "ldr    w4, [%2], #4        \n\t"   \
+        "ldr    w5, [%1]            \n\t"   \
+        "umaddl x6, w4, %w3, x5     \n\t"   \
+        "add    x6, x6, %w0, uxtw   \n\t"   \
+        "str    w6, [%1], #4        \n\t"   \
+        "lsr    %x0, x6, #32        \n\t"
+
+#define MULADDC_STOP                        \
+         : "+r" (c),  "+r" (d), "+r" (s)    \
+         : "r" (b)                          \
+         : "x4", "x5", "x6", "memory"       \
+    );
+
 #endif /* Aarch64 */
 
 #if defined(__mc68020__) || defined(__mcpu32__)
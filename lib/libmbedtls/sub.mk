@@ -98,3 +98,6 @@ cflags-lib-y += -Wno-switch-default
 ifeq ($(CFG_CRYPTOLIB_NAME_mbedtls),y)
 subdirs-$(sm-core) += core
 endif
+ifeq ($(CFG_TA_MBEDTLS_ARM_CE),y)
+subdirs-$(sm-$(ta-target)) += uta
+endif
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * MBEDTLS_AES_ALT for the TAs, see CFG_TA_MBEDTLS_ARM_CE. The assembly of
+ * the core in core/arch/arm/crypto is built into libutee, the VFP is
+ * enabled for the TA by the core on first use.
+ */
+
+#include <assert.h>
+#include <util.h>
+#include <mbedtls/aes.h>
+#include <mbedtls/platform_util.h>
+#include <string.h>
+
+#include "../../../core/arch/arm/crypto/aes_armv8a_ce.h"
+
+/* From libutee, returns a TEE_Result */
+uint32_t __utee_ce_aes_expand_keys(const void *key, size_t key_len,
+				   void *enc_key, void *dec_key,
+				   size_t expanded_key_len,
+				   unsigned int *round_count);
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+	assert(ctx);
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+	if (ctx)
+		mbedtls_platform_zeroize(ctx, sizeof(*ctx));
+}
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+			   unsigned int keybits)
+{
+	assert(ctx && key);
+
+	if (keybits != 128 && keybits != 192 && keybits != 256)
+		return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+
+	if (__utee_ce_aes_expand_keys(key, keybits / 8, ctx->key, NULL,
+				      sizeof(ctx->key), &ctx->round_count))
+		return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+	return 0;
+}
+
+int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key,
+			   unsigned int keybits)
+{
+	uint32_t enc_key[ARRAY_SIZE(ctx->key)] = { 0 };
+	int res = 0;
+
+	assert(ctx && key);
+
+	if (keybits != 128 && keybits != 192 && keybits != 256)
+		return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+
+	if (__utee_ce_aes_expand_keys(key, keybits / 8, enc_key, ctx->key,
+				      sizeof(ctx->key), &ctx->round_count))
+		res = MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+	mbedtls_platform_zeroize(enc_key, sizeof(enc_key));
+
+	return res;
+}
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx, int mode,
+			  const unsigned char input[16],
+			  unsigned char output[16])
+{
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		ce_aes_ecb_encrypt(output, input, (const uint8_t *)ctx->key,
+				   ctx->round_count, 1, 1);
+	else
+		ce_aes_ecb_decrypt(output, input, (const uint8_t *)ctx->key,
+				   ctx->round_count, 1, 1);
+
+	return 0;
+}
+
+int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx, int mode, size_t length,
+			  unsigned char iv[16], const unsigned char *input,
+			  unsigned char *output)
+{
+	if (length % 16)
+		return MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		ce_aes_cbc_encrypt(output, input, (const uint8_t *)ctx->key,
+				   ctx->round_count, length / 16, iv);
+	else
+		ce_aes_cbc_decrypt(output, input, (const uint8_t *)ctx->key,
+				   ctx->round_count, length / 16, iv);
+
+	return 0;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * MBEDTLS_SHA1_PROCESS_ALT and MBEDTLS_SHA256_PROCESS_ALT for the TAs, see
+ * CFG_TA_MBEDTLS_ARM_CE. The transforms of the core are built into libutee.
+ */
+
+#include <mbedtls/platform_util.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+#include <stdint.h>
+
+/* Prototypes for assembly functions */
+void sha1_ce_transform(uint32_t state[5], const void *src,
+		       unsigned int block_count);
+void sha256_ce_transform(uint32_t state[8], const void *src,
+			 unsigned int block_count);
+
+int mbedtls_internal_sha1_process(mbedtls_sha1_context *ctx,
+				  const unsigned char data[64])
+{
+	MBEDTLS_INTERNAL_VALIDATE_RET(ctx != NULL,
+				      MBEDTLS_ERR_SHA1_BAD_INPUT_DATA);
+	MBEDTLS_INTERNAL_VALIDATE_RET((const unsigned char *)data != NULL,
+				      MBEDTLS_ERR_SHA1_BAD_INPUT_DATA);
+
+	sha1_ce_transform(ctx->state, data, 1);
+
+	return 0;
+}
+
+int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
+				    const unsigned char data[64])
+{
+	MBEDTLS_INTERNAL_VALIDATE_RET(ctx != NULL,
+				      MBEDTLS_ERR_SHA256_BAD_INPUT_DATA);
+	MBEDTLS_INTERNAL_VALIDATE_RET((const unsigned char *)data != NULL,
+				      MBEDTLS_ERR_SHA256_BAD_INPUT_DATA);
+
+	sha256_ce_transform(ctx->state, data, 1);
+
+	return 0;
+}
@@ -0,0 +1,2 @@
+srcs-y += aes.c
+srcs-y += hash.c
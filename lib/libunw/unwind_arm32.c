@@ -108,6 +108,36 @@ static int32_t expand_prel31(uint32_t prel31)
 	return prel31 | SHIFT_U32(prel31 & BIT32(30), 1);
 }
 
+static vaddr_t idx_func_addr(struct unwind_idx *item)
+{
+	return (vaddr_t)&item->offset + expand_prel31(item->offset);
+}
+
+/*
+ * Index entries found by find_index(), a stack is usually unwound again
+ * and again through the same call sites. An entry is only a hint set and
+ * read without locks, it's checked against the index table of @addr
+ * before use.
+ */
+#define IDX_CACHE_SIZE		64
+static struct unwind_idx *idx_cache[IDX_CACHE_SIZE];
+
+static size_t idx_cache_slot(uint32_t addr)
+{
+	return (addr >> 2) % IDX_CACHE_SIZE;
+}
+
+static bool idx_covers(struct unwind_idx *item, struct unwind_idx *start,
+		       struct unwind_idx *end, uint32_t addr)
+{
+	if (item < start || item >= end)
+		return false;
+	if (idx_func_addr(item) > addr)
+		return false;
+
+	return item + 1 == end || idx_func_addr(item + 1) > addr;
+}
+
 /*
  * Perform a binary search of the index table to find the function
  * with the largest address that does not exceed addr.
@@ -121,14 +151,17 @@ static struct unwind_idx *find_index(uint32_t addr)
 	unsigned int max = 0;
 	struct unwind_idx *start = NULL;
 	struct unwind_idx *item = NULL;
-	int32_t prel31_addr = 0;
-	vaddr_t func_addr = 0;
+	size_t slot = idx_cache_slot(addr);
 
 	if (!find_exidx(addr, &idx_start, &idx_end))
 		return NULL;
 
 	start = (struct unwind_idx *)idx_start;
 
+	item = idx_cache[slot];
+	if (idx_covers(item, start, (struct unwind_idx *)idx_end, addr))
+		return item;
+
 	min = 0;
 	max = (idx_end - idx_start) / sizeof(struct unwind_idx);
 
@@ -137,15 +170,14 @@ static struct unwind_idx *find_index(uint32_t addr)
 
 		item = &start[mid];
 
-		prel31_addr = expand_prel31(item->offset);
-		func_addr = (vaddr_t)&item->offset + prel31_addr;
-
-		if (func_addr <= addr)
+		if (idx_func_addr(item) <= addr)
 			min = mid;
 		else
 			max = mid - 1;
 	}
 
+	idx_cache[slot] = &start[min];
+
 	return &start[min];
 }
 
@@ -7,5 +7,19 @@ ifneq ($(sm),ldelf)
 srcs-y += tcb.c
 srcs-y += user_ta_entry.c
 subdirs-y += gprof
+
+ifneq ($(filter y,$(CFG_TA_CRYPTO_ARM_CE) $(CFG_TA_MBEDTLS_ARM_CE)),)
+srcs-$(CFG_TA_CRYPTO_ARM_CE) += utee_ce.c
+srcs-y += utee_ce_aes.c
+srcs-$(CFG_ARM32_$(sm)) += aes_ce_a32.S
+srcs-$(CFG_ARM32_$(sm)) += sha256_ce_a32.S
+srcs-$(CFG_ARM64_$(sm)) += aes_ce_a64.S
+aflags-aes_ce_a64.S-y += -DINTERLEAVE=4
+srcs-$(CFG_ARM64_$(sm)) += sha256_ce_a64.S
+endif
+ifeq ($(CFG_TA_MBEDTLS_ARM_CE),y)
+srcs-$(CFG_ARM32_$(sm)) += sha1_ce_a32.S
+srcs-$(CFG_ARM64_$(sm)) += sha1_ce_a64.S
+endif
 endif #$(sm-$(sm)-is-ld)
 
@@ -150,11 +150,23 @@ void __utee_call_elf_fini_fn(void)
 	dl_iterate_phdr(_fini_iterate_phdr_cb, NULL);
 }
 
+static void init_malloc(void)
+{
+	bool size_classes = false;
+
+	malloc_add_pool(ta_heap, ta_heap_size);
+
+	if (!TEE_GetPropertyAsBool(TEE_PROPSET_CURRENT_TA,
+				   TA_PROP_STR_MALLOC_SIZE_CLASSES,
+				   &size_classes) && size_classes)
+		malloc_enable_magazines();
+}
+
 static TEE_Result init_instance(void)
 {
 	trace_set_level(tahead_get_trace_level());
 	__utee_gprof_init();
-	malloc_add_pool(ta_heap, ta_heap_size);
+	init_malloc();
 	_TEE_MathAPI_Init();
 	__utee_tcb_init();
 	__utee_call_elf_init_fn();
@@ -229,6 +241,10 @@ static void ta_header_remove_session(uint32_t session_id)
 			keep_alive =
 				(ta_head.flags & TA_FLAG_SINGLE_INSTANCE) &&
 				(ta_head.flags & TA_FLAG_INSTANCE_KEEP_ALIVE);
+			/* The instance may be reused by the next session */
+			if (!(ta_head.flags & TA_FLAG_SINGLE_INSTANCE) &&
+			    (ta_head.flags & TA_FLAG_INSTANCE_POOL))
+				keep_alive = true;
 			if (TAILQ_EMPTY(&ta_sessions) && !keep_alive)
 				uninit_instance();
 
@@ -366,12 +382,16 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 {
 	TEE_Result res;
 
+	__utee_prop_cache_enter_session(session_id);
+
 	switch (func) {
 	case UTEE_ENTRY_FUNC_OPEN_SESSION:
 		res = entry_open_session(session_id, up);
 		break;
 	case UTEE_ENTRY_FUNC_CLOSE_SESSION:
 		res = entry_close_session(session_id);
+		/* The session ID may be reused by a session of another client */
+		__utee_prop_cache_enter_session(0);
 		break;
 	case UTEE_ENTRY_FUNC_INVOKE_COMMAND:
 		res = entry_invoke_command(session_id, up, cmd_id);
@@ -382,6 +402,7 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 		break;
 	}
 	ta_header_save_params(0, NULL);
+	__utee_temp_pool_release();
 
 	return res;
 }
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * AES and SHA-256 with the ARMv8 Cryptographic Extensions in user mode,
+ * using the assembly of the core in core/arch/arm/crypto. The VFP is
+ * enabled for the TA by the core on first use.
+ */
+
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api.h>
+#include <tee_api_private.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "../../../../core/arch/arm/crypto/aes_armv8a_ce.h"
+
+#define SHA256_BLOCK_SIZE	64
+
+/* Prototype for assembly function */
+void sha256_ce_transform(uint32_t state[8], const void *src,
+			 unsigned int block_count);
+
+struct sha256_state {
+	uint32_t state[8];
+	uint8_t buf[SHA256_BLOCK_SIZE];
+	size_t buf_len;
+	uint64_t total_len;
+};
+
+struct aes_state {
+	/* Round keys for encryption, or decryption with ECB and CBC */
+	uint64_t key[30];
+	unsigned int rounds;
+	/* IV with CBC, counter with CTR */
+	uint8_t iv[TEE_AES_BLOCK_SIZE];
+	/* CTR key stream of the last partial block */
+	uint8_t ks[TEE_AES_BLOCK_SIZE];
+	size_t ks_offs;
+};
+
+struct utee_ce_state {
+	uint32_t algo;
+	uint32_t mode;
+	union {
+		struct sha256_state sha256;
+		struct aes_state aes;
+	};
+};
+
+struct utee_ce_state *__utee_ce_state_alloc(uint32_t algo, uint32_t mode)
+{
+	struct utee_ce_state *st = NULL;
+
+	switch (algo) {
+	case TEE_ALG_SHA256:
+	case TEE_ALG_AES_ECB_NOPAD:
+	case TEE_ALG_AES_CBC_NOPAD:
+	case TEE_ALG_AES_CTR:
+		break;
+	default:
+		return NULL;
+	}
+
+	st = TEE_Malloc(sizeof(*st), TEE_MALLOC_FILL_ZERO);
+	if (!st)
+		return NULL;
+	st->algo = algo;
+	st->mode = mode;
+
+	return st;
+}
+
+void __utee_ce_state_free(struct utee_ce_state *st)
+{
+	if (st) {
+		memzero_explicit(st, sizeof(*st));
+		TEE_Free(st);
+	}
+}
+
+void __utee_ce_state_copy(struct utee_ce_state *dst,
+			  const struct utee_ce_state *src)
+{
+	*dst = *src;
+}
+
+void __utee_ce_hash_init(struct utee_ce_state *st)
+{
+	static const uint32_t h0[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	struct sha256_state *s = &st->sha256;
+
+	memcpy(s->state, h0, sizeof(s->state));
+	s->buf_len = 0;
+	s->total_len = 0;
+}
+
+void __utee_ce_hash_update(struct utee_ce_state *st, const void *data,
+			   size_t len)
+{
+	struct sha256_state *s = &st->sha256;
+	const uint8_t *p = data;
+	size_t n = 0;
+
+	s->total_len += len;
+
+	if (s->buf_len) {
+		n = MIN(len, SHA256_BLOCK_SIZE - s->buf_len);
+		memcpy(s->buf + s->buf_len, p, n);
+		s->buf_len += n;
+		p += n;
+		len -= n;
+		if (s->buf_len < SHA256_BLOCK_SIZE)
+			return;
+		sha256_ce_transform(s->state, s->buf, 1);
+		s->buf_len = 0;
+	}
+
+	n = len / SHA256_BLOCK_SIZE;
+	if (n) {
+		sha256_ce_transform(s->state, p, n);
+		p += n * SHA256_BLOCK_SIZE;
+		len -= n * SHA256_BLOCK_SIZE;
+	}
+
+	memcpy(s->buf, p, len);
+	s->buf_len = len;
+}
+
+void __utee_ce_hash_final(struct utee_ce_state *st, void *digest)
+{
+	struct sha256_state *s = &st->sha256;
+	uint64_t nbits = s->total_len * 8;
+	uint8_t *d = digest;
+	size_t n = 0;
+
+	/* The final 0x80 byte and the 64-bit length may need another block */
+	s->buf[s->buf_len++] = 0x80;
+	if (s->buf_len > SHA256_BLOCK_SIZE - 8) {
+		memset(s->buf + s->buf_len, 0, SHA256_BLOCK_SIZE - s->buf_len);
+		sha256_ce_transform(s->state, s->buf, 1);
+		s->buf_len = 0;
+	}
+	memset(s->buf + s->buf_len, 0, SHA256_BLOCK_SIZE - s->buf_len);
+	for (n = 0; n < 8; n++)
+		s->buf[SHA256_BLOCK_SIZE - 1 - n] = nbits >> (n * 8);
+	sha256_ce_transform(s->state, s->buf, 1);
+
+	for (n = 0; n < ARRAY_SIZE(s->state); n++) {
+		d[n * 4] = s->state[n] >> 24;
+		d[n * 4 + 1] = s->state[n] >> 16;
+		d[n * 4 + 2] = s->state[n] >> 8;
+		d[n * 4 + 3] = s->state[n];
+	}
+}
+
+static bool use_dec_key(struct utee_ce_state *st)
+{
+	return st->mode == TEE_MODE_DECRYPT && st->algo != TEE_ALG_AES_CTR;
+}
+
+bool __utee_ce_cipher_init(struct utee_ce_state *st, const void *key,
+			   size_t key_len, const void *iv, size_t iv_len)
+{
+	struct aes_state *s = &st->aes;
+	uint64_t enc_key[30] = { };
+	void *dec_key = NULL;
+
+	if (st->algo != TEE_ALG_AES_ECB_NOPAD) {
+		if (!iv || iv_len != TEE_AES_BLOCK_SIZE)
+			return false;
+		memcpy(s->iv, iv, TEE_AES_BLOCK_SIZE);
+	}
+
+	if (use_dec_key(st))
+		dec_key = s->key;
+	if (__utee_ce_aes_expand_keys(key, key_len, enc_key, dec_key,
+				      sizeof(enc_key), &s->rounds))
+		return false;
+	if (!dec_key)
+		memcpy(s->key, enc_key, sizeof(s->key));
+	memzero_explicit(enc_key, sizeof(enc_key));
+
+	s->ks_offs = TEE_AES_BLOCK_SIZE;
+
+	return true;
+}
+
+static void ctr_update(struct aes_state *s, const uint8_t *src, size_t len,
+		       uint8_t *dst)
+{
+	const uint8_t *rk = (const uint8_t *)s->key;
+	size_t n = 0;
+
+	/* Use up the key stream left by a previous partial block */
+	while (len && s->ks_offs < TEE_AES_BLOCK_SIZE) {
+		*dst++ = *src++ ^ s->ks[s->ks_offs++];
+		len--;
+	}
+
+	n = len / TEE_AES_BLOCK_SIZE;
+	if (n) {
+		ce_aes_ctr_encrypt(dst, src, rk, s->rounds, n, s->iv, 1);
+		src += n * TEE_AES_BLOCK_SIZE;
+		dst += n * TEE_AES_BLOCK_SIZE;
+		len -= n * TEE_AES_BLOCK_SIZE;
+	}
+
+	if (len) {
+		memset(s->ks, 0, sizeof(s->ks));
+		ce_aes_ctr_encrypt(s->ks, s->ks, rk, s->rounds, 1, s->iv, 1);
+		for (n = 0; n < len; n++)
+			dst[n] = src[n] ^ s->ks[n];
+		s->ks_offs = len;
+	}
+}
+
+void __utee_ce_cipher_update(struct utee_ce_state *st, const void *src,
+			     size_t len, void *dst)
+{
+	struct aes_state *s = &st->aes;
+	const uint8_t *rk = (const uint8_t *)s->key;
+	int blocks = len / TEE_AES_BLOCK_SIZE;
+
+	switch (st->algo) {
+	case TEE_ALG_AES_ECB_NOPAD:
+		if (st->mode == TEE_MODE_ENCRYPT)
+			ce_aes_ecb_encrypt(dst, src, rk, s->rounds, blocks, 1);
+		else
+			ce_aes_ecb_decrypt(dst, src, rk, s->rounds, blocks, 1);
+		break;
+	case TEE_ALG_AES_CBC_NOPAD:
+		if (st->mode == TEE_MODE_ENCRYPT)
+			ce_aes_cbc_encrypt(dst, src, rk, s->rounds, blocks,
+					   s->iv);
+		else
+			ce_aes_cbc_decrypt(dst, src, rk, s->rounds, blocks,
+					   s->iv);
+		break;
+	case TEE_ALG_AES_CTR:
+		ctr_update(s, src, len, dst);
+		break;
+	default:
+		TEE_Panic(0);
+	}
+}
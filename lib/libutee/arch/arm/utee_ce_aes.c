@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * AES key expansion with the ARMv8 Cryptographic Extensions in user mode,
+ * shared by the TEE Internal Core API (CFG_TA_CRYPTO_ARM_CE) and the
+ * mbedTLS of the TAs (CFG_TA_MBEDTLS_ARM_CE).
+ */
+
+#include <string.h>
+#include <tee_api.h>
+#include <tee_api_private.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "../../../../core/arch/arm/crypto/aes_armv8a_ce.h"
+
+struct aes_block {
+	uint8_t b[TEE_AES_BLOCK_SIZE];
+};
+
+static uint32_t ror32(uint32_t val, unsigned int shift)
+{
+	return (val >> shift) | (val << (32 - shift));
+}
+
+/* Same as expand_enc_key() in core/arch/arm/crypto/aes_armv8a_ce.c */
+static void expand_enc_key(uint32_t *enc_key, size_t key_len)
+{
+	/* The AES key schedule round constants */
+	static uint8_t const rcon[] = {
+		0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36,
+	};
+	unsigned int kwords = key_len / sizeof(uint32_t);
+	unsigned int i = 0;
+
+	for (i = 0; i < sizeof(rcon); i++) {
+		uint32_t *rki = enc_key + i * kwords;
+		uint32_t *rko = rki + kwords;
+
+		rko[0] = ror32(ce_aes_sub(rki[kwords - 1]), 8) ^
+			 rcon[i] ^ rki[0];
+		rko[1] = rko[0] ^ rki[1];
+		rko[2] = rko[1] ^ rki[2];
+		rko[3] = rko[2] ^ rki[3];
+
+		if (key_len == 24) {
+			if (i >= 7)
+				break;
+			rko[4] = rko[3] ^ rki[4];
+			rko[5] = rko[4] ^ rki[5];
+		} else if (key_len == 32) {
+			if (i >= 6)
+				break;
+			rko[4] = ce_aes_sub(rko[3]) ^ rki[4];
+			rko[5] = rko[4] ^ rki[5];
+			rko[6] = rko[5] ^ rki[6];
+			rko[7] = rko[6] ^ rki[7];
+		}
+	}
+}
+
+/* Round keys of the Equivalent Inverse Cipher */
+static void make_dec_key(unsigned int round_count,
+			 const struct aes_block *key_enc,
+			 struct aes_block *key_dec)
+{
+	unsigned int i = 0;
+	unsigned int j = round_count;
+
+	key_dec[0] = key_enc[j];
+	for (i = 1, j--; j > 0; i++, j--)
+		ce_aes_invert(key_dec + i, key_enc + j);
+	key_dec[i] = key_enc[0];
+}
+
+TEE_Result __utee_ce_aes_expand_keys(const void *key, size_t key_len,
+				     void *enc_key, void *dec_key,
+				     size_t expanded_key_len,
+				     unsigned int *round_count)
+{
+	unsigned int num_rounds = 0;
+
+	if (!key || !enc_key)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!ALIGNMENT_IS_OK(enc_key, uint32_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_rounds = 10 + ((key_len / 8) - 2) * 2;
+
+	if (expanded_key_len < (num_rounds + 1) * sizeof(struct aes_block))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*round_count = num_rounds;
+	memset(enc_key, 0, expanded_key_len);
+	memcpy(enc_key, key, key_len);
+
+	expand_enc_key(enc_key, key_len);
+	if (dec_key)
+		make_dec_key(num_rounds, enc_key, dec_key);
+
+	return TEE_SUCCESS;
+}
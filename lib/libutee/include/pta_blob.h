@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * Encapsulation and decapsulation of blobs with the hardware crypto
+ * driver. The blobs are bound to the calling TA: a blob can only be
+ * decapsulated by the TA which encapsulated it.
+ */
+
+#ifndef __PTA_BLOB_H
+#define __PTA_BLOB_H
+
+#define PTA_BLOB_UUID { 0x2dfa1869, 0x7337, 0x411d, \
+		{ 0x8c, 0xc8, 0xa9, 0xb8, 0x1a, 0x8f, 0x26, 0xe0 } }
+
+/*
+ * Encapsulate a batch of payloads of the same size
+ *
+ * [in]     memref[0]        Payloads, value[2].a elements of the same size
+ * [out]    memref[1]        Blobs, element n at offset
+ *                           n * memref[1].size / value[2].a
+ * [in/out] value[2].a       Number of elements
+ *          value[2].b       [out] Size of a blob
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_SHORT_BUFFER - Output buffer size less than required
+ */
+#define PTA_BLOB_CMD_ENCAPS		0
+
+/*
+ * Decapsulate a batch of blobs of the same size
+ *
+ * [in]     memref[0]        Blobs, value[2].a elements of the same size
+ * [out]    memref[1]        Payloads, element n at offset
+ *                           n * memref[1].size / value[2].a
+ * [in/out] value[2].a       Number of elements
+ *          value[2].b       [out] Size of a payload
+ *
+ * Return codes:
+ * TEE_SUCCESS - Invoke command success
+ * TEE_ERROR_BAD_PARAMETERS - Incorrect input param
+ * TEE_ERROR_SHORT_BUFFER - Output buffer size less than required
+ * TEE_ERROR_MAC_INVALID - A blob isn't authentic
+ */
+#define PTA_BLOB_CMD_DECAPS		1
+
+#endif /* __PTA_BLOB_H */
@@ -103,5 +103,143 @@
  */
 #define PTA_INVOKE_TESTS_CMD_MEMREF_NULL	10
 
+/* Algorithm value selecting the random number generator */
+#define PTA_INVOKE_TESTS_CRYPTO_PERF_RNG	0
+
+/*
+ * Crypto performance tests, measures the time taken by repetition count
+ * operations on the whole buffer using the core crypto API. Digest, MAC,
+ * cipher and authenticated encryption algorithms process the buffer in
+ * updates of unit size bytes, ciphers encrypt in place. Signature
+ * algorithms sign the first 32 bytes of the buffer and store the
+ * signature after them, key generation isn't measured.
+ *
+ * [in]     value[0].a	TEE_ALG_* or PTA_INVOKE_TESTS_CRYPTO_PERF_RNG
+ * [in]     value[0].b	Key size in bits, 0 if not applicable
+ * [in]     value[1].a	repetition count
+ * [in]     value[1].b	unit size
+ * [in/out] memref[2]	Data buffer
+ * [out]    value[3].a	Elapsed time in milliseconds
+ */
+#define PTA_INVOKE_TESTS_CMD_CRYPTO_PERF	11
+
+/* Sort functions measured by PTA_INVOKE_TESTS_CMD_SORT_PERF */
+#define PTA_INVOKE_TESTS_SORT_QSORT		0
+#define PTA_INVOKE_TESTS_SORT_MERGESORT		1
+
+/* Initial order of the elements sorted by PTA_INVOKE_TESTS_CMD_SORT_PERF */
+#define PTA_INVOKE_TESTS_SORT_RANDOM		0
+#define PTA_INVOKE_TESTS_SORT_SORTED		1
+#define PTA_INVOKE_TESTS_SORT_REVERSED		2
+#define PTA_INVOKE_TESTS_SORT_ORGAN_PIPE	3
+#define PTA_INVOKE_TESTS_SORT_EQUAL		4
+
+/*
+ * Sort performance tests, measures the time taken to sort an array of
+ * 32-bit unsigned integers repetition count times, the array being
+ * initialized before each sort.
+ *
+ * [in]     value[0].a	Number of elements
+ * [in]     value[0].b	PTA_INVOKE_TESTS_SORT_{RANDOM,SORTED,...}
+ * [in]     value[1].a	PTA_INVOKE_TESTS_SORT_{QSORT,MERGESORT}
+ * [in]     value[1].b	repetition count
+ * [out]    value[2].a	Elapsed time in milliseconds
+ * [out]    value[2].b	Number of comparisons of one sort
+ */
+#define PTA_INVOKE_TESTS_CMD_SORT_PERF		12
+
+/* Operations measured by PTA_INVOKE_TESTS_CMD_LATENCY */
+#define PTA_INVOKE_TESTS_LATENCY_NULL		0
+#define PTA_INVOKE_TESTS_LATENCY_MALLOC		1
+#define PTA_INVOKE_TESTS_LATENCY_MUTEX		2
+#define PTA_INVOKE_TESTS_LATENCY_SYS_TIME	3
+#define PTA_INVOKE_TESTS_LATENCY_RPC		4
+
+/*
+ * Latency tests, measures each of repetition count calls of an operation
+ * in counter ticks. PTA_INVOKE_TESTS_LATENCY_NULL measures the cost of
+ * the measurement itself, PTA_INVOKE_TESTS_LATENCY_MALLOC a malloc() and
+ * free() of value[0].b bytes, PTA_INVOKE_TESTS_LATENCY_MUTEX locking and
+ * unlocking an uncontended mutex, PTA_INVOKE_TESTS_LATENCY_SYS_TIME
+ * reading the system time and PTA_INVOKE_TESTS_LATENCY_RPC an RPC round
+ * trip to normal world reading the REE time.
+ *
+ * The latency of the invocation itself, with or without memory
+ * references, is measured by the client with PTA_INVOKE_TESTS_CMD_PARAMS.
+ *
+ * [in]     value[0].a	PTA_INVOKE_TESTS_LATENCY_*
+ * [in]     value[0].b	Size in bytes, PTA_INVOKE_TESTS_LATENCY_MALLOC only
+ * [in/out] value[1].a	repetition count
+ * [in/out] value[1].b	Counter frequency in Hz, output only
+ * [out]    value[2].a	Minimum
+ * [out]    value[2].b	Mean
+ * [out]    value[3].a	99th percentile
+ * [out]    value[3].b	Maximum
+ */
+#define PTA_INVOKE_TESTS_CMD_LATENCY		13
+
+/* Access patterns measured by PTA_INVOKE_TESTS_CMD_FS_PERF */
+#define PTA_INVOKE_TESTS_FS_PERF_SEQ_WRITE	0
+#define PTA_INVOKE_TESTS_FS_PERF_SEQ_READ	1
+#define PTA_INVOKE_TESTS_FS_PERF_RAND_WRITE	2
+#define PTA_INVOKE_TESTS_FS_PERF_RAND_READ	3
+#define PTA_INVOKE_TESTS_FS_PERF_APPEND		4
+
+/* Flags of PTA_INVOKE_TESTS_CMD_FS_PERF */
+#define PTA_INVOKE_TESTS_FS_PERF_STAGED		0x1
+
+/*
+ * Secure storage performance tests, measures the time taken to access an
+ * object of the given size in chunks through the file operations of a
+ * storage backend. The object is created, and filled with data for all
+ * patterns but APPEND, before the measurement starts and is removed
+ * afterwards. APPEND extends an empty object chunk by chunk, the other
+ * patterns overwrite or read it. With PTA_INVOKE_TESTS_FS_PERF_STAGED
+ * the writes are staged and committed once, which is included in the
+ * measurement, if the backend supports it.
+ *
+ * [in]     value[0].a	TEE_STORAGE_PRIVATE_{REE,RPMB}
+ * [in]     value[0].b	PTA_INVOKE_TESTS_FS_PERF_{SEQ_WRITE,SEQ_READ,...}
+ * [in]     value[1].a	Object size in bytes
+ * [in]     value[1].b	Chunk size in bytes
+ * [in]     value[2].a	PTA_INVOKE_TESTS_FS_PERF_* flags
+ * [out]    value[3].a	Elapsed time in milliseconds
+ * [out]    value[3].b	Number of chunks accessed
+ */
+#define PTA_INVOKE_TESTS_CMD_FS_PERF		14
+
+/* Paged regions used by PTA_INVOKE_TESTS_CMD_PAGER_PERF */
+#define PTA_INVOKE_TESTS_PAGER_PERF_RW		0
+#define PTA_INVOKE_TESTS_PAGER_PERF_LOCKED	1
+
+/* Access patterns of PTA_INVOKE_TESTS_CMD_PAGER_PERF */
+#define PTA_INVOKE_TESTS_PAGER_PERF_SEQ		0
+#define PTA_INVOKE_TESTS_PAGER_PERF_RANDOM	1
+#define PTA_INVOKE_TESTS_PAGER_PERF_WORKING_SET	2
+
+/*
+ * Pager performance tests, touches one word in a page of a paged core
+ * region for each of access count accesses, the page being selected by
+ * the access pattern. With PTA_INVOKE_TESTS_PAGER_PERF_WORKING_SET nine
+ * accesses of ten are to a random page of the working set at the start
+ * of the region and the remaining ones to a random page of the region.
+ *
+ * A region of each type is allocated the first time it's used and can't
+ * be freed, so the size passed then is the maximum for later tests. The
+ * physical pages of a locked region are released before each test. The
+ * fault statistics require CFG_WITH_STATS, they are reset by the test.
+ *
+ * [in]     value[0].a	PTA_INVOKE_TESTS_PAGER_PERF_{RW,LOCKED}
+ * [in]     value[0].b	PTA_INVOKE_TESTS_PAGER_PERF_{SEQ,RANDOM,WORKING_SET}
+ * [in]     value[1].a	Region size in pages
+ * [in]     value[1].b	access count
+ * [in/out] value[2].a	Working set size in pages, elapsed time in
+ *			microseconds on output
+ * [in/out] value[2].b	Number of page faults, output only
+ * [out]    value[3].a	Time spent handling page faults in microseconds
+ * [out]    value[3].b	Number of evicted pages
+ */
+#define PTA_INVOKE_TESTS_CMD_PAGER_PERF		15
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __PTA_PMU_PROFILER_H
+#define __PTA_PMU_PROFILER_H
+
+#include <stdint.h>
+
+/*
+ * Interface to the PMU profiler pseudo-TA, which samples the secure world
+ * program counter each time a PMU event counter overflows
+ */
+
+#define PTA_PMU_PROFILER_UUID \
+		{ 0x3d4f2a56, 0x9c1e, 0x4b8d, \
+		{ 0xa6, 0x0b, 0x5e, 0x27, 0xc3, 0x91, 0x48, 0xf2 } }
+
+/* Some ARMv8 common architectural and microarchitectural events */
+#define PMU_PROF_EVT_L1D_CACHE_REFILL	0x03
+#define PMU_PROF_EVT_BR_MIS_PRED	0x10
+#define PMU_PROF_EVT_CPU_CYCLES		0x11
+#define PMU_PROF_EVT_LL_CACHE_MISS_RD	0x37
+
+/* Number of callers recorded in a sample */
+#define PMU_PROF_CALLCHAIN_DEPTH	6
+
+/* The sample was taken in user mode (TA) */
+#define PMU_PROF_SAMPLE_USER		0x1
+
+/*
+ * struct pmu_prof_sample - a sample of the interrupted secure world code
+ * @pc:		Program counter
+ * @callchain:	Return addresses of the callers, most recent first (TEE
+ *		core samples only)
+ * @uuid:	UUID of the TA of the current session, if any, in octet
+ *		string format
+ * @core:	Position of the core in the system
+ * @flags:	PMU_PROF_SAMPLE_*
+ * @depth:	Number of valid entries in @callchain
+ */
+struct pmu_prof_sample {
+	uint64_t pc;
+	uint64_t callchain[PMU_PROF_CALLCHAIN_DEPTH];
+	uint8_t uuid[16];
+	uint32_t core;
+	uint32_t flags;
+	uint32_t depth;
+	uint32_t reserved;
+};
+
+/*
+ * Start sampling, on each core sampling starts at the next call from
+ * normal world
+ *
+ * [in]		value[0].a	PMU event number, PMU_PROF_EVT_* or another
+ *				event supported by the cores
+ * [in]		value[0].b	Number of events between two samples
+ *
+ * Return codes:
+ * TEE_SUCCESS
+ * TEE_ERROR_BAD_PARAMETERS	Invalid event or period
+ * TEE_ERROR_NOT_SUPPORTED	The cores have no PMU event counter
+ */
+#define PTA_PMU_PROFILER_CMD_START	0
+
+/*
+ * Stop sampling, each core stops at its next call from normal world, the
+ * samples already taken can still be read
+ */
+#define PTA_PMU_PROFILER_CMD_STOP	1
+
+/*
+ * Read and remove samples
+ *
+ * [out]	memref[0]	Array of struct pmu_prof_sample
+ * [out]	value[1].a	Number of samples read
+ * [out]	value[1].b	Number of samples dropped since the last read
+ *				because the buffer of a core was full
+ * [out]	value[2].a	TEE core load address, bits [63:32]
+ * [out]	value[2].b	TEE core load address, bits [31:0]
+ */
+#define PTA_PMU_PROFILER_CMD_READ	2
+
+#endif /* __PTA_PMU_PROFILER_H */
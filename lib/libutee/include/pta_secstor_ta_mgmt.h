@@ -14,6 +14,17 @@
  */
 #define PTA_SECSTOR_TA_MGMT_BOOTSTRAP	0
 
+/*
+ * Bootstrap several Trusted Applications or Secure Domains into secure
+ * storage, with a single update of the TA database. Either all or none
+ * are installed.
+ *
+ * [in]		memref[0]: sequence of entries, each a 32-bit size in the
+ *			   byte order of the CPU followed by a signed binary
+ *			   of that size, padded to a multiple of 4 bytes
+ */
+#define PTA_SECSTOR_TA_MGMT_BOOTSTRAP_MULTI	1
+
 #define PTA_SECSTOR_TA_MGMT_UUID { 0x6e256cba, 0xfc4d, 0x4941, { \
 				   0xad, 0x09, 0x2c, 0xa1, 0x86, 0x03, 0x42, \
 				   0xdd } }
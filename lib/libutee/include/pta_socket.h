@@ -6,6 +6,8 @@
 #ifndef __PTA_SOCKET
 #define __PTA_SOCKET
 
+#include <stdint.h>
+
 #define PTA_SOCKET_UUID { 0x3b996a7d, 0x2c2b, 0x4a49, { \
 			  0xa8, 0x96, 0xe1, 0xfb, 0x57, 0x66, 0xd2, 0xf4 } }
 
@@ -48,4 +50,36 @@
  */
 #define PTA_SOCKET_IOCTL	5
 
+/*
+ * Send several records, in order and up to the first one which can't be
+ * transmitted completely. Each record is a datagram on a UDP socket.
+ *
+ * [in]		value[0].a	socket handle
+ * [in]		value[0].b	timeout ms or TEE_TIMEOUT_INFINITE
+ * [in]		memref[1]	records to transmit, one after the other
+ * [in]		memref[2]	array of uint32_t, length of each record
+ * [out]	value[3].a	number of transmitted records
+ * [out]	value[3].b	number of transmitted bytes
+ */
+#define PTA_SOCKET_SENDV	6
+
+#define PTA_SOCKET_POLL_IN	0x1
+#define PTA_SOCKET_POLL_OUT	0x2
+#define PTA_SOCKET_POLL_ERR	0x4
+
+struct pta_socket_pollfd {
+	uint32_t handle;
+	uint32_t events;	/* PTA_SOCKET_POLL_* */
+	uint32_t revents;	/* PTA_SOCKET_POLL_* */
+};
+
+/*
+ * Wait for sockets to be ready
+ *
+ * [in]		value[0].a	timeout ms or TEE_TIMEOUT_INFINITE
+ * [in/out]	memref[1]	array of struct pta_socket_pollfd
+ * [out]	value[2].a	number of sockets with revents set
+ */
+#define PTA_SOCKET_POLL		7
+
 #endif /*__PTA_SOCKET*/
@@ -55,12 +55,15 @@
 #define PTA_SYSTEM_MAP_FLAG_WRITEABLE	BIT32(1)
 /* Executable memory */
 #define PTA_SYSTEM_MAP_FLAG_EXECUTABLE	BIT32(2)
+/* Large memory is preferably mapped with translation blocks */
+#define PTA_SYSTEM_MAP_FLAG_BLOCK_MAPPED	BIT32(3)
 
 /*
  * Map zero initialized memory
  *
  * [in]	    value[0].a: Number of bytes
- * [in]	    value[0].b: Flags, 0 or PTA_SYSTEM_MAP_FLAG_SHAREABLE
+ * [in]	    value[0].b: Flags, 0 or PTA_SYSTEM_MAP_FLAG_SHAREABLE and/or
+ *			PTA_SYSTEM_MAP_FLAG_BLOCK_MAPPED
  * [out]    value[1].a: Address upper 32-bits
  * [out]    value[1].b: Address lower 32-bits
  * [in]     value[2].a: Extra pad before memory range
@@ -189,4 +192,23 @@
  */
 #define PTA_SYSTEM_GET_TPM_EVENT_LOG	12
 
+/*
+ * Resolve a table of symbols in a previously loaded shared library or in
+ * the whole TA
+ *
+ * [in]     memref[0]: the UUID of the shared library, or the nil UUID to
+ *                     search the whole TA
+ * [in]     memref[1]: symbol names, each terminated by a NUL character
+ * [out]    memref[2]: array of uint64_t receiving the address of each
+ *                     symbol, or 0 if not found, one element per name
+ *
+ * The sizes of memref[1] and memref[2] together must not exceed
+ * PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE.
+ *
+ * Used by: (libdl) dlsym_table(void *handle, const char *const *symbols,
+ *			       void **ptrs, size_t count)
+ */
+#define PTA_SYSTEM_DLSYM_TABLE		13
+#define PTA_SYSTEM_DLSYM_TABLE_MAX_SIZE	2048
+
 #endif /* __PTA_SYSTEM_H */
@@ -154,4 +154,26 @@ static inline size_t
  */
 #define PTA_REMOTEPROC_VERIFY_DIGEST	8
 
+/*
+ * Load a chunk of a segment with a SHA256 hash.
+ *
+ * The chunks of a segment are loaded in order, from the one flagged
+ * PTA_REMOTEPROC_CHUNK_FIRST to the one flagged PTA_REMOTEPROC_CHUNK_LAST.
+ * The segment hash is computed as the chunks are copied in the remote
+ * processor memory and checked once the last chunk is loaded: a successful
+ * completion of this last chunk ensures the loaded segment complies with
+ * the provided hash, otherwise the segment is cleared.
+ *
+ * [in]  params[0].value.a:	Unique 32bit firmware identifier
+ * [in]  params[0].value.b:	Chunk flags PTA_REMOTEPROC_CHUNK_*
+ * [in]  params[1].memref:	Chunk data to load
+ * [in]  params[2].value.a:	32bit LSB load device chunk address
+ * [in]  params[2].value.b:	32bit MSB load device chunk address
+ * [in]  params[3].memref:	Expected hash (SHA256) of the whole segment
+ */
+#define PTA_REMOTEPROC_LOAD_SEGMENT_CHUNK_SHA256	9
+
+#define PTA_REMOTEPROC_CHUNK_FIRST	BIT32(0)
+#define PTA_REMOTEPROC_CHUNK_LAST	BIT32(1)
+
 #endif /* __REMOTEPROC_PTA_H */
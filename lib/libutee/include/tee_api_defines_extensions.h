@@ -56,6 +56,15 @@
 #define TEE_ATTR_PBKDF2_ITERATION_COUNT     0xF00003C2
 #define TEE_ATTR_PBKDF2_DKM_LENGTH          0xF00004C2
 
+/*
+ * ChaCha20-Poly1305 authenticated encryption
+ * RFC 8439 https://www.rfc-editor.org/rfc/rfc8439.txt
+ */
+
+#define TEE_ALG_CHACHA20_POLY1305	0x400000C3
+
+#define TEE_TYPE_CHACHA20		0xA00000C3
+
 /*
  * PKCS#1 v1.5 RSASSA pre-hashed sign/verify
  */
@@ -73,6 +82,26 @@
 /* Was TEE_STORAGE_PRIVATE_SQL, which isn't supported any longer */
 #define TEE_STORAGE_PRIVATE_SQL_RESERVED  0x80000200
 
+/*
+ * Extension of "Data Flag Constants"
+ *
+ * TEE_DATA_FLAG_WRITE_BEHIND : writes to the object through the handle
+ * return once in the secure block cache and are staged as in a storage
+ * transaction. They are committed when the handle is closed or when
+ * TEE_CommitStorageTransaction() is called, so they can be lost but an
+ * object never ends up partly written.
+ */
+#define TEE_DATA_FLAG_WRITE_BEHIND	0x00001000
+
+/*
+ * TEE_DATA_FLAG_COMPRESS : data blocks written to the object through the
+ * handle are compressed before they are encrypted, if the storage supports
+ * it (REE FS with CFG_REE_FS_COMPRESS=y). Compressed data is read back
+ * transparently with or without the flag. If the object is already open
+ * the flags it was first opened with apply.
+ */
+#define TEE_DATA_FLAG_COMPRESS		0x00002000
+
 /*
  * Extension of "Memory Access Rights Constants"
  * #define TEE_MEMORY_ACCESS_READ             0x00000001
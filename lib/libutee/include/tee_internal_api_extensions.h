@@ -16,6 +16,13 @@ void tee_user_mem_mark_heap(void);
 size_t tee_user_mem_check_heap(void);
 /* Hint implementation defines */
 #define TEE_USER_MEM_HINT_NO_FILL_ZERO       0x80000000
+/*
+ * May be combined with the other hints, the buffer is released when the
+ * TA returns from the current entry point. Such a buffer must only be
+ * passed to TEE_Realloc() and TEE_Free() and not be used after the entry
+ * point returned.
+ */
+#define TEE_USER_MEM_HINT_TEMPORARY          0x40000000
 
 /*
  * Cache maintenance support (TA requires the CACHE_MAINTENANCE property)
@@ -62,4 +69,149 @@ TEE_Result tee_unmap(void *buf, size_t len);
  */
 TEE_Result tee_uuid_from_str(TEE_UUID *uuid, const char *s);
 
+/*
+ * struct tee_verify_item - Digest and signature verified by
+ *			    TEE_AsymmetricVerifyDigestBatch()
+ * @digest:		Digest
+ * @digest_len:		Length of @digest
+ * @signature:		Signature of @digest
+ * @signature_len:	Length of @signature
+ * @result:		Set to TEE_SUCCESS or TEE_ERROR_SIGNATURE_INVALID
+ */
+struct tee_verify_item {
+	const void *digest;
+	uint32_t digest_len;
+	const void *signature;
+	uint32_t signature_len;
+	TEE_Result result;
+};
+
+/*
+ * TEE_AsymmetricVerifyDigestBatch() - Verify several signatures with the
+ *				       key of an operation
+ * @operation:		Operation as for TEE_AsymmetricVerifyDigest()
+ * @params:		Optional operation parameters shared by all items
+ * @paramCount:		Number of parameters in @params
+ * @items:		Digests and signatures to verify
+ * @itemCount:		Number of items in @items
+ *
+ * Same as calling TEE_AsymmetricVerifyDigest() for each item, with far
+ * fewer system calls. The result of each verification is stored in the
+ * item.
+ *
+ * Returns TEE_SUCCESS if all signatures are valid or
+ * TEE_ERROR_SIGNATURE_INVALID if at least one of them isn't, panics on
+ * any other error.
+ */
+TEE_Result TEE_AsymmetricVerifyDigestBatch(TEE_OperationHandle operation,
+					   const TEE_Attribute *params,
+					   uint32_t paramCount,
+					   struct tee_verify_item *items,
+					   uint32_t itemCount);
+
+/*
+ * TEE_BeginStorageTransaction() - Start staging writes to persistent objects
+ *
+ * Until TEE_CommitStorageTransaction() is called, the data written with
+ * TEE_WriteObjectData() and TEE_TruncateObjectData() to objects in the
+ * REE FS storage is kept out of the persistent state of the objects. Other
+ * handles and TAs opening the objects see the data as it was before.
+ * Creating, renaming or deleting an object isn't part of the transaction.
+ *
+ * Closing an object with staged writes commits the transaction so far, an
+ * uncommitted transaction is discarded when the TA instance is destroyed.
+ * Objects opened with TEE_DATA_FLAG_WRITE_BEHIND are always staged.
+ *
+ * Panics if a transaction is already started.
+ */
+void TEE_BeginStorageTransaction(void);
+
+/*
+ * TEE_CommitStorageTransaction() - Commit the staged writes
+ *
+ * Makes the writes staged since TEE_BeginStorageTransaction() and those
+ * of the objects opened with TEE_DATA_FLAG_WRITE_BEHIND persistent at
+ * once: if the commit fails or is interrupted, none of the objects are
+ * updated. Headers and the directory file are written once for the whole
+ * transaction instead of once per write. Ends the transaction if one is
+ * started.
+ *
+ * Returns TEE_SUCCESS, TEE_ERROR_STORAGE_NO_SPACE,
+ * TEE_ERROR_CORRUPT_OBJECT or TEE_ERROR_STORAGE_NOT_AVAILABLE, panics on
+ * other errors. The transaction remains started when an error is
+ * returned.
+ */
+TEE_Result TEE_CommitStorageTransaction(void);
+
+/*
+ * struct tee_enum_item - Persistent object returned by
+ *			  TEE_GetNextPersistentObjects()
+ * @info:		Information of the object, valid if @result is
+ *			TEE_SUCCESS
+ * @result:		TEE_SUCCESS, TEE_ERROR_ITEM_NOT_FOUND,
+ *			TEE_ERROR_CORRUPT_OBJECT or
+ *			TEE_ERROR_STORAGE_NOT_AVAILABLE
+ * @objectIDLen:	Length of @objectID
+ * @objectID:		Identifier of the object
+ */
+struct tee_enum_item {
+	TEE_ObjectInfo info;
+	TEE_Result result;
+	uint32_t objectIDLen;
+	uint8_t objectID[TEE_OBJECT_ID_MAX_LEN];
+};
+
+/*
+ * TEE_GetNextPersistentObjects() - Get the next objects of an enumeration
+ * @objectEnumerator:	Enumerator started with
+ *			TEE_StartPersistentObjectEnumerator()
+ * @items:		Array receiving the objects
+ * @itemCount:		[in] Number of elements in @items,
+ *			[out] Number of objects returned
+ *
+ * Same as calling TEE_GetNextPersistentObject() up to @itemCount times
+ * with one system call for up to 16 objects. An object which can't be
+ * read is returned with its error in the result field of its item
+ * instead of ending the enumeration.
+ *
+ * Returns TEE_SUCCESS if at least one object is returned,
+ * TEE_ERROR_ITEM_NOT_FOUND if there are none left or
+ * TEE_ERROR_STORAGE_NOT_AVAILABLE, panics on other errors.
+ */
+TEE_Result TEE_GetNextPersistentObjects(TEE_ObjectEnumHandle objectEnumerator,
+					struct tee_enum_item *items,
+					uint32_t *itemCount);
+
+/*
+ * struct tee_populate_item - Transient object populated by
+ *			      TEE_PopulateTransientObjects()
+ * @object:		Uninitialized transient object
+ * @attrs:		Attributes of the object
+ * @attrCount:		Number of attributes in @attrs
+ * @result:		TEE_SUCCESS or TEE_ERROR_BAD_PARAMETERS
+ */
+struct tee_populate_item {
+	TEE_ObjectHandle object;
+	const TEE_Attribute *attrs;
+	uint32_t attrCount;
+	TEE_Result result;
+};
+
+/*
+ * TEE_PopulateTransientObjects() - Populate several transient objects
+ * @items:		Objects and their attributes
+ * @itemCount:		Number of items in @items
+ *
+ * Same as calling TEE_PopulateTransientObject() for each item with one
+ * system call for up to 16 objects. The result of each populate is stored
+ * in the item, an object which isn't an uninitialized transient object is
+ * reported with TEE_ERROR_BAD_PARAMETERS instead of a panic.
+ *
+ * Returns TEE_SUCCESS if all objects are populated or
+ * TEE_ERROR_BAD_PARAMETERS if at least one of them isn't, panics on any
+ * other error.
+ */
+TEE_Result TEE_PopulateTransientObjects(struct tee_populate_item *items,
+					uint32_t itemCount);
+
 #endif
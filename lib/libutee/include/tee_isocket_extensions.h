@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#ifndef __TEE_ISOCKET_EXTENSIONS_H
+#define __TEE_ISOCKET_EXTENSIONS_H
+
+#include <stdint.h>
+#include <tee_api_types.h>
+#include <tee_isocket.h>
+
+/*
+ * Extensions of the TEE_tcpSocket and TEE_udpSocket instances, not part
+ * of the GlobalPlatform Sockets API
+ */
+
+/* Record sent by TEE_iSocketSendv() */
+struct tee_isocket_iovec {
+	const void *buf;
+	uint32_t len;
+};
+
+/*
+ * TEE_iSocketSendv() - Send several records with one request
+ * @ctx:	Socket opened with TEE_tcpSocket or TEE_udpSocket
+ * @iov:	Records to send, one datagram each on a UDP socket
+ * @iovcnt:	[in] Number of records in @iov,
+ *		[out] Number of records transmitted completely
+ * @timeout:	Timeout in ms or TEE_TIMEOUT_INFINITE
+ *
+ * Same as calling the send() function of the socket for each record in
+ * order, stopping at the first one which isn't transmitted completely.
+ * Returns the same errors as send().
+ */
+TEE_Result TEE_iSocketSendv(TEE_iSocketHandle ctx,
+			    const struct tee_isocket_iovec *iov,
+			    uint32_t *iovcnt, uint32_t timeout);
+
+#define TEE_ISOCKET_POLL_IN	0x1	/* Data can be received */
+#define TEE_ISOCKET_POLL_OUT	0x2	/* Data can be sent */
+#define TEE_ISOCKET_POLL_ERR	0x4	/* Error, revents only */
+
+/* Socket waited for by TEE_iSocketPoll() */
+struct tee_isocket_pollfd {
+	TEE_iSocketHandle ctx;
+	uint32_t events;	/* TEE_ISOCKET_POLL_* to wait for */
+	uint32_t revents;	/* TEE_ISOCKET_POLL_* ready */
+};
+
+/*
+ * TEE_iSocketPoll() - Wait for sockets to be ready
+ * @fds:	Sockets and events to wait for
+ * @nfds:	Number of elements in @fds
+ * @nready:	Number of sockets with revents set
+ * @timeout:	Timeout in ms, TEE_TIMEOUT_INFINITE or 0 not to wait
+ *
+ * Returns TEE_SUCCESS, also if the timeout expired with @nready set to 0,
+ * or TEE_ISOCKET_ERROR_* on failure.
+ */
+TEE_Result TEE_iSocketPoll(struct tee_isocket_pollfd *fds, uint32_t nfds,
+			   uint32_t *nready, uint32_t timeout);
+
+#endif /*__TEE_ISOCKET_EXTENSIONS_H*/
@@ -79,8 +79,17 @@
 #define TEE_SCN_SE_CHANNEL_CLOSE__DEPRECATED		69
 /* End of deprecated Secure Element API syscalls */
 #define TEE_SCN_CACHE_OPERATION			70
+#define TEE_SCN_CIPHER_UPDATE_VEC		71
+#define TEE_SCN_AUTHENC_UPDATE_PAYLOAD_VEC	72
+#define TEE_SCN_ASYMM_VERIFY_BATCH		73
+#define TEE_SCN_STORAGE_TX_BEGIN		74
+#define TEE_SCN_STORAGE_TX_COMMIT		75
+#define TEE_SCN_STORAGE_ENUM_NEXT_BATCH		76
+#define TEE_SCN_CRYP_OBJ_POPULATE_BATCH		77
+#define TEE_SCN_GET_TIME_PAGE			78
+#define TEE_SCN_GET_PROPERTY_SET		79
 
-#define TEE_SCN_MAX				70
+#define TEE_SCN_MAX				79
 
 /* Maximum number of allowed arguments for a syscall */
 #define TEE_SVC_MAX_ARGS			8
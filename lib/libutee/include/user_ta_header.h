@@ -31,8 +31,22 @@
 	 */
 #define TA_FLAG_DEVICE_ENUM		(1 << 9)  /* without tee-supplicant */
 #define TA_FLAG_DEVICE_ENUM_SUPP	(1 << 10) /* with tee-supplicant */
+	/*
+	 * Idle instances of a multi-instance TA may be kept and reused for
+	 * a later session, see CFG_TA_INSTANCE_POOL_SIZE. Such a TA must
+	 * not leave any session specific state behind when a session is
+	 * closed. TA_CreateEntryPoint() is only called for the first
+	 * session of an instance and TA_DestroyEntryPoint() isn't called.
+	 */
+#define TA_FLAG_INSTANCE_POOL		(1 << 11)
+	/*
+	 * Memref parameters are mapped at the first access instead of
+	 * before each entry, which saves time for a TA that only looks at
+	 * some of the buffers it's passed.
+	 */
+#define TA_FLAG_LAZY_PARAM_MAP		(1 << 12)
 
-#define TA_FLAGS_MASK			GENMASK_32(10, 0)
+#define TA_FLAGS_MASK			GENMASK_32(12, 0)
 
 struct ta_head {
 	TEE_UUID uuid;
@@ -70,8 +84,24 @@ struct ftrace_buf {
 	uint32_t buf_off;	/* Ftrace buffer offset */
 	bool syscall_trace_enabled; /* Some syscalls are never traced */
 	bool syscall_trace_suspended; /* By foreign interrupt or RPC */
+	bool rec_wrapped;	/* Binary records have wrapped around */
 };
 
+/*
+ * Binary function trace record used with CFG_FTRACE_BUF_FORMAT=binary
+ * @ts:	Counter value in bits [55:0], call depth in bits [62:56] and bit 63
+ *	set for a function return
+ * @pc:	Address of the function entered, 0 for a function return
+ */
+struct ftrace_rec {
+	uint64_t ts;
+	uint64_t pc;
+};
+
+#define FTRACE_REC_TS_MASK		0x00ffffffffffffffULL
+#define FTRACE_REC_DEPTH_SHIFT		56
+#define FTRACE_REC_RETURN		0x8000000000000000ULL
+
 /* Defined by the linker script */
 extern struct ftrace_buf __ftrace_buf_start;
 extern uint8_t __ftrace_buf_end[];
@@ -115,6 +145,8 @@ extern struct __elf_phdr_info __elf_phdr_info;
 #define TA_PROP_STR_STACK_SIZE		"gpd.ta.stackSize"
 #define TA_PROP_STR_VERSION		"gpd.ta.version"
 #define TA_PROP_STR_DESCRIPTION		"gpd.ta.description"
+/* Small buffers are cached by size class, see CFG_TA_MALLOC_MAGAZINE_SIZE */
+#define TA_PROP_STR_MALLOC_SIZE_CLASSES	"optee.ta.mallocSizeClasses"
 
 enum user_ta_prop_type {
 	USER_TA_PROP_TYPE_BOOL,	/* bool */
@@ -46,6 +46,13 @@ TEE_Result _utee_get_property_name_to_index(unsigned long prop_set,
 					    unsigned long name_len,
 					    uint32_t *index);
 
+/*
+ * Returns all the properties of prop_set known by the kernel as struct
+ * utee_prop_rec records in buf
+ */
+TEE_Result _utee_get_property_set(unsigned long prop_set, void *buf,
+				  uint32_t *blen);
+
 /* sess has type TEE_TASessionHandle */
 TEE_Result _utee_open_ta_session(const TEE_UUID *dest,
 				 unsigned long cancel_req_to,
@@ -79,6 +86,9 @@ TEE_Result _utee_wait(unsigned long timeout);
 /* cat has type enum _utee_time_category */
 TEE_Result _utee_get_time(unsigned long cat, TEE_Time *time);
 
+/* Maps the struct utee_time_page, @va receives its address */
+TEE_Result _utee_get_time_page(uint64_t *va);
+
 TEE_Result _utee_set_ta_time(const TEE_Time *time);
 
 TEE_Result _utee_cryp_state_alloc(unsigned long algo, unsigned long op_mode,
@@ -100,6 +110,14 @@ TEE_Result _utee_cipher_update(unsigned long state, const void *src,
 			       size_t src_len, void *dest, uint64_t *dest_len);
 TEE_Result _utee_cipher_final(unsigned long state, const void *src,
 			      size_t src_len, void *dest, uint64_t *dest_len);
+/*
+ * Same as _utee_cipher_update() with the concatenation of the @iov_cnt
+ * buffers in @iov as input, each buffer has to be a valid update input.
+ */
+TEE_Result _utee_cipher_update_vec(unsigned long state,
+				   const struct utee_iovec *iov,
+				   size_t iov_cnt, void *dest,
+				   uint64_t *dest_len);
 
 /* Generic Object Functions */
 TEE_Result _utee_cryp_obj_get_info(unsigned long obj, TEE_ObjectInfo *info);
@@ -117,6 +135,13 @@ TEE_Result _utee_cryp_obj_reset(unsigned long obj);
 TEE_Result _utee_cryp_obj_populate(unsigned long obj,
 				   struct utee_attribute *attrs,
 				   unsigned long attr_count);
+/*
+ * Same as _utee_cryp_obj_populate() for each of the @num_items objects in
+ * @items, at most UTEE_POPULATE_BATCH_MAX_CNT. The result of each populate
+ * is returned in the result field of the item.
+ */
+TEE_Result _utee_cryp_obj_populate_batch(struct utee_populate_item *items,
+					 size_t num_items);
 TEE_Result _utee_cryp_obj_copy(unsigned long dst_obj, unsigned long src_obj);
 
 TEE_Result _utee_cryp_obj_generate_key(unsigned long obj,
@@ -139,6 +164,14 @@ TEE_Result _utee_authenc_update_aad(unsigned long state, const void *aad_data,
 TEE_Result _utee_authenc_update_payload(unsigned long state,
 					const void *src_data, size_t src_len,
 					void *dest_data, uint64_t *dest_len);
+/*
+ * Same as _utee_authenc_update_payload() with the concatenation of the
+ * @iov_cnt buffers in @iov as input.
+ */
+TEE_Result _utee_authenc_update_payload_vec(unsigned long state,
+					    const struct utee_iovec *iov,
+					    size_t iov_cnt, void *dest_data,
+					    uint64_t *dest_len);
 TEE_Result _utee_authenc_enc_final(unsigned long state, const void *src_data,
 				   size_t src_len, void *dest_data,
 				   uint64_t *dest_len, void *tag,
@@ -158,6 +191,17 @@ TEE_Result _utee_asymm_verify(unsigned long state,
 			      const struct utee_attribute *params,
 			      unsigned long num_params, const void *data,
 			      size_t data_len, const void *sig, size_t sig_len);
+/*
+ * Same as _utee_asymm_verify() for each of the @num_items digest and
+ * signature pairs in @items, at most UTEE_VERIFY_BATCH_MAX_CNT. The result
+ * of each verification is returned in the result field of the item, the
+ * function returns TEE_ERROR_SIGNATURE_INVALID if any of them failed.
+ */
+TEE_Result _utee_asymm_verify_batch(unsigned long state,
+				    const struct utee_attribute *params,
+				    unsigned long num_params,
+				    struct utee_verify_item *items,
+				    size_t num_items);
 
 /* Persistant Object Functions */
 /* obj is of type TEE_ObjectHandle */
@@ -201,6 +245,16 @@ TEE_Result _utee_storage_start_enum(unsigned long obj_enum,
 TEE_Result _utee_storage_next_enum(unsigned long obj_enum, TEE_ObjectInfo *info,
 				   void *obj_id, uint64_t *len);
 
+/*
+ * Same as _utee_storage_next_enum() for up to @num_items objects, at most
+ * UTEE_ENUM_BATCH_MAX_CNT. The number of objects returned in @items is
+ * returned in @count, TEE_ERROR_ITEM_NOT_FOUND is returned if there are
+ * none left.
+ */
+TEE_Result _utee_storage_next_enum_batch(unsigned long obj_enum,
+					 struct utee_enum_item *items,
+					 size_t num_items, uint64_t *count);
+
 /* Data Stream Access Functions */
 /* obj is of type TEE_ObjectHandle */
 TEE_Result _utee_storage_obj_read(unsigned long obj, void *data, size_t len,
@@ -218,6 +272,12 @@ TEE_Result _utee_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result _utee_storage_obj_seek(unsigned long obj, int32_t offset,
 				  unsigned long whence);
 
+/* Stages the following data writes until _utee_storage_tx_commit() */
+TEE_Result _utee_storage_tx_begin(void);
+
+/* Commits the staged data writes at once */
+TEE_Result _utee_storage_tx_commit(void);
+
 /* seServiceHandle is of type TEE_SEServiceHandle */
 TEE_Result _utee_se_service_open(uint32_t *seServiceHandle);
 
@@ -47,4 +47,100 @@ struct utee_attribute {
 	uint32_t attribute_id;
 };
 
+/* Maximum number of buffers in a vectored update */
+#define UTEE_IOVEC_MAX_CNT	4
+
+/* Buffer of a vectored update */
+struct utee_iovec {
+	uint64_t addr;
+	uint64_t len;
+};
+
+/* Maximum number of signatures in a batched verification */
+#define UTEE_VERIFY_BATCH_MAX_CNT	16
+
+/* Digest and signature pair of a batched verification */
+struct utee_verify_item {
+	uint64_t digest;
+	uint64_t digest_len;
+	uint64_t sig;
+	uint64_t sig_len;
+	uint32_t result;	/* TEE_SUCCESS or TEE_ERROR_SIGNATURE_INVALID */
+};
+
+/* Maximum number of objects in a batched populate */
+#define UTEE_POPULATE_BATCH_MAX_CNT	16
+
+/* Transient object and its attributes in a batched populate */
+struct utee_populate_item {
+	uint64_t attrs;		/* struct utee_attribute array */
+	uint32_t obj;
+	uint32_t attr_count;
+	uint32_t result;
+};
+
+/* Maximum number of objects returned by a batched enumeration */
+#define UTEE_ENUM_BATCH_MAX_CNT		16
+
+/*
+ * Persistent object returned by a batched enumeration, the fields before
+ * @result are those of TEE_ObjectInfo and are only valid if @result is
+ * TEE_SUCCESS
+ */
+struct utee_enum_item {
+	uint32_t obj_type;
+	uint32_t obj_size;
+	uint32_t max_obj_size;
+	uint32_t obj_usage;
+	uint32_t data_size;
+	uint32_t data_position;
+	uint32_t handle_flags;
+	uint32_t result;
+	uint32_t obj_id_len;
+	uint8_t obj_id[TEE_OBJECT_ID_MAX_LEN];
+};
+
+/* The counter and @cnt_freq give the system time */
+#define UTEE_TIME_PAGE_SYS_TIME		0x1
+/* @ree_seconds and @ree_millis are valid */
+#define UTEE_TIME_PAGE_REE_TIME		0x2
+
+/*
+ * Page mapped read-only in a user TA to read time without syscalls, the
+ * time is derived from the physical counter.
+ * @seq:		Odd while the core updates the page
+ * @flags:		UTEE_TIME_PAGE_*
+ * @cnt_freq:		Frequency of the counter
+ * @ree_cnt:		Counter value when the REE time was read
+ * @ree_valid_cnt:	Counter value until which the REE time can be
+ *			derived from @ree_cnt
+ * @ree_seconds:	Seconds of the REE time read at @ree_cnt
+ * @ree_millis:		Milliseconds of the REE time read at @ree_cnt
+ */
+struct utee_time_page {
+	uint32_t seq;
+	uint32_t flags;
+	uint64_t cnt_freq;
+	uint64_t ree_cnt;
+	uint64_t ree_valid_cnt;
+	uint32_t ree_seconds;
+	uint32_t ree_millis;
+};
+
+/*
+ * Property returned by _utee_get_property_set(), followed by the name
+ * including the terminating zero and by the value. The next property
+ * starts at the next UTEE_PROP_REC_ALIGN aligned offset.
+ * @prop_type:	enum user_ta_prop_type
+ * @name_len:	Length of the name including the terminating zero
+ * @value_len:	Length of the value
+ */
+#define UTEE_PROP_REC_ALIGN	8
+
+struct utee_prop_rec {
+	uint32_t prop_type;
+	uint32_t name_len;
+	uint32_t value_len;
+};
+
 #endif /* UTEE_TYPES_H */
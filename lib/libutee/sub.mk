@@ -13,6 +13,7 @@ srcs-y += tee_api_objects.c
 srcs-y += tee_api_operations.c
 srcs-y += tee_api_panic.c
 srcs-y += tee_api_property.c
+srcs-y += tee_api_temp_pool.c
 srcs-y += tee_socket_pta.c
 srcs-y += tee_system_pta.c
 srcs-y += tee_tcpudp_socket.c
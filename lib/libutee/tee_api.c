@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#include <arm_user_sysreg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_ext.h>
@@ -9,6 +10,7 @@
 #include <tee_internal_api_extensions.h>
 #include <types_ext.h>
 #include <user_ta_header.h>
+#include <utee_defines.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -329,10 +331,92 @@ void *TEE_MemFill(void *buff, uint32_t x, uint32_t size)
 
 /* Date & Time API */
 
+static const volatile struct utee_time_page *time_page;
+static bool time_page_unavailable;
+
+/*
+ * Reads a consistent copy of the time page, returns false if the core
+ * doesn't provide one.
+ */
+static bool read_time_page(struct utee_time_page *tp)
+{
+	const volatile struct utee_time_page *p = time_page;
+	uint64_t va = 0;
+	uint32_t seq = 0;
+
+	if (!p) {
+		if (time_page_unavailable)
+			return false;
+		if (_utee_get_time_page(&va)) {
+			time_page_unavailable = true;
+			return false;
+		}
+		p = (void *)(vaddr_t)va;
+		time_page = p;
+	}
+
+	do {
+		seq = p->seq;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		tp->flags = p->flags;
+		tp->cnt_freq = p->cnt_freq;
+		tp->ree_cnt = p->ree_cnt;
+		tp->ree_valid_cnt = p->ree_valid_cnt;
+		tp->ree_seconds = p->ree_seconds;
+		tp->ree_millis = p->ree_millis;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1) || seq != p->seq);
+
+	return true;
+}
+
+static bool get_sys_time_from_page(TEE_Time *time)
+{
+	struct utee_time_page tp = { };
+	uint64_t cnt = 0;
+
+	if (!read_time_page(&tp) || !(tp.flags & UTEE_TIME_PAGE_SYS_TIME))
+		return false;
+
+	/* Same computation as the core does */
+	cnt = barrier_read_cntpct();
+	time->seconds = cnt / tp.cnt_freq;
+	time->millis = (cnt % tp.cnt_freq) /
+		       (tp.cnt_freq / TEE_TIME_MILLIS_BASE);
+
+	return true;
+}
+
+static bool get_ree_time_from_page(TEE_Time *time)
+{
+	struct utee_time_page tp = { };
+	uint64_t cnt = 0;
+	uint64_t ms = 0;
+
+	if (!read_time_page(&tp) || !(tp.flags & UTEE_TIME_PAGE_REE_TIME))
+		return false;
+
+	/* Once too old the REE time is read again by the core */
+	cnt = barrier_read_cntpct();
+	if (cnt < tp.ree_cnt || cnt >= tp.ree_valid_cnt)
+		return false;
+
+	ms = (cnt - tp.ree_cnt) * TEE_TIME_MILLIS_BASE / tp.cnt_freq +
+	     tp.ree_millis;
+	time->seconds = tp.ree_seconds + ms / TEE_TIME_MILLIS_BASE;
+	time->millis = ms % TEE_TIME_MILLIS_BASE;
+
+	return true;
+}
+
 void TEE_GetSystemTime(TEE_Time *time)
 {
-	TEE_Result res = _utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (get_sys_time_from_page(time))
+		return;
 
+	res = _utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
@@ -384,18 +468,30 @@ TEE_Result TEE_SetTAPersistentTime(const TEE_Time *time)
 
 void TEE_GetREETime(TEE_Time *time)
 {
-	TEE_Result res = _utee_get_time(UTEE_TIME_CAT_REE, time);
+	TEE_Result res = TEE_ERROR_GENERIC;
 
+	if (get_ree_time_from_page(time))
+		return;
+
+	res = _utee_get_time(UTEE_TIME_CAT_REE, time);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
 
 void *TEE_Malloc(uint32_t len, uint32_t hint)
 {
-	if (hint == TEE_MALLOC_FILL_ZERO)
+	bool temp = hint & TEE_USER_MEM_HINT_TEMPORARY;
+
+	hint &= ~TEE_USER_MEM_HINT_TEMPORARY;
+	if (hint == TEE_MALLOC_FILL_ZERO) {
+		if (temp)
+			return __utee_temp_alloc(len, true);
 		return calloc(1, len);
-	else if (hint == TEE_USER_MEM_HINT_NO_FILL_ZERO)
+	} else if (hint == TEE_USER_MEM_HINT_NO_FILL_ZERO) {
+		if (temp)
+			return __utee_temp_alloc(len, false);
 		return malloc(len);
+	}
 
 	EMSG("Invalid hint %#" PRIx32, hint);
 
@@ -404,12 +500,18 @@ void *TEE_Malloc(uint32_t len, uint32_t hint)
 
 void *TEE_Realloc(void *buffer, uint32_t newSize)
 {
+	void *p = NULL;
+
+	if (__utee_temp_realloc(buffer, newSize, &p))
+		return p;
+
 	return realloc(buffer, newSize);
 }
 
 void TEE_Free(void *buffer)
 {
-	free(buffer);
+	if (!__utee_temp_free(buffer))
+		free(buffer);
 }
 
 /* Cache maintenance support (TA requires the CACHE_MAINTENANCE property) */
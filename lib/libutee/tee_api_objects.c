@@ -2,11 +2,15 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <tee_api.h>
+#include <tee_internal_api_extensions.h>
 #include <utee_syscalls.h>
+#include <util.h>
+
 #include "tee_api_private.h"
 
 #define TEE_USAGE_DEFAULT   0xffffffff
@@ -292,6 +296,72 @@ TEE_Result TEE_PopulateTransientObject(TEE_ObjectHandle object,
 	return res;
 }
 
+TEE_Result TEE_PopulateTransientObjects(struct tee_populate_item *items,
+					uint32_t itemCount)
+{
+	struct utee_populate_item ui[UTEE_POPULATE_BATCH_MAX_CNT] = { };
+	struct utee_attribute *ua = NULL;
+	struct tee_populate_item *item = NULL;
+	TEE_Result ret = TEE_SUCCESS;
+	TEE_Result res = TEE_SUCCESS;
+	size_t attr_count = 0;
+	size_t offs = 0;
+	size_t cnt = 0;
+	size_t n = 0;
+
+	if (!items && itemCount)
+		TEE_Panic(0);
+
+	for (offs = 0; offs < itemCount; offs += cnt) {
+		cnt = MIN(itemCount - offs, ARRAY_SIZE(ui));
+
+		attr_count = 0;
+		for (n = 0; n < cnt; n++) {
+			item = items + offs + n;
+			__utee_check_attr_in_annotation(item->attrs,
+							item->attrCount);
+			if (ADD_OVERFLOW(attr_count, item->attrCount,
+					 &attr_count))
+				TEE_Panic(0);
+		}
+
+		/* One array holds the attributes of all objects of the chunk */
+		if (MUL_OVERFLOW(attr_count, sizeof(*ua), &attr_count))
+			TEE_Panic(0);
+		ua = TEE_Malloc(attr_count, TEE_MALLOC_FILL_ZERO);
+		if (!ua && attr_count)
+			TEE_Panic(TEE_ERROR_OUT_OF_MEMORY);
+
+		attr_count = 0;
+		for (n = 0; n < cnt; n++) {
+			item = items + offs + n;
+			__utee_from_attr(ua + attr_count, item->attrs,
+					 item->attrCount);
+			ui[n].obj = (uintptr_t)item->object;
+			ui[n].attrs = (uintptr_t)(ua + attr_count);
+			ui[n].attr_count = item->attrCount;
+			attr_count += item->attrCount;
+		}
+
+		res = _utee_cryp_obj_populate_batch(ui, cnt);
+		TEE_Free(ua);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+
+		for (n = 0; n < cnt; n++) {
+			res = ui[n].result;
+			if (res != TEE_SUCCESS &&
+			    res != TEE_ERROR_BAD_PARAMETERS)
+				TEE_Panic(res);
+			if (res)
+				ret = res;
+			items[offs + n].result = res;
+		}
+	}
+
+	return ret;
+}
+
 void TEE_InitRefAttribute(TEE_Attribute *attr, uint32_t attributeID,
 			  const void *buffer, uint32_t length)
 {
@@ -628,6 +698,60 @@ out:
 	return res;
 }
 
+TEE_Result TEE_GetNextPersistentObjects(TEE_ObjectEnumHandle objectEnumerator,
+					struct tee_enum_item *items,
+					uint32_t *itemCount)
+{
+	struct tee_enum_item *item = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t count = 0;
+	uint64_t num = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	/* The system call fills in the items of the caller directly */
+	COMPILE_TIME_ASSERT(sizeof(struct tee_enum_item) ==
+			    sizeof(struct utee_enum_item));
+
+	__utee_check_inout_annotation(itemCount, sizeof(*itemCount));
+	if (MUL_OVERFLOW(*itemCount, sizeof(*items), &sz))
+		TEE_Panic(TEE_ERROR_BAD_PARAMETERS);
+	__utee_check_out_annotation(items, sz);
+
+	while (count < *itemCount) {
+		num = MIN(*itemCount - count, (uint32_t)UTEE_ENUM_BATCH_MAX_CNT);
+		res = _utee_storage_next_enum_batch((unsigned long)
+						    objectEnumerator,
+						    (void *)(items + count),
+						    num, &num);
+		if (res != TEE_SUCCESS)
+			break;
+
+		for (n = 0; n < num; n++) {
+			item = items + count + n;
+			if (item->result != TEE_SUCCESS &&
+			    item->result != TEE_ERROR_ITEM_NOT_FOUND &&
+			    item->result != TEE_ERROR_CORRUPT_OBJECT &&
+			    item->result != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+				TEE_Panic(item->result);
+		}
+		count += num;
+	}
+
+	/* The end of the enumeration isn't an error once objects are read */
+	if (res == TEE_ERROR_ITEM_NOT_FOUND && count)
+		res = TEE_SUCCESS;
+
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_ITEM_NOT_FOUND &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	*itemCount = count;
+
+	return res;
+}
+
 /* Data and Key Storage API  - Data Stream Access Functions */
 
 TEE_Result TEE_ReadObjectData(TEE_ObjectHandle object, void *buffer,
@@ -705,6 +829,27 @@ out:
 	return res;
 }
 
+void TEE_BeginStorageTransaction(void)
+{
+	TEE_Result res = _utee_storage_tx_begin();
+
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+}
+
+TEE_Result TEE_CommitStorageTransaction(void)
+{
+	TEE_Result res = _utee_storage_tx_commit();
+
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_STORAGE_NO_SPACE &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
 TEE_Result TEE_SeekObjectData(TEE_ObjectHandle object, int32_t offset,
 			      TEE_Whence whence)
 {
@@ -24,6 +24,8 @@ struct __TEE_OperationHandle {
 	size_t block_size;	/* Block size of cipher */
 	size_t buffer_offs;	/* Offset in buffer */
 	uint32_t state;		/* Handle to state in TEE Core */
+	struct utee_ce_state *ce; /* State for CFG_TA_CRYPTO_ARM_CE */
+	bool ce_active;		/* True if @ce is used instead of @state */
 };
 
 /* Cryptographic Operations API - Generic Operation Functions */
@@ -83,6 +85,8 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_ECDH_P256:
 	case TEE_ALG_SM2_PKE:
 	case TEE_ALG_SM2_DSA_SM3:
+	case TEE_ALG_ED25519:
+	case TEE_ALG_X25519:
 		if (maxKeySize != 256)
 			return TEE_ERROR_NOT_SUPPORTED;
 		break;
@@ -134,6 +138,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 		fallthrough;
 	case TEE_ALG_AES_CTR:
 	case TEE_ALG_AES_GCM:
+	case TEE_ALG_CHACHA20_POLY1305:
 		if (mode == TEE_MODE_ENCRYPT)
 			req_key_usage = TEE_USAGE_ENCRYPT;
 		else if (mode == TEE_MODE_DECRYPT)
@@ -165,6 +170,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_ECDSA_P384:
 	case TEE_ALG_ECDSA_P521:
 	case TEE_ALG_SM2_DSA_SM3:
+	case TEE_ALG_ED25519:
 		if (mode == TEE_MODE_SIGN) {
 			with_private_key = true;
 			req_key_usage = TEE_USAGE_SIGN;
@@ -209,6 +215,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_ECDH_P256:
 	case TEE_ALG_ECDH_P384:
 	case TEE_ALG_ECDH_P521:
+	case TEE_ALG_X25519:
 	case TEE_ALG_HKDF_MD5_DERIVE_KEY:
 	case TEE_ALG_HKDF_SHA1_DERIVE_KEY:
 	case TEE_ALG_HKDF_SHA224_DERIVE_KEY:
@@ -328,12 +335,19 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	/* NULL if the algorithm can't be run in user mode */
+	op->ce = __utee_ce_state_alloc(algorithm, mode);
+
 	/*
 	 * Initialize digest operations
 	 * Other multi-stage operations initialized w/ TEE_xxxInit functions
 	 * Non-applicable on asymmetric operations
 	 */
 	if (TEE_ALG_GET_CLASS(algorithm) == TEE_OPERATION_DIGEST) {
+		if (op->ce) {
+			__utee_ce_hash_init(op->ce);
+			op->ce_active = true;
+		}
 		res = _utee_hash_init(op->state, NULL, 0);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -381,6 +395,7 @@ void TEE_FreeOperation(TEE_OperationHandle operation)
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 
+	__utee_ce_state_free(operation->ce);
 	TEE_Free(operation->buffer);
 	TEE_Free(operation);
 }
@@ -501,11 +516,16 @@ void TEE_ResetOperation(TEE_OperationHandle operation)
 	operation->operationState = TEE_OPERATION_STATE_INITIAL;
 
 	if (operation->info.operationClass == TEE_OPERATION_DIGEST) {
-		res = _utee_hash_init(operation->state, NULL, 0);
-		if (res != TEE_SUCCESS)
-			TEE_Panic(res);
+		if (operation->ce_active) {
+			__utee_ce_hash_init(operation->ce);
+		} else {
+			res = _utee_hash_init(operation->state, NULL, 0);
+			if (res != TEE_SUCCESS)
+				TEE_Panic(res);
+		}
 		operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
 	} else {
+		operation->ce_active = false;
 		operation->info.handleState &= ~TEE_HANDLE_FLAG_INITIALIZED;
 	}
 }
@@ -758,6 +778,13 @@ void TEE_CopyOperation(TEE_OperationHandle dst_op, TEE_OperationHandle src_op)
 	res = _utee_cryp_state_copy(dst_op->state, src_op->state);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
+
+	if (src_op->ce_active) {
+		if (!dst_op->ce)
+			TEE_Panic(0);
+		__utee_ce_state_copy(dst_op->ce, src_op->ce);
+	}
+	dst_op->ce_active = src_op->ce_active;
 }
 
 /* Cryptographic Operations API - Message Digest Functions */
@@ -771,9 +798,13 @@ static void init_hash_operation(TEE_OperationHandle operation, const void *IV,
 	 * Note : IV and IVLen are never used in current implementation
 	 * This is why coherent values of IV and IVLen are not checked
 	 */
-	res = _utee_hash_init(operation->state, IV, IVLen);
-	if (res != TEE_SUCCESS)
-		TEE_Panic(res);
+	if (operation->ce_active) {
+		__utee_ce_hash_init(operation->ce);
+	} else {
+		res = _utee_hash_init(operation->state, IV, IVLen);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+	}
 	operation->buffer_offs = 0;
 	operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
 }
@@ -789,6 +820,11 @@ void TEE_DigestUpdate(TEE_OperationHandle operation,
 
 	operation->operationState = TEE_OPERATION_STATE_ACTIVE;
 
+	if (operation->ce_active) {
+		__utee_ce_hash_update(operation->ce, chunk, chunkSize);
+		return;
+	}
+
 	res = _utee_hash_update(operation->state, chunk, chunkSize);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
@@ -808,11 +844,24 @@ TEE_Result TEE_DigestDoFinal(TEE_OperationHandle operation, const void *chunk,
 	}
 	__utee_check_inout_annotation(hashLen, sizeof(*hashLen));
 
-	hl = *hashLen;
-	res = _utee_hash_final(operation->state, chunk, chunkLen, hash, &hl);
-	*hashLen = hl;
-	if (res != TEE_SUCCESS)
-		goto out;
+	if (operation->ce_active) {
+		if (*hashLen < operation->info.digestLength) {
+			*hashLen = operation->info.digestLength;
+			res = TEE_ERROR_SHORT_BUFFER;
+			goto out;
+		}
+		__utee_ce_hash_update(operation->ce, chunk, chunkLen);
+		__utee_ce_hash_final(operation->ce, hash);
+		*hashLen = operation->info.digestLength;
+		res = TEE_SUCCESS;
+	} else {
+		hl = *hashLen;
+		res = _utee_hash_final(operation->state, chunk, chunkLen, hash,
+				       &hl);
+		*hashLen = hl;
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
 
 	/* Reset operation state */
 	init_hash_operation(operation, NULL, 0);
@@ -829,6 +878,81 @@ out:
 
 /* Cryptographic Operations API - Symmetric Cipher Functions */
 
+/*
+ * Sets up the operation to be run in user mode, only possible if the
+ * algorithm is supported and the key is extractable anyway.
+ */
+static bool ce_cipher_init(TEE_OperationHandle op, const void *IV,
+			   uint32_t IVLen)
+{
+	uint8_t key[TEE_AES_MAX_KEY_SIZE] = { };
+	uint32_t key_len = sizeof(key);
+	TEE_ObjectInfo info = { };
+	bool ret = false;
+
+	if (!op->ce)
+		return false;
+
+	if (TEE_GetObjectInfo1(op->key1, &info) ||
+	    !(info.objectUsage & TEE_USAGE_EXTRACTABLE))
+		return false;
+	if (TEE_GetObjectBufferAttribute(op->key1, TEE_ATTR_SECRET_VALUE,
+					 key, &key_len))
+		return false;
+
+	ret = __utee_ce_cipher_init(op->ce, key, key_len, IV, IVLen);
+	memzero_explicit(key, sizeof(key));
+
+	return ret;
+}
+
+/*
+ * Runs the complete blocks of the operation buffer and @src through the
+ * user mode implementation, keeping the remaining bytes in the buffer.
+ * Returns the number of bytes written to @dst_data.
+ */
+static size_t ce_cipher_update(TEE_OperationHandle op, const void *src_data,
+			       size_t slen, void *dst_data)
+{
+	const uint8_t *src = src_data;
+	uint8_t *dst = dst_data;
+	size_t acc_dlen = 0;
+	size_t l = 0;
+
+	if (op->block_size == 1) {
+		__utee_ce_cipher_update(op->ce, src, slen, dst);
+		return slen;
+	}
+
+	if (op->buffer_offs > 0) {
+		l = MIN(slen, op->block_size - op->buffer_offs);
+		memcpy(op->buffer + op->buffer_offs, src, l);
+		op->buffer_offs += l;
+		src += l;
+		slen -= l;
+		if (op->buffer_offs < op->block_size)
+			return 0;
+		__utee_ce_cipher_update(op->ce, op->buffer, op->block_size,
+					dst);
+		dst += op->block_size;
+		acc_dlen += op->block_size;
+		op->buffer_offs = 0;
+	}
+
+	l = ROUNDDOWN(slen, op->block_size);
+	if (l) {
+		__utee_ce_cipher_update(op->ce, src, l, dst);
+		src += l;
+		slen -= l;
+		acc_dlen += l;
+	}
+
+	memcpy(op->buffer, src, slen);
+	op->buffer_offs = slen;
+
+	return acc_dlen;
+}
+
 void TEE_CipherInit(TEE_OperationHandle operation, const void *IV,
 		    uint32_t IVLen)
 {
@@ -849,18 +973,39 @@ void TEE_CipherInit(TEE_OperationHandle operation, const void *IV,
 
 	operation->operationState = TEE_OPERATION_STATE_ACTIVE;
 
-	res = _utee_cipher_init(operation->state, IV, IVLen);
-	if (res != TEE_SUCCESS)
-		TEE_Panic(res);
+	operation->ce_active = ce_cipher_init(operation, IV, IVLen);
+	if (!operation->ce_active) {
+		res = _utee_cipher_init(operation->state, IV, IVLen);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+	}
 
 	operation->buffer_offs = 0;
 	operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
 }
 
+/*
+ * Returns the number of bytes out of @slen that can be fed to the
+ * algorithm while keeping enough data in the operation buffer for the
+ * final block(s). Only called if @slen is at least @buffer_size plus
+ * @buffer_left.
+ */
+static size_t tee_buffer_feed_len(TEE_OperationHandle op, size_t slen,
+				  size_t buffer_size)
+{
+	if (op->info.algorithm == TEE_ALG_AES_CTS)
+		return ROUNDUP(slen - buffer_size, op->block_size);
+	else
+		return ROUNDUP(slen - buffer_size + 1, op->block_size);
+}
+
 static TEE_Result tee_buffer_update(
 		TEE_OperationHandle op,
 		TEE_Result(*update_func)(unsigned long state, const void *src,
 				size_t slen, void *dst, uint64_t *dlen),
+		TEE_Result(*update_vec_func)(unsigned long state,
+				const struct utee_iovec *iov, size_t iov_cnt,
+				void *dst, uint64_t *dlen),
 		const void *src_data, size_t src_len,
 		void *dest_data, uint64_t *dest_len)
 {
@@ -909,6 +1054,34 @@ static TEE_Result tee_buffer_update(
 		l = ROUNDUP(op->buffer_offs + slen - buffer_size,
 				op->block_size);
 		l = MIN(op->buffer_offs, l);
+
+		if (l == op->buffer_offs &&
+		    slen >= (buffer_size + buffer_left)) {
+			/*
+			 * The buffer is emptied and src is fed too, do both
+			 * with a single vectored update.
+			 */
+			struct utee_iovec iov[2] = {
+				{ .addr = (vaddr_t)op->buffer, .len = l },
+				{ .addr = (vaddr_t)src,
+				  .len = tee_buffer_feed_len(op, slen,
+							     buffer_size) },
+			};
+
+			tmp_dlen = dlen;
+			res = update_vec_func(op->state, iov, ARRAY_SIZE(iov),
+					      dst, &tmp_dlen);
+			if (res != TEE_SUCCESS)
+				TEE_Panic(res);
+			src += iov[1].len;
+			slen -= iov[1].len;
+			dst += tmp_dlen;
+			dlen -= tmp_dlen;
+			acc_dlen += tmp_dlen;
+			op->buffer_offs = 0;
+			goto feed_buffer;
+		}
+
 		tmp_dlen = dlen;
 		res = update_func(op->state, op->buffer, l, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
@@ -930,10 +1103,7 @@ static TEE_Result tee_buffer_update(
 
 	if (slen >= (buffer_size + buffer_left)) {
 		/* Buffer is empty, feed as much as possible from src */
-		if (op->info.algorithm == TEE_ALG_AES_CTS)
-			l = ROUNDUP(slen - buffer_size, op->block_size);
-		else
-			l = ROUNDUP(slen - buffer_size + 1, op->block_size);
+		l = tee_buffer_feed_len(op, slen, buffer_size);
 
 		tmp_dlen = dlen;
 		res = update_func(op->state, src, l, dst, &tmp_dlen);
@@ -946,6 +1116,7 @@ static TEE_Result tee_buffer_update(
 		acc_dlen += tmp_dlen;
 	}
 
+feed_buffer:
 	/* Slen is small enough to be contained in buffer. */
 	memcpy(op->buffer + op->buffer_offs, src, slen);
 	op->buffer_offs += slen;
@@ -1014,8 +1185,12 @@ TEE_Result TEE_CipherUpdate(TEE_OperationHandle operation, const void *srcData,
 	}
 
 	dl = *destLen;
-	if (operation->block_size > 1) {
-		res = tee_buffer_update(operation, _utee_cipher_update, srcData,
+	if (operation->ce_active) {
+		dl = ce_cipher_update(operation, srcData, srcLen, destData);
+		res = TEE_SUCCESS;
+	} else if (operation->block_size > 1) {
+		res = tee_buffer_update(operation, _utee_cipher_update,
+					_utee_cipher_update_vec, srcData,
 					srcLen, destData, &dl);
 	} else {
 		if (srcLen > 0) {
@@ -1106,8 +1281,13 @@ TEE_Result TEE_CipherDoFinal(TEE_OperationHandle operation,
 		goto out;
 	}
 
-	if (operation->block_size > 1) {
+	if (operation->ce_active) {
+		/* Only *_NOPAD and CTR, nothing is left in the buffer */
+		tmp_dlen = ce_cipher_update(operation, srcData, srcLen, dst);
+		res = TEE_SUCCESS;
+	} else if (operation->block_size > 1) {
 		res = tee_buffer_update(operation, _utee_cipher_update,
+					_utee_cipher_update_vec,
 					srcData, srcLen, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -1319,6 +1499,13 @@ TEE_Result TEE_AEInit(TEE_OperationHandle operation, const void *nonce,
 		}
 	}
 
+	/* RFC 8439 only defines a 128-bit Poly1305 tag */
+	if (operation->info.algorithm == TEE_ALG_CHACHA20_POLY1305 &&
+	    tagLen != 128) {
+		res = TEE_ERROR_NOT_SUPPORTED;
+		goto out;
+	}
+
 	res = _utee_authenc_init(operation->state, nonce, nonceLen, tagLen / 8,
 				 AADLen, payloadLen);
 	if (res != TEE_SUCCESS)
@@ -1409,6 +1596,7 @@ TEE_Result TEE_AEUpdate(TEE_OperationHandle operation, const void *srcData,
 
 	if (operation->block_size > 1) {
 		res = tee_buffer_update(operation, _utee_authenc_update_payload,
+					_utee_authenc_update_payload_vec,
 					srcData, srcLen, destData, &dl);
 	} else {
 		if (srcLen > 0) {
@@ -1492,6 +1680,7 @@ TEE_Result TEE_AEEncryptFinal(TEE_OperationHandle operation,
 	tmp_dlen = *destLen - acc_dlen;
 	if (operation->block_size > 1) {
 		res = tee_buffer_update(operation, _utee_authenc_update_payload,
+					_utee_authenc_update_payload_vec,
 					srcData, srcLen, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -1570,6 +1759,7 @@ TEE_Result TEE_AEDecryptFinal(TEE_OperationHandle operation,
 	tmp_dlen = *destLen - acc_dlen;
 	if (operation->block_size > 1) {
 		res = tee_buffer_update(operation, _utee_authenc_update_payload,
+					_utee_authenc_update_payload_vec,
 					srcData, srcLen, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -1757,6 +1947,65 @@ TEE_Result TEE_AsymmetricVerifyDigest(TEE_OperationHandle operation,
 	return res;
 }
 
+TEE_Result TEE_AsymmetricVerifyDigestBatch(TEE_OperationHandle operation,
+					   const TEE_Attribute *params,
+					   uint32_t paramCount,
+					   struct tee_verify_item *items,
+					   uint32_t itemCount)
+{
+	struct utee_verify_item ui[UTEE_VERIFY_BATCH_MAX_CNT] = { };
+	struct utee_attribute ua[paramCount];
+	TEE_Result ret = TEE_SUCCESS;
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs = 0;
+	size_t cnt = 0;
+	size_t n = 0;
+
+	if (operation == TEE_HANDLE_NULL || (!items && itemCount))
+		TEE_Panic(0);
+
+	__utee_check_attr_in_annotation(params, paramCount);
+
+	if (!operation->key1)
+		TEE_Panic(0);
+	if (operation->info.operationClass !=
+	    TEE_OPERATION_ASYMMETRIC_SIGNATURE)
+		TEE_Panic(0);
+	if (operation->info.mode != TEE_MODE_VERIFY)
+		TEE_Panic(0);
+
+	__utee_from_attr(ua, params, paramCount);
+
+	for (offs = 0; offs < itemCount; offs += cnt) {
+		cnt = MIN(itemCount - offs, ARRAY_SIZE(ui));
+
+		for (n = 0; n < cnt; n++) {
+			if ((!items[offs + n].digest &&
+			     items[offs + n].digest_len) ||
+			    (!items[offs + n].signature &&
+			     items[offs + n].signature_len))
+				TEE_Panic(0);
+
+			ui[n].digest = (uintptr_t)items[offs + n].digest;
+			ui[n].digest_len = items[offs + n].digest_len;
+			ui[n].sig = (uintptr_t)items[offs + n].signature;
+			ui[n].sig_len = items[offs + n].signature_len;
+		}
+
+		res = _utee_asymm_verify_batch(operation->state, ua,
+					       paramCount, ui, cnt);
+		if (res != TEE_SUCCESS && res != TEE_ERROR_SIGNATURE_INVALID)
+			TEE_Panic(res);
+		if (res)
+			ret = res;
+
+		for (n = 0; n < cnt; n++)
+			items[offs + n].result = ui[n].result;
+	}
+
+	return ret;
+}
+
 /* Cryptographic Operations API - Key Derivation Functions */
 
 void TEE_DeriveKey(TEE_OperationHandle operation,
@@ -2054,6 +2303,18 @@ TEE_Result TEE_IsAlgorithmSupported(uint32_t alg, uint32_t element)
 		if (alg == TEE_ALG_SM2_PKE && element == TEE_ECC_CURVE_SM2)
 			return TEE_SUCCESS;
 	}
+	if (IS_ENABLED(CFG_CRYPTO_X25519)) {
+		if (alg == TEE_ALG_X25519)
+			goto check_element_none;
+	}
+	if (IS_ENABLED(CFG_CRYPTO_ED25519)) {
+		if (alg == TEE_ALG_ED25519)
+			goto check_element_none;
+	}
+	if (IS_ENABLED(CFG_CRYPTO_CHACHA20_POLY1305)) {
+		if (alg == TEE_ALG_CHACHA20_POLY1305)
+			goto check_element_none;
+	}
 
 	return TEE_ERROR_NOT_SUPPORTED;
 check_element_none:
@@ -15,6 +15,81 @@ void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
 TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 			struct utee_params *up, unsigned long cmd_id);
 
+/*
+ * Drops the cached properties of the current client when @session_id
+ * isn't the session of the previous entry, 0 means no session.
+ */
+void __utee_prop_cache_enter_session(unsigned long session_id);
+
+/*
+ * Pool of the TEE_USER_MEM_HINT_TEMPORARY allocations. __utee_temp_free()
+ * and __utee_temp_realloc() return false if @ptr isn't from the pool.
+ * __utee_temp_pool_release() is called when an entry point returns.
+ */
+void *__utee_temp_alloc(size_t len, bool zero);
+bool __utee_temp_free(void *ptr);
+bool __utee_temp_realloc(void *ptr, size_t len, void **new_ptr);
+void __utee_temp_pool_release(void);
+
+/*
+ * Same as crypto_accel_aes_expand_keys() in the core, used by
+ * __utee_ce_cipher_init() and by the mbedTLS AES of the TAs.
+ */
+TEE_Result __utee_ce_aes_expand_keys(const void *key, size_t key_len,
+				     void *enc_key, void *dec_key,
+				     size_t expanded_key_len,
+				     unsigned int *round_count);
+
+struct utee_ce_state;
+
+/*
+ * AES and SHA-256 run in user mode with the ARMv8 Cryptographic
+ * Extensions, see CFG_TA_CRYPTO_ARM_CE. __utee_ce_state_alloc() returns
+ * NULL if @algo isn't supported and __utee_ce_cipher_init() returns false
+ * if the key or the IV can't be used, the core is used instead then.
+ */
+#if defined(CFG_TA_CRYPTO_ARM_CE)
+struct utee_ce_state *__utee_ce_state_alloc(uint32_t algo, uint32_t mode);
+void __utee_ce_state_free(struct utee_ce_state *st);
+void __utee_ce_state_copy(struct utee_ce_state *dst,
+			  const struct utee_ce_state *src);
+void __utee_ce_hash_init(struct utee_ce_state *st);
+void __utee_ce_hash_update(struct utee_ce_state *st, const void *data,
+			   size_t len);
+void __utee_ce_hash_final(struct utee_ce_state *st, void *digest);
+bool __utee_ce_cipher_init(struct utee_ce_state *st, const void *key,
+			   size_t key_len, const void *iv, size_t iv_len);
+void __utee_ce_cipher_update(struct utee_ce_state *st, const void *src,
+			     size_t len, void *dst);
+#else
+static inline struct utee_ce_state *
+__utee_ce_state_alloc(uint32_t algo __unused, uint32_t mode __unused)
+{
+	return NULL;
+}
+static inline void __utee_ce_state_free(struct utee_ce_state *st __unused) {}
+static inline void
+__utee_ce_state_copy(struct utee_ce_state *dst __unused,
+		     const struct utee_ce_state *src __unused) {}
+static inline void __utee_ce_hash_init(struct utee_ce_state *st __unused) {}
+static inline void __utee_ce_hash_update(struct utee_ce_state *st __unused,
+					 const void *data __unused,
+					 size_t len __unused) {}
+static inline void __utee_ce_hash_final(struct utee_ce_state *st __unused,
+					void *digest __unused) {}
+static inline bool __utee_ce_cipher_init(struct utee_ce_state *st __unused,
+					 const void *key __unused,
+					 size_t key_len __unused,
+					 const void *iv __unused,
+					 size_t iv_len __unused)
+{
+	return false;
+}
+static inline void __utee_ce_cipher_update(struct utee_ce_state *st __unused,
+					   const void *src __unused,
+					   size_t len __unused,
+					   void *dst __unused) {}
+#endif
 
 #if defined(CFG_TA_GPROF_SUPPORT)
 void __utee_gprof_init(void);
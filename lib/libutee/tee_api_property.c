@@ -15,6 +15,7 @@
 #include <tee_isocket.h>
 #include <user_ta_header.h>
 #include <utee_syscalls.h>
+#include <utee_types.h>
 #include <util.h>
 
 #include "base64.h"
@@ -25,9 +26,38 @@
 
 #define PROP_ENUMERATOR_NOT_STARTED 0xffffffff
 
+/*
+ * Cache of the properties obtained from the kernel, one entry per hash
+ * slot. The current TA and TEE implementation properties don't change
+ * during the life of the TA, the current client ones are dropped when
+ * another session is entered.
+ */
+#define PROP_CACHE_ENTRIES	16
+#define PROP_CACHE_NAME_MAX	64
+#define PROP_CACHE_VALUE_MAX	64
+
+struct prop_cache_entry {
+	TEE_PropSetHandle h;
+	uint32_t type;
+	uint32_t len;
+	char name[PROP_CACHE_NAME_MAX];
+	uint8_t value[PROP_CACHE_VALUE_MAX];
+};
+
+static struct prop_cache_entry prop_cache[PROP_CACHE_ENTRIES];
+static unsigned long prop_cache_session_id;
+
+/*
+ * The properties of the set known by the kernel are fetched with a single
+ * syscall the first time they're needed by the enumerator, they're
+ * fetched again if another session has been entered since.
+ */
 struct prop_enumerator {
 	uint32_t idx;			/* current index */
 	TEE_PropSetHandle prop_set;	/* part of TEE_PROPSET_xxx */
+	uint8_t *kprops;		/* struct utee_prop_rec records */
+	uint32_t kprops_len;
+	unsigned long kprops_session_id;
 };
 
 const struct user_ta_property tee_props[] = {
@@ -131,6 +161,137 @@ static bool is_propset_pseudo_handle(TEE_PropSetHandle h)
 	       h == TEE_PROPSET_TEE_IMPLEMENTATION;
 }
 
+static struct prop_cache_entry *prop_cache_slot(TEE_PropSetHandle h,
+						const char *name)
+{
+	uint32_t hash = 2166136261; /* FNV-1a */
+	const char *p = NULL;
+
+	for (p = name; *p; p++)
+		hash = (hash ^ (uint8_t)*p) * 16777619;
+	hash ^= (unsigned long)h;
+
+	return prop_cache + hash % PROP_CACHE_ENTRIES;
+}
+
+static TEE_Result prop_cache_get(TEE_PropSetHandle h, const char *name,
+				 uint32_t *type, void *buf, uint32_t *len)
+{
+	struct prop_cache_entry *e = prop_cache_slot(h, name);
+
+	if (e->h != h || strcmp(e->name, name))
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	*type = e->type;
+	if (*len < e->len) {
+		*len = e->len;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	*len = e->len;
+	memcpy(buf, e->value, e->len);
+
+	return TEE_SUCCESS;
+}
+
+static void prop_cache_put(TEE_PropSetHandle h, const char *name,
+			   uint32_t type, const void *buf, uint32_t len)
+{
+	struct prop_cache_entry *e = prop_cache_slot(h, name);
+
+	if (len > sizeof(e->value) ||
+	    strlcpy(e->name, name, sizeof(e->name)) >= sizeof(e->name)) {
+		e->h = NULL;
+		return;
+	}
+
+	e->h = h;
+	e->type = type;
+	e->len = len;
+	memcpy(e->value, buf, len);
+}
+
+void __utee_prop_cache_enter_session(unsigned long session_id)
+{
+	size_t n = 0;
+
+	if (session_id == prop_cache_session_id)
+		return;
+
+	for (n = 0; n < ARRAY_SIZE(prop_cache); n++)
+		if (prop_cache[n].h == TEE_PROPSET_CURRENT_CLIENT)
+			prop_cache[n].h = NULL;
+	prop_cache_session_id = session_id;
+}
+
+static void kprops_drop(struct prop_enumerator *pe)
+{
+	TEE_Free(pe->kprops);
+	pe->kprops = NULL;
+	pe->kprops_len = 0;
+}
+
+static TEE_Result kprops_fetch(struct prop_enumerator *pe)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t len = 0;
+
+	if (pe->kprops && pe->kprops_session_id == prop_cache_session_id)
+		return TEE_SUCCESS;
+	kprops_drop(pe);
+
+	while (true) {
+		res = _utee_get_property_set((unsigned long)pe->prop_set,
+					     pe->kprops, &len);
+		if (res != TEE_ERROR_SHORT_BUFFER)
+			break;
+		TEE_Free(pe->kprops);
+		pe->kprops = TEE_Malloc(len, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+		if (!pe->kprops)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	if (res) {
+		kprops_drop(pe);
+		return res;
+	}
+
+	pe->kprops_len = len;
+	pe->kprops_session_id = prop_cache_session_id;
+
+	return TEE_SUCCESS;
+}
+
+/* Finds the property @idx of the kernel, the name and value follow @rec */
+static TEE_Result kprops_get(struct prop_enumerator *pe, uint32_t idx,
+			     struct utee_prop_rec *rec, const uint8_t **data)
+{
+	TEE_Result res = kprops_fetch(pe);
+	size_t offs = 0;
+	size_t len = 0;
+	uint32_t n = 0;
+
+	if (res)
+		return res;
+
+	while (true) {
+		if (pe->kprops_len - offs < sizeof(*rec))
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		memcpy(rec, pe->kprops + offs, sizeof(*rec));
+		len = ROUNDUP(sizeof(*rec) + rec->name_len + rec->value_len,
+			      UTEE_PROP_REC_ALIGN);
+		if (len > pe->kprops_len - offs)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		if (n == idx)
+			break;
+		offs += len;
+		n++;
+	}
+
+	if (data)
+		*data = pe->kprops + offs + sizeof(*rec);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 				       enum user_ta_prop_type *type,
 				       void *buf, uint32_t *len)
@@ -154,6 +315,10 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 							    buf, len);
 		}
 
+		res = prop_cache_get(h, name, &prop_type, buf, len);
+		if (res != TEE_ERROR_ITEM_NOT_FOUND)
+			goto out;
+
 		/* get the index from the name */
 		res = _utee_get_property_name_to_index((unsigned long)h, name,
 						       strlen(name) + 1,
@@ -162,8 +327,12 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 			return res;
 		res = _utee_get_property((unsigned long)h, index, NULL, NULL,
 					 buf, len, &prop_type);
+		if (res == TEE_SUCCESS)
+			prop_cache_put(h, name, prop_type, buf, *len);
 	} else {
 		struct prop_enumerator *pe = (struct prop_enumerator *)h;
+		struct utee_prop_rec rec = { };
+		const uint8_t *data = NULL;
 		uint32_t idx = pe->idx;
 
 		if (idx == PROP_ENUMERATOR_NOT_STARTED)
@@ -177,12 +346,23 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 			return propget_get_ext_prop(eps + idx, type, buf, len);
 		idx -= eps_len;
 
-		res = _utee_get_property((unsigned long)pe->prop_set, idx,
-					 NULL, NULL, buf, len, &prop_type);
+		res = kprops_get(pe, idx, &rec, &data);
 		if (res == TEE_ERROR_ITEM_NOT_FOUND)
 			res = TEE_ERROR_BAD_PARAMETERS;
+		if (res)
+			return res;
+
+		prop_type = rec.prop_type;
+		if (*len < rec.value_len) {
+			res = TEE_ERROR_SHORT_BUFFER;
+		} else {
+			memcpy(buf, data + rec.name_len, rec.value_len);
+			res = TEE_SUCCESS;
+		}
+		*len = rec.value_len;
 	}
 
+out:
 	*type = prop_type;
 	return res;
 }
@@ -431,6 +611,7 @@ TEE_Result TEE_AllocatePropertyEnumerator(TEE_PropSetHandle *enumerator)
 		goto err;
 	}
 
+	pe->kprops = NULL;
 	*enumerator = (TEE_PropSetHandle) pe;
 	TEE_ResetPropertyEnumerator(*enumerator);
 
@@ -449,12 +630,15 @@ void TEE_ResetPropertyEnumerator(TEE_PropSetHandle enumerator)
 	struct prop_enumerator *pe = (struct prop_enumerator *)enumerator;
 
 	pe->idx = PROP_ENUMERATOR_NOT_STARTED;
+	kprops_drop(pe);
 }
 
 void TEE_FreePropertyEnumerator(TEE_PropSetHandle enumerator)
 {
 	struct prop_enumerator *pe = (struct prop_enumerator *)enumerator;
 
+	if (pe)
+		kprops_drop(pe);
 	TEE_Free(pe);
 }
 
@@ -468,6 +652,7 @@ void TEE_StartPropertyEnumerator(TEE_PropSetHandle enumerator,
 
 	pe->idx = 0;
 	pe->prop_set = propSet;
+	kprops_drop(pe);
 }
 
 TEE_Result TEE_GetPropertyName(TEE_PropSetHandle enumerator,
@@ -476,6 +661,8 @@ TEE_Result TEE_GetPropertyName(TEE_PropSetHandle enumerator,
 	TEE_Result res;
 	struct prop_enumerator *pe = (struct prop_enumerator *)enumerator;
 	const struct user_ta_property *eps;
+	struct utee_prop_rec rec = { };
+	const uint8_t *data = NULL;
 	size_t eps_len;
 	const char *str;
 	size_t bufferlen;
@@ -498,11 +685,14 @@ TEE_Result TEE_GetPropertyName(TEE_PropSetHandle enumerator,
 			res = TEE_ERROR_SHORT_BUFFER;
 		*name_len = bufferlen;
 	} else {
-		res = _utee_get_property((unsigned long)pe->prop_set,
-					 pe->idx - eps_len, name, name_len,
-					 NULL, NULL, NULL);
+		res = kprops_get(pe, pe->idx - eps_len, &rec, &data);
 		if (res != TEE_SUCCESS)
 			goto err;
+		if (*name_len < rec.name_len)
+			res = TEE_ERROR_SHORT_BUFFER;
+		else
+			memcpy(name, data, rec.name_len);
+		*name_len = rec.name_len;
 	}
 
 err:
@@ -519,6 +709,7 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
 	struct prop_enumerator *pe = (struct prop_enumerator *)enumerator;
 	uint32_t next_idx;
 	const struct user_ta_property *eps;
+	struct utee_prop_rec rec = { };
 	size_t eps_len;
 
 	if (!pe) {
@@ -540,9 +731,7 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
 	if (next_idx < eps_len)
 		res = TEE_SUCCESS;
 	else
-		res = _utee_get_property((unsigned long)pe->prop_set,
-					 next_idx - eps_len, NULL, NULL, NULL,
-					 NULL, NULL);
+		res = kprops_get(pe, next_idx - eps_len, &rec, NULL);
 
 out:
 	if (res != TEE_SUCCESS &&
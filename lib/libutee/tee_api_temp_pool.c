@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+#include <tee_internal_api_extensions.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "tee_api_private.h"
+
+/*
+ * Pool of the TEE_USER_MEM_HINT_TEMPORARY allocations. Buffers are carved
+ * out of chunks allocated from the heap and are all released at once when
+ * the TA returns from an entry point. The first chunk is kept for the next
+ * entry so that a TA only allocating a few temporary buffers per entry
+ * doesn't use the heap at all once warmed up.
+ *
+ * Each buffer is preceded by a header holding its size, needed by
+ * TEE_Realloc(). TEE_Free() only gives back the space of the most recent
+ * buffer of a chunk, other buffers are released with the pool.
+ */
+
+#define TEMP_POOL_ALIGN		(sizeof(vaddr_t) * 2)
+#define TEMP_POOL_CHUNK_SIZE	2048
+
+struct temp_chunk {
+	SLIST_ENTRY(temp_chunk) link;
+	size_t size;
+	size_t offs;
+	uint8_t data[] __aligned(TEMP_POOL_ALIGN);
+};
+
+struct temp_hdr {
+	size_t len;
+} __aligned(TEMP_POOL_ALIGN);
+
+static SLIST_HEAD(temp_chunk_head, temp_chunk) temp_chunks =
+	SLIST_HEAD_INITIALIZER(temp_chunks);
+
+static struct temp_chunk *find_chunk(const void *ptr)
+{
+	const uint8_t *p = ptr;
+	struct temp_chunk *c = NULL;
+
+	SLIST_FOREACH(c, &temp_chunks, link)
+		if (p > c->data && p < c->data + c->offs)
+			return c;
+
+	return NULL;
+}
+
+static struct temp_hdr *get_hdr(void *ptr)
+{
+	return (struct temp_hdr *)ptr - 1;
+}
+
+static struct temp_chunk *alloc_chunk(size_t space)
+{
+	struct temp_chunk *c = NULL;
+	size_t sz = 0;
+
+	if (ADD_OVERFLOW(space, sizeof(*c), &sz))
+		return NULL;
+	sz = MAX(sz, (size_t)TEMP_POOL_CHUNK_SIZE);
+
+	c = malloc(sz);
+	if (!c)
+		return NULL;
+	c->size = sz - sizeof(*c);
+	c->offs = 0;
+
+	return c;
+}
+
+void *__utee_temp_alloc(size_t len, bool zero)
+{
+	struct temp_chunk *c = SLIST_FIRST(&temp_chunks);
+	struct temp_hdr *hdr = NULL;
+	size_t space = 0;
+
+	if (ROUNDUP_OVERFLOW(len, TEMP_POOL_ALIGN, &space) ||
+	    ADD_OVERFLOW(space, sizeof(*hdr), &space))
+		return NULL;
+
+	/* Only the most recent chunk is allocated from */
+	if (!c || c->size - c->offs < space) {
+		c = alloc_chunk(space);
+		if (!c)
+			return NULL;
+		SLIST_INSERT_HEAD(&temp_chunks, c, link);
+	}
+
+	hdr = (struct temp_hdr *)(c->data + c->offs);
+	hdr->len = len;
+	c->offs += space;
+
+	if (zero)
+		memset(hdr + 1, 0, len);
+
+	return hdr + 1;
+}
+
+bool __utee_temp_free(void *ptr)
+{
+	struct temp_chunk *c = NULL;
+	struct temp_hdr *hdr = NULL;
+
+	if (!ptr)
+		return false;
+
+	c = find_chunk(ptr);
+	if (!c)
+		return false;
+
+	hdr = get_hdr(ptr);
+	if ((uint8_t *)ptr + ROUNDUP(hdr->len, TEMP_POOL_ALIGN) ==
+	    c->data + c->offs)
+		c->offs = (uint8_t *)hdr - c->data;
+
+	return true;
+}
+
+bool __utee_temp_realloc(void *ptr, size_t len, void **new_ptr)
+{
+	void *p = NULL;
+	size_t old_len = 0;
+
+	if (!ptr || !find_chunk(ptr))
+		return false;
+
+	old_len = get_hdr(ptr)->len;
+	if (len <= old_len) {
+		get_hdr(ptr)->len = len;
+		*new_ptr = ptr;
+		return true;
+	}
+
+	p = __utee_temp_alloc(len, false);
+	if (p)
+		memcpy(p, ptr, old_len);
+	*new_ptr = p;
+
+	return true;
+}
+
+void __utee_temp_pool_release(void)
+{
+	struct temp_chunk *c = SLIST_FIRST(&temp_chunks);
+
+	if (!c)
+		return;
+
+	/* Keep the oldest chunk for the next entry */
+	while (SLIST_NEXT(c, link)) {
+		SLIST_REMOVE_HEAD(&temp_chunks, link);
+		free(c);
+		c = SLIST_FIRST(&temp_chunks);
+	}
+	c->offs = 0;
+}
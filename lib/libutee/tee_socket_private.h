@@ -6,6 +6,8 @@
 #ifndef __TEE_SOCKET_PRIVATE_H
 #define __TEE_SOCKET_PRIVATE_H
 
+#include <pta_socket.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <__tee_ipsocket.h>
 
@@ -29,4 +31,12 @@ TEE_Result __tee_socket_pta_recv(uint32_t handle, void *buf, uint32_t *len,
 TEE_Result __tee_socket_pta_ioctl(uint32_t handle, uint32_t command, void *buf,
 				  uint32_t *len);
 
+TEE_Result __tee_socket_pta_sendv(uint32_t handle, const void *buf,
+				  size_t len, const uint32_t *rec_lens,
+				  uint32_t *rec_count, uint32_t timeout);
+
+TEE_Result __tee_socket_pta_poll(struct pta_socket_pollfd *fds,
+				 uint32_t nfds, uint32_t *nready,
+				 uint32_t timeout);
+
 #endif /*__TEE_SOCKET_PRIVATE_H*/
@@ -160,3 +160,56 @@ TEE_Result __tee_socket_pta_ioctl(uint32_t handle, uint32_t command, void *buf,
 	*len =  params[1].memref.size;
 	return res;
 }
+
+TEE_Result __tee_socket_pta_sendv(uint32_t handle, const void *buf,
+				  size_t len, const uint32_t *rec_lens,
+				  uint32_t *rec_count, uint32_t timeout)
+{
+	TEE_Result res;
+	uint32_t param_types;
+	TEE_Param params[TEE_NUM_PARAMS];
+
+	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INPUT,
+				      TEE_PARAM_TYPE_VALUE_OUTPUT);
+	memset(params, 0, sizeof(params));
+
+	params[0].value.a = handle;
+	params[0].value.b = timeout;
+
+	params[1].memref.buffer = (void *)buf;
+	params[1].memref.size = len;
+
+	params[2].memref.buffer = (void *)rec_lens;
+	params[2].memref.size = *rec_count * sizeof(*rec_lens);
+
+	res = invoke_socket_pta(PTA_SOCKET_SENDV, param_types, params);
+	*rec_count = params[3].value.a;
+	return res;
+}
+
+TEE_Result __tee_socket_pta_poll(struct pta_socket_pollfd *fds,
+				 uint32_t nfds, uint32_t *nready,
+				 uint32_t timeout)
+{
+	TEE_Result res;
+	uint32_t param_types;
+	TEE_Param params[TEE_NUM_PARAMS];
+
+	param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				      TEE_PARAM_TYPE_MEMREF_INOUT,
+				      TEE_PARAM_TYPE_VALUE_OUTPUT,
+				      TEE_PARAM_TYPE_NONE);
+	memset(params, 0, sizeof(params));
+
+	params[0].value.a = timeout;
+
+	params[1].memref.buffer = fds;
+	params[1].memref.size = nfds * sizeof(*fds);
+
+	res = invoke_socket_pta(PTA_SOCKET_POLL, param_types, params);
+	if (res == TEE_SUCCESS)
+		*nready = params[2].value.a;
+	return res;
+}
@@ -3,12 +3,17 @@
  * Copyright (c) 2016-2017, Linaro Limited
  */
 
+#include <assert.h>
 #include <pta_socket.h>
+#include <string.h>
 #include <tee_internal_api.h>
+#include <tee_internal_api_extensions.h>
 #include <tee_isocket.h>
+#include <tee_isocket_extensions.h>
 #include <tee_tcpsocket.h>
 #include <__tee_tcpsocket_defines_extensions.h>
 #include <tee_udpsocket.h>
+#include <util.h>
 
 #include "tee_socket_private.h"
 
@@ -203,7 +208,97 @@ static TEE_Result udp_ioctl(TEE_iSocketHandle ctx, uint32_t commandCode,
 	return res;
 }
 
+TEE_Result TEE_iSocketSendv(TEE_iSocketHandle ctx,
+			    const struct tee_isocket_iovec *iov,
+			    uint32_t *iovcnt, uint32_t timeout)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct socket_ctx *sock_ctx = (struct socket_ctx *)ctx;
+	uint32_t *lens = NULL;
+	uint8_t *buf = NULL;
+	size_t len = 0;
+	size_t offs = 0;
+	uint32_t n = 0;
+
+	if (ctx == TEE_HANDLE_NULL || !iovcnt || (!iov && *iovcnt))
+		TEE_Panic(0);
+
+	if (!*iovcnt)
+		return TEE_SUCCESS;
+
+	for (n = 0; n < *iovcnt; n++) {
+		if ((!iov[n].buf && iov[n].len) ||
+		    ADD_OVERFLOW(len, iov[n].len, &len))
+			TEE_Panic(0);
+	}
+
+	if (MUL_OVERFLOW(*iovcnt, sizeof(*lens), &offs))
+		TEE_Panic(0);
+
+	/* The records are gathered to be passed as a single buffer */
+	lens = TEE_Malloc(offs, TEE_MALLOC_FILL_ZERO);
+	buf = TEE_Malloc(len, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+	if (!lens || !buf) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	offs = 0;
+	for (n = 0; n < *iovcnt; n++) {
+		memcpy(buf + offs, iov[n].buf, iov[n].len);
+		offs += iov[n].len;
+		lens[n] = iov[n].len;
+	}
+
+	res = __tee_socket_pta_sendv(sock_ctx->handle, buf, len, lens, iovcnt,
+				     timeout);
+	sock_ctx->proto_error = res;
+out:
+	TEE_Free(lens);
+	TEE_Free(buf);
+
+	return res;
+}
 
+TEE_Result TEE_iSocketPoll(struct tee_isocket_pollfd *fds, uint32_t nfds,
+			   uint32_t *nready, uint32_t timeout)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct pta_socket_pollfd *pfds = NULL;
+	struct socket_ctx *sock_ctx = NULL;
+	size_t sz = 0;
+	uint32_t n = 0;
+
+	/* The events are passed as is to the socket PTA */
+	COMPILE_TIME_ASSERT(TEE_ISOCKET_POLL_IN == PTA_SOCKET_POLL_IN &&
+			    TEE_ISOCKET_POLL_OUT == PTA_SOCKET_POLL_OUT &&
+			    TEE_ISOCKET_POLL_ERR == PTA_SOCKET_POLL_ERR);
+
+	if (!nready || !fds || !nfds ||
+	    MUL_OVERFLOW(nfds, sizeof(*pfds), &sz))
+		TEE_Panic(0);
+
+	pfds = TEE_Malloc(sz, TEE_MALLOC_FILL_ZERO);
+	if (!pfds)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < nfds; n++) {
+		if (fds[n].ctx == TEE_HANDLE_NULL)
+			TEE_Panic(0);
+		sock_ctx = fds[n].ctx;
+		pfds[n].handle = sock_ctx->handle;
+		pfds[n].events = fds[n].events;
+	}
+
+	res = __tee_socket_pta_poll(pfds, nfds, nready, timeout);
+	if (res == TEE_SUCCESS)
+		for (n = 0; n < nfds; n++)
+			fds[n].revents = pfds[n].revents;
+
+	TEE_Free(pfds);
+
+	return res;
+}
 
 static TEE_iSocket tcp_socket_instance = {
 	.TEE_iSocketVersion = TEE_ISOCKET_VERSION,
@@ -25,10 +25,6 @@
 #endif
 #include "ftrace.h"
 
-#define DURATION_MAX_LEN		16
-
-static const char hex_str[] = "0123456789abcdef";
-
 static __noprof struct ftrace_buf *get_fbuf(void)
 {
 #if defined(__KERNEL__)
@@ -59,6 +55,89 @@ static __noprof struct ftrace_buf *get_fbuf(void)
 #endif
 }
 
+#if defined(_CFG_FTRACE_BUF_FORMAT_binary)
+
+/*
+ * The buffer is a ring of struct ftrace_rec, there's a single writer per
+ * buffer (the TA thread, or the core on its behalf during syscalls) so no
+ * locking is needed.
+ */
+static void __noprof fbuf_add_rec(struct ftrace_buf *fbuf, uint64_t now,
+				  bool ret, unsigned long pc)
+{
+	struct ftrace_rec *rec = (struct ftrace_rec *)((char *)fbuf +
+						       fbuf->buf_off +
+						       fbuf->curr_size);
+
+	rec->ts = (now & FTRACE_REC_TS_MASK) |
+		  ((uint64_t)fbuf->ret_idx << FTRACE_REC_DEPTH_SHIFT);
+	if (ret)
+		rec->ts |= FTRACE_REC_RETURN;
+	rec->pc = pc;
+
+	fbuf->curr_size += sizeof(*rec);
+	if (fbuf->curr_size + sizeof(*rec) > fbuf->max_size) {
+		fbuf->curr_size = 0;
+		fbuf->rec_wrapped = true;
+	}
+}
+
+void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
+{
+	struct ftrace_buf *fbuf = NULL;
+	uint64_t now = 0;
+
+	fbuf = get_fbuf();
+
+	if (!fbuf || !fbuf->buf_off ||
+	    fbuf->max_size < sizeof(struct ftrace_rec))
+		return;
+
+	if (fbuf->ret_idx >= FTRACE_RETFUNC_DEPTH) {
+		/*
+		 * This scenario isn't expected as function call depth
+		 * shouldn't be more than FTRACE_RETFUNC_DEPTH.
+		 */
+#if defined(__KERNEL__)
+		panic();
+#else
+		_utee_panic(0);
+#endif
+	}
+
+	now = barrier_read_cntpct();
+	fbuf_add_rec(fbuf, now, false, pc);
+
+	fbuf->ret_stack[fbuf->ret_idx] = *lr;
+	fbuf->begin_time[fbuf->ret_idx] = now;
+	fbuf->ret_idx++;
+
+	*lr = (unsigned long)&__ftrace_return;
+}
+
+unsigned long __noprof ftrace_return(void)
+{
+	struct ftrace_buf *fbuf = NULL;
+
+	fbuf = get_fbuf();
+
+	/* Check for valid return index */
+	if (fbuf && fbuf->ret_idx && fbuf->ret_idx <= FTRACE_RETFUNC_DEPTH)
+		fbuf->ret_idx--;
+	else
+		return 0;
+
+	fbuf_add_rec(fbuf, barrier_read_cntpct(), true, 0);
+
+	return fbuf->ret_stack[fbuf->ret_idx];
+}
+
+#else /*!_CFG_FTRACE_BUF_FORMAT_binary*/
+
+#define DURATION_MAX_LEN		16
+
+static const char hex_str[] = "0123456789abcdef";
+
 #if defined(_CFG_FTRACE_BUF_WHEN_FULL_shift)
 
 /*
@@ -303,6 +382,7 @@ unsigned long __noprof ftrace_return(void)
 
 	return fbuf->ret_stack[fbuf->ret_idx];
 }
+#endif /*!_CFG_FTRACE_BUF_FORMAT_binary*/
 
 #if !defined(__KERNEL__)
 void __noprof ftrace_longjmp(unsigned int *ret_idx)
@@ -49,6 +49,27 @@ extern struct mempool *mempool_default;
 struct mempool *mempool_alloc_pool(void *data, size_t size,
 				   void (*release_mem)(void *ptr, size_t size));
 
+#if defined(__KERNEL__)
+/*
+ * mempool_alloc_thread_pool() - Allocate a new memory pool with one arena
+ *				 per thread
+ * @data:		a block of memory of CFG_NUM_THREADS * @size bytes
+ *			to carve out the arenas from, must have an
+ *			alignment of MEMPOOL_ALIGN.
+ * @size:		size of each arena, must be a multiple of
+ *			MEMPOOL_ALIGN
+ * @release_mem:	function to call with an arena when it has been
+ *			emptied, ignored if NULL.
+ *
+ * Items are allocated from the arena of the current thread so threads
+ * never wait for each other, but each thread is limited to @size bytes.
+ * returns a pointer to a valid pool on success or NULL on failure.
+ */
+struct mempool *
+mempool_alloc_thread_pool(void *data, size_t size,
+			  void (*release_mem)(void *ptr, size_t size));
+#endif
+
 /*
  * mempool_alloc() - Allocate an item from a memory pool
  * @pool:		A memory pool created with mempool_alloc_pool()
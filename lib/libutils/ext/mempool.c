@@ -50,6 +50,13 @@
  *   - if an item A is allocated before another item B, then A should be
  *     released after B.
  *   So the potential fragmentation is mitigated.
+ *
+ * In the TEE core items are allocated and freed by a single thread
+ * holding the pool until all its items are freed, other threads using the
+ * same pool are blocked meanwhile. A pool created with
+ * mempool_alloc_thread_pool() instead has one arena per thread, with a
+ * thread only ever using its own arena no locking is needed and threads
+ * don't block each other.
  */
 
 
@@ -63,6 +70,9 @@ struct mempool {
 #if defined(__KERNEL__)
 	void (*release_mem)(void *ptr, size_t size);
 	struct recursive_mutex mu;
+	struct mempool *arenas;	/* CFG_NUM_THREADS arenas or NULL */
+	bool is_arena;
+	size_t refc;		/* Used instead of @mu in an arena */
 #endif
 };
 
@@ -70,30 +80,62 @@ struct mempool {
 struct mempool *mempool_default;
 #endif
 
-static void get_pool(struct mempool *pool __maybe_unused)
+/* Returns the pool or arena of the current thread to allocate from */
+static struct mempool *get_pool(struct mempool *pool)
 {
 #if defined(__KERNEL__)
+	if (pool->arenas) {
+		pool = pool->arenas + thread_get_id();
+		pool->refc++;
+		return pool;
+	}
+
 	mutex_lock_recursive(&pool->mu);
 #endif
+	return pool;
 }
 
+#if defined(__KERNEL__)
+static void release_pool(struct mempool *pool)
+{
+	/*
+	 * As the refcount is about to become 0 there should be no items
+	 * left
+	 */
+	if (pool->last_offset >= 0)
+		panic();
+	if (pool->release_mem)
+		pool->release_mem((void *)pool->data, pool->size);
+}
+#endif
+
 static void put_pool(struct mempool *pool __maybe_unused)
 {
 #if defined(__KERNEL__)
-	if (mutex_get_recursive_lock_depth(&pool->mu) == 1) {
-		/*
-		 * As the refcount is about to become 0 there should be no items
-		 * left
-		 */
-		if (pool->last_offset >= 0)
-			panic();
-		if (pool->release_mem)
-			pool->release_mem((void *)pool->data, pool->size);
+	if (pool->is_arena) {
+		assert(pool->refc);
+		pool->refc--;
+		if (!pool->refc)
+			release_pool(pool);
+		return;
 	}
+
+	if (mutex_get_recursive_lock_depth(&pool->mu) == 1)
+		release_pool(pool);
 	mutex_unlock_recursive(&pool->mu);
 #endif
 }
 
+/* Returns the pool or arena of the current thread holding items */
+static struct mempool *find_pool(struct mempool *pool)
+{
+#if defined(__KERNEL__)
+	if (pool->arenas)
+		return pool->arenas + thread_get_id();
+#endif
+	return pool;
+}
+
 struct mempool *
 mempool_alloc_pool(void *data, size_t size,
 		   void (*release_mem)(void *ptr, size_t size) __maybe_unused)
@@ -116,13 +158,51 @@ mempool_alloc_pool(void *data, size_t size,
 	return pool;
 }
 
+#if defined(__KERNEL__)
+struct mempool *
+mempool_alloc_thread_pool(void *data, size_t size,
+			  void (*release_mem)(void *ptr, size_t size))
+{
+	struct mempool *pool = NULL;
+	struct mempool *arena = NULL;
+	size_t n = 0;
+
+	assert(!((vaddr_t)data & (MEMPOOL_ALIGN - 1)));
+	assert(!(size & (MEMPOOL_ALIGN - 1)));
+
+	pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+
+	pool->arenas = calloc(CFG_NUM_THREADS, sizeof(*pool->arenas));
+	if (!pool->arenas) {
+		free(pool);
+		return NULL;
+	}
+
+	pool->size = size * CFG_NUM_THREADS;
+	pool->data = (vaddr_t)data;
+	pool->last_offset = -1;
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		arena = pool->arenas + n;
+		arena->size = size;
+		arena->data = (vaddr_t)data + n * size;
+		arena->last_offset = -1;
+		arena->release_mem = release_mem;
+		arena->is_arena = true;
+	}
+
+	return pool;
+}
+#endif
+
 void *mempool_alloc(struct mempool *pool, size_t size)
 {
 	size_t offset;
 	struct mempool_item *new_item;
 	struct mempool_item *last_item = NULL;
 
-	get_pool(pool);
+	pool = get_pool(pool);
 
 	if (pool->last_offset < 0) {
 		offset = 0;
@@ -189,6 +269,7 @@ void mempool_free(struct mempool *pool, void *ptr)
 	if (!ptr)
 		return;
 
+	pool = find_pool(pool);
 	item = (struct mempool_item *)((vaddr_t)ptr -
 				       sizeof(struct mempool_item));
 	if (item->prev_item_offset >= 0) {
@@ -20,6 +20,14 @@ endif
 srcs-$(CFG_ARM32_$(sm)) += setjmp_a32.S
 srcs-$(CFG_ARM64_$(sm)) += setjmp_a64.S
 
+ifeq ($(CFG_ARM64_$(sm))-$(CFG_ULIBS_ARM64_MEM_ROUTINES),y-y)
+ifneq ($(sm),core)
+# Replaces the generic implementations in ../../newlib
+srcs-y += memcpy_a64.S
+srcs-y += memset_a64.S
+endif
+endif
+
 ifeq ($(CFG_TA_FLOAT_SUPPORT),y)
 # Floating point is only supported for user TAs
 ifneq ($(sm),core)
@@ -90,6 +90,8 @@
 #if defined(__KERNEL__)
 /* Compiling for TEE Core */
 #include <kernel/asan.h>
+#include <kernel/malloc_prof.h>
+#include <kernel/misc.h>
 #include <kernel/thread.h>
 #include <kernel/spinlock.h>
 #include <kernel/unwind.h>
@@ -137,13 +139,32 @@ static __maybe_unused void *memcpy_unchecked(void *dst, const void *src,
 	return memcpy(dst, src, n);
 }
 
+static inline void malloc_prof_alloc(void *ptr __unused,
+				     size_t size __unused,
+				     uintptr_t site __unused)
+{
+}
+
+static inline void malloc_prof_free(void *ptr __unused)
+{
+}
+
 #endif /*__KERNEL__*/
 
+/* Accounts a successful allocation to the caller of malloc() and friends */
+#define PROF_ALLOC(p, size) \
+	do { \
+		if (p) \
+			malloc_prof_alloc((p), (size), \
+				(uintptr_t)__builtin_return_address(0)); \
+	} while (0)
+
 #include "bget.c"		/* this is ugly, but this is bget */
 
 struct malloc_pool {
 	void *buf;
 	size_t len;
+	bool grown;
 };
 
 struct malloc_ctx {
@@ -155,14 +176,25 @@ struct malloc_ctx {
 #endif
 #ifdef __KERNEL__
 	unsigned int spinlock;
+#ifdef CFG_LOCK_STATS
+	struct lock_stats lock_stats;
+#endif
 #endif
 };
 
 #ifdef __KERNEL__
 
+#ifdef CFG_LOCK_STATS
+#define CTX_LOCK_STATS(ctx)		(&(ctx)->lock_stats)
+#define CTX_LOCK_STATS_INIT(name)	\
+	, .lock_stats = LOCK_STATS_INITIALIZER(#name)
+#else
+#define CTX_LOCK_STATS(ctx)		NULL
+#endif
+
 static uint32_t malloc_lock(struct malloc_ctx *ctx)
 {
-	return cpu_spin_lock_xsave(&ctx->spinlock);
+	return cpu_spin_lock_xsave_stats(&ctx->spinlock, CTX_LOCK_STATS(ctx));
 }
 
 static void malloc_unlock(struct malloc_ctx *ctx, uint32_t exceptions)
@@ -184,13 +216,41 @@ static void malloc_unlock(struct malloc_ctx *ctx __unused,
 
 #endif	/* __KERNEL__ */
 
+#ifndef CTX_LOCK_STATS_INIT
+#define CTX_LOCK_STATS_INIT(name)
+#endif
+
 #define DEFINE_CTX(name) struct malloc_ctx name =		\
 	{ .poolset = { .freelist = { {0, 0},			\
 			{&name.poolset.freelist,		\
-			 &name.poolset.freelist}}}}
+			 &name.poolset.freelist}}}		\
+	  CTX_LOCK_STATS_INIT(name) }
 
 static DEFINE_CTX(malloc_ctx);
 
+#if defined(__KERNEL__) && !defined(ENABLE_MDBG) && \
+	defined(CFG_CORE_MALLOC_MAGAZINE_SIZE) && CFG_CORE_MALLOC_MAGAZINE_SIZE
+#define WITH_MAGAZINES
+#define MAG_SIZE		CFG_CORE_MALLOC_MAGAZINE_SIZE
+#define MAG_NUM_SETS		CFG_TEE_CORE_NB_CORE
+#endif
+
+#if !defined(__KERNEL__) && !defined(ENABLE_MDBG) && \
+	defined(CFG_TA_MALLOC_MAGAZINE_SIZE) && CFG_TA_MALLOC_MAGAZINE_SIZE
+#define WITH_MAGAZINES
+#define MAG_SIZE		CFG_TA_MALLOC_MAGAZINE_SIZE
+/* A TA instance is single threaded */
+#define MAG_NUM_SETS		1
+#endif
+
+#if defined(__KERNEL__) && defined(CFG_CORE_HEAP_GROW)
+#define WITH_HEAP_GROW
+#endif
+
+#ifdef WITH_MAGAZINES
+static size_t mag_cached_bytes(void);
+#endif
+
 #ifdef CFG_VIRTUALIZATION
 static __nex_data DEFINE_CTX(nex_malloc_ctx);
 #endif
@@ -245,6 +305,11 @@ static void gen_malloc_get_stats(struct malloc_ctx *ctx,
 
 	memcpy_unchecked(stats, &ctx->mstats, sizeof(*stats));
 	stats->allocated = ctx->poolset.totalloc;
+#ifdef WITH_MAGAZINES
+	/* Buffers cached in magazines are free from the caller's view */
+	if (ctx == &malloc_ctx)
+		stats->allocated -= MIN(stats->allocated, mag_cached_bytes());
+#endif
 	malloc_unlock(ctx, exceptions);
 }
 
@@ -462,6 +527,395 @@ static __maybe_unused bufsize bget_buf_size(void *buf)
 	return osize;
 }
 
+#ifdef WITH_MAGAZINES
+/*
+ * Per-core caches of free small buffers, or magazines, in front of bget.
+ * Each core has one magazine per size class holding up to MAG_SIZE
+ * buffers of at least the class size and less than twice the class size.
+ * An empty magazine is refilled and a full magazine is flushed by batches
+ * of half its size.
+ *
+ * The magazines of a core are protected by a lock of their own which is
+ * only contended when another core reclaims cached buffers after a failed
+ * allocation, so the heap lock is only taken for refills and flushes.
+ *
+ * In a TA there's a single set of magazines, enabled with
+ * malloc_enable_magazines(). Small allocations and releases are then
+ * served without the first-fit search of bget.
+ *
+ * Buffers in magazines are still allocated as far as bget is concerned,
+ * they're tagged as free for ASAN though.
+ */
+#define MAG_NUM_CLASSES		4
+#define MAG_CLASS_SIZE(n)	(SizeQuant << (n))
+#define MAG_BATCH		((MAG_SIZE + 1) / 2)
+
+struct malloc_magazine {
+	size_t count;
+	size_t cached_bytes;
+	void *bufs[MAG_SIZE];
+};
+
+struct malloc_core_magazines {
+	unsigned int lock;
+	struct malloc_magazine mag[MAG_NUM_CLASSES];
+};
+
+static struct malloc_core_magazines malloc_magazines[MAG_NUM_SETS];
+
+/* Returns the size class for an allocation of @size bytes or -1 */
+static int mag_alloc_class(size_t size)
+{
+	int n = 0;
+
+	for (n = 0; n < MAG_NUM_CLASSES; n++)
+		if (size <= MAG_CLASS_SIZE(n))
+			return n;
+
+	return -1;
+}
+
+/* Returns the size class for a buffer of @bs bytes or -1 */
+static int mag_buf_class(bufsize bs)
+{
+	int n = 0;
+
+	if (bs < MAG_CLASS_SIZE(0) ||
+	    bs >= 2 * MAG_CLASS_SIZE(MAG_NUM_CLASSES - 1))
+		return -1;
+
+	while (bs >= MAG_CLASS_SIZE(n + 1))
+		n++;
+
+	return n;
+}
+
+#ifdef __KERNEL__
+static bool mag_is_enabled(void)
+{
+	return true;
+}
+
+/* Locks and returns the magazines of the current core */
+static struct malloc_core_magazines *mag_lock(uint32_t *exceptions)
+{
+	struct malloc_core_magazines *cm = NULL;
+
+	*exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	cm = malloc_magazines + get_core_pos();
+	cpu_spin_lock(&cm->lock);
+
+	return cm;
+}
+
+static void mag_unlock(struct malloc_core_magazines *cm, uint32_t exceptions)
+{
+	cpu_spin_unlock(&cm->lock);
+	thread_unmask_exceptions(exceptions);
+}
+#else /*__KERNEL__*/
+static bool mag_enabled;
+
+static bool mag_is_enabled(void)
+{
+	return mag_enabled;
+}
+
+static struct malloc_core_magazines *mag_lock(uint32_t *exceptions)
+{
+	*exceptions = 0;
+	return malloc_magazines;
+}
+
+static void mag_unlock(struct malloc_core_magazines *cm __unused,
+		       uint32_t exceptions __unused)
+{
+}
+#endif /*__KERNEL__*/
+
+static void mag_refill(struct malloc_magazine *mag, int cl)
+{
+	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	bufsize bs = 0;
+	void *p = NULL;
+
+	raw_malloc_validate_pools(&malloc_ctx);
+
+	while (mag->count < MAG_BATCH) {
+		/*
+		 * A failure here isn't reported, the caller falls back to
+		 * a plain allocation if the magazine remains empty.
+		 */
+		p = bget(SizeQ, 0, MAG_CLASS_SIZE(cl), &malloc_ctx.poolset);
+		if (!p)
+			break;
+
+		bs = bget_buf_size(p);
+		tag_asan_free(p, bs);
+		mag->bufs[mag->count] = p;
+		mag->cached_bytes += bs + sizeof(struct bhead);
+		mag->count++;
+	}
+
+	malloc_unlock(&malloc_ctx, exceptions);
+}
+
+static void mag_flush(struct malloc_magazine *mag, size_t num)
+{
+	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	void *p = NULL;
+
+	raw_malloc_validate_pools(&malloc_ctx);
+
+	while (num && mag->count) {
+		mag->count--;
+		p = mag->bufs[mag->count];
+		mag->cached_bytes -= bget_buf_size(p) + sizeof(struct bhead);
+		brel(p, &malloc_ctx.poolset, false);
+		num--;
+	}
+
+	malloc_unlock(&malloc_ctx, exceptions);
+}
+
+static void *mag_alloc(size_t size)
+{
+	struct malloc_core_magazines *cm = NULL;
+	struct malloc_magazine *mag = NULL;
+	uint32_t exceptions = 0;
+	int cl = mag_alloc_class(size);
+	void *p = NULL;
+
+	if (cl < 0 || !mag_is_enabled())
+		return NULL;
+
+	cm = mag_lock(&exceptions);
+	mag = cm->mag + cl;
+
+	if (!mag->count)
+		mag_refill(mag, cl);
+
+	if (mag->count) {
+		mag->count--;
+		p = mag->bufs[mag->count];
+		mag->cached_bytes -= bget_buf_size(p) + sizeof(struct bhead);
+	}
+
+	mag_unlock(cm, exceptions);
+
+	if (p)
+		tag_asan_alloced(p, size);
+
+	return p;
+}
+
+/* Returns true if @ptr was put in a magazine */
+static bool mag_free(void *ptr)
+{
+	struct malloc_core_magazines *cm = NULL;
+	struct malloc_magazine *mag = NULL;
+	uint32_t exceptions = 0;
+	bufsize bs = bget_buf_size(ptr);
+	int cl = mag_buf_class(bs);
+
+	if (cl < 0 || !mag_is_enabled())
+		return false;
+
+	tag_asan_free(ptr, bs);
+
+	cm = mag_lock(&exceptions);
+	mag = cm->mag + cl;
+
+	if (mag->count == MAG_SIZE)
+		mag_flush(mag, MAG_BATCH);
+
+	mag->bufs[mag->count] = ptr;
+	mag->cached_bytes += bs + sizeof(struct bhead);
+	mag->count++;
+
+	mag_unlock(cm, exceptions);
+
+	return true;
+}
+
+/* Releases the buffers cached in the magazines of all cores to bget */
+#ifdef __KERNEL__
+static void mag_reclaim(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct malloc_core_magazines *cm = NULL;
+	size_t m = 0;
+	int n = 0;
+
+	for (m = 0; m < MAG_NUM_SETS; m++) {
+		cm = malloc_magazines + m;
+		cpu_spin_lock(&cm->lock);
+		for (n = 0; n < MAG_NUM_CLASSES; n++)
+			mag_flush(cm->mag + n, MAG_SIZE);
+		cpu_spin_unlock(&cm->lock);
+	}
+
+	thread_unmask_exceptions(exceptions);
+}
+#else /*__KERNEL__*/
+static void mag_reclaim(void)
+{
+	int n = 0;
+
+	for (n = 0; n < MAG_NUM_CLASSES; n++)
+		mag_flush(malloc_magazines->mag + n, MAG_SIZE);
+}
+#endif /*__KERNEL__*/
+
+static size_t mag_cached_bytes(void)
+{
+	size_t bytes = 0;
+	size_t m = 0;
+	int n = 0;
+
+	/* Only a snapshot, magazines of other cores may change meanwhile */
+	for (m = 0; m < MAG_NUM_SETS; m++)
+		for (n = 0; n < MAG_NUM_CLASSES; n++)
+			bytes += malloc_magazines[m].mag[n].cached_bytes;
+
+	return bytes;
+}
+#endif /*WITH_MAGAZINES*/
+
+#ifndef __KERNEL__
+void malloc_enable_magazines(void)
+{
+#ifdef WITH_MAGAZINES
+	mag_enabled = true;
+#endif
+}
+#endif
+
+static void gen_malloc_add_pool(struct malloc_ctx *ctx, void *buf, size_t len,
+				bool grown);
+
+#ifdef WITH_HEAP_GROW
+/*
+ * Pools added to malloc_ctx with the grow callback when an allocation
+ * fails. Such a pool is handed back with the shrink callback as soon as
+ * it's entirely free again.
+ */
+static const struct malloc_grow_ops *heap_grow_ops;
+static size_t heap_grown_pools;
+static bool heap_growing;
+
+void malloc_set_grow_ops(const struct malloc_grow_ops *ops)
+{
+	uint32_t exceptions = malloc_lock(&malloc_ctx);
+
+	heap_grow_ops = ops;
+	malloc_unlock(&malloc_ctx, exceptions);
+}
+
+/*
+ * Adds a pool able to hold an allocation of @size bytes aligned on
+ * @alignment, returns true if the allocation should be tried again.
+ */
+static bool __maybe_unused heap_grow(size_t size, size_t alignment)
+{
+	const struct malloc_grow_ops *ops = NULL;
+	uint32_t exceptions = 0;
+	size_t extra = 0;
+	size_t len = 0;
+	void *buf = NULL;
+
+	exceptions = malloc_lock(&malloc_ctx);
+	/*
+	 * The grow callback is likely to allocate from the heap itself,
+	 * such nested allocations must not try to grow the heap again.
+	 */
+	if (heap_growing || !heap_grow_ops) {
+		malloc_unlock(&malloc_ctx, exceptions);
+		return false;
+	}
+	heap_growing = true;
+	ops = heap_grow_ops;
+	/* Room for bget headers, alignment and the enlarged pool array */
+	extra = (malloc_ctx.pool_len + 1) * sizeof(struct malloc_pool) +
+		4 * sizeof(struct bfhead) + 2 * SizeQuant + alignment;
+	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!ADD_OVERFLOW(size, extra, &size))
+		buf = ops->grow(size, &len);
+	if (buf)
+		gen_malloc_add_pool(&malloc_ctx, buf, len, true);
+
+	exceptions = malloc_lock(&malloc_ctx);
+	heap_growing = false;
+	malloc_unlock(&malloc_ctx, exceptions);
+
+	return buf;
+}
+
+/*
+ * Called with malloc_ctx locked after @ptr has been released. If @ptr
+ * belonged to a grown pool which is now unused the pool is removed from
+ * malloc_ctx and returned in @pool.
+ */
+static bool __maybe_unused heap_take_idle_pool(void *ptr,
+					       struct malloc_pool *pool)
+{
+	struct malloc_pool *p = NULL;
+	struct bfhead *b = NULL;
+	size_t n = 0;
+
+	if (!heap_grown_pools || !ptr)
+		return false;
+
+	for (n = 0; n < malloc_ctx.pool_len; n++) {
+		p = malloc_ctx.pool + n;
+		if (!p->grown || (vaddr_t)ptr < (vaddr_t)p->buf ||
+		    (vaddr_t)ptr >= (vaddr_t)p->buf + p->len)
+			continue;
+
+		/* An unused pool consists of a single free buffer */
+		b = BFH(p->buf);
+		if (b->bh.bsize != (bufsize)(p->len - sizeof(struct bhead)))
+			return false;
+
+		b->ql.blink->ql.flink = b->ql.flink;
+		b->ql.flink->ql.blink = b->ql.blink;
+
+		*pool = *p;
+		malloc_ctx.pool_len--;
+		memmove(p, p + 1, (malloc_ctx.pool_len - n) * sizeof(*p));
+#ifdef BufStats
+		malloc_ctx.mstats.size -= pool->len;
+#endif
+		heap_grown_pools--;
+		return true;
+	}
+
+	return false;
+}
+
+static void __maybe_unused heap_shrink(struct malloc_pool *pool)
+{
+	heap_grow_ops->shrink(pool->buf, pool->len);
+}
+#else /*WITH_HEAP_GROW*/
+static bool __maybe_unused heap_grow(size_t size __unused,
+				     size_t alignment __unused)
+{
+	return false;
+}
+
+static bool __maybe_unused heap_take_idle_pool(void *ptr __unused,
+					       struct malloc_pool *pool __unused)
+{
+	return false;
+}
+
+static void __maybe_unused heap_shrink(struct malloc_pool *pool __unused)
+{
+}
+#endif /*WITH_HEAP_GROW*/
+
 #ifdef ENABLE_MDBG
 
 struct mdbg_hdr {
@@ -689,28 +1143,91 @@ void mdbg_check(int bufdump)
 void *malloc(size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
+
+#ifdef WITH_MAGAZINES
+	p = mag_alloc(size);
+	if (p)
+		goto out;
+#endif
 
+	exceptions = malloc_lock(&malloc_ctx);
 	p = raw_malloc(0, 0, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+#ifdef WITH_MAGAZINES
+	if (!p) {
+		/* Give back what is cached in all magazines and try again */
+		mag_reclaim();
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_malloc(0, 0, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
+#endif
+
+	if (!p && heap_grow(size, SizeQ)) {
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_malloc(0, 0, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
+#ifdef WITH_MAGAZINES
+out:
+#endif
+	PROF_ALLOC(p, size);
+
 	return p;
 }
 
 static void free_helper(void *ptr, bool wipe)
 {
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	struct malloc_pool idle_pool = { };
+	bool idle = false;
+	uint32_t exceptions;
+
+	malloc_prof_free(ptr);
+
+#ifdef WITH_MAGAZINES
+	/* Buffers to be wiped are released to bget which does the wiping */
+	if (ptr && !wipe && mag_free(ptr))
+		return;
+#endif
 
+	exceptions = malloc_lock(&malloc_ctx);
 	raw_free(ptr, &malloc_ctx, wipe);
+	idle = heap_take_idle_pool(ptr, &idle_pool);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (idle)
+		heap_shrink(&idle_pool);
 }
 
 void *calloc(size_t nmemb, size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
+	size_t s = 0;
+
+#ifdef WITH_MAGAZINES
+	if (!MUL_OVERFLOW(nmemb, size, &s)) {
+		p = mag_alloc(s);
+		if (p) {
+			PROF_ALLOC(p, s);
+			return memset(p, 0, s);
+		}
+	}
+#endif
 
+	exceptions = malloc_lock(&malloc_ctx);
 	p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!p && !MUL_OVERFLOW(nmemb, size, &s) && s && heap_grow(s, SizeQ)) {
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
+	PROF_ALLOC(p, nmemb * size);
+
 	return p;
 }
 
@@ -727,6 +1244,17 @@ void *realloc(void *ptr, size_t size)
 
 	p = realloc_unlocked(&malloc_ctx, ptr, size);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!p && size && heap_grow(size, SizeQ)) {
+		exceptions = malloc_lock(&malloc_ctx);
+		p = realloc_unlocked(&malloc_ctx, ptr, size);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
+	if (p) {
+		malloc_prof_free(ptr);
+		PROF_ALLOC(p, size);
+	}
+
 	return p;
 }
 
@@ -737,6 +1265,15 @@ void *memalign(size_t alignment, size_t size)
 
 	p = raw_memalign(0, 0, alignment, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!p && alignment && IS_POWER_OF_TWO(alignment) &&
+	    heap_grow(size, alignment)) {
+		exceptions = malloc_lock(&malloc_ctx);
+		p = raw_memalign(0, 0, alignment, size, &malloc_ctx);
+		malloc_unlock(&malloc_ctx, exceptions);
+	}
+	PROF_ALLOC(p, size);
+
 	return p;
 }
 
@@ -758,7 +1295,8 @@ void free_wipe(void *ptr)
 	free_helper(ptr, true);
 }
 
-static void gen_malloc_add_pool(struct malloc_ctx *ctx, void *buf, size_t len)
+static void gen_malloc_add_pool(struct malloc_ctx *ctx, void *buf, size_t len,
+				bool grown __maybe_unused)
 {
 	void *p;
 	size_t l;
@@ -789,6 +1327,13 @@ static void gen_malloc_add_pool(struct malloc_ctx *ctx, void *buf, size_t len)
 	ctx->pool = p;
 	ctx->pool[ctx->pool_len].buf = (void *)start;
 	ctx->pool[ctx->pool_len].len = end - start;
+	ctx->pool[ctx->pool_len].grown = false;
+#ifdef WITH_HEAP_GROW
+	if (grown) {
+		ctx->pool[ctx->pool_len].grown = true;
+		heap_grown_pools++;
+	}
+#endif
 #ifdef BufStats
 	ctx->mstats.size += ctx->pool[ctx->pool_len].len;
 #endif
@@ -865,7 +1410,7 @@ out:
 
 void malloc_add_pool(void *buf, size_t len)
 {
-	gen_malloc_add_pool(&malloc_ctx, buf, len);
+	gen_malloc_add_pool(&malloc_ctx, buf, len, false);
 }
 
 bool malloc_buffer_is_within_alloced(void *buf, size_t len)
@@ -970,7 +1515,7 @@ void nex_free(void *ptr)
 
 void nex_malloc_add_pool(void *buf, size_t len)
 {
-	gen_malloc_add_pool(&nex_malloc_ctx, buf, len);
+	gen_malloc_add_pool(&nex_malloc_ctx, buf, len, false);
 }
 
 bool nex_malloc_buffer_is_within_alloced(void *buf, size_t len)
@@ -61,6 +61,36 @@ bool malloc_buffer_overlaps_heap(void *buf, size_t len);
  */
 void malloc_add_pool(void *buf, size_t len);
 
+#ifndef __KERNEL__
+/*
+ * Enables the caches of free small buffers in front of the heap, see
+ * CFG_TA_MALLOC_MAGAZINE_SIZE. Does nothing if they're not supported.
+ */
+void malloc_enable_magazines(void);
+#endif
+
+#if defined(__KERNEL__) && defined(CFG_CORE_HEAP_GROW)
+/*
+ * struct malloc_grow_ops - callbacks lending memory to the heap
+ * @grow:	Called without any heap lock held when an allocation failed,
+ *		returns a buffer of at least @size bytes and its actual
+ *		length in @len, or NULL if no memory is available. The
+ *		buffer is added as a pool of the heap.
+ * @shrink:	Returns a buffer from @grow once the heap doesn't use any
+ *		part of it any longer.
+ */
+struct malloc_grow_ops {
+	void *(*grow)(size_t size, size_t *len);
+	void (*shrink)(void *buf, size_t len);
+};
+
+/*
+ * Registers callbacks used to grow the heap on demand. Allocations made
+ * by @ops->grow() are not allowed to grow the heap again.
+ */
+void malloc_set_grow_ops(const struct malloc_grow_ops *ops);
+#endif
+
 #ifdef CFG_WITH_STATS
 /*
  * Get/reset allocation statistics
@@ -18,6 +18,14 @@
 void
 qsort(void *aa, size_t n, size_t es, int (*cmp)(const void *, const void *));
 
+/*
+ * Stable sort with the same arguments as qsort(), allocates a temporary
+ * buffer of @n * @es bytes. Returns 0 on success or -1 if the buffer
+ * can't be allocated, in which case the array is unchanged.
+ */
+int mergesort(void *base, size_t n, size_t es,
+	      int (*cmp)(const void *, const void *));
+
 void abort(void) __noreturn;
 
 int abs(int i);
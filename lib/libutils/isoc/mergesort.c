@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
+ */
+
+/*
+ * Stable bottom-up merge sort: runs of RUN_LEN elements are sorted with
+ * an insertion sort and then merged pairwise, merges of runs which are
+ * already in order are skipped.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <util.h>
+
+#define RUN_LEN		8
+
+static void insertion_sort(char *a, size_t n, size_t es,
+			   int (*cmp)(const void *, const void *), char *t)
+{
+	char *end = a + n * es;
+	char *pm = NULL;
+	char *pl = NULL;
+
+	for (pm = a + es; pm < end; pm += es) {
+		if (cmp(pm - es, pm) <= 0)
+			continue;
+		memcpy(t, pm, es);
+		for (pl = pm - es; pl > a && cmp(pl - es, t) > 0; pl -= es)
+			;
+		memmove(pl + es, pl, pm - pl);
+		memcpy(pl, t, es);
+	}
+}
+
+/* Merges the sorted runs [lo, mid) and [mid, hi) using @t as scratch */
+static void merge(char *lo, char *mid, char *hi, size_t es,
+		  int (*cmp)(const void *, const void *), char *t)
+{
+	char *t_end = t + (mid - lo);
+	char *dst = lo;
+
+	memcpy(t, lo, mid - lo);
+	while (t < t_end && mid < hi) {
+		/* Take from the left run on equality to keep the sort stable */
+		if (cmp(mid, t) < 0) {
+			memcpy(dst, mid, es);
+			mid += es;
+		} else {
+			memcpy(dst, t, es);
+			t += es;
+		}
+		dst += es;
+	}
+	/* What's left of the right run is already in place */
+	memcpy(dst, t, t_end - t);
+}
+
+int mergesort(void *base, size_t n, size_t es,
+	      int (*cmp)(const void *, const void *))
+{
+	char *a = base;
+	size_t width = 0;
+	size_t lo = 0;
+	size_t sz = 0;
+	char *t = NULL;
+
+	if (n < 2 || !es)
+		return 0;
+
+	if (MUL_OVERFLOW(n, es, &sz))
+		return -1;
+	t = malloc(sz);
+	if (!t)
+		return -1;
+
+	for (lo = 0; lo < n; lo += RUN_LEN)
+		insertion_sort(a + lo * es, MIN(n - lo, (size_t)RUN_LEN), es,
+			       cmp, t);
+
+	for (width = RUN_LEN; width < n; width *= 2) {
+		for (lo = 0; lo < n - width; lo += 2 * width) {
+			char *pl = a + lo * es;
+			char *pm = pl + width * es;
+
+			if (cmp(pm - es, pm) <= 0)
+				continue;
+			merge(pl, pm, a + MIN(lo + 2 * width, n) * es, es, cmp,
+			      t);
+		}
+	}
+
+	free(t);
+
+	return 0;
+}
@@ -6,14 +6,21 @@ srcs-y += abs.c
 srcs-y += bcmp.c
 srcs-y += memchr.c
 srcs-y += memcmp.c
-srcs-y += memcpy.c
+# memcpy(), memmove() and memset() may be provided by ../arch/arm instead
+newlib-mem-c := y
+ifeq ($(CFG_ARM64_$(sm))-$(CFG_ULIBS_ARM64_MEM_ROUTINES),y-y)
+ifneq ($(sm),core)
+newlib-mem-c := n
+endif
+endif
+srcs-$(newlib-mem-c) += memcpy.c
 ifeq (s,$(CFG_CC_OPT_LEVEL))
 cflags-memcpy.c-y += -O2
 endif
 cflags-memcpy.c-y += $(call cc-option,-fno-tree-loop-distribute-patterns)
-srcs-y += memmove.c
+srcs-$(newlib-mem-c) += memmove.c
 cflags-memmove.c-y += $(call cc-option,-fno-tree-loop-distribute-patterns)
-srcs-y += memset.c
+srcs-$(newlib-mem-c) += memset.c
 cflags-memset.c-y += $(call cc-option,-fno-tree-loop-distribute-patterns)
 srcs-y += strchr.c
 srcs-y += strcmp.c
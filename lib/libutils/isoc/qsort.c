@@ -1,151 +1,242 @@
-// SPDX-License-Identifier: BSD-3-Clause
-/*	$OpenBSD: qsort.c,v 1.10 2005/08/08 08:05:37 espie Exp $ */
-/*-
- * Copyright (c) 1992, 1993
- *	The Regents of the University of California.  All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. Neither the name of the University nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
- * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
- * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
- * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
- * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
- * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
- * SUCH DAMAGE.
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2021, Linaro Limited
  */
-#include <sys/types.h>
-#include <stdlib.h>
-static __inline char
-	*med3(char *, char *, char *, int (*)(const void *, const void *));
-static __inline void	 swapfunc(char *, char *, int, int);
-#define min(a, b)	(a) < (b) ? a : b
+
 /*
- * Qsort routine from Bentley & McIlroy's "Engineering a Sort Function".
+ * Introsort: Bentley & McIlroy's quicksort ("Engineering a Sort Function")
+ * with a three-way partition around a median of three or a ninther,
+ * falling back to heapsort when the recursion gets too deep so that the
+ * worst case stays O(n log n). Small partitions are finished with an
+ * insertion sort, elements are swapped a long at a time when their size
+ * and alignment permit it.
  */
-#define swapcode(TYPE, parmi, parmj, n) { 		\
-		long i = (n) / sizeof (TYPE); 			\
-		TYPE *pi = (TYPE *) (parmi); 			\
-		TYPE *pj = (TYPE *) (parmj); 			\
-		do { 						\
-			TYPE	t = *pi;			\
-			*pi++ = *pj;				\
-			*pj++ = t;				\
-		} while (--i > 0);				\
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <util.h>
+
+#define INSERTION_SORT_MAX	12
+
+enum swap_type {
+	SWAP_ONE_LONG,
+	SWAP_LONGS,
+	SWAP_BYTES,
+};
+
+struct sort_ctx {
+	size_t es;
+	enum swap_type swap_type;
+	int (*cmp)(const void *, const void *);
+};
+
+static void swap(const struct sort_ctx *ctx, char *a, char *b, size_t n)
+{
+	long t = 0;
+	char c = 0;
+
+	if (ctx->swap_type == SWAP_BYTES) {
+		for (; n; n--, a++, b++) {
+			c = *a;
+			*a = *b;
+			*b = c;
+		}
+		return;
+	}
+
+	for (; n; n -= sizeof(long), a += sizeof(long), b += sizeof(long)) {
+		t = *(long *)a;
+		*(long *)a = *(long *)b;
+		*(long *)b = t;
+	}
 }
-#define SWAPINIT(a, es) swaptype = ((char *)a - (char *)0) % sizeof(long) || \
-		es % sizeof(long) ? 2 : es == sizeof(long)? 0 : 1;
-static __inline void
-swapfunc(char *a, char *b, int n, int swaptype)
+
+static void swap_elem(const struct sort_ctx *ctx, char *a, char *b)
 {
-	if (swaptype <= 1)
-		swapcode(long, a, b, n)
-		else
-			swapcode(char, a, b, n)
+	long t = 0;
+
+	if (ctx->swap_type == SWAP_ONE_LONG) {
+		t = *(long *)a;
+		*(long *)a = *(long *)b;
+		*(long *)b = t;
+	} else {
+		swap(ctx, a, b, ctx->es);
+	}
 }
-#define swap(a, b)					\
-		if (swaptype == 0) {				\
-			long t = *(long *)(a);			\
-			*(long *)(a) = *(long *)(b);		\
-			*(long *)(b) = t;			\
-		} else						\
-		swapfunc(a, b, es, swaptype)
-#define vecswap(a, b, n) 	if ((n) > 0) swapfunc(a, b, n, swaptype)
-static __inline char *
-med3(char *a, char *b, char *c, int (*cmp)(const void *, const void *))
+
+static char *med3(const struct sort_ctx *ctx, char *a, char *b, char *c)
 {
-	return cmp(a, b) < 0 ?
-			(cmp(b, c) < 0 ? b : (cmp(a, c) < 0 ? c : a ))
-			:(cmp(b, c) > 0 ? b : (cmp(a, c) < 0 ? a : c ));
+	if (ctx->cmp(a, b) < 0) {
+		if (ctx->cmp(b, c) < 0)
+			return b;
+		return ctx->cmp(a, c) < 0 ? c : a;
+	}
+	if (ctx->cmp(b, c) > 0)
+		return b;
+	return ctx->cmp(a, c) < 0 ? a : c;
 }
-void
-qsort(void *aa, size_t n, size_t es, int (*cmp)(const void *, const void *))
+
+static void insertion_sort(const struct sort_ctx *ctx, char *a, size_t n)
 {
-	char *pa, *pb, *pc, *pd, *pl, *pm, *pn;
-	int d, r, swaptype, swap_cnt;
-	char *a = aa;
-	loop:	SWAPINIT(a, es);
-	swap_cnt = 0;
-	if (n < 7) {
-		for (pm = (char *)a + es; pm < (char *) a + n * es; pm += es)
-			for (pl = pm; pl > (char *) a && cmp(pl - es, pl) > 0;
-					pl -= es)
-				swap(pl, pl - es);
-		return;
+	char *end = a + n * ctx->es;
+	char *pm = NULL;
+	char *pl = NULL;
+
+	for (pm = a + ctx->es; pm < end; pm += ctx->es)
+		for (pl = pm; pl > a && ctx->cmp(pl - ctx->es, pl) > 0;
+		     pl -= ctx->es)
+			swap_elem(ctx, pl, pl - ctx->es);
+}
+
+static void sift_down(const struct sort_ctx *ctx, char *a, size_t root,
+		      size_t n)
+{
+	size_t child = 0;
+
+	while (root < n / 2) {
+		child = 2 * root + 1;
+		if (child + 1 < n &&
+		    ctx->cmp(a + child * ctx->es, a + (child + 1) * ctx->es) < 0)
+			child++;
+		if (ctx->cmp(a + root * ctx->es, a + child * ctx->es) >= 0)
+			return;
+		swap_elem(ctx, a + root * ctx->es, a + child * ctx->es);
+		root = child;
 	}
-	pm = (char *)a + (n / 2) * es;
-	if (n > 7) {
-		pl = (char *)a;
-		pn = (char *)a + (n - 1) * es;
-		if (n > 40) {
-			d = (n / 8) * es;
-			pl = med3(pl, pl + d, pl + 2 * d, cmp);
-			pm = med3(pm - d, pm, pm + d, cmp);
-			pn = med3(pn - 2 * d, pn - d, pn, cmp);
-		}
-		pm = med3(pl, pm, pn, cmp);
+}
+
+static void heap_sort(const struct sort_ctx *ctx, char *a, size_t n)
+{
+	size_t i = n / 2;
+
+	while (i)
+		sift_down(ctx, a, --i, n);
+
+	for (i = n - 1; i; i--) {
+		swap_elem(ctx, a, a + i * ctx->es);
+		sift_down(ctx, a, 0, i);
 	}
-	swap(a, pm);
-	pa = pb = (char *)a + es;
-
-	pc = pd = (char *)a + (n - 1) * es;
-	for (;;) {
-		while (pb <= pc && (r = cmp(pb, a)) <= 0) {
-			if (r == 0) {
-				swap_cnt = 1;
-				swap(pa, pb);
-				pa += es;
-			}
-			pb += es;
+}
+
+/* Moves the pivot to the first element */
+static void select_pivot(const struct sort_ctx *ctx, char *a, size_t n)
+{
+	char *pl = a;
+	char *pm = a + (n / 2) * ctx->es;
+	char *pn = a + (n - 1) * ctx->es;
+	size_t d = 0;
+
+	if (n > 40) {
+		d = (n / 8) * ctx->es;
+		pl = med3(ctx, pl, pl + d, pl + 2 * d);
+		pm = med3(ctx, pm - d, pm, pm + d);
+		pn = med3(ctx, pn - 2 * d, pn - d, pn);
+	}
+	pm = med3(ctx, pl, pm, pn);
+	swap_elem(ctx, a, pm);
+}
+
+static void introsort(const struct sort_ctx *ctx, char *a, size_t n,
+		      unsigned int depth)
+{
+	size_t es = ctx->es;
+	char *pa = NULL;
+	char *pb = NULL;
+	char *pc = NULL;
+	char *pd = NULL;
+	char *pn = NULL;
+	size_t nl = 0;
+	size_t nr = 0;
+	size_t r = 0;
+	int res = 0;
+
+	while (n > INSERTION_SORT_MAX) {
+		if (!depth) {
+			heap_sort(ctx, a, n);
+			return;
 		}
-		while (pb <= pc && (r = cmp(pc, a)) >= 0) {
-			if (r == 0) {
-				swap_cnt = 1;
-				swap(pc, pd);
-				pd -= es;
+		depth--;
+
+		select_pivot(ctx, a, n);
+
+		/*
+		 * Elements equal to the pivot are gathered at both ends,
+		 * [a, pa) and (pd, pn), smaller ones in [pa, pb) and larger
+		 * ones in (pc, pd].
+		 */
+		pa = a + es;
+		pb = pa;
+		pc = a + (n - 1) * es;
+		pd = pc;
+		while (true) {
+			while (pb <= pc && (res = ctx->cmp(pb, a)) <= 0) {
+				if (!res) {
+					swap_elem(ctx, pa, pb);
+					pa += es;
+				}
+				pb += es;
 			}
+			while (pb <= pc && (res = ctx->cmp(pc, a)) >= 0) {
+				if (!res) {
+					swap_elem(ctx, pc, pd);
+					pd -= es;
+				}
+				pc -= es;
+			}
+			if (pb > pc)
+				break;
+			swap_elem(ctx, pb, pc);
+			pb += es;
 			pc -= es;
 		}
-		if (pb > pc)
-			break;
-		swap(pb, pc);
-		swap_cnt = 1;
-		pb += es;
-		pc -= es;
+
+		/* Move the elements equal to the pivot to the middle */
+		pn = a + n * es;
+		r = MIN((size_t)(pa - a), (size_t)(pb - pa));
+		if (r)
+			swap(ctx, a, pb - r, r);
+		r = MIN((size_t)(pd - pc), (size_t)(pn - pd) - es);
+		if (r)
+			swap(ctx, pb, pn - r, r);
+
+		nl = (pb - pa) / es;
+		nr = (pd - pc) / es;
+
+		/* Recurse into the smaller side to bound the stack usage */
+		if (nl < nr) {
+			introsort(ctx, a, nl, depth);
+			a = pn - nr * es;
+			n = nr;
+		} else {
+			introsort(ctx, pn - nr * es, nr, depth);
+			n = nl;
+		}
 	}
-	if (swap_cnt == 0) {  /* Switch to insertion sort */
-		for (pm = (char *) a + es; pm < (char *) a + n * es; pm += es)
-			for (pl = pm; pl > (char *) a && cmp(pl - es, pl) > 0;
-					pl -= es)
-				swap(pl, pl - es);
+
+	insertion_sort(ctx, a, n);
+}
+
+void qsort(void *aa, size_t n, size_t es,
+	   int (*cmp)(const void *, const void *))
+{
+	struct sort_ctx ctx = { .es = es, .cmp = cmp };
+	unsigned int depth = 0;
+	size_t m = 0;
+
+	if (n < 2 || !es)
 		return;
-	}
-	pn = (char *)a + n * es;
-	r = min(pa - (char *)a, pb - pa);
-	vecswap(a, pb - r, r);
-	r = min(pd - pc, pn - pd - (int)es);
-	vecswap(pb, pn - r, r);
-	if ((r = pb - pa) > (int)es)
-		qsort(a, r / es, es, cmp);
-	if ((r = pd - pc) > (int)es) {
-		/* Iterate rather than recurse to save stack space */
-		a = pn - r;
-		n = r / es;
-		goto loop;
-	}
-	/* qsort(pn - r, r / es, es, cmp);*/
+
+	if ((uintptr_t)aa % sizeof(long) || es % sizeof(long))
+		ctx.swap_type = SWAP_BYTES;
+	else if (es == sizeof(long))
+		ctx.swap_type = SWAP_ONE_LONG;
+	else
+		ctx.swap_type = SWAP_LONGS;
+
+	/* Allow 2 * log2(n) levels of partitioning before heapsort */
+	for (m = n; m > 1; m >>= 1)
+		depth += 2;
+
+	introsort(&ctx, aa, n, depth);
 }
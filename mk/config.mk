@@ -84,6 +84,73 @@ CFG_TEE_TA_MALLOC_DEBUG ?= n
 # using malloc() and friends.
 CFG_CORE_DUMP_OOM ?= $(CFG_TEE_CORE_MALLOC_DEBUG)
 
+# Number of free small heap buffers cached per size class and per core in
+# front of the TEE core heap. Allocations and releases served from the cache
+# of the current core don't take the heap lock, which reduces contention when
+# many cores allocate concurrently, at the cost of some memory kept cached.
+# 0 disables the cache. Has no effect with CFG_TEE_CORE_MALLOC_DEBUG=y.
+CFG_CORE_MALLOC_MAGAZINE_SIZE ?= 0
+ifneq ($(CFG_CORE_MALLOC_MAGAZINE_SIZE),0)
+ifeq ($(CFG_TEE_CORE_NB_CORE),)
+$(error CFG_CORE_MALLOC_MAGAZINE_SIZE requires CFG_TEE_CORE_NB_CORE)
+endif
+endif
+
+# Number of free small heap buffers cached per size class in front of the
+# heap of a TA, same as CFG_CORE_MALLOC_MAGAZINE_SIZE but only used by TAs
+# with the TA_PROP_STR_MALLOC_SIZE_CLASSES property set, see
+# TA_MALLOC_SIZE_CLASSES. 0 removes the support from libutils.
+CFG_TA_MALLOC_MAGAZINE_SIZE ?= 16
+
+# Profile the TEE core heap by allocation site (return address of the call
+# to malloc() and friends) and by TA of the current session: allocation
+# counts, live and peak bytes, read with the stats pseudo TA. Up to
+# CFG_CORE_MALLOC_PROFILE_BLOCKS live buffers and
+# CFG_CORE_MALLOC_PROFILE_SITES sites are tracked, both powers of two.
+# Not supported with CFG_TEE_CORE_MALLOC_DEBUG=y which tracks file and line
+# instead.
+CFG_CORE_MALLOC_PROFILE ?= n
+CFG_CORE_MALLOC_PROFILE_BLOCKS ?= 4096
+CFG_CORE_MALLOC_PROFILE_SITES ?= 256
+ifeq ($(CFG_CORE_MALLOC_PROFILE)-$(CFG_TEE_CORE_MALLOC_DEBUG),y-y)
+$(error CFG_CORE_MALLOC_PROFILE and CFG_TEE_CORE_MALLOC_DEBUG are exclusive)
+endif
+
+# Manages the TA RAM, shared memory and pager virtual memory pools with a
+# bitmap of free blocks and a tree of free extents instead of a list of
+# allocated entries, see TEE_MM_POOL_BITMAP. Allocation, release and lookup
+# of entries then scale with the logarithm of the pool size rather than
+# with the number of entries, at the cost of a few bits per block of the
+# pool.
+CFG_CORE_TEE_MM_BITMAP ?= n
+
+# Map physically contiguous and suitably aligned parts of registered and
+# FF-A shared memory with block mappings of CORE_MMU_PGDIR_SIZE (2 MiB
+# with LPAE, 1 MiB otherwise) instead of small pages, saving translation
+# tables and TLB entries for large buffers.
+CFG_CORE_MMU_SHM_BLOCK_MAP ?= n
+
+# Switch user mappings without invalidating the entire TLB. Entries of user
+# mappings are tagged with the ASID of their context, so switching only has
+# to invalidate the entries of the ASID being switched to on the local core,
+# and only if the translation tables of the context were rebuilt since that
+# core last did so. Global core mappings stay in the TLB.
+CFG_CORE_MMU_LAZY_TLBI ?= n
+
+# Number of registered shared memory objects kept mapped in core virtual
+# memory when no longer used, so that a client passing the same buffer
+# again doesn't get it mapped and unmapped on each invoke. Idle mappings
+# are dropped when the shared memory virtual space runs out or when the
+# buffer is unregistered. 0 unmaps buffers as soon as they're unused.
+CFG_CORE_REG_SHM_MAP_CACHE ?= 8
+
+# Number of released non-contiguous shared memory objects, typically from
+# temporary memory references, kept for reuse by a later memory reference
+# with the exact same list of pages. This saves allocating the object and
+# checking its pages, and together with CFG_CORE_REG_SHM_MAP_CACHE mapping
+# them. 0 frees the objects when released.
+CFG_CORE_REG_SHM_FREE_CACHE ?= 8
+
 # Mask to select which messages are prefixed with long debugging information
 # (severity, core ID, thread ID, component name, function name, line number)
 # based on the message level. If BIT(level) is set, the long prefix is shown.
@@ -97,9 +164,54 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Otherwise, you need to implement hw_get_random_byte() for your platform
 CFG_WITH_SOFTWARE_PRNG ?= y
 
+# Size in bytes of the per-core buffer of pre-generated random bytes used by
+# the software PRNG to serve small requests, up to a quarter of the buffer,
+# without taking the global PRNG lock. Bytes are wiped from the buffer as
+# soon as they are handed out. 0 disables the buffers.
+CFG_CRYPTO_RNG_PCPU_BUF_SIZE ?= 256
+
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
+# Number of threads per core
+# When set, CFG_NUM_THREADS is derived from CFG_NUM_THREADS_PER_CORE and
+# CFG_TEE_CORE_NB_CORE so that the number of threads scales with the number
+# of cores instead of being fixed by the platform.
+CFG_NUM_THREADS_PER_CORE ?=
+ifneq ($(CFG_NUM_THREADS_PER_CORE),)
+ifeq ($(CFG_TEE_CORE_NB_CORE),)
+$(error CFG_NUM_THREADS_PER_CORE requires CFG_TEE_CORE_NB_CORE)
+endif
+CFG_NUM_THREADS := $(shell echo $$(($(CFG_NUM_THREADS_PER_CORE) * \
+						$(CFG_TEE_CORE_NB_CORE))))
+endif
+
+# Gives each thread its own arena in the scratch memory pool used for big
+# number computations and temporary file system blocks, so crypto on
+# different threads doesn't serialize on the shared pool. Costs
+# CFG_NUM_THREADS times the memory of the shared pool.
+CFG_CORE_MEMPOOL_PER_THREAD ?= n
+
+# Per-core pools of free threads
+# When enabled, each core allocates threads for standard calls from its own
+# pool of free threads and only steals from the pools of other cores when
+# its own pool is empty. This avoids serializing all cores on the global
+# thread lock when entering with standard calls on systems with many cores.
+CFG_CORE_THREAD_POOL_PER_CORE ?= n
+
+# Report to normal world, in the resume information of RPCs, the core a
+# suspended thread is preferably resumed on: the one it was suspended on
+# which likely still caches its stack and data. Only done if normal world
+# asks for it with OPTEE_SMC_NSEC_CAP_RPC_AFFINITY.
+CFG_CORE_RPC_AFFINITY ?= y
+
+# Largest amount of data, in bytes, passed to the crypto implementation in
+# one call by the cipher and authenticated encryption update system calls.
+# Bigger TA buffers are processed in place in chunks of up to this size,
+# which bounds the time spent with foreign interrupts masked by accelerated
+# implementations using the VFP unit. Must be a multiple of 64.
+CFG_CORE_CRYPTO_UPDATE_CHUNK_SIZE ?= 0x10000
+
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
 
@@ -139,6 +251,41 @@ CFG_TEE_FW_MANUFACTURER ?= FW_MAN_UNDEF
 # TEE_STORAGE_PRIVATE is passed to the trusted storage API)
 CFG_REE_FS ?= y
 
+# Number of decrypted data blocks of the REE FS cached in secure memory for
+# each open file. Cached blocks are read from normal world and decrypted
+# once, written blocks are encrypted and written back when evicted or when
+# the file is committed. Each entry takes a 4 kB block of heap memory,
+# caching is disabled when set to 0.
+CFG_REE_FS_BLOCK_CACHE_SIZE ?= 0
+
+# Number of children of each node in the hash tree of REE FS files created
+# from now on, 2 to 14. A larger fanout makes a tree shallower so that
+# fewer nodes are rewritten when a file is committed. Files created with a
+# fanout up to this value can be opened, files created with a fanout of 2
+# before this option existed included.
+CFG_REE_FS_HTREE_FANOUT ?= 2
+
+# When enabled, the data blocks of REE FS objects opened or created with
+# TEE_DATA_FLAG_COMPRESS are compressed one by one with the LZ format of
+# core/lib/lz before they are encrypted, blocks which don't compress are
+# stored as is. Only the compressed bytes are encrypted and decrypted.
+# Blocks written this way can't be read by a core built without it.
+CFG_REE_FS_COMPRESS ?= n
+
+# When enabled, the blocks and hash tree nodes written when a REE FS file is
+# committed are sent to tee-supplicant in as few OPTEE_RPC_FS_WRITEV
+# requests as possible instead of one request each. Requires a
+# tee-supplicant supporting OPTEE_RPC_FS_WRITEV.
+CFG_REE_FS_RPC_WRITEV ?= n
+
+# When enabled, the hash trees of the REE FS and RPMB FS files are encrypted
+# and authenticated with ChaCha20-Poly1305 instead of AES-GCM, which is much
+# faster on cores without the Cryptographic Extensions. The 128-bit file
+# encryption keys are used with the 128-bit key variant of ChaCha20 and the
+# first 12 bytes of the stored IVs. Files written with this option can't be
+# read by a core built without it and the other way around.
+CFG_REE_FS_HTREE_CHACHA20_POLY1305 ?= n
+
 # RPMB file system support
 CFG_RPMB_FS ?= n
 
@@ -180,6 +327,46 @@ CFG_RPMB_FS_RD_ENTRIES ?= 8
 # in case the cache is too small to hold all elements when traversing.
 CFG_RPMB_FS_CACHE_ENTRIES ?= 0
 
+# When enabled, all FAT FS entries are read in once and kept in memory,
+# indexed by filename. Opening, removing or renaming a file then doesn't read
+# in the FAT from RPMB storage, neither does allocating space for a file or
+# listing a directory. Requires the number of FAT FS entries times
+# sizeof(struct rpmb_fat_entry) bytes of heap memory, and makes
+# CFG_RPMB_FS_CACHE_ENTRIES unneeded.
+CFG_RPMB_FS_FAT_INDEX ?= n
+
+# Maximum number of RPMB data frames requested by a single authenticated read.
+# Larger reads are split into several requests sharing the same RPC buffers.
+# No limit when set to 0, a read is then always a single request.
+CFG_RPMB_FS_RD_MAX_BLOCKS ?= 0
+
+# When enabled, authenticated writes use as many frames per request as the
+# eMMC reliable write sector count reported by the device allows, instead of
+# one frame per request. Requires an RPMB driver in normal world supporting
+# multi-block reliable writes.
+CFG_RPMB_FS_MULTI_BLOCK_WRITE ?= n
+
+# Maximum number of bytes of spare room reserved after the data of a file
+# stored in RPMB when it's moved to grow. The spare room is as large as the
+# data up to this limit, so that appending to the file then only writes the
+# new data and the FAT entry instead of copying the whole file again. Spare
+# room is only reserved if there's space enough left. Disabled when set to 0.
+CFG_RPMB_FS_PREALLOC_MAX ?= 4096
+
+# Number of persistent object headers and attributes cached in secure memory
+# once authenticated, so that opening again the same object doesn't read and
+# decrypt them from storage. Caching is disabled when set to 0. Each entry
+# takes up to about 4 kB of heap memory, objects with larger attributes are
+# not cached.
+CFG_STORAGE_HEAD_CACHE_ENTRIES ?= 0
+
+# Number of secure storage keys cached in secure memory: the storage keys
+# derived for each TA (TSK) and the file encryption keys (FEK) once
+# decrypted, so that opening a file doesn't derive and unwrap them again.
+# The keys of a TA are wiped when its context is destroyed. Caching is
+# disabled when set to 0.
+CFG_FS_KEY_CACHE_ENTRIES ?= 0
+
 # Enables RPMB key programming by the TEE, in case the RPMB partition has not
 # been configured yet.
 # !!! Security warning !!!
@@ -285,6 +472,19 @@ CFG_REE_FS_TA ?= y
 CFG_REE_FS_TA_BUFFERED ?= n
 $(eval $(call cfg-depends-all,CFG_REE_FS_TA_BUFFERED,CFG_REE_FS_TA))
 
+# With CFG_REE_FS_TA_BUFFERED=y, keep up to CFG_REE_FS_TA_CACHE_SIZE bytes
+# of verified TA binaries in the "Secure DDR" pool once loaded, so further
+# instances of a TA are loaded without RPC and signature verification. The
+# least recently used binaries are evicted first, a TA installed with the
+# secstor_ta_mgmt pseudo TA is evicted. 0 disables the cache.
+CFG_REE_FS_TA_CACHE_SIZE ?= 0
+
+# Number of idle instances of a multi-instance TA built with
+# TA_FLAG_INSTANCE_POOL kept loaded once their last session is closed. The
+# next session to such a TA reuses an idle instance, skipping loading,
+# relocation and TA_CreateEntryPoint(). 0 disables the pool.
+CFG_TA_INSTANCE_POOL_SIZE ?= 0
+
 # Support for loading user TAs from a special section in the TEE binary.
 # Such TAs are available even before tee-supplicant is available (hence their
 # name), but note that many services exported to TAs may need tee-supplicant,
@@ -328,9 +528,25 @@ $(call force,CFG_ZLIB,y)
 endif
 CFG_EARLY_TA_COMPRESS ?= y
 
+# With CFG_EARLY_TA_COMPRESS_LZ=y the early TAs are compressed in independent
+# 4 KiB blocks with the LZ format of core/lib/lz instead of DEFLATE. The
+# compression ratio is lower, but decompression is much faster and only the
+# blocks actually read by the loader are decompressed.
+CFG_EARLY_TA_COMPRESS_LZ ?= n
+ifeq ($(CFG_EARLY_TA_COMPRESS_LZ)-$(CFG_EARLY_TA_COMPRESS),y-n)
+$(error CFG_EARLY_TA_COMPRESS_LZ=y requires CFG_EARLY_TA_COMPRESS=y)
+endif
+
 # Enable paging, requires SRAM, can't be enabled by default
 CFG_WITH_PAGER ?= n
 
+# With CFG_CORE_PAGER_LAZY_HASH_CHECK=y only the hashes of the init part of
+# the pageable area are checked at boot, the remaining pages are checked by
+# the pager when they are loaded, as every paged read-only page is. This
+# shortens boot at the cost of detecting a corrupted page only when it's
+# first used.
+CFG_CORE_PAGER_LAZY_HASH_CHECK ?= n
+
 # Runtime lock dependency checker: ensures that a proper locking hierarchy is
 # used in the TEE core when acquiring and releasing mutexes. Any violation will
 # cause a panic as soon as the invalid locking condition is detected. If
@@ -348,6 +564,62 @@ CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
+# Gives pages of the pager a second chance before they're evicted: a page
+# which was accessed again after having been hidden is kept once more when
+# it's the oldest page, keeping the working set of active TAs resident
+# when paging memory is scarce.
+CFG_PAGER_SECOND_CHANCE ?= n
+
+# Maximum number of pages the pager loads ahead when consecutive pages of a
+# read-only area fault one after another, for instance while TA or paged
+# core code is executed or a large table is scanned linearly. Each page
+# loaded ahead saves an abort. 0 disables read-ahead.
+CFG_PAGER_READ_AHEAD_PAGES ?= 0
+
+# Compress the pages of read/write paged memory, that is TA memory with
+# CFG_PAGED_USER_TA=y, before they are encrypted into the backing store.
+# Instead of reserving one page of TA RAM for each such page the
+# compressed pages share a store of CFG_PAGER_RWP_COMPRESS_STORE_SIZE
+# bytes, which must be large enough for all pages evicted at the same
+# time.
+CFG_PAGER_RWP_COMPRESS ?= n
+CFG_PAGER_RWP_COMPRESS_STORE_SIZE ?= 0x100000
+ifeq ($(CFG_PAGER_RWP_COMPRESS)-$(CFG_WITH_PAGER),y-n)
+$(error CFG_PAGER_RWP_COMPRESS=y requires CFG_WITH_PAGER=y)
+endif
+
+# Count the faults loading read-only pages of the core by faulting
+# address, in a table of CFG_CORE_PAGER_FAULT_LOG_ENTRIES entries (a power
+# of two) exposed by the stats pseudo TA. scripts/gen_text_order.py turns
+# the counts into a list of the hot functions for CFG_CORE_PAGED_TEXT_ORDER.
+CFG_CORE_PAGER_FAULT_LOG ?= n
+CFG_CORE_PAGER_FAULT_LOG_ENTRIES ?= 512
+ifeq ($(CFG_CORE_PAGER_FAULT_LOG)-$(CFG_WITH_PAGER),y-n)
+$(error CFG_CORE_PAGER_FAULT_LOG=y requires CFG_WITH_PAGER=y)
+endif
+
+# Path to a file of linker input section descriptions, one per line such
+# as "*(.text.foo)", placed first in the pageable core text in that order.
+# Listing the hot functions together packs the paged working set of the
+# core in fewer pages. Empty keeps the default link order.
+CFG_CORE_PAGED_TEXT_ORDER ?=
+
+# With CFG_PAGED_USER_TA, maximum number of page tables saved per TA context
+# while the context is unmapped. Limiting the number of tables a single TA
+# can keep leaves more tables for other TAs so tables saved by a TA are less
+# likely to be evicted before the TA is mapped again. 0 means no limit.
+CFG_PGT_CACHE_CTX_TABLES ?= 0
+
+# Lend private memory of a TA invoking another TA to the called TA instead
+# of copying it to and from a temporary buffer. Only memrefs made of whole
+# pages are lent, input memrefs are mapped read-only into the called TA.
+# The pages are mapped into the called TA for the duration of the call,
+# the calling TA must not expect anything else in them to stay private.
+CFG_TA_LEND_PRIV_MEMREF ?= n
+ifeq ($(CFG_TA_LEND_PRIV_MEMREF)-$(CFG_PAGED_USER_TA),y-y)
+$(error CFG_TA_LEND_PRIV_MEMREF=y requires CFG_PAGED_USER_TA=n)
+endif
+
 # Enable support for detected undefined behavior in C
 # Uses a lot of memory, can't be enabled by default
 CFG_CORE_SANITIZE_UNDEFINED ?= n
@@ -427,6 +699,14 @@ CFG_CORE_HEAP_SIZE ?= 65536
 # is enabled
 CFG_CORE_NEX_HEAP_SIZE ?= 16384
 
+# Lets the core heap borrow memory from the TA RAM pool when an allocation
+# fails, so CFG_CORE_HEAP_SIZE can be kept small while still surviving
+# peaks. Memory is borrowed in chunks of at least CFG_CORE_HEAP_GROW_SIZE
+# bytes and each chunk is returned as soon as the heap has freed all of it.
+# Not supported with CFG_VIRTUALIZATION where TA RAM belongs to the guests.
+CFG_CORE_HEAP_GROW ?= n
+CFG_CORE_HEAP_GROW_SIZE ?= 32768
+
 # TA profiling.
 # When this option is enabled, OP-TEE can execute Trusted Applications
 # instrumented with GCC's -pg flag and will output profiling information
@@ -456,6 +736,16 @@ CFG_FTRACE_BUF_WHEN_FULL ?= shift
 $(call cfg-check-value,FTRACE_BUF_WHEN_FULL,shift stop wrap)
 $(call force,_CFG_FTRACE_BUF_WHEN_FULL_$(CFG_FTRACE_BUF_WHEN_FULL),y)
 
+# Function tracing buffer format
+# 'text': function graph in ftrace.out format, formatted while tracing
+# 'binary': fixed size struct ftrace_rec records in a ring buffer, much
+#    cheaper to record. The records are sent to normal world each time the
+#    buffer is half full when an invocation returns, and when the session
+#    is closed. CFG_FTRACE_BUF_WHEN_FULL and CFG_FTRACE_US_MS don't apply.
+CFG_FTRACE_BUF_FORMAT ?= text
+$(call cfg-check-value,FTRACE_BUF_FORMAT,text binary)
+$(call force,_CFG_FTRACE_BUF_FORMAT_$(CFG_FTRACE_BUF_FORMAT),y)
+
 # Function tracing: unit to be used when displaying durations
 #  0: always display durations in microseconds
 # >0: if duration is greater or equal to the specified value (in microseconds),
@@ -541,6 +831,32 @@ CFG_CORE_DYN_SHM ?= y
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
 
+# Enable support for OPTEE_MSG_CMD_MULTI_INVOKE, invoking several TA
+# commands back-to-back in a single standard call to reduce the number of
+# world switches when issuing many small commands.
+CFG_CORE_MULTI_INVOKE ?= y
+
+# Enable support for a submission/completion ring in non-secure shared
+# memory registered with OPTEE_SMC_REGISTER_RING. Normal world posts invoke
+# requests in the ring and OPTEE_MSG_CMD_PROCESS_RING calls complete them,
+# allowing many requests in flight with few normal world threads blocked.
+# CFG_CORE_MSG_RING_NOTIF_IT, if non-zero, is a non-secure interrupt raised
+# each time a completion is posted.
+CFG_CORE_MSG_RING ?= n
+CFG_CORE_MSG_RING_NOTIF_IT ?= 0
+
+# Enable asynchronous notifications: normal world registers a bitmap of
+# pending notification values with OPTEE_SMC_REGISTER_NOTIF and secure
+# world sets bits in it and raises the non-secure interrupt
+# CFG_CORE_ASYNC_NOTIF_IT. Wait queue wakeups then don't need an RPC.
+CFG_CORE_ASYNC_NOTIF ?= n
+CFG_CORE_ASYNC_NOTIF_IT ?= 0
+ifeq ($(CFG_CORE_ASYNC_NOTIF),y)
+ifeq ($(CFG_CORE_ASYNC_NOTIF_IT),0)
+$(error CFG_CORE_ASYNC_NOTIF=y requires CFG_CORE_ASYNC_NOTIF_IT)
+endif
+endif
+
 # Enables support for larger physical addresses, that is, it will define
 # paddr_t as a 64-bit type.
 CFG_CORE_LARGE_PHYS_ADDR ?= n
@@ -582,9 +898,79 @@ CFG_CRYPTOLIB_DIR ?= core/lib/libtomcrypt
 # that would set = n.
 $(call force,CFG_CORE_MBEDTLS_MPI,y)
 
+# Use the assembly multiply-accumulate inner loops of the mbedTLS bignum
+# code, in the TEE core and in TAs respectively. This speeds up RSA, DH and
+# the Internal Core API arithmetical functions.
+CFG_CORE_MBEDTLS_MPI_ASM ?= y
+CFG_TA_MBEDTLS_MPI_ASM ?= $(CFG_CORE_MBEDTLS_MPI_ASM)
+
+# Collect statistics of the invocations of each TA command: count,
+# cumulated duration and latency histogram, time spent in RPC and waiting
+# for a busy TA. The statistics are exposed by the stats pseudo TA, at most
+# CFG_TA_INVOKE_STATS_ENTRIES (TA, command ID) pairs are tracked.
+CFG_TA_INVOKE_STATS ?= n
+CFG_TA_INVOKE_STATS_ENTRIES ?= 64
+
+# Soft limit in bytes of the private memory (code, data, heap and stacks)
+# a single TA context may map, mapping more fails with
+# TEE_ERROR_OUT_OF_MEMORY. Parameters and shared memory aren't counted.
+# 0 means no limit. The memory used by each TA is exposed by the stats
+# pseudo TA.
+CFG_TA_MEM_LIMIT ?= 0
+
+# Collect contention statistics of named locks: number of acquisitions,
+# how many had to wait, the cumulated and longest waiting times and the
+# number of sleeps in normal world for mutexes. Locks are named with
+# MUTEX_INITIALIZER_NAMED() or by passing a struct lock_stats to
+# cpu_spin_lock_xsave_stats(). The statistics are exposed by the stats
+# pseudo TA.
+CFG_LOCK_STATS ?= n
+
+# Count the interrupts handled by each registered interrupt handler and
+# the time spent handling them. The statistics are exposed by the stats
+# pseudo TA.
+CFG_ITR_STATS ?= n
+
+# Maximum time in microseconds a thread spins on a mutex held for writing by
+# a thread running on another core before it goes to sleep in normal world.
+# Short critical sections are then waited for without the sleep and wakeup
+# RPCs. 0 disables spinning.
+CFG_MUTEX_SPIN_US ?= 0
+
+# Maximum time in microseconds a thread waiting in a wait queue, that is
+# for a mutex or a condvar, waits in secure world to be woken up before it
+# sleeps in normal world. A thread woken up while still waiting in secure
+# world costs neither the sleep nor the wakeup RPC. 0 disables waiting in
+# secure world.
+CFG_WAIT_QUEUE_SPIN_US ?= 0
+
+# Give writers of mutexes precedence over readers: once a writer waits for
+# a mutex, new readers wait too and the readers queued are woken all at
+# once when no writer waits any longer. Without it a steady flow of readers
+# of a read-mostly mutex can starve the writers.
+CFG_MUTEX_WRITER_PREFERENCE ?= n
+
+# Collect statistics of the RPCs to normal world per OPTEE_RPC_CMD_* and
+# per TA of the current session: count, failures, cumulated size of the
+# memory references and latency histogram. The statistics are exposed by
+# the stats pseudo TA, at most CFG_RPC_STATS_ENTRIES (TA, command ID) pairs
+# are tracked.
+CFG_RPC_STATS ?= n
+CFG_RPC_STATS_ENTRIES ?= 64
+
+# Time each initcall and finalcall during boot and print the durations
+# and the total of each stage with the info level.
+CFG_CORE_INITCALL_PROFILE ?= n
+
 # Enable PKCS#11 TA's TEE Identity based authentication support
 CFG_PKCS11_TA_AUTH_TEE_IDENTITY ?= y
 
+# Size in bytes of the attributes of PKCS#11 TA persistent objects kept
+# loaded in memory once used. The attributes of the least recently used
+# objects are released beyond it and read again from secure storage when
+# needed.
+CFG_PKCS11_TA_ATTRS_CACHE_SIZE ?= 16384
+
 # Enable virtualization support. OP-TEE will not work without compatible
 # hypervisor if this option is enabled.
 CFG_VIRTUALIZATION ?= n
@@ -597,9 +983,18 @@ $(call force,CFG_CORE_RWDATA_NOEXEC,y)
 CFG_VIRT_GUEST_COUNT ?= 2
 endif
 
+ifeq ($(CFG_VIRTUALIZATION)-$(CFG_CORE_HEAP_GROW),y-y)
+$(error CFG_CORE_HEAP_GROW and CFG_VIRTUALIZATION are incompatible)
+endif
+
 # Enables backwards compatible derivation of RPMB and SSK keys
 CFG_CORE_HUK_SUBKEY_COMPAT ?= y
 
+# Number of subkeys derived from the hardware unique key that are cached
+# in secure memory to avoid reading the HUK again. The cache is wiped on
+# suspend. 0 disables the cache.
+CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES ?= 4
+
 # Compress and encode conf.mk into the TEE core, and show the encoded string on
 # boot (with severity TRACE_INFO).
 CFG_SHOW_CONF_ON_BOOT ?= n
@@ -627,6 +1022,13 @@ endif
 ifeq ($(CFG_WITH_STMM_SP),y)
 $(call force,CFG_ZLIB,y)
 endif
+# When enabled, keeps a copy of the inflated StMM image after the first
+# instance is loaded so that a restarted instance copies it instead of
+# inflating it again, at the cost of keeping the image size of memory.
+CFG_STMM_IMAGE_CACHE ?= n
+# Number of 1 KiB blocks of the StMM variable store cached by OP-TEE, the
+# store is kept open between requests. At least one block is needed.
+CFG_STMM_STORAGE_CACHE_BLOCKS ?= 8
 
 # When enabled checks that buffers passed to the GP Internal Core API
 # comply with the rules added as annotations as part of the definition of
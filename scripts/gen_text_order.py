@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2021, Linaro Limited
+#
+
+import argparse
+import bisect
+import sys
+try:
+    from elftools.elf.elffile import ELFFile
+    from elftools.elf.sections import SymbolTableSection
+
+except ImportError:
+    print("""
+***
+Can't find elftools module. Probably it is not installed on your system.
+You can install this module with
+
+$ apt install python3-pyelftools
+
+if you are using Ubuntu. Or try to search for "pyelftools" or "elftools" in
+your package manager if you are using some other distribution.
+***
+""")
+    raise
+
+
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+        description='Generates the list of the hot functions of the paged '
+        'core for CFG_CORE_PAGED_TEXT_ORDER, ordered from the function with '
+        'most page faults. The faults are those counted with '
+        'CFG_CORE_PAGER_FAULT_LOG=y, one "<address> <count>" pair per line, '
+        'addresses being link addresses of tee.elf.')
+    parser.add_argument('tee_elf', help='the OP-TEE ELF file (tee.elf)')
+    parser.add_argument('faults', nargs='+',
+                        help='files with the fault counts, the counts of '
+                        'several files are added')
+    parser.add_argument('--out', type=argparse.FileType('w'),
+                        default=sys.stdout, help='output file')
+    return parser.parse_args()
+
+
+def get_funcs(elffile):
+    funcs = []
+
+    for section in elffile.iter_sections():
+        if not isinstance(section, SymbolTableSection):
+            continue
+        for sym in section.iter_symbols():
+            if sym['st_info']['type'] != 'STT_FUNC' or not sym['st_size']:
+                continue
+            # Clear the Thumb bit
+            funcs.append((sym['st_value'] & ~1, sym['st_size'], sym.name))
+
+    funcs.sort()
+    return funcs
+
+
+def read_faults(names):
+    faults = {}
+
+    for name in names:
+        with open(name) as f:
+            for n, line in enumerate(f, 1):
+                words = line.split()
+                if not words or words[0].startswith('#'):
+                    continue
+                try:
+                    va = int(words[0], 16)
+                    count = int(words[1], 0) if len(words) > 1 else 1
+                except ValueError:
+                    eprint('{}:{}: bad line ignored'.format(name, n))
+                    continue
+                faults[va] = faults.get(va, 0) + count
+
+    return faults
+
+
+def main():
+    args = get_args()
+
+    with open(args.tee_elf, 'rb') as f:
+        funcs = get_funcs(ELFFile(f))
+    addrs = [fn[0] for fn in funcs]
+
+    counts = {}
+    for va, count in read_faults(args.faults).items():
+        n = bisect.bisect_right(addrs, va) - 1
+        if n < 0 or va >= funcs[n][0] + funcs[n][1]:
+            continue
+        name = funcs[n][2]
+        counts[name] = counts.get(name, 0) + count
+
+    # With -ffunction-sections each function has a section of its own
+    for name in sorted(counts, key=lambda k: (-counts[k], k)):
+        args.out.write('\t*(.text.{0})\t/* {1} faults */\n'.format(
+            name, counts[name]))
+
+
+if __name__ == "__main__":
+    main()
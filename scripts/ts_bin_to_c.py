@@ -43,9 +43,94 @@ def get_args():
         help='Compress the image using the DEFLATE '
         'algorithm')
 
+    parser.add_argument(
+        '--compress-lz',
+        dest="compress_lz",
+        action="store_true",
+        help='Compress the image in independent blocks using the LZ '
+        'format of core/lib/lz, faster to decompress than DEFLATE')
+
     return parser.parse_args()
 
 
+# Must match EMB_TS_LZ_BLOCK_SIZE in kernel/embedded_ts.h
+LZ_BLOCK_SIZE = 4096
+# Must match core/lib/lz/lz.c
+LZ_HTAB_BITS = 10
+LZ_MIN_MATCH = 3
+LZ_MAX_LIT = 32
+LZ_MAX_OFFS = 8192
+LZ_LEN_EXT = 7
+LZ_MAX_MATCH = LZ_LEN_EXT + 255 + 2
+
+
+def lz_hash(b, i):
+    v = (b[i] << 16) | (b[i + 1] << 8) | b[i + 2]
+    return ((v * 2654435761) & 0xffffffff) >> (32 - LZ_HTAB_BITS)
+
+
+def lz_emit_literals(out, lit):
+    while lit:
+        n = min(len(lit), LZ_MAX_LIT)
+        out.append(n - 1)
+        out += lit[:n]
+        lit = lit[n:]
+
+
+# Same algorithm as lz_compress() in core/lib/lz/lz.c
+def lz_compress(b):
+    out = bytearray()
+    htab = {}
+    lit_start = 0
+    ip = 0
+
+    while ip + LZ_MIN_MATCH <= len(b):
+        h = lz_hash(b, ip)
+        ref = htab.get(h)
+        htab[h] = ip
+        if (ref is None or ip - ref > LZ_MAX_OFFS or
+                b[ref:ref + LZ_MIN_MATCH] != b[ip:ip + LZ_MIN_MATCH]):
+            ip += 1
+            continue
+
+        max_len = min(len(b) - ip, LZ_MAX_MATCH)
+        length = LZ_MIN_MATCH
+        while length < max_len and b[ref + length] == b[ip + length]:
+            length += 1
+
+        lz_emit_literals(out, b[lit_start:ip])
+        offs = ip - ref - 1
+        if length - 2 < LZ_LEN_EXT:
+            out.append(((length - 2) << 5) | (offs >> 8))
+        else:
+            out.append((LZ_LEN_EXT << 5) | (offs >> 8))
+            out.append(length - 2 - LZ_LEN_EXT)
+        out.append(offs & 0xff)
+
+        ip += length
+        lit_start = ip
+
+    lz_emit_literals(out, b[lit_start:])
+    return bytes(out)
+
+
+def lz_compress_blocks(b):
+    out = bytearray()
+    offs = []
+
+    for i in range(0, len(b), LZ_BLOCK_SIZE):
+        blk = b[i:i + LZ_BLOCK_SIZE]
+        c = lz_compress(blk)
+        offs.append(len(out))
+        # Blocks which don't compress are stored as is
+        if len(c) < len(blk):
+            out += c
+        else:
+            out += blk
+    offs.append(len(out))
+    return bytes(out), offs
+
+
 def get_name(obj):
     # Symbol or section .name can be a byte array or a string, we want a string
     try:
@@ -95,13 +180,20 @@ def main():
         ts = args.sp
         is_sp = True
 
+    if args.compress and args.compress_lz:
+        raise Exception('The --compress and the --compress-lz can\'t be '
+                        'combined')
+
     ts_uuid = uuid.UUID(re.sub(r'\..*', '', os.path.basename(ts)))
 
+    lz_offs = None
     with open(ts, 'rb') as _ts:
         bytes = _ts.read()
         uncompressed_size = len(bytes)
         if args.compress:
             bytes = zlib.compress(bytes)
+        if args.compress_lz:
+            bytes, lz_offs = lz_compress_blocks(bytes)
         size = len(bytes)
 
     f = open(args.out, 'w')
@@ -121,6 +213,13 @@ def main():
         else:
             f.write(' ')
     f.write('};\n')
+    if lz_offs is not None:
+        f.write('static const uint32_t ts_lz_offs_' + ts_uuid.hex +
+                '[] = {\n')
+        for i in range(0, len(lz_offs), 8):
+            f.write('\t\t' + ', '.join(str(o) for o in lz_offs[i:i + 8]) +
+                    ',\n')
+        f.write('};\n')
 
     if is_sp:
         f.write('SCATTERED_ARRAY_DEFINE_PG_ITEM(sp_images, struct \
@@ -144,9 +243,11 @@ def main():
     f.write('\t.size = sizeof(ts_bin_' + ts_uuid.hex +
             '), /* {:d} */\n'.format(size))
     f.write('\t.ts = ts_bin_' + ts_uuid.hex + ',\n')
-    if args.compress:
+    if args.compress or args.compress_lz:
         f.write('\t.uncompressed_size = '
                 '{:d},\n'.format(uncompressed_size))
+    if lz_offs is not None:
+        f.write('\t.lz_offs = ts_lz_offs_' + ts_uuid.hex + ',\n')
     f.write('};\n')
     f.close()
 
@@ -32,6 +32,7 @@ link-ldflags += -Map=$(link-out-dir$(sm))/$(user-ta-uuid).map
 link-ldflags += --sort-section=alignment
 link-ldflags += -z max-page-size=4096 # OP-TEE always uses 4K alignment
 link-ldflags += --as-needed # Do not add dependency on unused shlib
+link-ldflags += --hash-style=both # DT_GNU_HASH and DT_HASH for older ldelf
 link-ldflags += $(link-ldflags$(sm))
 
 $(link-out-dir$(sm))/dyn_list:
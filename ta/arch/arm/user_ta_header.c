@@ -22,6 +22,10 @@ const char trace_ext_prefix[]  = "TA";
 #define TA_DESCRIPTION "Undefined description"
 #endif
 
+#ifndef TA_MALLOC_SIZE_CLASSES
+#define TA_MALLOC_SIZE_CLASSES false
+#endif
+
 /* exprted to user_ta_header.c, built within TA */
 struct utee_params;
 
@@ -115,6 +119,9 @@ const struct user_ta_property ta_props[] = {
 	{TA_PROP_STR_DESCRIPTION, USER_TA_PROP_TYPE_STRING,
 	 TA_DESCRIPTION},
 
+	{TA_PROP_STR_MALLOC_SIZE_CLASSES, USER_TA_PROP_TYPE_BOOL,
+	 &(const bool){TA_MALLOC_SIZE_CLASSES}},
+
 /*
  * Extended propietary properties, name of properties must not begin with
  * "gpd."
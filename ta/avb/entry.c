@@ -70,6 +70,89 @@ static TEE_Result get_named_object_name(char *name_orig,
 	return TEE_SUCCESS;
 }
 
+/*
+ * The rollback state object is kept open and cached for the lifetime of
+ * the TA instance, which is shared by all sessions since the TA is single
+ * instance. Updates are written through to the object before the cache is
+ * updated. The cache is dropped on any storage error, the next command
+ * opens the object again.
+ */
+struct rb_state {
+	TEE_ObjectHandle h;
+	bool lock_state_valid;
+	uint32_t lock_state;
+	/* Not yet written slots read as 0 */
+	uint64_t idx[TA_AVB_MAX_ROLLBACK_LOCATIONS];
+};
+
+static struct rb_state rb_state;
+
+static void drop_rb_state(void)
+{
+	if (rb_state.h != TEE_HANDLE_NULL)
+		TEE_CloseObject(rb_state.h);
+	memset(&rb_state, 0, sizeof(rb_state));
+	rb_state.h = TEE_HANDLE_NULL;
+}
+
+static TEE_Result load_rb_state(uint32_t default_lock_state)
+{
+	size_t slot_offset;
+	uint32_t count;
+	size_t slot;
+	TEE_Result res;
+
+	if (rb_state.h != TEE_HANDLE_NULL)
+		return TEE_SUCCESS;
+
+	res = open_rb_state(default_lock_state, &rb_state.h);
+	if (res) {
+		rb_state.h = TEE_HANDLE_NULL;
+		return res;
+	}
+
+	res = TEE_ReadObjectData(rb_state.h, &rb_state.lock_state,
+				 sizeof(rb_state.lock_state), &count);
+	if (res)
+		goto err;
+	/*
+	 * Client need write the lock state to recover, this can normally
+	 * not happen.
+	 */
+	rb_state.lock_state_valid = (count == sizeof(rb_state.lock_state));
+	if (!rb_state.lock_state_valid)
+		return TEE_SUCCESS;
+
+	res = TEE_ReadObjectData(rb_state.h, rb_state.idx,
+				 sizeof(rb_state.idx), &count);
+	if (res)
+		goto err;
+	if (count % sizeof(uint64_t)) {
+		/*
+		 * Somehow the file didn't even hold a complete slot index
+		 * entry. Write it as 0.
+		 */
+		slot = count / sizeof(uint64_t);
+		rb_state.idx[slot] = 0;
+		res = get_slot_offset(slot, &slot_offset);
+		if (res)
+			goto err;
+		res = TEE_SeekObjectData(rb_state.h, slot_offset,
+					 TEE_DATA_SEEK_SET);
+		if (res)
+			goto err;
+		res = TEE_WriteObjectData(rb_state.h, rb_state.idx + slot,
+					  sizeof(uint64_t));
+		if (res)
+			goto err;
+	}
+
+	return TEE_SUCCESS;
+err:
+	drop_rb_state();
+	return res;
+}
+
 static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 {
 	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
@@ -78,9 +161,7 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_NONE);
 	size_t slot_offset;
 	uint64_t idx;
-	uint32_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -89,40 +170,51 @@ static TEE_Result read_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 	if (res)
 		return res;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_state(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
+	idx = rb_state.idx[params[0].value.a];
+	params[1].value.a = idx >> 32;
+	params[1].value.b = idx;
+
+	return TEE_SUCCESS;
+}
 
-	res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
+static TEE_Result read_rb_idxs(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	size_t slot = params[0].value.a;
+	size_t slot_offset;
+	size_t num_slots;
+	TEE_Result res;
+
+	if (pt != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = get_slot_offset(slot, &slot_offset);
 	if (res)
-		goto out;
-	if (count != sizeof(idx)) {
-		idx = 0; /* Not yet written slots are reported as 0 */
-
-		if (count) {
-			/*
-			 * Somehow the file didn't even hold a complete
-			 * slot index entry.  Write it as 0.
-			 */
-			res = TEE_SeekObjectData(h, slot_offset,
-						 TEE_DATA_SEEK_SET);
-			if (res)
-				goto out;
-			res = TEE_WriteObjectData(h, &idx, sizeof(idx));
-			if (res)
-				goto out;
-		}
+		return res;
+
+	num_slots = MIN(params[1].memref.size / sizeof(uint64_t),
+			TA_AVB_MAX_ROLLBACK_LOCATIONS - slot);
+	if (!num_slots) {
+		params[1].memref.size = sizeof(uint64_t);
+		return TEE_ERROR_SHORT_BUFFER;
 	}
 
-	params[1].value.a = idx >> 32;
-	params[1].value.b = idx;
-out:
-	TEE_CloseObject(h);
-	return res;
+	res = load_rb_state(DEFAULT_LOCK_STATE);
+	if (res)
+		return res;
+
+	TEE_MemMove(params[1].memref.buffer, rb_state.idx + slot,
+		    num_slots * sizeof(uint64_t));
+	params[1].memref.size = num_slots * sizeof(uint64_t);
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
@@ -131,47 +223,38 @@ static TEE_Result write_rb_idx(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_VALUE_INPUT,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
+	size_t slot = params[0].value.a;
 	size_t slot_offset;
 	uint64_t widx;
-	uint64_t idx;
-	uint32_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = get_slot_offset(params[0].value.a, &slot_offset);
+	res = get_slot_offset(slot, &slot_offset);
 	if (res)
 		return res;
 	widx = ((uint64_t)params[1].value.a << 32) | params[1].value.b;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_state(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
-	if (res)
-		goto out;
+	if (widx < rb_state.idx[slot])
+		return TEE_ERROR_SECURITY;
 
-	res =  TEE_ReadObjectData(h, &idx, sizeof(idx), &count);
+	res = TEE_SeekObjectData(rb_state.h, slot_offset, TEE_DATA_SEEK_SET);
 	if (res)
-		goto out;
-	if (count != sizeof(idx))
-		idx = 0; /* Not yet written slots are reported as 0 */
-
-	if (widx < idx) {
-		res = TEE_ERROR_SECURITY;
-		goto out;
-	}
+		goto err;
 
-	res = TEE_SeekObjectData(h, slot_offset, TEE_DATA_SEEK_SET);
+	res = TEE_WriteObjectData(rb_state.h, &widx, sizeof(widx));
 	if (res)
-		goto out;
+		goto err;
 
-	res = TEE_WriteObjectData(h, &widx, sizeof(widx));
-out:
-	TEE_CloseObject(h);
+	rb_state.idx[slot] = widx;
+	return TEE_SUCCESS;
+err:
+	drop_rb_state();
 	return res;
 }
 
@@ -181,34 +264,20 @@ static TEE_Result read_lock_state(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
-	uint32_t lock_state;
-	uint32_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = open_rb_state(DEFAULT_LOCK_STATE, &h);
+	res = load_rb_state(DEFAULT_LOCK_STATE);
 	if (res)
 		return res;
 
-	res =  TEE_ReadObjectData(h, &lock_state, sizeof(lock_state), &count);
-	if (res)
-		goto out;
-	if (count != sizeof(lock_state)) {
-		/*
-		 * Client need write the lock state to recover, this can
-		 * normally not happen.
-		 */
-		res = TEE_ERROR_CORRUPT_OBJECT;
-		goto out;
-	}
+	if (!rb_state.lock_state_valid)
+		return TEE_ERROR_CORRUPT_OBJECT;
 
-	params[0].value.a = lock_state;
-out:
-	TEE_CloseObject(h);
-	return res;
+	params[0].value.a = rb_state.lock_state;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_lock_state(uint32_t pt,
@@ -219,30 +288,31 @@ static TEE_Result write_lock_state(uint32_t pt,
 						TEE_PARAM_TYPE_NONE,
 						TEE_PARAM_TYPE_NONE);
 	uint32_t wlock_state;
-	uint32_t lock_state;
-	uint32_t count;
 	TEE_Result res;
-	TEE_ObjectHandle h;
 
 	if (pt != exp_pt)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	wlock_state = params[0].value.a;
 
-	res = open_rb_state(wlock_state, &h);
+	res = load_rb_state(wlock_state);
 	if (res)
 		return res;
 
-	res =  TEE_ReadObjectData(h, &lock_state, sizeof(lock_state), &count);
-	if (res)
-		goto out;
-	if (count == sizeof(lock_state) && lock_state == wlock_state)
-		goto out;
+	if (rb_state.lock_state_valid && rb_state.lock_state == wlock_state)
+		return TEE_SUCCESS;
 
-	res = create_rb_state(wlock_state, &h);
-out:
-	TEE_CloseObject(h);
-	return res;
+	/* Resets all the rollback slots */
+	drop_rb_state();
+	res = create_rb_state(wlock_state, &rb_state.h);
+	if (res) {
+		rb_state.h = TEE_HANDLE_NULL;
+		return res;
+	}
+
+	rb_state.lock_state_valid = true;
+	rb_state.lock_state = wlock_state;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_persist_value(uint32_t pt,
@@ -344,6 +414,7 @@ TEE_Result TA_CreateEntryPoint(void)
 
 void TA_DestroyEntryPoint(void)
 {
+	drop_rb_state();
 }
 
 TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
@@ -364,6 +435,8 @@ TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
 	switch (cmd) {
 	case TA_AVB_CMD_READ_ROLLBACK_INDEX:
 		return read_rb_idx(pt, params);
+	case TA_AVB_CMD_READ_ROLLBACK_INDEXES:
+		return read_rb_idxs(pt, params);
 	case TA_AVB_CMD_WRITE_ROLLBACK_INDEX:
 		return write_rb_idx(pt, params);
 	case TA_AVB_CMD_READ_LOCK_STATE:
@@ -61,4 +61,16 @@
  */
 #define TA_AVB_CMD_WRITE_PERSIST_VALUE	5
 
+/*
+ * Gets the rollback indexes of consecutive rollback index slots, as many
+ * as fit in the buffer, in one command.
+ *
+ * in	params[0].value.a:	first rollback index slot
+ * out	params[1].memref:	array of uint64_t rollback indexes, in the
+ *				byte order of the CPU
+ *
+ * Returns TEE_ERROR_SHORT_BUFFER if the buffer can't hold one index.
+ */
+#define TA_AVB_CMD_READ_ROLLBACK_INDEXES	6
+
 #endif /*__TA_AVB_H*/
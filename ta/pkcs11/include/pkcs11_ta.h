@@ -509,6 +509,39 @@ enum pkcs11_ta_cmd {
 	 * attribs + attributes data).
 	 */
 	PKCS11_CMD_GET_ATTRIBUTE_VALUE = 38,
+
+	/*
+	 * PKCS11_CMD_PROCESSING_BATCH - Run a list of one-shot processings
+	 *
+	 * [in]  memref[0] = [
+	 *              32bit number of processings N,
+	 *              then N times [
+	 *                      32bit session handle,
+	 *                      32bit command: PKCS11_CMD_ENCRYPT_ONESHOT,
+	 *                              PKCS11_CMD_DECRYPT_ONESHOT or
+	 *                              PKCS11_CMD_SIGN_ONESHOT,
+	 *                      32bit key handle,
+	 *                      (struct pkcs11_attribute_head)mechanism +
+	 *                                                    mechanism params,
+	 *                      32bit input data byte size,
+	 *                      32bit output data max byte size,
+	 *              ]
+	 *	 ]
+	 * [out] memref[0] = 32bit return code, enum pkcs11_rc
+	 * [in]  memref[1] = input data of the N processings, concatenated
+	 * [out] memref[2] = N times [
+	 *              32bit return code of the processing, enum pkcs11_rc,
+	 *              32bit output data byte size,
+	 *              byte array: output data, padded to the max byte size
+	 *	 ]
+	 *
+	 * Each processing is the same as the related *_INIT command followed
+	 * by the *_ONESHOT command. The TEE operation is reused by the next
+	 * processing if it has the same session, command, key and mechanism.
+	 * The return code in memref[0] reports the validity of the request
+	 * as a whole.
+	 */
+	PKCS11_CMD_PROCESSING_BATCH = 39,
 };
 
 /*
@@ -28,34 +28,108 @@ enum pkcs11_rc init_attributes_head(struct obj_attrs **head)
 	return PKCS11_CKR_OK;
 }
 
+/* Return the offset in @head of the first attribute of ID above @attribute */
+static size_t find_insert_offset(struct obj_attrs *head, uint32_t attribute)
+{
+	size_t off = 0;
+
+	while (off < head->attrs_size) {
+		struct pkcs11_attribute_head pkcs11_ref = { };
+
+		TEE_MemMove(&pkcs11_ref, head->attrs + off, sizeof(pkcs11_ref));
+		if (pkcs11_ref.id > attribute)
+			break;
+
+		off += sizeof(pkcs11_ref) + pkcs11_ref.size;
+	}
+
+	return off;
+}
+
 enum pkcs11_rc add_attribute(struct obj_attrs **head, uint32_t attribute,
 			     void *data, size_t size)
 {
-	size_t buf_len = sizeof(struct obj_attrs) + (*head)->attrs_size;
-	char **bstart = (void *)head;
+	struct pkcs11_attribute_head pkcs11_ref = {
+		.id = attribute,
+		.size = size,
+	};
+	struct obj_attrs *h = *head;
+	uint32_t entry_size = 0;
+	uint32_t attrs_size = 0;
+	size_t buf_len = 0;
+	size_t off = 0;
+
+	if (ADD_OVERFLOW(sizeof(pkcs11_ref), size, &entry_size) ||
+	    ADD_OVERFLOW(h->attrs_size, entry_size, &attrs_size) ||
+	    ADD_OVERFLOW(sizeof(*h), attrs_size, &buf_len))
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	off = find_insert_offset(h, attribute);
+
+	h = TEE_Realloc(h, buf_len);
+	if (!h)
+		return PKCS11_CKR_DEVICE_MEMORY;
+
+	/* Keep the attributes sorted by ID, in insertion order for an ID */
+	TEE_MemMove(h->attrs + off + entry_size, h->attrs + off,
+		    h->attrs_size - off);
+	TEE_MemMove(h->attrs + off, &pkcs11_ref, sizeof(pkcs11_ref));
+	if (size)
+		TEE_MemMove(h->attrs + off + sizeof(pkcs11_ref), data, size);
+
+	h->attrs_size = attrs_size;
+	h->attrs_count++;
+	*head = h;
+
+	return PKCS11_CKR_OK;
+}
+
+enum pkcs11_rc sort_attributes(struct obj_attrs **head)
+{
+	struct obj_attrs *h = *head;
+	struct obj_attrs *sorted = NULL;
 	enum pkcs11_rc rc = PKCS11_CKR_OK;
-	uint32_t data32 = 0;
+	uint32_t prev_id = 0;
+	size_t off = 0;
+	size_t n = 0;
 
-	data32 = attribute;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
+	for (n = 0; n < h->attrs_count; n++) {
+		struct pkcs11_attribute_head pkcs11_ref = { };
 
-	data32 = size;
-	rc = serialize(bstart, &buf_len, &data32, sizeof(uint32_t));
-	if (rc)
-		return rc;
+		TEE_MemMove(&pkcs11_ref, h->attrs + off, sizeof(pkcs11_ref));
+		if (n && pkcs11_ref.id < prev_id)
+			break;
+
+		prev_id = pkcs11_ref.id;
+		off += sizeof(pkcs11_ref) + pkcs11_ref.size;
+	}
+
+	if (n == h->attrs_count)
+		return PKCS11_CKR_OK;
 
-	rc = serialize(bstart, &buf_len, data, size);
+	rc = init_attributes_head(&sorted);
 	if (rc)
 		return rc;
 
-	/* Alloced buffer is always well aligned */
-	head = (void *)bstart;
-	(*head)->attrs_size += 2 * sizeof(uint32_t) + size;
-	(*head)->attrs_count++;
+	for (off = 0, n = 0; n < h->attrs_count; n++) {
+		struct pkcs11_attribute_head pkcs11_ref = { };
+
+		TEE_MemMove(&pkcs11_ref, h->attrs + off, sizeof(pkcs11_ref));
+		rc = add_attribute(&sorted, pkcs11_ref.id,
+				   h->attrs + off + sizeof(pkcs11_ref),
+				   pkcs11_ref.size);
+		if (rc) {
+			TEE_Free(sorted);
+			return rc;
+		}
 
-	return rc;
+		off += sizeof(pkcs11_ref) + pkcs11_ref.size;
+	}
+
+	TEE_Free(h);
+	*head = sorted;
+
+	return PKCS11_CKR_OK;
 }
 
 static enum pkcs11_rc _remove_attribute(struct obj_attrs **head,
@@ -119,6 +193,10 @@ void get_attribute_ptrs(struct obj_attrs *head, uint32_t attribute,
 		TEE_MemMove(&pkcs11_ref, cur, sizeof(pkcs11_ref));
 		next_off = sizeof(pkcs11_ref) + pkcs11_ref.size;
 
+		/* Attributes are sorted, none further can match */
+		if (pkcs11_ref.id > attribute)
+			break;
+
 		if (pkcs11_ref.id != attribute)
 			continue;
 
@@ -210,28 +288,56 @@ bool get_bool(struct obj_attrs *head, uint32_t attribute)
 bool attributes_match_reference(struct obj_attrs *candidate,
 				struct obj_attrs *ref)
 {
-	size_t count = ref->attrs_count;
+	struct pkcs11_attribute_head cand_ref = { };
 	unsigned char *ref_attr = ref->attrs;
-	uint32_t rc = PKCS11_CKR_GENERAL_ERROR;
+	unsigned char *cand_attr = candidate->attrs;
+	unsigned char *cand_end = cand_attr + candidate->attrs_size;
+	uint32_t prev_id = 0;
+	size_t count = 0;
 
 	if (!ref->attrs_count) {
 		DMSG("Empty reference match all");
 		return true;
 	}
 
+	/*
+	 * Both lists are sorted by ID, the candidate attributes are walked
+	 * once along the reference attributes.
+	 */
 	for (count = 0; count < ref->attrs_count; count++) {
 		struct pkcs11_attribute_head pkcs11_ref = { };
-		void *value = NULL;
-		uint32_t size = 0;
+		unsigned char *next = NULL;
 
 		TEE_MemMove(&pkcs11_ref, ref_attr, sizeof(pkcs11_ref));
 
-		rc = get_attribute_ptr(candidate, pkcs11_ref.id, &value, &size);
+		/* Restart the walk in case the reference is not sorted */
+		if (pkcs11_ref.id < prev_id)
+			cand_attr = candidate->attrs;
+		prev_id = pkcs11_ref.id;
 
-		if (rc || !value || size != pkcs11_ref.size ||
-		    TEE_MemCompare(ref_attr + sizeof(pkcs11_ref), value, size))
+		for (; cand_attr < cand_end; cand_attr = next) {
+			TEE_MemMove(&cand_ref, cand_attr, sizeof(cand_ref));
+			next = cand_attr + sizeof(cand_ref) + cand_ref.size;
+			if (cand_ref.id >= pkcs11_ref.id)
+				break;
+		}
+
+		if (cand_attr >= cand_end || cand_ref.id != pkcs11_ref.id ||
+		    !cand_ref.size || cand_ref.size != pkcs11_ref.size ||
+		    TEE_MemCompare(ref_attr + sizeof(pkcs11_ref),
+				   cand_attr + sizeof(cand_ref), cand_ref.size))
 			return false;
 
+		/* An attribute found twice in the candidate is not a match */
+		next = cand_attr + sizeof(cand_ref) + cand_ref.size;
+		if (next < cand_end) {
+			struct pkcs11_attribute_head next_ref = { };
+
+			TEE_MemMove(&next_ref, next, sizeof(next_ref));
+			if (next_ref.id == pkcs11_ref.id)
+				return false;
+		}
+
 		ref_attr += sizeof(pkcs11_ref) + pkcs11_ref.size;
 	}
 
@@ -54,6 +54,9 @@ enum boolprop_attr {
  * @attrs_size:	 byte size of the serialized data
  * @attrs_count: number of items in the blob
  * @attrs:	 then starts the blob binary data
+ *
+ * The attributes are sorted by ID so that lookups stop early and matches
+ * walk the lists once.
  */
 struct obj_attrs {
 	uint32_t attrs_size;
@@ -80,11 +83,25 @@ enum pkcs11_rc init_attributes_head(struct obj_attrs **head);
  * @data:	Opaque data of attribute
  * @size:	Size of data
  *
+ * The entry is inserted after the entries of lower or equal ID.
+ *
  * Return PKCS11_CKR_OK on success or a PKCS11 return code.
  */
 enum pkcs11_rc add_attribute(struct obj_attrs **head, uint32_t attribute,
 			     void *data, size_t size);
 
+/*
+ * sort_attributes() - Sort serialized attributes by ID
+ * @head:	*@head points to serialized attributes, reallocated if unsorted
+ *
+ * Attributes built by add_attribute() are sorted, this is needed for
+ * serialized attributes of other origins, like an object stored before
+ * attributes were sorted.
+ *
+ * Return PKCS11_CKR_OK on success or a PKCS11 return code.
+ */
+enum pkcs11_rc sort_attributes(struct obj_attrs **head);
+
 /*
  * Update serialized attributes to remove an empty entry. Can relocate the
  * attribute list buffer. Only 1 instance of the entry is expected.
@@ -15,6 +15,12 @@
 #include "pkcs11_token.h"
 #include "processing.h"
 
+/*
+ * Size of the stack buffer the control arguments of a command are copied
+ * to, larger control arguments are copied to an allocated buffer.
+ */
+#define CTRL_STACK_BUF_SIZE	64
+
 TEE_Result TA_CreateEntryPoint(void)
 {
 	return pkcs11_init();
@@ -118,7 +124,11 @@ TEE_Result TA_InvokeCommandEntryPoint(void *tee_session, uint32_t cmd,
 				      TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct pkcs11_client *client = tee_session2client(tee_session);
+	uint64_t ctrl_stack[CTRL_STACK_BUF_SIZE / sizeof(uint64_t)] = { };
 	enum pkcs11_rc rc = PKCS11_CKR_GENERAL_ERROR;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctrl_shm = NULL;
+	void *ctrl = ctrl_stack;
 
 	if (!client)
 		return TEE_ERROR_SECURITY;
@@ -140,6 +150,20 @@ TEE_Result TA_InvokeCommandEntryPoint(void *tee_session, uint32_t cmd,
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
+	/*
+	 * Arguments are parsed in place from a private copy of the control
+	 * buffer so that the client cannot change them while being checked.
+	 */
+	ctrl_shm = params[0].memref.buffer;
+	if (params[0].memref.size > sizeof(ctrl_stack)) {
+		ctrl = TEE_Malloc(params[0].memref.size,
+				  TEE_USER_MEM_HINT_NO_FILL_ZERO);
+		if (!ctrl)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	TEE_MemMove(ctrl, ctrl_shm, params[0].memref.size);
+	params[0].memref.buffer = ctrl;
+
 	DMSG("%s p#0 %"PRIu32"@%p, p#1 %s %"PRIu32"@%p, p#2 %s %"PRIu32"@%p",
 	     id2str_ta_cmd(cmd),
 	     params[0].memref.size, params[0].memref.buffer,
@@ -303,18 +327,32 @@ TEE_Result TA_InvokeCommandEntryPoint(void *tee_session, uint32_t cmd,
 	case PKCS11_CMD_GET_OBJECT_SIZE:
 		rc = entry_get_object_size(client, ptypes, params);
 		break;
+	case PKCS11_CMD_PROCESSING_BATCH:
+		rc = entry_processing_batch(client, ptypes, params);
+		break;
 	default:
 		EMSG("Command %#"PRIx32" is not supported", cmd);
-		return TEE_ERROR_NOT_SUPPORTED;
+		res = TEE_ERROR_NOT_SUPPORTED;
+		goto out;
 	}
 
 	DMSG("%s rc %#"PRIx32"/%s", id2str_ta_cmd(cmd), rc, id2str_rc(rc));
 
-	TEE_MemMove(params[0].memref.buffer, &rc, sizeof(rc));
+	/* No reference to object attributes is held between commands */
+	trim_persistent_attributes_cache();
+
+	TEE_MemMove(ctrl_shm, &rc, sizeof(rc));
 	params[0].memref.size = sizeof(rc);
 
 	if (rc == PKCS11_CKR_BUFFER_TOO_SMALL)
-		return TEE_ERROR_SHORT_BUFFER;
+		res = TEE_ERROR_SHORT_BUFFER;
 	else
-		return TEE_SUCCESS;
+		res = TEE_SUCCESS;
+
+out:
+	params[0].memref.buffer = ctrl_shm;
+	if (ctrl != ctrl_stack)
+		TEE_Free(ctrl);
+
+	return res;
 }
@@ -17,6 +17,82 @@
  */
 #define HANDLE_DB_INITIAL_MAX_PTRS	4
 
+/*
+ * Unused entries in db->ptrs are linked in a free list. A free entry holds
+ * the index of the next free entry (0 ends the list since handle 0 is
+ * invalid) shifted one bit left and with bit 0 set, which can't be
+ * mistaken for a registered pointer since those are at least 2-byte
+ * aligned. db->free_list holds the index of the first free entry.
+ */
+#define FREE_BIT	1UL
+
+/*
+ * Registered handles are also indexed by pointer in db->hash, an open
+ * addressing hash table with linear probing that holds handles (0 marks
+ * an empty slot). It has twice as many slots as db->ptrs has entries so
+ * its load factor stays below one half and handle_lookup_handle() doesn't
+ * have to scan the whole database.
+ */
+static uint32_t hash_slot(struct handle_db *db, void *ptr)
+{
+	uintptr_t v = (uintptr_t)ptr >> 1;
+
+	v ^= v >> 16;
+
+	return ((uint32_t)v * 0x9e3779b1U) & (db->hash_size - 1);
+}
+
+static void hash_insert(struct handle_db *db, uint32_t handle)
+{
+	uint32_t n = hash_slot(db, db->ptrs[handle]);
+
+	while (db->hash[n])
+		n = (n + 1) & (db->hash_size - 1);
+
+	db->hash[n] = handle;
+}
+
+static void hash_remove(struct handle_db *db, uint32_t handle)
+{
+	uint32_t mask = db->hash_size - 1;
+	uint32_t n = hash_slot(db, db->ptrs[handle]);
+	uint32_t m = 0;
+	uint32_t k = 0;
+
+	while (db->hash[n] != handle) {
+		if (!db->hash[n])
+			return;
+		n = (n + 1) & mask;
+	}
+
+	/*
+	 * Backward shift deletion: move up the following entries of the
+	 * probe sequence which would no longer be reachable through the
+	 * emptied slot.
+	 */
+	for (m = (n + 1) & mask; db->hash[m]; m = (m + 1) & mask) {
+		k = hash_slot(db, db->ptrs[db->hash[m]]);
+		if ((n <= m) ? (n < k && k <= m) : (n < k || k <= m))
+			continue;
+
+		db->hash[n] = db->hash[m];
+		n = m;
+	}
+
+	db->hash[n] = 0;
+}
+
+static bool is_free(void *p)
+{
+	return (uintptr_t)p & FREE_BIT;
+}
+
+static void push_free(struct handle_db *db, uint32_t n)
+{
+	db->ptrs[n] = (void *)(((uintptr_t)db->free_list << 1) | FREE_BIT);
+	db->free_list = n;
+}
+
 void handle_db_init(struct handle_db *db)
 {
 	TEE_MemFill(db, 0, sizeof(*db));
@@ -26,8 +102,12 @@ void handle_db_destroy(struct handle_db *db)
 {
 	if (db) {
 		TEE_Free(db->ptrs);
+		TEE_Free(db->hash);
 		db->ptrs = NULL;
+		db->hash = NULL;
 		db->max_ptrs = 0;
+		db->hash_size = 0;
+		db->free_list = 0;
 	}
 }
 
@@ -35,35 +115,57 @@ uint32_t handle_get(struct handle_db *db, void *ptr)
 {
 	uint32_t n = 0;
 	void *p = NULL;
+	uint32_t *old_hash = NULL;
+	uint32_t *new_hash = NULL;
 	uint32_t new_max_ptrs = 0;
 
-	if (!db || !ptr)
+	if (!db || !ptr || is_free(ptr))
 		return 0;
 
-	/* Try to find an empty location (index 0 is reserved as invalid) */
-	for (n = 1; n < db->max_ptrs; n++) {
-		if (!db->ptrs[n]) {
-			db->ptrs[n] = ptr;
-			return n;
+	if (!db->free_list) {
+		/* No location available, grow the ptrs array */
+		if (db->max_ptrs)
+			new_max_ptrs = db->max_ptrs * 2;
+		else
+			new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+
+		new_hash = TEE_Malloc(2 * new_max_ptrs * sizeof(uint32_t),
+				      TEE_MALLOC_FILL_ZERO);
+		if (!new_hash)
+			return 0;
+
+		p = TEE_Realloc(db->ptrs, new_max_ptrs * sizeof(void *));
+		if (!p) {
+			TEE_Free(new_hash);
+			return 0;
 		}
-	}
+		db->ptrs = p;
 
-	/* No location available, grow the ptrs array */
-	if (db->max_ptrs)
-		new_max_ptrs = db->max_ptrs * 2;
-	else
-		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+		/* Index 0 is reserved as invalid and never used */
+		if (!db->max_ptrs) {
+			db->ptrs[0] = NULL;
+			db->max_ptrs = 1;
+		}
 
-	p = TEE_Realloc(db->ptrs, new_max_ptrs * sizeof(void *));
-	if (!p)
-		return 0;
-	db->ptrs = p;
-	TEE_MemFill(db->ptrs + db->max_ptrs, 0,
-		    (new_max_ptrs - db->max_ptrs) * sizeof(void *));
-	db->max_ptrs = new_max_ptrs;
+		/* Add the new locations to the free list, lowest first */
+		for (n = new_max_ptrs - 1; n >= db->max_ptrs; n--)
+			push_free(db, n);
+		db->max_ptrs = new_max_ptrs;
+
+		/* Rehash the registered pointers in the larger table */
+		old_hash = db->hash;
+		db->hash = new_hash;
+		db->hash_size = 2 * new_max_ptrs;
+		for (n = 1; n < db->max_ptrs; n++)
+			if (!is_free(db->ptrs[n]))
+				hash_insert(db, n);
+		TEE_Free(old_hash);
+	}
 
-	/* Since n stopped at db->max_ptrs there is an empty location there */
+	n = db->free_list;
+	db->free_list = (uintptr_t)db->ptrs[n] >> 1;
 	db->ptrs[n] = ptr;
+	hash_insert(db, n);
 	return n;
 }
 
@@ -75,27 +177,39 @@ void *handle_put(struct handle_db *db, uint32_t handle)
 		return NULL;
 
 	p = db->ptrs[handle];
-	db->ptrs[handle] = NULL;
+	if (is_free(p))
+		return NULL;
+
+	hash_remove(db, handle);
+	push_free(db, handle);
 	return p;
 }
 
 void *handle_lookup(struct handle_db *db, uint32_t handle)
 {
+	void *p = NULL;
+
 	if (!db || !handle || handle >= db->max_ptrs)
 		return NULL;
 
-	return db->ptrs[handle];
+	p = db->ptrs[handle];
+	if (is_free(p))
+		return NULL;
+
+	return p;
 }
 
 uint32_t handle_lookup_handle(struct handle_db *db, void *ptr)
 {
 	uint32_t n = 0;
 
-	if (ptr) {
-		for (n = 1; n < db->max_ptrs; n++)
-			if (db->ptrs[n] == ptr)
-				return n;
-	}
+	if (!db || !db->hash_size || !ptr || is_free(ptr))
+		return 0;
+
+	for (n = hash_slot(db, ptr); db->hash[n];
+	     n = (n + 1) & (db->hash_size - 1))
+		if (db->ptrs[db->hash[n]] == ptr)
+			return db->hash[n];
 
 	return 0;
 }
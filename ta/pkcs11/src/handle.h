@@ -8,9 +8,20 @@
 
 #include <stddef.h>
 
+/*
+ * struct handle_db - database of handles
+ * @ptrs:	Registered pointers and free list entries indexed by handle
+ * @max_ptrs:	Number of entries in @ptrs
+ * @free_list:	Index of the first unused entry in @ptrs, 0 if none
+ * @hash:	Hash table of the registered handles indexed by pointer
+ * @hash_size:	Number of slots in @hash, twice @max_ptrs
+ */
 struct handle_db {
 	void **ptrs;
 	uint32_t max_ptrs;
+	uint32_t free_list;
+	uint32_t *hash;
+	uint32_t hash_size;
 };
 
 /*
@@ -27,6 +38,8 @@ void handle_db_destroy(struct handle_db *db);
 
 /*
  * Allocate a new handle ID and assigns the supplied pointer to it,
+ * ptr must be at least 2-byte aligned. Allocation takes constant time,
+ * apart from when the database has to grow.
  * The function returns > 0 on success and 0 on failure.
  */
 uint32_t handle_get(struct handle_db *db, void *ptr);
@@ -44,7 +57,10 @@ void *handle_put(struct handle_db *db, uint32_t handle);
  */
 void *handle_lookup(struct handle_db *db, uint32_t handle);
 
-/* Return the handle associated to a pointer if found, else return 0 */
+/*
+ * Return the handle associated to a pointer if found, else return 0.
+ * The lookup takes constant time on average.
+ */
 uint32_t handle_lookup_handle(struct handle_db *db, void *ptr);
 
 #endif /*PKCS11_TA_HANDLE_H*/
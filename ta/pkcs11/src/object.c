@@ -8,6 +8,7 @@
 #include <string_ext.h>
 #include <tee_internal_api.h>
 #include <tee_internal_api_extensions.h>
+#include <util.h>
 
 #include "attributes.h"
 #include "handle.h"
@@ -18,10 +19,193 @@
 #include "sanitize_object.h"
 #include "serializer.h"
 
+/*
+ * Define the initial number of buckets of an object index. The index
+ * doubles up each time it holds as many objects as buckets.
+ */
+#define OBJ_INDEX_INITIAL_BUCKETS	16
+
+static const uint32_t obj_index_attribute[OBJ_INDEX_KEY_COUNT] = {
+	[OBJ_INDEX_ID] = PKCS11_CKA_ID,
+	[OBJ_INDEX_LABEL] = PKCS11_CKA_LABEL,
+};
+
+/*
+ * FNV-1a hash of an attribute value. The hash values of the persistent
+ * objects are stored in the token object index file, a change of the hash
+ * function must invalidate it.
+ */
+static uint32_t obj_index_hash(const void *data, uint32_t size)
+{
+	const uint8_t *p = data;
+	uint32_t hash = 2166136261U;
+	uint32_t n = 0;
+
+	for (n = 0; n < size; n++)
+		hash = (hash ^ p[n]) * 16777619U;
+
+	return hash;
+}
+
+static bool get_index_hash(struct obj_attrs *attrs, unsigned int key,
+			   uint32_t *hash)
+{
+	void *value = NULL;
+	uint32_t size = 0;
+
+	if (get_attribute_ptr(attrs, obj_index_attribute[key], &value, &size))
+		return false;
+
+	*hash = obj_index_hash(value, size);
+
+	return true;
+}
+
+static struct object_list *obj_index_bucket(struct obj_index *index,
+					    unsigned int key, uint32_t hash)
+{
+	return index->buckets[key] + (hash & (index->bucket_count - 1));
+}
+
+static void obj_index_link(struct obj_index *index, struct pkcs11_object *obj)
+{
+	unsigned int key = 0;
+
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++)
+		if (obj->index_keys & BIT(key))
+			LIST_INSERT_HEAD(obj_index_bucket(index, key,
+							  obj->index_hash[key]),
+					 obj, index_link[key]);
+}
+
+static bool obj_index_grow(struct obj_index *index)
+{
+	struct object_list *buckets[OBJ_INDEX_KEY_COUNT] = { };
+	struct pkcs11_object *obj = NULL;
+	uint32_t count = OBJ_INDEX_INITIAL_BUCKETS;
+	unsigned int key = 0;
+
+	if (index->bucket_count)
+		count = index->bucket_count * 2;
+
+	/* Zeroed list heads are empty lists */
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++) {
+		buckets[key] = TEE_Malloc(count * sizeof(struct object_list),
+					  TEE_MALLOC_FILL_ZERO);
+		if (!buckets[key])
+			goto err;
+	}
+
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++) {
+		TEE_Free(index->buckets[key]);
+		index->buckets[key] = buckets[key];
+	}
+	index->bucket_count = count;
+
+	LIST_FOREACH(obj, index->list, link)
+		if (obj->indexed)
+			obj_index_link(index, obj);
+
+	return true;
+
+err:
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++)
+		TEE_Free(buckets[key]);
+
+	return false;
+}
+
+void obj_index_init(struct obj_index *index, struct object_list *list)
+{
+	TEE_MemFill(index, 0, sizeof(*index));
+	index->list = list;
+}
+
+void obj_index_release(struct obj_index *index)
+{
+	unsigned int key = 0;
+
+	assert(!index->count && !index->unindexed);
+
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++) {
+		TEE_Free(index->buckets[key]);
+		index->buckets[key] = NULL;
+	}
+	index->bucket_count = 0;
+}
+
+void obj_index_set_keys(struct pkcs11_object *obj)
+{
+	unsigned int key = 0;
+
+	assert(obj->attributes);
+
+	obj->index_keys = 0;
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++)
+		if (get_index_hash(obj->attributes, key, obj->index_hash + key))
+			obj->index_keys |= BIT(key);
+
+	obj->index_known = true;
+}
+
+void obj_index_add(struct obj_index *index, struct pkcs11_object *obj)
+{
+	if (!obj->index) {
+		obj->index = index;
+		index->unindexed++;
+	}
+	assert(obj->index == index);
+
+	if (obj->indexed || (!obj->attributes && !obj->index_known))
+		return;
+
+	/* On allocation failure the object is simply left unindexed */
+	if (index->count >= index->bucket_count && !obj_index_grow(index))
+		return;
+
+	if (!obj->index_known)
+		obj_index_set_keys(obj);
+
+	obj_index_link(index, obj);
+	obj->indexed = true;
+	index->count++;
+	index->unindexed--;
+}
+
+void obj_index_remove(struct pkcs11_object *obj)
+{
+	struct obj_index *index = obj->index;
+	unsigned int key = 0;
+
+	if (!index)
+		return;
+
+	if (obj->indexed) {
+		for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++)
+			if (obj->index_keys & BIT(key))
+				LIST_REMOVE(obj, index_link[key]);
+
+		obj->indexed = false;
+		index->count--;
+	} else {
+		index->unindexed--;
+	}
+
+	obj->index = NULL;
+}
+
 struct pkcs11_object *pkcs11_handle2object(uint32_t handle,
 					   struct pkcs11_session *session)
 {
-	return handle_lookup(&session->object_handle_db, handle);
+	struct pkcs11_object *obj = NULL;
+
+	obj = handle_lookup(&session->object_handle_db, handle);
+
+	/* Attributes of a persistent object may have been released */
+	if (obj && obj->uuid && load_persistent_object_attributes(obj))
+		return NULL;
+
+	return obj;
 }
 
 uint32_t pkcs11_object2handle(struct pkcs11_object *obj,
@@ -53,6 +237,12 @@ static void cleanup_volatile_obj_ref(struct pkcs11_object *obj)
 	if (!obj)
 		return;
 
+	assert(!obj->cached);
+	obj_index_remove(obj);
+
+	if (obj->op_handle != TEE_HANDLE_NULL)
+		TEE_FreeOperation(obj->op_handle);
+
 	if (obj->key_handle != TEE_HANDLE_NULL)
 		TEE_FreeTransientObject(obj->key_handle);
 
@@ -86,6 +276,7 @@ void cleanup_persistent_object(struct pkcs11_object *obj,
 
 	obj->attribs_hdl = TEE_HANDLE_NULL;
 	destroy_object_uuid(token, obj);
+	release_persistent_object_attributes(obj);
 
 	LIST_REMOVE(obj, link);
 
@@ -150,13 +341,21 @@ void destroy_object(struct pkcs11_session *session, struct pkcs11_object *obj,
 
 static struct pkcs11_object *create_obj_instance(struct obj_attrs *head)
 {
+	static uint32_t last_instance_id;
 	struct pkcs11_object *obj = NULL;
 
 	obj = TEE_Malloc(sizeof(struct pkcs11_object), TEE_MALLOC_FILL_ZERO);
 	if (!obj)
 		return NULL;
 
+	/* 0 is never used, a processing uses it when bound to no object */
+	last_instance_id++;
+	if (!last_instance_id)
+		last_instance_id++;
+	obj->instance_id = last_instance_id;
+
 	obj->key_handle = TEE_HANDLE_NULL;
+	obj->op_handle = TEE_HANDLE_NULL;
 	obj->attribs_hdl = TEE_HANDLE_NULL;
 	obj->attributes = head;
 
@@ -240,14 +439,17 @@ enum pkcs11_rc create_object(void *sess, struct obj_attrs *head,
 		}
 
 		rc = register_persistent_object(get_session_token(session),
-						obj->uuid);
+						obj);
 		if (rc)
 			goto err;
 
 		LIST_INSERT_HEAD(&session->token->object_list, obj, link);
+		obj_index_add(&session->token->object_index, obj);
+		cache_persistent_object_attributes(obj);
 	} else {
 		rc = PKCS11_CKR_OK;
 		LIST_INSERT_HEAD(get_session_objects(session), obj, link);
+		obj_index_add(&session->object_index, obj);
 	}
 
 	*out_handle = obj_handle;
@@ -296,7 +498,7 @@ enum pkcs11_rc entry_create_object(struct pkcs11_client *client,
 	if (rc)
 		return rc;
 
-	rc = serialargs_alloc_get_attributes(&ctrlargs, &template);
+	rc = serialargs_get_attributes(&ctrlargs, &template);
 	if (rc)
 		return rc;
 
@@ -315,7 +517,7 @@ enum pkcs11_rc entry_create_object(struct pkcs11_client *client,
 					     NULL, PKCS11_FUNCTION_IMPORT,
 					     PKCS11_PROCESSING_IMPORT,
 					     PKCS11_CKO_UNDEFINED_ID);
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 	template = NULL;
 	if (rc)
 		goto out;
@@ -362,7 +564,7 @@ enum pkcs11_rc entry_create_object(struct pkcs11_client *client,
 	     session->handle, obj_handle);
 
 out:
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 	TEE_Free(head);
 
 	return rc;
@@ -455,6 +657,133 @@ static enum pkcs11_rc find_ctx_add(struct pkcs11_find_objects *find_ctx,
 	return PKCS11_CKR_OK;
 }
 
+/* Add the handle of @obj to @find_ctx if the object matches @req_attrs */
+static enum pkcs11_rc find_match_object(struct pkcs11_session *session,
+					struct pkcs11_find_objects *find_ctx,
+					struct obj_attrs *req_attrs,
+					struct pkcs11_object *obj,
+					bool token_object)
+{
+	enum pkcs11_rc rc = PKCS11_CKR_GENERAL_ERROR;
+	uint32_t handle = 0;
+	bool new_load = false;
+
+	if (!token_object) {
+		if (check_access_attrs_against_token(session,
+						     obj->attributes) ||
+		    !attributes_match_reference(obj->attributes, req_attrs))
+			return PKCS11_CKR_OK;
+
+		return find_ctx_add(find_ctx,
+				    pkcs11_object2handle(obj, session));
+	}
+
+	if (!obj->attributes) {
+		rc = load_persistent_object_attributes(obj);
+		if (rc)
+			return PKCS11_CKR_GENERAL_ERROR;
+
+		new_load = true;
+	}
+
+	if (!obj->indexed) {
+		obj_index_add(&session->token->object_index, obj);
+		/* Spare the attribute loading to the next searches */
+		if (obj->indexed)
+			update_persistent_object_index(session->token, obj);
+	}
+
+	if (!obj->attributes ||
+	    check_access_attrs_against_token(session, obj->attributes) ||
+	    !attributes_match_reference(obj->attributes, req_attrs)) {
+		if (new_load)
+			release_persistent_object_attributes(obj);
+
+		return PKCS11_CKR_OK;
+	}
+
+	/* Object may not yet be published in the session */
+	handle = pkcs11_object2handle(obj, session);
+	if (!handle) {
+		handle = handle_get(&session->object_handle_db, obj);
+		if (!handle)
+			return PKCS11_CKR_DEVICE_MEMORY;
+	}
+
+	return find_ctx_add(find_ctx, handle);
+}
+
+/*
+ * Return the index key to use to look up objects matching @req_attrs and
+ * store the key hash value in @hash, or OBJ_INDEX_KEY_COUNT if none applies.
+ */
+static unsigned int find_index_key(struct obj_attrs *req_attrs,
+				   uint32_t *hash)
+{
+	unsigned int key = 0;
+
+	for (key = 0; key < OBJ_INDEX_KEY_COUNT; key++)
+		if (get_index_hash(req_attrs, key, hash))
+			break;
+
+	return key;
+}
+
+static enum pkcs11_rc find_matching_objects(struct pkcs11_session *session,
+					    struct pkcs11_find_objects *ctx,
+					    struct obj_attrs *req_attrs,
+					    struct obj_index *index,
+					    bool token_objects)
+{
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+	struct pkcs11_object *obj = NULL;
+	unsigned int key = 0;
+	uint32_t hash = 0;
+
+	key = find_index_key(req_attrs, &hash);
+
+	if (key == OBJ_INDEX_KEY_COUNT || !index->bucket_count) {
+		LIST_FOREACH(obj, index->list, link) {
+			rc = find_match_object(session, ctx, req_attrs, obj,
+					       token_objects);
+			if (rc)
+				return rc;
+		}
+
+		return PKCS11_CKR_OK;
+	}
+
+	/*
+	 * Only objects which attribute hashes to the same bucket can match,
+	 * other objects of the bucket are filtered out by their hash value.
+	 */
+	LIST_FOREACH(obj, obj_index_bucket(index, key, hash),
+		     index_link[key]) {
+		if (obj->index_hash[key] != hash)
+			continue;
+
+		rc = find_match_object(session, ctx, req_attrs, obj,
+				       token_objects);
+		if (rc)
+			return rc;
+	}
+
+	/* Objects not indexed yet must still be scanned */
+	if (index->unindexed) {
+		LIST_FOREACH(obj, index->list, link) {
+			if (obj->indexed)
+				continue;
+
+			rc = find_match_object(session, ctx, req_attrs, obj,
+					       token_objects);
+			if (rc)
+				return rc;
+		}
+	}
+
+	return PKCS11_CKR_OK;
+}
+
 enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 				       uint32_t ptypes, TEE_Param *params)
 {
@@ -468,7 +797,6 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 	struct pkcs11_session *session = NULL;
 	struct pkcs11_object_head *template = NULL;
 	struct obj_attrs *req_attrs = NULL;
-	struct pkcs11_object *obj = NULL;
 	struct pkcs11_find_objects *find_ctx = NULL;
 
 	if (!client || ptypes != exp_pt)
@@ -480,7 +808,7 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 	if (rc)
 		return rc;
 
-	rc = serialargs_alloc_get_attributes(&ctrlargs, &template);
+	rc = serialargs_get_attributes(&ctrlargs, &template);
 	if (rc)
 		return rc;
 
@@ -514,7 +842,7 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 		goto out;
 	}
 
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 	template = NULL;
 
 	switch (get_class(req_attrs)) {
@@ -534,58 +862,18 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 	}
 
 	/*
-	 * Scan all objects (sessions and persistent ones) and set a list of
-	 * candidates that match caller attributes.
+	 * Look up all objects (sessions and persistent ones) and set a list
+	 * of candidates that match caller attributes.
 	 */
+	rc = find_matching_objects(session, find_ctx, req_attrs,
+				   &session->object_index, false);
+	if (rc)
+		goto out;
 
-	LIST_FOREACH(obj, &session->object_list, link) {
-		if (check_access_attrs_against_token(session, obj->attributes))
-			continue;
-
-		if (!attributes_match_reference(obj->attributes, req_attrs))
-			continue;
-
-		rc = find_ctx_add(find_ctx, pkcs11_object2handle(obj, session));
-		if (rc)
-			goto out;
-	}
-
-	LIST_FOREACH(obj, &session->token->object_list, link) {
-		uint32_t handle = 0;
-		bool new_load = false;
-
-		if (!obj->attributes) {
-			rc = load_persistent_object_attributes(obj);
-			if (rc)
-				return PKCS11_CKR_GENERAL_ERROR;
-
-			new_load = true;
-		}
-
-		if (!obj->attributes ||
-		    check_access_attrs_against_token(session,
-						     obj->attributes) ||
-		    !attributes_match_reference(obj->attributes, req_attrs)) {
-			if (new_load)
-				release_persistent_object_attributes(obj);
-
-			continue;
-		}
-
-		/* Object may not yet be published in the session */
-		handle = pkcs11_object2handle(obj, session);
-		if (!handle) {
-			handle = handle_get(&session->object_handle_db, obj);
-			if (!handle) {
-				rc = PKCS11_CKR_DEVICE_MEMORY;
-				goto out;
-			}
-		}
-
-		rc = find_ctx_add(find_ctx, handle);
-		if (rc)
-			goto out;
-	}
+	rc = find_matching_objects(session, find_ctx, req_attrs,
+				   &session->token->object_index, true);
+	if (rc)
+		goto out;
 
 	find_ctx->attributes = req_attrs;
 	req_attrs = NULL;
@@ -595,7 +883,7 @@ enum pkcs11_rc entry_find_objects_init(struct pkcs11_client *client,
 
 out:
 	TEE_Free(req_attrs);
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 	release_find_obj_context(find_ctx);
 
 	return rc;
@@ -724,7 +1012,7 @@ uint32_t entry_get_attribute_value(struct pkcs11_client *client,
 	if (rc)
 		return rc;
 
-	rc = serialargs_alloc_get_attributes(&ctrlargs, &template);
+	rc = serialargs_get_attributes(&ctrlargs, &template);
 	if (rc)
 		return rc;
 
@@ -835,7 +1123,7 @@ uint32_t entry_get_attribute_value(struct pkcs11_client *client,
 	     session->handle, object_handle);
 
 out:
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 
 	return rc;
 }
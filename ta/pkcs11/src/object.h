@@ -14,19 +14,47 @@ struct ck_token;
 struct obj_attrs;
 struct pkcs11_client;
 struct pkcs11_session;
+struct obj_index;
+
+/* Attributes used as keys of the object lookup indexes */
+enum obj_index_key {
+	OBJ_INDEX_ID,
+	OBJ_INDEX_LABEL,
+	OBJ_INDEX_KEY_COUNT,
+};
 
 /*
  * link: objects are referenced in a double-linked list
+ * index_link: links in the index buckets of the object owner
+ * index: index of the object owner the object is tracked by, or NULL
+ * index_hash: hash values of the indexed attributes of the object
+ * index_keys: bit mask of the indexed attributes found in the object
+ * index_known: true once index_hash and index_keys are set
+ * indexed: true if the object is linked in the index buckets
  * attributes: pointer to the serialized object attributes
+ * cache_link: link in the cache of loaded persistent object attributes
+ * cached: true if the object is linked in the persistent attributes cache
  * key_handle: GPD TEE object handle if used in an operation
+ * op_handle: idle GPD TEE operation using key_handle, ready for reuse
+ * instance_id: unique ID telling the object from a later one reusing its handle
  * key_type: GPD TEE key type (shortcut used for processing)
  * uuid: object UUID in the persistent database if a persistent object, or NULL
  * attribs_hdl: GPD TEE attributes handles if persistent object
  */
 struct pkcs11_object {
 	LIST_ENTRY(pkcs11_object) link;
+	LIST_ENTRY(pkcs11_object) index_link[OBJ_INDEX_KEY_COUNT];
+	struct obj_index *index;
+	uint32_t index_hash[OBJ_INDEX_KEY_COUNT];
+	uint32_t index_keys;
+	bool index_known;
+	bool indexed;
 	struct obj_attrs *attributes;
+	TAILQ_ENTRY(pkcs11_object) cache_link;
+	bool cached;
 	TEE_ObjectHandle key_handle;
+	TEE_OperationHandle op_handle;
+	uint32_t instance_id;
 	uint32_t key_type;
 	TEE_UUID *uuid;
 	TEE_ObjectHandle attribs_hdl;
@@ -34,6 +62,37 @@ struct pkcs11_object {
 
 LIST_HEAD(object_list, pkcs11_object);
 
+/*
+ * struct obj_index - hash indexes of the objects of a session or a token
+ * @list: List of the objects the index applies to
+ * @buckets: Per key array of @bucket_count lists of objects
+ * @bucket_count: Number of buckets per key, a power of 2 or 0 when empty
+ * @count: Number of objects linked in the buckets
+ * @unindexed: Number of objects of @list not yet linked in the buckets,
+ *	typically persistent objects which attributes were never loaded
+ */
+struct obj_index {
+	struct object_list *list;
+	struct object_list *buckets[OBJ_INDEX_KEY_COUNT];
+	uint32_t bucket_count;
+	uint32_t count;
+	uint32_t unindexed;
+};
+
+void obj_index_init(struct obj_index *index, struct object_list *list);
+void obj_index_release(struct obj_index *index);
+
+/*
+ * Track an object inserted in index->list. The object is linked in the
+ * index buckets once its attributes or its index hash values are available,
+ * until then searches fall back to a scan of the unindexed objects.
+ */
+void obj_index_add(struct obj_index *index, struct pkcs11_object *obj);
+void obj_index_remove(struct pkcs11_object *obj);
+
+/* Set the index hash values of an object from its attributes */
+void obj_index_set_keys(struct pkcs11_object *obj);
+
 struct pkcs11_object *pkcs11_handle2object(uint32_t client_handle,
 					   struct pkcs11_session *session);
 
@@ -10,11 +10,20 @@
 #include <tee_internal_api_extensions.h>
 #include <util.h>
 
+#include "attributes.h"
 #include "pkcs11_token.h"
 #include "pkcs11_helpers.h"
 
 #define PERSISTENT_OBJECT_ID_LEN	32
 
+/* Number of unused UUID slots the object database file may end with */
+#define PERSISTENT_DB_SLACK		32
+
+/* Loaded persistent object attributes, least recently used first */
+static TAILQ_HEAD(, pkcs11_object) attrs_cache =
+	TAILQ_HEAD_INITIALIZER(attrs_cache);
+static size_t attrs_cache_size;
+
 /*
  * Token persistent objects
  *
@@ -289,6 +298,18 @@ void close_persistent_db(struct ck_token *token __unused)
 {
 }
 
+static bool find_uuid(struct token_persistent_objs *db_objs, size_t count,
+		      TEE_UUID *uuid)
+{
+	size_t i = 0;
+
+	for (i = 0; i < count; i++)
+		if (!TEE_MemCompare(db_objs->uuids + i, uuid, sizeof(TEE_UUID)))
+			return true;
+
+	return false;
+}
+
 static int get_persistent_obj_idx(struct ck_token *token, TEE_UUID *uuid)
 {
 	size_t i = 0;
@@ -347,13 +368,191 @@ enum pkcs11_rc get_persistent_objects_list(struct ck_token *token,
 	return PKCS11_CKR_OK;
 }
 
+/*
+ * The object UUID list is updated in place: registering an object appends
+ * its UUID, unregistering one moves the last UUID into its slot. A UUID is
+ * always written before the count that makes it part of the list, so an
+ * interrupted update leaves at worst the last UUID duplicated, which is
+ * dropped at load.
+ */
+static TEE_Result write_db_objs_count(TEE_ObjectHandle db_hdl, uint32_t count)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main),
+				 TEE_DATA_SEEK_SET);
+	if (res)
+		return res;
+
+	return TEE_WriteObjectData(db_hdl, &count, sizeof(count));
+}
+
+static TEE_Result write_db_objs_uuid(TEE_ObjectHandle db_hdl, size_t idx,
+				     TEE_UUID *uuid)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main) +
+				 sizeof(struct token_persistent_objs) +
+				 idx * sizeof(TEE_UUID), TEE_DATA_SEEK_SET);
+	if (res)
+		return res;
+
+	return TEE_WriteObjectData(db_hdl, uuid, sizeof(*uuid));
+}
+
+/* Drop the unused end of the database once large enough */
+static void compact_db_file(TEE_ObjectHandle db_hdl, uint32_t count)
+{
+	size_t size = sizeof(struct token_persistent_main) +
+		      sizeof(struct token_persistent_objs) +
+		      count * sizeof(TEE_UUID);
+	TEE_ObjectInfo info = { };
+
+	if (TEE_GetObjectInfo1(db_hdl, &info))
+		return;
+
+	if (info.dataSize > size + PERSISTENT_DB_SLACK * sizeof(TEE_UUID) &&
+	    TEE_TruncateObjectData(db_hdl, size))
+		DMSG("Failed to compact database");
+}
+
+/*
+ * The object index file stores a struct token_persistent_index record per
+ * object, at the position of the object UUID in the database, so that the
+ * objects can be indexed at token initialization without loading their
+ * attributes. The file is only a hint: a record which UUID doesn't match
+ * the database is ignored and the object is indexed once its attributes
+ * are loaded.
+ */
+static TEE_Result open_index_file(struct ck_token *token, bool create,
+				  TEE_ObjectHandle *out_hdl)
+{
+	char file[PERSISTENT_OBJECT_ID_LEN] = { };
+	uint32_t flags = TEE_DATA_FLAG_ACCESS_READ | TEE_DATA_FLAG_ACCESS_WRITE;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	int n = 0;
+
+	n = snprintf(file, sizeof(file), "token.idx.%u", get_token_id(token));
+	if (n < 0 || (size_t)n >= sizeof(file))
+		return TEE_ERROR_SECURITY;
+
+	res = TEE_OpenPersistentObject(TEE_STORAGE_PRIVATE, file, sizeof(file),
+				       flags, out_hdl);
+	if (res == TEE_ERROR_ITEM_NOT_FOUND && create)
+		res = TEE_CreatePersistentObject(TEE_STORAGE_PRIVATE,
+						 file, sizeof(file), flags,
+						 TEE_HANDLE_NULL, NULL, 0,
+						 out_hdl);
+
+	return res;
+}
+
+static TEE_Result write_index_record(TEE_ObjectHandle hdl, size_t idx,
+				     struct token_persistent_index *rec)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = TEE_SeekObjectData(hdl, idx * sizeof(*rec), TEE_DATA_SEEK_SET);
+	if (res)
+		return res;
+
+	return TEE_WriteObjectData(hdl, rec, sizeof(*rec));
+}
+
+static void store_index_record(struct ck_token *token, size_t idx,
+			       struct pkcs11_object *obj)
+{
+	struct token_persistent_index rec = { };
+	TEE_ObjectHandle hdl = TEE_HANDLE_NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!obj->index_known)
+		obj_index_set_keys(obj);
+
+	TEE_MemMove(&rec.uuid, obj->uuid, sizeof(rec.uuid));
+	rec.keys = obj->index_keys;
+	TEE_MemMove(rec.hash, obj->index_hash, sizeof(rec.hash));
+
+	res = open_index_file(token, true, &hdl);
+	if (!res) {
+		res = write_index_record(hdl, idx, &rec);
+		TEE_CloseObject(hdl);
+	}
+
+	if (res)
+		DMSG("Failed to update object index: %#"PRIx32, res);
+}
+
+/* Move the last index record in the slot @idx and drop the last slot */
+static void remove_index_record(struct ck_token *token, size_t idx,
+				size_t last)
+{
+	struct token_persistent_index rec = { };
+	TEE_ObjectHandle hdl = TEE_HANDLE_NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t size = sizeof(rec);
+
+	res = open_index_file(token, false, &hdl);
+	if (res == TEE_ERROR_ITEM_NOT_FOUND)
+		return;
+
+	if (!res && idx != last) {
+		res = TEE_SeekObjectData(hdl, last * sizeof(rec),
+					 TEE_DATA_SEEK_SET);
+		if (!res)
+			res = TEE_ReadObjectData(hdl, &rec, size, &size);
+		/* A missing record leaves a stale one, which is ignored */
+		if (!res && size == sizeof(rec))
+			res = write_index_record(hdl, idx, &rec);
+	}
+
+	if (!res)
+		res = TEE_TruncateObjectData(hdl, last * sizeof(rec));
+
+	if (res)
+		DMSG("Failed to update object index: %#"PRIx32, res);
+	TEE_CloseObject(hdl);
+}
+
+/* Return the index records of the @count objects of the database, or NULL */
+static struct token_persistent_index *load_index_records(struct ck_token *token,
+							 size_t count)
+{
+	struct token_persistent_index *recs = NULL;
+	TEE_ObjectHandle hdl = TEE_HANDLE_NULL;
+	uint32_t size = count * sizeof(*recs);
+
+	if (!count || open_index_file(token, false, &hdl))
+		return NULL;
+
+	/* Records missing from a short file are left zeroed, thus ignored */
+	recs = TEE_Malloc(size, TEE_MALLOC_FILL_ZERO);
+	if (recs && TEE_ReadObjectData(hdl, recs, size, &size)) {
+		TEE_Free(recs);
+		recs = NULL;
+	}
+
+	TEE_CloseObject(hdl);
+
+	return recs;
+}
+
+void update_persistent_object_index(struct ck_token *token,
+				    struct pkcs11_object *obj)
+{
+	int idx = get_persistent_obj_idx(token, obj->uuid);
+
+	if (idx >= 0)
+		store_index_record(token, idx, obj);
+}
+
 enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 					    TEE_UUID *uuid)
 {
 	TEE_ObjectHandle db_hdl = TEE_HANDLE_NULL;
-	struct token_persistent_objs *ptr = NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
-	int count = 0;
+	uint32_t last = 0;
 	int idx = 0;
 
 	if (!uuid)
@@ -365,58 +564,45 @@ enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 		return PKCS11_RV_NOT_FOUND;
 	}
 
-	ptr = TEE_Malloc(sizeof(struct token_persistent_objs) +
-			 ((token->db_objs->count - 1) * sizeof(TEE_UUID)),
-			 TEE_USER_MEM_HINT_NO_FILL_ZERO);
-	if (!ptr)
-		return PKCS11_CKR_DEVICE_MEMORY;
-
 	res = open_db_file(token, &db_hdl);
 	if (res)
 		goto out;
 
-	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main),
-				 TEE_DATA_SEEK_SET);
-	if (res) {
-		DMSG("Failed to read database");
-		goto out;
+	last = token->db_objs->count - 1;
+	if ((uint32_t)idx != last) {
+		res = write_db_objs_uuid(db_hdl, idx,
+					 token->db_objs->uuids + last);
+		if (res)
+			goto out;
 	}
 
-	TEE_MemMove(ptr, token->db_objs,
-		    sizeof(struct token_persistent_objs) +
-		    idx * sizeof(TEE_UUID));
+	res = write_db_objs_count(db_hdl, last);
+	if (res)
+		goto out;
 
-	ptr->count--;
-	count = ptr->count - idx;
+	TEE_MemMove(token->db_objs->uuids + idx, token->db_objs->uuids + last,
+		    sizeof(TEE_UUID));
+	token->db_objs->count = last;
 
-	TEE_MemMove(&ptr->uuids[idx],
-		    &token->db_objs->uuids[idx + 1],
-		    count * sizeof(TEE_UUID));
+	compact_db_file(db_hdl, last);
+	remove_index_record(token, idx, last);
 
-	res = TEE_WriteObjectData(db_hdl, ptr,
-				  sizeof(struct token_persistent_objs) +
-				  ptr->count * sizeof(TEE_UUID));
+out:
 	if (res)
 		DMSG("Failed to update database");
-	TEE_Free(token->db_objs);
-	token->db_objs = ptr;
-	ptr = NULL;
-
-out:
 	TEE_CloseObject(db_hdl);
-	TEE_Free(ptr);
 
 	return tee2pkcs_error(res);
 }
 
 enum pkcs11_rc register_persistent_object(struct ck_token *token,
-					  TEE_UUID *uuid)
+					  struct pkcs11_object *obj)
 {
+	TEE_UUID *uuid = obj->uuid;
 	TEE_ObjectHandle db_hdl = TEE_HANDLE_NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
 	void *ptr = NULL;
-	size_t size = 0;
-	int count = 0;
+	uint32_t count = 0;
 
 	if (get_persistent_obj_idx(token, uuid) >= 0)
 		TEE_Panic(0);
@@ -431,30 +617,20 @@ enum pkcs11_rc register_persistent_object(struct ck_token *token,
 	token->db_objs = ptr;
 	TEE_MemMove(token->db_objs->uuids + count, uuid, sizeof(TEE_UUID));
 
-	size = sizeof(struct token_persistent_main) +
-	       sizeof(struct token_persistent_objs) +
-	       count * sizeof(TEE_UUID);
-
 	res = open_db_file(token, &db_hdl);
 	if (res)
 		goto out;
 
-	res = TEE_TruncateObjectData(db_hdl, size + sizeof(TEE_UUID));
+	res = write_db_objs_uuid(db_hdl, count, uuid);
 	if (res)
 		goto out;
 
-	res = TEE_SeekObjectData(db_hdl, sizeof(struct token_persistent_main),
-				 TEE_DATA_SEEK_SET);
+	res = write_db_objs_count(db_hdl, count + 1);
 	if (res)
 		goto out;
 
 	token->db_objs->count++;
-
-	res = TEE_WriteObjectData(db_hdl, token->db_objs,
-				  sizeof(struct token_persistent_objs) +
-				  token->db_objs->count * sizeof(TEE_UUID));
-	if (res)
-		token->db_objs->count--;
+	store_index_record(token, count, obj);
 
 out:
 	TEE_CloseObject(db_hdl);
@@ -471,8 +647,12 @@ enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj)
 	struct obj_attrs *attr = NULL;
 	uint32_t read_bytes = 0;
 
-	if (obj->attributes)
+	if (obj->attributes) {
+		if (obj->cached)
+			cache_persistent_object_attributes(obj);
+
 		return PKCS11_CKR_OK;
+	}
 
 	if (hdl == TEE_HANDLE_NULL) {
 		res = TEE_OpenPersistentObject(TEE_STORAGE_PRIVATE,
@@ -518,8 +698,14 @@ enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj)
 		goto out;
 	}
 
+	/* Objects stored before attributes were sorted */
+	rc = sort_attributes(&attr);
+	if (rc)
+		goto out;
+
 	obj->attributes = attr;
 	attr = NULL;
+	cache_persistent_object_attributes(obj);
 
 	rc = PKCS11_CKR_OK;
 
@@ -532,12 +718,44 @@ out:
 	return rc;
 }
 
+static size_t get_attributes_size(struct obj_attrs *attrs)
+{
+	return sizeof(*attrs) + attrs->attrs_size;
+}
+
 void release_persistent_object_attributes(struct pkcs11_object *obj)
 {
+	if (obj->cached) {
+		TAILQ_REMOVE(&attrs_cache, obj, cache_link);
+		attrs_cache_size -= get_attributes_size(obj->attributes);
+		obj->cached = false;
+	}
+
 	TEE_Free(obj->attributes);
 	obj->attributes = NULL;
 }
 
+/* Track or refresh the loaded attributes of a persistent object */
+void cache_persistent_object_attributes(struct pkcs11_object *obj)
+{
+	assert(obj->uuid && obj->attributes);
+
+	if (obj->cached) {
+		TAILQ_REMOVE(&attrs_cache, obj, cache_link);
+	} else {
+		attrs_cache_size += get_attributes_size(obj->attributes);
+		obj->cached = true;
+	}
+
+	TAILQ_INSERT_TAIL(&attrs_cache, obj, cache_link);
+}
+
+void trim_persistent_attributes_cache(void)
+{
+	while (attrs_cache_size > CFG_PKCS11_TA_ATTRS_CACHE_SIZE)
+		release_persistent_object_attributes(TAILQ_FIRST(&attrs_cache));
+}
+
 /*
  * Return the token instance, either initialized from reset or initialized
  * from the token persistent state if found.
@@ -550,12 +768,14 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 	/* Copy persistent database: main db and object db */
 	struct token_persistent_main *db_main = NULL;
 	struct token_persistent_objs *db_objs = NULL;
+	struct token_persistent_index *index = NULL;
 	void *ptr = NULL;
 
 	if (!token)
 		return NULL;
 
 	LIST_INIT(&token->object_list);
+	obj_index_init(&token->object_index, &token->object_list);
 
 	db_main = TEE_Malloc(sizeof(*db_main), TEE_MALLOC_FILL_ZERO);
 	db_objs = TEE_Malloc(sizeof(*db_objs), TEE_MALLOC_FILL_ZERO);
@@ -592,8 +812,18 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 						 &size);
 			if (res || size != (db_objs->count * sizeof(TEE_UUID)))
 				TEE_Panic(0);
+
+			/* Complete an interrupted unregistration */
+			idx = db_objs->count - 1;
+			if (find_uuid(db_objs, idx, db_objs->uuids + idx)) {
+				if (write_db_objs_count(db_hdl, idx))
+					TEE_Panic(0);
+				db_objs->count = idx;
+			}
 		}
 
+		index = load_index_records(token, db_objs->count);
+
 		for (idx = 0; idx < db_objs->count; idx++) {
 			/* Create an empty object instance */
 			struct pkcs11_object *obj = NULL;
@@ -610,9 +840,21 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 			if (!obj)
 				TEE_Panic(0);
 
+			/* Index the object without loading its attributes */
+			if (index && !TEE_MemCompare(&index[idx].uuid, uuid,
+						     sizeof(*uuid))) {
+				obj->index_keys = index[idx].keys;
+				TEE_MemMove(obj->index_hash, index[idx].hash,
+					    sizeof(obj->index_hash));
+				obj->index_known = true;
+			}
+
 			LIST_INSERT_HEAD(&token->object_list, obj, link);
+			obj_index_add(&token->object_index, obj);
 		}
 
+		TEE_Free(index);
+		index = NULL;
 	} else if (res == TEE_ERROR_ITEM_NOT_FOUND) {
 		char file[PERSISTENT_OBJECT_ID_LEN] = { };
 
@@ -673,6 +915,7 @@ struct ck_token *init_persistent_db(unsigned int token_id)
 	return token;
 
 error:
+	TEE_Free(index);
 	TEE_Free(db_main);
 	TEE_Free(db_objs);
 	if (db_hdl != TEE_HANDLE_NULL)
@@ -175,6 +175,7 @@ static const struct any_id __maybe_unused string_ta_cmd[] = {
 	PKCS11_ID(PKCS11_CMD_FIND_OBJECTS_FINAL),
 	PKCS11_ID(PKCS11_CMD_GET_OBJECT_SIZE),
 	PKCS11_ID(PKCS11_CMD_GET_ATTRIBUTE_VALUE),
+	PKCS11_ID(PKCS11_CMD_PROCESSING_BATCH),
 };
 
 static const struct any_id __maybe_unused string_slot_flags[] = {
@@ -635,6 +635,7 @@ enum pkcs11_rc entry_ck_open_session(struct pkcs11_client *client,
 	session->client = client;
 
 	LIST_INIT(&session->object_list);
+	obj_index_init(&session->object_index, &session->object_list);
 	handle_db_init(&session->object_handle_db);
 
 	set_session_state(client, session, readonly);
@@ -663,6 +664,7 @@ static void close_ck_session(struct pkcs11_session *session)
 			       LIST_FIRST(&session->object_list), true);
 
 	release_session_find_obj_context(session);
+	obj_index_release(&session->object_index);
 
 	TAILQ_REMOVE(&session->client->session_list, session, link);
 	handle_put(&session->client->session_handle_db, session->handle);
@@ -1305,8 +1307,12 @@ static void session_logout(struct pkcs11_session *session)
 		 */
 		LIST_FOREACH(obj, &session->token->object_list, link) {
 			handle = pkcs11_object2handle(obj, session);
+			if (!handle)
+				continue;
 
-			if (handle && object_is_private(obj->attributes))
+			/* Drop the handle if the object cannot be checked */
+			if (load_persistent_object_attributes(obj) ||
+			    object_is_private(obj->attributes))
 				handle_put(&sess->object_handle_db, handle);
 		}
 
@@ -86,6 +86,19 @@ struct token_persistent_objs {
 	TEE_UUID uuids[];
 };
 
+/*
+ * Index record of a persistent object, searchable attributes only
+ *
+ * @uuid - reference/UUID of the object the record applies to
+ * @keys - bit mask of the indexed attributes found in the object
+ * @hash - hash values of the indexed attributes
+ */
+struct token_persistent_index {
+	TEE_UUID uuid;
+	uint32_t keys;
+	uint32_t hash[OBJ_INDEX_KEY_COUNT];
+};
+
 /*
  * Runtime state of the token, complies with pkcs11
  *
@@ -93,6 +106,7 @@ struct token_persistent_objs {
  * @session_count - Counter for opened Pkcs11 sessions
  * @rw_session_count - Count for opened Pkcs11 read/write sessions
  * @object_list - List of the objects owned by the token
+ * @object_index - Lookup index of the objects owned by the token
  * @db_main - Volatile copy of the persistent main database
  * @db_objs - Volatile copy of the persistent object database
  */
@@ -101,6 +115,7 @@ struct ck_token {
 	uint32_t session_count;
 	uint32_t rw_session_count;
 	struct object_list object_list;
+	struct obj_index object_index;
 	/* Copy in RAM of the persistent database */
 	struct token_persistent_main *db_main;
 	struct token_persistent_objs *db_objs;
@@ -137,6 +152,10 @@ enum pkcs11_proc_state {
  * @updated - true once an active operation is updated
  * @tee_op_handle - handle on active crypto operation or TEE_HANDLE_NULL
  * @extra_ctx - context for the active processing
+ * @key_obj_handle - handle of the key object @tee_op_handle is returned to
+ *                   once the processing is released, 0 if none
+ * @key_obj_id - instance ID of the key object of @key_obj_handle
+ * @key_set - true once the key is set in @tee_op_handle
  */
 struct active_processing {
 	enum pkcs11_proc_state state;
@@ -146,6 +165,9 @@ struct active_processing {
 	bool updated;
 	TEE_OperationHandle tee_op_handle;
 	void *extra_ctx;
+	uint32_t key_obj_handle;
+	uint32_t key_obj_id;
+	bool key_set;
 };
 
 /*
@@ -171,6 +193,7 @@ struct pkcs11_find_objects {
  * @token - Token this session belongs to
  * @handle - Identifier of the session published to the client
  * @object_list - Entry of the session objects list
+ * @object_index - Lookup index of the session objects
  * @object_handle_db - Database for object handles published by the session
  * @state - R/W SO, R/W user, RO user, R/W public, RO public.
  * @processing - Reference to initialized processing context if any
@@ -182,6 +205,7 @@ struct pkcs11_session {
 	struct ck_token *token;
 	enum pkcs11_mechanism_id handle;
 	struct object_list object_list;
+	struct obj_index object_index;
 	struct handle_db object_handle_db;
 	enum pkcs11_session_state state;
 	struct active_processing *processing;
@@ -203,9 +227,17 @@ struct ck_token *init_persistent_db(unsigned int token_id);
 void update_persistent_db(struct ck_token *token);
 void close_persistent_db(struct ck_token *token);
 
-/* Load and release persistent object attributes in memory */
+/*
+ * Load and release persistent object attributes in memory
+ *
+ * Loaded attributes are cached until the attributes of the least recently
+ * used objects exceed CFG_PKCS11_TA_ATTRS_CACHE_SIZE bytes, they are then
+ * released by trim_persistent_attributes_cache() at the end of a command.
+ */
 enum pkcs11_rc load_persistent_object_attributes(struct pkcs11_object *obj);
 void release_persistent_object_attributes(struct pkcs11_object *obj);
+void cache_persistent_object_attributes(struct pkcs11_object *obj);
+void trim_persistent_attributes_cache(void);
 
 enum pkcs11_rc hash_pin(enum pkcs11_user_type user, const uint8_t *pin,
 			size_t pin_size, uint32_t *salt,
@@ -253,7 +285,9 @@ void destroy_object_uuid(struct ck_token *token, struct pkcs11_object *obj);
 enum pkcs11_rc unregister_persistent_object(struct ck_token *token,
 					    TEE_UUID *uuid);
 enum pkcs11_rc register_persistent_object(struct ck_token *token,
-					  TEE_UUID *uuid);
+					  struct pkcs11_object *obj);
+void update_persistent_object_index(struct ck_token *token,
+				    struct pkcs11_object *obj);
 enum pkcs11_rc get_persistent_objects_list(struct ck_token *token,
 					   TEE_UUID *array, size_t *size);
 
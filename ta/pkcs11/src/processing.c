@@ -70,13 +70,40 @@ static enum pkcs11_rc get_active_session(struct pkcs11_session *session,
 	return rc;
 }
 
+/*
+ * Return the TEE operation of the released processing to its key object
+ * so that the next processing with the same key and mechanism doesn't
+ * need to allocate an operation and set the key again.
+ */
+static bool cache_tee_operation(struct pkcs11_session *session)
+{
+	struct active_processing *proc = session->processing;
+	struct pkcs11_object *obj = NULL;
+
+	if (!proc->key_obj_handle || !proc->key_set)
+		return false;
+
+	obj = pkcs11_handle2object(proc->key_obj_handle, session);
+	if (!obj || obj->instance_id != proc->key_obj_id)
+		return false;
+
+	if (obj->op_handle != TEE_HANDLE_NULL)
+		TEE_FreeOperation(obj->op_handle);
+
+	TEE_ResetOperation(proc->tee_op_handle);
+	obj->op_handle = proc->tee_op_handle;
+
+	return true;
+}
+
 void release_active_processing(struct pkcs11_session *session)
 {
 	if (!session->processing)
 		return;
 
 	if (session->processing->tee_op_handle != TEE_HANDLE_NULL) {
-		TEE_FreeOperation(session->processing->tee_op_handle);
+		if (!cache_tee_operation(session))
+			TEE_FreeOperation(session->processing->tee_op_handle);
 		session->processing->tee_op_handle = TEE_HANDLE_NULL;
 	}
 
@@ -179,11 +206,11 @@ enum pkcs11_rc entry_generate_secret(struct pkcs11_client *client,
 	if (rc)
 		return rc;
 
-	rc = serialargs_alloc_get_one_attribute(&ctrlargs, &proc_params);
+	rc = serialargs_get_one_attribute(&ctrlargs, &proc_params);
 	if (rc)
 		goto out;
 
-	rc = serialargs_alloc_get_attributes(&ctrlargs, &template);
+	rc = serialargs_get_attributes(&ctrlargs, &template);
 	if (rc)
 		goto out;
 
@@ -217,7 +244,7 @@ enum pkcs11_rc entry_generate_secret(struct pkcs11_client *client,
 	if (rc)
 		goto out;
 
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, template);
 	template = NULL;
 
 	rc = check_created_attrs(head, NULL);
@@ -251,7 +278,7 @@ enum pkcs11_rc entry_generate_secret(struct pkcs11_client *client,
 		goto out;
 	}
 
-	TEE_Free(proc_params);
+	serialargs_release(&ctrlargs, proc_params);
 	proc_params = NULL;
 
 	/*
@@ -276,13 +303,63 @@ enum pkcs11_rc entry_generate_secret(struct pkcs11_client *client,
 	     session->handle, obj_handle);
 
 out:
-	TEE_Free(proc_params);
-	TEE_Free(template);
+	serialargs_release(&ctrlargs, proc_params);
+	serialargs_release(&ctrlargs, template);
 	TEE_Free(head);
 
 	return rc;
 }
 
+static enum pkcs11_rc processing_init(struct pkcs11_session *session,
+				      enum processing_func function,
+				      uint32_t key_handle,
+				      struct pkcs11_attribute_head *proc_params)
+{
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+	struct pkcs11_object *obj = NULL;
+
+	rc = get_ready_session(session);
+	if (rc)
+		return rc;
+
+	obj = pkcs11_handle2object(key_handle, session);
+	if (!obj)
+		return PKCS11_CKR_KEY_HANDLE_INVALID;
+
+	rc = set_processing_state(session, function, obj, NULL);
+	if (rc)
+		return rc;
+
+	rc = check_mechanism_against_processing(session, proc_params->id,
+						function,
+						PKCS11_FUNC_STEP_INIT);
+	if (rc)
+		return rc;
+
+	rc = check_parent_attrs_against_processing(proc_params->id, function,
+						   obj->attributes);
+	if (rc)
+		return rc;
+
+	rc = check_access_attrs_against_token(session, obj->attributes);
+	if (rc)
+		return rc;
+
+	if (processing_is_tee_symm(proc_params->id))
+		rc = init_symm_operation(session, function, proc_params, obj);
+	else
+		rc = PKCS11_CKR_MECHANISM_INVALID;
+
+	if (rc == PKCS11_CKR_OK) {
+		session->processing->mecha_type = proc_params->id;
+		DMSG("PKCS11 session %"PRIu32": init processing %s %s",
+		     session->handle, id2str_proc(proc_params->id),
+		     id2str_function(function));
+	}
+
+	return rc;
+}
+
 /*
  * entry_processing_init - Generic entry for initializing a processing
  *
@@ -305,7 +382,6 @@ enum pkcs11_rc entry_processing_init(struct pkcs11_client *client,
 	struct pkcs11_session *session = NULL;
 	struct pkcs11_attribute_head *proc_params = NULL;
 	uint32_t key_handle = 0;
-	struct pkcs11_object *obj = NULL;
 
 	if (!client || ptypes != exp_pt)
 		return PKCS11_CKR_ARGUMENTS_BAD;
@@ -320,7 +396,7 @@ enum pkcs11_rc entry_processing_init(struct pkcs11_client *client,
 	if (rc)
 		return rc;
 
-	rc = serialargs_alloc_get_one_attribute(&ctrlargs, &proc_params);
+	rc = serialargs_get_one_attribute(&ctrlargs, &proc_params);
 	if (rc)
 		return rc;
 
@@ -329,52 +405,13 @@ enum pkcs11_rc entry_processing_init(struct pkcs11_client *client,
 		goto out;
 	}
 
-	rc = get_ready_session(session);
-	if (rc)
-		goto out;
-
-	obj = pkcs11_handle2object(key_handle, session);
-	if (!obj) {
-		rc = PKCS11_CKR_KEY_HANDLE_INVALID;
-		goto out;
-	}
-
-	rc = set_processing_state(session, function, obj, NULL);
-	if (rc)
-		goto out;
-
-	rc = check_mechanism_against_processing(session, proc_params->id,
-						function,
-						PKCS11_FUNC_STEP_INIT);
-	if (rc)
-		goto out;
-
-	rc = check_parent_attrs_against_processing(proc_params->id, function,
-						   obj->attributes);
-	if (rc)
-		goto out;
-
-	rc = check_access_attrs_against_token(session, obj->attributes);
-	if (rc)
-		goto out;
-
-	if (processing_is_tee_symm(proc_params->id))
-		rc = init_symm_operation(session, function, proc_params, obj);
-	else
-		rc = PKCS11_CKR_MECHANISM_INVALID;
-
-	if (rc == PKCS11_CKR_OK) {
-		session->processing->mecha_type = proc_params->id;
-		DMSG("PKCS11 session %"PRIu32": init processing %s %s",
-		     session->handle, id2str_proc(proc_params->id),
-		     id2str_function(function));
-	}
+	rc = processing_init(session, function, key_handle, proc_params);
 
 out:
 	if (rc && session)
 		release_active_processing(session);
 
-	TEE_Free(proc_params);
+	serialargs_release(&ctrlargs, proc_params);
 
 	return rc;
 }
@@ -450,3 +487,240 @@ out:
 
 	return rc;
 }
+
+/*
+ * Processing kept active by entry_processing_batch() for the next
+ * processing of the batch if it uses the same session, function, key
+ * and mechanism.
+ */
+struct batch_state {
+	struct pkcs11_session *session;
+	enum processing_func function;
+	uint32_t key_handle;
+	struct pkcs11_attribute_head *proc_params;
+};
+
+static void batch_release(struct batch_state *state)
+{
+	if (state->session)
+		release_active_processing(state->session);
+	TEE_Free(state->proc_params);
+	*state = (struct batch_state){ };
+}
+
+static bool batch_can_reuse(struct batch_state *state,
+			    struct pkcs11_session *session,
+			    enum processing_func function, uint32_t key_handle,
+			    struct pkcs11_attribute_head *proc_params)
+{
+	return state->session == session && state->function == function &&
+	       state->key_handle == key_handle &&
+	       state->proc_params->size == proc_params->size &&
+	       !TEE_MemCompare(state->proc_params, proc_params,
+			       sizeof(*proc_params) + proc_params->size);
+}
+
+static enum pkcs11_rc batch_oneshot(struct batch_state *state,
+				    struct pkcs11_session *session,
+				    enum processing_func function,
+				    uint32_t key_handle,
+				    struct pkcs11_attribute_head *proc_params,
+				    void *in, uint32_t in_size,
+				    void *out, uint32_t *out_size)
+{
+	const uint32_t ptypes = TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						TEE_PARAM_TYPE_NONE);
+	TEE_Param params[TEE_NUM_PARAMS] = { };
+	size_t params_size = sizeof(*proc_params) + proc_params->size;
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+
+	if (state->session &&
+	    batch_can_reuse(state, session, function, key_handle,
+			    proc_params)) {
+		rc = reinit_symm_operation(session, proc_params);
+	} else {
+		batch_release(state);
+
+		/* Don't release a processing the client has started */
+		rc = get_ready_session(session);
+		if (rc)
+			return rc;
+
+		rc = processing_init(session, function, key_handle,
+				     proc_params);
+		if (!rc) {
+			state->proc_params = TEE_Malloc(params_size,
+							TEE_MALLOC_FILL_ZERO);
+			if (!state->proc_params)
+				rc = PKCS11_CKR_DEVICE_MEMORY;
+		}
+		if (rc) {
+			release_active_processing(session);
+			return rc;
+		}
+
+		TEE_MemMove(state->proc_params, proc_params, params_size);
+		state->session = session;
+		state->function = function;
+		state->key_handle = key_handle;
+	}
+
+	if (!rc)
+		rc = check_mechanism_against_processing(session,
+						proc_params->id, function,
+						PKCS11_FUNC_STEP_ONESHOT);
+	if (!rc) {
+		params[1].memref.buffer = in;
+		params[1].memref.size = in_size;
+		params[2].memref.buffer = out;
+		params[2].memref.size = *out_size;
+		rc = step_symm_operation(session, function,
+					 PKCS11_FUNC_STEP_ONESHOT,
+					 ptypes, params);
+		if (rc == PKCS11_CKR_OK || rc == PKCS11_CKR_BUFFER_TOO_SMALL)
+			*out_size = params[2].memref.size;
+	}
+
+	/* The operation is restarted by the next processing using it */
+	if (rc != PKCS11_CKR_OK && rc != PKCS11_CKR_BUFFER_TOO_SMALL)
+		batch_release(state);
+
+	return rc;
+}
+
+static enum pkcs11_rc batch_cmd2function(uint32_t cmd,
+					 enum processing_func *function)
+{
+	switch (cmd) {
+	case PKCS11_CMD_ENCRYPT_ONESHOT:
+		*function = PKCS11_FUNCTION_ENCRYPT;
+		return PKCS11_CKR_OK;
+	case PKCS11_CMD_DECRYPT_ONESHOT:
+		*function = PKCS11_FUNCTION_DECRYPT;
+		return PKCS11_CKR_OK;
+	case PKCS11_CMD_SIGN_ONESHOT:
+		*function = PKCS11_FUNCTION_SIGN;
+		return PKCS11_CKR_OK;
+	default:
+		return PKCS11_CKR_ARGUMENTS_BAD;
+	}
+}
+
+/*
+ * entry_processing_batch - Run a list of one-shot processings
+ *
+ * @client = client reference
+ * @ptype = Invocation parameter types
+ * @params = Invocation parameters reference
+ */
+enum pkcs11_rc entry_processing_batch(struct pkcs11_client *client,
+				      uint32_t ptypes, TEE_Param *params)
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+						TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_MEMREF_OUTPUT,
+						TEE_PARAM_TYPE_NONE);
+	TEE_Param *ctrl = params;
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+	enum pkcs11_rc item_rc = PKCS11_CKR_OK;
+	struct serialargs ctrlargs = { };
+	struct batch_state state = { };
+	struct pkcs11_session *session = NULL;
+	struct pkcs11_attribute_head *proc_params = NULL;
+	enum processing_func function = PKCS11_FUNCTION_ENCRYPT;
+	uint32_t session_handle = 0;
+	uint32_t key_handle = 0;
+	uint32_t count = 0;
+	uint32_t cmd = 0;
+	uint32_t in_size = 0;
+	uint32_t out_size = 0;
+	uint32_t out_max = 0;
+	char *in = NULL;
+	size_t in_left = 0;
+	char *out = NULL;
+	size_t out_left = 0;
+	size_t slot_size = 0;
+	uint32_t n = 0;
+
+	if (!client || ptypes != exp_pt)
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	in = params[1].memref.buffer;
+	in_left = params[1].memref.size;
+	out = params[2].memref.buffer;
+	out_left = params[2].memref.size;
+
+	serialargs_init(&ctrlargs, ctrl->memref.buffer, ctrl->memref.size);
+
+	rc = serialargs_get_u32(&ctrlargs, &count);
+	if (rc)
+		return rc;
+
+	for (n = 0; n < count; n++) {
+		rc = serialargs_get_u32(&ctrlargs, &session_handle);
+		if (!rc)
+			rc = serialargs_get_u32(&ctrlargs, &cmd);
+		if (!rc)
+			rc = serialargs_get_u32(&ctrlargs, &key_handle);
+		if (!rc)
+			rc = serialargs_get_one_attribute(&ctrlargs,
+							  &proc_params);
+		if (!rc)
+			rc = serialargs_get_u32(&ctrlargs, &in_size);
+		if (!rc)
+			rc = serialargs_get_u32(&ctrlargs, &out_max);
+		if (!rc)
+			rc = batch_cmd2function(cmd, &function);
+		if (rc)
+			goto out;
+
+		if (ADD_OVERFLOW(2 * sizeof(uint32_t), out_max, &slot_size) ||
+		    in_size > in_left || slot_size > out_left) {
+			rc = PKCS11_CKR_ARGUMENTS_BAD;
+			goto out;
+		}
+
+		out_size = out_max;
+		session = pkcs11_handle2session(session_handle, client);
+		if (session)
+			item_rc = batch_oneshot(&state, session, function,
+						key_handle, proc_params,
+						in, in_size,
+						out + 2 * sizeof(uint32_t),
+						&out_size);
+		else
+			item_rc = PKCS11_CKR_SESSION_HANDLE_INVALID;
+
+		if (item_rc != PKCS11_CKR_OK &&
+		    item_rc != PKCS11_CKR_BUFFER_TOO_SMALL)
+			out_size = 0;
+
+		TEE_MemMove(out, &item_rc, sizeof(item_rc));
+		TEE_MemMove(out + sizeof(item_rc), &out_size, sizeof(out_size));
+
+		serialargs_release(&ctrlargs, proc_params);
+		proc_params = NULL;
+
+		in += in_size;
+		in_left -= in_size;
+		out += slot_size;
+		out_left -= slot_size;
+	}
+
+	if (serialargs_remaining_bytes(&ctrlargs)) {
+		rc = PKCS11_CKR_ARGUMENTS_BAD;
+		goto out;
+	}
+
+	params[2].memref.size -= out_left;
+
+	DMSG("PKCS11 batch of %"PRIu32" processings", count);
+
+out:
+	batch_release(&state);
+	serialargs_release(&ctrlargs, proc_params);
+
+	return rc;
+}
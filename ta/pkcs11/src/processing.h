@@ -30,6 +30,9 @@ enum pkcs11_rc entry_processing_step(struct pkcs11_client *client,
 				     enum processing_func function,
 				     enum processing_step step);
 
+enum pkcs11_rc entry_processing_batch(struct pkcs11_client *client,
+				      uint32_t ptypes, TEE_Param *params);
+
 /*
  * Util
  */
@@ -47,6 +50,9 @@ enum pkcs11_rc init_symm_operation(struct pkcs11_session *session,
 				   struct pkcs11_attribute_head *proc_params,
 				   struct pkcs11_object *key);
 
+enum pkcs11_rc reinit_symm_operation(struct pkcs11_session *session,
+				     struct pkcs11_attribute_head *proc_params);
+
 enum pkcs11_rc step_symm_operation(struct pkcs11_session *session,
 				   enum processing_func function,
 				   enum processing_step step,
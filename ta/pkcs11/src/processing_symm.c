@@ -158,6 +158,37 @@ static enum pkcs11_rc hmac_to_tee_hash(uint32_t *algo,
 	return PKCS11_RV_NOT_FOUND;
 }
 
+static void set_key_object(struct pkcs11_session *session,
+			   struct pkcs11_object *obj)
+{
+	session->processing->key_obj_handle = pkcs11_object2handle(obj,
+								   session);
+	session->processing->key_obj_id = obj->instance_id;
+}
+
+/* Reuse the idle operation of the key object if it fits */
+static bool take_cached_operation(struct pkcs11_session *session,
+				  struct pkcs11_object *obj, uint32_t algo,
+				  uint32_t mode, uint32_t max_key_size)
+{
+	TEE_OperationInfo info = { };
+
+	if (obj->op_handle == TEE_HANDLE_NULL)
+		return false;
+
+	TEE_GetOperationInfo(obj->op_handle, &info);
+	if (info.algorithm != algo || info.mode != mode ||
+	    info.maxKeySize != max_key_size)
+		return false;
+
+	session->processing->tee_op_handle = obj->op_handle;
+	session->processing->key_set = true;
+	obj->op_handle = TEE_HANDLE_NULL;
+	set_key_object(session, obj);
+
+	return true;
+}
+
 static enum pkcs11_rc
 allocate_tee_operation(struct pkcs11_session *session,
 		       enum processing_func function,
@@ -210,11 +241,16 @@ allocate_tee_operation(struct pkcs11_session *session,
 		break;
 	}
 
+	if (take_cached_operation(session, obj, algo, mode, size))
+		return PKCS11_CKR_OK;
+
 	res = TEE_AllocateOperation(&session->processing->tee_op_handle,
 				    algo, mode, size);
 	if (res)
 		EMSG("TEE_AllocateOp. failed %#"PRIx32" %#"PRIx32" %#"PRIx32,
 		     algo, mode, size);
+	else
+		set_key_object(session, obj);
 
 	if (res == TEE_ERROR_NOT_SUPPORTED)
 		return PKCS11_CKR_MECHANISM_INVALID;
@@ -271,6 +307,10 @@ static enum pkcs11_rc load_tee_key(struct pkcs11_session *session,
 	uint32_t max_key_size = 0;
 	uint32_t min_key_size = 0;
 
+	/* Operation taken from the key object with its key already set */
+	if (session->processing->key_set)
+		return PKCS11_CKR_OK;
+
 	if (obj->key_handle != TEE_HANDLE_NULL) {
 		/* Key was already loaded and fits current need */
 		goto key_ready;
@@ -356,6 +396,7 @@ key_ready:
 		DMSG("TEE_SetOperationKey failed, %#"PRIx32, res);
 		goto error;
 	}
+	session->processing->key_set = true;
 
 	return PKCS11_CKR_OK;
 
@@ -435,6 +476,16 @@ enum pkcs11_rc init_symm_operation(struct pkcs11_session *session,
 	return init_tee_operation(session, proc_params);
 }
 
+/* Restart the active operation with the key already loaded */
+enum pkcs11_rc reinit_symm_operation(struct pkcs11_session *session,
+				     struct pkcs11_attribute_head *proc_params)
+{
+	assert(processing_is_tee_symm(proc_params->id) &&
+	       session->processing->tee_op_handle != TEE_HANDLE_NULL);
+
+	return init_tee_operation(session, proc_params);
+}
+
 /* Validate input buffer size as per PKCS#11 constraints */
 static enum pkcs11_rc input_data_size_is_valid(struct active_processing *proc,
 					       enum processing_func function,
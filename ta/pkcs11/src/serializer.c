@@ -103,20 +103,58 @@ enum pkcs11_rc serialargs_get_ptr(struct serialargs *args, void **out,
 	return PKCS11_CKR_OK;
 }
 
-enum pkcs11_rc
-serialargs_alloc_get_one_attribute(struct serialargs *args,
-				   struct pkcs11_attribute_head **out)
+/*
+ * Reference in place the @size bytes at the current position if aligned as
+ * @align, otherwise return an aligned copy the caller releases with
+ * serialargs_release().
+ */
+static enum pkcs11_rc get_aligned(struct serialargs *args, void **out,
+				  size_t size, size_t align)
+{
+	enum pkcs11_rc rc = PKCS11_CKR_OK;
+	char *orig_next = args->next;
+	void *src = NULL;
+	void *ptr = NULL;
+
+	rc = serialargs_get_ptr(args, &src, size);
+	if (rc)
+		return rc;
+
+	if (!((vaddr_t)src & (align - 1))) {
+		*out = src;
+		return PKCS11_CKR_OK;
+	}
+
+	ptr = TEE_Malloc(size, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+	if (!ptr) {
+		args->next = orig_next;
+		return PKCS11_CKR_DEVICE_MEMORY;
+	}
+
+	TEE_MemMove(ptr, src, size);
+	*out = ptr;
+
+	return PKCS11_CKR_OK;
+}
+
+enum pkcs11_rc serialargs_get_one_attribute(struct serialargs *args,
+					    struct pkcs11_attribute_head **out)
 {
 	struct pkcs11_attribute_head head = { };
 	enum pkcs11_rc rc = PKCS11_CKR_OK;
 	char *orig_next = args->next;
+	size_t size = 0;
 	void *p = NULL;
 
 	rc = serialargs_get(args, &head, sizeof(head));
 	if (rc)
 		return rc;
 
-	rc = alloc_and_get(args, orig_next, &head, sizeof(head), &p, head.size);
+	args->next = orig_next;
+	if (ADD_OVERFLOW(sizeof(head), head.size, &size))
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	rc = get_aligned(args, &p, size, __alignof__(head));
 	if (rc)
 		return rc;
 
@@ -125,20 +163,24 @@ serialargs_alloc_get_one_attribute(struct serialargs *args,
 	return PKCS11_CKR_OK;
 }
 
-enum pkcs11_rc serialargs_alloc_get_attributes(struct serialargs *args,
-					       struct pkcs11_object_head **out)
+enum pkcs11_rc serialargs_get_attributes(struct serialargs *args,
+					 struct pkcs11_object_head **out)
 {
 	struct pkcs11_object_head attr = { };
 	enum pkcs11_rc rc = PKCS11_CKR_OK;
 	char *orig_next = args->next;
+	size_t size = 0;
 	void *p = NULL;
 
 	rc = serialargs_get(args, &attr, sizeof(attr));
 	if (rc)
 		return rc;
 
-	rc = alloc_and_get(args, orig_next, &attr, sizeof(attr), &p,
-			   attr.attrs_size);
+	args->next = orig_next;
+	if (ADD_OVERFLOW(sizeof(attr), attr.attrs_size, &size))
+		return PKCS11_CKR_ARGUMENTS_BAD;
+
+	rc = get_aligned(args, &p, size, __alignof__(attr));
 	if (rc)
 		return rc;
 
@@ -147,6 +189,14 @@ enum pkcs11_rc serialargs_alloc_get_attributes(struct serialargs *args,
 	return PKCS11_CKR_OK;
 }
 
+void serialargs_release(struct serialargs *args, void *ptr)
+{
+	char *p = ptr;
+
+	if (p < args->start || p >= args->start + args->size)
+		TEE_Free(ptr);
+}
+
 bool serialargs_remaining_bytes(struct serialargs *args)
 {
 	return args->next < args->start + args->size;
@@ -172,24 +222,3 @@ enum pkcs11_rc serialargs_get_session_from_handle(struct serialargs *args,
 
 	return PKCS11_CKR_OK;
 }
-
-enum pkcs11_rc serialize(char **bstart, size_t *blen, void *data, size_t len)
-{
-	char *buf = NULL;
-	size_t nlen = 0;
-
-	if (ADD_OVERFLOW(*blen, len, &nlen))
-		return PKCS11_CKR_ARGUMENTS_BAD;
-
-	buf = TEE_Realloc(*bstart, nlen);
-	if (!buf)
-		return PKCS11_CKR_DEVICE_MEMORY;
-
-	TEE_MemMove(buf + *blen, data, len);
-
-	*blen = nlen;
-	*bstart = buf;
-
-	return PKCS11_CKR_OK;
-}
-
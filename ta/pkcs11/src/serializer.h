@@ -28,7 +28,8 @@ struct pkcs11_session;
 /*
  * serialargs_init() - Initialize with a new input buffer
  * @args:	serializing state
- * @in:		input buffer
+ * @in:		input buffer, in TA private memory since data may be
+ *		referenced in place
  * @size:	size of the input buffer
  */
 void serialargs_init(struct serialargs *args, void *in, size_t size);
@@ -68,27 +69,40 @@ enum pkcs11_rc serialargs_get_ptr(struct serialargs *args, void **out,
 				  size_t size);
 
 /*
- * serialargs_alloc_get_one_attribute() - allocate and extract one attribute
+ * serialargs_get_one_attribute() - get one attribute and advance
  * @args:	serializing state
- * @out:	Pointer to the allocated and extracted attribute in *@out
+ * @out:	Pointer to the extracted attribute in *@out
+ *
+ * The attribute is referenced in place unless misaligned, in which case it
+ * is copied. It must be released with serialargs_release().
  *
  * Returns PKCS11_CKR_OK on success or an error code from enum pkcs11_rc on
  * failure.
  */
-enum pkcs11_rc
-serialargs_alloc_get_one_attribute(struct serialargs *args,
-				   struct pkcs11_attribute_head **out);
+enum pkcs11_rc serialargs_get_one_attribute(struct serialargs *args,
+					    struct pkcs11_attribute_head **out);
 
 /*
- * serialargs_alloc_get_attributes() - allocate and extract an object
+ * serialargs_get_attributes() - get an object and advance
  * @args:	serializing state
- * @out:	Pointer to the allocated and extracted object in *@out
+ * @out:	Pointer to the extracted object in *@out
+ *
+ * The object is referenced in place unless misaligned, in which case it is
+ * copied. It must be released with serialargs_release().
  *
  * Returns PKCS11_CKR_OK on success or an error code from enum pkcs11_rc on
  * failure.
  */
-enum pkcs11_rc serialargs_alloc_get_attributes(struct serialargs *args,
-					       struct pkcs11_object_head **out);
+enum pkcs11_rc serialargs_get_attributes(struct serialargs *args,
+					 struct pkcs11_object_head **out);
+
+/*
+ * serialargs_release() - release data got from serialized arguments
+ * @args:	serializing state
+ * @ptr:	Data from serialargs_get_one_attribute() or
+ *		serialargs_get_attributes(), or NULL
+ */
+void serialargs_release(struct serialargs *args, void *ptr);
 
 /*
  * serialargs_alloc_and_get() - allocate and extract data
@@ -124,17 +138,4 @@ enum pkcs11_rc serialargs_get_session_from_handle(struct serialargs *args,
 						  struct pkcs11_client *client,
 						  struct pkcs11_session **sess);
 
-/*
- * serialize() - append data into a serialized buffer
- * @bstart:	points to start of a buffer or NULL, *@bstart is updated
- *		with the new buffer if changed
- * @blen:	size of the *@bstart buffer, updated when data is added
- * @data:	data to appen to the buffer
- * @len:	size of the @data buffer
- *
- * Returns PKCS11_CKR_OK on success or an error code from enum pkcs11_rc on
- * failure.
- */
-enum pkcs11_rc serialize(char **bstart, size_t *blen, void *data, size_t len);
-
 #endif /*PKCS11_TA_SERIALIZER_H*/
@@ -16,6 +16,7 @@
 
 #define TA_STACK_SIZE			(4 * 1024)
 #define TA_DATA_SIZE			(16 * 1024)
+#define TA_MALLOC_SIZE_CLASSES		true
 
 #define TA_DESCRIPTION			"PKCS#11 trusted application"
 #define TA_VERSION			TO_STR(PKCS11_TA_VERSION_MAJOR) "." \
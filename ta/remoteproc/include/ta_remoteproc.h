@@ -62,4 +62,40 @@
  */
 #define TA_RPROC_FW_CMD_GET_COREDUMP	5
 
+/*
+ * Start a streamed authentication and load of the firmware. The image is
+ * then provided in chunks with TA_RPROC_FW_CMD_LOAD_FW_UPDATE and the load
+ * completed with TA_RPROC_FW_CMD_LOAD_FW_FINAL.
+ *
+ * The firmware header, which must be entirely contained in the first chunk,
+ * is authenticated before any segment is loaded. The segments are copied in
+ * the remote processor memory as their data are received and each is checked
+ * against the header hash table once complete.
+ *
+ * [in]  params[0].value.a:	unique 32bit identifier of the firmware
+ * [in]  params[1].memref:	first chunk of the image of the firmware
+ */
+#define TA_RPROC_FW_CMD_LOAD_FW_INIT	6
+
+/*
+ * Provide the next chunk of the image of a firmware being streamed.
+ *
+ * [in]  params[0].value.a:	unique 32bit identifier of the firmware
+ * [in]  params[1].memref:	next chunk of the image of the firmware
+ */
+#define TA_RPROC_FW_CMD_LOAD_FW_UPDATE	7
+
+/*
+ * Complete a streamed load of the firmware once all its segments have been
+ * received. The section headers locating the resource table are not covered
+ * by the hash table and may follow the segments in the image so the caller
+ * provides the resource table location, which must be within a segment
+ * described by the hash table.
+ *
+ * [in]  params[0].value.a:	unique 32bit identifier of the firmware
+ * [in]  params[1].value.a:	resource table device address, 0 if none
+ * [in]  params[1].value.b:	resource table byte size
+ */
+#define TA_RPROC_FW_CMD_LOAD_FW_FINAL	8
+
 #endif /*TA_RPROC_FW_H*/
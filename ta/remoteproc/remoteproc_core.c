@@ -96,6 +96,9 @@ struct remoteproc_sig_algo {
  * @state:       Remote-processor state
  * @hw_fmt:      Image format capabilities of the remoteproc PTA
  * @hw_img_prot: Image protection capabilities of the remoteproc PTA
+ * @streaming:   A streamed load of the firmware is in progress
+ * @stream_pos:  Byte offset from header start of the next streamed data
+ * @stream_seg:  Index in the hash table of the next segment streamed
  * @link:        Linked list element
  */
 struct remoteproc_context {
@@ -108,6 +111,9 @@ struct remoteproc_context {
 	enum remoteproc_state state;
 	uint32_t hw_fmt;
 	uint32_t hw_img_prot;
+	bool streaming;
+	uint32_t stream_pos;
+	unsigned int stream_seg;
 	TAILQ_ENTRY(remoteproc_context) link;
 };
 
@@ -237,7 +243,7 @@ static TEE_Result remoteproc_save_fw_header(struct remoteproc_context *ctx,
 
 	remoteproc_header_dump(hdr);
 
-	if (fw_orig_size <= sizeof(*hdr) || fw_orig_size <= hdr->hdr_length)
+	if (fw_orig_size <= sizeof(*hdr) || fw_orig_size < hdr->hdr_length)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
 	ctx->hdr = TEE_Malloc(hdr->hdr_length, TEE_MALLOC_FILL_ZERO);
@@ -361,11 +367,23 @@ static TEE_Result get_rproc_pta_capabilities(struct remoteproc_context *ctx)
 	return TEE_SUCCESS;
 }
 
-static TEE_Result remoteproc_verify_firmware(struct remoteproc_context *ctx,
-					     uint8_t *fw_orig,
-					     uint32_t fw_orig_size)
+static void remoteproc_release_fw_header(struct remoteproc_context *ctx)
+{
+	TEE_Free(ctx->hdr);
+	ctx->hdr = NULL;
+	ctx->streaming = false;
+	ctx->stream_pos = 0;
+	ctx->stream_seg = 0;
+}
+
+/*
+ * Authenticate the firmware header found at the start of @fw_orig, a
+ * secure copy is kept in the context for the firmware load.
+ */
+static TEE_Result remoteproc_verify_fw_header(struct remoteproc_context *ctx,
+					      uint8_t *fw_orig,
+					      uint32_t fw_orig_size)
 {
-	struct remoteproc_fw_hdr *hdr = NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
 
 	res = get_rproc_pta_capabilities(ctx);
@@ -388,20 +406,38 @@ static TEE_Result remoteproc_verify_firmware(struct remoteproc_context *ctx,
 
 	res = remoteproc_verify_header(ctx);
 	if (res)
-		goto free_hdr;
+		remoteproc_release_fw_header(ctx);
+
+	return res;
+}
+
+static TEE_Result remoteproc_verify_firmware(struct remoteproc_context *ctx,
+					     uint8_t *fw_orig,
+					     uint32_t fw_orig_size)
+{
+	struct remoteproc_fw_hdr *hdr = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t img_end = 0;
+
+	res = remoteproc_verify_fw_header(ctx, fw_orig, fw_orig_size);
+	if (res)
+		return res;
 
-	/* Store location of the loadable binary in non-secure memory */
 	hdr = ctx->hdr;
+	if (ADD_OVERFLOW(hdr->img_offset, hdr->img_length, &img_end) ||
+	    img_end > fw_orig_size) {
+		remoteproc_release_fw_header(ctx);
+		return TEE_ERROR_CORRUPT_OBJECT;
+	}
+
+	/* Store location of the loadable binary in non-secure memory */
 	ctx->fw_img_size = hdr->img_length;
 	ctx->fw_img = fw_orig + hdr->img_offset;
 
 	DMSG("Firmware image addr: %p size: %zu", ctx->fw_img,
 	     ctx->fw_img_size);
 
-free_hdr:
-	TEE_Free(ctx->hdr);
-
-	return res;
+	return TEE_SUCCESS;
 }
 
 static paddr_t remoteproc_da_to_pa(uint32_t da, uint32_t size, void *priv)
@@ -494,6 +530,30 @@ static TEE_Result get_segment_hash(struct remoteproc_context *ctx, uint8_t *src,
 	return TEE_ERROR_NO_DATA;
 }
 
+static TEE_Result remoteproc_clear_memory(struct remoteproc_context *ctx,
+					  uint32_t da, uint32_t size)
+{
+	uint32_t param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					       TEE_PARAM_TYPE_VALUE_INPUT,
+					       TEE_PARAM_TYPE_VALUE_INPUT,
+					       TEE_PARAM_TYPE_VALUE_INPUT);
+	TEE_Param params[TEE_NUM_PARAMS] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	params[0].value.a = ctx->fw_id;
+	params[1].value.a = da;
+	params[2].value.a = size;
+	params[3].value.a = 0;
+
+	res = TEE_InvokeTACommand(pta_session, TEE_TIMEOUT_INFINITE,
+				  PTA_REMOTEPROC_SET_MEMORY,
+				  param_types, params, NULL);
+	if (res != TEE_SUCCESS)
+		EMSG("Fails to clear segment, res = 0x%x", res);
+
+	return res;
+}
+
 static TEE_Result remoteproc_load_segment(uint8_t *src, uint32_t size,
 					  uint32_t da, uint32_t mem_size,
 					  void *priv)
@@ -535,21 +595,8 @@ static TEE_Result remoteproc_load_segment(uint8_t *src, uint32_t size,
 	}
 
 	/* Fill the rest of the memory with 0 */
-	if (size < mem_size) {
-		param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
-					      TEE_PARAM_TYPE_VALUE_INPUT,
-					      TEE_PARAM_TYPE_VALUE_INPUT,
-					      TEE_PARAM_TYPE_VALUE_INPUT);
-		params[1].value.a = da + size;
-		params[2].value.a = mem_size - size;
-		params[3].value.a = 0;
-
-		res = TEE_InvokeTACommand(pta_session, TEE_TIMEOUT_INFINITE,
-					  PTA_REMOTEPROC_SET_MEMORY,
-					  param_types, params, NULL);
-		if (res != TEE_SUCCESS)
-			EMSG("Fails to clear segment, res = 0x%x", res);
-	}
+	if (size < mem_size)
+		res = remoteproc_clear_memory(ctx, da + size, mem_size - size);
 
 	return res;
 }
@@ -594,6 +641,9 @@ static TEE_Result remoteproc_load_fw(uint32_t pt,
 	if (!params[1].memref.buffer || !params[1].memref.size)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	/* A full load supersedes a streamed load in progress */
+	remoteproc_release_fw_header(ctx);
+
 	DMSG("Got base addr: %p size %zu", params[1].memref.buffer,
 	     params[1].memref.size);
 
@@ -617,6 +667,347 @@ out:
 	/* Clear reference to firmware image from shared memory */
 	ctx->fw_img = NULL;
 	ctx->fw_img_size =  0;
+	remoteproc_release_fw_header(ctx);
+
+	return res;
+}
+
+static struct remoteproc_segment *
+remoteproc_get_segments(struct remoteproc_fw_hdr *hdr, unsigned int *count)
+{
+	*count = hdr->phhdr_length / sizeof(struct remoteproc_segment);
+
+	return (void *)((uint8_t *)hdr + hdr->phhdr_offset);
+}
+
+static bool is_streamed_segment(struct remoteproc_segment *peh)
+{
+	return peh->phdr.p_type == PT_LOAD && peh->phdr.p_filesz;
+}
+
+/*
+ * The segments are loaded as the image is received so their data must be
+ * ordered in the image as they are in the hash table.
+ */
+static TEE_Result remoteproc_check_stream_layout(struct remoteproc_context *ctx)
+{
+	struct remoteproc_fw_hdr *hdr = ctx->hdr;
+	struct remoteproc_segment *peh = NULL;
+	unsigned int nb_entry = 0;
+	unsigned int i = 0;
+	uint32_t seg_end = 0;
+	uint32_t end = 0;
+
+	if (hdr->img_offset < hdr->hdr_length ||
+	    ADD_OVERFLOW(hdr->img_offset, hdr->img_length, &end))
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	peh = remoteproc_get_segments(hdr, &nb_entry);
+	end = 0;
+
+	for (i = 0; i < nb_entry; peh++, i++) {
+		if (peh->phdr.p_type != PT_LOAD)
+			continue;
+
+		if (peh->phdr.p_filesz > peh->phdr.p_memsz ||
+		    ADD_OVERFLOW(peh->phdr.p_offset, peh->phdr.p_filesz,
+				 &seg_end) ||
+		    seg_end > hdr->img_length)
+			return TEE_ERROR_CORRUPT_OBJECT;
+
+		if (!peh->phdr.p_filesz)
+			continue;
+
+		if (peh->phdr.p_offset < end) {
+			EMSG("Segment %u can't be streamed", i);
+			return TEE_ERROR_NOT_SUPPORTED;
+		}
+		end = seg_end;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result remoteproc_load_chunk(struct remoteproc_context *ctx,
+					uint8_t *src, uint32_t size,
+					uint32_t da, unsigned char *hash,
+					uint32_t flags)
+{
+	uint32_t param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					       TEE_PARAM_TYPE_MEMREF_INPUT,
+					       TEE_PARAM_TYPE_VALUE_INPUT,
+					       TEE_PARAM_TYPE_MEMREF_INPUT);
+	TEE_Param params[TEE_NUM_PARAMS] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	params[0].value.a = ctx->fw_id;
+	params[0].value.b = flags;
+	params[1].memref.buffer = src;
+	params[1].memref.size = size;
+	params[2].value.a = da;
+	params[3].memref.buffer = hash;
+	params[3].memref.size = TEE_SHA256_HASH_SIZE;
+
+	res = TEE_InvokeTACommand(pta_session, TEE_TIMEOUT_INFINITE,
+				  PTA_REMOTEPROC_LOAD_SEGMENT_CHUNK_SHA256,
+				  param_types, params, NULL);
+	if (res != TEE_SUCCESS)
+		EMSG("Fails to load segment chunk, res = 0x%x", res);
+
+	return res;
+}
+
+/*
+ * Load the parts of a chunk of the image which belong to a segment, the
+ * other data such as the ELF headers aren't needed since the segments are
+ * described by the authenticated hash table.
+ */
+static TEE_Result remoteproc_stream_chunk(struct remoteproc_context *ctx,
+					  uint8_t *data, size_t size)
+{
+	struct remoteproc_fw_hdr *hdr = ctx->hdr;
+	struct remoteproc_segment *peh = NULL;
+	struct remoteproc_segment *seg = NULL;
+	unsigned int nb_entry = 0;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint32_t seg_start = 0;
+	uint32_t seg_end = 0;
+	uint32_t flags = 0;
+	uint32_t end = 0;
+	uint32_t n = 0;
+
+	if (ADD_OVERFLOW(ctx->stream_pos, size, &end) ||
+	    end > hdr->img_offset + hdr->img_length)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	peh = remoteproc_get_segments(hdr, &nb_entry);
+
+	while (size) {
+		while (ctx->stream_seg < nb_entry &&
+		       !is_streamed_segment(peh + ctx->stream_seg))
+			ctx->stream_seg++;
+
+		if (ctx->stream_seg == nb_entry) {
+			/* Data following the last segment isn't loaded */
+			ctx->stream_pos = end;
+			return TEE_SUCCESS;
+		}
+
+		seg = peh + ctx->stream_seg;
+		seg_start = hdr->img_offset + seg->phdr.p_offset;
+		seg_end = seg_start + seg->phdr.p_filesz;
+
+		if (ctx->stream_pos < seg_start) {
+			n = MIN(size, seg_start - ctx->stream_pos);
+		} else {
+			n = MIN(size, seg_end - ctx->stream_pos);
+
+			flags = 0;
+			if (ctx->stream_pos == seg_start)
+				flags |= PTA_REMOTEPROC_CHUNK_FIRST;
+			if (ctx->stream_pos + n == seg_end)
+				flags |= PTA_REMOTEPROC_CHUNK_LAST;
+
+			res = remoteproc_load_chunk(ctx, data, n,
+						    seg->phdr.p_paddr +
+						    ctx->stream_pos - seg_start,
+						    seg->hash, flags);
+			if (res)
+				return res;
+
+			if (flags & PTA_REMOTEPROC_CHUNK_LAST)
+				ctx->stream_seg++;
+		}
+
+		data += n;
+		size -= n;
+		ctx->stream_pos += n;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result remoteproc_load_fw_init(uint32_t pt,
+					  TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	struct remoteproc_context *ctx = NULL;
+	uint8_t *buf = params[1].memref.buffer;
+	size_t size = params[1].memref.size;
+	uint32_t fw_id = params[0].value.a;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (pt != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ctx = remoteproc_find_firmware(fw_id);
+	if (!ctx)
+		ctx = remoteproc_add_firmware(fw_id);
+	if (!ctx)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	if (ctx->state != REMOTEPROC_OFF)
+		return TEE_ERROR_BAD_STATE;
+
+	if (!buf || !size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Restart from scratch a streamed load in progress */
+	remoteproc_release_fw_header(ctx);
+
+	res = remoteproc_verify_fw_header(ctx, buf, size);
+	if (res) {
+		EMSG("Can't Authenticate the firmware, res = %#"PRIx32, res);
+		return res;
+	}
+
+	res = remoteproc_check_stream_layout(ctx);
+	if (res)
+		goto out;
+
+	ctx->streaming = true;
+	ctx->stream_pos = ctx->hdr->hdr_length;
+
+	res = remoteproc_stream_chunk(ctx, buf + ctx->hdr->hdr_length,
+				      size - ctx->hdr->hdr_length);
+
+out:
+	if (res)
+		remoteproc_release_fw_header(ctx);
+
+	return res;
+}
+
+static TEE_Result remoteproc_load_fw_update(uint32_t pt,
+					    TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_MEMREF_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	struct remoteproc_context *ctx = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (pt != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ctx = remoteproc_find_firmware(params[0].value.a);
+	if (!ctx)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!ctx->streaming)
+		return TEE_ERROR_BAD_STATE;
+
+	if (!params[1].memref.buffer || !params[1].memref.size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = remoteproc_stream_chunk(ctx, params[1].memref.buffer,
+				      params[1].memref.size);
+	if (res)
+		remoteproc_release_fw_header(ctx);
+
+	return res;
+}
+
+static TEE_Result remoteproc_set_rsc_table(struct remoteproc_context *ctx,
+					   uint32_t da, uint32_t size)
+{
+	struct remoteproc_segment *peh = NULL;
+	unsigned int nb_entry = 0;
+	unsigned int i = 0;
+
+	ctx->rsc_pa = 0;
+	ctx->rsc_size = 0;
+
+	if (!da)
+		return TEE_SUCCESS;
+
+	if (!size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	peh = remoteproc_get_segments(ctx->hdr, &nb_entry);
+
+	for (i = 0; i < nb_entry; peh++, i++) {
+		if (peh->phdr.p_type != PT_LOAD || da < peh->phdr.p_paddr ||
+		    size > peh->phdr.p_memsz ||
+		    da - peh->phdr.p_paddr > peh->phdr.p_memsz - size)
+			continue;
+
+		DMSG("Resource table device address %#"PRIx32" size %"PRIu32,
+		     da, size);
+
+		ctx->rsc_pa = remoteproc_da_to_pa(da, size, ctx);
+		if (!ctx->rsc_pa)
+			return TEE_ERROR_ACCESS_DENIED;
+		ctx->rsc_size = size;
+
+		return TEE_SUCCESS;
+	}
+
+	EMSG("Resource table not in a firmware segment");
+
+	return TEE_ERROR_CORRUPT_OBJECT;
+}
+
+static TEE_Result remoteproc_load_fw_final(uint32_t pt,
+					   TEE_Param params[TEE_NUM_PARAMS])
+{
+	const uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_VALUE_INPUT,
+						TEE_PARAM_TYPE_NONE,
+						TEE_PARAM_TYPE_NONE);
+	struct remoteproc_context *ctx = NULL;
+	struct remoteproc_segment *peh = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	unsigned int nb_entry = 0;
+	unsigned int i = 0;
+
+	if (pt != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ctx = remoteproc_find_firmware(params[0].value.a);
+	if (!ctx)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!ctx->streaming)
+		return TEE_ERROR_BAD_STATE;
+
+	peh = remoteproc_get_segments(ctx->hdr, &nb_entry);
+
+	while (ctx->stream_seg < nb_entry &&
+	       !is_streamed_segment(peh + ctx->stream_seg))
+		ctx->stream_seg++;
+
+	if (ctx->stream_seg != nb_entry) {
+		EMSG("Firmware image is truncated");
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	/* Fill the memory of the segments beyond their data with 0 */
+	for (i = 0; i < nb_entry; peh++, i++) {
+		if (peh->phdr.p_type != PT_LOAD ||
+		    peh->phdr.p_filesz == peh->phdr.p_memsz)
+			continue;
+
+		res = remoteproc_clear_memory(ctx, peh->phdr.p_paddr +
+						   peh->phdr.p_filesz,
+					      peh->phdr.p_memsz -
+					      peh->phdr.p_filesz);
+		if (res)
+			goto out;
+	}
+
+	res = remoteproc_set_rsc_table(ctx, params[1].value.a,
+				       params[1].value.b);
+	if (res == TEE_SUCCESS)
+		ctx->state = REMOTEPROC_LOADED;
+
+out:
+	remoteproc_release_fw_header(ctx);
 
 	return res;
 }
@@ -775,6 +1166,12 @@ TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd_id,
 		return remoteproc_get_rsc_table(pt, params);
 	case TA_RPROC_FW_CMD_GET_COREDUMP:
 		return TEE_ERROR_NOT_IMPLEMENTED;
+	case TA_RPROC_FW_CMD_LOAD_FW_INIT:
+		return remoteproc_load_fw_init(pt, params);
+	case TA_RPROC_FW_CMD_LOAD_FW_UPDATE:
+		return remoteproc_load_fw_update(pt, params);
+	case TA_RPROC_FW_CMD_LOAD_FW_FINAL:
+		return remoteproc_load_fw_final(pt, params);
 	default:
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
@@ -130,64 +130,146 @@ static TEE_Result huk_ae_decrypt(TEE_OperationHandle crypto_op, uint8_t *in,
 	return res;
 }
 
-static TEE_Result huk_crypt(TEE_OperationMode mode, uint8_t *in, uint32_t in_sz,
-			    uint8_t *out, uint32_t *out_sz)
+/*
+ * The key derived from the hardware unique key and the AE operations are
+ * kept for the lifetime of the session since Linux seals and unseals many
+ * keys in a row at boot.
+ */
+struct tk_session {
+	TEE_ObjectHandle hkey;
+	TEE_OperationHandle enc_op;
+	TEE_OperationHandle dec_op;
+};
+
+static TEE_Result get_huk_key(struct tk_session *s)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
-	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
-	TEE_ObjectHandle hkey = TEE_HANDLE_NULL;
 	uint8_t huk_key[TA_DERIVED_KEY_MAX_SIZE] = { };
 	TEE_Attribute attr = { };
 
-	res = TEE_AllocateOperation(&crypto_op, TEE_ALG_AES_GCM, mode,
-				    sizeof(huk_key) * 8);
-	if (res)
-		return res;
+	if (s->hkey)
+		return TEE_SUCCESS;
 
 	res = derive_unique_key(huk_key, sizeof(huk_key), NULL, 0);
 	if (res) {
 		EMSG("derive_unique_key failed: returned %#"PRIx32, res);
-		goto out_op;
+		goto out;
 	}
 
 	res = TEE_AllocateTransientObject(TEE_TYPE_AES, sizeof(huk_key) * 8,
-					  &hkey);
+					  &s->hkey);
 	if (res)
-		goto out_op;
+		goto out;
 
 	attr.attributeID = TEE_ATTR_SECRET_VALUE;
 	attr.content.ref.buffer = huk_key;
 	attr.content.ref.length = sizeof(huk_key);
 
-	res = TEE_PopulateTransientObject(hkey, &attr, 1);
-	if (res)
-		goto out_key;
+	res = TEE_PopulateTransientObject(s->hkey, &attr, 1);
+	if (res) {
+		TEE_FreeTransientObject(s->hkey);
+		s->hkey = TEE_HANDLE_NULL;
+	}
+
+out:
+	memzero_explicit(huk_key, sizeof(huk_key));
+	return res;
+}
+
+static TEE_OperationHandle *session_op(struct tk_session *s,
+				       TEE_OperationMode mode)
+{
+	if (mode == TEE_MODE_ENCRYPT)
+		return &s->enc_op;
+	if (mode == TEE_MODE_DECRYPT)
+		return &s->dec_op;
+	TEE_Panic(0);
+	return NULL;
+}
 
-	res = TEE_SetOperationKey(crypto_op, hkey);
+static void put_crypto_op(struct tk_session *s, TEE_OperationMode mode)
+{
+	TEE_OperationHandle *op = session_op(s, mode);
+
+	if (*op) {
+		TEE_FreeOperation(*op);
+		*op = TEE_HANDLE_NULL;
+	}
+}
+
+static TEE_Result get_crypto_op(struct tk_session *s, TEE_OperationMode mode,
+				TEE_OperationHandle *crypto_op)
+{
+	TEE_OperationHandle *op = session_op(s, mode);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!*op) {
+		res = get_huk_key(s);
+		if (res)
+			return res;
+
+		res = TEE_AllocateOperation(op, TEE_ALG_AES_GCM, mode,
+					    TA_DERIVED_KEY_MAX_SIZE * 8);
+		if (res) {
+			*op = TEE_HANDLE_NULL;
+			return res;
+		}
+
+		res = TEE_SetOperationKey(*op, s->hkey);
+		if (res) {
+			put_crypto_op(s, mode);
+			return res;
+		}
+	}
+
+	*crypto_op = *op;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result huk_crypt(struct tk_session *s, TEE_OperationMode mode,
+			    uint8_t *in, uint32_t in_sz, uint8_t *out,
+			    uint32_t *out_sz)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	TEE_OperationHandle crypto_op = TEE_HANDLE_NULL;
+
+	res = get_crypto_op(s, mode, &crypto_op);
 	if (res)
-		goto out_key;
+		return res;
 
 	if (mode == TEE_MODE_ENCRYPT) {
 		res = huk_ae_encrypt(crypto_op, in, in_sz, out, out_sz);
 		if (res)
 			EMSG("huk_AE_encrypt failed: returned %#"PRIx32, res);
-	} else if (mode == TEE_MODE_DECRYPT) {
+	} else {
 		res = huk_ae_decrypt(crypto_op, in, in_sz, out, out_sz);
 		if (res)
 			EMSG("huk_AE_decrypt failed: returned %#"PRIx32, res);
-	} else {
-		TEE_Panic(0);
 	}
 
-out_key:
-	TEE_FreeTransientObject(hkey);
-out_op:
-	TEE_FreeOperation(crypto_op);
-	memzero_explicit(huk_key, sizeof(huk_key));
+	/* The operation may be left active, start over with a new one */
+	if (res)
+		put_crypto_op(s, mode);
+
 	return res;
 }
 
-static TEE_Result seal_trusted_key(uint32_t types,
+/* Size of the output of huk_crypt() for @in_sz bytes, 0 if invalid */
+static uint32_t huk_crypt_out_size(TEE_OperationMode mode, uint32_t in_sz)
+{
+	if (mode == TEE_MODE_ENCRYPT) {
+		if (!in_sz || in_sz > MAX_BUF_SIZE ||
+		    in_sz + sizeof(struct tk_blob_hdr) > MAX_BUF_SIZE)
+			return 0;
+		return in_sz + sizeof(struct tk_blob_hdr);
+	}
+
+	if (in_sz <= sizeof(struct tk_blob_hdr) || in_sz > MAX_BUF_SIZE)
+		return 0;
+	return in_sz - sizeof(struct tk_blob_hdr);
+}
+
+static TEE_Result seal_trusted_key(struct tk_session *s, uint32_t types,
 				   TEE_Param params[TEE_NUM_PARAMS])
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -221,7 +303,7 @@ static TEE_Result seal_trusted_key(uint32_t types,
 		return TEE_ERROR_SHORT_BUFFER;
 	}
 
-	res = huk_crypt(TEE_MODE_ENCRYPT, in, in_sz, out, &out_sz);
+	res = huk_crypt(s, TEE_MODE_ENCRYPT, in, in_sz, out, &out_sz);
 	if (res == TEE_SUCCESS) {
 		assert(out_sz == in_sz + sizeof(struct tk_blob_hdr));
 		params[1].memref.size = out_sz;
@@ -230,7 +312,7 @@ static TEE_Result seal_trusted_key(uint32_t types,
 	return res;
 }
 
-static TEE_Result unseal_trusted_key(uint32_t types,
+static TEE_Result unseal_trusted_key(struct tk_session *s, uint32_t types,
 				     TEE_Param params[TEE_NUM_PARAMS])
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -263,7 +345,7 @@ static TEE_Result unseal_trusted_key(uint32_t types,
 		return TEE_ERROR_SHORT_BUFFER;
 	}
 
-	res = huk_crypt(TEE_MODE_DECRYPT, in, in_sz, out, &out_sz);
+	res = huk_crypt(s, TEE_MODE_DECRYPT, in, in_sz, out, &out_sz);
 	if (res == TEE_SUCCESS) {
 		assert(out_sz == in_sz - sizeof(struct tk_blob_hdr));
 		params[1].memref.size = out_sz;
@@ -272,6 +354,101 @@ static TEE_Result unseal_trusted_key(uint32_t types,
 	return res;
 }
 
+/*
+ * Returns the data and the length of the batch entry at @*offs and moves
+ * @*offs to the next entry. The buffer is shared with the normal world so
+ * the length is read once and the bounds checked on each pass.
+ */
+static TEE_Result get_batch_entry(uint8_t *buf, size_t buf_sz, size_t *offs,
+				  uint8_t **data, uint32_t *len)
+{
+	size_t end = 0;
+
+	if (ADD_OVERFLOW(*offs, sizeof(*len), &end) || end > buf_sz)
+		return TEE_ERROR_BAD_PARAMETERS;
+	memcpy(len, buf + *offs, sizeof(*len));
+
+	if (ADD_OVERFLOW(end, *len, &end) || end > buf_sz)
+		return TEE_ERROR_BAD_PARAMETERS;
+	*data = buf + *offs + sizeof(*len);
+	*offs = ROUNDUP(end, sizeof(*len));
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result crypt_batch(struct tk_session *s, TEE_OperationMode mode,
+			      uint32_t types, TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *in = NULL;
+	size_t in_sz = 0;
+	uint8_t *out = NULL;
+	size_t out_sz = 0;
+	size_t in_offs = 0;
+	size_t out_offs = 0;
+	uint8_t *data = NULL;
+	uint32_t len = 0;
+	uint32_t res_len = 0;
+	size_t req_sz = 0;
+
+	DMSG("Invoked TA_CMD_%s",
+	     mode == TEE_MODE_ENCRYPT ? "SEAL_BATCH" : "UNSEAL_BATCH");
+
+	if (types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				     TEE_PARAM_TYPE_MEMREF_OUTPUT,
+				     TEE_PARAM_TYPE_NONE,
+				     TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	in = params[0].memref.buffer;
+	in_sz = params[0].memref.size;
+	out = params[1].memref.buffer;
+	out_sz = params[1].memref.size;
+
+	if (!in || !in_sz || (!out && out_sz))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* First pass for the size of the output */
+	while (in_offs < in_sz) {
+		res = get_batch_entry(in, in_sz, &in_offs, &data, &len);
+		if (res)
+			return res;
+		res_len = huk_crypt_out_size(mode, len);
+		if (!res_len)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (ADD_OVERFLOW(req_sz, sizeof(len) + res_len, &req_sz))
+			return TEE_ERROR_BAD_PARAMETERS;
+		req_sz = ROUNDUP(req_sz, sizeof(len));
+	}
+
+	if (req_sz > out_sz) {
+		params[1].memref.size = req_sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	in_offs = 0;
+	while (in_offs < in_sz) {
+		res = get_batch_entry(in, in_sz, &in_offs, &data, &len);
+		if (res)
+			return res;
+		res_len = huk_crypt_out_size(mode, len);
+		if (!res_len || out_offs + sizeof(len) + res_len > out_sz)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		res = huk_crypt(s, mode, data, len,
+				out + out_offs + sizeof(len), &res_len);
+		if (res)
+			return res;
+
+		memcpy(out + out_offs, &res_len, sizeof(res_len));
+		out_offs = ROUNDUP(out_offs + sizeof(len) + res_len,
+				   sizeof(len));
+	}
+
+	params[1].memref.size = out_offs;
+	return TEE_SUCCESS;
+}
+
 TEE_Result TA_CreateEntryPoint(void)
 {
 	return TEE_SUCCESS;
@@ -283,11 +460,12 @@ void TA_DestroyEntryPoint(void)
 
 TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
 				    TEE_Param params[TEE_NUM_PARAMS] __unused,
-				    void **session __unused)
+				    void **session)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	TEE_PropSetHandle h = TEE_HANDLE_NULL;
 	TEE_Identity id = { };
+	struct tk_session *s = NULL;
 
 	res = TEE_AllocatePropertyEnumerator(&h);
 	if (res)
@@ -299,8 +477,17 @@ TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
 	if (res)
 		goto out;
 
-	if (id.login != TEE_LOGIN_REE_KERNEL)
+	if (id.login != TEE_LOGIN_REE_KERNEL) {
 		res = TEE_ERROR_ACCESS_DENIED;
+		goto out;
+	}
+
+	s = TEE_Malloc(sizeof(*s), TEE_MALLOC_FILL_ZERO);
+	if (!s) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	*session = s;
 
 out:
 	if (h)
@@ -308,11 +495,17 @@ out:
 	return res;
 }
 
-void TA_CloseSessionEntryPoint(void *sess __unused)
+void TA_CloseSessionEntryPoint(void *sess)
 {
+	struct tk_session *s = sess;
+
+	put_crypto_op(s, TEE_MODE_ENCRYPT);
+	put_crypto_op(s, TEE_MODE_DECRYPT);
+	TEE_FreeTransientObject(s->hkey);
+	TEE_Free(s);
 }
 
-TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
+TEE_Result TA_InvokeCommandEntryPoint(void *sess, uint32_t cmd,
 				      uint32_t pt,
 				      TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -320,9 +513,13 @@ TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
 	case TA_CMD_GET_RANDOM:
 		return get_random(pt, params);
 	case TA_CMD_SEAL:
-		return seal_trusted_key(pt, params);
+		return seal_trusted_key(sess, pt, params);
 	case TA_CMD_UNSEAL:
-		return unseal_trusted_key(pt, params);
+		return unseal_trusted_key(sess, pt, params);
+	case TA_CMD_SEAL_BATCH:
+		return crypt_batch(sess, TEE_MODE_ENCRYPT, pt, params);
+	case TA_CMD_UNSEAL_BATCH:
+		return crypt_batch(sess, TEE_MODE_DECRYPT, pt, params);
 	default:
 		EMSG("Command ID %#"PRIx32" is not supported", cmd);
 		return TEE_ERROR_NOT_SUPPORTED;
@@ -32,4 +32,28 @@
  */
 #define TA_CMD_UNSEAL		0x2
 
+/*
+ * Seal several trusted keys using hardware unique key
+ *
+ * [in]      memref[0]        Plain keys
+ * [out]     memref[1]        Sealed key datablobs
+ *
+ * Both buffers hold a sequence of entries, each a 32-bit length in the
+ * byte order of the CPU followed by that many bytes of data, padded to a
+ * multiple of 4 bytes. The output has one entry per input entry, in the
+ * same order. The command fails if any of the keys can't be sealed.
+ */
+#define TA_CMD_SEAL_BATCH	0x3
+
+/*
+ * Unseal several trusted keys using hardware unique key
+ *
+ * [in]      memref[0]        Sealed key datablobs
+ * [out]     memref[1]        Plain keys
+ *
+ * The buffers are laid out as with TA_CMD_SEAL_BATCH. The command fails
+ * if any of the datablobs can't be unsealed.
+ */
+#define TA_CMD_UNSEAL_BATCH	0x4
+
 #endif /* TRUSTED_KEYS_H */